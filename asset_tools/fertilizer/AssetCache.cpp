@@ -0,0 +1,577 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <AssetCache.h>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string_view>
+#include <unordered_set>
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <core/utils/CRC64.hpp>
+#include <core/utils/stringmanip.h>
+
+namespace Fertilizer {
+    using fspath = std::filesystem::path;
+
+    static constexpr std::size_t HashChunkSize = 1024 * 1024;
+
+    static std::string toHex(std::uint64_t value) {
+        return Carrot::sprintf("%016llx", static_cast<unsigned long long>(value));
+    }
+
+    static std::uint64_t fromHex(std::string_view text) {
+        return std::stoull(std::string { text }, nullptr, 16);
+    }
+
+    static std::string pathToString(const fspath& path) {
+        return Carrot::toString(path.generic_u8string());
+    }
+
+    static fspath stringToPath(std::string_view text) {
+        return fspath { std::u8string_view { reinterpret_cast<const char8_t*>(text.data()), text.size() } };
+    }
+
+    static std::int64_t getWriteTime(const fspath& path) {
+        return static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    static std::uint64_t hashFileContents(const fspath& path) {
+        std::ifstream file { path, std::ios::binary };
+        if(!file) {
+            throw std::filesystem::filesystem_error("Failed to open file", path, std::make_error_code(std::errc::io_error));
+        }
+        std::vector<char> buffer(HashChunkSize);
+        std::uint64_t hash = 0;
+        while(file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hash = Carrot::CRC64(buffer.data(), static_cast<std::size_t>(file.gcount()), hash);
+        }
+        return hash;
+    }
+
+    /// Decodes %XX sequences of URIs (glTF files reference "my%20texture.png")
+    static std::string decodeURI(std::string_view uri) {
+        std::string decoded;
+        decoded.reserve(uri.size());
+        for(std::size_t i = 0; i < uri.size(); i++) {
+            if(uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+                decoded += static_cast<char>(std::stoi(std::string { uri.substr(i + 1, 2) }, nullptr, 16));
+                i += 2;
+            } else {
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    /// Files referenced by the 'uri' fields of the given arrays of a glTF document. Embedded data ("data:" URIs) is skipped
+    static void findGLTFReferences(const rapidjson::Document& document, const fspath& folder, std::span<const char* const> arrays, std::vector<fspath>& references) {
+        if(!document.IsObject()) {
+            return;
+        }
+        for(const char* arrayName : arrays) {
+            auto arrayIt = document.FindMember(arrayName);
+            if(arrayIt == document.MemberEnd() || !arrayIt->value.IsArray()) {
+                continue;
+            }
+            for(const auto& element : arrayIt->value.GetArray()) {
+                if(!element.IsObject()) {
+                    continue;
+                }
+                auto uriIt = element.FindMember("uri");
+                if(uriIt == element.MemberEnd() || !uriIt->value.IsString()) {
+                    continue;
+                }
+                const std::string_view uri { uriIt->value.GetString(), uriIt->value.GetStringLength() };
+                if(uri.starts_with("data:")) {
+                    continue;
+                }
+                references.push_back(folder / stringToPath(decodeURI(uri)));
+            }
+        }
+    }
+
+    /// Reads the JSON part of a .gltf or .glb file. Returns false if the file cannot be parsed
+    static bool readGLTFDocument(const fspath& file, rapidjson::Document& document) {
+        std::ifstream stream { file, std::ios::binary };
+        if(!stream) {
+            return false;
+        }
+
+        std::string json;
+        if(file.extension() == ".glb") {
+            // header (magic, version, length), then the first chunk (length, type) contains the JSON
+            std::array<std::uint32_t, 5> header{};
+            stream.read(reinterpret_cast<char*>(header.data()), sizeof(header));
+            constexpr std::uint32_t GLBMagic = 0x46546C67; // "glTF"
+            constexpr std::uint32_t JSONChunkType = 0x4E4F534A; // "JSON"
+            if(!stream || header[0] != GLBMagic || header[4] != JSONChunkType) {
+                return false;
+            }
+            json.resize(header[3]);
+            stream.read(json.data(), static_cast<std::streamsize>(json.size()));
+            if(!stream) {
+                return false;
+            }
+        } else {
+            std::stringstream contents;
+            contents << stream.rdbuf();
+            json = contents.str();
+        }
+
+        document.Parse(json.c_str(), json.size());
+        return !document.HasParseError();
+    }
+
+    /// Calls 'forEachLine' with each line of a text file
+    template<typename Callback>
+    static void forEachLine(const fspath& file, const Callback& callback) {
+        std::ifstream stream { file };
+        std::string line;
+        while(std::getline(stream, line)) {
+            if(!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            callback(std::string_view { line });
+        }
+    }
+
+    /// Last whitespace-separated token of a line: path of a texture in a .mtl file ("map_Kd -bm 1.0 textures/albedo.png")
+    static std::string_view getLastToken(std::string_view line) {
+        const std::size_t end = line.find_last_not_of(" \t");
+        if(end == std::string_view::npos) {
+            return {};
+        }
+        const std::size_t separator = line.find_last_of(" \t", end);
+        const std::size_t start = separator == std::string_view::npos ? 0 : separator + 1;
+        return line.substr(start, end - start + 1);
+    }
+
+    /// Files directly referenced by 'file'
+    static void findDirectReferences(const fspath& file, std::vector<fspath>& references) {
+        const fspath extension = file.extension();
+        const fspath folder = file.parent_path();
+        if(extension == ".gltf" || extension == ".glb") {
+            rapidjson::Document document;
+            if(readGLTFDocument(file, document)) {
+                constexpr std::array<const char*, 2> Arrays { "buffers", "images" };
+                findGLTFReferences(document, folder, Arrays, references);
+            }
+        } else if(extension == ".obj") {
+            forEachLine(file, [&](std::string_view line) {
+                if(line.starts_with("mtllib ")) {
+                    std::istringstream names { std::string { line.substr(7) } };
+                    std::string name;
+                    while(names >> name) {
+                        references.push_back(folder / stringToPath(name));
+                    }
+                }
+            });
+        } else if(extension == ".mtl") {
+            forEachLine(file, [&](std::string_view line) {
+                const std::size_t start = line.find_first_not_of(" \t");
+                if(start == std::string_view::npos) {
+                    return;
+                }
+                line = line.substr(start);
+                if(line.starts_with("map_") || line.starts_with("bump ") || line.starts_with("disp ") || line.starts_with("norm ") || line.starts_with("refl ")) {
+                    const std::string_view texture = getLastToken(line);
+                    if(!texture.empty()) {
+                        references.push_back(folder / stringToPath(texture));
+                    }
+                }
+            });
+        }
+    }
+
+    std::vector<fspath> findDependencies(const fspath& file) {
+        std::vector<fspath> dependencies;
+        std::unordered_set<fspath> visited { file.lexically_normal() };
+        std::vector<fspath> toVisit { file };
+        std::vector<fspath> references;
+        while(!toVisit.empty()) {
+            const fspath current = std::move(toVisit.back());
+            toVisit.pop_back();
+
+            references.clear();
+            findDirectReferences(current, references);
+            for(fspath& reference : references) {
+                reference = reference.lexically_normal();
+                if(!visited.insert(reference).second) {
+                    continue;
+                }
+                dependencies.push_back(reference);
+                if(std::filesystem::is_regular_file(reference)) {
+                    toVisit.push_back(reference);
+                }
+            }
+        }
+        return dependencies;
+    }
+
+    std::vector<fspath> findNormalMaps(const fspath& file) {
+        std::vector<fspath> normalMaps;
+        const fspath extension = file.extension();
+        const fspath folder = file.parent_path();
+        if(extension == ".gltf" || extension == ".glb") {
+            rapidjson::Document document;
+            if(!readGLTFDocument(file, document) || !document.IsObject()) {
+                return normalMaps;
+            }
+            // material -> texture -> image -> uri
+            auto getArray = [&](const char* name) -> const rapidjson::Value* {
+                auto it = document.FindMember(name);
+                return it != document.MemberEnd() && it->value.IsArray() ? &it->value : nullptr;
+            };
+            auto getElement = [](const rapidjson::Value* pArray, const rapidjson::Value& object, const char* indexName) -> const rapidjson::Value* {
+                auto it = object.FindMember(indexName);
+                if(pArray == nullptr || it == object.MemberEnd() || !it->value.IsUint() || it->value.GetUint() >= pArray->Size()) {
+                    return nullptr;
+                }
+                const rapidjson::Value& element = (*pArray)[it->value.GetUint()];
+                return element.IsObject() ? &element : nullptr;
+            };
+            const rapidjson::Value* pMaterials = getArray("materials");
+            const rapidjson::Value* pTextures = getArray("textures");
+            const rapidjson::Value* pImages = getArray("images");
+            if(pMaterials == nullptr) {
+                return normalMaps;
+            }
+            for(const auto& material : pMaterials->GetArray()) {
+                if(!material.IsObject()) {
+                    continue;
+                }
+                auto normalTextureIt = material.FindMember("normalTexture");
+                if(normalTextureIt == material.MemberEnd() || !normalTextureIt->value.IsObject()) {
+                    continue;
+                }
+                const rapidjson::Value* pTexture = getElement(pTextures, normalTextureIt->value, "index");
+                const rapidjson::Value* pImage = pTexture != nullptr ? getElement(pImages, *pTexture, "source") : nullptr;
+                if(pImage == nullptr) {
+                    continue;
+                }
+                auto uriIt = pImage->FindMember("uri");
+                if(uriIt == pImage->MemberEnd() || !uriIt->value.IsString()) {
+                    continue;
+                }
+                const std::string_view uri { uriIt->value.GetString(), uriIt->value.GetStringLength() };
+                if(!uri.starts_with("data:")) {
+                    normalMaps.push_back((folder / stringToPath(decodeURI(uri))).lexically_normal());
+                }
+            }
+        } else if(extension == ".obj") {
+            for(const fspath& dependency : findDependencies(file)) {
+                if(dependency.extension() != ".mtl") {
+                    continue;
+                }
+                const fspath materialFolder = dependency.parent_path();
+                forEachLine(dependency, [&](std::string_view line) {
+                    const std::size_t start = line.find_first_not_of(" \t");
+                    if(start == std::string_view::npos) {
+                        return;
+                    }
+                    line = line.substr(start);
+                    if(line.starts_with("map_Bump ") || line.starts_with("map_bump ") || line.starts_with("bump ") || line.starts_with("norm ")) {
+                        const std::string_view texture = getLastToken(line);
+                        if(!texture.empty()) {
+                            normalMaps.push_back((materialFolder / stringToPath(texture)).lexically_normal());
+                        }
+                    }
+                });
+            }
+        }
+        return normalMaps;
+    }
+
+    std::uint64_t computeAssetKey(const fspath& inputFile, const fspath& outputFile, const ConversionOptions& options, const AssetManifest* pPrevious, std::vector<InputFileRecord>& inputs) {
+        std::vector<InputFileRecord> hashedDependencies; //< hashed before looking for dependencies again, see below
+        auto findPrevious = [&](const fspath& path) -> const InputFileRecord* {
+            for(const InputFileRecord& record : hashedDependencies) {
+                if(record.path == path) {
+                    return &record;
+                }
+            }
+            if(pPrevious == nullptr) {
+                return nullptr;
+            }
+            for(const InputFileRecord& record : pPrevious->inputs) {
+                if(record.path == path) {
+                    return &record;
+                }
+            }
+            return nullptr;
+        };
+
+        auto makeRecord = [&](const fspath& path) {
+            InputFileRecord& record = inputs.emplace_back();
+            record.path = path;
+            std::error_code error;
+            if(!std::filesystem::is_regular_file(path, error)) {
+                return; // missing dependency: hash of 0
+            }
+            record.size = std::filesystem::file_size(path);
+            record.writeTime = getWriteTime(path);
+
+            const InputFileRecord* pPreviousRecord = findPrevious(path);
+            if(pPreviousRecord != nullptr && pPreviousRecord->size == record.size && pPreviousRecord->writeTime == record.writeTime) {
+                record.hash = pPreviousRecord->hash;
+            } else {
+                record.hash = hashFileContents(path);
+            }
+        };
+
+        inputs.clear();
+        makeRecord(inputFile);
+
+        // the list of dependencies can only change if one of the files it was found from changed: the main input, or a
+        // dependency which references other files (.mtl files referencing textures). Creating a missing dependency changes its hash too
+        bool sameInputs = pPrevious != nullptr && !pPrevious->inputs.empty()
+                       && pPrevious->inputs[0].path == inputFile && pPrevious->inputs[0].hash == inputs[0].hash;
+        if(sameInputs) {
+            for(std::size_t i = 1; i < pPrevious->inputs.size(); i++) {
+                makeRecord(pPrevious->inputs[i].path);
+                sameInputs &= inputs[i].hash == pPrevious->inputs[i].hash;
+            }
+        }
+        if(!sameInputs) {
+            // files which were just hashed are not hashed again
+            hashedDependencies.assign(std::make_move_iterator(inputs.begin() + 1), std::make_move_iterator(inputs.end()));
+            inputs.resize(1);
+            for(const fspath& dependency : findDependencies(inputFile)) {
+                makeRecord(dependency);
+            }
+        }
+
+        std::uint64_t key = 0;
+        auto hashBytes = [&](const void* pData, std::size_t size) {
+            key = Carrot::CRC64(static_cast<const char*>(pData), size, key);
+        };
+        auto hashString = [&](const std::string& str) {
+            const std::uint64_t length = str.size();
+            hashBytes(&length, sizeof(length));
+            hashBytes(str.data(), str.size());
+        };
+        hashBytes(&ConverterVersion, sizeof(ConverterVersion));
+        const std::uint64_t optionsHash = options.hash();
+        hashBytes(&optionsHash, sizeof(optionsHash));
+
+        // converters use the name of the output (name of the model, name of the .bin file)
+        hashString(pathToString(outputFile.filename()));
+        hashString(pathToString(inputFile.extension()));
+        hashBytes(&inputs[0].hash, sizeof(inputs[0].hash));
+        // converted differently when a model uses the texture as a normal map
+        const std::uint8_t isNormalMap = options.normalMaps.contains(inputFile.lexically_normal()) ? 1 : 0;
+        hashBytes(&isNormalMap, sizeof(isNormalMap));
+
+        // dependencies by path relative to the input, so that the key does not depend on where the project is
+        const fspath inputFolder = inputFile.parent_path();
+        for(std::size_t i = 1; i < inputs.size(); i++) {
+            hashString(pathToString(inputs[i].path.lexically_relative(inputFolder)));
+            hashBytes(&inputs[i].hash, sizeof(inputs[i].hash));
+        }
+        return key;
+    }
+
+    fspath getManifestPath(const fspath& outputFile) {
+        fspath manifestPath = outputFile;
+        manifestPath += ".fmanifest";
+        return manifestPath;
+    }
+
+    std::optional<AssetManifest> AssetManifest::read(const fspath& manifestFile) {
+        std::ifstream stream { manifestFile, std::ios::binary };
+        if(!stream) {
+            return {};
+        }
+        std::stringstream contents;
+        contents << stream.rdbuf();
+
+        rapidjson::Document document;
+        document.Parse(contents.str().c_str());
+        if(document.HasParseError() || !document.IsObject()) {
+            return {};
+        }
+
+        // a manifest from another version of the converters would not have the same key anyway
+        auto versionIt = document.FindMember("version");
+        if(versionIt == document.MemberEnd() || !versionIt->value.IsUint() || versionIt->value.GetUint() != ConverterVersion) {
+            return {};
+        }
+
+        // rapidjson asserts on type mismatches: check everything, the manifest may have been modified by hand
+        auto getMember = [](const rapidjson::Value& object, const char* name) -> const rapidjson::Value* {
+            if(!object.IsObject()) {
+                return nullptr;
+            }
+            auto it = object.FindMember(name);
+            return it != object.MemberEnd() ? &it->value : nullptr;
+        };
+        auto getString = [&](const rapidjson::Value& object, const char* name) -> std::optional<std::string_view> {
+            const rapidjson::Value* pValue = getMember(object, name);
+            if(pValue == nullptr || !pValue->IsString()) {
+                return {};
+            }
+            return std::string_view { pValue->GetString(), pValue->GetStringLength() };
+        };
+        auto getArray = [&](const rapidjson::Value& object, const char* name) -> const rapidjson::Value* {
+            const rapidjson::Value* pValue = getMember(object, name);
+            return pValue != nullptr && pValue->IsArray() ? pValue : nullptr;
+        };
+        auto getHash = [&](const rapidjson::Value& object, const char* name) -> std::optional<std::uint64_t> {
+            const std::optional<std::string_view> text = getString(object, name);
+            if(!text.has_value() || text->empty() || text->size() > 16 || text->find_first_not_of("0123456789abcdefABCDEF") != std::string_view::npos) {
+                return {};
+            }
+            return fromHex(text.value());
+        };
+
+        AssetManifest manifest;
+        const std::optional<std::uint64_t> key = getHash(document, "key");
+        const rapidjson::Value* pInputs = getArray(document, "inputs");
+        const rapidjson::Value* pOutputs = getArray(document, "outputs");
+        if(!key.has_value() || pInputs == nullptr || pOutputs == nullptr) {
+            return {};
+        }
+        manifest.key = key.value();
+
+        for(const auto& input : pInputs->GetArray()) {
+            const std::optional<std::string_view> path = getString(input, "path");
+            const std::optional<std::uint64_t> hash = getHash(input, "hash");
+            const rapidjson::Value* pSize = getMember(input, "size");
+            const rapidjson::Value* pWriteTime = getMember(input, "write_time");
+            if(!path.has_value() || !hash.has_value() || pSize == nullptr || !pSize->IsUint64() || pWriteTime == nullptr || !pWriteTime->IsInt64()) {
+                return {};
+            }
+            manifest.inputs.push_back(InputFileRecord {
+                .path = stringToPath(path.value()),
+                .size = pSize->GetUint64(),
+                .writeTime = pWriteTime->GetInt64(),
+                .hash = hash.value(),
+            });
+        }
+        for(const auto& output : pOutputs->GetArray()) {
+            const std::optional<std::string_view> path = getString(output, "path");
+            const rapidjson::Value* pSize = getMember(output, "size");
+            if(!path.has_value() || pSize == nullptr || !pSize->IsUint64()) {
+                return {};
+            }
+            manifest.outputs.push_back(OutputFileRecord {
+                .path = stringToPath(path.value()),
+                .size = pSize->GetUint64(),
+            });
+        }
+        if(manifest.inputs.empty() || manifest.outputs.empty()) {
+            return {};
+        }
+        return manifest;
+    }
+
+    void AssetManifest::write(const fspath& manifestFile) const {
+        rapidjson::Document document;
+        document.SetObject();
+        auto& allocator = document.GetAllocator();
+
+        auto makeString = [&](const std::string& str) {
+            return rapidjson::Value { str.c_str(), static_cast<rapidjson::SizeType>(str.size()), allocator };
+        };
+
+        rapidjson::Value inputArray { rapidjson::kArrayType };
+        for(const InputFileRecord& record : inputs) {
+            rapidjson::Value input { rapidjson::kObjectType };
+            input.AddMember("path", makeString(pathToString(record.path)), allocator);
+            input.AddMember("size", static_cast<std::uint64_t>(record.size), allocator);
+            input.AddMember("write_time", record.writeTime, allocator);
+            input.AddMember("hash", makeString(toHex(record.hash)), allocator);
+            inputArray.PushBack(input, allocator);
+        }
+
+        rapidjson::Value outputArray { rapidjson::kArrayType };
+        for(const OutputFileRecord& record : outputs) {
+            rapidjson::Value output { rapidjson::kObjectType };
+            output.AddMember("path", makeString(pathToString(record.path)), allocator);
+            output.AddMember("size", static_cast<std::uint64_t>(record.size), allocator);
+            outputArray.PushBack(output, allocator);
+        }
+
+        document.AddMember("version", ConverterVersion, allocator);
+        document.AddMember("key", makeString(toHex(key)), allocator);
+        document.AddMember("inputs", inputArray, allocator);
+        document.AddMember("outputs", outputArray, allocator);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer { buffer };
+        document.Accept(writer);
+
+        std::ofstream stream { manifestFile, std::ios::binary | std::ios::trunc };
+        stream.write(buffer.GetString(), static_cast<std::streamsize>(buffer.GetSize()));
+    }
+
+    AssetCache::AssetCache(fspath directory): directory(std::move(directory)) {}
+
+    const fspath& AssetCache::getDirectory() const {
+        return directory;
+    }
+
+    bool AssetCache::restore(std::uint64_t key, const fspath& outputFile, std::vector<OutputFileRecord>& outputs) const {
+        const fspath entryFolder = directory / toHex(key);
+        std::error_code error;
+        if(!std::filesystem::is_directory(entryFolder, error)) {
+            return false;
+        }
+
+        const fspath outputFolder = outputFile.parent_path();
+        outputs.clear();
+        for(const auto& entry : std::filesystem::recursive_directory_iterator { entryFolder }) {
+            if(!entry.is_regular_file()) {
+                continue;
+            }
+            OutputFileRecord& record = outputs.emplace_back();
+            record.path = entry.path().lexically_relative(entryFolder);
+            record.size = entry.file_size();
+
+            const fspath target = outputFolder / record.path;
+            std::filesystem::create_directories(target.parent_path());
+            std::filesystem::copy_file(entry.path(), target, std::filesystem::copy_options::overwrite_existing);
+        }
+
+        // main output first, like after a conversion
+        auto mainOutput = std::ranges::find(outputs, outputFile.filename(), &OutputFileRecord::path);
+        if(mainOutput == outputs.end()) {
+            return false; // not written by this version of Fertilizer
+        }
+        std::iter_swap(outputs.begin(), mainOutput);
+        return true;
+    }
+
+    void AssetCache::store(std::uint64_t key, const fspath& outputFile, std::span<const OutputFileRecord> outputs) const {
+        const fspath entryFolder = directory / toHex(key);
+        std::error_code error;
+        if(std::filesystem::exists(entryFolder, error)) {
+            return; // another conversion (maybe from another process) already stored the same outputs
+        }
+
+        // outputs are copied to a temporary folder, then the folder is renamed: other processes never see partial entries
+        thread_local std::mt19937_64 rng { std::random_device{}() };
+        const fspath temporaryFolder = directory / (toHex(key) + ".tmp" + toHex(rng()));
+        const fspath outputFolder = outputFile.parent_path();
+        std::filesystem::create_directories(temporaryFolder);
+        for(const OutputFileRecord& record : outputs) {
+            const fspath target = temporaryFolder / record.path;
+            std::filesystem::create_directories(target.parent_path());
+            std::filesystem::copy_file(outputFolder / record.path, target, std::filesystem::copy_options::overwrite_existing);
+        }
+
+        std::filesystem::rename(temporaryFolder, entryFolder, error);
+        if(error) {
+            // stored by someone else in the meantime
+            std::filesystem::remove_all(temporaryFolder, error);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+#include <ConversionOptions.h>
+
+namespace Fertilizer {
+    /// Version of the conversion code, part of the content hash of each asset.
+    /// Increment it when a converter changes its output, so that outputs of older versions are not reused
+    constexpr std::uint32_t ConverterVersion = 7;
+
+    /// A file read during a conversion
+    struct InputFileRecord {
+        std::filesystem::path path;
+        std::uintmax_t size = 0;
+        std::int64_t writeTime = 0; //< last write time when 'hash' was computed, to avoid hashing unchanged files again
+        std::uint64_t hash = 0; //< hash of the contents, 0 if the file does not exist
+    };
+
+    /// A file written by a conversion
+    struct OutputFileRecord {
+        std::filesystem::path path; //< relative to the folder of the main output
+        std::uintmax_t size = 0;
+    };
+
+    /// Stored next to each output, describes what the output was converted from
+    struct AssetManifest {
+        std::uint64_t key = 0; //< see computeAssetKey
+        std::vector<InputFileRecord> inputs; //< main input first, then its dependencies
+        std::vector<OutputFileRecord> outputs; //< main output first
+
+        /// Returns an empty optional if the manifest does not exist or cannot be read
+        static std::optional<AssetManifest> read(const std::filesystem::path& manifestFile);
+        void write(const std::filesystem::path& manifestFile) const;
+    };
+
+    /// Path of the manifest of the given output
+    std::filesystem::path getManifestPath(const std::filesystem::path& outputFile);
+
+    /**
+     * Files referenced by 'file' which are read when converting it (buffers and images of glTF files, materials and
+     * textures of .obj files), recursively. Referenced files which do not exist are returned too, so that creating them
+     * changes the key of the asset.
+     */
+    std::vector<std::filesystem::path> findDependencies(const std::filesystem::path& file);
+
+    /**
+     * Textures used as normal maps by the model 'file' (normalTexture of glTF materials, bump and norm maps of the .mtl
+     * files of .obj files), lexically normal. Empty for other files. See ConversionOptions::normalMaps
+     */
+    std::vector<std::filesystem::path> findNormalMaps(const std::filesystem::path& file);
+
+    /**
+     * Content hash of the conversion of 'inputFile' to 'outputFile': covers the converter version, the conversion options,
+     * the name of the output and the contents of the input and of its dependencies. Fills 'inputs' with the files which were hashed.
+     * Hashes of files which have the same size and write time as in 'pPrevious' are reused instead of reading the files.
+     * Dependencies are searched again only if one of the inputs recorded in 'pPrevious' changed.
+     */
+    std::uint64_t computeAssetKey(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options,
+                                  const AssetManifest* pPrevious, std::vector<InputFileRecord>& inputs);
+
+    /**
+     * Local folder storing the outputs of conversions by key: <directory>/<key>/<outputs>.
+     * Can be shared by several checkouts and branches: an asset is only converted once for a given content and converter version.
+     * Safe to use from several threads and processes at once.
+     */
+    class AssetCache {
+    public:
+        explicit AssetCache(std::filesystem::path directory);
+
+        /// Copies the outputs stored for 'key' to the folder of 'outputFile', and fills 'outputs'.
+        /// Returns false if nothing is stored for this key
+        bool restore(std::uint64_t key, const std::filesystem::path& outputFile, std::vector<OutputFileRecord>& outputs) const;
+
+        /// Stores the outputs of a conversion, given relative to the folder of 'outputFile'
+        void store(std::uint64_t key, const std::filesystem::path& outputFile, std::span<const OutputFileRecord> outputs) const;
+
+        const std::filesystem::path& getDirectory() const;
+
+    private:
+        std::filesystem::path directory;
+    };
+}
@@ -0,0 +1,229 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "BlockCompression.h"
+#include <Fertilizer.h>
+#include <core/Macros.h>
+#include <core/render/ImageFormats.h>
+#include <core/utils/stringmanip.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+
+#define RGBCX_IMPLEMENTATION
+#include <rgbcx.h>
+#include <bc7enc.h>
+#include <bc7decomp.h>
+
+namespace Fertilizer {
+    /// rgbcx level used by TextureCompressionQuality::Fast, much faster than rgbcx::MAX_LEVEL for a small loss of quality
+    constexpr std::uint32_t FastBC1Level = 4;
+
+    /// Texels of a 4x4 block, RGBA
+    using BlockTexels = std::array<std::uint8_t, 4 * 4 * 4>;
+
+    static void initEncodersIfNecessary() {
+        static std::once_flag onceFlag;
+        std::call_once(onceFlag, []() {
+            rgbcx::init();
+            bc7enc_compress_block_init();
+        });
+    }
+
+    TextureUsage guessTextureUsage(const std::filesystem::path& file, int componentCount) {
+        if(componentCount == 1) {
+            return TextureUsage::Mask;
+        }
+        if(componentCount == 2) {
+            return TextureUsage::TwoChannels;
+        }
+
+        // only suffixes: "normal" can be part of other words ("abnormal", "normalized")
+        const std::string lowerCaseName = Carrot::toLowerCase(Carrot::toString(file.stem().u8string()));
+        std::string_view name = lowerCaseName;
+        for(const std::string_view convention : { "_gl", "-gl", "_dx", "-dx", "_opengl", "-opengl", "_directx", "-directx" }) {
+            if(name.ends_with(convention)) {
+                name.remove_suffix(convention.size());
+                break;
+            }
+        }
+        for(const std::string_view suffix : { "normal", "normals", "normalmap", "n", "nrm", "nor", "norm", "nml" }) {
+            if(name == suffix) {
+                return TextureUsage::NormalMap;
+            }
+            if(name.size() > suffix.size() && name.ends_with(suffix)) {
+                const char separator = name[name.size() - suffix.size() - 1];
+                if(separator == '_' || separator == '-' || separator == ' ' || separator == '.') {
+                    return TextureUsage::NormalMap;
+                }
+            }
+        }
+        return TextureUsage::Color;
+    }
+
+    VkFormat chooseCompressedFormat(TextureUsage usage, bool hasAlpha, TextureCompressionQuality quality) {
+        switch(usage) {
+            case TextureUsage::Mask:
+                return VK_FORMAT_BC4_UNORM_BLOCK;
+
+            case TextureUsage::NormalMap:
+            case TextureUsage::TwoChannels:
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+
+            case TextureUsage::Color:
+                if(quality == TextureCompressionQuality::High) {
+                    return VK_FORMAT_BC7_UNORM_BLOCK;
+                }
+                return hasAlpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        }
+        verify(false, "Unknown texture usage");
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    /// Copies the texels of the block at (blockX, blockY) of slice 'z'. Texels outside of the image repeat the edges
+    static void fetchBlock(std::span<const std::uint8_t> rgbaTexels, std::uint32_t width, std::uint32_t height,
+                           std::uint32_t blockX, std::uint32_t blockY, std::uint32_t z, BlockTexels& block) {
+        for(std::uint32_t dy = 0; dy < 4; dy++) {
+            const std::uint32_t y = std::min(blockY * 4 + dy, height - 1);
+            for(std::uint32_t dx = 0; dx < 4; dx++) {
+                const std::uint32_t x = std::min(blockX * 4 + dx, width - 1);
+                const std::size_t texelIndex = (static_cast<std::size_t>(z) * height + y) * width + x;
+                std::copy_n(&rgbaTexels[texelIndex * 4], 4, &block[(dx + dy * 4) * 4]);
+            }
+        }
+    }
+
+    void compressBlocks(VkFormat format, TextureCompressionQuality quality, std::span<const std::uint8_t> rgbaTexels,
+                        std::uint32_t width, std::uint32_t height, std::uint32_t depth, std::span<std::uint8_t> output) {
+        verify(rgbaTexels.size() >= static_cast<std::size_t>(width) * height * depth * 4, "Not enough input texels");
+        verify(output.size() >= Carrot::ImageFormats::computeMipSize(width, height, depth, format), "Output is too small");
+        initEncodersIfNecessary();
+
+        const std::size_t blockSize = Carrot::ImageFormats::getBlockSize(format);
+        const std::uint32_t widthInBlocks = (width + 3) / 4;
+        const std::uint32_t heightInBlocks = (height + 3) / 4;
+
+        // read-only once built, shared by all threads
+        bc7enc_compress_block_params bc7Params;
+        bc7enc_compress_block_params_init(&bc7Params);
+        bc7enc_compress_block_params_init_linear_weights(&bc7Params); // textures are stored as UNORM, errors are not perceptual
+        bc7Params.m_max_partitions = quality == TextureCompressionQuality::Fast ? 16 : BC7ENC_MAX_PARTITIONS;
+        bc7Params.m_uber_level = quality == TextureCompressionQuality::High ? 1 : 0;
+
+        const bool fast = quality == TextureCompressionQuality::Fast;
+        auto encodeBlock = [&](void* pDst, const BlockTexels& block) {
+            switch(format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                    rgbcx::encode_bc1(fast ? FastBC1Level : rgbcx::MAX_LEVEL, pDst, block.data(), true /* 3 color mode, its 4th color is black */, false);
+                    break;
+
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                    if(fast) {
+                        rgbcx::encode_bc3(FastBC1Level, pDst, block.data());
+                    } else {
+                        rgbcx::encode_bc3_hq(rgbcx::MAX_LEVEL, pDst, block.data());
+                    }
+                    break;
+
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    if(fast) {
+                        rgbcx::encode_bc4(pDst, block.data(), 4);
+                    } else {
+                        rgbcx::encode_bc4_hq(pDst, block.data(), 4);
+                    }
+                    break;
+
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    if(fast) {
+                        rgbcx::encode_bc5(pDst, block.data(), 0, 1, 4);
+                    } else {
+                        rgbcx::encode_bc5_hq(pDst, block.data(), 0, 1, 4);
+                    }
+                    break;
+
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                    bc7enc_compress_block(pDst, block.data(), &bc7Params);
+                    break;
+
+                default:
+                    verify(false, Carrot::sprintf("Unsupported block format: %d", static_cast<int>(format)));
+            }
+        };
+
+        // blocks are independent: split rows of blocks over threads
+        parallelFor(static_cast<std::size_t>(depth) * heightInBlocks, [&](std::size_t rowIndex) {
+            const std::uint32_t z = rowIndex / heightInBlocks;
+            const std::uint32_t blockY = rowIndex % heightInBlocks;
+            BlockTexels block;
+            for(std::uint32_t blockX = 0; blockX < widthInBlocks; blockX++) {
+                fetchBlock(rgbaTexels, width, height, blockX, blockY, z, block);
+                encodeBlock(&output[(rowIndex * widthInBlocks + blockX) * blockSize], block);
+            }
+        }, 4);
+    }
+
+    void decompressBlocks(VkFormat format, std::span<const std::uint8_t> blocks,
+                          std::uint32_t width, std::uint32_t height, std::uint32_t depth, std::span<std::uint8_t> rgbaTexels) {
+        verify(blocks.size() >= Carrot::ImageFormats::computeMipSize(width, height, depth, format), "Not enough blocks");
+        verify(rgbaTexels.size() >= static_cast<std::size_t>(width) * height * depth * 4, "Output is too small");
+
+        const std::size_t blockSize = Carrot::ImageFormats::getBlockSize(format);
+        const std::uint32_t widthInBlocks = (width + 3) / 4;
+        const std::uint32_t heightInBlocks = (height + 3) / 4;
+
+        auto decodeBlock = [&](const void* pBlock, BlockTexels& block) {
+            switch(format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                    rgbcx::unpack_bc1(pBlock, block.data(), true);
+                    break;
+
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                    rgbcx::unpack_bc3(pBlock, block.data());
+                    break;
+
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    for(std::size_t i = 0; i < 16; i++) {
+                        block[i * 4 + 1] = 0;
+                        block[i * 4 + 2] = 0;
+                        block[i * 4 + 3] = 255;
+                    }
+                    rgbcx::unpack_bc4(pBlock, block.data(), 4);
+                    break;
+
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    for(std::size_t i = 0; i < 16; i++) {
+                        block[i * 4 + 2] = 0;
+                        block[i * 4 + 3] = 255;
+                    }
+                    rgbcx::unpack_bc5(pBlock, block.data(), 0, 1, 4);
+                    break;
+
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                    bc7decomp::unpack_bc7(pBlock, reinterpret_cast<bc7decomp::color_rgba*>(block.data()));
+                    break;
+
+                default:
+                    verify(false, Carrot::sprintf("Unsupported block format: %d", static_cast<int>(format)));
+            }
+        };
+
+        for(std::uint32_t z = 0; z < depth; z++) {
+            for(std::uint32_t blockY = 0; blockY < heightInBlocks; blockY++) {
+                for(std::uint32_t blockX = 0; blockX < widthInBlocks; blockX++) {
+                    BlockTexels block;
+                    decodeBlock(&blocks[((static_cast<std::size_t>(z) * heightInBlocks + blockY) * widthInBlocks + blockX) * blockSize], block);
+
+                    // texels outside of the image are dropped
+                    for(std::uint32_t dy = 0; dy < 4 && blockY * 4 + dy < height; dy++) {
+                        for(std::uint32_t dx = 0; dx < 4 && blockX * 4 + dx < width; dx++) {
+                            const std::size_t texelIndex = (static_cast<std::size_t>(z) * height + blockY * 4 + dy) * width + blockX * 4 + dx;
+                            std::copy_n(&block[(dx + dy * 4) * 4], 4, &rgbaTexels[texelIndex * 4]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vulkan/vulkan_core.h>
+#include <ConversionOptions.h>
+
+namespace Fertilizer {
+    /// What a texture is used for, decides its compressed format
+    enum class TextureUsage {
+        Color, //< albedo, emissive, etc. RGB with optional alpha
+        NormalMap, //< tangent-space normals: only X and Y are stored, shaders reconstruct Z
+        Mask, //< single channel (roughness, occlusion, height, ...)
+        TwoChannels, //< two independent channels
+    };
+
+    /// Guesses the usage of a texture from its channel count and the suffix of its name for normal maps ("_normal", "_n", "_nrm",
+    /// optionally followed by "_gl" or "_dx"). Prefer tagging normal maps via ConversionOptions::normalMaps
+    TextureUsage guessTextureUsage(const std::filesystem::path& file, int componentCount);
+
+    /**
+     * Block-compressed format to use for a texture:
+     *  - Color: BC1 if opaque, BC3 otherwise. BC7 with TextureCompressionQuality::High
+     *  - NormalMap, TwoChannels: BC5
+     *  - Mask: BC4
+     * \param hasAlpha true if some texels are not fully opaque
+     */
+    VkFormat chooseCompressedFormat(TextureUsage usage, bool hasAlpha, TextureCompressionQuality quality);
+
+    /**
+     * Compresses RGBA8 texels to 'format' (BC1 RGB, BC3, BC4, BC5 or BC7, UNORM). Rows of blocks are compressed in
+     * parallel, via Fertilizer::parallelFor.
+     * BC4 stores the red channel, BC5 the red and green channels.
+     * The size does not need to be a multiple of 4: blocks on the border repeat the texels of the edges.
+     * \param rgbaTexels width*height*depth*4 bytes
+     * \param output Carrot::ImageFormats::computeMipSize(width, height, depth, format) bytes
+     */
+    void compressBlocks(VkFormat format, TextureCompressionQuality quality, std::span<const std::uint8_t> rgbaTexels,
+                        std::uint32_t width, std::uint32_t height, std::uint32_t depth, std::span<std::uint8_t> output);
+
+    /**
+     * Inverse of compressBlocks, for tests and tools. Channels which are not stored by 'format' are set to 0, and alpha to 255.
+     * \param rgbaTexels width*height*depth*4 bytes
+     */
+    void decompressBlocks(VkFormat format, std::span<const std::uint8_t> blocks,
+                          std::uint32_t width, std::uint32_t height, std::uint32_t depth, std::span<std::uint8_t> rgbaTexels);
+}
@@ -0,0 +1,53 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_set>
+#include <core/render/Mipmaps.h>
+
+namespace Fertilizer {
+    /// Trade-off between encoding speed and quality of compressed textures
+    enum class TextureCompressionQuality: std::uint8_t {
+        Fast, //< low effort BC1/BC3/BC4/BC5 encoding, for quick iterations
+        Normal, //< highest effort BC1/BC3/BC4/BC5 encoding
+        High, //< BC7 for color textures, much slower to encode
+    };
+
+    /// Settings shared by all conversions of a run
+    struct ConversionOptions {
+        TextureCompressionQuality textureQuality = TextureCompressionQuality::Normal;
+
+        /// Filter used to compute the mips of textures
+        Carrot::Mipmaps::Filter mipFilter = Carrot::Mipmaps::Filter::Kaiser;
+
+        /// Scale the alpha of mips of color textures so that as many texels pass the alpha test as in the full resolution
+        bool preserveAlphaCoverage = false;
+
+        /// Also write models as glTF next to their cooked version (.cmodel), to inspect or export them. Not used by the engine
+        bool exportGLTF = false;
+
+        /// Store vertices of models quantized (octahedral normals, 16-bit positions and UVs, 8-bit colors and weights). Lossy
+        bool quantizeVertices = false;
+
+        /// Compress vertices, indices and meshlets of models with meshoptimizer. Lossless, decoded quickly on load
+        bool compressModels = true;
+
+        /// Textures used as normal maps by the models of the run (see findNormalMaps), lexically normal. Textures which are not
+        /// in this set get their usage guessed from their name. Not part of hash(): only the key of the tagged textures changes
+        std::unordered_set<std::filesystem::path> normalMaps;
+
+        /// Part of the key of converted assets (see computeAssetKey): outputs converted with other options are not reused
+        std::uint64_t hash() const {
+            return static_cast<std::uint64_t>(textureQuality)
+                | (static_cast<std::uint64_t>(mipFilter) << 8)
+                | (static_cast<std::uint64_t>(preserveAlphaCoverage) << 16)
+                | (static_cast<std::uint64_t>(exportGLTF) << 24)
+                | (static_cast<std::uint64_t>(quantizeVertices) << 32)
+                | (static_cast<std::uint64_t>(compressModels) << 40);
+        }
+    };
+}
@@ -2,22 +2,41 @@
 // Created by jglrxavpok on 10/09/2024.
 //
 // Heavily based on https://learnopengl.com/PBR/IBL/Diffuse-irradiance
+// Specular prefiltering and BRDF integration follow "Real Shading in Unreal Engine 4" (Karis 2013), with the filtered
+// importance sampling of "GPU-Based Importance Sampling" (GPU Gems 3, chapter 20)
 
 #include "EnvironmentMapProcessing.h"
 #include <stb_image.h>
 #include <array>
+#include <bit>
 #include <core/Macros.h>
 #include <core/containers/Vector.hpp>
+#include <core/utils/Profiling.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <ktx.h>
-#include <glm/ext/matrix_transform.hpp>
 #include <vulkan/vulkan_core.h>
 
 namespace Fertilizer {
 
     constexpr glm::vec2 invAtan = glm::vec2(0.1591f, 0.3183f);
 
+    /// Samples used per texel of prefiltered specular mips
+    constexpr std::uint32_t SpecularSampleCount = 64;
+
+    /// Samples used per texel of the BRDF lookup table
+    constexpr std::uint32_t BRDFSampleCount = 512;
+
+    /// Face size of the mip used to compute spherical harmonics: SH9 only keep low frequencies, more texels would not change the result
+    constexpr std::uint32_t SHFaceSize = 64;
+
+    /// Prefiltered specular texels are computed by tiles of about this many texels
+    constexpr std::uint32_t SpecularTileTexelCount = 4096;
+
+    /// Largest value representable by half floats, radiance is clamped to it
+    constexpr float MaxHalf = 65504.0f;
+
     static glm::vec2 toSphericalMap(const glm::vec3& cubeUV) {
         // difference from LearnOpenGL: - on X to flip the entire cubemap horizontally to match with source .hdr file (as seen in ImageViewer)
         glm::vec2 uv = glm::vec2(-glm::atan(cubeUV.z, cubeUV.x), glm::asin(cubeUV.y));
@@ -26,7 +45,356 @@ namespace Fertilizer {
         return uv;
     }
 
-    ConversionResult processEnvironmentMap(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile) {
+    /// Orientation of a face of a Vulkan cubemap
+    struct CubemapFace {
+        glm::vec3 forward; //< direction of the center of the face
+        glm::vec3 right; //< direction of increasing u
+        glm::vec3 down; //< direction of increasing v (rows)
+    };
+
+    // follows KTX2 order
+    static const std::array<CubemapFace, 6> CubemapFaces = {
+        // +X
+        CubemapFace { .forward = { 1, 0, 0 }, .right = { 0, 0, -1 }, .down = { 0, -1, 0 } },
+        // -X
+        CubemapFace { .forward = { -1, 0, 0 }, .right = { 0, 0, 1 }, .down = { 0, -1, 0 } },
+        // +Y
+        CubemapFace { .forward = { 0, 1, 0 }, .right = { 1, 0, 0 }, .down = { 0, 0, 1 } },
+        // -Y
+        CubemapFace { .forward = { 0, -1, 0 }, .right = { 1, 0, 0 }, .down = { 0, 0, -1 } },
+        // +Z
+        CubemapFace { .forward = { 0, 0, 1 }, .right = { 1, 0, 0 }, .down = { 0, -1, 0 } },
+        // -Z
+        CubemapFace { .forward = { 0, 0, -1 }, .right = { -1, 0, 0 }, .down = { 0, -1, 0 } },
+    };
+
+    glm::vec3 getCubemapDirection(std::uint32_t face, float u, float v) {
+        const CubemapFace& cubemapFace = CubemapFaces[face];
+        return glm::normalize(cubemapFace.forward + u * cubemapFace.right + v * cubemapFace.down);
+    }
+
+    /// Inverse of getCubemapDirection: face pointed to by 'direction', and coordinates (u, v) on this face
+    static std::uint32_t getCubemapFace(const glm::vec3& direction, float& u, float& v) {
+        const glm::vec3 absDirection = glm::abs(direction);
+        std::uint32_t face;
+        if(absDirection.x >= absDirection.y && absDirection.x >= absDirection.z) {
+            face = direction.x > 0 ? 0 : 1;
+        } else if(absDirection.y >= absDirection.z) {
+            face = direction.y > 0 ? 2 : 3;
+        } else {
+            face = direction.z > 0 ? 4 : 5;
+        }
+        const CubemapFace& cubemapFace = CubemapFaces[face];
+        const float majorAxis = glm::dot(direction, cubemapFace.forward);
+        u = glm::dot(direction, cubemapFace.right) / majorAxis;
+        v = glm::dot(direction, cubemapFace.down) / majorAxis;
+        return face;
+    }
+
+    /// Bilinear sample of a face of a cubemap. Does not filter across faces: samples on the border are clamped to their face
+    static glm::vec3 sampleCubemapFace(const Carrot::Mipmaps::PlanarImage& cubemap, std::uint32_t face, float u, float v) {
+        const std::uint32_t faceSize = cubemap.width;
+        const float x = glm::clamp((u * 0.5f + 0.5f) * faceSize - 0.5f, 0.0f, faceSize - 1.0f);
+        const float y = glm::clamp((v * 0.5f + 0.5f) * faceSize - 0.5f, 0.0f, faceSize - 1.0f);
+        const std::uint32_t x0 = static_cast<std::uint32_t>(x);
+        const std::uint32_t y0 = static_cast<std::uint32_t>(y);
+        const std::uint32_t x1 = std::min(x0 + 1, faceSize - 1);
+        const std::uint32_t y1 = std::min(y0 + 1, faceSize - 1);
+        const float fx = x - x0;
+        const float fy = y - y0;
+
+        const std::size_t row0 = (static_cast<std::size_t>(face) * faceSize + y0) * faceSize;
+        const std::size_t row1 = (static_cast<std::size_t>(face) * faceSize + y1) * faceSize;
+        glm::vec3 result;
+        for(std::uint32_t channel = 0; channel < 3; channel++) {
+            std::span<const float> plane = cubemap.getPlane(channel);
+            const float top = plane[row0 + x0] + (plane[row0 + x1] - plane[row0 + x0]) * fx;
+            const float bottom = plane[row1 + x0] + (plane[row1 + x1] - plane[row1 + x0]) * fx;
+            result[channel] = top + (bottom - top) * fy;
+        }
+        return result;
+    }
+
+    /// Trilinear sample of a mip chain of cubemaps (see computeCubemapMips)
+    static glm::vec3 sampleCubemapLod(std::span<const Carrot::Mipmaps::PlanarImage> mips, const glm::vec3& direction, float lod) {
+        float u;
+        float v;
+        const std::uint32_t face = getCubemapFace(direction, u, v);
+        lod = glm::clamp(lod, 0.0f, static_cast<float>(mips.size() - 1));
+        const std::uint32_t mip0 = static_cast<std::uint32_t>(lod);
+        const std::uint32_t mip1 = std::min<std::uint32_t>(mip0 + 1, mips.size() - 1);
+        const glm::vec3 color0 = sampleCubemapFace(mips[mip0], face, u, v);
+        if(mip0 == mip1) {
+            return color0;
+        }
+        return glm::mix(color0, sampleCubemapFace(mips[mip1], face, u, v), lod - mip0);
+    }
+
+    /// Point i of a Hammersley sequence of 'count' points
+    static glm::vec2 hammersley(std::uint32_t i, std::uint32_t count) {
+        const std::uint32_t reversedBits = (i << 16u) | (i >> 16u);
+        std::uint32_t bits = reversedBits;
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return glm::vec2 { static_cast<float>(i) / count, static_cast<float>(bits) * 2.3283064365386963e-10f };
+    }
+
+    /// Half vector sampled proportionally to D(h)*NdotH, in tangent space (normal is +Z). Same as importanceSample_GGX in brdf.glsl
+    static glm::vec3 importanceSampleGGX(const glm::vec2& xi, float roughness) {
+        const float alpha = roughness * roughness;
+        const float phi = 2.0f * glm::pi<float>() * xi.x;
+        const float cosTheta = glm::sqrt(glm::max(0.0f, (1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y)));
+        const float sinTheta = glm::sqrt(glm::max(0.0f, 1.0f - cosTheta * cosTheta));
+        return glm::vec3 { sinTheta * glm::cos(phi), sinTheta * glm::sin(phi), cosTheta };
+    }
+
+    /// GGX normal distribution function
+    static float distributionGGX(float NdotH, float roughness) {
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float denominator = NdotH * NdotH * (alpha2 - 1.0f) + 1.0f;
+        return alpha2 / (glm::pi<float>() * denominator * denominator);
+    }
+
+    /// Smith shadowing-masking term, same as G in brdf.glsl
+    static float geometrySmithGGX(float NdotL, float NdotV, float roughness) {
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float attenuationL = 2.0f * NdotL / (NdotL + glm::sqrt(alpha2 + (1.0f - alpha2) * (NdotL * NdotL)));
+        const float attenuationV = 2.0f * NdotV / (NdotV + glm::sqrt(alpha2 + (1.0f - alpha2) * (NdotV * NdotV)));
+        return attenuationL * attenuationV;
+    }
+
+    /// Real spherical harmonics basis, up to band 2
+    static std::array<float, 9> evaluateSHBasis(const glm::vec3& n) {
+        return {
+            0.282095f,
+            0.488603f * n.y,
+            0.488603f * n.z,
+            0.488603f * n.x,
+            1.092548f * n.x * n.y,
+            1.092548f * n.y * n.z,
+            0.315392f * (3.0f * n.z * n.z - 1.0f),
+            1.092548f * n.x * n.z,
+            0.546274f * (n.x * n.x - n.y * n.y),
+        };
+    }
+
+    /// Solid angle of the rectangle between (0, 0) and (x, y) on a face at distance 1 of the center of the cube
+    static double computeAreaElement(double x, double y) {
+        return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0));
+    }
+
+    IrradianceSH computeIrradianceSH(const Carrot::Mipmaps::PlanarImage& cubemap) {
+        ZoneScoped;
+        const std::uint32_t faceSize = cubemap.width;
+        verify(cubemap.height == faceSize * 6 && cubemap.channelCount >= 3, "Expected a cubemap");
+
+        // accumulate in double, in a fixed order: results do not depend on threads
+        std::array<glm::dvec3, 9> radianceSH{};
+        double totalSolidAngle = 0.0;
+        const double texelSize = 2.0 / faceSize;
+        for(std::uint32_t face = 0; face < 6; face++) {
+            for(std::uint32_t y = 0; y < faceSize; y++) {
+                for(std::uint32_t x = 0; x < faceSize; x++) {
+                    const double u0 = -1.0 + x * texelSize;
+                    const double v0 = -1.0 + y * texelSize;
+                    const double solidAngle = computeAreaElement(u0, v0) - computeAreaElement(u0, v0 + texelSize)
+                                            - computeAreaElement(u0 + texelSize, v0) + computeAreaElement(u0 + texelSize, v0 + texelSize);
+                    const glm::vec3 direction = getCubemapDirection(face, static_cast<float>(u0 + texelSize / 2), static_cast<float>(v0 + texelSize / 2));
+                    const std::size_t texelIndex = (static_cast<std::size_t>(face) * faceSize + y) * faceSize + x;
+                    const glm::dvec3 radiance {
+                        cubemap.getPlane(0)[texelIndex],
+                        cubemap.getPlane(1)[texelIndex],
+                        cubemap.getPlane(2)[texelIndex],
+                    };
+
+                    const std::array<float, 9> basis = evaluateSHBasis(direction);
+                    for(std::size_t i = 0; i < basis.size(); i++) {
+                        radianceSH[i] += radiance * static_cast<double>(basis[i]) * std::abs(solidAngle);
+                    }
+                    totalSolidAngle += std::abs(solidAngle);
+                }
+            }
+        }
+
+        // convolution with a clamped cosine lobe (Ramamoorthi & Hanrahan, 2001)
+        constexpr std::array<double, 3> BandFactors = { glm::pi<double>(), 2.0 * glm::pi<double>() / 3.0, glm::pi<double>() / 4.0 };
+        const double normalization = 4.0 * glm::pi<double>() / totalSolidAngle; // corrects rounding errors of solid angles
+        IrradianceSH result;
+        for(std::size_t i = 0; i < result.size(); i++) {
+            const std::size_t band = i == 0 ? 0 : (i < 4 ? 1 : 2);
+            result[i] = glm::vec3(radianceSH[i] * BandFactors[band] * normalization);
+        }
+        return result;
+    }
+
+    glm::vec3 evaluateIrradianceSH(const IrradianceSH& sh, const glm::vec3& normal) {
+        const std::array<float, 9> basis = evaluateSHBasis(normal);
+        glm::vec3 irradiance { 0.0f };
+        for(std::size_t i = 0; i < basis.size(); i++) {
+            irradiance += sh[i] * basis[i];
+        }
+        return glm::max(irradiance, glm::vec3(0.0f));
+    }
+
+    std::vector<Carrot::Mipmaps::PlanarImage> computeCubemapMips(const Carrot::Mipmaps::PlanarImage& cubemap) {
+        ZoneScoped;
+        verify(cubemap.height == cubemap.width * 6, "Expected a cubemap");
+        std::vector<Carrot::Mipmaps::PlanarImage> mips;
+        mips.emplace_back(cubemap);
+
+        // faces are stacked vertically: a 2x box filter never mixes two faces as long as faces have an even size
+        while(mips.back().width > 1) {
+            const Carrot::Mipmaps::PlanarImage& previous = mips.back();
+            Carrot::Mipmaps::PlanarImage mip;
+            const std::uint32_t faceSize = previous.width / 2;
+            mip.resize(faceSize, faceSize * 6, previous.channelCount);
+            Carrot::Mipmaps::resample(previous, mip, Carrot::Mipmaps::Filter::Box);
+            mips.emplace_back(std::move(mip));
+        }
+        return mips;
+    }
+
+    void prefilterSpecular(std::span<const Carrot::Mipmaps::PlanarImage> radianceMips, std::uint32_t sampleCount,
+                           std::span<Carrot::Mipmaps::PlanarImage> specularMips) {
+        ZoneScoped;
+        verify(!radianceMips.empty() && !specularMips.empty(), "Expected at least one mip");
+        verify(sampleCount > 0, "Expected at least one sample");
+        const std::uint32_t baseFaceSize = radianceMips[0].width;
+        const std::size_t specularMipCount = specularMips.size();
+
+        // roughness 0 is a perfect mirror
+        specularMips[0] = radianceMips[0];
+        if(specularMipCount == 1) {
+            return;
+        }
+
+        // with N=V=R, the sampled directions around N and the mip to read them from only depend on the roughness
+        struct Sample {
+            glm::vec3 direction; //< tangent space, normal is +Z
+            float lod;
+        };
+        std::vector<std::vector<Sample>> samplesPerMip(specularMipCount);
+        const float texelSolidAngle = 4.0f * glm::pi<float>() / (6.0f * baseFaceSize * baseFaceSize);
+        for(std::size_t mip = 1; mip < specularMipCount; mip++) {
+            const float roughness = static_cast<float>(mip) / (specularMipCount - 1);
+            for(std::uint32_t i = 0; i < sampleCount; i++) {
+                const glm::vec3 halfVector = importanceSampleGGX(hammersley(i, sampleCount), roughness);
+                const glm::vec3 lightDirection = 2.0f * halfVector.z * halfVector - glm::vec3(0, 0, 1);
+                if(lightDirection.z <= 0.0f) {
+                    continue;
+                }
+
+                // read from the mip whose texels cover the solid angle of the sample (+1 to smooth it a bit)
+                const float pdf = distributionGGX(halfVector.z, roughness) / 4.0f; // D * NdotH / (4 * VdotH) with N=V
+                const float sampleSolidAngle = 1.0f / (sampleCount * pdf + 1e-6f);
+                const float lod = glm::max(0.0f, 0.5f * glm::log2(sampleSolidAngle / texelSolidAngle) + 1.0f);
+                samplesPerMip[mip].emplace_back(Sample { lightDirection, lod });
+            }
+        }
+
+        // split all mips and faces into tiles of rows of similar texel counts, and compute them all in parallel
+        struct Tile {
+            std::uint32_t mip;
+            std::uint32_t face;
+            std::uint32_t firstRow;
+            std::uint32_t rowCount;
+        };
+        std::vector<Tile> tiles;
+        for(std::uint32_t mip = 1; mip < specularMipCount; mip++) {
+            const std::uint32_t faceSize = std::max(1u, baseFaceSize >> mip);
+            specularMips[mip].resize(faceSize, faceSize * 6, 3);
+            const std::uint32_t rowsPerTile = std::max(1u, SpecularTileTexelCount / faceSize);
+            for(std::uint32_t face = 0; face < 6; face++) {
+                for(std::uint32_t row = 0; row < faceSize; row += rowsPerTile) {
+                    tiles.emplace_back(Tile { mip, face, row, std::min(rowsPerTile, faceSize - row) });
+                }
+            }
+        }
+
+        parallelFor(tiles.size(), [&](std::size_t tileIndex) {
+            const Tile& tile = tiles[tileIndex];
+            Carrot::Mipmaps::PlanarImage& output = specularMips[tile.mip];
+            const std::uint32_t faceSize = output.width;
+            const std::vector<Sample>& samples = samplesPerMip[tile.mip];
+            for(std::uint32_t y = tile.firstRow; y < tile.firstRow + tile.rowCount; y++) {
+                for(std::uint32_t x = 0; x < faceSize; x++) {
+                    const glm::vec3 normal = getCubemapDirection(tile.face, (x + 0.5f) / faceSize * 2.0f - 1.0f, (y + 0.5f) / faceSize * 2.0f - 1.0f);
+                    const glm::vec3 up = glm::abs(normal.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+                    const glm::vec3 tangentX = glm::normalize(glm::cross(up, normal));
+                    const glm::vec3 tangentY = glm::cross(normal, tangentX);
+
+                    glm::vec3 color { 0.0f };
+                    float totalWeight = 0.0f;
+                    for(const Sample& sample : samples) {
+                        const glm::vec3 direction = tangentX * sample.direction.x + tangentY * sample.direction.y + normal * sample.direction.z;
+                        color += sampleCubemapLod(radianceMips, direction, sample.lod) * sample.direction.z;
+                        totalWeight += sample.direction.z;
+                    }
+
+                    const std::size_t texelIndex = (static_cast<std::size_t>(tile.face) * faceSize + y) * faceSize + x;
+                    for(std::uint32_t channel = 0; channel < 3; channel++) {
+                        output.getPlane(channel)[texelIndex] = totalWeight > 0.0f ? color[channel] / totalWeight : 0.0f;
+                    }
+                }
+            }
+        }, 1);
+    }
+
+    void computeBRDFLUT(std::uint32_t size, std::uint32_t sampleCount, std::span<glm::vec2> lut) {
+        ZoneScoped;
+        verify(lut.size() >= static_cast<std::size_t>(size) * size, "Output is too small");
+        parallelFor(size, [&](std::size_t y) {
+            const float roughness = (y + 0.5f) / size;
+            for(std::uint32_t x = 0; x < size; x++) {
+                const float NdotV = (x + 0.5f) / size;
+                const glm::vec3 view { glm::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV };
+
+                float scale = 0.0f;
+                float bias = 0.0f;
+                for(std::uint32_t i = 0; i < sampleCount; i++) {
+                    const glm::vec3 halfVector = importanceSampleGGX(hammersley(i, sampleCount), roughness);
+                    const float VdotH = glm::dot(view, halfVector);
+                    const glm::vec3 lightDirection = 2.0f * VdotH * halfVector - view;
+                    const float NdotL = lightDirection.z;
+                    if(NdotL <= 0.0f) {
+                        continue;
+                    }
+
+                    // pdf is D * NdotH / (4 * VdotH): D cancels out
+                    const float NdotH = glm::max(halfVector.z, 0.0f);
+                    const float visibility = geometrySmithGGX(NdotL, NdotV, roughness) * VdotH / (NdotH * NdotV);
+                    const float fresnel = glm::pow(1.0f - VdotH, 5.0f);
+                    scale += (1.0f - fresnel) * visibility;
+                    bias += fresnel * visibility;
+                }
+                lut[y * size + x] = glm::vec2 { scale, bias } / static_cast<float>(sampleCount);
+            }
+        }, 4);
+    }
+
+    /// Converts a face of a cubemap to RGBA half floats, as written to the KTX2 file
+    static void writeFaceRGBA16(const Carrot::Mipmaps::PlanarImage& cubemap, std::uint32_t face, Carrot::Vector<std::uint16_t>& output) {
+        const std::size_t faceTexelCount = static_cast<std::size_t>(cubemap.width) * cubemap.width;
+        output.resize(faceTexelCount * 4);
+        Carrot::Vector<std::uint16_t> channelHalves;
+        channelHalves.resize(faceTexelCount);
+        for(std::uint32_t channel = 0; channel < 3; channel++) {
+            Carrot::Mipmaps::floatsToHalves(cubemap.getPlane(channel).subspan(face * faceTexelCount, faceTexelCount), channelHalves);
+            for(std::size_t i = 0; i < faceTexelCount; i++) {
+                output[i * 4 + channel] = channelHalves[i];
+            }
+        }
+        constexpr std::uint16_t HalfOne = 0x3C00;
+        for(std::size_t i = 0; i < faceTexelCount; i++) {
+            output[i * 4 + 3] = HalfOne;
+        }
+    }
+
+    ConversionResult processEnvironmentMap(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options) {
         int width = 0;
         int height = 0;
         int comp = 0;
@@ -48,8 +416,7 @@ namespace Fertilizer {
         CLEANUP(stbi_image_free(pixels));
 
         // 1. convert to cubemap
-        int faceWidth = 1024;
-        int faceHeight = 1024;
+        const std::uint32_t faceSize = EnvironmentFaceSize;
 
         ktxTexture2* texture;
         ktxTextureCreateInfo createInfo {};
@@ -57,17 +424,17 @@ namespace Fertilizer {
 
         createInfo.glInternalformat = 0;  //Ignored as we'll create a KTX2 texture.
 
-        createInfo.baseWidth = faceWidth;
-        createInfo.baseHeight = faceHeight;
+        createInfo.baseWidth = faceSize;
+        createInfo.baseHeight = faceSize;
         createInfo.baseDepth = 1;
         createInfo.numDimensions = 2;
 
-        createInfo.numLevels = 1;
+        createInfo.numLevels = SpecularMipCount;
         createInfo.numLayers = 1;
         createInfo.numFaces = 6;
         createInfo.isArray = KTX_FALSE;
         createInfo.generateMipmaps = KTX_FALSE;
-        createInfo.vkFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+        createInfo.vkFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 
         result = ktxTexture2_Create(&createInfo,
                                     KTX_TEXTURE_CREATE_ALLOC_STORAGE,
@@ -79,62 +446,86 @@ namespace Fertilizer {
                 .errorMessage = ktxErrorString(result),
             };
         }
+        CLEANUP(ktxTexture_Destroy(ktxTexture(texture)));
 
         // render each face: input texture is expected to be in equirectangular projection, convert to a cubemap
-        Carrot::Vector<glm::vec4> faceColors;
-        faceColors.resize(faceWidth * faceHeight);
-
-        constexpr glm::vec3 up = glm::vec3(0, 1, 0);
-        constexpr glm::vec3 right = glm::vec3(1, 0, 0);
-
-        // follows KTX2 order, left handed, Y up, Z forward
-        const std::array faceRotations = {
-            // +X
-            glm::rotate(glm::mat4{1.0f}, glm::half_pi<float>(), up),
-            // -X
-            glm::rotate(glm::mat4{1.0f}, -glm::half_pi<float>(), up),
-            // +Y
-            glm::rotate(glm::mat4{1.0f}, glm::half_pi<float>(), right),
-            // -Y
-            glm::rotate(glm::mat4{1.0f}, -glm::half_pi<float>(), right),
-            // +Z
-            glm::mat4{1.0f},
-            // -Z
-            glm::rotate(glm::mat4{1.0f}, glm::pi<float>(), up),
-        };
-        for(int face = 0; face < 6; face++) {
-            for(int y = 0; y < faceHeight; y++) {
-                for(int x = 0; x < faceWidth; x++) {
-                    // sample environment map
-                    glm::vec2 faceUV = glm::vec2(x / static_cast<float>(faceWidth), y / static_cast<float>(faceHeight)) *2.0f -1.0f;
-                    glm::vec3 cubeUV = faceRotations[face] * glm::vec4(faceUV, 1, 0);
-
-                    glm::vec2 equirectangularUV = toSphericalMap(glm::normalize(cubeUV));
-                    int pixelX = glm::round(equirectangularUV.x * (width-1));
-                    int pixelY = glm::round(equirectangularUV.y * (height-1));
-                    faceColors[x + y * faceWidth] = glm::vec4 {
-                        pixels[(pixelX + pixelY * width) * comp + 0],
-                        pixels[(pixelX + pixelY * width) * comp + 1],
-                        pixels[(pixelX + pixelY * width) * comp + 2],
-                        1.0f,
-                    };
+        Carrot::Mipmaps::PlanarImage cubemap;
+        cubemap.resize(faceSize, 6 * faceSize, 3);
+
+        // texels are independent: split the rows of all faces over threads
+        parallelFor(6 * faceSize, [&](std::size_t rowIndex) {
+            const std::uint32_t face = rowIndex / faceSize;
+            const std::uint32_t y = rowIndex % faceSize;
+            for(std::uint32_t x = 0; x < faceSize; x++) {
+                // sample environment map
+                const glm::vec3 direction = getCubemapDirection(face, (x + 0.5f) / faceSize * 2.0f - 1.0f, (y + 0.5f) / faceSize * 2.0f - 1.0f);
+
+                // equirectangular maps have +Y at the top, unlike rows of cubemap faces
+                glm::vec2 equirectangularUV = toSphericalMap(glm::vec3(direction.x, -direction.y, direction.z));
+                int pixelX = glm::round(equirectangularUV.x * (width-1));
+                int pixelY = glm::round(equirectangularUV.y * (height-1));
+                for(std::uint32_t channel = 0; channel < 3; channel++) {
+                    cubemap.getPlane(channel)[rowIndex * faceSize + x] = glm::clamp(pixels[(pixelX + pixelY * width) * comp + channel], 0.0f, MaxHalf);
                 }
             }
+        }, 16);
+
+        // 2. diffuse irradiance, as spherical harmonics
+        const std::vector<Carrot::Mipmaps::PlanarImage> radianceMips = computeCubemapMips(cubemap);
+        const std::size_t shMip = std::min<std::size_t>(radianceMips.size() - 1, std::countr_zero(faceSize / std::min(faceSize, SHFaceSize)));
+        const IrradianceSH irradianceSH = computeIrradianceSH(radianceMips[shMip]);
 
-            // write face to ktx2
-            result = ktxTexture_SetImageFromMemory(ktxTexture(texture),
-                                                       0, 0, face,
-                                                       reinterpret_cast<const std::uint8_t*>(faceColors.cdata()), faceColors.bytes_size());
-            if(result != ktx_error_code_e::KTX_SUCCESS) {
-                return {
-                    .errorCode = ConversionResultError::EnvironmentMapError,
-                    .errorMessage = ktxErrorString(result),
-                };
+        // 3. specular: radiance prefiltered for increasing roughnesses, in the mips of the cubemap
+        std::vector<Carrot::Mipmaps::PlanarImage> specularMips(SpecularMipCount);
+        prefilterSpecular(radianceMips, SpecularSampleCount, specularMips);
+
+        // 4. BRDF lookup table of the split sum approximation
+        Carrot::Vector<glm::vec2> brdfLUT;
+        brdfLUT.resize(BRDFLUTSize * BRDFLUTSize);
+        computeBRDFLUT(BRDFLUTSize, BRDFSampleCount, brdfLUT);
+
+        // write faces to ktx2
+        Carrot::Vector<std::uint16_t> faceTexels;
+        for(std::uint32_t mip = 0; mip < SpecularMipCount; mip++) {
+            for(std::uint32_t face = 0; face < 6; face++) {
+                writeFaceRGBA16(specularMips[mip], face, faceTexels);
+                result = ktxTexture_SetImageFromMemory(ktxTexture(texture),
+                                                       mip, 0, face,
+                                                       reinterpret_cast<const std::uint8_t*>(faceTexels.cdata()), faceTexels.size() * sizeof(std::uint16_t));
+                if(result != ktx_error_code_e::KTX_SUCCESS) {
+                    return {
+                        .errorCode = ConversionResultError::EnvironmentMapError,
+                        .errorMessage = ktxErrorString(result),
+                    };
+                }
             }
         }
 
+        std::array<float, 27> shValues;
+        for(std::size_t i = 0; i < irradianceSH.size(); i++) {
+            shValues[i * 3 + 0] = irradianceSH[i].x;
+            shValues[i * 3 + 1] = irradianceSH[i].y;
+            shValues[i * 3 + 2] = irradianceSH[i].z;
+        }
+        result = ktxHashList_AddKVPair(&texture->kvDataHead, IrradianceSHKey, sizeof(shValues), shValues.data());
+
+        if(result == ktx_error_code_e::KTX_SUCCESS) {
+            Carrot::Vector<std::uint16_t> lutValue;
+            lutValue.resize(4 + BRDFLUTSize * BRDFLUTSize * 2); // 2 uint32 for the size, then RG halves
+            const std::uint32_t lutSize[2] = { BRDFLUTSize, BRDFLUTSize };
+            memcpy(lutValue.data(), lutSize, sizeof(lutSize));
+            Carrot::Mipmaps::floatsToHalves(std::span<const float>(reinterpret_cast<const float*>(brdfLUT.cdata()), brdfLUT.size() * 2),
+                                            std::span<std::uint16_t>(lutValue.data() + 4, lutValue.size() - 4));
+            result = ktxHashList_AddKVPair(&texture->kvDataHead, BRDFLUTKey, lutValue.size() * sizeof(std::uint16_t), lutValue.cdata());
+        }
+        if(result != ktx_error_code_e::KTX_SUCCESS) {
+            return {
+                .errorCode = ConversionResultError::EnvironmentMapError,
+                .errorMessage = ktxErrorString(result),
+            };
+        }
+
         result = ktxTexture_WriteToNamedFile(ktxTexture(texture), outputFile.string().c_str());
-        ktxTexture_Destroy(ktxTexture(texture));
 
         return result == ktx_error_code_e::KTX_SUCCESS
         ? ConversionResult {
@@ -144,7 +535,5 @@ namespace Fertilizer {
             .errorCode = ConversionResultError::EnvironmentMapError,
             .errorMessage = ktxErrorString(result),
         };
-
-        // 3. TODO: create specular map
     }
 }
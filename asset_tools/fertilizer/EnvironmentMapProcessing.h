@@ -4,9 +4,73 @@
 
 #pragma once
 
+#include <array>
 #include <filesystem>
+#include <span>
+#include <vector>
 #include <Fertilizer.h>
+#include <core/render/Mipmaps.h>
+#include <glm/glm.hpp>
 
 namespace Fertilizer {
-    ConversionResult processEnvironmentMap(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
+    /// Key of the irradiance spherical harmonics in the key/value data of environment maps: 9 RGB coefficients, as 27 floats (see IrradianceSH)
+    constexpr const char* IrradianceSHKey = "Carrot.IrradianceSH9";
+
+    /// Key of the BRDF lookup table in the key/value data of environment maps: width and height as uint32, followed by
+    /// width*height RG half floats, see computeBRDFLUT
+    constexpr const char* BRDFLUTKey = "Carrot.BRDFLUT";
+
+    /// Size of the faces of environment cubemaps
+    constexpr std::uint32_t EnvironmentFaceSize = 1024;
+
+    /// Mips of environment cubemaps. Mip 0 is the environment itself, mip i is prefiltered for a GGX roughness of i/(SpecularMipCount-1)
+    constexpr std::uint32_t SpecularMipCount = 8;
+
+    /// Size of BRDF lookup tables stored in environment maps
+    constexpr std::uint32_t BRDFLUTSize = 64;
+
+    /**
+     * Irradiance spherical harmonics: E(n) = sum of coefficients[i] * Y_i(n), with the cosine lobe already convolved.
+     * Order is Y00, Y1-1, Y10, Y11, Y2-2, Y2-1, Y20, Y21, Y22. Diffuse lighting is albedo / pi * E(n).
+     * 'n' is in cubemap space, the same as the directions used to sample the cubemap.
+     */
+    using IrradianceSH = std::array<glm::vec3, 9>;
+
+    /*
+     * Cubemaps are stored as Carrot::Mipmaps::PlanarImage of 3 channels (RGB), faceSize wide and 6*faceSize high: faces
+     * are stacked vertically in KTX2 order (+X, -X, +Y, -Y, +Z, -Z), and follow the orientation of Vulkan cubemaps.
+     */
+
+    /// Direction (normalized) of point (u, v) of a face of a cubemap, u and v in [-1; 1], v going down
+    glm::vec3 getCubemapDirection(std::uint32_t face, float u, float v);
+
+    /// Projects the radiance of a cubemap on spherical harmonics, and convolves it with a cosine lobe
+    IrradianceSH computeIrradianceSH(const Carrot::Mipmaps::PlanarImage& cubemap);
+
+    /// Irradiance for 'normal' (cubemap space)
+    glm::vec3 evaluateIrradianceSH(const IrradianceSH& sh, const glm::vec3& normal);
+
+    /// Mips of a cubemap, box filtered, down to 1x1 faces. mips[0] is a copy of 'cubemap'
+    std::vector<Carrot::Mipmaps::PlanarImage> computeCubemapMips(const Carrot::Mipmaps::PlanarImage& cubemap);
+
+    /**
+     * Prefilters radiance with a GGX lobe (split sum approximation, N=V=R), for increasing roughnesses: specularMips[i]
+     * is for a roughness of i/(specularMips.size()-1), and is half as large as the previous one. specularMips[0] is the
+     * environment itself.
+     * Directions are importance sampled with a Hammersley sequence, and read from a mip of 'radianceMips' which matches
+     * the solid angle of each sample, so 'sampleCount' can stay low without aliasing. Results do not depend on the
+     * thread count.
+     * All mips, faces and tiles of texels are split over threads at once, via Fertilizer::parallelFor.
+     * \param radianceMips result of computeCubemapMips
+     */
+    void prefilterSpecular(std::span<const Carrot::Mipmaps::PlanarImage> radianceMips, std::uint32_t sampleCount,
+                           std::span<Carrot::Mipmaps::PlanarImage> specularMips);
+
+    /**
+     * Integrates the GGX specular BRDF for the split sum approximation: lut[x + y * size] is (scale, bias) to apply to F0,
+     * for NdotV = (x+0.5)/size and roughness = (y+0.5)/size.
+     */
+    void computeBRDFLUT(std::uint32_t size, std::uint32_t sampleCount, std::span<glm::vec2> lut);
+
+    ConversionResult processEnvironmentMap(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options);
 }
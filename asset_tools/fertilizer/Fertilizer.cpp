@@ -10,7 +10,9 @@
 #include <unordered_map>
 #include <filesystem>
 #include <ParticleProcessing.h>
+#include <stb_image.h>
 
+#include "core/tasks/Tasks.h"
 #include "core/utils/stringmanip.h"
 
 namespace Fertilizer {
@@ -32,10 +34,10 @@ namespace Fertilizer {
             { ".pic", { ".ktx2",  compressTexture } },
             { ".pnm", { ".ktx2",  compressTexture } },
 
-            { ".gltf", { ".gltf", processGLTF } },
-            { ".glb", { ".gltf", processGLTF } },
-            { ".obj", { ".gltf", processAssimp } },
-            { ".fbx", { ".gltf", processAssimp } },
+            { ".gltf", { ".cmodel", processGLTF } },
+            { ".glb", { ".cmodel", processGLTF } },
+            { ".obj", { ".cmodel", processAssimp } },
+            { ".fbx", { ".cmodel", processAssimp } },
 
         { ".hdr", { ".ktx2",  processEnvironmentMap } },
 
@@ -46,11 +48,64 @@ namespace Fertilizer {
         return ConversionFunctions.find(input.extension().string()) != ConversionFunctions.end();
     }
 
-    bool requiresModifications(const fspath& inputFile, const fspath& outputFile) {
-        if(!std::filesystem::exists(outputFile))
-            return true;
-        // TODO GMTK: make this an option. Needed for asset server to work properly on "exported" builds
-        return std::filesystem::last_write_time(inputFile) != std::filesystem::last_write_time(outputFile);
+    /// Do all outputs of the manifest exist, with the expected sizes?
+    static bool outputsExist(const fspath& outputFile, const AssetManifest& manifest) {
+        const fspath outputFolder = outputFile.parent_path();
+        for(const OutputFileRecord& record : manifest.outputs) {
+            std::error_code error;
+            const std::uintmax_t size = std::filesystem::file_size(outputFolder / record.path, error);
+            if(error || size != record.size) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Checks if the output matches the manifest written during its conversion. Fills 'manifest' with the current state of the inputs
+    static bool isUpToDate(const fspath& inputFile, const fspath& outputFile, const ConversionOptions& options, const std::optional<AssetManifest>& previous, AssetManifest& manifest) {
+        manifest.key = computeAssetKey(inputFile, outputFile, options, previous.has_value() ? &previous.value() : nullptr, manifest.inputs);
+        return previous.has_value()
+            && previous->key == manifest.key
+            && previous->outputs[0].path == outputFile.filename()
+            && outputsExist(outputFile, *previous);
+    }
+
+    /// Files written by the conversion to 'outputFile', relative to its folder
+    static std::vector<OutputFileRecord> collectOutputs(const fspath& outputFile, const ConversionOptions& options) {
+        std::vector<OutputFileRecord> outputs;
+        const fspath outputFolder = outputFile.parent_path();
+        auto addOutput = [&](const fspath& path) {
+            outputs.push_back(OutputFileRecord {
+                .path = path.lexically_relative(outputFolder),
+                .size = std::filesystem::file_size(path),
+            });
+        };
+
+        // glTF outputs reference their buffers (images are other assets, converted separately)
+        auto addGLTF = [&](const fspath& gltfFile) {
+            addOutput(gltfFile);
+            for(const fspath& dependency : findDependencies(gltfFile)) {
+                if(dependency.extension() != ".bin" || !std::filesystem::is_regular_file(dependency)) {
+                    continue;
+                }
+                addOutput(dependency);
+            }
+        };
+
+        if(outputFile.extension() == ".gltf") {
+            addGLTF(outputFile);
+        } else {
+            addOutput(outputFile);
+            if(outputFile.extension() == ".cmodel" && options.exportGLTF) {
+                addGLTF(getExportedGLTFPath(outputFile));
+            }
+        }
+        return outputs;
+    }
+
+    bool requiresModifications(const fspath& inputFile, const fspath& outputFile, const ConversionOptions& options) {
+        AssetManifest manifest;
+        return !isUpToDate(inputFile, outputFile, options, AssetManifest::read(getManifestPath(outputFile)), manifest);
     }
 
     std::filesystem::path makeOutputPath(const std::filesystem::path& inputFile) {
@@ -78,7 +133,7 @@ namespace Fertilizer {
         return {};
     }
 
-    ConversionResult convert(const fspath& inputFile, const fspath& outputFile, bool forceConvert) {
+    ConversionResult convert(const fspath& inputFile, const fspath& outputFile, bool forceConvert, const AssetCache* pCache, const ConversionOptions& options) {
         auto convertorIt = ConversionFunctions.find(inputFile.extension().string());
         if(convertorIt == ConversionFunctions.end()) {
             return {
@@ -94,10 +149,30 @@ namespace Fertilizer {
             };
         }
 
-        if(!forceConvert && !requiresModifications(inputFile, outputFile)) {
+        if(!std::filesystem::exists(inputFile)) {
+            return {
+                .errorCode = ConversionResultError::InputFileDoesNotExist,
+                .errorMessage = Carrot::sprintf("Input file does not exist: %s", inputFile.string().c_str()),
+            };
+        }
+
+        const fspath manifestPath = getManifestPath(outputFile);
+        const std::optional<AssetManifest> previousManifest = AssetManifest::read(manifestPath);
+        AssetManifest manifest;
+        const bool upToDate = isUpToDate(inputFile, outputFile, options, previousManifest, manifest);
+        if(!forceConvert && upToDate) {
+            bool rehashed = false; // if inputs were touched without changing their contents, avoid hashing them again next time
+            for(std::size_t i = 0; i < manifest.inputs.size(); i++) {
+                rehashed |= i >= previousManifest->inputs.size() || previousManifest->inputs[i].writeTime != manifest.inputs[i].writeTime;
+            }
+            if(rehashed) {
+                manifest.outputs = previousManifest->outputs;
+                manifest.write(manifestPath);
+            }
             return {
                 .errorCode = ConversionResultError::Success,
                 .errorMessage = "Asset already up-to-date",
+                .status = ConversionStatus::UpToDate,
             };
         }
 
@@ -106,12 +181,62 @@ namespace Fertilizer {
             std::filesystem::create_directories(outputFolder);
         }
 
-        ConversionResult result = convertorIt->second.func(inputFile, outputFile);
+        if(!forceConvert && pCache != nullptr && pCache->restore(manifest.key, outputFile, manifest.outputs)) {
+            manifest.write(manifestPath);
+            return {
+                .errorCode = ConversionResultError::Success,
+                .errorMessage = "Asset restored from cache",
+                .status = ConversionStatus::RestoredFromCache,
+            };
+        }
+
+        // if the conversion fails, the old output must not be considered up-to-date
+        std::filesystem::remove(manifestPath);
+        ConversionResult result = convertorIt->second.func(inputFile, outputFile, options);
 
         if(result.errorCode == ConversionResultError::Success) {
-            makeTimestampsMatch(inputFile, outputFile);
+            manifest.outputs = collectOutputs(outputFile, options);
+            manifest.write(manifestPath);
+            if(pCache != nullptr) {
+                pCache->store(manifest.key, outputFile, manifest.outputs);
+            }
         }
 
         return result;
     }
+    std::uint64_t estimateConversionCost(const fspath& inputFile) {
+        std::error_code error;
+        const std::uintmax_t fileSize = std::filesystem::file_size(inputFile, error);
+        if(error) {
+            return 0;
+        }
+
+        // images are compressed on disk, what matters is the amount of pixels to filter and encode
+        int width = 0;
+        int height = 0;
+        int componentCount = 0;
+        if(stbi_info(inputFile.string().c_str(), &width, &height, &componentCount)) {
+            const std::uint64_t bytesPerComponent = stbi_is_hdr(inputFile.string().c_str()) ? sizeof(float) : sizeof(std::uint8_t);
+            return static_cast<std::uint64_t>(width) * height * componentCount * bytesPerComponent;
+        }
+
+        std::uint64_t cost = fileSize;
+        for(const fspath& dependency : findDependencies(inputFile)) {
+            const std::uintmax_t dependencySize = std::filesystem::file_size(dependency, error);
+            if(!error) {
+                cost += dependencySize;
+            }
+        }
+        return cost;
+    }
+
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity) {
+        if(count > granularity && Carrot::Async::parallelFor != nullptr) {
+            Carrot::Async::parallelFor(count, forEach, granularity);
+            return;
+        }
+        for(std::size_t i = 0; i < count; i++) {
+            forEach(i);
+        }
+    }
 }
\ No newline at end of file
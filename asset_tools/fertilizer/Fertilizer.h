@@ -5,6 +5,9 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
+#include <AssetCache.h>
+#include <ConversionOptions.h>
 
 namespace Fertilizer {
     enum class ConversionResultError {
@@ -17,12 +20,20 @@ namespace Fertilizer {
         EnvironmentMapError,
     };
 
+    /// How the output of a successful conversion was obtained
+    enum class ConversionStatus {
+        Converted,
+        UpToDate, //< output already matched the contents of the input, nothing was done
+        RestoredFromCache, //< output copied from the AssetCache
+    };
+
     struct ConversionResult {
         ConversionResultError errorCode = ConversionResultError::Success;
         std::string errorMessage;
+        ConversionStatus status = ConversionStatus::Converted;
     };
 
-    using ConversionFunction = ConversionResult(*)(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
+    using ConversionFunction = ConversionResult(*)(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options);
 
     /**
      * Returns true iif the format of the given file path is one Fertilizer cares about.
@@ -30,11 +41,12 @@ namespace Fertilizer {
     bool isSupportedFormat(const std::filesystem::path& input);
 
     /**
-     * Checks timestamps of inputFile and outputFile to check if the conversion needs to be redone.
-     * Performs an equality check, not a >= check: input assets could be rolled back via a version control system and we
-     * would need to rerun the conversion on the old asset.
+     * Checks whether the conversion needs to be redone: compares the content hash of inputFile and of its dependencies
+     * with the one stored in the manifest of outputFile (see AssetManifest), and checks that the outputs still exist.
+     * Timestamps are only used to avoid hashing files which did not change since the manifest was written, so checkouts,
+     * branch switches and rollbacks via a version control system do not trigger conversions if the contents are the same.
      */
-    bool requiresModifications(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
+    bool requiresModifications(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options = {});
 
     /**
      * Creates a new path with the extension of the input replaced with the extension used for the output.
@@ -47,5 +59,24 @@ namespace Fertilizer {
      */
     ConversionResult copyConvert(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
 
-    ConversionResult convert(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, bool forceConvert);
+    /**
+     * Converts inputFile to outputFile, unless the output is already up-to-date (see requiresModifications) or
+     * stored in 'pCache'. After a conversion, the outputs are stored in 'pCache', if not null.
+     * A manifest is written next to the output, to know what it was converted from.
+     */
+    ConversionResult convert(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, bool forceConvert, const AssetCache* pCache = nullptr, const ConversionOptions& options = {});
+
+    /**
+     * Rough estimate of the work needed to convert inputFile, in bytes of data to process: decoded pixels for textures,
+     * size of the file and of its dependencies for models. Only meant to compare assets with each other, so that batch
+     * conversions can start with the largest ones.
+     */
+    std::uint64_t estimateConversionCost(const std::filesystem::path& inputFile);
+
+    /**
+     * Used by converters to split their work over threads: runs on Carrot::Async::parallelFor when it is bound to a
+     * scheduler (by the fertilizer executable, or by the engine for the AssetServer), and serially otherwise.
+     * Same arguments as Carrot::Async::parallelFor.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity);
 }
\ No newline at end of file
@@ -11,7 +11,7 @@
 #include <node_based/nodes/DefaultNodes.h>
 
 namespace Fertilizer {
-    ConversionResult processParticleFile(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile) {
+    ConversionResult processParticleFile(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options) {
         EditorGraph updateGraph{"update"};
         EditorGraph renderGraph{"render"};
 
@@ -8,5 +8,5 @@
 #include <Fertilizer.h>
 
 namespace Fertilizer {
-    ConversionResult processParticleFile(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
+    ConversionResult processParticleFile(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options);
 } // Fertilizer
\ No newline at end of file
@@ -3,11 +3,14 @@
 //
 
 #include <TextureCompression.h>
+#include <Fertilizer.h>
+#include <algorithm>
+#include <atomic>
+#include <optional>
 #include <iostream>
-#include <thread>
 #include "core/Macros.h"
 #include "core/utils/stringmanip.h"
-#include "core/tasks/Tasks.h"
+#include "core/tasks/TaskScheduler.h"
 
 // single file implementations
 #define STB_IMAGE_IMPLEMENTATION
@@ -26,12 +29,56 @@ int main(int argc, char** argv) {
     bool forceConvert = false;
     std::filesystem::path inputFile;
     std::filesystem::path outputFile;
+    std::filesystem::path cacheDirectory;
+    Fertilizer::ConversionOptions options;
+    if(const char* cacheFromEnvironment = std::getenv("CARROT_FERTILIZER_CACHE")) {
+        cacheDirectory = cacheFromEnvironment;
+    }
     for (int i = 1; i < argc;) {
         const std::string_view arg = argv[i];
         if(arg == "-r" || arg == "--recursive") {
             recursive = true;
         } else if(arg == "-f" || arg == "--force") {
             forceConvert = true;
+        } else if(arg == "--cache") {
+            if(i + 1 >= argc) {
+                std::cerr << "Missing cache directory after --cache" << std::endl;
+                valid = false;
+            } else {
+                cacheDirectory = argv[++i];
+            }
+        } else if(arg == "--texture-quality") {
+            const std::string_view quality = i + 1 < argc ? argv[++i] : "";
+            if(quality == "fast") {
+                options.textureQuality = Fertilizer::TextureCompressionQuality::Fast;
+            } else if(quality == "normal") {
+                options.textureQuality = Fertilizer::TextureCompressionQuality::Normal;
+            } else if(quality == "high") {
+                options.textureQuality = Fertilizer::TextureCompressionQuality::High;
+            } else {
+                std::cerr << "Expected fast, normal or high after --texture-quality" << std::endl;
+                valid = false;
+            }
+        } else if(arg == "--mip-filter") {
+            const std::string_view filter = i + 1 < argc ? argv[++i] : "";
+            if(filter == "box") {
+                options.mipFilter = Carrot::Mipmaps::Filter::Box;
+            } else if(filter == "kaiser") {
+                options.mipFilter = Carrot::Mipmaps::Filter::Kaiser;
+            } else if(filter == "lanczos") {
+                options.mipFilter = Carrot::Mipmaps::Filter::Lanczos;
+            } else {
+                std::cerr << "Expected box, kaiser or lanczos after --mip-filter" << std::endl;
+                valid = false;
+            }
+        } else if(arg == "--preserve-alpha-coverage") {
+            options.preserveAlphaCoverage = true;
+        } else if(arg == "--export-gltf") {
+            options.exportGLTF = true;
+        } else if(arg == "--quantize-vertices") {
+            options.quantizeVertices = true;
+        } else if(arg == "--uncompressed-models") {
+            options.compressModels = false;
         } else {
             if(!hasInput) {
                 inputFile = arg;
@@ -82,50 +129,117 @@ int main(int argc, char** argv) {
         allOutputs.push_back(outputFile);
     }
 
-    int errorCode = 0;
-    const unsigned int maxThreads = std::thread::hardware_concurrency();
-    const unsigned int stepSize = ceil(allInputs.size() / (float)maxThreads);
+    // textures are converted independently of the models using them: tell them beforehand which ones are normal maps
+    std::vector<std::vector<std::filesystem::path>> normalMapsPerInput;
+    normalMapsPerInput.resize(allInputs.size());
+    Fertilizer::parallelFor(allInputs.size(), [&](std::size_t index) {
+        normalMapsPerInput[index] = Fertilizer::findNormalMaps(allInputs[index]);
+    }, 16);
+    for(const auto& normalMaps : normalMapsPerInput) {
+        options.normalMaps.insert(normalMaps.begin(), normalMaps.end());
+    }
 
-    Carrot::Async::parallelFor = [](std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity) {
-        // TODO: make it actually parallel
-        for(std::size_t i = 0; i < count; i++) {
-            forEach(i);
-        }
-    };
-
-    std::vector<std::thread> threads;
-    threads.reserve(maxThreads);
-    for(std::size_t i = 0; i < allInputs.size(); i += stepSize) {
-        threads.emplace_back([&, i]()
-        {
-            for (int j = 0; j < stepSize; ++j) {
-                unsigned int index = j + i;
-                if(index >= allInputs.size()) {
-                    continue;
-                }
+    std::atomic<int> errorCode { 0 };
 
-                const auto& input = allInputs[index];
-                const auto& output = allOutputs[index];
-                std::cout << Carrot::sprintf("Converting %s (%llu / %llu)\n", input.string().c_str(), index+1, allInputs.size());
-                Fertilizer::ConversionResult result = Fertilizer::convert(input, output, forceConvert);
-                switch(result.errorCode) {
-                    case Fertilizer::ConversionResultError::Success:
-                        break;
+    // no asset loading in the fertilizer: assets are converted with parallelFor, and converters use parallelFor for
+    // their own work (block compression, mips, cubemap faces, primitives of models). Both run on the same work-stealing
+    // threads, so threads which are done with their assets help with the sub-tasks of the assets still being converted
+    Carrot::TaskScheduler taskScheduler { Carrot::TaskSchedulerConfig {
+        .assetLoadingThreads = 0,
+    } };
+    taskScheduler.bindAsyncParallelFor();
 
-                    default:
-                        errorCode = -1;
-                        std::cerr << "[" << input << "] Conversion failed: " << result.errorMessage << std::endl;
+    std::optional<Fertilizer::AssetCache> cache;
+    if(!cacheDirectory.empty()) {
+        cache.emplace(cacheDirectory);
+    }
+    std::atomic<std::size_t> convertedCount { 0 };
+    std::atomic<std::size_t> upToDateCount { 0 };
+    std::atomic<std::size_t> restoredCount { 0 };
+    std::atomic<std::size_t> startedCount { 0 };
+
+    // largest assets first: a large asset started last would keep a single thread busy at the end of the batch
+    std::vector<std::uint64_t> estimatedCosts;
+    estimatedCosts.resize(allInputs.size());
+    Fertilizer::parallelFor(allInputs.size(), [&](std::size_t index) {
+        estimatedCosts[index] = Fertilizer::estimateConversionCost(allInputs[index]);
+    }, 16);
+    std::vector<std::size_t> conversionOrder;
+    conversionOrder.resize(allInputs.size());
+    for(std::size_t i = 0; i < conversionOrder.size(); i++) {
+        conversionOrder[i] = i;
+    }
+    std::stable_sort(conversionOrder.begin(), conversionOrder.end(), [&](std::size_t a, std::size_t b) {
+        return estimatedCosts[a] > estimatedCosts[b];
+    });
+
+    std::vector<float> conversionDurations; // in seconds, indexed like allInputs
+    conversionDurations.resize(allInputs.size());
+    std::vector<Fertilizer::ConversionStatus> conversionStatuses;
+    conversionStatuses.resize(allInputs.size(), Fertilizer::ConversionStatus::Converted);
+
+    // one asset at a time per thread, in conversionOrder
+    taskScheduler.parallelFor(conversionOrder.size(), [&](std::size_t orderIndex) {
+        const std::size_t index = conversionOrder[orderIndex];
+        const auto& input = allInputs[index];
+        const auto& output = allOutputs[index];
+        std::cout << Carrot::sprintf("Converting %s (%llu / %llu)\n", input.string().c_str(), ++startedCount, allInputs.size());
+
+        const auto conversionStart = std::chrono::steady_clock::now();
+        Fertilizer::ConversionResult result;
+        try {
+            result = Fertilizer::convert(input, output, forceConvert, cache.has_value() ? &cache.value() : nullptr, options);
+        } catch(const std::exception& e) {
+            // must not leave parallelFor early, other threads are still converting
+            result.errorCode = Fertilizer::ConversionResultError::UnsupportedInputType;
+            result.errorMessage = e.what();
+        }
+        conversionDurations[index] = duration_cast<std::chrono::duration<float>>((std::chrono::steady_clock::now() - conversionStart)).count();
+        conversionStatuses[index] = result.status;
+        switch(result.errorCode) {
+            case Fertilizer::ConversionResultError::Success:
+                switch(result.status) {
+                    case Fertilizer::ConversionStatus::Converted:
+                        convertedCount++;
+                        break;
+                    case Fertilizer::ConversionStatus::UpToDate:
+                        upToDateCount++;
+                        break;
+                    case Fertilizer::ConversionStatus::RestoredFromCache:
+                        restoredCount++;
                         break;
                 }
-            }
-        });
-    }
+                break;
 
-    for(auto& t : threads) {
-        t.join();
+            default:
+                errorCode = -1;
+                std::cerr << "[" << input << "] Conversion failed: " << result.errorMessage << std::endl;
+                break;
+        }
+    }, 1);
+
+    // summary: time spent on each converted asset, slowest first
+    std::vector<std::size_t> convertedAssets;
+    float totalConversionTime = 0.0f;
+    for(std::size_t index = 0; index < allInputs.size(); index++) {
+        totalConversionTime += conversionDurations[index];
+        if(conversionStatuses[index] == Fertilizer::ConversionStatus::Converted) {
+            convertedAssets.push_back(index);
+        }
+    }
+    std::sort(convertedAssets.begin(), convertedAssets.end(), [&](std::size_t a, std::size_t b) {
+        return conversionDurations[a] > conversionDurations[b];
+    });
+    if(!convertedAssets.empty()) {
+        std::cout << "Conversion times:\n";
+        for(const std::size_t index : convertedAssets) {
+            std::cout << Carrot::sprintf("  %8.3fs %s\n", conversionDurations[index], allInputs[index].string().c_str());
+        }
     }
 
+    std::cout << Carrot::sprintf("%llu converted, %llu up-to-date, %llu restored from cache\n", convertedCount.load(), upToDateCount.load(), restoredCount.load());
     float duration = duration_cast<std::chrono::duration<float>>((std::chrono::steady_clock::now() - start)).count();
+    std::cout << Carrot::sprintf("Sum of conversion times: %.3f seconds, on %llu threads\n", totalConversionTime, taskScheduler.getParallelThreadIDs().size() + 1 /* main thread */);
     std::cout << "Took " << duration << " seconds." << std::endl;
 
     return errorCode;
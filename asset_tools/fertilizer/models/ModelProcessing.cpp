@@ -6,9 +6,13 @@
 #include <core/utils/CarrotTinyGLTF.h>
 #include <core/utils/UserNotifications.h>
 #include <core/scene/LoadedScene.h>
+#include <core/scene/CookedModel.h>
+#include <core/render/VertexQuantization.h>
+#include <core/io/IO.h>
 #include <core/Macros.h>
 #include <core/scene/GLTFLoader.h>
 #include <models/GLTFWriter.h>
+#include <atomic>
 #include <unordered_set>
 #include <core/io/Logging.hpp>
 #include <glm/gtx/component_wise.hpp>
@@ -539,10 +543,28 @@ namespace Fertilizer {
         });
     }
 
-    static void processScene(LoadedScene& scene, const std::string& modelName, const Carrot::NotificationID& loadNotifID) {
-        for(std::size_t i = 0; i < scene.primitives.size(); i++) {
-            Carrot::UserNotifications::getInstance().setProgress(loadNotifID, float(i) / scene.primitives.size());
+    /// Replaces the vertices of the primitive by what writeAsCookedModel will store when quantizing them, so that
+    /// clusters and BLASes are built from the positions the engine will load
+    static void applyQuantization(LoadedPrimitive& primitive) {
+        namespace VQ = Carrot::VertexQuantization;
+        if(!primitive.vertices.empty()) {
+            const VQ::Bounds bounds = VQ::computeBounds(primitive.vertices);
+            for(Carrot::Vertex& vertex : primitive.vertices) {
+                vertex = VQ::decode(VQ::encode(vertex, bounds), bounds);
+            }
+        }
+        if(!primitive.skinnedVertices.empty()) {
+            const VQ::Bounds bounds = VQ::computeBounds(primitive.skinnedVertices);
+            for(Carrot::SkinnedVertex& vertex : primitive.skinnedVertices) {
+                vertex = VQ::decode(VQ::encode(vertex, bounds), bounds);
+            }
+        }
+    }
 
+    static void processScene(LoadedScene& scene, const std::string& modelName, const ConversionOptions& options, const Carrot::NotificationID& loadNotifID) {
+        // primitives are processed independently from each other
+        std::atomic<std::size_t> processedPrimitives { 0 };
+        parallelFor(scene.primitives.size(), [&](std::size_t i) {
             auto& primitive = scene.primitives[i];
             ExpandedMesh expandedMesh = expandMesh(primitive, loadNotifID);
 
@@ -565,12 +587,18 @@ namespace Fertilizer {
             cleanupTangents(expandedMesh, loadNotifID);
 
             collapseMesh(primitive, expandedMesh, loadNotifID);
+            if(options.quantizeVertices) {
+                // decoding the quantized vertices again gives the same values, so the cooked model stores exactly these
+                applyQuantization(primitive);
+            }
             if(!primitive.vertices.empty()) {
                 // TODO: support for skinned meshes
                 const float simplifyScale = meshopt_simplifyScale(&primitive.vertices[0].pos.x, primitive.vertices.size(), sizeof(Carrot::Vertex));
                 generateClusterHierarchy(primitive, simplifyScale);
             }
-        }
+
+            Carrot::UserNotifications::getInstance().setProgress(loadNotifID, float(++processedPrimitives) / scene.primitives.size());
+        }, 1);
 
         // iterate over nodes, for processes that require the transform of the mesh and/or to handle instances of the same mesh
         // also assigns the nodeKey used to link nodes to data inside the scene
@@ -592,25 +620,36 @@ namespace Fertilizer {
         iterateOverNodes(scene.nodeHierarchy->hierarchy, glm::mat4{ 1.0f });
     }
 
-    static void processGLTFModel(const std::string& modelName, tinygltf::Model& model) {
-        Carrot::NotificationID loadNotifID = Carrot::UserNotifications::getInstance().showNotification({.title = Carrot::sprintf("Processing %s", modelName.c_str())});
-        CLEANUP(Carrot::UserNotifications::getInstance().closeNotification(loadNotifID));
-
-        GLTFLoader loader{};
-        LoadedScene scene = loader.load(model, {});
-
-        processScene(scene, modelName, loadNotifID);
-
-        // re-export model
-        tinygltf::Model reexported = std::move(writeAsGLTF(modelName, scene));
-        // keep copyright+author info
-        model.asset.extras = std::move(model.asset.extras);
-        model.asset.copyright = std::move(model.asset.copyright);
+    /// Writes the processed scene as a cooked model, and as glTF next to it if the options ask for it
+    static ConversionResult writeModel(const LoadedScene& scene, const std::string& modelName, const fspath& outputFile, const ConversionOptions& options, const tinygltf::Asset* pSourceAsset) {
+        const std::vector<std::uint8_t> cookedModel = writeAsCookedModel(scene, CookedModelOptions {
+            .quantizeVertices = options.quantizeVertices,
+            .compress = options.compressModels,
+        });
+        Carrot::IO::writeFile(outputFile.string(), (void*)cookedModel.data(), cookedModel.size());
+
+        if(options.exportGLTF) {
+            tinygltf::TinyGLTF gltf;
+            tinygltf::Model reexported = std::move(writeAsGLTF(modelName, scene));
+            if(pSourceAsset) {
+                // keep copyright+author info
+                reexported.asset.extras = pSourceAsset->extras;
+                reexported.asset.copyright = pSourceAsset->copyright;
+            }
+            if(!gltf.WriteGltfSceneToFile(&reexported, getExportedGLTFPath(outputFile).string(), false, false, true/* pretty-print */, false)) {
+                return {
+                    .errorCode = ConversionResultError::ModelCompressionError,
+                    .errorMessage = "Could not write GLTF",
+                };
+            }
+        }
 
-        model = std::move(reexported);
+        return {
+            .errorCode = ConversionResultError::Success,
+        };
     }
 
-    ConversionResult processAssimp(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile) {
+    ConversionResult processAssimp(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options) {
         AssimpLoader loader;
         Assimp::Importer importer;
         LoadedScene scene = std::move(loader.load(inputFile.string(), importer));
@@ -619,25 +658,14 @@ namespace Fertilizer {
         {
             Carrot::NotificationID loadNotifID = Carrot::UserNotifications::getInstance().showNotification({.title = Carrot::sprintf("Processing %s", modelName.c_str())});
             CLEANUP(Carrot::UserNotifications::getInstance().closeNotification(loadNotifID));
-            processScene(scene, modelName, loadNotifID);
-        }
-
-        tinygltf::TinyGLTF gltf;
-        tinygltf::Model reexported = std::move(writeAsGLTF(modelName, scene));
-        if(!gltf.WriteGltfSceneToFile(&reexported, outputFile.string(), false, false, true/* pretty-print */, false)) {
-            return {
-                .errorCode = ConversionResultError::ModelCompressionError,
-                .errorMessage = "Could not write GLTF",
-            };
+            processScene(scene, modelName, options, loadNotifID);
         }
 
-        return {
-            .errorCode = ConversionResultError::Success,
-        };
+        return writeModel(scene, modelName, outputFile, options, nullptr);
     }
 
 
-    ConversionResult processGLTF(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile) {
+    ConversionResult processGLTF(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options) {
         using namespace tinygltf;
 
         tinygltf::TinyGLTF parser;
@@ -675,20 +703,22 @@ namespace Fertilizer {
 
         // ----------
 
-        // buffers are regenerated inside 'processModel' method too, so we don't copy the .bin file
-        processGLTFModel(Carrot::toString(outputFile.stem().u8string()), model);
+        const std::string modelName = Carrot::toString(outputFile.stem().u8string());
+        Carrot::NotificationID loadNotifID = Carrot::UserNotifications::getInstance().showNotification({.title = Carrot::sprintf("Processing %s", modelName.c_str())});
+        CLEANUP(Carrot::UserNotifications::getInstance().closeNotification(loadNotifID));
+
+        GLTFLoader loader{};
+        LoadedScene scene = loader.load(model, {});
+        processScene(scene, modelName, options, loadNotifID);
 
         // ----------
 
-        if(!parser.WriteGltfSceneToFile(&model, outputFile.string(), false, false, true/* pretty-print */, false)) {
-            return {
-                .errorCode = ConversionResultError::ModelCompressionError,
-                .errorMessage = "Could not write GLTF",
-            };
-        }
+        // buffers are regenerated from the scene, so the .bin files are not copied
+        return writeModel(scene, modelName, outputFile, options, &model.asset);
+    }
 
-        return {
-            .errorCode = ConversionResultError::Success,
-        };
+    std::filesystem::path getExportedGLTFPath(const std::filesystem::path& outputFile) {
+        fspath gltfPath = outputFile;
+        return gltfPath.replace_extension(".gltf");
     }
 }
@@ -8,6 +8,9 @@
 #include <Fertilizer.h>
 
 namespace Fertilizer {
-    ConversionResult processGLTF(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
-    ConversionResult processAssimp(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile);
+    ConversionResult processGLTF(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options);
+    ConversionResult processAssimp(const std::filesystem::path& inputFile, const std::filesystem::path& outputFile, const ConversionOptions& options);
+
+    /// Where the glTF version of a cooked model is written, when ConversionOptions::exportGLTF is set
+    std::filesystem::path getExportedGLTFPath(const std::filesystem::path& outputFile);
 }
@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <optional>
-#include <list>
+#include <utility>
+#include <vector>
 #include <cider/Mutex.h>
 
 #include "core/Macros.h"
@@ -15,40 +20,208 @@
 
 namespace Carrot::Async {
     /// Specialized data structure that allows concurrent access to its values, via getOrCompute.
-    ///  Access to different keys can be done in multiple threads, with minimal blocking.
+    ///  Reading a key which already has a value never blocks, nor writes to memory shared with other keys.
+    ///  Access to different keys can be done in multiple threads, with minimal blocking: keys are spread over shards,
+    ///  and only inserting a new key locks its shard, for a short time.
     ///  Access to the same key can be done in multiple threads, but will block if generation started
-    ///  Once created, values are never moved. Erase a value via its key and then re-set a value
+    ///  Values are never modified once published: replace and remove publish a new value (or none), and the previous one is
+    ///  destroyed once no thread which could have seen it is still inside the map (epoch-based reclamation). Use read()
+    ///  to access a value which may be replaced or removed concurrently: references returned by find and getOrCompute
+    ///  are only guaranteed to stay valid until their key is replaced or removed.
+    ///  Nodes of keys without value are reclaimed the same way when their shard rebuilds its table.
     /// KeyType: must be hashable
     /// ValueType: must meet std::is_move_constructible_v
     template<typename KeyType, typename ValueType> requires Concepts::IsMoveable<ValueType> && Concepts::Hashable<KeyType>
     class ParallelMap {
-        using Hash = std::size_t;
+        using Hash = std::uint64_t;
 
+        static constexpr std::size_t ShardBits = 5;
+        static constexpr std::size_t ShardCount = 1 << ShardBits;
+        static constexpr std::size_t InitialTableCapacity = 16;
+
+        /// Readers can still be looking at a node after it was unlinked from its shard: nodes are retired, not deleted
         struct Node {
-            Cider::Mutex nodeAccess;
+            Node(const KeyType& key, Hash hash, Node* pNextInShard): key(key), hash(hash), pNextInShard(pNextInShard) {}
+
+            ~Node() {
+                delete pValue.load(std::memory_order_relaxed);
+            }
+
+            const KeyType key;
+            const Hash hash;
+            std::atomic<Node*> pNextInShard; //< older node of the same shard, used for iteration
+
+            Cider::Mutex nodeAccess; //< held while the value is computed or replaced
+            std::atomic<ValueType*> pValue = nullptr; //< published values are never modified, only replaced (see retire)
+
+            /// Number of threads about to give a value to this node, or -1 once the node is retired. Nodes are only
+            /// retired when they have no value and no writer
+            std::atomic<std::int32_t> writers = 0;
+        };
+
+        /// Open-addressing hash table, filled to at most half of its capacity.
+        /// Once replaced by a new table, a table is never modified again and is retired, because readers may still be looking inside it
+        struct Table {
+            explicit Table(std::size_t capacity): mask(capacity - 1), slots(std::make_unique<std::atomic<Node*>[]>(capacity)) {}
+
+            std::size_t getCapacity() const {
+                return mask + 1;
+            }
 
-            std::optional<ValueType> value;
+            const std::size_t mask;
+            std::unique_ptr<std::atomic<Node*>[]> slots;
+        };
+
+        struct alignas(64) Shard {
+            Async::SpinLock insertionLock; //< held while inserting a new key
+
+            std::atomic<Table*> pTable { nullptr };
+            std::atomic<Node*> pNewestNode { nullptr }; //< head of the list of all nodes of this shard
+
+            std::size_t nodeCount = 0;
+        };
+
+        /// Memory which readers may still be using, destroyed once the global epoch is 2 steps after 'epoch'
+        struct Retired {
+            void* pointer = nullptr;
+            void (*deleter)(void*) = nullptr;
+            std::uint64_t epoch = 0;
+        };
+
+        /// Keeps the thread inside the current epoch: memory retired after this point is not destroyed until the guard is released
+        class EpochGuard {
+        public:
+            EpochGuard() = default;
+
+            explicit EpochGuard(const ParallelMap& map): pMap(&map) {
+                parity = map.enterEpoch();
+            }
+
+            EpochGuard(const EpochGuard& other): pMap(other.pMap) {
+                if(pMap != nullptr) {
+                    parity = pMap->enterEpoch();
+                }
+            }
+
+            EpochGuard(EpochGuard&& other) noexcept: pMap(std::exchange(other.pMap, nullptr)), parity(other.parity) {}
+
+            EpochGuard& operator=(EpochGuard other) noexcept {
+                std::swap(pMap, other.pMap);
+                std::swap(parity, other.parity);
+                return *this;
+            }
+
+            ~EpochGuard() {
+                if(pMap != nullptr) {
+                    pMap->activeReaders[parity].fetch_sub(1);
+                }
+            }
+
+        private:
+            const ParallelMap* pMap = nullptr;
+            std::size_t parity = 0;
         };
 
         template<bool isConst>
         class Snapshot {
         public:
-            using ElementType = std::pair<KeyType, std::conditional_t<isConst, const ValueType*, ValueType*>>;
+            using ValuePointer = std::conditional_t<isConst, const ValueType*, ValueType*>;
+            using ElementType = std::pair<const KeyType&, ValuePointer>;
+
+            class Iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = ElementType;
+                using difference_type = std::ptrdiff_t;
+                using pointer = ElementType*;
+                using reference = ElementType&;
+
+                Iterator(const Snapshot* pSnapshot, std::size_t shardIndex, Node* pNode): pSnapshot(pSnapshot), shardIndex(shardIndex), pNode(pNode) {
+                    skipNodesWithoutValue();
+                }
 
-            auto begin() {
-                return keyValuePairs.begin();
+                Iterator(const Iterator& other): Iterator(other.pSnapshot, other.shardIndex, other.pNode) {}
+
+                Iterator& operator=(const Iterator& other) {
+                    pSnapshot = other.pSnapshot;
+                    shardIndex = other.shardIndex;
+                    pNode = other.pNode;
+                    skipNodesWithoutValue();
+                    return *this;
+                }
+
+                ElementType& operator*() {
+                    return *current;
+                }
+
+                ElementType* operator->() {
+                    return &current.value();
+                }
+
+                Iterator& operator++() {
+                    pNode = pNode->pNextInShard.load(std::memory_order_acquire);
+                    skipNodesWithoutValue();
+                    return *this;
+                }
+
+                bool operator==(const Iterator& other) const {
+                    return pNode == other.pNode;
+                }
+
+            private:
+                /// Moves to the next node which has a value, possibly in the next shards
+                void skipNodesWithoutValue() {
+                    while(true) {
+                        while(pNode != nullptr) {
+                            if(ValueType* pValue = pNode->pValue.load(std::memory_order_acquire)) {
+                                current.emplace(pNode->key, pValue);
+                                return;
+                            }
+                            pNode = pNode->pNextInShard.load(std::memory_order_acquire);
+                        }
+                        if(pSnapshot == nullptr || shardIndex + 1 >= ShardCount) {
+                            current.reset();
+                            return;
+                        }
+                        shardIndex++;
+                        pNode = pSnapshot->newestNodes[shardIndex];
+                    }
+                }
+
+                const Snapshot* pSnapshot = nullptr;
+                std::size_t shardIndex = 0;
+                Node* pNode = nullptr;
+                std::optional<ElementType> current;
+            };
+
+            Iterator begin() const {
+                return Iterator { this, 0, newestNodes[0] };
             }
 
-            auto end() {
-                return keyValuePairs.end();
+            Iterator end() const {
+                return Iterator { nullptr, ShardCount, nullptr };
             }
 
+            /// Counts the elements of this snapshot which still have a value. Linear in the number of keys
             std::size_t size() const {
-                return keyValuePairs.size();
+                std::size_t count = 0;
+                for(Node* pNode : newestNodes) {
+                    for(; pNode != nullptr; pNode = pNode->pNextInShard.load(std::memory_order_acquire)) {
+                        if(pNode->pValue.load(std::memory_order_acquire) != nullptr) {
+                            count++;
+                        }
+                    }
+                }
+                return count;
             }
 
         private:
-            std::vector<ElementType> keyValuePairs;
+            /// Newest node of each shard when the snapshot was taken. New nodes are only ever prepended to the lists, so this
+            /// fixes the set of keys visible by this snapshot
+            std::array<Node*, ShardCount> newestNodes {};
+
+            /// Nodes and values seen by this snapshot are not destroyed while it is alive
+            EpochGuard guard;
             friend class ParallelMap<KeyType, ValueType>;
         };
 
@@ -59,212 +232,373 @@ namespace Carrot::Async {
         /// Creates an empty map
         ParallelMap() = default;
 
+        ParallelMap(const ParallelMap&) = delete;
+        ParallelMap& operator=(const ParallelMap&) = delete;
+
+        ~ParallelMap() {
+            for(Shard& shard : shards) {
+                Node* pNode = shard.pNewestNode.load(std::memory_order_relaxed);
+                while(pNode != nullptr) {
+                    Node* pNext = pNode->pNextInShard.load(std::memory_order_relaxed);
+                    delete pNode;
+                    pNode = pNext;
+                }
+                delete shard.pTable.load(std::memory_order_relaxed);
+            }
+            for(const Retired& retired : retiredList) {
+                retired.deleter(retired.pointer);
+            }
+        }
+
         /// Gets the value corresponding to the given key. If no such value exists, the value is created via generator.
         ValueType& getOrCompute(const KeyType& key, std::function<ValueType()> generator) {
-            Node* existingNode = nullptr;
-            {
-                Async::LockGuard l { storageAccess.read() };
-                auto iter = storage.find(key);
-                if(iter != storage.end()) {
-                    auto& node = iter->second;
-                    if(node.value.has_value()) {
-                        return node.value.value();
-                    } else {
-                        existingNode = &node;
-                    }
-                }
+            EpochGuard guard { *this };
+            Node& node = findOrInsertNode(key);
+            if(ValueType* pValue = node.pValue.load(std::memory_order_acquire)) {
+                return *pValue;
             }
 
-            // Value does not exist
-            {
-                auto& writeLock = storageAccess.write();
-                writeLock.lock();
+            return writeToNode(key, node, [&](Node& writtenNode) -> ValueType& {
+                Cider::BlockingMutexGuard l { writtenNode.nodeAccess };
+                return computeIfNeeded(writtenNode, generator);
+            });
+        }
 
-                // node might have been created by another thread
-                if(!existingNode) {
-                    auto iter = storage.find(key);
-                    if(iter != storage.end()) {
-                        existingNode = &iter->second;
-                    }
-                }
+        /// Gets the value corresponding to the given key. If no such value exists, the value is created via generator.
+        ValueType& getOrCompute(Cider::FiberHandle& fiberHandle, const KeyType& key, std::function<ValueType()> generator) {
+            EpochGuard guard { *this };
+            Node& node = findOrInsertNode(key);
+            if(ValueType* pValue = node.pValue.load(std::memory_order_acquire)) {
+                return *pValue;
+            }
 
-                // insert empty node
-                if(!existingNode) {
-                    existingNode = &storage[key];
-                    existingNode->value = {};
-                }
+            return writeToNode(key, node, [&](Node& writtenNode) -> ValueType& {
+                Cider::LockGuard l { fiberHandle, writtenNode.nodeAccess };
+                return computeIfNeeded(writtenNode, generator);
+            });
+        }
 
-                writeLock.unlock();
-                Cider::BlockingMutexGuard l { existingNode->nodeAccess };
+        /// Sets the value corresponding to the given key. If no such value exists, the node is created.
+        /// The previous value is destroyed once no reader can access it anymore.
+        void replace(const KeyType& key, ValueType&& newValue) {
+            EpochGuard guard { *this };
+            Node& node = findOrInsertNode(key);
+            writeToNode(key, node, [&](Node& writtenNode) {
+                Cider::BlockingMutexGuard l { writtenNode.nodeAccess };
+                retire(writtenNode.pValue.exchange(new ValueType(std::move(newValue)), std::memory_order_acq_rel));
+                return 0;
+            });
+        }
 
-                if(existingNode->value.has_value()) {
-                    return existingNode->value.value();
-                }
+        /// Removes the value corresponding to the given key. If no such value exists, returns false. Returns true otherwise.
+        /// The value is destroyed once no reader can access it anymore.
+        bool remove(const KeyType& key) {
+            EpochGuard guard { *this };
+            Node* pNode = findNode(key, hashKey(key));
+            if(pNode == nullptr) {
+                return false;
+            }
+
+            Cider::BlockingMutexGuard l { pNode->nodeAccess };
+            ValueType* pRemoved = pNode->pValue.exchange(nullptr, std::memory_order_acq_rel);
+            retire(pRemoved);
+            return pRemoved != nullptr;
+        }
+
+        ValueType* find(const KeyType& key) {
+            EpochGuard guard { *this };
+            Node* pNode = findNode(key, hashKey(key));
+            if(pNode == nullptr) {
+                return nullptr;
+            }
+            return pNode->pValue.load(std::memory_order_acquire);
+        }
 
-                existingNode->value = std::move(generator());
+        const ValueType* find(const KeyType& key) const {
+            EpochGuard guard { *this };
+            Node* pNode = findNode(key, hashKey(key));
+            if(pNode == nullptr) {
+                return nullptr;
+            }
+            return pNode->pValue.load(std::memory_order_acquire);
+        }
 
-                return existingNode->value.value();
+        /// Calls 'reader' with the value of the given key, if there is one. The value stays valid during the call, even if
+        /// another thread replaces or removes it concurrently. Returns true if there was a value.
+        template<typename Reader>
+        bool read(const KeyType& key, Reader&& reader) const {
+            EpochGuard guard { *this };
+            Node* pNode = findNode(key, hashKey(key));
+            if(pNode == nullptr) {
+                return false;
             }
+            const ValueType* pValue = pNode->pValue.load(std::memory_order_acquire);
+            if(pValue == nullptr) {
+                return false;
+            }
+            reader(*pValue);
+            return true;
         }
 
-        /// Sets the value corresponding to the given key. If no such value exists, the node is created.
-        void replace(const KeyType& key, ValueType&& newValue) {
-            {
-                Async::LockGuard l { storageAccess.read() };
-                auto iter = storage.find(key);
-                if(iter != storage.end()) {
-                    auto& node = iter->second;
-                    Cider::BlockingMutexGuard l2 { node.nodeAccess };
-                    node.value = std::move(newValue);
-                    return;
+        /// Provides a view of the keys present when this method is called, without copying them. Can be used to iterate over this structure.
+        /// Values removed after the snapshot is taken are skipped during iteration, keys added after are not visible.
+        /// Values seen by the snapshot are not destroyed while it is alive, so snapshots should not be kept for long.
+        NonConstSnapshot snapshot() {
+            NonConstSnapshot result;
+            result.guard = EpochGuard { *this };
+            fillSnapshot(result.newestNodes);
+            return result;
+        }
+
+        /// Provides a view of the keys present when this method is called, without copying them. Can be used to iterate over this structure.
+        /// Values removed after the snapshot is taken are skipped during iteration, keys added after are not visible.
+        /// Values seen by the snapshot are not destroyed while it is alive, so snapshots should not be kept for long.
+        ConstSnapshot snapshot() const {
+            ConstSnapshot result;
+            result.guard = EpochGuard { *this };
+            fillSnapshot(result.newestNodes);
+            return result;
+        }
+
+        /// Removes all values. Nodes are reclaimed when their shard next rebuilds its table
+        void clear() {
+            EpochGuard guard { *this };
+            for(Shard& shard : shards) {
+                for(Node* pNode = shard.pNewestNode.load(std::memory_order_acquire); pNode != nullptr; pNode = pNode->pNextInShard.load(std::memory_order_acquire)) {
+                    Cider::BlockingMutexGuard g { pNode->nodeAccess };
+                    retire(pNode->pValue.exchange(nullptr, std::memory_order_acq_rel));
                 }
             }
+        }
 
-            Node* existingNode = nullptr;
-            auto& writeLock = storageAccess.write();
-            writeLock.lock();
+    private:
+        /// Spreads the bits of std::hash, which is the identity for integers and pointers on most implementations
+        static Hash hashKey(const KeyType& key) {
+            Hash h = static_cast<Hash>(std::hash<KeyType>{}(key));
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111ebull;
+            h ^= h >> 31;
+            return h;
+        }
 
-            // node might have been created by another thread
-            auto iter = storage.find(key);
-            if(iter != storage.end()) {
-                existingNode = &iter->second;
-            }
+        Shard& getShard(Hash hash) {
+            return shards[hash >> (64 - ShardBits)];
+        }
 
-            // insert empty node
-            if(!existingNode) {
-                existingNode = &storage[key];
-                existingNode->value = {};
-            }
+        const Shard& getShard(Hash hash) const {
+            return shards[hash >> (64 - ShardBits)];
+        }
 
-            writeLock.unlock();
-            Cider::BlockingMutexGuard l { existingNode->nodeAccess };
+        /// Never blocks. Must be called inside an epoch (see EpochGuard)
+        Node* findNode(const KeyType& key, Hash hash) const {
+            const Table* pTable = getShard(hash).pTable.load(std::memory_order_acquire);
+            if(pTable == nullptr) {
+                return nullptr;
+            }
 
-            existingNode->value = std::move(newValue);
+            // tables are never full, so there is always an empty slot to stop at
+            for(std::size_t slot = hash & pTable->mask; ; slot = (slot + 1) & pTable->mask) {
+                Node* pNode = pTable->slots[slot].load(std::memory_order_acquire);
+                if(pNode == nullptr) {
+                    return nullptr;
+                }
+                if(pNode->hash == hash && pNode->key == key) {
+                    return pNode;
+                }
+            }
         }
 
-        /// Gets the value corresponding to the given key. If no such value exists, the value is created via generator.
-        ValueType& getOrCompute(Cider::FiberHandle& fiberHandle, const KeyType& key, std::function<ValueType()> generator) {
-            Node* existingNode = nullptr;
-            {
-                Async::LockGuard l { storageAccess.read() };
-                auto iter = storage.find(key);
-                if(iter != storage.end()) {
-                    auto& node = iter->second;
-                    if(node.value.has_value()) {
-                        return node.value.value();
-                    } else {
-                        existingNode = &node;
-                    }
+        /// Must be called inside an epoch (see EpochGuard). If 'lockFirst' is true, skips the lookup without lock
+        Node& findOrInsertNode(const KeyType& key, bool lockFirst = false) {
+            const Hash hash = hashKey(key);
+            if(!lockFirst) {
+                if(Node* pExisting = findNode(key, hash)) {
+                    return *pExisting;
                 }
             }
 
-            // Value does not exist
-            {
-                auto& writeLock = storageAccess.write();
-                writeLock.lock();
+            Shard& shard = getShard(hash);
+            Async::LockGuard g { shard.insertionLock };
 
-                // node might have been created by another thread
-                if(!existingNode) {
-                    auto iter = storage.find(key);
-                    if(iter != storage.end()) {
-                        existingNode = &iter->second;
-                    }
-                }
+            // node might have been created by another thread
+            if(Node* pExisting = findNode(key, hash)) {
+                return *pExisting;
+            }
+
+            Table* pTable = shard.pTable.load(std::memory_order_relaxed);
+            if(pTable == nullptr || (shard.nodeCount + 1) * 2 > pTable->getCapacity()) {
+                pTable = rebuildTable(shard);
+            }
 
-                // insert empty node
-                if(!existingNode) {
-                    existingNode = &storage[key];
-                    existingNode->value = {};
+            Node* pNode = new Node(key, hash, shard.pNewestNode.load(std::memory_order_relaxed));
+            insertInto(*pTable, pNode);
+            shard.pNewestNode.store(pNode, std::memory_order_release);
+            shard.nodeCount++;
+            return *pNode;
+        }
+
+        /// Calls 'write' on the node of the key, once it is registered as a writer of the node (so that the node cannot be retired
+        /// in the meantime). Must be called inside an epoch (see EpochGuard)
+        template<typename Write>
+        decltype(auto) writeToNode(const KeyType& key, Node& firstNode, Write&& write) {
+            Node* pNode = &firstNode;
+            while(true) {
+                std::int32_t writerCount = pNode->writers.load(std::memory_order_acquire);
+                while(writerCount >= 0 && !pNode->writers.compare_exchange_weak(writerCount, writerCount + 1, std::memory_order_acq_rel)) {}
+                if(writerCount >= 0) {
+                    break;
                 }
+                // retired while its shard rebuilt its table: wait for the rebuild to finish, and insert the key again
+                pNode = &findOrInsertNode(key, true);
+            }
 
-                writeLock.unlock();
-                Cider::LockGuard l { fiberHandle, existingNode->nodeAccess };
+            struct WriterRelease {
+                Node& node;
+                ~WriterRelease() {
+                    node.writers.fetch_sub(1, std::memory_order_release);
+                }
+            } release { *pNode };
+            return write(*pNode);
+        }
 
-                if(existingNode->value.has_value()) {
-                    return existingNode->value.value();
+        /// Replaces the table of the shard by a new one, large enough for the nodes which still have a value (or a writer).
+        /// The other nodes are removed from the shard and retired. Must be called with the insertion lock of the shard held
+        Table* rebuildTable(Shard& shard) {
+            Table* pOldTable = shard.pTable.load(std::memory_order_relaxed);
+
+            // unlink nodes without value, the list is only modified by threads holding the insertion lock
+            std::vector<Node*> keptNodes;
+            std::vector<Node*> retiredNodes;
+            keptNodes.reserve(shard.nodeCount);
+            std::atomic<Node*>* pLink = &shard.pNewestNode;
+            for(Node* pNode = pLink->load(std::memory_order_relaxed); pNode != nullptr; ) {
+                Node* pNext = pNode->pNextInShard.load(std::memory_order_relaxed);
+                if(tryRetireNode(*pNode)) {
+                    // readers currently on this node can still follow its 'next' pointer
+                    pLink->store(pNext, std::memory_order_release);
+                    retiredNodes.push_back(pNode);
+                } else {
+                    keptNodes.push_back(pNode);
+                    pLink = &pNode->pNextInShard;
                 }
+                pNode = pNext;
+            }
+            shard.nodeCount = keptNodes.size();
 
-                existingNode->value = std::move(generator());
+            std::size_t newCapacity = InitialTableCapacity;
+            while((shard.nodeCount + 1) * 2 > newCapacity) {
+                newCapacity *= 2;
+            }
+            Table* pNewTable = new Table(newCapacity);
+            for(Node* pNode : keptNodes) {
+                insertInto(*pNewTable, pNode);
+            }
+            shard.pTable.store(pNewTable, std::memory_order_release);
 
-                return existingNode->value.value();
+            // only now are the old table and the removed nodes unreachable by new readers
+            if(pOldTable != nullptr) {
+                retire(pOldTable);
             }
+            for(Node* pNode : retiredNodes) {
+                retire(pNode);
+            }
+            return pNewTable;
         }
 
-        /// Removes the value corresponding to the given key. If no such value exists, returns false. Returns true otherwise.
-        bool remove(const KeyType& key) {
-            Async::LockGuard l { storageAccess.write() };
-            auto iter = storage.find(key);
-            if(iter != storage.end()) {
-                auto& node = iter->second;
-                Cider::BlockingMutexGuard l1 { node.nodeAccess };
-                bool result = node.value.has_value();
-                node.value.reset();
-                return result;
-            }
-            return false;
+        /// Marks the node as retired if it has no value and nobody is about to give it one
+        static bool tryRetireNode(Node& node) {
+            std::int32_t noWriter = 0;
+            if(!node.writers.compare_exchange_strong(noWriter, -1, std::memory_order_acq_rel)) {
+                return false;
+            }
+            // no writer can start once the node is retired, so its value cannot change anymore
+            if(node.pValue.load(std::memory_order_acquire) != nullptr) {
+                node.writers.store(0, std::memory_order_release);
+                return false;
+            }
+            return true;
         }
 
-        ValueType* find(const KeyType& key) {
-            Async::LockGuard l{storageAccess.read()};
-            auto iter = storage.find(key);
-            if(iter == storage.end()) {
-                return nullptr;
+        static void insertInto(Table& table, Node* pNode) {
+            std::size_t slot = pNode->hash & table.mask;
+            while(table.slots[slot].load(std::memory_order_relaxed) != nullptr) {
+                slot = (slot + 1) & table.mask;
             }
-            return &iter->second.value.value();
+            table.slots[slot].store(pNode, std::memory_order_release);
         }
 
-        const ValueType* find(const KeyType& key) const {
-            Async::LockGuard l { storageAccess.read() };
-            auto iter = storage.find(key);
-            if(iter == storage.end()) {
-                return nullptr;
+        /// Must be called with nodeAccess held
+        static ValueType& computeIfNeeded(Node& node, const std::function<ValueType()>& generator) {
+            ValueType* pValue = node.pValue.load(std::memory_order_relaxed);
+            if(pValue == nullptr) {
+                pValue = new ValueType(generator());
+                node.pValue.store(pValue, std::memory_order_release);
             }
-            return &iter->second.value.value();
+            return *pValue;
         }
 
-        /// Provides a copy of this map's contents. Can be used to iterate over this structure
-        NonConstSnapshot snapshot() {
-            Async::LockGuard l { storageAccess.read() };
-
-            NonConstSnapshot result;
-            result.keyValuePairs.reserve(storage.size());
-            for(auto& [key, node] : storage) {
-                if(node.value.has_value()) {
-                    result.keyValuePairs.emplace_back(key, &node.value.value());
-                }
+        void fillSnapshot(std::array<Node*, ShardCount>& newestNodes) const {
+            for(std::size_t i = 0; i < ShardCount; i++) {
+                newestNodes[i] = shards[i].pNewestNode.load(std::memory_order_acquire);
             }
-            result.keyValuePairs.shrink_to_fit();
-
-            return result;
         }
 
-        /// Provides a copy of this map's contents. Can be used to iterate over this structure
-        ConstSnapshot snapshot() const {
-            Async::LockGuard l { storageAccess.read() };
-
-            ConstSnapshot result;
-            result.keyValuePairs.reserve(storage.size());
-            for(auto& [key, node] : storage) {
-                if(node.value.has_value()) {
-                    result.keyValuePairs.emplace_back(key, &node.value.value());
+        /// Enters the current epoch, returns the index of the reader counter to decrement when leaving it
+        std::size_t enterEpoch() const {
+            while(true) {
+                const std::uint64_t epoch = globalEpoch.load();
+                const std::size_t parity = epoch & 1;
+                activeReaders[parity].fetch_add(1);
+                // if the epoch moved in-between, the counter of the new epoch must be used
+                if(globalEpoch.load() == epoch) {
+                    return parity;
                 }
+                activeReaders[parity].fetch_sub(1);
             }
-            result.keyValuePairs.shrink_to_fit();
+        }
 
-            return result;
+        template<typename T>
+        void retire(T* pointer) {
+            if(pointer == nullptr) {
+                return;
+            }
+            Async::LockGuard g { retiredLock };
+            retiredList.push_back(Retired {
+                .pointer = pointer,
+                .deleter = [](void* p) { delete static_cast<T*>(p); },
+                .epoch = globalEpoch.load(),
+            });
+            reclaim();
         }
 
-        void clear() {
-            Async::LockGuard g { storageAccess.write() };
-            for(auto& [key, node] : storage) {
-                Cider::BlockingMutexGuard g2 { node.nodeAccess };
-                node.value.reset();
+        /// Advances the global epoch if all readers of the previous one left, and destroys what nobody can access anymore.
+        /// Must be called with retiredLock held
+        void reclaim() {
+            // readers of epoch N-1 and N use different counters: once the readers of N-1 are gone, the epoch can move to N+1
+            std::uint64_t epoch = globalEpoch.load();
+            if(activeReaders[(epoch + 1) & 1].load() == 0) {
+                globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+                epoch = globalEpoch.load();
+            }
+
+            // memory retired during epoch N was reachable by readers of N-1 and N, which all left once the epoch reached N+2.
+            // The epoch only advances here, so the list is sorted by epoch
+            std::size_t reclaimedCount = 0;
+            while(reclaimedCount < retiredList.size() && retiredList[reclaimedCount].epoch + 2 <= epoch) {
+                retiredList[reclaimedCount].deleter(retiredList[reclaimedCount].pointer);
+                reclaimedCount++;
             }
-            storage.clear();
+            retiredList.erase(retiredList.begin(), retiredList.begin() + reclaimedCount);
         }
 
     private:
-        mutable Async::ReadWriteLock storageAccess{};
-        std::unordered_map<KeyType, Node> storage{};
+        std::array<Shard, ShardCount> shards;
+
+        mutable std::atomic<std::uint64_t> globalEpoch { 0 };
+        mutable std::array<std::atomic<std::uint32_t>, 2> activeReaders {}; //< threads inside an even/odd epoch
+        Async::SpinLock retiredLock; //< protects retiredList
+        std::vector<Retired> retiredList;
     };
-}
\ No newline at end of file
+}
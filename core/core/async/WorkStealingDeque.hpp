@@ -0,0 +1,130 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include <core/Macros.h>
+
+namespace Carrot::Async {
+    /// Chase-Lev work-stealing deque (see "Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013).
+    /// A single thread owns the deque: it is the only one allowed to push and pop, at the bottom (LIFO).
+    /// Any other thread can steal from the top (FIFO), without locks.
+    /// The storage grows when full, and is never shrunk. Old buffers are kept alive until the deque is destroyed, because
+    /// thieves may still be reading from them.
+    /// T: must be trivially copyable (typically a pointer)
+    template<typename T> requires std::is_trivially_copyable_v<T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(std::size_t initialCapacity = 256) {
+            verify(initialCapacity > 0 && (initialCapacity & (initialCapacity - 1)) == 0, "Capacity must be a power of 2");
+            buffers.emplace_back(std::make_unique<Buffer>(initialCapacity));
+            buffer.store(buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /// Adds an element at the bottom of the deque. Only the owner thread is allowed to call this method
+        void push(T item) {
+            const std::int64_t b = bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = top.load(std::memory_order_acquire);
+            Buffer* pBuffer = buffer.load(std::memory_order_relaxed);
+            if(b - t > static_cast<std::int64_t>(pBuffer->capacity) - 1) {
+                pBuffer = grow(pBuffer, b, t);
+            }
+            pBuffer->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /// Removes the element at the bottom of the deque (last pushed). Only the owner thread is allowed to call this method
+        std::optional<T> pop() {
+            const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* pBuffer = buffer.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = top.load(std::memory_order_relaxed);
+
+            if(t > b) {
+                // empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return {};
+            }
+
+            std::optional<T> result = pBuffer->get(b);
+            if(t == b) {
+                // last element: race against thieves
+                if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    result.reset();
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        /// Removes the element at the top of the deque (first pushed). Can be called from any thread.
+        /// Returns an empty optional if the deque is empty, or if another thread stole the element at the same time
+        std::optional<T> steal() {
+            std::int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t b = bottom.load(std::memory_order_acquire);
+            if(t >= b) {
+                return {};
+            }
+
+            Buffer* pBuffer = buffer.load(std::memory_order_acquire);
+            T item = pBuffer->get(t);
+            if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return {};
+            }
+            return item;
+        }
+
+        /// Approximation of the element count, only meant for statistics and heuristics
+        std::size_t getSizeApprox() const {
+            const std::int64_t b = bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<std::size_t>(b - t) : 0;
+        }
+
+    private:
+        struct Buffer {
+            explicit Buffer(std::size_t capacity): capacity(capacity), mask(capacity - 1), items(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+            T get(std::int64_t index) const {
+                return items[static_cast<std::size_t>(index) & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(std::int64_t index, T item) {
+                items[static_cast<std::size_t>(index) & mask].store(item, std::memory_order_relaxed);
+            }
+
+            std::size_t capacity;
+            std::size_t mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+        };
+
+        Buffer* grow(Buffer* pOld, std::int64_t b, std::int64_t t) {
+            Buffer* pNew = buffers.emplace_back(std::make_unique<Buffer>(pOld->capacity * 2)).get();
+            for(std::int64_t i = t; i < b; i++) {
+                pNew->put(i, pOld->get(i));
+            }
+            buffer.store(pNew, std::memory_order_release);
+            return pNew;
+        }
+
+    private:
+        // on separate cache lines: 'top' is written by thieves, 'bottom' by the owner
+        alignas(64) std::atomic<std::int64_t> top { 0 };
+        alignas(64) std::atomic<std::int64_t> bottom { 0 };
+        alignas(64) std::atomic<Buffer*> buffer { nullptr };
+        std::vector<std::unique_ptr<Buffer>> buffers; //< only touched by the owner thread
+    };
+}
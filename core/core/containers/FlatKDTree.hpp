@@ -0,0 +1,172 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <core/Allocator.h>
+#include <core/containers/KDTree.hpp>
+#include <core/containers/Vector.hpp>
+
+namespace Carrot {
+    /**
+     * \brief K-d tree with the same purpose as KDTree, but stored as a few contiguous arrays instead of one allocation per element.
+     *
+     * The tree is an implicit complete binary tree in breadth-first order: node i has children 2i+1 and 2i+2, internal
+     * nodes only store their split plane. Elements are stored in leaf buckets of BucketSize positions (structure of arrays,
+     * padded with positions at infinity), so distance tests are done over whole buckets in fixed-size loops that the
+     * compiler vectorizes.
+     * Building is done by median splits, in parallel via Carrot::Async::parallelFor when it is bound to a scheduler.
+     *
+     * Elements are expected to outlive this tree! All methods return indices to the input elements.
+     * Unlike KDTree, closestNeighbor is exact.
+     * \tparam TElement Element type to store inside this tree. Must match concept 'HasSpatialInfo'
+     */
+    template<typename TElement>
+    requires HasSpatialInfo<TElement>
+    class FlatKDTree {
+    public:
+        /// How many elements are stored per leaf
+        constexpr static std::size_t BucketSize = 16;
+
+        /// Value returned by closestNeighbor when there is no neighbor
+        constexpr static std::int64_t NoNeighbor = -1;
+
+        /**
+         * \brief Creates an empty K-d tree
+         * \param allocator the allocator which will be used for the storage of this tree
+         */
+        explicit FlatKDTree(Allocator& allocator = Allocator::getDefault());
+
+        /**
+         * \brief Constructs a K-d tree with the given elements. Equivalent to empty constructor + build
+         * \param allocator the allocator which will be used for the storage of this tree
+         * \param elements elements to build the K-d tree with
+         */
+        explicit FlatKDTree(Allocator& allocator, std::span<const TElement> elements);
+
+        /**
+         * \brief Builds this tree to reference the given elements. Previous content of this tree are lost!
+         * \param elements the elements to store in this tree
+         */
+        void build(std::span<const TElement> elements);
+
+    public: // single queries
+        /**
+         * \brief Finds the closest element to a given position
+         * \param from position to get closest neighbor of
+         * \param maxDistance elements at 'maxDistance' or further will not be taken into account. Defaults to INFINITY
+         * \return index of the closest neighbor, or NoNeighbor if there are no such neighbor
+         */
+        std::int64_t closestNeighbor(const glm::vec3& from, float maxDistance = INFINITY) const;
+
+        /// Same as closestNeighbor(from.getPosition(), maxDistance)
+        std::int64_t closestNeighbor(const TElement& from, float maxDistance = INFINITY) const;
+
+        /**
+         * \brief Finds the k closest elements to a given position
+         * \param out vector where to store the neighbors, sorted from closest to furthest. Not cleared when filled
+         * \param from position to get closest neighbors of
+         * \param k maximum number of neighbors to find
+         * \param maxDistance elements at 'maxDistance' or further will not be taken into account. Defaults to INFINITY
+         */
+        void kNearest(Vector<std::size_t>& out, const glm::vec3& from, std::size_t k, float maxDistance = INFINITY) const;
+
+        /**
+         * \brief Finds all elements in this tree that are at most 'maxDistance' away from 'from'.
+         * \param out vector where to store the neighbors, not cleared when filled
+         * \param from position to search neighbors of
+         * \param maxDistance max distance to 'from'
+         */
+        void getNeighbors(Vector<std::size_t>& out, const glm::vec3& from, float maxDistance) const;
+
+        /// Same as getNeighbors(out, from.getPosition(), maxDistance)
+        void getNeighbors(Vector<std::size_t>& out, const TElement& from, float maxDistance) const;
+
+        /**
+         * \brief Finds all elements in this tree that are inside the region defined by min (inclusive) and max (exclusive).
+         * \param out vector where to store the elements, not cleared when filled
+         */
+        void rangeSearch(Vector<std::size_t>& out, const glm::vec3& min, const glm::vec3& max) const;
+
+    public: // batched queries
+        /**
+         * \brief closestNeighbor for each position of 'from'. Queries are split over threads with Carrot::Async::parallelFor, if available.
+         * \param out closest neighbor of from[i] is written to out[i]. Must be at least as large as 'from'
+         * \param from positions to get closest neighbor of
+         * \param maxDistance see closestNeighbor
+         */
+        void closestNeighbors(std::span<std::int64_t> out, std::span<const glm::vec3> from, float maxDistance = INFINITY) const;
+
+        /**
+         * \brief rangeSearch for each region (mins[i], maxs[i]).
+         * \param outIndices elements inside each region, region after region. Not cleared when filled
+         * \param outOffsets where the results of each region start inside 'outIndices', plus one last element for the end of
+         *  the last region. Not cleared when filled
+         * \param mins lower corners of the regions (inclusive)
+         * \param maxs upper corners of the regions (exclusive). Must have the same size as 'mins'
+         */
+        void rangeSearches(Vector<std::size_t>& outIndices, Vector<std::size_t>& outOffsets, std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs) const;
+
+    public:
+        /**
+         * How many elements are in this tree
+         */
+        std::size_t size() const;
+
+        /**
+         * Is this tree empty? (size() == 0)
+         */
+        bool empty() const;
+
+    private:
+        /// Index stored in the padding of leaf buckets
+        constexpr static std::uint32_t InvalidIndex = ~0u;
+
+        /// Deepest tree supported by the traversal stacks
+        constexpr static std::size_t MaxDepth = 64;
+
+        struct BuildPoint {
+            glm::vec3 position;
+            std::uint32_t elementIndex;
+        };
+
+        /// First point (inside 'points') of the node at index 'nodeIndex' of 'level'
+        std::size_t getRangeStart(std::size_t level, std::size_t nodeIndex) const;
+
+        /// Computes the split plane of the given internal node, and partitions its points around the median
+        void splitNode(BuildPoint* points, std::size_t level, std::size_t nodeIndex);
+
+        /// splitNode for the given node and all its descendants
+        void buildSubtree(BuildPoint* points, std::size_t level, std::size_t nodeIndex);
+
+        /// Calls 'leafAction(leafIndex, radiusSq)' on the leaves which may contain a point closer than 'radiusSq' (squared
+        /// distance), closest leaves first. 'leafAction' can reduce 'radiusSq' to prune the search
+        template<typename TLeafAction>
+        void forEachLeafNear(const glm::vec3& position, float& radiusSq, const TLeafAction& leafAction) const;
+
+        /// Calls 'leafAction(leafIndex)' on the leaves which may contain a point inside the region [min; max]
+        template<typename TLeafAction>
+        void forEachLeafInRegion(const glm::vec3& min, const glm::vec3& max, const TLeafAction& leafAction) const;
+
+        /// Squared distance between 'position' and each slot of the given leaf
+        void computeDistancesSq(float (&distancesSq)[BucketSize], std::size_t leafIndex, const glm::vec3& position) const;
+
+        Allocator& allocator;
+        std::size_t elementCount = 0;
+        std::size_t levelCount = 0; //< number of levels of internal nodes, there are 2^levelCount leaves
+
+        // internal nodes, in breadth-first order
+        Vector<float, NoConstructorVectorTraits> splitPositions;
+        Vector<std::uint8_t, NoConstructorVectorTraits> splitAxes;
+
+        // leaf buckets, BucketSize slots per leaf
+        Vector<float, NoConstructorVectorTraits> bucketX;
+        Vector<float, NoConstructorVectorTraits> bucketY;
+        Vector<float, NoConstructorVectorTraits> bucketZ;
+        Vector<std::uint32_t, NoConstructorVectorTraits> bucketElementIndices;
+    };
+}
+
+#include "FlatKDTree.ipp"
@@ -0,0 +1,389 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <core/tasks/Tasks.h>
+#include <core/utils/Assert.h>
+
+namespace Carrot {
+
+#define FLAT_KD_TREE_TEMPLATE template<typename TElement> requires HasSpatialInfo<TElement>
+
+    FLAT_KD_TREE_TEMPLATE
+    FlatKDTree<TElement>::FlatKDTree(Allocator& allocator)
+    : allocator(allocator)
+    , splitPositions(allocator)
+    , splitAxes(allocator)
+    , bucketX(allocator)
+    , bucketY(allocator)
+    , bucketZ(allocator)
+    , bucketElementIndices(allocator)
+    {}
+
+    FLAT_KD_TREE_TEMPLATE
+    FlatKDTree<TElement>::FlatKDTree(Allocator& allocator, std::span<const TElement> elements): FlatKDTree(allocator) {
+        build(elements);
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::build(std::span<const TElement> elements) {
+        verify(elements.size() < InvalidIndex, "Too many elements for a FlatKDTree");
+        elementCount = elements.size();
+
+        const std::size_t leafCount = std::bit_ceil(std::max<std::size_t>(1, (elementCount + BucketSize - 1) / BucketSize));
+        levelCount = std::countr_zero(leafCount);
+        verify(levelCount < MaxDepth, "Tree is too deep");
+
+        splitPositions.resize(leafCount - 1);
+        splitAxes.resize(leafCount - 1);
+
+        Vector<BuildPoint> points { Allocator::getDefault() };
+        points.resize(elementCount);
+        for(std::size_t i = 0; i < elementCount; i++) {
+            points[i].position = elements[i].getPosition();
+            points[i].elementIndex = static_cast<std::uint32_t>(i);
+        }
+
+        // top levels: split nodes of a level in parallel. Once there are enough nodes, build whole subtrees in parallel instead
+        constexpr std::size_t ParallelSubtrees = 64;
+        auto forEachParallel = [](std::size_t count, const std::function<void(std::size_t)>& action) {
+            if(count > 1 && Async::parallelFor != nullptr) {
+                Async::parallelFor(count, action, 1);
+            } else {
+                for(std::size_t i = 0; i < count; i++) {
+                    action(i);
+                }
+            }
+        };
+        for(std::size_t level = 0; level < levelCount; level++) {
+            const std::size_t nodesOnLevel = std::size_t(1) << level;
+            if(nodesOnLevel >= ParallelSubtrees) {
+                forEachParallel(nodesOnLevel, [&](std::size_t nodeIndex) {
+                    buildSubtree(points.data(), level, nodeIndex);
+                });
+                break;
+            }
+            forEachParallel(nodesOnLevel, [&](std::size_t nodeIndex) {
+                splitNode(points.data(), level, nodeIndex);
+            });
+        }
+
+        // fill leaf buckets, padding is at infinity so that it is never the closest point
+        bucketX.resize(leafCount * BucketSize);
+        bucketY.resize(leafCount * BucketSize);
+        bucketZ.resize(leafCount * BucketSize);
+        bucketElementIndices.resize(leafCount * BucketSize);
+        bucketX.fill(INFINITY);
+        bucketY.fill(INFINITY);
+        bucketZ.fill(INFINITY);
+        bucketElementIndices.fill(InvalidIndex);
+        for(std::size_t leafIndex = 0; leafIndex < leafCount; leafIndex++) {
+            const std::size_t start = getRangeStart(levelCount, leafIndex);
+            const std::size_t end = getRangeStart(levelCount, leafIndex + 1);
+            verify(end - start <= BucketSize, "Leaf is too large");
+            for(std::size_t i = start; i < end; i++) {
+                const std::size_t slot = leafIndex * BucketSize + (i - start);
+                bucketX[slot] = points[i].position.x;
+                bucketY[slot] = points[i].position.y;
+                bucketZ[slot] = points[i].position.z;
+                bucketElementIndices[slot] = points[i].elementIndex;
+            }
+        }
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    std::int64_t FlatKDTree<TElement>::closestNeighbor(const glm::vec3& from, float maxDistance) const {
+        if(empty()) {
+            return NoNeighbor;
+        }
+
+        float bestDistanceSq = maxDistance * maxDistance;
+        std::int64_t bestSlot = NoNeighbor;
+        forEachLeafNear(from, bestDistanceSq, [&](std::size_t leafIndex, float& radiusSq) {
+            float distancesSq[BucketSize];
+            computeDistancesSq(distancesSq, leafIndex, from);
+            for(std::size_t i = 0; i < BucketSize; i++) {
+                if(distancesSq[i] < radiusSq) {
+                    radiusSq = distancesSq[i];
+                    bestSlot = leafIndex * BucketSize + i;
+                }
+            }
+        });
+
+        if(bestSlot == NoNeighbor) {
+            return NoNeighbor;
+        }
+        return bucketElementIndices[bestSlot];
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    std::int64_t FlatKDTree<TElement>::closestNeighbor(const TElement& from, float maxDistance) const {
+        return closestNeighbor(from.getPosition(), maxDistance);
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::kNearest(Vector<std::size_t>& out, const glm::vec3& from, std::size_t k, float maxDistance) const {
+        if(empty() || k == 0) {
+            return;
+        }
+
+        struct Candidate {
+            float distanceSq;
+            std::uint32_t slot;
+
+            bool operator<(const Candidate& other) const {
+                return distanceSq < other.distanceSq;
+            }
+        };
+
+        // max-heap of the k best candidates found so far: the root is the furthest one
+        Vector<Candidate> candidates { Allocator::getDefault() };
+        candidates.setCapacity(std::min(k, size()));
+        float searchRadiusSq = maxDistance * maxDistance;
+        forEachLeafNear(from, searchRadiusSq, [&](std::size_t leafIndex, float& radiusSq) {
+            float distancesSq[BucketSize];
+            computeDistancesSq(distancesSq, leafIndex, from);
+            for(std::size_t i = 0; i < BucketSize; i++) {
+                if(distancesSq[i] >= radiusSq) {
+                    continue;
+                }
+                if(candidates.size() == k) {
+                    std::pop_heap(candidates.data(), candidates.data() + candidates.size());
+                    candidates.resize(k - 1);
+                }
+                candidates.pushBack(Candidate { distancesSq[i], static_cast<std::uint32_t>(leafIndex * BucketSize + i) });
+                std::push_heap(candidates.data(), candidates.data() + candidates.size());
+                if(candidates.size() == k) {
+                    radiusSq = candidates[0].distanceSq;
+                }
+            }
+        });
+
+        std::sort_heap(candidates.data(), candidates.data() + candidates.size());
+        for(const Candidate& candidate : candidates) {
+            out.pushBack(bucketElementIndices[candidate.slot]);
+        }
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::getNeighbors(Vector<std::size_t>& out, const glm::vec3& from, float maxDistance) const {
+        if(empty()) {
+            return;
+        }
+
+        const float maxDistanceSq = maxDistance * maxDistance;
+        forEachLeafInRegion(from - glm::vec3(maxDistance), from + glm::vec3(maxDistance), [&](std::size_t leafIndex) {
+            float distancesSq[BucketSize];
+            computeDistancesSq(distancesSq, leafIndex, from);
+            for(std::size_t i = 0; i < BucketSize; i++) {
+                const std::uint32_t elementIndex = bucketElementIndices[leafIndex * BucketSize + i];
+                if(distancesSq[i] <= maxDistanceSq && elementIndex != InvalidIndex) {
+                    out.pushBack(elementIndex);
+                }
+            }
+        });
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::getNeighbors(Vector<std::size_t>& out, const TElement& from, float maxDistance) const {
+        getNeighbors(out, from.getPosition(), maxDistance);
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::rangeSearch(Vector<std::size_t>& out, const glm::vec3& min, const glm::vec3& max) const {
+        if(empty()) {
+            return;
+        }
+
+        forEachLeafInRegion(min, max, [&](std::size_t leafIndex) {
+            const std::size_t firstSlot = leafIndex * BucketSize;
+            bool inside[BucketSize];
+            for(std::size_t i = 0; i < BucketSize; i++) {
+                const std::size_t slot = firstSlot + i;
+                inside[i] = (bucketX[slot] >= min.x) & (bucketX[slot] < max.x)
+                          & (bucketY[slot] >= min.y) & (bucketY[slot] < max.y)
+                          & (bucketZ[slot] >= min.z) & (bucketZ[slot] < max.z);
+            }
+            for(std::size_t i = 0; i < BucketSize; i++) {
+                const std::uint32_t elementIndex = bucketElementIndices[firstSlot + i];
+                if(inside[i] && elementIndex != InvalidIndex) {
+                    out.pushBack(elementIndex);
+                }
+            }
+        });
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::closestNeighbors(std::span<std::int64_t> out, std::span<const glm::vec3> from, float maxDistance) const {
+        verify(out.size() >= from.size(), "Output is too small");
+
+        constexpr std::size_t QueriesPerTask = 1024;
+        const std::size_t taskCount = (from.size() + QueriesPerTask - 1) / QueriesPerTask;
+        auto queryRange = [&](std::size_t taskIndex) {
+            const std::size_t end = std::min(from.size(), (taskIndex + 1) * QueriesPerTask);
+            for(std::size_t i = taskIndex * QueriesPerTask; i < end; i++) {
+                out[i] = closestNeighbor(from[i], maxDistance);
+            }
+        };
+
+        if(taskCount > 1 && Async::parallelFor != nullptr) {
+            Async::parallelFor(taskCount, queryRange, 1);
+        } else {
+            for(std::size_t taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+                queryRange(taskIndex);
+            }
+        }
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::rangeSearches(Vector<std::size_t>& outIndices, Vector<std::size_t>& outOffsets, std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs) const {
+        verify(mins.size() == maxs.size(), "There must be as many mins as maxs");
+
+        outOffsets.increaseReserve(mins.size() + 1);
+        for(std::size_t i = 0; i < mins.size(); i++) {
+            outOffsets.pushBack(outIndices.size());
+            rangeSearch(outIndices, mins[i], maxs[i]);
+        }
+        outOffsets.pushBack(outIndices.size());
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    std::size_t FlatKDTree<TElement>::size() const {
+        return elementCount;
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    bool FlatKDTree<TElement>::empty() const {
+        return size() == 0;
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    std::size_t FlatKDTree<TElement>::getRangeStart(std::size_t level, std::size_t nodeIndex) const {
+        // each node splits its range in two halves, so the ranges of a level split the points evenly
+        return (nodeIndex * elementCount) >> level;
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::splitNode(BuildPoint* points, std::size_t level, std::size_t nodeIndex) {
+        BuildPoint* start = points + getRangeStart(level, nodeIndex);
+        BuildPoint* end = points + getRangeStart(level, nodeIndex + 1);
+        BuildPoint* median = points + getRangeStart(level + 1, nodeIndex * 2 + 1);
+
+        // split along the axis where points are the most spread
+        glm::vec3 regionMin { +INFINITY };
+        glm::vec3 regionMax { -INFINITY };
+        for(const BuildPoint* p = start; p != end; p++) {
+            regionMin = glm::min(regionMin, p->position);
+            regionMax = glm::max(regionMax, p->position);
+        }
+        const glm::vec3 extents = regionMax - regionMin;
+        std::uint8_t axis = 0;
+        if(extents.y > extents[axis]) {
+            axis = 1;
+        }
+        if(extents.z > extents[axis]) {
+            axis = 2;
+        }
+
+        const std::size_t treeIndex = (std::size_t(1) << level) - 1 + nodeIndex;
+        splitAxes[treeIndex] = axis;
+        if(start == end) {
+            splitPositions[treeIndex] = 0.0f;
+            return;
+        }
+        std::nth_element(start, median, end, [axis](const BuildPoint& a, const BuildPoint& b) {
+            return a.position[axis] < b.position[axis];
+        });
+        splitPositions[treeIndex] = median == end ? (end-1)->position[axis] : median->position[axis];
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::buildSubtree(BuildPoint* points, std::size_t level, std::size_t nodeIndex) {
+        if(level >= levelCount) {
+            return;
+        }
+        splitNode(points, level, nodeIndex);
+        buildSubtree(points, level + 1, nodeIndex * 2);
+        buildSubtree(points, level + 1, nodeIndex * 2 + 1);
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    template<typename TLeafAction>
+    void FlatKDTree<TElement>::forEachLeafNear(const glm::vec3& position, float& radiusSq, const TLeafAction& leafAction) const {
+        struct PendingNode {
+            std::size_t treeIndex;
+            float distanceSq; //< lower bound of the distance between 'position' and the region of this node
+        };
+
+        const std::size_t internalNodeCount = splitPositions.size();
+        PendingNode stack[MaxDepth];
+        std::size_t stackSize = 0;
+        stack[stackSize++] = { 0, 0.0f };
+        while(stackSize > 0) {
+            const PendingNode pending = stack[--stackSize];
+            if(pending.distanceSq >= radiusSq) {
+                continue;
+            }
+
+            // go down towards 'position', and remember the other sides to visit them later if they are still close enough
+            std::size_t treeIndex = pending.treeIndex;
+            while(treeIndex < internalNodeCount) {
+                const float difference = position[splitAxes[treeIndex]] - splitPositions[treeIndex];
+                const std::size_t left = treeIndex * 2 + 1;
+                const std::size_t near = difference < 0.0f ? left : left + 1;
+                const std::size_t far = difference < 0.0f ? left + 1 : left;
+                const float farDistanceSq = difference * difference;
+                if(farDistanceSq < radiusSq) {
+                    stack[stackSize++] = { far, farDistanceSq };
+                }
+                treeIndex = near;
+            }
+            leafAction(treeIndex - internalNodeCount, radiusSq);
+        }
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    template<typename TLeafAction>
+    void FlatKDTree<TElement>::forEachLeafInRegion(const glm::vec3& min, const glm::vec3& max, const TLeafAction& leafAction) const {
+        const std::size_t internalNodeCount = splitPositions.size();
+        std::size_t stack[MaxDepth];
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0) {
+            const std::size_t treeIndex = stack[--stackSize];
+            if(treeIndex >= internalNodeCount) {
+                leafAction(treeIndex - internalNodeCount);
+                continue;
+            }
+
+            // points equal to the split position can be on either side
+            const std::uint8_t axis = splitAxes[treeIndex];
+            const float split = splitPositions[treeIndex];
+            if(max[axis] >= split) {
+                stack[stackSize++] = treeIndex * 2 + 2;
+            }
+            if(min[axis] <= split) {
+                stack[stackSize++] = treeIndex * 2 + 1;
+            }
+        }
+    }
+
+    FLAT_KD_TREE_TEMPLATE
+    void FlatKDTree<TElement>::computeDistancesSq(float (&distancesSq)[BucketSize], std::size_t leafIndex, const glm::vec3& position) const {
+        const float* x = bucketX.data() + leafIndex * BucketSize;
+        const float* y = bucketY.data() + leafIndex * BucketSize;
+        const float* z = bucketZ.data() + leafIndex * BucketSize;
+        for(std::size_t i = 0; i < BucketSize; i++) {
+            const float dx = x[i] - position.x;
+            const float dy = y[i] - position.y;
+            const float dz = z[i] - position.z;
+            distancesSq[i] = dx * dx + dy * dy + dz * dz;
+        }
+    }
+
+#undef FLAT_KD_TREE_TEMPLATE
+}
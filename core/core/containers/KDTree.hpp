@@ -18,6 +18,7 @@ namespace Carrot {
     /**
      * \brief Binary Space Partitioning tree mostly used for neighbor searches. Elements are expected to outlive this tree!
      * Also, all methods return indices to the input elements
+     * See FlatKDTree for a faster alternative with exact nearest neighbor searches.
      * \tparam TElement Element type to store inside this tree. Must match concept 'HasSpatialInfo'
      */
     template<typename TElement>
@@ -88,7 +89,7 @@ namespace Carrot {
         };
 
         void buildInner(Node* pDestination, Carrot::Allocator& tempAllocator, std::span<const TElement> allElements, const Carrot::Vector<std::size_t>& subset, std::size_t depth, const glm::vec3& regionMin, const glm::vec3& regionMax);
-        Node* findClosest(const TElement& element) const;
+        const Node* findClosest(const TElement& element) const;
 
         template<typename TFunctor>
         void rangeSearchInner(Vector<std::size_t>& out, const Node* pRoot, const glm::vec3& min, const glm::vec3& max, const TFunctor& checkResult) const;
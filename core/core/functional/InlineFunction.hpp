@@ -0,0 +1,177 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Carrot {
+    template<typename Signature, std::size_t InlineCapacity = 64>
+    class InlineFunction;
+
+    namespace Internal {
+        template<typename T>
+        constexpr bool IsStdFunction = false;
+
+        template<typename Signature>
+        constexpr bool IsStdFunction<std::function<Signature>> = true;
+    }
+
+    /**
+     * Type-erased callable, similar to std::function, but callables of up to 'InlineCapacity' bytes are stored inside the
+     * object itself instead of being allocated on the heap. Larger callables fall back to a heap allocation.
+     * Like std::function, stored callables must be copy-constructible.
+     */
+    template<typename Return, typename... Args, std::size_t InlineCapacity>
+    class InlineFunction<Return(Args...), InlineCapacity> {
+    public:
+        InlineFunction() = default;
+        InlineFunction(std::nullptr_t) {}
+
+        template<typename Callable>
+            requires (!std::is_same_v<std::decay_t<Callable>, InlineFunction>
+                      && !std::is_same_v<std::decay_t<Callable>, std::nullptr_t>
+                      && std::is_invocable_r_v<Return, std::decay_t<Callable>&, Args...>)
+        InlineFunction(Callable&& callable) {
+            using Stored = std::decay_t<Callable>;
+            if constexpr (std::is_pointer_v<Stored> || std::is_member_pointer_v<Stored> || Internal::IsStdFunction<Stored>) {
+                // null function pointers and empty std::function are considered empty, like std::function does
+                if (callable == nullptr) {
+                    return;
+                }
+            }
+            if constexpr (StoresInline<Stored>) {
+                new (storage) Stored(std::forward<Callable>(callable));
+            } else {
+                *reinterpret_cast<Stored**>(storage) = new Stored(std::forward<Callable>(callable));
+            }
+            pOperations = &OperationsFor<Stored>;
+        }
+
+        InlineFunction(const InlineFunction& other) {
+            if (other.pOperations) {
+                other.pOperations->copy(other.storage, storage);
+                pOperations = other.pOperations;
+            }
+        }
+
+        InlineFunction(InlineFunction&& other) noexcept {
+            if (other.pOperations) {
+                other.pOperations->move(other.storage, storage);
+                pOperations = other.pOperations;
+                other.pOperations = nullptr;
+            }
+        }
+
+        ~InlineFunction() {
+            reset();
+        }
+
+        InlineFunction& operator=(const InlineFunction& other) {
+            if (this != &other) {
+                InlineFunction copy { other };
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        InlineFunction& operator=(InlineFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                if (other.pOperations) {
+                    other.pOperations->move(other.storage, storage);
+                    pOperations = other.pOperations;
+                    other.pOperations = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        InlineFunction& operator=(std::nullptr_t) {
+            reset();
+            return *this;
+        }
+
+        Return operator()(Args... args) const {
+            return pOperations->invoke(const_cast<std::byte*>(storage), std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const {
+            return pOperations != nullptr;
+        }
+
+        /// Destroys the stored callable, if any
+        void reset() {
+            if (pOperations) {
+                pOperations->destroy(storage);
+                pOperations = nullptr;
+            }
+        }
+
+        /// Does the given callable type fit inside the object, without heap allocation?
+        template<typename Callable>
+        static constexpr bool StoresInline = sizeof(Callable) <= InlineCapacity
+                                          && alignof(Callable) <= alignof(std::max_align_t)
+                                          && std::is_nothrow_move_constructible_v<Callable>;
+
+    private:
+        struct Operations {
+            Return (*invoke)(std::byte* pStorage, Args&&... args);
+            void (*copy)(const std::byte* pSource, std::byte* pDestination);
+            /// Move-constructs into pDestination, and destroys the source
+            void (*move)(std::byte* pSource, std::byte* pDestination) noexcept;
+            void (*destroy)(std::byte* pStorage) noexcept;
+        };
+
+        template<typename Stored>
+        static Stored& get(std::byte* pStorage) {
+            if constexpr (StoresInline<Stored>) {
+                return *std::launder(reinterpret_cast<Stored*>(pStorage));
+            } else {
+                return **reinterpret_cast<Stored**>(pStorage);
+            }
+        }
+
+        template<typename Stored>
+        static constexpr Operations OperationsFor {
+            .invoke = [](std::byte* pStorage, Args&&... args) -> Return {
+                return std::invoke(get<Stored>(pStorage), std::forward<Args>(args)...);
+            },
+            .copy = [](const std::byte* pSource, std::byte* pDestination) {
+                const Stored& source = get<Stored>(const_cast<std::byte*>(pSource));
+                if constexpr (StoresInline<Stored>) {
+                    new (pDestination) Stored(source);
+                } else {
+                    *reinterpret_cast<Stored**>(pDestination) = new Stored(source);
+                }
+            },
+            .move = [](std::byte* pSource, std::byte* pDestination) noexcept {
+                if constexpr (StoresInline<Stored>) {
+                    Stored& source = get<Stored>(pSource);
+                    new (pDestination) Stored(std::move(source));
+                    source.~Stored();
+                } else {
+                    // heap allocated: only the pointer moves
+                    *reinterpret_cast<Stored**>(pDestination) = *reinterpret_cast<Stored**>(pSource);
+                }
+            },
+            .destroy = [](std::byte* pStorage) noexcept {
+                if constexpr (StoresInline<Stored>) {
+                    get<Stored>(pStorage).~Stored();
+                } else {
+                    delete *reinterpret_cast<Stored**>(pStorage);
+                }
+            },
+        };
+
+        static_assert(InlineCapacity >= sizeof(void*), "Must at least be able to store a pointer to heap-allocated callables");
+
+        alignas(std::max_align_t) std::byte storage[InlineCapacity];
+        const Operations* pOperations = nullptr;
+    };
+}
@@ -33,8 +33,9 @@ namespace Carrot::IO {
         OBJ,
         GLB,
         GLTF,
+        CMODEL, // Carrot cooked models
         ModelFirst = FBX,
-        ModelLast = GLTF,
+        ModelLast = CMODEL,
 
         PARTICLE,
 
@@ -101,6 +102,7 @@ namespace Carrot::IO {
         CHECK(OBJ);
         CHECK(GLB);
         CHECK(GLTF);
+        CHECK(CMODEL);
 
         CHECK(PARTICLE);
         CHECK(LUA);
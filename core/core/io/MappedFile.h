@@ -0,0 +1,45 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace Carrot::IO {
+
+    /**
+     * Read-only view of the contents of a file, mapped in memory by the OS.
+     * Pages are loaded on first access, so opening is fast even for large files, and only the accessed parts are read.
+     * Contents must not be modified while the file is mapped (writers should write to a new file instead).
+     */
+    class MappedFile {
+    public:
+        /// Maps the whole file. Throws if the file cannot be opened or mapped
+        static std::shared_ptr<const MappedFile> open(const std::filesystem::path& path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::span<const std::uint8_t> getData() const {
+            return std::span { pData, size };
+        }
+
+        const std::filesystem::path& getPath() const {
+            return path;
+        }
+
+    private:
+        MappedFile() = default;
+
+        std::filesystem::path path;
+        const std::uint8_t* pData = nullptr;
+        std::size_t size = 0;
+        void* pMappingHandle = nullptr; //< HANDLE of the file mapping object on Windows, unused on Linux
+    };
+
+} // Carrot::IO
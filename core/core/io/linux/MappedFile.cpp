@@ -0,0 +1,54 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <core/io/MappedFile.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Carrot::IO {
+
+    std::shared_ptr<const MappedFile> MappedFile::open(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::filesystem::filesystem_error("Failed to open file", path, std::error_code { errno, std::generic_category() });
+        }
+
+        struct stat fileStats{};
+        if(fstat(fd, &fileStats) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::filesystem::filesystem_error("Failed to get file size", path, std::error_code { error, std::generic_category() });
+        }
+
+        std::shared_ptr<MappedFile> pFile { new MappedFile };
+        pFile->path = path;
+        pFile->size = static_cast<std::size_t>(fileStats.st_size);
+        if(pFile->size > 0) { // mmap does not accept empty mappings
+            void* pMapping = mmap(nullptr, pFile->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(pMapping == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::filesystem::filesystem_error("Failed to map file", path, std::error_code { error, std::generic_category() });
+            }
+            pFile->pData = static_cast<const std::uint8_t*>(pMapping);
+        }
+
+        // the mapping keeps a reference to the file
+        ::close(fd);
+        return pFile;
+    }
+
+    MappedFile::~MappedFile() {
+        if(pData != nullptr) {
+            munmap(const_cast<std::uint8_t*>(pData), size);
+        }
+    }
+
+} // Carrot::IO
+#endif
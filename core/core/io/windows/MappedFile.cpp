@@ -0,0 +1,65 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <core/io/MappedFile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+namespace Carrot::IO {
+
+    static std::error_code getLastError() {
+        return std::error_code { static_cast<int>(GetLastError()), std::system_category() };
+    }
+
+    std::shared_ptr<const MappedFile> MappedFile::open(const std::filesystem::path& path) {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) {
+            throw std::filesystem::filesystem_error("Failed to open file", path, getLastError());
+        }
+
+        LARGE_INTEGER fileSize{};
+        if(!GetFileSizeEx(file, &fileSize)) {
+            const std::error_code error = getLastError();
+            CloseHandle(file);
+            throw std::filesystem::filesystem_error("Failed to get file size", path, error);
+        }
+
+        std::shared_ptr<MappedFile> pFile { new MappedFile };
+        pFile->path = path;
+        pFile->size = static_cast<std::size_t>(fileSize.QuadPart);
+        if(pFile->size > 0) { // CreateFileMapping does not accept empty files
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(mapping == nullptr) {
+                const std::error_code error = getLastError();
+                CloseHandle(file);
+                throw std::filesystem::filesystem_error("Failed to map file", path, error);
+            }
+            pFile->pMappingHandle = mapping;
+
+            void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if(pView == nullptr) {
+                const std::error_code error = getLastError();
+                CloseHandle(file);
+                throw std::filesystem::filesystem_error("Failed to map file", path, error); // destructor closes the mapping
+            }
+            pFile->pData = static_cast<const std::uint8_t*>(pView);
+        }
+
+        // the mapping keeps a reference to the file
+        CloseHandle(file);
+        return pFile;
+    }
+
+    MappedFile::~MappedFile() {
+        if(pData != nullptr) {
+            UnmapViewOfFile(pData);
+        }
+        if(pMappingHandle != nullptr) {
+            CloseHandle(pMappingHandle);
+        }
+    }
+
+} // Carrot::IO
+#endif
@@ -0,0 +1,535 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "Mipmaps.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <core/Macros.h>
+#include <core/tasks/Tasks.h>
+#include <core/utils/Profiling.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define CARROT_MIPMAPS_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CARROT_MIPMAPS_SSE2 1
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define CARROT_MIPMAPS_NEON 1
+#endif
+
+#if defined(__F16C__)
+    #include <immintrin.h>
+#endif
+
+namespace Carrot::Mipmaps {
+#if CARROT_MIPMAPS_AVX
+    constexpr std::size_t SimdWidth = 8;
+#else
+    constexpr std::size_t SimdWidth = 4;
+#endif
+
+    /// How many rows of the destination are computed by a single task of 'resample'
+    constexpr std::uint32_t StripHeight = 16;
+
+    // SIMD helpers. Loops handle 'count' which are not multiples of SimdWidth, unless noted otherwise
+
+    /// pDst[i] = pSrc[i] * weight
+    static void scaleRow(float* pDst, const float* pSrc, float weight, std::size_t count) {
+        std::size_t i = 0;
+#if CARROT_MIPMAPS_AVX
+        const __m256 w = _mm256_set1_ps(weight);
+        for(; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), w));
+        }
+#elif CARROT_MIPMAPS_SSE2
+        const __m128 w = _mm_set1_ps(weight);
+        for(; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_loadu_ps(pSrc + i), w));
+        }
+#elif CARROT_MIPMAPS_NEON
+        for(; i + 4 <= count; i += 4) {
+            vst1q_f32(pDst + i, vmulq_n_f32(vld1q_f32(pSrc + i), weight));
+        }
+#endif
+        for(; i < count; i++) {
+            pDst[i] = pSrc[i] * weight;
+        }
+    }
+
+    /// pDst[i] += pSrc[i] * weight
+    static void accumulateRow(float* pDst, const float* pSrc, float weight, std::size_t count) {
+        std::size_t i = 0;
+#if CARROT_MIPMAPS_AVX
+        const __m256 w = _mm256_set1_ps(weight);
+        for(; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(pDst + i, _mm256_add_ps(_mm256_loadu_ps(pDst + i), _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), w)));
+        }
+#elif CARROT_MIPMAPS_SSE2
+        const __m128 w = _mm_set1_ps(weight);
+        for(; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(_mm_loadu_ps(pSrc + i), w)));
+        }
+#elif CARROT_MIPMAPS_NEON
+        for(; i + 4 <= count; i += 4) {
+            vst1q_f32(pDst + i, vmlaq_n_f32(vld1q_f32(pDst + i), vld1q_f32(pSrc + i), weight));
+        }
+#endif
+        for(; i < count; i++) {
+            pDst[i] += pSrc[i] * weight;
+        }
+    }
+
+    /// Dot product of 'count' floats, 'count' must be a multiple of SimdWidth
+    static float dot(const float* pA, const float* pB, std::size_t count) {
+#if CARROT_MIPMAPS_AVX
+        __m256 sum = _mm256_setzero_ps();
+        for(std::size_t i = 0; i < count; i += 8) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(pA + i), _mm256_loadu_ps(pB + i)));
+        }
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        return _mm_cvtss_f32(sum4);
+#elif CARROT_MIPMAPS_SSE2
+        __m128 sum = _mm_setzero_ps();
+        for(std::size_t i = 0; i < count; i += 4) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i)));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+#elif CARROT_MIPMAPS_NEON
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for(std::size_t i = 0; i < count; i += 4) {
+            sum = vmlaq_f32(sum, vld1q_f32(pA + i), vld1q_f32(pB + i));
+        }
+        const float32x2_t sum2 = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+#else
+        float sum = 0.0f;
+        for(std::size_t i = 0; i < count; i++) {
+            sum += pA[i] * pB[i];
+        }
+        return sum;
+#endif
+    }
+
+    // Filter kernels, 't' is in texels of the destination
+
+    /// Radius of the kernel, in texels of the destination
+    static float getFilterRadius(Filter filter) {
+        switch(filter) {
+            case Filter::Box:
+                return 0.5f;
+            case Filter::Kaiser:
+            case Filter::Lanczos:
+                return 3.0f;
+        }
+        verify(false, "Unknown filter");
+        return 0.0f;
+    }
+
+    static double sinc(double x) {
+        if(std::abs(x) < 1e-6) {
+            return 1.0;
+        }
+        return std::sin(glm::pi<double>() * x) / (glm::pi<double>() * x);
+    }
+
+    /// Modified Bessel function of the first kind, order 0
+    static double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        const double halfX = x / 2.0;
+        for(int k = 1; k < 32 && term > sum * 1e-12; k++) {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    static double evaluateFilter(Filter filter, double t) {
+        const double radius = getFilterRadius(filter);
+        if(std::abs(t) > radius) {
+            return 0.0;
+        }
+        switch(filter) {
+            case Filter::Box:
+                return 1.0;
+
+            case Filter::Kaiser: {
+                constexpr double Alpha = 4.0;
+                const double x = t / radius;
+                return sinc(t) * besselI0(Alpha * std::sqrt(std::max(0.0, 1.0 - x * x))) / besselI0(Alpha);
+            }
+
+            case Filter::Lanczos:
+                return sinc(t) * sinc(t / radius);
+        }
+        return 0.0;
+    }
+
+    /// Weights of the source texels used by each texel of the destination, along one axis
+    struct FilterWeights {
+        /// Weights per destination texel, a multiple of SimdWidth if padded
+        std::uint32_t tapCount = 0;
+
+        /// Index of the source texel of the first weight, for each destination texel
+        Carrot::Vector<std::uint32_t> firstTaps;
+
+        /// tapCount weights per destination texel. Sum to 1
+        Carrot::Vector<float> weights;
+    };
+
+    /**
+     * Computes the weights of 'filter' to go from 'sourceSize' to 'destinationSize' texels.
+     * Texels outside of the source are clamped to the edges, and their weight is added to the edge texel: windows of
+     * weights never start before 0 nor end after 'sourceSize', except for padding (with weights of 0) if 'padToSimd'
+     */
+    static FilterWeights computeWeights(Filter filter, std::uint32_t sourceSize, std::uint32_t destinationSize, bool padToSimd) {
+        verify(destinationSize > 0 && destinationSize <= sourceSize, "Mipmaps only support downscaling");
+        const double scale = static_cast<double>(sourceSize) / destinationSize;
+        const double support = getFilterRadius(filter) * scale;
+
+        auto getSourceRange = [&](std::uint32_t destinationIndex) {
+            const double center = (destinationIndex + 0.5) * scale;
+            const std::int64_t first = static_cast<std::int64_t>(std::ceil(center - support - 0.5));
+            const std::int64_t last = static_cast<std::int64_t>(std::floor(center + support - 0.5));
+            return std::make_pair(first, last);
+        };
+
+        std::uint32_t maxSpan = 1;
+        for(std::uint32_t d = 0; d < destinationSize; d++) {
+            const auto [first, last] = getSourceRange(d);
+            maxSpan = std::max(maxSpan, static_cast<std::uint32_t>(last - first + 1));
+        }
+        const std::uint32_t windowSize = std::min(maxSpan, sourceSize);
+
+        FilterWeights result;
+        result.tapCount = padToSimd ? (windowSize + SimdWidth - 1) / SimdWidth * SimdWidth : windowSize;
+        result.firstTaps.resize(destinationSize);
+        result.weights.resize(static_cast<std::size_t>(destinationSize) * result.tapCount);
+        result.weights.fill(0.0f);
+
+        for(std::uint32_t d = 0; d < destinationSize; d++) {
+            const auto [first, last] = getSourceRange(d);
+            const std::int64_t windowStart = std::clamp<std::int64_t>(first, 0, sourceSize - windowSize);
+            result.firstTaps[d] = static_cast<std::uint32_t>(windowStart);
+
+            float* pWeights = &result.weights[static_cast<std::size_t>(d) * result.tapCount];
+            const double center = (d + 0.5) * scale;
+            double sum = 0.0;
+            for(std::int64_t s = first; s <= last; s++) {
+                const double weight = evaluateFilter(filter, (s + 0.5 - center) / scale);
+                const std::int64_t clampedIndex = std::clamp<std::int64_t>(s, 0, sourceSize - 1);
+                pWeights[clampedIndex - windowStart] += static_cast<float>(weight);
+                sum += weight;
+            }
+
+            if(std::abs(sum) < 1e-8) {
+                // can only happen with degenerate sizes, fallback to the closest texel
+                std::fill_n(pWeights, result.tapCount, 0.0f);
+                const std::int64_t closest = std::clamp<std::int64_t>(static_cast<std::int64_t>(center), 0, sourceSize - 1);
+                pWeights[closest - windowStart] = 1.0f;
+                continue;
+            }
+            const float invSum = static_cast<float>(1.0 / sum);
+            for(std::uint32_t tap = 0; tap < result.tapCount; tap++) {
+                pWeights[tap] *= invSum;
+            }
+        }
+        return result;
+    }
+
+    // sRGB conversions
+
+    static float sRGBToLinear(double value) {
+        return static_cast<float>(value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+    }
+
+    static double linearToSRGB(double value) {
+        return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+    }
+
+    static const std::array<float, 256>& getSRGBToLinearTable() {
+        static const std::array<float, 256> table = []() {
+            std::array<float, 256> values;
+            for(std::size_t i = 0; i < values.size(); i++) {
+                values[i] = sRGBToLinear(i / 255.0);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    /**
+     * Linear to sRGB without pow: the curve is sampled at each float whose 16 lowest bits are 0 (7 bits of mantissa,
+     * about 1100 samples over ]0.0031308; 1]), and linearly interpolated with the 16 lowest bits in between.
+     * Error is far below what 8 bits can represent.
+     */
+    class LinearToSRGBTable {
+    public:
+        constexpr static float LinearEnd = 0.0031308f;
+        constexpr static std::uint32_t FirstKey = std::bit_cast<std::uint32_t>(LinearEnd) >> 16;
+        constexpr static std::uint32_t LastKey = std::bit_cast<std::uint32_t>(1.0f) >> 16;
+
+        LinearToSRGBTable() {
+            for(std::uint32_t key = FirstKey; key <= LastKey + 1; key++) {
+                values[key - FirstKey] = static_cast<float>(linearToSRGB(std::bit_cast<float>(key << 16)));
+            }
+        }
+
+        /// Linear in [0; 1] to sRGB in [0; 1]. Values outside are clamped, NaN becomes 0
+        float convert(float linear) const {
+            if(!(linear > LinearEnd)) {
+                return linear > 0.0f ? linear * 12.92f : 0.0f;
+            }
+            if(linear >= 1.0f) {
+                return 1.0f;
+            }
+            const std::uint32_t bits = std::bit_cast<std::uint32_t>(linear);
+            const std::uint32_t index = (bits >> 16) - FirstKey;
+            const float t = static_cast<float>(bits & 0xFFFFu) * (1.0f / 65536.0f);
+            return values[index] + (values[index + 1] - values[index]) * t;
+        }
+
+    private:
+        std::array<float, LastKey - FirstKey + 2> values;
+    };
+
+    static const LinearToSRGBTable& getLinearToSRGBTable() {
+        static const LinearToSRGBTable table;
+        return table;
+    }
+
+    static std::uint8_t toUNorm8(float value) {
+        return static_cast<std::uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    void PlanarImage::resize(std::uint32_t newWidth, std::uint32_t newHeight, std::uint32_t newChannelCount) {
+        width = newWidth;
+        height = newHeight;
+        channelCount = newChannelCount;
+        texels.resize(static_cast<std::size_t>(width) * height * channelCount);
+    }
+
+    std::span<float> PlanarImage::getPlane(std::uint32_t channel) {
+        verify(channel < channelCount, "Channel out of bounds");
+        const std::size_t planeSize = static_cast<std::size_t>(width) * height;
+        return std::span { texels.data() + channel * planeSize, planeSize };
+    }
+
+    std::span<const float> PlanarImage::getPlane(std::uint32_t channel) const {
+        verify(channel < channelCount, "Channel out of bounds");
+        const std::size_t planeSize = static_cast<std::size_t>(width) * height;
+        return std::span { texels.cdata() + channel * planeSize, planeSize };
+    }
+
+    void decode(std::span<const std::uint8_t> texels, std::uint32_t width, std::uint32_t height, std::uint32_t channelCount,
+                std::uint8_t sRGBChannels, PlanarImage& out) {
+        ZoneScoped;
+        const std::size_t texelCount = static_cast<std::size_t>(width) * height;
+        verify(texels.size() >= texelCount * channelCount, "Not enough texels");
+        out.resize(width, height, channelCount);
+
+        const std::array<float, 256>& sRGBTable = getSRGBToLinearTable();
+        for(std::uint32_t channel = 0; channel < channelCount; channel++) {
+            std::span<float> plane = out.getPlane(channel);
+            if(sRGBChannels & (1u << channel)) {
+                for(std::size_t i = 0; i < texelCount; i++) {
+                    plane[i] = sRGBTable[texels[i * channelCount + channel]];
+                }
+            } else {
+                for(std::size_t i = 0; i < texelCount; i++) {
+                    plane[i] = texels[i * channelCount + channel] * (1.0f / 255.0f);
+                }
+            }
+        }
+    }
+
+    void encode(const PlanarImage& image, std::uint8_t sRGBChannels, std::span<std::uint8_t> texels) {
+        ZoneScoped;
+        const std::size_t texelCount = static_cast<std::size_t>(image.width) * image.height;
+        verify(texels.size() >= texelCount * image.channelCount, "Output is too small");
+
+        const LinearToSRGBTable& sRGBTable = getLinearToSRGBTable();
+        for(std::uint32_t channel = 0; channel < image.channelCount; channel++) {
+            std::span<const float> plane = image.getPlane(channel);
+            if(sRGBChannels & (1u << channel)) {
+                for(std::size_t i = 0; i < texelCount; i++) {
+                    texels[i * image.channelCount + channel] = toUNorm8(sRGBTable.convert(plane[i]));
+                }
+            } else {
+                for(std::size_t i = 0; i < texelCount; i++) {
+                    texels[i * image.channelCount + channel] = toUNorm8(plane[i]);
+                }
+            }
+        }
+    }
+
+    void floatsToHalves(std::span<const float> floats, std::span<std::uint16_t> halves) {
+        verify(halves.size() >= floats.size(), "Output is too small");
+        std::size_t i = 0;
+#if defined(__F16C__)
+        for(; i + 8 <= floats.size(); i += 8) {
+            const __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(&floats[i]), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&halves[i]), packed);
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for(; i + 4 <= floats.size(); i += 4) {
+            vst1_u16(&halves[i], vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(&floats[i]))));
+        }
+#endif
+        for(; i < floats.size(); i++) {
+            halves[i] = glm::packHalf1x16(floats[i]);
+        }
+    }
+
+    void halvesToFloats(std::span<const std::uint16_t> halves, std::span<float> floats) {
+        verify(floats.size() >= halves.size(), "Output is too small");
+        std::size_t i = 0;
+#if defined(__F16C__)
+        for(; i + 8 <= halves.size(); i += 8) {
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&halves[i]));
+            _mm256_storeu_ps(&floats[i], _mm256_cvtph_ps(packed));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for(; i + 4 <= halves.size(); i += 4) {
+            vst1q_f32(&floats[i], vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(&halves[i]))));
+        }
+#endif
+        for(; i < halves.size(); i++) {
+            floats[i] = glm::unpackHalf1x16(halves[i]);
+        }
+    }
+
+    void encodeHalf(const PlanarImage& image, std::span<std::uint16_t> halves) {
+        ZoneScoped;
+        const std::size_t texelCount = static_cast<std::size_t>(image.width) * image.height;
+        verify(halves.size() >= texelCount * image.channelCount, "Output is too small");
+
+        // convert a few texels at a time, then interleave
+        constexpr std::size_t ChunkSize = 256;
+        std::array<std::uint16_t, ChunkSize> chunk;
+        for(std::uint32_t channel = 0; channel < image.channelCount; channel++) {
+            std::span<const float> plane = image.getPlane(channel);
+            for(std::size_t start = 0; start < texelCount; start += ChunkSize) {
+                const std::size_t count = std::min(ChunkSize, texelCount - start);
+                floatsToHalves(plane.subspan(start, count), chunk);
+                for(std::size_t i = 0; i < count; i++) {
+                    halves[(start + i) * image.channelCount + channel] = chunk[i];
+                }
+            }
+        }
+    }
+
+    void resample(const PlanarImage& source, PlanarImage& destination, Filter filter) {
+        ZoneScoped;
+        verify(source.channelCount == destination.channelCount, "Source and destination must have the same channel count");
+        const FilterWeights horizontal = computeWeights(filter, source.width, destination.width, true);
+        const FilterWeights vertical = computeWeights(filter, source.height, destination.height, false);
+
+        const std::uint32_t stripCount = (destination.height + StripHeight - 1) / StripHeight;
+        auto resampleStrip = [&](std::size_t stripIndex) {
+            // source rows filtered vertically. Padded so that the padded windows of 'horizontal' stay inside
+            Carrot::Vector<float> filteredRow;
+            filteredRow.resize(source.width + horizontal.tapCount);
+            filteredRow.fill(0.0f);
+
+            const std::uint32_t firstRow = stripIndex * StripHeight;
+            const std::uint32_t lastRow = std::min(destination.height, firstRow + StripHeight);
+            for(std::uint32_t y = firstRow; y < lastRow; y++) {
+                const std::uint32_t firstSourceRow = vertical.firstTaps[y];
+                const float* pVerticalWeights = &vertical.weights[static_cast<std::size_t>(y) * vertical.tapCount];
+
+                for(std::uint32_t channel = 0; channel < source.channelCount; channel++) {
+                    const float* pSourcePlane = source.getPlane(channel).data();
+                    float* pDestinationRow = destination.getPlane(channel).data() + static_cast<std::size_t>(y) * destination.width;
+
+                    scaleRow(filteredRow.data(), pSourcePlane + static_cast<std::size_t>(firstSourceRow) * source.width, pVerticalWeights[0], source.width);
+                    for(std::uint32_t tap = 1; tap < vertical.tapCount; tap++) {
+                        if(pVerticalWeights[tap] == 0.0f) {
+                            continue;
+                        }
+                        accumulateRow(filteredRow.data(), pSourcePlane + static_cast<std::size_t>(firstSourceRow + tap) * source.width, pVerticalWeights[tap], source.width);
+                    }
+
+                    for(std::uint32_t x = 0; x < destination.width; x++) {
+                        pDestinationRow[x] = dot(filteredRow.cdata() + horizontal.firstTaps[x],
+                                                 horizontal.weights.cdata() + static_cast<std::size_t>(x) * horizontal.tapCount,
+                                                 horizontal.tapCount);
+                    }
+                }
+            }
+        };
+
+        if(stripCount > 1 && Async::parallelFor != nullptr) {
+            Async::parallelFor(stripCount, resampleStrip, 1);
+        } else {
+            for(std::uint32_t stripIndex = 0; stripIndex < stripCount; stripIndex++) {
+                resampleStrip(stripIndex);
+            }
+        }
+    }
+
+    float computeAlphaCoverage(std::span<const float> alpha, float cutoff, float scale) {
+        if(alpha.empty()) {
+            return 0.0f;
+        }
+        std::size_t coveredCount = 0;
+        for(const float value : alpha) {
+            coveredCount += value * scale > cutoff ? 1 : 0;
+        }
+        return static_cast<float>(coveredCount) / alpha.size();
+    }
+
+    void scaleAlphaToCoverage(std::span<float> alpha, float cutoff, float targetCoverage) {
+        // coverage decreases when the reference alpha increases: binary search the reference for which 'alpha' has the
+        // target coverage, then scale alpha so that this reference becomes the cutoff
+        float minReference = 0.0f;
+        float maxReference = 1.0f;
+        for(int iteration = 0; iteration < 12; iteration++) {
+            const float reference = (minReference + maxReference) / 2.0f;
+            if(computeAlphaCoverage(alpha, reference) > targetCoverage) {
+                minReference = reference;
+            } else {
+                maxReference = reference;
+            }
+        }
+
+        const float reference = std::max((minReference + maxReference) / 2.0f, 1e-4f);
+        const float scale = cutoff / reference;
+        for(float& value : alpha) {
+            value = std::clamp(value * scale, 0.0f, 1.0f);
+        }
+    }
+
+    void generateMipChain(const PlanarImage& mip0, std::uint32_t mipCount, const MipChainSettings& settings,
+                          const std::function<void(std::uint32_t mipLevel, const PlanarImage& mip)>& onMip) {
+        ZoneScoped;
+        const bool preserveAlphaCoverage = settings.preserveAlphaCoverage && settings.alphaChannel < mip0.channelCount;
+        const float targetCoverage = preserveAlphaCoverage ? computeAlphaCoverage(mip0.getPlane(settings.alphaChannel), settings.alphaCutoff) : 0.0f;
+
+        std::array<PlanarImage, 2> mips;
+        const PlanarImage* pPrevious = &mip0;
+        for(std::uint32_t mipLevel = 1; mipLevel < mipCount; mipLevel++) {
+            PlanarImage& mip = mips[mipLevel % 2];
+            mip.resize(std::max(1u, pPrevious->width >> 1), std::max(1u, pPrevious->height >> 1), mip0.channelCount);
+            resample(*pPrevious, mip, settings.filter);
+            if(preserveAlphaCoverage) {
+                scaleAlphaToCoverage(mip.getPlane(settings.alphaChannel), settings.alphaCutoff, targetCoverage);
+            }
+
+            onMip(mipLevel, mip);
+            pPrevious = &mip;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <core/containers/Vector.hpp>
+
+/**
+ * CPU generation of mip chains.
+ * Filtering is done on linear values: sRGB-encoded channels are converted to linear light before filtering, and back
+ * when encoding the result. Images are stored as one plane of floats per channel (structure of arrays), so the inner
+ * loops are over contiguous floats and use SSE2/AVX/NEON when available.
+ */
+namespace Carrot::Mipmaps {
+    /// Kernel used to compute a texel of a mip from the texels of the previous mip
+    enum class Filter: std::uint8_t {
+        Box, //< average of the texels covered by the texel of the mip. Blurry, but cheap and never rings
+        Kaiser, //< Kaiser-windowed sinc (3 lobes, alpha=4). Sharper than Box, slight ringing
+        Lanczos, //< Lanczos 3. Sharpest, rings more than Kaiser around hard edges
+    };
+
+    /// Image with one contiguous plane of floats per channel
+    struct PlanarImage {
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t channelCount = 0;
+
+        /// Plane of channel c is [c*width*height; (c+1)*width*height[, rows are contiguous
+        Carrot::Vector<float> texels;
+
+        /// Changes the dimensions of this image. Content is undefined afterwards
+        void resize(std::uint32_t width, std::uint32_t height, std::uint32_t channelCount);
+
+        std::span<float> getPlane(std::uint32_t channel);
+        std::span<const float> getPlane(std::uint32_t channel) const;
+    };
+
+    struct MipChainSettings {
+        Filter filter = Filter::Kaiser;
+
+        /// Channels which are stored in sRGB, one bit per channel (bit 0 = channel 0). Only matters for encode/decode
+        std::uint8_t sRGBChannels = 0;
+
+        /// Scales the alpha of each mip so that the same fraction of texels pass the alpha test as in mip 0.
+        /// Keeps alpha-tested foliage and fences from thinning out in the distance
+        bool preserveAlphaCoverage = false;
+
+        /// Alpha test reference value used for preserveAlphaCoverage
+        float alphaCutoff = 0.5f;
+
+        /// Channel holding the alpha, used for preserveAlphaCoverage
+        std::uint32_t alphaChannel = 3;
+    };
+
+    /// Bit mask of sRGBChannels for RGB(A) color images: RGB are sRGB, alpha is linear
+    constexpr std::uint8_t ColorSRGBChannels = 0b0111;
+
+    /**
+     * Converts interleaved 8-bit texels to a planar image. Channels of 'sRGBChannels' are converted to linear.
+     * \param texels width*height*channelCount bytes
+     */
+    void decode(std::span<const std::uint8_t> texels, std::uint32_t width, std::uint32_t height, std::uint32_t channelCount,
+                std::uint8_t sRGBChannels, PlanarImage& out);
+
+    /**
+     * Converts a planar image to interleaved 8-bit texels, values are clamped to [0; 1]. Channels of 'sRGBChannels' are
+     * converted to sRGB.
+     * \param texels image.width*image.height*image.channelCount bytes
+     */
+    void encode(const PlanarImage& image, std::uint8_t sRGBChannels, std::span<std::uint8_t> texels);
+
+    /**
+     * Converts a planar image to interleaved half floats (IEEE 754 binary16), for HDR images.
+     * \param halves image.width*image.height*image.channelCount elements
+     */
+    void encodeHalf(const PlanarImage& image, std::span<std::uint16_t> halves);
+
+    /// Converts floats to half floats, 'halves' must be at least as large as 'floats'
+    void floatsToHalves(std::span<const float> floats, std::span<std::uint16_t> halves);
+
+    /// Converts half floats to floats, 'floats' must be at least as large as 'halves'
+    void halvesToFloats(std::span<const std::uint16_t> halves, std::span<float> floats);
+
+    /**
+     * Resamples 'source' to the dimensions of 'destination' (which must already be sized, and have the same channel
+     * count). Only supports downscaling. Texels outside of the image repeat the edges.
+     * Rows of the destination are processed in strips: a strip only reads a few rows of the source which stay in cache
+     * for all its channels. Strips are split over threads via Carrot::Async::parallelFor if it is bound.
+     */
+    void resample(const PlanarImage& source, PlanarImage& destination, Filter filter);
+
+    /// Fraction of texels of 'alpha' which are strictly above 'cutoff' once multiplied by 'scale'
+    float computeAlphaCoverage(std::span<const float> alpha, float cutoff, float scale = 1.0f);
+
+    /// Scales 'alpha' so that its coverage (see computeAlphaCoverage) is as close as possible to 'targetCoverage'
+    void scaleAlphaToCoverage(std::span<float> alpha, float cutoff, float targetCoverage);
+
+    /**
+     * Generates mips 1 to mipCount-1 of 'mip0'. Each mip is computed from the previous one, and only two mips are alive at
+     * once: 'onMip' is called with each mip as soon as it is ready, and must copy what it needs.
+     * Values are not converted: decode the source with the sRGBChannels of the settings beforehand, and encode each mip
+     * with them.
+     */
+    void generateMipChain(const PlanarImage& mip0, std::uint32_t mipCount, const MipChainSettings& settings,
+                          const std::function<void(std::uint32_t mipLevel, const PlanarImage& mip)>& onMip);
+}
@@ -0,0 +1,160 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Carrot::VertexQuantization {
+    static constexpr float UNorm16Max = 65535.0f;
+    static constexpr float SNorm16Max = 32767.0f;
+    static constexpr float UNorm8Max = 255.0f;
+
+    static std::uint16_t quantizeUNorm16(float value, float min, float extent) {
+        if(extent <= 0.0f) {
+            return 0;
+        }
+        const float normalized = std::clamp((value - min) / extent, 0.0f, 1.0f);
+        return static_cast<std::uint16_t>(std::lround(normalized * UNorm16Max));
+    }
+
+    static float dequantizeUNorm16(std::uint16_t value, float min, float extent) {
+        return min + (value / UNorm16Max) * extent;
+    }
+
+    static std::uint8_t quantizeUNorm8(float value) {
+        return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * UNorm8Max));
+    }
+
+    template<typename VertexType>
+    static Bounds computeBoundsImpl(std::span<const VertexType> vertices) {
+        if(vertices.empty()) {
+            return {};
+        }
+        glm::vec3 minPos { vertices[0].pos };
+        glm::vec3 maxPos { vertices[0].pos };
+        glm::vec2 minUV { vertices[0].uv };
+        glm::vec2 maxUV { vertices[0].uv };
+        for(const VertexType& vertex : vertices) {
+            minPos = glm::min(minPos, glm::vec3 { vertex.pos });
+            maxPos = glm::max(maxPos, glm::vec3 { vertex.pos });
+            minUV = glm::min(minUV, vertex.uv);
+            maxUV = glm::max(maxUV, vertex.uv);
+        }
+        return Bounds {
+            .positionMin = minPos,
+            .positionExtent = maxPos - minPos,
+            .uvMin = minUV,
+            .uvExtent = maxUV - minUV,
+        };
+    }
+
+    Bounds computeBounds(std::span<const Carrot::Vertex> vertices) {
+        return computeBoundsImpl(vertices);
+    }
+
+    Bounds computeBounds(std::span<const Carrot::SkinnedVertex> vertices) {
+        return computeBoundsImpl(vertices);
+    }
+
+    void encodeOctahedral(const glm::vec3& direction, std::int16_t out[2]) {
+        const float l1Norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+        if(l1Norm <= 0.0f) {
+            out[0] = 0;
+            out[1] = 0;
+            return;
+        }
+        glm::vec2 p = glm::vec2 { direction.x, direction.y } / l1Norm;
+        if(direction.z < 0.0f) {
+            // fold the lower hemisphere over the diagonals
+            const glm::vec2 folded { 1.0f - std::abs(p.y), 1.0f - std::abs(p.x) };
+            p.x = p.x >= 0.0f ? folded.x : -folded.x;
+            p.y = p.y >= 0.0f ? folded.y : -folded.y;
+        }
+        out[0] = static_cast<std::int16_t>(std::lround(std::clamp(p.x, -1.0f, 1.0f) * SNorm16Max));
+        out[1] = static_cast<std::int16_t>(std::lround(std::clamp(p.y, -1.0f, 1.0f) * SNorm16Max));
+    }
+
+    glm::vec3 decodeOctahedral(const std::int16_t encoded[2]) {
+        const float x = std::max(encoded[0] / SNorm16Max, -1.0f);
+        const float y = std::max(encoded[1] / SNorm16Max, -1.0f);
+        glm::vec3 direction { x, y, 1.0f - std::abs(x) - std::abs(y) };
+        const float t = std::max(-direction.z, 0.0f);
+        direction.x += direction.x >= 0.0f ? -t : t;
+        direction.y += direction.y >= 0.0f ? -t : t;
+        return glm::normalize(direction);
+    }
+
+    void encodeBoneWeights(const glm::vec4& weights, std::uint8_t out[4]) {
+        int sum = 0;
+        int largest = 0;
+        for(int i = 0; i < 4; i++) {
+            out[i] = quantizeUNorm8(weights[i]);
+            sum += out[i];
+            if(weights[i] > weights[largest]) {
+                largest = i;
+            }
+        }
+
+        // rounding each weight can make the sum drift from 255, put the difference on the largest weight
+        const float weightSum = weights.x + weights.y + weights.z + weights.w;
+        if(std::abs(weightSum - 1.0f) < 1e-3f) {
+            out[largest] = static_cast<std::uint8_t>(std::clamp(out[largest] + 255 - sum, 0, 255));
+        }
+    }
+
+    QuantizedVertex encode(const Carrot::Vertex& vertex, const Bounds& bounds) {
+        QuantizedVertex result{};
+        for(int i = 0; i < 3; i++) {
+            result.position[i] = quantizeUNorm16(vertex.pos[i], bounds.positionMin[i], bounds.positionExtent[i]);
+        }
+        result.flags = vertex.tangent.w < 0.0f ? 1 : 0;
+        encodeOctahedral(vertex.normal, result.normal);
+        encodeOctahedral(glm::vec3 { vertex.tangent }, result.tangent);
+        for(int i = 0; i < 2; i++) {
+            result.uv[i] = quantizeUNorm16(vertex.uv[i], bounds.uvMin[i], bounds.uvExtent[i]);
+        }
+        for(int i = 0; i < 3; i++) {
+            result.color[i] = quantizeUNorm8(vertex.color[i]);
+        }
+        return result;
+    }
+
+    QuantizedSkinnedVertex encode(const Carrot::SkinnedVertex& vertex, const Bounds& bounds) {
+        QuantizedSkinnedVertex result{};
+        result.vertex = encode(static_cast<const Carrot::Vertex&>(vertex), bounds);
+        encodeBoneWeights(vertex.boneWeights, result.boneWeights);
+        for(int i = 0; i < 4; i++) {
+            result.boneIDs[i] = vertex.boneIDs[i];
+        }
+        return result;
+    }
+
+    Carrot::Vertex decode(const QuantizedVertex& vertex, const Bounds& bounds) {
+        Carrot::Vertex result{};
+        for(int i = 0; i < 3; i++) {
+            result.pos[i] = dequantizeUNorm16(vertex.position[i], bounds.positionMin[i], bounds.positionExtent[i]);
+        }
+        result.pos.w = 1.0f;
+        for(int i = 0; i < 3; i++) {
+            result.color[i] = vertex.color[i] / UNorm8Max;
+        }
+        result.normal = decodeOctahedral(vertex.normal);
+        result.tangent = glm::vec4 { decodeOctahedral(vertex.tangent), (vertex.flags & 1) != 0 ? -1.0f : 1.0f };
+        for(int i = 0; i < 2; i++) {
+            result.uv[i] = dequantizeUNorm16(vertex.uv[i], bounds.uvMin[i], bounds.uvExtent[i]);
+        }
+        return result;
+    }
+
+    Carrot::SkinnedVertex decode(const QuantizedSkinnedVertex& vertex, const Bounds& bounds) {
+        Carrot::SkinnedVertex result{};
+        static_cast<Carrot::Vertex&>(result) = decode(vertex.vertex, bounds);
+        for(int i = 0; i < 4; i++) {
+            result.boneWeights[i] = vertex.boneWeights[i] / UNorm8Max;
+            result.boneIDs[i] = vertex.boneIDs[i];
+        }
+        return result;
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <core/render/VertexTypes.h>
+#include <glm/glm.hpp>
+
+/**
+ * Compact versions of Carrot::Vertex and Carrot::SkinnedVertex, used to store meshes (see CookedModel.h).
+ * Positions and UVs are 16-bit UNORM relative to the bounds of their mesh, normals and tangents are 16-bit octahedral,
+ * colors and bone weights are 8-bit UNORM.
+ * Decoding assumes pos.w == 1 and colors inside [0; 1], which is what loaders produce.
+ */
+namespace Carrot::VertexQuantization {
+    /// Range covered by quantized positions and UVs of a mesh. Decoded values are 'min + quantized * extent'
+    struct Bounds {
+        glm::vec3 positionMin{0.0f};
+        glm::vec3 positionExtent{0.0f};
+        glm::vec2 uvMin{0.0f};
+        glm::vec2 uvExtent{0.0f};
+    };
+
+    /// Carrot::Vertex in 24 bytes instead of 80
+    struct QuantizedVertex {
+        std::uint16_t position[3]; //< UNORM16 inside Bounds
+        std::uint16_t flags; //< bit 0: tangent.w is negative
+        std::int16_t normal[2]; //< octahedral, SNORM16
+        std::int16_t tangent[2]; //< octahedral, SNORM16
+        std::uint16_t uv[2]; //< UNORM16 inside Bounds
+        std::uint8_t color[4]; //< RGB UNORM8, A unused
+    };
+    static_assert(sizeof(QuantizedVertex) == 24);
+
+    /// Carrot::SkinnedVertex in 32 bytes instead of 112
+    struct QuantizedSkinnedVertex {
+        QuantizedVertex vertex;
+        std::uint8_t boneWeights[4]; //< UNORM8, sum is exactly 255 if the original weights were normalized
+        std::uint8_t boneIDs[4];
+    };
+    static_assert(sizeof(QuantizedSkinnedVertex) == 32);
+
+    /// Smallest bounds containing all positions and UVs of the given vertices
+    Bounds computeBounds(std::span<const Carrot::Vertex> vertices);
+    Bounds computeBounds(std::span<const Carrot::SkinnedVertex> vertices);
+
+    QuantizedVertex encode(const Carrot::Vertex& vertex, const Bounds& bounds);
+    QuantizedSkinnedVertex encode(const Carrot::SkinnedVertex& vertex, const Bounds& bounds);
+    Carrot::Vertex decode(const QuantizedVertex& vertex, const Bounds& bounds);
+    Carrot::SkinnedVertex decode(const QuantizedSkinnedVertex& vertex, const Bounds& bounds);
+
+    /// Unit vector to octahedral coordinates, as SNORM16. Zero vectors give (0,0,1)
+    void encodeOctahedral(const glm::vec3& direction, std::int16_t out[2]);
+    glm::vec3 decodeOctahedral(const std::int16_t encoded[2]);
+
+    /// Weights are rounded so that their sum stays exactly 255 when they sum to 1
+    void encodeBoneWeights(const glm::vec4& weights, std::uint8_t out[4]);
+}
@@ -0,0 +1,764 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "CookedModel.h"
+#include <core/Macros.h>
+#include <core/io/MappedFile.h>
+#include <core/math/BasicFunctions.h>
+#include <core/render/VertexQuantization.h>
+#include <core/utils/Profiling.h>
+#include <core/utils/stringmanip.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <meshoptimizer.h>
+
+namespace Carrot::Render {
+
+    static constexpr std::array<char, 4> CMODELMagic = { 'C', 'M', 'D', 'L' };
+    static constexpr std::uint32_t CMODELVersion = 2;
+
+    /// Start of each section of a .cmodel file, relative to the start of the file. Enough for Carrot::Vertex
+    static constexpr std::size_t CMODELSectionAlignment = 16;
+
+    // .cmodel files are copied to memory as is, in the native layout of the types of LoadedScene
+    static_assert(std::endian::native == std::endian::little, ".cmodel files are used as is, and are little-endian");
+    static_assert(std::is_trivially_copyable_v<Carrot::Vertex> && std::is_trivially_copyable_v<Carrot::SkinnedVertex>);
+    static_assert(std::is_trivially_copyable_v<Meshlet>);
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float), ".cmodel files store tightly packed glm::mat4");
+
+    /// Arrays inside a .cmodel file, in the order they are written
+    enum class CMODELSection: std::uint32_t {
+        SceneInfo, // CookedSceneInfo, exactly 1
+        Strings, // char, referenced by StringRef
+        Materials, // CookedMaterial
+        Primitives, // CookedPrimitive
+        Vertices, // Carrot::Vertex, vertices of all primitives
+        SkinnedVertices, // Carrot::SkinnedVertex, skinned vertices of all primitives
+        QuantizedVertices, // VertexQuantization::QuantizedVertex, vertices of primitives with the QuantizedVertices flag
+        QuantizedSkinnedVertices, // VertexQuantization::QuantizedSkinnedVertex
+        Indices, // std::uint32_t
+        MeshletVertexIndices, // std::uint32_t
+        MeshletIndices, // std::uint32_t
+        Meshlets, // Meshlet
+        Nodes, // CookedNode, depth-first: parents are before their children, and children are in order
+        NodeMeshIndices, // std::uint32_t, primitives of nodes
+        BoneMappings, // CookedBoneMapping
+        OffsetMatrices, // CookedOffsetMatrix
+        Animations, // CookedAnimation, in the order of LoadedScene::animationData
+        AnimationMapping, // CookedAnimationName
+        Keyframes, // CookedKeyframe
+        BoneTransforms, // glm::mat4, bone transforms of keyframes
+        PrecomputedBLASes, // CookedBLAS
+        BLASBytes, // std::uint8_t
+
+        Count
+    };
+
+    /// How a section is stored inside the file
+    enum class CMODELEncoding: std::uint32_t {
+        None, // as is, used in place
+        MeshoptVertices, // meshopt_encodeVertexBuffer, the elements of the section are the vertices
+        MeshoptTriangles, // meshopt_encodeIndexBuffer, std::uint32_t triangle lists
+        MeshoptIndexSequence, // meshopt_encodeIndexSequence, std::uint32_t
+    };
+
+    struct CMODELSectionRange {
+        std::uint64_t offset = 0; //< in bytes, from the start of the file
+        std::uint64_t size = 0; //< in bytes, once decoded
+        std::uint64_t encodedSize = 0; //< in bytes, inside the file
+        CMODELEncoding encoding = CMODELEncoding::None;
+        std::uint32_t reserved = 0;
+    };
+
+    struct CMODELHeader {
+        std::array<char, 4> magic = CMODELMagic;
+        std::uint32_t version = CMODELVersion;
+        std::uint32_t sectionCount = static_cast<std::uint32_t>(CMODELSection::Count);
+        std::uint32_t reserved = 0;
+        CMODELSectionRange sections[static_cast<std::size_t>(CMODELSection::Count)];
+    };
+
+    // Records below have no implicit padding, so files do not contain uninitialized bytes
+
+    /// String inside the Strings section
+    struct StringRef {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+    };
+
+    /// Elements [first; first+count[ of a section
+    struct ArrayRef {
+        std::uint64_t first = 0;
+        std::uint64_t count = 0;
+    };
+
+    struct CookedSceneInfo {
+        StringRef debugName;
+        std::uint32_t hasSkeleton = 0;
+        std::uint32_t reserved = 0;
+        glm::mat4 globalInverseTransform{1.0f};
+    };
+    static_assert(sizeof(CookedSceneInfo) == 80);
+
+    struct CookedMaterial {
+        StringRef name;
+        StringRef albedo;
+        StringRef normalMap;
+        StringRef metallicRoughness;
+        StringRef occlusion;
+        StringRef emissive;
+        glm::vec4 baseColorFactor{1.0f};
+        glm::vec3 emissiveFactor{1.0f};
+        float metallicFactor = 1.0f;
+        float roughnessFactor = 1.0f;
+        std::uint32_t blendMode = 0;
+    };
+    static_assert(sizeof(CookedMaterial) == 88);
+
+    struct CookedPrimitive {
+        enum Flags: std::uint32_t {
+            IsSkinned = 1 << 0,
+            HadTangents = 1 << 1,
+            HadNormals = 1 << 2,
+            HadTexCoords = 1 << 3,
+            QuantizedVertices = 1 << 4, //< vertices and skinnedVertices are in the Quantized(Skinned)Vertices sections
+        };
+
+        StringRef name;
+        std::uint32_t flags = 0;
+        std::uint32_t reserved = 0;
+        std::int64_t materialIndex = -1;
+        glm::mat4 transform{1.0f};
+        glm::vec3 minPos{0.0f};
+        glm::vec3 maxPos{0.0f};
+        VertexQuantization::Bounds quantizationBounds;
+        ArrayRef vertices;
+        ArrayRef skinnedVertices;
+        ArrayRef indices;
+        ArrayRef meshletVertexIndices;
+        ArrayRef meshletIndices;
+        ArrayRef meshlets;
+    };
+    static_assert(sizeof(CookedPrimitive) == 248);
+
+    struct CookedNode {
+        static constexpr std::uint32_t NoParent = std::numeric_limits<std::uint32_t>::max();
+
+        StringRef name;
+        std::uint32_t parent = NoParent; //< index in Nodes section
+        std::uint32_t nodeKey = 0;
+        glm::mat4 transform{1.0f};
+        glm::mat4 originalTransform{1.0f};
+        std::uint32_t hasMeshIndices = 0; //< meshIndices can be present but empty
+        std::uint32_t firstMeshIndex = 0; //< in NodeMeshIndices section
+        std::uint32_t meshIndexCount = 0;
+        std::uint32_t reserved = 0;
+    };
+    static_assert(sizeof(CookedNode) == 160);
+
+    struct CookedBoneMapping {
+        std::int32_t primitiveIndex = 0;
+        std::uint32_t boneIndex = 0;
+        StringRef boneName;
+    };
+    static_assert(sizeof(CookedBoneMapping) == 16);
+
+    struct CookedOffsetMatrix {
+        std::int32_t primitiveIndex = 0;
+        std::uint32_t reserved = 0;
+        StringRef boneName;
+        glm::mat4 matrix{1.0f};
+    };
+    static_assert(sizeof(CookedOffsetMatrix) == 80);
+
+    struct CookedAnimation {
+        std::int32_t keyframeCount = 0;
+        float duration = 1.0f;
+        ArrayRef keyframes; //< in Keyframes section
+    };
+    static_assert(sizeof(CookedAnimation) == 24);
+
+    struct CookedAnimationName {
+        StringRef name;
+        std::uint32_t animationIndex = 0;
+        std::uint32_t reserved = 0;
+    };
+    static_assert(sizeof(CookedAnimationName) == 16);
+
+    struct CookedKeyframe {
+        float timestamp = 0.0f;
+        std::uint32_t reserved = 0;
+        ArrayRef boneTransforms; //< in BoneTransforms section
+    };
+    static_assert(sizeof(CookedKeyframe) == 24);
+
+    struct CookedBLAS {
+        std::uint32_t nodeKey = 0;
+        std::uint32_t primitiveIndex = 0;
+        std::uint32_t groupIndex = 0;
+        std::uint32_t reserved = 0;
+        ArrayRef bytes; //< in BLASBytes section
+    };
+    static_assert(sizeof(CookedBLAS) == 32);
+
+    /// Sections of a .cmodel file being loaded. Sections stored as is are used in place, without copying them. Encoded
+    /// sections are decoded once, and live as long as this object
+    struct CMODELSections {
+        std::span<const std::uint8_t> fileContents;
+        const CMODELHeader& header;
+        const char* fileName;
+        std::array<std::vector<std::uint8_t>, static_cast<std::size_t>(CMODELSection::Count)> decodedSections;
+
+        /// Gives access to an array of the file. Throws if the section is not a valid array of T
+        template<typename T>
+        std::span<const T> get(CMODELSection section) {
+            const CMODELSectionRange& range = header.sections[static_cast<std::size_t>(section)];
+            if(range.offset > fileContents.size() || range.encodedSize > fileContents.size() - range.offset || range.size % sizeof(T) != 0) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is truncated or corrupted (section %u)", fileName, static_cast<std::uint32_t>(section)));
+            }
+
+            const std::uint8_t* pEncoded = fileContents.data() + range.offset;
+            const std::size_t elementCount = range.size / sizeof(T);
+            const std::uint8_t* pStart = pEncoded;
+            if(range.encoding != CMODELEncoding::None) {
+                std::vector<std::uint8_t>& decoded = decodedSections[static_cast<std::size_t>(section)];
+                decoded.resize(range.size);
+                int status = -1;
+                if(range.encoding == CMODELEncoding::MeshoptVertices) {
+                    if constexpr(sizeof(T) % 4 == 0 && sizeof(T) <= 256) {
+                        status = meshopt_decodeVertexBuffer(decoded.data(), elementCount, sizeof(T), pEncoded, range.encodedSize);
+                    }
+                } else if(range.encoding == CMODELEncoding::MeshoptTriangles) {
+                    if constexpr(std::is_same_v<T, std::uint32_t>) {
+                        if(elementCount % 3 == 0) {
+                            status = meshopt_decodeIndexBuffer(decoded.data(), elementCount, sizeof(T), pEncoded, range.encodedSize);
+                        }
+                    }
+                } else if(range.encoding == CMODELEncoding::MeshoptIndexSequence) {
+                    if constexpr(std::is_same_v<T, std::uint32_t>) {
+                        status = meshopt_decodeIndexSequence(decoded.data(), elementCount, sizeof(T), pEncoded, range.encodedSize);
+                    }
+                }
+                if(status != 0) {
+                    throw std::invalid_argument(Carrot::sprintf("[CookedModel] Section %u of file %s could not be decoded", static_cast<std::uint32_t>(section), fileName));
+                }
+                pStart = decoded.data();
+            } else if(range.encodedSize != range.size) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is truncated or corrupted (section %u)", fileName, static_cast<std::uint32_t>(section)));
+            }
+
+            if(reinterpret_cast<std::uintptr_t>(pStart) % alignof(T) != 0) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] Section %u of file %s is misaligned", static_cast<std::uint32_t>(section), fileName));
+            }
+            return std::span { reinterpret_cast<const T*>(pStart), elementCount };
+        }
+    };
+
+    /// Appends an array to a .cmodel file being written. 'encoding' is only used if it makes the section smaller
+    template<typename T>
+    static void writeSection(std::vector<std::uint8_t>& fileContents, CMODELHeader& header, CMODELSection section, std::span<const T> elements, CMODELEncoding encoding = CMODELEncoding::None) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const std::size_t offset = Carrot::Math::alignUp(fileContents.size(), CMODELSectionAlignment);
+        const std::size_t size = elements.size_bytes();
+
+        std::vector<std::uint8_t> encoded;
+        if(encoding == CMODELEncoding::MeshoptVertices) {
+            if constexpr(sizeof(T) % 4 == 0 && sizeof(T) <= 256) {
+                encoded.resize(meshopt_encodeVertexBufferBound(elements.size(), sizeof(T)));
+                encoded.resize(meshopt_encodeVertexBuffer(encoded.data(), encoded.size(), elements.data(), elements.size(), sizeof(T)));
+            }
+        } else if(encoding == CMODELEncoding::MeshoptTriangles || encoding == CMODELEncoding::MeshoptIndexSequence) {
+            if constexpr(std::is_same_v<T, std::uint32_t>) {
+                const std::size_t vertexCount = elements.empty() ? 0 : *std::ranges::max_element(elements) + 1ull;
+                if(encoding == CMODELEncoding::MeshoptIndexSequence) {
+                    encoded.resize(meshopt_encodeIndexSequenceBound(elements.size(), vertexCount));
+                    encoded.resize(meshopt_encodeIndexSequence(encoded.data(), encoded.size(), elements.data(), elements.size()));
+                } else if(elements.size() % 3 == 0) { // concatenated triangle lists
+                    encoded.resize(meshopt_encodeIndexBufferBound(elements.size(), vertexCount));
+                    encoded.resize(meshopt_encodeIndexBuffer(encoded.data(), encoded.size(), elements.data(), elements.size()));
+                }
+            }
+        }
+        std::span<const std::uint8_t> stored = encoded;
+        if(encoded.empty() || encoded.size() >= size) {
+            encoding = CMODELEncoding::None;
+            stored = std::span { reinterpret_cast<const std::uint8_t*>(elements.data()), size };
+        }
+
+        fileContents.resize(offset + stored.size(), 0);
+        if(!stored.empty()) {
+            std::memcpy(fileContents.data() + offset, stored.data(), stored.size());
+        }
+        header.sections[static_cast<std::size_t>(section)] = CMODELSectionRange { .offset = offset, .size = size, .encodedSize = stored.size(), .encoding = encoding };
+    }
+
+    /// Elements of 'section' referenced by 'range'. Throws if they are out of bounds
+    template<typename T>
+    static std::span<const T> getRange(std::span<const T> section, const ArrayRef& range, const char* fileName) {
+        if(range.first > section.size() || range.count > section.size() - range.first) {
+            throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+        }
+        return section.subspan(range.first, range.count);
+    }
+
+    /// Copies the elements referenced by 'range' in a single memcpy
+    template<typename T>
+    static void copyRange(std::span<const T> section, const ArrayRef& range, std::vector<T>& out, const char* fileName) {
+        const std::span<const T> elements = getRange(section, range, fileName);
+        out.assign(elements.begin(), elements.end());
+    }
+
+    LoadedScene CookedModelLoader::load(const Carrot::IO::Resource& resource) {
+        ZoneScoped;
+        const IO::VFS::Path vfsPath { resource.getName() };
+        LoadedScene result;
+        if(resource.isFile()) {
+            std::shared_ptr<const IO::MappedFile> pFile = IO::MappedFile::open(resource.getFilepath());
+            result = load(pFile->getData(), vfsPath, resource.getName().c_str());
+        } else {
+            std::vector<std::uint8_t> contents(resource.getSize());
+            resource.read(contents);
+            result = load(contents, vfsPath, resource.getName().c_str());
+        }
+        result.debugName = resource.getName();
+        return result;
+    }
+
+    LoadedScene CookedModelLoader::load(std::span<const std::uint8_t> fileContents, const IO::VFS::Path& modelFilepath, const char* fileName) {
+        ZoneScoped;
+        CMODELHeader header;
+        if(fileContents.size() < sizeof(header)) {
+            throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is too small to be a .cmodel file", fileName));
+        }
+        std::memcpy(&header, fileContents.data(), sizeof(header));
+        if(header.magic != CMODELMagic) {
+            throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s does not have the proper magic header", fileName));
+        }
+        if(header.version != CMODELVersion || header.sectionCount != static_cast<std::uint32_t>(CMODELSection::Count)) {
+            throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s does not have a valid version", fileName));
+        }
+
+        CMODELSections sections { .fileContents = fileContents, .header = header, .fileName = fileName };
+
+        const auto sceneInfos = sections.get<CookedSceneInfo>(CMODELSection::SceneInfo);
+        const auto strings = sections.get<char>(CMODELSection::Strings);
+        const auto materials = sections.get<CookedMaterial>(CMODELSection::Materials);
+        const auto primitives = sections.get<CookedPrimitive>(CMODELSection::Primitives);
+        const auto vertices = sections.get<Carrot::Vertex>(CMODELSection::Vertices);
+        const auto skinnedVertices = sections.get<Carrot::SkinnedVertex>(CMODELSection::SkinnedVertices);
+        const auto quantizedVertices = sections.get<VertexQuantization::QuantizedVertex>(CMODELSection::QuantizedVertices);
+        const auto quantizedSkinnedVertices = sections.get<VertexQuantization::QuantizedSkinnedVertex>(CMODELSection::QuantizedSkinnedVertices);
+        const auto indices = sections.get<std::uint32_t>(CMODELSection::Indices);
+        const auto meshletVertexIndices = sections.get<std::uint32_t>(CMODELSection::MeshletVertexIndices);
+        const auto meshletIndices = sections.get<std::uint32_t>(CMODELSection::MeshletIndices);
+        const auto meshlets = sections.get<Meshlet>(CMODELSection::Meshlets);
+        const auto nodes = sections.get<CookedNode>(CMODELSection::Nodes);
+        const auto nodeMeshIndices = sections.get<std::uint32_t>(CMODELSection::NodeMeshIndices);
+        const auto boneMappings = sections.get<CookedBoneMapping>(CMODELSection::BoneMappings);
+        const auto offsetMatrices = sections.get<CookedOffsetMatrix>(CMODELSection::OffsetMatrices);
+        const auto animations = sections.get<CookedAnimation>(CMODELSection::Animations);
+        const auto animationMapping = sections.get<CookedAnimationName>(CMODELSection::AnimationMapping);
+        const auto keyframes = sections.get<CookedKeyframe>(CMODELSection::Keyframes);
+        const auto boneTransforms = sections.get<glm::mat4>(CMODELSection::BoneTransforms);
+        const auto precomputedBLASes = sections.get<CookedBLAS>(CMODELSection::PrecomputedBLASes);
+        const auto blasBytes = sections.get<std::uint8_t>(CMODELSection::BLASBytes);
+
+        if(sceneInfos.size() != 1) {
+            throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+        }
+        const CookedSceneInfo& sceneInfo = sceneInfos[0];
+
+        auto getString = [&](const StringRef& ref) {
+            if(ref.offset > strings.size() || ref.size > strings.size() - ref.offset) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+            }
+            return std::string { strings.data() + ref.offset, ref.size };
+        };
+
+        // texture paths are stored like glTF uris: relative to the model
+        auto getTexturePath = [&](const StringRef& ref) -> IO::VFS::Path {
+            const std::string path = getString(ref);
+            if(path.empty()) {
+                return {};
+            }
+            return modelFilepath.relative(IO::Path(path));
+        };
+
+        LoadedScene result;
+        result.debugName = getString(sceneInfo.debugName);
+
+        result.materials.reserve(materials.size());
+        for(const CookedMaterial& cookedMaterial : materials) {
+            LoadedMaterial& material = result.materials.emplace_back();
+            material.name = getString(cookedMaterial.name);
+            material.blendMode = static_cast<LoadedMaterial::BlendMode>(cookedMaterial.blendMode);
+            material.albedo = getTexturePath(cookedMaterial.albedo);
+            material.baseColorFactor = cookedMaterial.baseColorFactor;
+            material.normalMap = getTexturePath(cookedMaterial.normalMap);
+            material.metallicRoughness = getTexturePath(cookedMaterial.metallicRoughness);
+            material.metallicFactor = cookedMaterial.metallicFactor;
+            material.roughnessFactor = cookedMaterial.roughnessFactor;
+            material.occlusion = getTexturePath(cookedMaterial.occlusion);
+            material.emissive = getTexturePath(cookedMaterial.emissive);
+            material.emissiveFactor = cookedMaterial.emissiveFactor;
+        }
+
+        result.primitives.resize(primitives.size());
+        for(std::size_t i = 0; i < primitives.size(); i++) {
+            const CookedPrimitive& cookedPrimitive = primitives[i];
+            LoadedPrimitive& primitive = result.primitives[i];
+            primitive.name = getString(cookedPrimitive.name);
+            primitive.isSkinned = (cookedPrimitive.flags & CookedPrimitive::IsSkinned) != 0;
+            primitive.hadTangents = (cookedPrimitive.flags & CookedPrimitive::HadTangents) != 0;
+            primitive.hadNormals = (cookedPrimitive.flags & CookedPrimitive::HadNormals) != 0;
+            primitive.hadTexCoords = (cookedPrimitive.flags & CookedPrimitive::HadTexCoords) != 0;
+            primitive.transform = cookedPrimitive.transform;
+            primitive.minPos = cookedPrimitive.minPos;
+            primitive.maxPos = cookedPrimitive.maxPos;
+            primitive.materialIndex = cookedPrimitive.materialIndex;
+            if(primitive.materialIndex >= static_cast<std::int64_t>(materials.size())) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+            }
+
+            if(cookedPrimitive.flags & CookedPrimitive::QuantizedVertices) {
+                const VertexQuantization::Bounds& bounds = cookedPrimitive.quantizationBounds;
+                const auto primitiveVertices = getRange(quantizedVertices, cookedPrimitive.vertices, fileName);
+                primitive.vertices.resize(primitiveVertices.size());
+                for(std::size_t v = 0; v < primitiveVertices.size(); v++) {
+                    primitive.vertices[v] = VertexQuantization::decode(primitiveVertices[v], bounds);
+                }
+                const auto primitiveSkinnedVertices = getRange(quantizedSkinnedVertices, cookedPrimitive.skinnedVertices, fileName);
+                primitive.skinnedVertices.resize(primitiveSkinnedVertices.size());
+                for(std::size_t v = 0; v < primitiveSkinnedVertices.size(); v++) {
+                    primitive.skinnedVertices[v] = VertexQuantization::decode(primitiveSkinnedVertices[v], bounds);
+                }
+            } else {
+                copyRange(vertices, cookedPrimitive.vertices, primitive.vertices, fileName);
+                copyRange(skinnedVertices, cookedPrimitive.skinnedVertices, primitive.skinnedVertices, fileName);
+            }
+            copyRange(indices, cookedPrimitive.indices, primitive.indices, fileName);
+            copyRange(meshletVertexIndices, cookedPrimitive.meshletVertexIndices, primitive.meshletVertexIndices, fileName);
+            copyRange(meshletIndices, cookedPrimitive.meshletIndices, primitive.meshletIndices, fileName);
+            copyRange(meshlets, cookedPrimitive.meshlets, primitive.meshlets, fileName);
+        }
+
+        if(sceneInfo.hasSkeleton) {
+            result.nodeHierarchy = std::make_unique<Skeleton>(sceneInfo.globalInverseTransform);
+            std::vector<SkeletonTreeNode*> loadedNodes;
+            loadedNodes.reserve(nodes.size());
+            for(std::size_t i = 0; i < nodes.size(); i++) {
+                const CookedNode& cookedNode = nodes[i];
+                const bool isRoot = i == 0;
+                if(isRoot != (cookedNode.parent == CookedNode::NoParent) || (!isRoot && cookedNode.parent >= i)) {
+                    throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+                }
+
+                SkeletonTreeNode& node = isRoot ? result.nodeHierarchy->hierarchy : loadedNodes[cookedNode.parent]->newChild();
+                node.bone.name = getString(cookedNode.name);
+                node.bone.transform = cookedNode.transform;
+                node.bone.originalTransform = cookedNode.originalTransform;
+                node.nodeKey.value = cookedNode.nodeKey;
+                if(cookedNode.hasMeshIndices) {
+                    const std::span<const std::uint32_t> meshIndices = getRange(nodeMeshIndices, ArrayRef { cookedNode.firstMeshIndex, cookedNode.meshIndexCount }, fileName);
+                    node.meshIndices = std::vector<std::size_t> { meshIndices.begin(), meshIndices.end() };
+                }
+                loadedNodes.push_back(&node);
+            }
+        }
+
+        for(const CookedBoneMapping& mapping : boneMappings) {
+            result.boneMapping[mapping.primitiveIndex][getString(mapping.boneName)] = mapping.boneIndex;
+        }
+        for(const CookedOffsetMatrix& offsetMatrix : offsetMatrices) {
+            result.offsetMatrices[offsetMatrix.primitiveIndex][getString(offsetMatrix.boneName)] = offsetMatrix.matrix;
+        }
+
+        result.animationData.resize(animations.size());
+        for(std::size_t i = 0; i < animations.size(); i++) {
+            const CookedAnimation& cookedAnimation = animations[i];
+            Animation& animation = result.animationData[i];
+            animation.keyframeCount = cookedAnimation.keyframeCount;
+            animation.duration = cookedAnimation.duration;
+
+            const std::span<const CookedKeyframe> cookedKeyframes = getRange(keyframes, cookedAnimation.keyframes, fileName);
+            animation.keyframes.reserve(cookedKeyframes.size());
+            for(const CookedKeyframe& cookedKeyframe : cookedKeyframes) {
+                Keyframe& keyframe = animation.keyframes.emplace_back(cookedKeyframe.timestamp);
+                copyRange(boneTransforms, cookedKeyframe.boneTransforms, keyframe.boneTransforms, fileName);
+            }
+        }
+        for(const CookedAnimationName& animationName : animationMapping) {
+            if(animationName.animationIndex >= animations.size()) {
+                throw std::invalid_argument(Carrot::sprintf("[CookedModel] File %s is corrupted", fileName));
+            }
+            result.animationMapping[getString(animationName.name)] = animationName.animationIndex;
+        }
+
+        for(const CookedBLAS& cookedBLAS : precomputedBLASes) {
+            const std::span<const std::uint8_t> bytes = getRange(blasBytes, cookedBLAS.bytes, fileName);
+            PrecomputedBLAS& blas = result.precomputedBLASes[NodeKey { cookedBLAS.nodeKey }][Carrot::Pair { cookedBLAS.primitiveIndex, cookedBLAS.groupIndex }];
+            blas.blasBytes.resize(bytes.size());
+            if(!bytes.empty()) {
+                std::memcpy(blas.blasBytes.data(), bytes.data(), bytes.size());
+            }
+        }
+
+        return result;
+    }
+
+    /// Copy of 'vertex' with zeroed padding, so that the same scene always gives the same file
+    static Carrot::Vertex withoutPadding(const Carrot::Vertex& vertex) {
+        Carrot::Vertex result;
+        std::memset(&result, 0, sizeof(result));
+        result.pos = vertex.pos;
+        result.color = vertex.color;
+        result.normal = vertex.normal;
+        result.tangent = vertex.tangent;
+        result.uv = vertex.uv;
+        return result;
+    }
+
+    static Carrot::SkinnedVertex withoutPadding(const Carrot::SkinnedVertex& vertex) {
+        Carrot::SkinnedVertex result;
+        std::memset(&result, 0, sizeof(result));
+        static_cast<Carrot::Vertex&>(result) = withoutPadding(static_cast<const Carrot::Vertex&>(vertex));
+        result.boneWeights = vertex.boneWeights;
+        result.boneIDs = vertex.boneIDs;
+        return result;
+    }
+
+    std::vector<std::uint8_t> writeAsCookedModel(const LoadedScene& scene, const CookedModelOptions& options) {
+        ZoneScoped;
+        std::vector<char> strings;
+        auto addString = [&](const std::string& str) {
+            verify(strings.size() + str.size() <= std::numeric_limits<std::uint32_t>::max(), "Too many strings for a cooked model");
+            const StringRef ref { .offset = static_cast<std::uint32_t>(strings.size()), .size = static_cast<std::uint32_t>(str.size()) };
+            strings.insert(strings.end(), str.begin(), str.end());
+            return ref;
+        };
+        auto addPath = [&](const IO::VFS::Path& path) {
+            return path.isEmpty() ? StringRef{} : addString(path.toString());
+        };
+
+        // appends 'elements' to 'section' and returns where they are
+        auto append = [](auto& section, const auto& elements) {
+            const ArrayRef ref { .first = section.size(), .count = elements.size() };
+            section.insert(section.end(), elements.begin(), elements.end());
+            return ref;
+        };
+
+        CookedSceneInfo sceneInfo;
+        sceneInfo.debugName = addString(scene.debugName);
+        sceneInfo.hasSkeleton = scene.nodeHierarchy != nullptr;
+        sceneInfo.globalInverseTransform = scene.nodeHierarchy ? scene.nodeHierarchy->getGlobalInverseTransform() : glm::mat4{1.0f};
+
+        std::vector<CookedMaterial> materials;
+        materials.reserve(scene.materials.size());
+        for(const LoadedMaterial& material : scene.materials) {
+            materials.emplace_back(CookedMaterial {
+                .name = addString(material.name),
+                .albedo = addPath(material.albedo),
+                .normalMap = addPath(material.normalMap),
+                .metallicRoughness = addPath(material.metallicRoughness),
+                .occlusion = addPath(material.occlusion),
+                .emissive = addPath(material.emissive),
+                .baseColorFactor = material.baseColorFactor,
+                .emissiveFactor = material.emissiveFactor,
+                .metallicFactor = material.metallicFactor,
+                .roughnessFactor = material.roughnessFactor,
+                .blendMode = static_cast<std::uint32_t>(material.blendMode),
+            });
+        }
+
+        std::vector<CookedPrimitive> primitives;
+        std::vector<Carrot::Vertex> vertices;
+        std::vector<Carrot::SkinnedVertex> skinnedVertices;
+        std::vector<VertexQuantization::QuantizedVertex> quantizedVertices;
+        std::vector<VertexQuantization::QuantizedSkinnedVertex> quantizedSkinnedVertices;
+        std::vector<std::uint32_t> indices;
+        std::vector<std::uint32_t> meshletVertexIndices;
+        std::vector<std::uint32_t> meshletIndices;
+        std::vector<Meshlet> meshlets;
+        primitives.reserve(scene.primitives.size());
+        for(const LoadedPrimitive& primitive : scene.primitives) {
+            CookedPrimitive& cookedPrimitive = primitives.emplace_back();
+            cookedPrimitive.name = addString(primitive.name);
+            cookedPrimitive.flags = (primitive.isSkinned ? CookedPrimitive::IsSkinned : 0)
+                                  | (primitive.hadTangents ? CookedPrimitive::HadTangents : 0)
+                                  | (primitive.hadNormals ? CookedPrimitive::HadNormals : 0)
+                                  | (primitive.hadTexCoords ? CookedPrimitive::HadTexCoords : 0)
+                                  | (options.quantizeVertices ? CookedPrimitive::QuantizedVertices : 0);
+            cookedPrimitive.materialIndex = primitive.materialIndex;
+            cookedPrimitive.transform = primitive.transform;
+            cookedPrimitive.minPos = primitive.minPos;
+            cookedPrimitive.maxPos = primitive.maxPos;
+
+            if(options.quantizeVertices) {
+                verify(primitive.vertices.empty() || primitive.skinnedVertices.empty(), "Primitives have either static or skinned vertices");
+                const VertexQuantization::Bounds bounds = primitive.skinnedVertices.empty()
+                    ? VertexQuantization::computeBounds(primitive.vertices)
+                    : VertexQuantization::computeBounds(primitive.skinnedVertices);
+                cookedPrimitive.quantizationBounds = bounds;
+
+                cookedPrimitive.vertices = ArrayRef { .first = quantizedVertices.size(), .count = primitive.vertices.size() };
+                for(const Carrot::Vertex& vertex : primitive.vertices) {
+                    quantizedVertices.emplace_back(VertexQuantization::encode(vertex, bounds));
+                }
+                cookedPrimitive.skinnedVertices = ArrayRef { .first = quantizedSkinnedVertices.size(), .count = primitive.skinnedVertices.size() };
+                for(const Carrot::SkinnedVertex& vertex : primitive.skinnedVertices) {
+                    quantizedSkinnedVertices.emplace_back(VertexQuantization::encode(vertex, bounds));
+                }
+            } else {
+                cookedPrimitive.vertices = ArrayRef { .first = vertices.size(), .count = primitive.vertices.size() };
+                for(const Carrot::Vertex& vertex : primitive.vertices) {
+                    vertices.emplace_back(withoutPadding(vertex));
+                }
+                cookedPrimitive.skinnedVertices = ArrayRef { .first = skinnedVertices.size(), .count = primitive.skinnedVertices.size() };
+                for(const Carrot::SkinnedVertex& vertex : primitive.skinnedVertices) {
+                    skinnedVertices.emplace_back(withoutPadding(vertex));
+                }
+            }
+            cookedPrimitive.indices = append(indices, primitive.indices);
+            cookedPrimitive.meshletVertexIndices = append(meshletVertexIndices, primitive.meshletVertexIndices);
+            cookedPrimitive.meshletIndices = append(meshletIndices, primitive.meshletIndices);
+            cookedPrimitive.meshlets = append(meshlets, primitive.meshlets);
+        }
+
+        std::vector<CookedNode> nodes;
+        std::vector<std::uint32_t> nodeMeshIndices;
+        if(scene.nodeHierarchy) {
+            std::function<void(const SkeletonTreeNode&, std::uint32_t)> addNode = [&](const SkeletonTreeNode& node, std::uint32_t parent) {
+                const std::uint32_t nodeIndex = nodes.size();
+                CookedNode& cookedNode = nodes.emplace_back();
+                cookedNode.name = addString(node.bone.name);
+                cookedNode.parent = parent;
+                cookedNode.nodeKey = node.nodeKey.value;
+                cookedNode.transform = node.bone.transform;
+                cookedNode.originalTransform = node.bone.originalTransform;
+                if(node.meshIndices.has_value()) {
+                    cookedNode.hasMeshIndices = 1;
+                    cookedNode.firstMeshIndex = nodeMeshIndices.size();
+                    cookedNode.meshIndexCount = node.meshIndices->size();
+                    for(const std::size_t meshIndex : node.meshIndices.value()) {
+                        nodeMeshIndices.push_back(meshIndex);
+                    }
+                }
+                for(const SkeletonTreeNode& child : node.getChildren()) {
+                    addNode(child, nodeIndex);
+                }
+            };
+            addNode(scene.nodeHierarchy->hierarchy, CookedNode::NoParent);
+        }
+
+        // maps are sorted so that the same scene always gives the same file
+        std::vector<std::tuple<int, std::string, std::uint32_t>> sortedBoneMappings;
+        for(const auto& [primitiveIndex, mapping] : scene.boneMapping) {
+            for(const auto& [boneName, boneIndex] : mapping) {
+                sortedBoneMappings.emplace_back(primitiveIndex, boneName, boneIndex);
+            }
+        }
+        std::ranges::sort(sortedBoneMappings);
+        std::vector<CookedBoneMapping> boneMappings;
+        boneMappings.reserve(sortedBoneMappings.size());
+        for(const auto& [primitiveIndex, boneName, boneIndex] : sortedBoneMappings) {
+            boneMappings.emplace_back(CookedBoneMapping { .primitiveIndex = primitiveIndex, .boneIndex = boneIndex, .boneName = addString(boneName) });
+        }
+
+        std::vector<std::pair<int, std::string>> sortedOffsetMatrices;
+        for(const auto& [primitiveIndex, matrices] : scene.offsetMatrices) {
+            for(const auto& [boneName, _] : matrices) {
+                sortedOffsetMatrices.emplace_back(primitiveIndex, boneName);
+            }
+        }
+        std::ranges::sort(sortedOffsetMatrices);
+        std::vector<CookedOffsetMatrix> offsetMatrices;
+        offsetMatrices.reserve(sortedOffsetMatrices.size());
+        for(const auto& [primitiveIndex, boneName] : sortedOffsetMatrices) {
+            offsetMatrices.emplace_back(CookedOffsetMatrix {
+                .primitiveIndex = primitiveIndex,
+                .boneName = addString(boneName),
+                .matrix = scene.offsetMatrices.at(primitiveIndex).at(boneName),
+            });
+        }
+
+        std::vector<CookedAnimation> animations;
+        std::vector<CookedKeyframe> keyframes;
+        std::vector<glm::mat4> boneTransforms;
+        animations.reserve(scene.animationData.size());
+        for(const Animation& animation : scene.animationData) {
+            animations.emplace_back(CookedAnimation {
+                .keyframeCount = animation.keyframeCount,
+                .duration = animation.duration,
+                .keyframes = ArrayRef { .first = keyframes.size(), .count = animation.keyframes.size() },
+            });
+            for(const Keyframe& keyframe : animation.keyframes) {
+                keyframes.emplace_back(CookedKeyframe {
+                    .timestamp = keyframe.timestamp,
+                    .boneTransforms = append(boneTransforms, keyframe.boneTransforms),
+                });
+            }
+        }
+        std::vector<CookedAnimationName> animationMapping;
+        for(const auto& [animationName, animationIndex] : scene.animationMapping) { // std::map, already sorted
+            animationMapping.emplace_back(CookedAnimationName { .name = addString(animationName), .animationIndex = animationIndex });
+        }
+
+        std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t, const PrecomputedBLAS*>> sortedBLASes;
+        for(const auto& [nodeKey, blasesOfNode] : scene.precomputedBLASes) {
+            for(const auto& [primitiveAndGroup, blas] : blasesOfNode) {
+                sortedBLASes.emplace_back(nodeKey.value, primitiveAndGroup.first, primitiveAndGroup.second, &blas);
+            }
+        }
+        std::ranges::sort(sortedBLASes);
+        std::vector<CookedBLAS> precomputedBLASes;
+        std::vector<std::uint8_t> blasBytes;
+        precomputedBLASes.reserve(sortedBLASes.size());
+        for(const auto& [nodeKey, primitiveIndex, groupIndex, pBLAS] : sortedBLASes) {
+            precomputedBLASes.emplace_back(CookedBLAS {
+                .nodeKey = nodeKey,
+                .primitiveIndex = primitiveIndex,
+                .groupIndex = groupIndex,
+                .bytes = ArrayRef { .first = blasBytes.size(), .count = static_cast<std::uint64_t>(pBLAS->blasBytes.size()) },
+            });
+            blasBytes.insert(blasBytes.end(), pBLAS->blasBytes.cdata(), pBLAS->blasBytes.cdata() + pBLAS->blasBytes.size());
+        }
+
+        // arrays which meshoptimizer knows how to compress. Everything else is small, or not compressed well by its codecs
+        const CMODELEncoding vertexEncoding = options.compress ? CMODELEncoding::MeshoptVertices : CMODELEncoding::None;
+        const CMODELEncoding triangleEncoding = options.compress ? CMODELEncoding::MeshoptTriangles : CMODELEncoding::None;
+        const CMODELEncoding indexSequenceEncoding = options.compress ? CMODELEncoding::MeshoptIndexSequence : CMODELEncoding::None;
+
+        CMODELHeader header;
+        std::vector<std::uint8_t> fileContents(sizeof(header), 0);
+        writeSection(fileContents, header, CMODELSection::SceneInfo, std::span<const CookedSceneInfo> { &sceneInfo, 1 });
+        writeSection(fileContents, header, CMODELSection::Strings, std::span<const char> { strings });
+        writeSection(fileContents, header, CMODELSection::Materials, std::span<const CookedMaterial> { materials });
+        writeSection(fileContents, header, CMODELSection::Primitives, std::span<const CookedPrimitive> { primitives });
+        writeSection(fileContents, header, CMODELSection::Vertices, std::span<const Carrot::Vertex> { vertices }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::SkinnedVertices, std::span<const Carrot::SkinnedVertex> { skinnedVertices }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::QuantizedVertices, std::span<const VertexQuantization::QuantizedVertex> { quantizedVertices }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::QuantizedSkinnedVertices, std::span<const VertexQuantization::QuantizedSkinnedVertex> { quantizedSkinnedVertices }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::Indices, std::span<const std::uint32_t> { indices }, triangleEncoding);
+        writeSection(fileContents, header, CMODELSection::MeshletVertexIndices, std::span<const std::uint32_t> { meshletVertexIndices }, indexSequenceEncoding);
+        writeSection(fileContents, header, CMODELSection::MeshletIndices, std::span<const std::uint32_t> { meshletIndices }, triangleEncoding);
+        writeSection(fileContents, header, CMODELSection::Meshlets, std::span<const Meshlet> { meshlets }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::Nodes, std::span<const CookedNode> { nodes });
+        writeSection(fileContents, header, CMODELSection::NodeMeshIndices, std::span<const std::uint32_t> { nodeMeshIndices });
+        writeSection(fileContents, header, CMODELSection::BoneMappings, std::span<const CookedBoneMapping> { boneMappings });
+        writeSection(fileContents, header, CMODELSection::OffsetMatrices, std::span<const CookedOffsetMatrix> { offsetMatrices });
+        writeSection(fileContents, header, CMODELSection::Animations, std::span<const CookedAnimation> { animations });
+        writeSection(fileContents, header, CMODELSection::AnimationMapping, std::span<const CookedAnimationName> { animationMapping });
+        writeSection(fileContents, header, CMODELSection::Keyframes, std::span<const CookedKeyframe> { keyframes });
+        writeSection(fileContents, header, CMODELSection::BoneTransforms, std::span<const glm::mat4> { boneTransforms }, vertexEncoding);
+        writeSection(fileContents, header, CMODELSection::PrecomputedBLASes, std::span<const CookedBLAS> { precomputedBLASes });
+        writeSection(fileContents, header, CMODELSection::BLASBytes, std::span<const std::uint8_t> { blasBytes });
+        std::memcpy(fileContents.data(), &header, sizeof(header));
+        return fileContents;
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "LoadedScene.h"
+#include "core/io/Resource.h"
+
+/**
+ * Cooked models (.cmodel) are LoadedScenes written by Fertilizer in their in-memory layout: a header with a section
+ * table, followed by 16-byte aligned arrays (vertices, indices, meshlets, nodes, animations, precomputed BLASes, ...).
+ * Loading one maps the file and copies each array with a single memcpy, there is no per-element parsing.
+ * Large arrays can be compressed with the vertex and index codecs of meshoptimizer (decoded at several GB/s), and
+ * vertices can be quantized (see VertexQuantization.h), in which case they are expanded back to Carrot::Vertex on load.
+ */
+namespace Carrot::Render {
+    struct CookedModelOptions {
+        /// Store vertices as VertexQuantization::QuantizedVertex (24 bytes instead of 80). Lossy
+        bool quantizeVertices = false;
+
+        /// Compress vertices, indices, meshlets and animations with meshoptimizer. Lossless
+        bool compress = false;
+    };
+
+    class CookedModelLoader {
+    public:
+        /// Loads a .cmodel file. Files are memory mapped, in-memory resources are read once
+        LoadedScene load(const Carrot::IO::Resource& resource);
+
+        /**
+         * Loads a cooked model from its contents. Throws std::invalid_argument if the contents are not a valid cooked model
+         * \param modelFilepath path of the model, texture paths are relative to it
+         * \param fileName used for error messages
+         */
+        LoadedScene load(std::span<const std::uint8_t> fileContents, const IO::VFS::Path& modelFilepath, const char* fileName);
+    };
+
+    /// Serializes 'scene' to the .cmodel format. The same scene and options always give the same bytes
+    std::vector<std::uint8_t> writeAsCookedModel(const LoadedScene& scene, const CookedModelOptions& options = {});
+}
@@ -0,0 +1,767 @@
+//
+// Created by jglrxavpok on 27/01/2022.
+//
+
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <core/async/OSThreads.h>
+#include <core/utils/Profiling.h>
+#include <core/utils/stringmanip.h>
+#include "core/io/Logging.hpp"
+
+static std::atomic<std::int64_t> TaskScheduledThisFrameCount{0};
+static std::atomic<std::int64_t> TaskDataCreatedThisFrameCount{0};
+static std::atomic<std::int64_t> TaskDataCreatedCount{0};
+static std::atomic<std::int64_t> AliveTaskDataCount{0};
+static std::atomic<std::int64_t> ActiveTaskCount{0};
+static std::atomic<std::int64_t> FiberCreatedCount{0};
+static std::atomic<std::int64_t> TaskStolenThisFrameCount{0};
+static std::atomic<std::int64_t> LeafTaskScheduledThisFrameCount{0};
+static std::atomic<std::int64_t> TaskCompletedThisFrameCount{0};
+static std::atomic<std::int64_t> FiberStackBytes{0};
+
+namespace Carrot {
+    Async::TaskLane TaskScheduler::FrameParallelWork;
+    Async::TaskLane TaskScheduler::AssetLoading;
+    Async::TaskLane TaskScheduler::MainLoop;
+    Async::TaskLane TaskScheduler::Rendering;
+
+    struct FiberLocalStorage {
+        TaskData* taskData = nullptr;
+        std::string* fiberTracyID = nullptr; //< unique ID for Tracy. Allocated once and never deleted, because it may need to survive past 'main' !
+        bool isFullyInit = false;
+        bool tracyEnteredFiber = false;
+    };
+
+    static_assert(sizeof(FiberLocalStorage) <= sizeof(Cider::FiberHandle::localStorage));
+
+    /// Identifies the worker running on the current thread, if any
+    struct WorkerContext {
+        TaskScheduler* pScheduler = nullptr;
+        std::size_t laneIndex = 0;
+        std::size_t workerIndex = 0;
+        std::uint32_t randomState = 0x9E3779B9u; //< to select victims when stealing
+    };
+
+    static thread_local WorkerContext CurrentWorker;
+
+    /// xorshift32, good enough to spread steal attempts over workers
+    static std::uint32_t nextRandom(std::uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    static TaskData& getTaskData(Cider::FiberHandle& fiberHandle) {
+        auto* fls = (FiberLocalStorage*) &fiberHandle.localStorage[0];
+        return *fls->taskData;
+    }
+
+    TaskData::TaskData(TaskStackSize stackSizeClass)
+    : QueuedTask(false)
+    , stackSizeClass(stackSizeClass)
+    , stack(TaskScheduler::getStackBytes(stackSizeClass)) {
+        AliveTaskDataCount++;
+        TaskDataCreatedCount++;
+        TaskDataCreatedThisFrameCount++;
+    }
+
+    TaskData::~TaskData() {
+        AliveTaskDataCount--;
+    }
+
+    void TaskHandle::changeLane(const Async::TaskLane& resumeOn) {
+        taskData.wantedLane = resumeOn;
+        fiberHandle.yieldOnTop([this]() {
+            taskData.pScheduler->enqueue(taskData);
+        });
+    }
+
+    void TaskHandle::yield() {
+        fiberHandle.yieldOnTop([this]() {
+            taskData.pScheduler->enqueue(taskData, true);
+        });
+    }
+
+    void TaskHandle::wait(Async::Counter& counter) {
+        counter.wait(*this);
+    }
+
+    Cider::FiberHandle& TaskHandle::getFiberHandle() {
+        return fiberHandle;
+    }
+
+    TaskHandle::operator Cider::FiberHandle&() {
+        return getFiberHandle();
+    }
+
+    const Async::TaskLane& TaskHandle::getCurrentLane() {
+        return taskData.currentLane;
+    }
+
+    TaskHandle::TaskHandle(Cider::FiberHandle& fiberHandle, TaskData& selfData)
+    : fiberHandle(fiberHandle)
+    , taskData(selfData) {
+    }
+
+    std::size_t TaskScheduler::frameParallelWorkParallelismAmount() {
+        // reduce CPU load by using less threads
+        return std::thread::hardware_concurrency() - 1 /* main thread */;
+    }
+
+    std::size_t TaskScheduler::assetLoadingParallelismAmount() {
+        // reduce CPU load by using less threads
+        return std::thread::hardware_concurrency()/2 - 1 /* main thread */;
+    }
+
+    /// Scheduler used by Carrot::Async::parallelFor, see TaskScheduler::bindAsyncParallelFor
+    static std::atomic<TaskScheduler*> AsyncParallelForScheduler { nullptr };
+
+    /// How long scheduling sleeps waiting for a fiber to be released once the stack memory budget is reached
+    static constexpr std::chrono::milliseconds MaxWaitForFiber { 50 };
+
+    static TaskStackSize getDefaultStackSize(const Async::TaskLane& lane) {
+        return lane == TaskScheduler::AssetLoading ? TaskStackSize::Large : TaskStackSize::Medium;
+    }
+
+    TaskScheduler::TaskScheduler(const TaskSchedulerConfig& config)
+    : queueing(config.queueing)
+    , fiberStackMemoryBudget(config.fiberStackMemoryBudget) {
+        Cider::Fiber::OnFiberEnter = [](Cider::Fiber* fiber) {
+            auto* fls = (FiberLocalStorage*) &fiber->getHandlePtr()->localStorage[0];
+            if(fls && fls->isFullyInit) {
+                fls->tracyEnteredFiber = true;
+                TracyFiberEnter(fls->fiberTracyID->c_str());
+            }
+        };
+        Cider::Fiber::OnFiberExit = [](Cider::Fiber* fiber) {
+            auto* fls = (FiberLocalStorage*) &fiber->getHandlePtr()->localStorage[0];
+            if(fls && fls->tracyEnteredFiber) {
+                TracyFiberLeave;
+            }
+        };
+
+        const std::size_t inFrameCount = config.frameParallelWorkThreads.value_or(frameParallelWorkParallelismAmount());
+        const std::size_t asyncCount = config.assetLoadingThreads.value_or(assetLoadingParallelismAmount());
+        const std::size_t frameLaneIndex = getLaneIndex(FrameParallelWork);
+        const std::size_t asyncLaneIndex = getLaneIndex(AssetLoading);
+
+        // all workers must exist before any thread starts, because threads steal from each other
+        for (std::size_t i = 0; i < inFrameCount; i++) {
+            lanes[frameLaneIndex].workers.emplace_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < asyncCount; i++) {
+            lanes[asyncLaneIndex].workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        const ThreadInitCallback threadInit = config.threadInit;
+        std::size_t availableThreads = inFrameCount + asyncCount;
+        parallelThreads.resize(availableThreads);
+        for (std::size_t i = 0; i < availableThreads; i++) {
+            bool isInFrame = i < inFrameCount;
+            const std::size_t laneIndex = isInFrame ? frameLaneIndex : asyncLaneIndex;
+            const std::size_t workerIndex = isInFrame ? i : i - inFrameCount;
+            const Async::TaskLane& lane = isInFrame ? FrameParallelWork : AssetLoading;
+            parallelThreads[i] = std::thread([threadInit, &lane, laneIndex, workerIndex, this]() {
+                if(threadInit) {
+                    threadInit(lane, workerIndex);
+                }
+                threadProc(laneIndex, workerIndex);
+            });
+            Carrot::Threads::setName(parallelThreads[i], Carrot::sprintf("%sTask#%d", isInFrame ? "Frame" : "Async", static_cast<int>(workerIndex + 1)));
+        }
+    }
+
+    TaskScheduler::~TaskScheduler() {
+        TaskScheduler* pThis = this;
+        if(AsyncParallelForScheduler.compare_exchange_strong(pThis, nullptr)) {
+            Carrot::Async::parallelFor = nullptr;
+        }
+
+        running = false;
+        for (auto& lane : lanes) {
+            lane.wakeUp.signal(static_cast<std::ptrdiff_t>(lane.workers.size()));
+        }
+        for (auto& t : parallelThreads) {
+            t.join();
+        }
+    }
+
+    std::size_t TaskScheduler::getLaneIndex(const Async::TaskLane& lane) {
+        if(lane == FrameParallelWork) {
+            return 0;
+        }
+        if(lane == AssetLoading) {
+            return 1;
+        }
+        if(lane == MainLoop) {
+            return 2;
+        }
+        verify(lane == Rendering, "No other lanes supported at the moment");
+        return 3;
+    }
+
+    std::uint64_t TaskScheduler::getStolenTaskCount() const {
+        return stolenTaskCount.load(std::memory_order_relaxed);
+    }
+
+    void TaskScheduler::bindAsyncParallelFor() {
+        AsyncParallelForScheduler = this;
+        Carrot::Async::parallelFor = [](std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity) {
+            AsyncParallelForScheduler.load()->parallelFor(count, forEach, granularity);
+        };
+    }
+
+    TaskSchedulerStats TaskScheduler::collectFrameStats() {
+        static std::chrono::steady_clock::time_point lastCollection = std::chrono::steady_clock::now();
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsedSeconds = std::chrono::duration<double>(now - lastCollection).count();
+        lastCollection = now;
+
+        const std::int64_t completedTasks = TaskCompletedThisFrameCount.exchange(0);
+        return TaskSchedulerStats {
+            .activeTasks = ActiveTaskCount.load(),
+            .aliveTaskData = AliveTaskDataCount.load(),
+            .totalTaskDataCreated = TaskDataCreatedCount.load(),
+            .fibersCreated = FiberCreatedCount.load(),
+            .fiberStackBytes = FiberStackBytes.load(),
+            .tasksScheduledThisFrame = TaskScheduledThisFrameCount.exchange(0),
+            .leafTasksScheduledThisFrame = LeafTaskScheduledThisFrameCount.exchange(0),
+            .taskDataCreatedThisFrame = TaskDataCreatedThisFrameCount.exchange(0),
+            .tasksStolenThisFrame = TaskStolenThisFrameCount.exchange(0),
+            .tasksCompletedThisFrame = completedTasks,
+            .tasksCompletedPerSecond = elapsedSeconds > 0.0 ? static_cast<double>(completedTasks) / elapsedSeconds : 0.0,
+        };
+    }
+
+    std::size_t TaskScheduler::getStackBytes(TaskStackSize stackSize) {
+        switch(stackSize) {
+            case TaskStackSize::Small:
+                return 256 * 1024;
+            case TaskStackSize::Medium:
+                return 4 * 1024 * 1024;
+            case TaskStackSize::Large:
+                return 64 * 1024 * 1024;
+        }
+        verify(false, "Unknown stack size");
+        return 0;
+    }
+
+    TaskData* TaskScheduler::acquireTaskData(TaskStackSize stackSize) {
+        ZoneScoped;
+        auto& pool = reusableTaskData[static_cast<std::size_t>(stackSize)];
+        const std::size_t stackBytes = getStackBytes(stackSize);
+        const auto waitEnd = std::chrono::steady_clock::now() + MaxWaitForFiber;
+        while(true) {
+            TaskData* pTaskData = nullptr;
+            if(pool.try_dequeue(pTaskData)) {
+                return pTaskData;
+            }
+
+            if(tryReserveStackMemory(stackBytes)) {
+                return createTaskData(stackSize);
+            }
+
+            if(releaseIdleTaskData(stackSize)) {
+                continue; // try again with the freed memory
+            }
+
+            // sleep until a fiber of this size is done with its task (see makeReusable)
+            bool released;
+            threadsWaitingForTaskData.fetch_add(1);
+            {
+                std::unique_lock l { taskDataReleaseMutex };
+                released = taskDataReleased.wait_until(l, waitEnd, [&]() {
+                    return pool.size_approx() > 0;
+                });
+            }
+            threadsWaitingForTaskData.fetch_sub(1);
+            if(released) {
+                continue;
+            }
+
+            // better to go over budget than to deadlock
+            if(!budgetWarningLogged.exchange(true)) {
+                Carrot::Log::warn("Fiber stack memory budget (%llu bytes) exceeded, consider increasing it", (unsigned long long)fiberStackMemoryBudget);
+            }
+            reservedStackMemory += stackBytes;
+            return createTaskData(stackSize);
+        }
+    }
+
+    void TaskScheduler::makeReusable(TaskData& task) {
+        reusableTaskData[static_cast<std::size_t>(task.stackSizeClass)].enqueue(&task);
+
+        // pairs with the increment in acquireTaskData: either the waiting thread sees the TaskData, or we see the waiting thread
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(threadsWaitingForTaskData.load() > 0) {
+            {
+                // makes sure the waiting thread is either before its check, or already sleeping
+                std::lock_guard l { taskDataReleaseMutex };
+            }
+            taskDataReleased.notify_all();
+        }
+    }
+
+    bool TaskScheduler::tryReserveStackMemory(std::size_t bytes) {
+        std::size_t reserved = reservedStackMemory.load();
+        do {
+            if(reserved + bytes > fiberStackMemoryBudget) {
+                return false;
+            }
+        } while(!reservedStackMemory.compare_exchange_weak(reserved, reserved + bytes));
+        return true;
+    }
+
+    bool TaskScheduler::releaseIdleTaskData(TaskStackSize wanted) {
+        // largest stacks first, they free the most memory
+        for(std::size_t i = StackSizeCount; i > 0; i--) {
+            const std::size_t sizeIndex = i - 1;
+            if(sizeIndex == static_cast<std::size_t>(wanted)) {
+                continue;
+            }
+
+            TaskData* pIdle = nullptr;
+            if(!reusableTaskData[sizeIndex].try_dequeue(pIdle)) {
+                continue;
+            }
+
+            // the fiber is suspended inside its reuse loop and will never be resumed, it can be destroyed safely
+            const std::size_t stackBytes = getStackBytes(pIdle->stackSizeClass);
+            {
+                std::lock_guard l { ownershipMutex };
+                auto it = std::find_if(allTaskData.begin(), allTaskData.end(), [&](const std::unique_ptr<TaskData>& p) {
+                    return p.get() == pIdle;
+                });
+                verify(it != allTaskData.end(), "Idle TaskData is not owned by this scheduler");
+                std::swap(*it, allTaskData.back());
+                allTaskData.pop_back();
+            }
+            FiberStackBytes -= static_cast<std::int64_t>(stackBytes);
+            reservedStackMemory -= stackBytes;
+            return true;
+        }
+        return false;
+    }
+
+    TaskData* TaskScheduler::createTaskData(TaskStackSize stackSize) {
+        ZoneScoped;
+        std::unique_ptr<TaskData> pOwnedTaskData;
+        {
+            ZoneScopedN("allocate TaskData");
+            pOwnedTaskData = std::make_unique<TaskData>(stackSize);
+        }
+        TaskData* pTaskData = pOwnedTaskData.get();
+        FiberStackBytes += static_cast<std::int64_t>(getStackBytes(stackSize));
+
+        std::string* pTracyID = new std::string{Carrot::sprintf("Fiber %lld", FiberCreatedCount++)};
+        auto fiberProc = [pTracyID, pTaskData, pTaskScheduler = this](Cider::FiberHandle& fiber) {
+            {
+                struct Data {
+                    TaskData* pTask = nullptr;
+                    TaskScheduler* pTaskScheduler = nullptr;
+                };
+                Data data {
+                        .pTask = pTaskData,
+                        .pTaskScheduler = pTaskScheduler
+                };
+
+                auto* fls = (FiberLocalStorage*) &fiber.localStorage[0];
+                fls->fiberTracyID = pTracyID;
+                fls->isFullyInit = true;
+
+                while(true) {
+                    // yield this fiber, and sets up task data for reuse
+                    fiber.yieldOnTop([](void* pUserData) {
+                        Data* pData = (Data*)pUserData;
+                        pData->pTaskScheduler->makeReusable(*pData->pTask);
+                    }, &data);
+                }
+            }
+            verify(false, "Reached bottom of fiber used for tasks, should not happen!");
+        };
+        pTaskData->fiber = std::make_unique<Cider::Fiber>(std::move(fiberProc), pTaskData->stack.asSpan(), fiberScheduler);
+
+        std::lock_guard l { ownershipMutex };
+        allTaskData.emplace_back(std::move(pOwnedTaskData));
+        return pTaskData;
+    }
+
+    LeafTaskData* TaskScheduler::acquireLeafTaskData() {
+        LeafTaskData* pTaskData = nullptr;
+        if(reusableLeafTaskData.try_dequeue(pTaskData)) {
+            return pTaskData;
+        }
+
+        std::lock_guard l { ownershipMutex };
+        return allLeafTaskData.emplace_back(std::make_unique<LeafTaskData>()).get();
+    }
+
+    void TaskScheduler::enqueue(TaskData& task, bool isYield) {
+        const std::size_t laneIndex = getLaneIndex(task.wantedLane);
+        Lane& lane = lanes[laneIndex];
+
+        const bool isWorkerOfLane = CurrentWorker.pScheduler == this && CurrentWorker.laneIndex == laneIndex;
+        const bool hasAffinity = task.affinityWorker >= 0 && task.currentLane == task.wantedLane;
+        if(queueing == TaskQueueing::SharedQueue || isYield) {
+            lane.sharedQueue.enqueue(&task);
+        } else if(hasAffinity && !(isWorkerOfLane && CurrentWorker.workerIndex == static_cast<std::size_t>(task.affinityWorker))) {
+            // woken up from another thread: go back to the thread which last ran this task, its caches are probably still warm
+            lane.workers[task.affinityWorker]->mailbox.enqueue(&task);
+        } else if(isWorkerOfLane) {
+            lane.workers[CurrentWorker.workerIndex]->deque.push(&task);
+        } else {
+            lane.sharedQueue.enqueue(&task);
+        }
+
+        // pairs with the fence in runSingleTask: either the worker sees the new task, or we see the sleeping worker
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(lane.sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+            lane.wakeUp.signal();
+        }
+    }
+
+    void TaskScheduler::enqueueLeaf(LeafTaskData& task, std::size_t laneIndex) {
+        Lane& lane = lanes[laneIndex];
+
+        // leaf tasks never resume, so there is no affinity to respect
+        const bool isWorkerOfLane = CurrentWorker.pScheduler == this && CurrentWorker.laneIndex == laneIndex;
+        if(queueing == TaskQueueing::WorkStealing && isWorkerOfLane) {
+            lane.workers[CurrentWorker.workerIndex]->deque.push(&task);
+        } else {
+            lane.sharedQueue.enqueue(&task);
+        }
+
+        // see enqueue
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(lane.sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+            lane.wakeUp.signal();
+        }
+    }
+
+    QueuedTask* TaskScheduler::findTask(std::size_t laneIndex) {
+        Lane& lane = lanes[laneIndex];
+        QueuedTask* pTask = nullptr;
+
+        const bool isWorkerOfLane = CurrentWorker.pScheduler == this && CurrentWorker.laneIndex == laneIndex;
+        if(isWorkerOfLane) {
+            Worker& self = *lane.workers[CurrentWorker.workerIndex];
+            if(self.mailbox.try_dequeue(pTask)) {
+                return pTask;
+            }
+            if(std::optional<QueuedTask*> ownTask = self.deque.pop()) {
+                return *ownTask;
+            }
+        }
+
+        if(lane.sharedQueue.try_dequeue(pTask)) {
+            return pTask;
+        }
+
+        const std::size_t workerCount = lane.workers.size();
+        if(workerCount == 0) {
+            return nullptr;
+        }
+
+        // steal, starting from a random victim to avoid all thieves hammering the same worker
+        const std::size_t firstVictim = nextRandom(CurrentWorker.randomState) % workerCount;
+        for(std::size_t i = 0; i < workerCount; i++) {
+            const std::size_t victim = (firstVictim + i) % workerCount;
+            if(isWorkerOfLane && victim == CurrentWorker.workerIndex) {
+                continue;
+            }
+            if(std::optional<QueuedTask*> stolenTask = lane.workers[victim]->deque.steal()) {
+                stolenTaskCount.fetch_add(1, std::memory_order_relaxed);
+                TaskStolenThisFrameCount++;
+                return *stolenTask;
+            }
+        }
+
+        // last resort: tasks waiting for a worker which is busy
+        for(std::size_t i = 0; i < workerCount; i++) {
+            const std::size_t victim = (firstVictim + i) % workerCount;
+            if(lane.workers[victim]->mailbox.try_dequeue(pTask)) {
+                return pTask;
+            }
+        }
+        return nullptr;
+    }
+
+    bool TaskScheduler::runSingleTask(Async::TaskLane localLane, bool allowBlocking) {
+        const std::size_t laneIndex = getLaneIndex(localLane);
+        QueuedTask* toRun = findTask(laneIndex);
+        if(!toRun && allowBlocking) {
+            Lane& lane = lanes[laneIndex];
+            lane.sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            toRun = findTask(laneIndex);
+            if(!toRun) {
+                lane.wakeUp.wait(1'000'000); // with timeout to handle shutdown of game
+                toRun = findTask(laneIndex);
+            }
+            lane.sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if(!toRun) {
+            return false;
+        }
+        if(toRun->isLeaf) {
+            runLeafTask(static_cast<LeafTaskData&>(*toRun));
+        } else {
+            runFiberTask(static_cast<TaskData&>(*toRun), localLane, laneIndex);
+        }
+        return true;
+    }
+
+    void TaskScheduler::runFiberTask(TaskData& toRun, const Async::TaskLane& localLane, std::size_t laneIndex) {
+        ZoneScopedN("Run task");
+        ZoneText(toRun.name.c_str(), toRun.name.size());
+        try {
+            const bool isWorkerOfLane = CurrentWorker.pScheduler == this && CurrentWorker.laneIndex == laneIndex;
+            toRun.currentLane = localLane;
+            toRun.affinityWorker = isWorkerOfLane ? static_cast<std::int32_t>(CurrentWorker.workerIndex) : -1;
+
+            // lane changes are handled by TaskHandle::changeLane, once the fiber is no longer running
+            toRun.fiber->switchTo();
+        } catch (const std::exception& e) {
+            // don't crash thread if a task fails
+            Carrot::Log::error("Error while executing scheduled task '%s': %s", toRun.name.c_str(), e.what());
+        }
+    }
+
+    void TaskScheduler::runLeafTask(LeafTaskData& toRun) {
+        ZoneScopedN("Run leaf task");
+        ZoneText(toRun.name, strlen(toRun.name));
+        ActiveTaskCount++;
+        try {
+            toRun.task();
+        } catch (const std::exception& e) {
+            // don't crash thread if a task fails
+            Carrot::Log::error("Error while executing scheduled task '%s': %s", toRun.name, e.what());
+        }
+        ActiveTaskCount--;
+        TaskCompletedThisFrameCount++;
+
+        Async::Counter* pJoiner = toRun.joiner;
+        toRun.task = nullptr; // release captures as soon as possible
+        toRun.joiner = nullptr;
+        reusableLeafTaskData.enqueue(&toRun);
+        if(pJoiner) {
+            pJoiner->decrement();
+        }
+    }
+
+    void TaskScheduler::threadProc(std::size_t laneIndex, std::size_t workerIndex) {
+        CurrentWorker.pScheduler = this;
+        CurrentWorker.laneIndex = laneIndex;
+        CurrentWorker.workerIndex = workerIndex;
+        CurrentWorker.randomState = static_cast<std::uint32_t>(workerIndex * 0x9E3779B9u + laneIndex + 1);
+
+        const Async::TaskLane& lane = laneIndex == getLaneIndex(FrameParallelWork) ? FrameParallelWork : AssetLoading;
+        while(running) {
+            runSingleTask(lane, true);
+        }
+    }
+
+    void TaskScheduler::executeMainLoop() {
+        runSingleTask(TaskScheduler::MainLoop, false);
+    }
+
+    void TaskScheduler::executeRendering() {
+        runSingleTask(TaskScheduler::Rendering, false);
+    }
+
+    bool TaskScheduler::stealJobAndRun(const Async::TaskLane& lane) {
+        return runSingleTask(lane, false);
+    }
+
+
+    void TaskScheduler::parallelFor(std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity) {
+        if(count == 0) {
+            return;
+        }
+
+        verify(granularity > 0, "Cannot have a granularity of 0");
+
+        auto run = [&](std::size_t startIndex) {
+            for(std::size_t i = startIndex; i < startIndex + granularity && i < count; i++) {
+                forEach(i);
+            }
+        };
+
+        if(queueing == TaskQueueing::SharedQueue) {
+            // one task per chunk
+            std::size_t parallelJobs = count / granularity; // truncate on purpose, the calling thread will participate
+            if(parallelJobs > 0) {
+                Async::Counter sync;
+                for(std::size_t jobIndex = 0; jobIndex < parallelJobs; jobIndex++) {
+                    schedule(TaskDescription {
+                            .name = "Parallel ForEach",
+                            .task = [&, jobIndex](Carrot::TaskHandle&) {
+                                std::size_t startIndex = jobIndex * granularity;
+                                run(startIndex);
+                            },
+                            .joiner = &sync,
+                    }, FrameParallelWork);
+                }
+
+                run(parallelJobs * granularity);
+                while(!sync.isIdle()) {
+                    stealJobAndRun(FrameParallelWork);
+                }
+            } else {
+                run(0);
+            }
+            return;
+        }
+
+        // at most one task per worker, each task (and the calling thread) grabs chunks until there are none left:
+        // much less tasks to schedule, and threads which are late to the party simply find nothing to do
+        const std::size_t chunkCount = (count + granularity - 1) / granularity;
+        if(chunkCount <= 1) {
+            run(0);
+            return;
+        }
+
+        std::atomic<std::size_t> nextChunk { 0 };
+        auto runChunks = [&]() {
+            while(true) {
+                const std::size_t chunkIndex = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunkIndex >= chunkCount) {
+                    break;
+                }
+                run(chunkIndex * granularity);
+            }
+        };
+
+        const std::size_t helperCount = std::min(chunkCount - 1, lanes[getLaneIndex(FrameParallelWork)].workers.size());
+        Async::Counter sync;
+        for(std::size_t helperIndex = 0; helperIndex < helperCount; helperIndex++) {
+            // helpers never yield, no need for a fiber
+            scheduleLeaf(LeafTaskDescription {
+                    .name = "Parallel ForEach",
+                    .task = [&]() {
+                        runChunks();
+                    },
+                    .joiner = &sync,
+            }, FrameParallelWork);
+        }
+
+        runChunks();
+        while(!sync.isIdle()) {
+            stealJobAndRun(FrameParallelWork);
+        }
+    }
+
+    Carrot::Vector<std::thread::id> TaskScheduler::getParallelThreadIDs() const {
+        Carrot::Vector<std::thread::id> result;
+        result.resize(parallelThreads.size());
+        for(std::size_t i = 0; i < result.size(); i++) {
+            result[i] = parallelThreads[i].get_id();
+        }
+        return result;
+    }
+
+    void TaskScheduler::schedule(TaskDescription&& description, const Async::TaskLane& lane) {
+        ZoneScoped;
+        getLaneIndex(lane); // verifies the lane is supported
+        verify(description.task, "No valid task");
+        TaskScheduledThisFrameCount++;
+        if(description.joiner) {
+            description.joiner->increment();
+        }
+
+        TaskData* pNewTask = acquireTaskData(description.stackSize.value_or(getDefaultStackSize(lane)));
+        pNewTask->pScheduler = this;
+        pNewTask->affinityWorker = -1;
+        pNewTask->wantedLane = lane;
+        pNewTask->currentLane = lane;
+        pNewTask->name = std::move(description.name);
+        pNewTask->dependency = description.dependency;
+        pNewTask->joiner = description.joiner;
+        pNewTask->task = std::move(description.task);
+
+        {
+            auto fiberProc = [](Cider::FiberHandle& fiber, void* pTaskRef) {
+                TracyCZoneN(newZone, "fiberProc", true);
+
+                const char name[] = "fiberProc";
+                TracyCZoneName(newZone, name, strlen(name));
+
+                TaskData* pTask = static_cast<TaskData*>(pTaskRef);
+
+                // fiber prolog
+                TaskHandle taskHandle { fiber, *pTask };
+
+                auto* fls = (FiberLocalStorage*) &fiber.localStorage[0];
+                fls->taskData = pTask;
+
+                ActiveTaskCount++;
+
+                TracyCZoneEnd(newZone);
+
+                if(pTask->dependency) {
+                    taskHandle.wait(*pTask->dependency);
+                } else {
+                    fiber.yield();
+                }
+
+                // execute task
+                pTask->task(taskHandle);
+                pTask->task = nullptr; // release captures as soon as possible
+                if(pTask->joiner) {
+                    pTask->joiner->decrement();
+                }
+
+                ActiveTaskCount--;
+                TaskCompletedThisFrameCount++;
+            };
+            {
+                ZoneScopedN("Fiber start");
+                pNewTask->fiber->switchToWithOnTop(fiberProc, pNewTask); // execute prolog
+            }
+
+            // if task is not waiting on something, start it
+            if(!pNewTask->dependency) {
+                ZoneScopedN("Push task description to queue");
+                enqueue(*pNewTask);
+            }
+        }
+    }
+
+    void TaskScheduler::scheduleLeaf(LeafTaskDescription&& description, const Async::TaskLane& lane) {
+        ZoneScoped;
+        const std::size_t laneIndex = getLaneIndex(lane);
+        verify(description.task, "No valid task");
+        verify(description.name, "Leaf tasks must have a name");
+        TaskScheduledThisFrameCount++;
+        LeafTaskScheduledThisFrameCount++;
+        if(description.joiner) {
+            description.joiner->increment();
+        }
+
+        LeafTaskData* pNewTask = acquireLeafTaskData();
+        pNewTask->name = description.name;
+        pNewTask->task = std::move(description.task);
+        pNewTask->joiner = description.joiner;
+        enqueueLeaf(*pNewTask, laneIndex);
+    }
+
+    void TaskScheduler::FiberScheduler::schedule(Cider::FiberHandle& toSchedule) {
+        auto& taskData = getTaskData(toSchedule);
+        taskScheduler.enqueue(taskData);
+    }
+
+    void TaskScheduler::FiberScheduler::schedule(Cider::FiberHandle& toSchedule, Cider::Proc proc, void *userData) {
+        schedule(toSchedule);
+        proc(userData);
+    }
+
+    void TaskScheduler::FiberScheduler::schedule(Cider::FiberHandle& toSchedule, const Cider::StdFunctionProc& proc) {
+        schedule(toSchedule);
+        proc();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+//
+// Created by jglrxavpok on 27/01/2022.
+//
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <core/ThreadSafeQueue.hpp>
+#include <core/async/Counter.h>
+#include <core/async/WorkStealingDeque.hpp>
+#include <core/data/Hashes.h>
+#include <core/functional/InlineFunction.hpp>
+#include <core/tasks/Tasks.h>
+#include <cider/Fiber.h>
+#include <cider/GrowingStack.h>
+#include <cider/scheduling/Scheduler.h>
+#include <concurrentqueue.h>
+#include <blockingconcurrentqueue.h>
+#include <core/containers/Vector.hpp>
+
+namespace Carrot {
+    struct TaskData;
+    class TaskHandle;
+    class TaskScheduler;
+
+    /// Closures of tasks are stored inline inside the task when small enough, to avoid heap allocations when scheduling
+    using TaskProc = InlineFunction<void(TaskHandle&)>;
+    using LeafTaskProc = InlineFunction<void()>;
+
+    /**
+     * If this is an argument of a function, it most often means that the function is expected to be called from a task,
+     * executing on a fiber, scheduled via the TaskScheduler.
+     * It also means that the function very probably yields the current fiber.
+     */
+    class TaskHandle {
+    public:
+        /**
+         * Change task lane where this task is executed.
+         * Does nothing
+         * @param resumeOn
+         */
+        void changeLane(const Async::TaskLane& resumeOn);
+
+        /**
+         * Yield this task and reschedule it to be re-executed later (allows other tasks to progress)
+         */
+        void yield();
+
+        /**
+         * Wait for the counter to reach 0, by yielding. Does nothing if the counter is already at 0
+         * @param counter
+         */
+        void wait(Async::Counter& counter);
+
+        /**
+         * Gets the underlying fiber handle. Use only if you know what you are doing.
+         */
+        Cider::FiberHandle& getFiberHandle();
+
+        /**
+         * Implicit conversion to FiberHandle, intended for usage with locks and other synchronisation primitives from Cider
+         */
+        operator Cider::FiberHandle&();
+
+        /**
+         * Which lane is this task currently running on?
+         */
+        const Async::TaskLane& getCurrentLane();
+
+    private:
+        explicit TaskHandle(Cider::FiberHandle& fiberHandle, TaskData& selfData);
+
+        Cider::FiberHandle& fiberHandle;
+        TaskData& taskData;
+
+        friend class TaskScheduler;
+    };
+
+    /// Size of the stack reserved for a task running on a fiber
+    enum class TaskStackSize {
+        Small, //< 256 KiB, for tasks which do not call deep into other systems
+        Medium, //< 4 MiB, default for tasks of the FrameParallelWork, MainLoop and Rendering lanes
+        Large, //< 64 MiB, default for tasks of the AssetLoading lane (loaders can recurse deeply)
+    };
+
+    struct TaskDescription {
+        /// Name/Description of the task.
+        std::string name;
+
+        /// Your task to execute.
+        TaskProc task;
+
+        /// Counter to wait for before starting this task. If null, no wait is performed and the task starts as soon as
+        /// it is scheduled
+        Async::Counter* dependency = nullptr;
+
+        /// Incremented when the task is scheduled, decremented when the task is finished
+        Async::Counter* joiner = nullptr;
+
+        /// Stack to run this task on. If empty, depends on the lane the task is scheduled on
+        std::optional<TaskStackSize> stackSize;
+    };
+
+    /**
+     * Task which never yields nor waits. Leaf tasks run directly on the stack of the thread which executes them, without
+     * any fiber: they are much cheaper to schedule and run than regular tasks, and are intended for small jobs such as
+     * slices of a parallel loop.
+     * They can still schedule other tasks, or help other tasks progress (via TaskScheduler::stealJobAndRun)
+     */
+    struct LeafTaskDescription {
+        /// Name of the task, must outlive the task (string literals are fine)
+        const char* name = "Leaf task";
+
+        /// Your task to execute. Must not yield.
+        LeafTaskProc task;
+
+        /// Incremented when the task is scheduled, decremented when the task is finished
+        Async::Counter* joiner = nullptr;
+    };
+
+    /// Common part of anything that can be stored in the queues of the scheduler
+    struct QueuedTask {
+        /// true for LeafTaskData, false for TaskData
+        const bool isLeaf;
+    };
+
+    struct LeafTaskData : public QueuedTask {
+        const char* name = nullptr;
+        LeafTaskProc task;
+        Async::Counter* joiner = nullptr;
+
+        LeafTaskData(): QueuedTask(true) {}
+    };
+
+    struct TaskData : public QueuedTask, public TaskDescription {
+        const TaskStackSize stackSizeClass;
+        Cider::GrowingStack stack;
+        Async::TaskLane currentLane = Async::TaskLane::Undefined;
+        Async::TaskLane wantedLane = Async::TaskLane::Undefined;
+        std::unique_ptr<Cider::Fiber> fiber = nullptr;
+
+        TaskScheduler* pScheduler = nullptr;
+
+        /// Index of the worker (inside currentLane) which last ran this task, -1 if none.
+        /// Used to resume the task on the same thread once it is woken up.
+        std::int32_t affinityWorker = -1;
+
+        explicit TaskData(TaskStackSize stackSizeClass);
+        ~TaskData();
+    };
+
+    enum class TaskQueueing {
+        /// Each lane has a single queue shared by all its threads. Kept for comparison purposes.
+        SharedQueue,
+
+        /// Each thread has its own deque, and steals from other threads of the same lane when it runs out of work.
+        /// Tasks woken up after waiting resume on the thread which last ran them, when possible.
+        WorkStealing,
+    };
+
+    /// Called on each thread of the scheduler when it starts, before it runs any task.
+    /// Receives the lane of the thread, and the index of the thread inside this lane
+    using ThreadInitCallback = std::function<void(const Async::TaskLane& lane, std::size_t threadIndex)>;
+
+    struct TaskSchedulerConfig {
+        /// Thread count for FrameParallelWork. Defaults to TaskScheduler::frameParallelWorkParallelismAmount()
+        std::optional<std::size_t> frameParallelWorkThreads;
+
+        /// Thread count for AssetLoading. Defaults to TaskScheduler::assetLoadingParallelismAmount()
+        std::optional<std::size_t> assetLoadingThreads;
+
+        TaskQueueing queueing = TaskQueueing::WorkStealing;
+
+        /// Optional, used by the engine to make its threads capable of submitting render packets
+        ThreadInitCallback threadInit;
+
+        /// Maximum amount of stack memory reserved by the fibers of this scheduler.
+        /// Once reached, idle fibers with another stack size are released, then scheduling sleeps until a fiber becomes
+        /// available. If none is released after a short while (all fibers may be waiting on the task being scheduled),
+        /// the budget is exceeded and a warning is logged.
+        std::size_t fiberStackMemoryBudget = 16ull * 1024 * 1024 * 1024;
+    };
+
+    /// Statistics for debug display
+    struct TaskSchedulerStats {
+        std::int64_t activeTasks = 0;
+        std::int64_t aliveTaskData = 0;
+        std::int64_t totalTaskDataCreated = 0;
+        std::int64_t fibersCreated = 0;
+        std::int64_t fiberStackBytes = 0; //< reserved by alive fibers. Pages are only committed as the stacks grow
+
+        // since the previous call to TaskScheduler::collectFrameStats
+        std::int64_t tasksScheduledThisFrame = 0;
+        std::int64_t leafTasksScheduledThisFrame = 0;
+        std::int64_t taskDataCreatedThisFrame = 0;
+        std::int64_t tasksStolenThisFrame = 0;
+        std::int64_t tasksCompletedThisFrame = 0;
+        double tasksCompletedPerSecond = 0.0;
+    };
+
+    class TaskScheduler {
+    public:
+        explicit TaskScheduler(const TaskSchedulerConfig& config = {});
+        ~TaskScheduler();
+
+        /**
+         * Executes 'count' tasks in parallel, executing 'forEach' for each task.
+         * The calling thread will also participate.
+         * Waits until all tasks are done before returning
+         * @param count how many tasks to execute
+         * @param forEach what to execute for each task
+         * @param granularity how many tasks at once per thread
+         */
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)>& forEach, std::size_t granularity);
+
+        Carrot::Vector<std::thread::id> getParallelThreadIDs() const;
+
+    public: // scheduling
+        /// Schedule a task for execution. The task will be executed as soon as possible on the given lane.
+        void schedule(TaskDescription&& description, const Async::TaskLane& lane);
+
+        /// Schedule a task which never yields, see LeafTaskDescription. The task will be executed as soon as possible on the given lane.
+        void scheduleLeaf(LeafTaskDescription&& description, const Async::TaskLane& lane);
+
+        /// Schedule a task for execution. Call from the main loop
+        void executeMainLoop();
+
+        /// Schedule a task for execution. Call at the beginning of rendering
+        void executeRendering();
+
+        /// Steals a job from the given lane and runs it.
+        /// If there are no jobs to steal, does nothing and returns false
+        bool stealJobAndRun(const Async::TaskLane& lane);
+
+    public:
+        /// How many threads can we use for the task scheduler? Only count "short" tasks
+        static std::size_t frameParallelWorkParallelismAmount();
+
+        /// How many threads can we use for the task scheduler? Only count "long" tasks
+        static std::size_t assetLoadingParallelismAmount();
+
+    public:
+        /// Group of threads that run parallel to the main thread. Conceptually must be used for short tasks (that are expected to finish in the current frame)
+        static Async::TaskLane FrameParallelWork;
+
+        /// Group of threads that run parallel to the main thread. Conceptually must be used for long tasks (that are NOT expected to finish in the current frame)
+        static Async::TaskLane AssetLoading;
+
+        /// Run tasks at each iteration of the main loop
+        static Async::TaskLane MainLoop;
+
+        /// Run tasks at the beginning of each frame
+        static Async::TaskLane Rendering;
+
+    public:
+        /// Makes Carrot::Async::parallelFor run on this scheduler, until this scheduler is destroyed
+        void bindAsyncParallelFor();
+
+        /// How many tasks were stolen from another thread since the creation of this scheduler
+        std::uint64_t getStolenTaskCount() const;
+
+        /// Returns the current statistics, and resets the per-frame counters. Counters are shared by all schedulers.
+        /// Expected to be called once per frame, from a single thread
+        static TaskSchedulerStats collectFrameStats();
+
+        /// How many bytes are reserved for the stack of a fiber of the given size
+        static std::size_t getStackBytes(TaskStackSize stackSize);
+
+    private:
+        /// Gets an idle fiber of the given stack size, or creates one if the memory budget allows it
+        TaskData* acquireTaskData(TaskStackSize stackSize);
+        TaskData* createTaskData(TaskStackSize stackSize);
+        bool tryReserveStackMemory(std::size_t bytes);
+
+        /// Destroys an idle fiber with a stack size different from 'wanted', to make room in the memory budget.
+        /// Returns false if there was none
+        bool releaseIdleTaskData(TaskStackSize wanted);
+
+        /// Puts a TaskData whose task is done back into its pool, and wakes up threads waiting for one inside acquireTaskData
+        void makeReusable(TaskData& task);
+
+        LeafTaskData* acquireLeafTaskData();
+
+        /// Returns true if a task was run
+        bool runSingleTask(Async::TaskLane lane, bool allowBlocking);
+        void runFiberTask(TaskData& task, const Async::TaskLane& localLane, std::size_t laneIndex);
+        void runLeafTask(LeafTaskData& task);
+        void threadProc(std::size_t laneIndex, std::size_t workerIndex);
+
+        /// Makes the given task available for execution on its wanted lane.
+        /// 'isYield' is true if the task is voluntarily giving up its thread: in that case it goes to the back of the lane
+        void enqueue(TaskData& task, bool isYield = false);
+        void enqueueLeaf(LeafTaskData& task, std::size_t laneIndex);
+
+        /// Finds a task to run on the given lane: from the current thread's deque, then the queue shared by the lane, then
+        /// by stealing from other threads. Returns nullptr if nothing is available
+        QueuedTask* findTask(std::size_t laneIndex);
+
+        static std::size_t getLaneIndex(const Async::TaskLane& lane);
+
+    private:
+        class FiberScheduler: public Cider::Scheduler {
+        public:
+            explicit FiberScheduler(TaskScheduler& taskScheduler): taskScheduler(taskScheduler) {}
+
+            void schedule(Cider::FiberHandle& toSchedule) override final;
+
+            void schedule(Cider::FiberHandle& toSchedule, Cider::Proc proc, void *userData) override final;
+
+            void schedule(Cider::FiberHandle& toSchedule, const Cider::StdFunctionProc& proc) override final;
+
+        private:
+            TaskScheduler& taskScheduler;
+        };
+        FiberScheduler fiberScheduler { *this };
+
+        static constexpr std::size_t LaneCount = 4;
+        static constexpr std::size_t StackSizeCount = 3;
+
+        /// TaskData and LeafTaskData are owned by the scheduler (see allTaskData and allLeafTaskData), so queues can store raw pointers
+        using TaskQueue = moodycamel::ConcurrentQueue<QueuedTask*>;
+
+        struct Worker {
+            Async::WorkStealingDeque<QueuedTask*> deque; //< tasks spawned by this worker
+            TaskQueue mailbox; //< tasks which last ran on this worker and were woken up by another thread
+        };
+
+        struct Lane {
+            TaskQueue sharedQueue; //< tasks pushed by threads outside of this lane, or all tasks with TaskQueueing::SharedQueue
+            std::vector<std::unique_ptr<Worker>> workers; //< empty for lanes run by the main thread
+            moodycamel::LightweightSemaphore wakeUp;
+            std::atomic<std::uint32_t> sleepingWorkers { 0 };
+        };
+
+        TaskQueueing queueing = TaskQueueing::WorkStealing;
+        std::array<Lane, LaneCount> lanes; //< indexed by getLaneIndex
+        std::atomic<std::uint64_t> stolenTaskCount { 0 };
+
+        std::array<moodycamel::ConcurrentQueue<TaskData*>, StackSizeCount> reusableTaskData; //< indexed by TaskStackSize
+        moodycamel::ConcurrentQueue<LeafTaskData*> reusableLeafTaskData;
+        std::mutex ownershipMutex; //< protects allTaskData and allLeafTaskData
+        std::vector<std::unique_ptr<TaskData>> allTaskData;
+        std::vector<std::unique_ptr<LeafTaskData>> allLeafTaskData;
+
+        const std::size_t fiberStackMemoryBudget;
+        std::atomic<std::size_t> reservedStackMemory { 0 };
+        std::atomic<bool> budgetWarningLogged = false;
+
+        // threads waiting for a TaskData inside acquireTaskData, once the budget is reached
+        std::mutex taskDataReleaseMutex;
+        std::condition_variable taskDataReleased;
+        std::atomic<std::uint32_t> threadsWaitingForTaskData { 0 };
+
+        std::atomic<bool> running = true;
+
+        // counts must be the same below
+        std::vector<std::thread> parallelThreads;
+
+        friend class FiberScheduler;
+        friend class TaskHandle;
+    };
+}
@@ -45,11 +45,17 @@ namespace Carrot {
 	    0x25577eeb6e6bb820ULL, 0x196c0603e6b3b7c1ULL, 0x5d218f3a7fdba7e2ULL, 0x611af7d2f703a803ULL, 0x505b5e9e1edfea83ULL, 0x6c6026769607e562ULL, 0x282daf4f0f6ff541ULL, 0x1416d7a787b7faa0ULL,
 	};
 
-    constexpr std::uint64_t CRC64(const char* pData, std::size_t length) {
-		std::uint64_t crc = -1ull;
+    /// Continues the CRC 'previous' with the given data: CRC64(a+b) == CRC64(b, CRC64(a)).
+    /// Used to hash data which is not contiguous in memory, like files read in chunks
+    constexpr std::uint64_t CRC64(const char* pData, std::size_t length, std::uint64_t previous) {
+		std::uint64_t crc = previous ^ -1ull;
 		while(length--) {
 			crc = CRCTable[((crc ^ *(pData++)) & 0xFF)] ^ (crc >> 8);
 		}
         return crc ^ -1ull;
     }
+
+    constexpr std::uint64_t CRC64(const char* pData, std::size_t length) {
+        return CRC64(pData, length, 0);
+    }
 }
\ No newline at end of file
@@ -92,6 +92,7 @@ static Carrot::RuntimeOption showFPS("Engine/Show FPS", false);
 static Carrot::RuntimeOption showToneMappingSelector{"Engine/Tone mapping selector", false};
 static Carrot::RuntimeOption showInputDebug("Engine/Show Inputs", false);
 static Carrot::RuntimeOption showSettingsDebug("Engine/Show Settings", false);
+static Carrot::RuntimeOption showTaskSchedulerDebug("Debug/Task Scheduler", false);
 
 static std::unordered_set<int> activeJoysticks{};
 
@@ -134,6 +135,7 @@ renderer(vkDriver, config), screenQuad(std::make_unique<SingleMesh>(
     ZoneScoped;
     instance = this;
     Carrot::Threads::setCurrentThreadName("Main");
+    taskScheduler.bindAsyncParallelFor();
     changeTickRate(config.tickRate);
     setShutdownRequestHandler([this]() {
         running = false;
@@ -1063,6 +1065,9 @@ void Carrot::Engine::drawFrame(size_t currentFrame) {
         resourceAllocator->beginFrame(mainRenderContext);
         renderer.beginFrame(mainRenderContext);
         GetTaskScheduler().executeRendering();
+        if(showTaskSchedulerDebug) {
+            drawTaskSchedulerDebug();
+        }
 
         auto onFrame = [&](Carrot::Render::Viewport& v) {
             ZoneScoped;
@@ -1828,6 +1833,30 @@ Carrot::TaskScheduler& Carrot::Engine::getTaskScheduler() {
     return taskScheduler;
 }
 
+Carrot::TaskSchedulerConfig Carrot::Engine::makeTaskSchedulerConfig() {
+    return Carrot::TaskSchedulerConfig {
+        .threadInit = [](const Carrot::Async::TaskLane& lane, std::size_t threadIndex) {
+            GetRenderer().makeCurrentThreadRenderCapable();
+        },
+    };
+}
+
+void Carrot::Engine::drawTaskSchedulerDebug() {
+    const TaskSchedulerStats stats = TaskScheduler::collectFrameStats();
+    if(ImGui::Begin("Task Scheduler")) {
+        ImGui::Text("Active tasks: %lld", (long long)stats.activeTasks);
+        ImGui::Text("Task count scheduled this frame: %lld (%lld leaf tasks)", (long long)stats.tasksScheduledThisFrame, (long long)stats.leafTasksScheduledThisFrame);
+        ImGui::Text("Tasks completed this frame: %lld (%.0f tasks/s)", (long long)stats.tasksCompletedThisFrame, stats.tasksCompletedPerSecond);
+        ImGui::Text("Tasks stolen this frame: %lld", (long long)stats.tasksStolenThisFrame);
+        ImGui::Text("Alive TaskData: %lld", (long long)stats.aliveTaskData);
+        ImGui::Text("Total TaskData created: %lld", (long long)stats.totalTaskDataCreated);
+        ImGui::Text("TaskData created this frame: %lld", (long long)stats.taskDataCreatedThisFrame);
+        ImGui::Text("Fibers created: %lld", (long long)stats.fibersCreated);
+        ImGui::Text("Fiber stack memory reserved: %.2f MiB", static_cast<double>(stats.fiberStackBytes) / (1024.0 * 1024.0));
+    }
+    ImGui::End();
+}
+
 void Carrot::Engine::addWaitSemaphoreBeforeRendering(const Render::Context& renderContext, const vk::PipelineStageFlags& stage, const vk::Semaphore& semaphore, u64 waitValue) {
     for (auto& [_, sem] : additionalWaitSemaphores[renderContext.frameNumber % additionalWaitSemaphores.size()]) {
         if (sem.first == semaphore) {
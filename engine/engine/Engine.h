@@ -27,7 +27,7 @@ namespace Carrot {
 #include "engine/Configuration.h"
 #include "engine/Capabilities.h"
 #include "engine/io/actions/InputVectors.h"
-#include "engine/task/TaskScheduler.h"
+#include "core/tasks/TaskScheduler.h"
 #include <engine/scene/SceneManager.h>
 #include <engine/audio/AudioManager.h>
 #include <engine/assets/AssetServer.h>
@@ -621,7 +621,12 @@ namespace Carrot {
 
     private: // async members
         std::list<std::future<void>> frameTaskFutures;
-        TaskScheduler taskScheduler;
+        TaskScheduler taskScheduler { makeTaskSchedulerConfig() };
+
+        /// Worker threads of the engine must be able to submit render packets
+        static TaskSchedulerConfig makeTaskSchedulerConfig();
+
+        void drawTaskSchedulerDebug();
 
     private:
         std::unique_ptr<Scripting::ScriptingEngine> scriptingEngine = nullptr;
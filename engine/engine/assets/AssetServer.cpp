@@ -40,6 +40,7 @@ namespace Carrot {
             std::filesystem::create_directories(vfsRoot);
         }
         GetVFS().addRoot("asset_server", vfsRoot);
+        pConversionCache = std::make_unique<Fertilizer::AssetCache>(Carrot::IO::getExecutablePath().parent_path() / "asset_server_cache");
     }
 
     AssetServer::~AssetServer() {}
@@ -138,6 +139,7 @@ namespace Carrot {
     void AssetServer::deleteConvertedAsset(const Carrot::IO::VFS::Path& vfsPath) {
         const std::filesystem::path& path = getConvertedPath(vfsPath);
         std::filesystem::remove(path);
+        std::filesystem::remove(Fertilizer::getManifestPath(path));
     }
 
     std::shared_ptr<Render::Texture> AssetServer::blockingLoadTexture(const Carrot::IO::VFS::Path& path) {
@@ -324,7 +326,7 @@ namespace Carrot {
 
         Carrot::Profiling::PrintingScopedTimer convertTimer{ Carrot::sprintf("Converting %s", path.toString().c_str()) };
         const fs::path diskPath = GetVFS().resolve(path);
-        Fertilizer::ConversionResult result = Fertilizer::convert(diskPath, convertedPath, false);
+        Fertilizer::ConversionResult result = Fertilizer::convert(diskPath, convertedPath, false, pConversionCache.get());
 
         if(result.errorCode != Fertilizer::ConversionResultError::Success) {
             throw AssetConversionException(path, result.errorMessage);
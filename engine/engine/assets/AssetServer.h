@@ -7,10 +7,14 @@
 #include <core/data/Hashes.h>
 #include <core/io/vfs/VirtualFileSystem.h>
 #include <engine/ecs/EntityTypes.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include <engine/render/animation/AnimatedModel.h>
 #include <engine/ecs/Prefab.h>
 
+namespace Fertilizer {
+    class AssetCache;
+}
+
 namespace Carrot {
     class RenderableParticleBlueprint;
     class Model;
@@ -93,6 +97,7 @@ namespace Carrot {
     private:
         IO::VirtualFileSystem& vfs;
         std::filesystem::path vfsRoot;
+        std::unique_ptr<Fertilizer::AssetCache> pConversionCache; // converted assets by content hash, survives deletion of converted assets
         std::atomic_int64_t loadingCount{0};
 
         Async::ParallelMap<std::pair<std::string, std::uint64_t>, std::shared_ptr<Pipeline>> pipelines{};
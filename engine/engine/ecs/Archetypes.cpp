@@ -0,0 +1,166 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "Archetypes.h"
+#include <algorithm>
+#include <core/utils/Assert.h>
+
+namespace Carrot::ECS {
+    ArchetypeChunk::ArchetypeChunk(std::span<const ComponentLayout* const> columnLayouts) {
+        entities.reserve(Capacity);
+
+        // columns are laid out one after the other inside a single allocation
+        const std::size_t columnCount = columnLayouts.size();
+        columns.resize(columnCount);
+        std::size_t storageSize = 0;
+        storageAlignment = alignof(Component*);
+        for(std::size_t columnIndex = 0; columnIndex < columnCount; columnIndex++) {
+            const ComponentLayout* pLayout = columnLayouts[columnIndex];
+            const std::size_t elementSize = pLayout != nullptr ? pLayout->size : sizeof(Component*);
+            const std::size_t elementAlignment = pLayout != nullptr ? pLayout->alignment : alignof(Component*);
+            storageSize = (storageSize + elementAlignment - 1) / elementAlignment * elementAlignment;
+            columns[columnIndex] = Column {
+                .pLayout = pLayout,
+                .offset = storageSize,
+            };
+            storageSize += elementSize * Capacity;
+            storageAlignment = std::max(storageAlignment, elementAlignment);
+        }
+        storage = static_cast<std::byte*>(::operator new(std::max<std::size_t>(1, storageSize), std::align_val_t { storageAlignment }));
+
+        rowVersions = std::make_unique<std::uint64_t[]>(std::max<std::size_t>(1, columnCount * Capacity));
+        columnVersions = std::make_unique<std::uint64_t[]>(std::max<std::size_t>(1, columnCount));
+    }
+
+    ArchetypeChunk::~ArchetypeChunk() {
+        for(std::size_t columnIndex = 0; columnIndex < columns.size(); columnIndex++) {
+            for(std::size_t row = 0; row < size(); row++) {
+                destroy(columnIndex, row);
+            }
+        }
+        ::operator delete(storage, std::align_val_t { storageAlignment });
+    }
+
+    void* ArchetypeChunk::getAddress(std::size_t columnIndex, std::size_t row) const {
+        const Column& column = columns[columnIndex];
+        const std::size_t elementSize = column.pLayout != nullptr ? column.pLayout->size : sizeof(Component*);
+        return storage + column.offset + row * elementSize;
+    }
+
+    Component& ArchetypeChunk::getComponent(std::size_t columnIndex, std::size_t row) const {
+        const Column& column = columns[columnIndex];
+        if(column.pLayout != nullptr) {
+            return *column.pLayout->fromStorage(getAddress(columnIndex, row));
+        }
+        return *getPointers(columnIndex)[row];
+    }
+
+    void ArchetypeChunk::store(std::size_t columnIndex, std::size_t row, Component& component) {
+        const Column& column = columns[columnIndex];
+        if(column.pLayout != nullptr) {
+            column.pLayout->moveConstruct(getAddress(columnIndex, row), component);
+        } else {
+            getPointers(columnIndex)[row] = &component;
+        }
+    }
+
+    void ArchetypeChunk::destroy(std::size_t columnIndex, std::size_t row) {
+        const Column& column = columns[columnIndex];
+        if(column.pLayout != nullptr) {
+            column.pLayout->destroy(*column.pLayout->fromStorage(getAddress(columnIndex, row)));
+        }
+    }
+
+    void ArchetypeChunk::markChanged(std::size_t row, std::size_t columnIndex, std::uint64_t version) {
+        getRowVersions(columnIndex)[row] = version;
+        raiseColumnVersion(columnIndex, version);
+    }
+
+    void ArchetypeChunk::raiseColumnVersion(std::size_t columnIndex, std::uint64_t version) {
+        columnVersions[columnIndex] = std::max(columnVersions[columnIndex], version);
+    }
+
+    Archetype::Archetype(const Signature& signature, std::vector<const ComponentLayout*> columnLayouts)
+        : signature(signature)
+        , columnLayouts(std::move(columnLayouts))
+    {
+        verify(this->columnLayouts.size() == signature.getComponentCount(), "There must be one layout per column");
+    }
+
+    std::size_t Archetype::getEntityCount() const {
+        if(chunks.empty()) {
+            return 0;
+        }
+        return (chunks.size() - 1) * ArchetypeChunk::Capacity + chunks.back()->size();
+    }
+
+    std::size_t Archetype::getColumnIndex(ComponentID componentID) const {
+        return static_cast<std::size_t>(signature.getComponentIndex(componentID));
+    }
+
+    Component& Archetype::getComponent(const ArchetypeLocation& location, std::size_t columnIndex) const {
+        verify(location.pArchetype == this, "Location is not inside this archetype");
+        return chunks[location.chunkIndex]->getComponent(columnIndex, location.row);
+    }
+
+    ArchetypeLocation Archetype::add(const EntityID& entity, std::span<Component* const> components, std::uint64_t version) {
+        verify(components.size() == columnLayouts.size(), "Component count does not match archetype");
+        if(chunks.empty() || chunks.back()->isFull()) {
+            chunks.emplace_back(std::make_unique<ArchetypeChunk>(columnLayouts));
+        }
+
+        ArchetypeChunk& chunk = *chunks.back();
+        const std::size_t row = chunk.size();
+        for(std::size_t column = 0; column < columnLayouts.size(); column++) {
+            chunk.store(column, row, *components[column]);
+            chunk.markChanged(row, column, version);
+        }
+        chunk.entities.push_back(entity);
+
+        return ArchetypeLocation {
+            .pArchetype = this,
+            .chunkIndex = static_cast<std::uint32_t>(chunks.size() - 1),
+            .row = static_cast<std::uint32_t>(row),
+        };
+    }
+
+    void Archetype::replaceComponent(const ArchetypeLocation& location, std::size_t columnIndex, Component& component, std::uint64_t version) {
+        verify(location.pArchetype == this, "Location is not inside this archetype");
+        ArchetypeChunk& chunk = *chunks[location.chunkIndex];
+        chunk.destroy(columnIndex, location.row);
+        chunk.store(columnIndex, location.row, component);
+        chunk.markChanged(location.row, columnIndex, version);
+    }
+
+    std::optional<EntityID> Archetype::remove(const ArchetypeLocation& location) {
+        verify(location.pArchetype == this, "Location is not inside this archetype");
+        ArchetypeChunk& holeChunk = *chunks[location.chunkIndex];
+        ArchetypeChunk& lastChunk = *chunks.back();
+        const std::size_t lastRow = lastChunk.size() - 1;
+
+        for(std::size_t column = 0; column < columnLayouts.size(); column++) {
+            holeChunk.destroy(column, location.row);
+        }
+
+        std::optional<EntityID> movedEntity;
+        const bool isLast = location.chunkIndex == chunks.size() - 1 && location.row == lastRow;
+        if(!isLast) {
+            // swap-remove: fill the hole with the last entity to keep chunks packed
+            holeChunk.entities[location.row] = lastChunk.entities[lastRow];
+            for(std::size_t column = 0; column < columnLayouts.size(); column++) {
+                holeChunk.store(column, location.row, lastChunk.getComponent(column, lastRow));
+                lastChunk.destroy(column, lastRow);
+                holeChunk.markChanged(location.row, column, lastChunk.getRowVersions(column)[lastRow]);
+            }
+            movedEntity = holeChunk.entities[location.row];
+        }
+
+        // the last row is either the removed entity, or was moved (and destroyed) above
+        lastChunk.entities.pop_back();
+        if(lastChunk.size() == 0) {
+            chunks.pop_back();
+        }
+        return movedEntity;
+    }
+}
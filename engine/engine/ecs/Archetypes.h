@@ -0,0 +1,169 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include "ComponentLayout.h"
+#include "EntityTypes.h"
+#include "Signature.hpp"
+
+namespace Carrot::ECS {
+    class Archetype;
+    struct Component;
+
+    /// How a World keeps track of the components of its entities.
+    enum class ComponentStorage {
+        /// Each entity has its own map of components. Iterating over a system requires a lookup per entity
+        PerEntityMap,
+
+        /// Entities with the same signature are grouped inside chunks, with one contiguous column per component type.
+        /// Components which can be moved around are stored by value inside their column (see ComponentLayout).
+        /// Systems iterate chunk by chunk, without any lookup per entity.
+        Archetypes,
+    };
+
+    /**
+     * Fixed-size block of entities sharing the same signature.
+     * Components are stored column by column (SoA): all components of a given type are next to each other in memory.
+     * Columns of components with a ComponentLayout contain the components themselves, other columns contain pointers to
+     * components owned by the World (see ComponentLayout for which components can be stored by value).
+     */
+    class ArchetypeChunk {
+    public:
+        static constexpr std::size_t Capacity = 256;
+
+        /// One layout per column, nullptr for columns of pointers
+        explicit ArchetypeChunk(std::span<const ComponentLayout* const> columnLayouts);
+        ~ArchetypeChunk();
+
+        ArchetypeChunk(const ArchetypeChunk&) = delete;
+        ArchetypeChunk& operator=(const ArchetypeChunk&) = delete;
+
+        std::size_t size() const { return entities.size(); }
+        bool isFull() const { return entities.size() == Capacity; }
+
+        const EntityID& getEntity(std::size_t row) const { return entities[row]; }
+
+        /// Layout of the components stored by value in the given column, nullptr if the column stores pointers.
+        /// Column indices match Signature::getComponentIndex
+        const ComponentLayout* getLayout(std::size_t columnIndex) const { return columns[columnIndex].pLayout; }
+
+        /// Component at the given row and column, whatever the column stores
+        Component& getComponent(std::size_t columnIndex, std::size_t row) const;
+
+        /// Start of a column storing components of type T by value (getLayout(columnIndex) == ComponentLayout::of<T>())
+        template<typename T>
+        T* getValues(std::size_t columnIndex) const {
+            return static_cast<T*>(static_cast<void*>(storage + columns[columnIndex].offset));
+        }
+
+        /// Start of a column storing pointers to components (getLayout(columnIndex) == nullptr)
+        Component** getPointers(std::size_t columnIndex) const {
+            return static_cast<Component**>(static_cast<void*>(storage + columns[columnIndex].offset));
+        }
+
+        /// Change version of each component of the given column (see World::nextChangeVersion): the version of the last time
+        /// the component at a given row was added, replaced or marked as changed.
+        std::uint64_t* getRowVersions(std::size_t columnIndex) { return &rowVersions[columnIndex * Capacity]; }
+        const std::uint64_t* getRowVersions(std::size_t columnIndex) const { return &rowVersions[columnIndex * Capacity]; }
+
+        /// Highest change version of the given column. Lets change filters skip entire chunks
+        std::uint64_t getColumnVersion(std::size_t columnIndex) const { return columnVersions[columnIndex]; }
+
+        /// Marks the component at the given row and column as changed
+        void markChanged(std::size_t row, std::size_t columnIndex, std::uint64_t version);
+
+        /// Updates the column version after rows were marked as changed by writing to getRowVersions directly
+        void raiseColumnVersion(std::size_t columnIndex, std::uint64_t version);
+
+    private:
+        struct Column {
+            const ComponentLayout* pLayout = nullptr;
+            std::size_t offset = 0; //< in bytes, from the start of 'storage'
+        };
+
+        void* getAddress(std::size_t columnIndex, std::size_t row) const;
+
+        /// Stores 'component' at the given row: moved into the chunk for columns of values, referenced otherwise.
+        /// The row must not contain a component yet
+        void store(std::size_t columnIndex, std::size_t row, Component& component);
+
+        /// Destroys the component at the given row, if the column stores values
+        void destroy(std::size_t columnIndex, std::size_t row);
+
+        std::vector<EntityID> entities;
+        std::vector<Column> columns;
+        std::byte* storage = nullptr; //< all columns, one after the other
+        std::size_t storageAlignment = 0;
+        std::unique_ptr<std::uint64_t[]> rowVersions;
+        std::unique_ptr<std::uint64_t[]> columnVersions;
+
+        friend class Archetype;
+    };
+
+    /// Where an entity is stored inside the archetypes of a World
+    struct ArchetypeLocation {
+        Archetype* pArchetype = nullptr;
+        std::uint32_t chunkIndex = 0;
+        std::uint32_t row = 0;
+    };
+
+    /**
+     * Set of all entities which have exactly the same signature.
+     * Entities are kept packed: all chunks are full, except the last one.
+     */
+    class Archetype {
+    public:
+        /// 'columnLayouts' gives the layout of each column (see ArchetypeChunk), in column order
+        explicit Archetype(const Signature& signature, std::vector<const ComponentLayout*> columnLayouts);
+
+        const Signature& getSignature() const { return signature; }
+        std::size_t getColumnCount() const { return columnLayouts.size(); }
+        std::size_t getEntityCount() const;
+
+        /// Index of the column containing the given component type. Same order as the one used by EntityWithComponents
+        std::size_t getColumnIndex(ComponentID componentID) const;
+
+        /// Layout of the components stored by value in the given column, nullptr if the column stores pointers
+        const ComponentLayout* getColumnLayout(std::size_t columnIndex) const { return columnLayouts[columnIndex]; }
+
+        std::span<const std::unique_ptr<ArchetypeChunk>> getChunks() const { return chunks; }
+
+        /// Component of the entity at the given location
+        Component& getComponent(const ArchetypeLocation& location, std::size_t columnIndex) const;
+
+        /// Adds an entity at the end of this archetype. 'components' must contain one component per column, in column order.
+        /// Components of columns storing values are moved inside the chunk: the caller still owns (and must destroy) the
+        /// moved-from originals. Other columns reference the given components.
+        /// All components of the entity are marked as changed with the given version
+        ArchetypeLocation add(const EntityID& entity, std::span<Component* const> components, std::uint64_t version);
+
+        /// Replaces the component of the entity at the given location (for instance when a component was replaced by another of the same type),
+        /// with the same ownership rules as 'add'. The component is marked as changed with the given version
+        void replaceComponent(const ArchetypeLocation& location, std::size_t columnIndex, Component& component, std::uint64_t version);
+
+        /// Removes the entity at the given location, destroying the components it stored by value, and moves the last entity
+        /// of this archetype in its place.
+        /// Returns the ID of the moved entity, if any. Its location is now the location that was given to this method.
+        std::optional<EntityID> remove(const ArchetypeLocation& location);
+
+    private:
+        Signature signature;
+        std::vector<const ComponentLayout*> columnLayouts;
+        std::vector<std::unique_ptr<ArchetypeChunk>> chunks;
+    };
+
+    /// Archetypes matching a given signature, updated incrementally when new archetypes are created.
+    /// Owned by users of World::updateMatchingArchetypes (usually systems)
+    struct ArchetypeQueryCache {
+        std::vector<Archetype*> archetypes;
+        std::size_t checkedArchetypeCount = 0;
+        std::uint64_t generation = 0;
+    };
+}
@@ -0,0 +1,60 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Carrot::ECS {
+    struct Component;
+
+    /**
+     * How to store a component type by value inside the columns of archetype chunks (see ArchetypeChunk).
+     * Only components which can be moved around in memory have a layout: components registering their own address somewhere
+     * else (callbacks, physics bodies, C# objects...) are kept on the heap and chunks only reference them.
+     * See Component::StoredByValue
+     */
+    struct ComponentLayout {
+        std::size_t size = 0;
+        std::size_t alignment = 0;
+
+        /// Move-constructs a component at 'destination' from 'source'. 'source' still needs to be destroyed afterwards
+        void (*moveConstruct)(void* destination, Component& source) = nullptr;
+
+        /// Calls the destructor of the component, without freeing its memory
+        void (*destroy)(Component& component) = nullptr;
+
+        /// Component stored at the given address
+        Component* (*fromStorage)(void* storage) = nullptr;
+
+        /// Moves the component to a new heap allocation. 'source' still needs to be destroyed afterwards
+        std::unique_ptr<Component> (*moveToHeap)(Component& source) = nullptr;
+
+        template<typename T>
+        static const ComponentLayout* of() {
+            static_assert(std::is_move_constructible_v<T>, "Components stored by value must be move-constructible");
+            static const ComponentLayout layout {
+                .size = sizeof(T),
+                .alignment = alignof(T),
+                .moveConstruct = [](void* destination, Component& source) {
+                    new (destination) T(std::move(static_cast<T&>(source)));
+                },
+                .destroy = [](Component& component) {
+                    static_cast<T&>(component).~T();
+                },
+                .fromStorage = [](void* storage) -> Component* {
+                    return static_cast<T*>(storage);
+                },
+                .moveToHeap = [](Component& source) -> std::unique_ptr<Component> {
+                    return std::make_unique<T>(std::move(static_cast<T&>(source)));
+                },
+            };
+            return &layout;
+        }
+    };
+}
@@ -7,6 +7,7 @@
 #include <optional>
 #include <cstddef>
 #include <string_view>
+#include <unordered_map>
 #include <cassert>
 #include <core/containers/Vector.hpp>
 #include <core/memory/OptionalRef.h>
@@ -187,6 +188,7 @@ namespace Carrot::ECS {
     struct QueryResult {
         Signature signature;
         std::vector<EntityWithComponents> matchingEntities;
+        std::unordered_map<EntityID, std::size_t> indices; //< index of each entity inside matchingEntities, kept up-to-date when entities are swap-removed
     };
 
     /**
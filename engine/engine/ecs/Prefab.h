@@ -10,7 +10,7 @@
 #include <engine/ecs/components/Component.h>
 #include <engine/render/AsyncResource.hpp>
 #include <engine/scene/Scene.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 
 namespace Carrot {
     class AssetServer;
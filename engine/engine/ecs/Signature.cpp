@@ -4,83 +4,99 @@
 
 #include <core/utils/Assert.h>
 #include <core/Macros.h>
+#include <core/async/ParallelMap.hpp>
 #include "Signature.hpp"
 #include <robin_hood.h>
-
-std::unordered_map<Carrot::ComponentID, std::size_t> Carrot::Signature::hash2index{};
-std::mutex Carrot::Signature::mappingAccess{};
+#include <algorithm>
+#include <atomic>
 
 namespace Carrot {
-    Signature::Signature() {
-        componentIndices.resize(MAX_COMPONENTS, -1);
+    /// ComponentID -> index mapping. Indices are only ever added, so reads of existing ones never lock
+    static Async::ParallelMap<ComponentID, std::size_t>& getComponentIndices() {
+        static Async::ParallelMap<ComponentID, std::size_t> indices;
+        return indices;
     }
 
-    void Signature::fromBitset(const std::bitset<MAX_COMPONENTS>& _components) {
-        components = _components;
-        reindex();
+    /// index -> ComponentID mapping, filled when indices are assigned
+    static std::array<std::atomic<ComponentID>, MAX_COMPONENTS> ComponentIDsByIndex{};
+    static std::atomic<std::size_t> NextComponentIndex { 0 };
+
+    void Signature::fromWords(std::span<const Word> newWords) {
+        clear();
+        const std::size_t count = std::min(newWords.size(), WordCount);
+        for(std::size_t i = 0; i < count; i++) {
+            words[i] = newWords[i];
+        }
     }
 
     std::size_t Signature::getIndex(ComponentID id) {
-        // check if component already has an index
-        auto position = hash2index.find(id);
-        if(position == hash2index.end()) { // no index
-            std::lock_guard lk(mappingAccess);
-            position = hash2index.find(id);
-            if(position == hash2index.end()) { // still no index after lock
-                auto newIndex = hash2index.size();
-                hash2index[id] = newIndex;
-                return newIndex;
-            }
-            return position->second;
+        auto& indices = getComponentIndices();
+        if(const std::size_t* pIndex = indices.find(id)) {
+            return *pIndex;
         }
 
-        return position->second;
+        return indices.getOrCompute(id, [id]() {
+            const std::size_t newIndex = NextComponentIndex++;
+            verify(newIndex < MAX_COMPONENTS, "Too many component types, increase MAX_COMPONENTS");
+            ComponentIDsByIndex[newIndex].store(id, std::memory_order_release);
+            return newIndex;
+        });
     }
 
-    void Signature::reindex() {
-        IndexType index = 0;
-        componentCount = 0;
-        for (int i = 0; i < MAX_COMPONENTS; i++) {
-            if (components[i]) {
-                componentIndices[i] = index++;
-                componentCount++;
-            } else {
-                componentIndices[i] = -1;
-            }
-        }
+    ComponentID Signature::getComponentID(std::size_t index) {
+        verify(index < NextComponentIndex.load(std::memory_order_acquire), "No component has this index");
+        return ComponentIDsByIndex[index].load(std::memory_order_acquire);
     }
 
     bool Signature::hasComponent(ComponentID componentID) const {
-        auto index = getIndex(componentID);
-        return components[index];
+        const std::size_t index = getIndex(componentID);
+        return (words[index / BitsPerWord] >> (index % BitsPerWord)) & 1;
     }
 
     void Signature::addComponent(size_t componentID) {
-        auto index = getIndex(componentID);
-        components[index] = true;
-        reindex();
+        addComponentFromComponentIndex_Internal(getIndex(componentID));
     }
 
     void Signature::addComponentFromComponentIndex_Internal(std::size_t index) {
-        components[index] = true;
-        reindex();
+        verify(index < MAX_COMPONENTS, "Component index out of bounds");
+        words[index / BitsPerWord] |= Word(1) << (index % BitsPerWord);
     }
 
     void Signature::clear() {
-        components.reset();
+        words.fill(0);
     }
 
     Signature::IndexType Signature::getComponentIndex(std::size_t componentID) const {
-        auto index = getIndex(componentID);
-        verify(components[index], "Component is not inside signature");
-        return componentIndices[index];
+        const std::size_t index = getIndex(componentID);
+        const std::size_t wordIndex = index / BitsPerWord;
+        const Word bit = Word(1) << (index % BitsPerWord);
+        verify(words[wordIndex] & bit, "Component is not inside signature");
+
+        // rank of the bit: count the components with a lower index
+        std::size_t rank = std::popcount(words[wordIndex] & (bit - 1));
+        for(std::size_t i = 0; i < wordIndex; i++) {
+            rank += std::popcount(words[i]);
+        }
+        return static_cast<IndexType>(rank);
     }
 
     std::size_t Signature::getComponentCount() const {
-        return componentCount;
+        std::size_t count = 0;
+        for(const Word& word : words) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    bool Signature::isEmpty() const {
+        Word any = 0;
+        for(const Word& word : words) {
+            any |= word;
+        }
+        return any == 0;
     }
 
     std::size_t Signature::hash() const {
-        return robin_hood::hash_int(components.to_ullong());
+        return robin_hood::hash_bytes(words.data(), sizeof(words));
     }
-}
\ No newline at end of file
+}
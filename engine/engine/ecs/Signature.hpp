@@ -6,42 +6,60 @@
 #include <unordered_map>
 #include <bitset>
 #include <mutex>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
 
 namespace Carrot {
     using ComponentID = std::size_t;
 
-    constexpr int MAX_COMPONENTS = 64;
+    /// Maximum number of component types which can be registered at once. Must be a multiple of 64.
+    /// Signatures store one bit per component type inline, raising this value makes each Signature larger.
+    constexpr std::size_t MAX_COMPONENTS = 256;
 
     class Signature {
     public:
-        using IndexType = std::int8_t;
+        using IndexType = std::int16_t;
+        using Word = std::uint64_t;
+
+        static constexpr std::size_t BitsPerWord = std::numeric_limits<Word>::digits;
+        static constexpr std::size_t WordCount = MAX_COMPONENTS / BitsPerWord;
+        static_assert(MAX_COMPONENTS % BitsPerWord == 0, "MAX_COMPONENTS must be a multiple of 64");
         static_assert(MAX_COMPONENTS < std::numeric_limits<IndexType>::max());
 
     private:
-        /// Hash to ID mapping
-        static std::unordered_map<ComponentID, std::size_t> hash2index;
-        static std::mutex mappingAccess;
-
-        /// Components present in this signature
-        std::bitset<MAX_COMPONENTS> components;
-        std::vector<IndexType> componentIndices; // map of ComponentID -> index of component when returning multiple components based on Signature (for example LoadAllEntities in C#)
-        std::size_t componentCount = 0;
+        /// Components present in this signature, one bit per component index.
+        /// Stored inline and aligned for vector instructions: copies do not allocate, and the loops over 'words' are
+        /// unrolled and vectorized by the compiler (WordCount is known at compile time)
+        alignas(32) std::array<Word, WordCount> words{};
 
         /// Gets or generates the index for the given component
         template<typename Component>
         static std::size_t getIndex();
 
-        void reindex();
-
     public:
+        /// Gets the index of the given component inside signatures. The index is assigned the first time a component is
+        /// seen (ideally when it is registered), and never changes afterwards.
+        /// Lookups of already assigned indices are lock-free.
         static std::size_t getIndex(ComponentID id);
 
-        explicit Signature();
+        /// Reverse of getIndex: which component has the given index? The index must have been assigned already.
+        static ComponentID getComponentID(std::size_t index);
+
+        Signature() = default;
 
         /**
-         * Loads a signature from the given bitset
+         * Loads a signature from the given bits (bit i of word j corresponds to component index j*64+i).
+         * Words past WordCount are ignored, missing words are considered 0.
          */
-        void fromBitset(const std::bitset<MAX_COMPONENTS>& components);
+        void fromWords(std::span<const Word> words);
+
+        /// Bits of this signature, see fromWords
+        std::span<const Word, WordCount> getWords() const {
+            return words;
+        }
 
         template<typename... Components>
         void addComponents();
@@ -55,22 +73,55 @@ namespace Carrot {
         bool hasComponent(ComponentID componentID) const;
 
         void addComponent(std::size_t componentID);
-        void addComponentFromComponentIndex_Internal(std::size_t componentID);
+        void addComponentFromComponentIndex_Internal(std::size_t componentIndex);
 
         void clear();
 
+        /// Index of the given component among the components of this signature (number of components with a lower
+        /// index present in this signature)
         IndexType getComponentIndex(std::size_t componentID) const;
 
         std::size_t getComponentCount() const;
 
+        /// Does this signature contain no component at all?
+        bool isEmpty() const;
+
+        /// Does this signature contain all components of 'other'? Equivalent to (*this & other) == other, without the temporary
+        bool contains(const Signature& other) const {
+            Word missing = 0;
+            for(std::size_t i = 0; i < WordCount; i++) {
+                missing |= other.words[i] & ~words[i];
+            }
+            return missing == 0;
+        }
+
+        /// Does this signature have at least one component in common with 'other'? Equivalent to !(*this & other).isEmpty()
+        bool intersects(const Signature& other) const {
+            Word common = 0;
+            for(std::size_t i = 0; i < WordCount; i++) {
+                common |= words[i] & other.words[i];
+            }
+            return common != 0;
+        }
+
+        /// Calls 'action' with the index of each component inside this signature, in increasing order
+        template<typename Action>
+        void forEachComponentIndex(Action&& action) const;
+
         Signature operator&(const Carrot::Signature& rhs) const {
             Signature result{};
-            result.components = components & rhs.components;
+            for(std::size_t i = 0; i < WordCount; i++) {
+                result.words[i] = words[i] & rhs.words[i];
+            }
             return result;
         }
 
         friend bool operator==(const Carrot::Signature& a, const Carrot::Signature& b) {
-            return a.components == b.components;
+            Word different = 0;
+            for(std::size_t i = 0; i < WordCount; i++) {
+                different |= a.words[i] ^ b.words[i];
+            }
+            return different == 0;
         }
 
         std::size_t hash() const;
@@ -93,9 +144,7 @@ void Carrot::Signature::addComponents() {
 
 template<typename Component>
 void Carrot::Signature::addComponent() {
-    auto index = getIndex<Component>();
-    components[index] = true;
-    reindex();
+    addComponentFromComponentIndex_Internal(getIndex<Component>());
 }
 
 template<typename Component>
@@ -105,6 +154,17 @@ std::size_t Carrot::Signature::getIndex() {
 
 template<typename Component>
 bool Carrot::Signature::hasComponent() const {
-    auto index = getIndex<Component>();
-    return components[index];
+    return hasComponent(Component::getID());
+}
+
+template<typename Action>
+void Carrot::Signature::forEachComponentIndex(Action&& action) const {
+    for(std::size_t wordIndex = 0; wordIndex < WordCount; wordIndex++) {
+        Word remaining = words[wordIndex];
+        while(remaining != 0) {
+            const std::size_t bit = std::countr_zero(remaining);
+            action(wordIndex * BitsPerWord + bit);
+            remaining &= remaining - 1;
+        }
+    }
 }
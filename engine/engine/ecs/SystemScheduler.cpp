@@ -0,0 +1,263 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "SystemScheduler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <core/io/Logging.hpp>
+#include <engine/console/Console.h>
+#include <engine/console/RuntimeOption.hpp>
+#include <engine/ecs/systems/System.h>
+#include <core/tasks/TaskScheduler.h>
+#include <engine/utils/Macros.h>
+#include <engine/utils/Profiling.h>
+
+namespace Carrot::ECS {
+    static Carrot::RuntimeOption ForceSequentialSystems("Debug/Sequential ECS systems", false);
+
+    static std::mutex AliveSchedulersAccess;
+    static std::vector<SystemScheduler*> AliveSchedulers;
+    static std::once_flag RegisterConsoleCommand;
+
+    static constexpr std::array<const char*, static_cast<std::size_t>(SystemPhase::Count)> PhaseNames {
+        "Tick", "PrePhysics", "PostPhysics", "Frame",
+    };
+
+    // Tracy needs plot names with static storage
+    static constexpr std::array<const char*, static_cast<std::size_t>(SystemPhase::Count)> CriticalPathPlotNames {
+        "ECS Tick critical path (ms)", "ECS PrePhysics critical path (ms)", "ECS PostPhysics critical path (ms)", "ECS Frame critical path (ms)",
+    };
+    static constexpr std::array<const char*, static_cast<std::size_t>(SystemPhase::Count)> ParallelismPlotNames {
+        "ECS Tick parallelism", "ECS PrePhysics parallelism", "ECS PostPhysics parallelism", "ECS Frame parallelism",
+    };
+
+    SystemScheduler::SystemScheduler() {
+        std::call_once(RegisterConsoleCommand, []() {
+            Console::instance().registerCommand("DumpSystemSchedules", [](Carrot::Engine& engine) {
+                SystemScheduler::dumpAllStats();
+            });
+        });
+
+        std::lock_guard l { AliveSchedulersAccess };
+        AliveSchedulers.push_back(this);
+    }
+
+    SystemScheduler::~SystemScheduler() {
+        std::lock_guard l { AliveSchedulersAccess };
+        std::erase(AliveSchedulers, this);
+    }
+
+    SystemScheduling SystemScheduler::getScheduling() const {
+        return scheduling;
+    }
+
+    void SystemScheduler::setScheduling(SystemScheduling newScheduling) {
+        scheduling = newScheduling;
+    }
+
+    const SystemScheduleStats& SystemScheduler::getStats(SystemPhase phase) const {
+        return statsPerPhase[static_cast<std::size_t>(phase)];
+    }
+
+    void SystemScheduler::run(SystemPhase phase, std::span<System* const> systems, const std::function<void(System&)>& action) {
+        ZoneScoped;
+        ZoneText(PhaseNames[static_cast<std::size_t>(phase)], std::strlen(PhaseNames[static_cast<std::size_t>(phase)]));
+
+        timings.clear();
+        timings.resize(systems.size());
+        buildGraph(systems);
+
+        runStart = Clock::now();
+        currentPhase = phase;
+        if(scheduling == SystemScheduling::Sequential || ForceSequentialSystems || systems.size() <= 1) {
+            runSequential(systems, action);
+        } else {
+            runParallel(systems, action);
+        }
+        computeStats(phase);
+    }
+
+    void SystemScheduler::runSystem(std::size_t index, System& system, const std::function<void(System&)>& action) {
+        ZoneScopedN("System");
+        ZoneText(system.getName(), std::strlen(system.getName()));
+
+        const Clock::time_point start = Clock::now();
+        system.beginRun(currentPhase);
+        action(system);
+        system.endRun();
+        const Clock::time_point end = Clock::now();
+
+        SystemTiming& timing = timings[index];
+        timing.name = system.getName();
+        timing.startMs = std::chrono::duration<double, std::milli>(start - runStart).count();
+        timing.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void SystemScheduler::runSequential(std::span<System* const> systems, const std::function<void(System&)>& action) {
+        for(std::size_t i = 0; i < systems.size(); i++) {
+            runSystem(i, *systems[i], action);
+        }
+    }
+
+    void SystemScheduler::runParallel(std::span<System* const> systems, const std::function<void(System&)>& action) {
+        const std::size_t systemCount = systems.size();
+        std::unique_ptr<std::atomic<std::uint32_t>[]> remainingDependencies = std::make_unique<std::atomic<std::uint32_t>[]>(systemCount);
+        for(std::size_t i = 0; i < systemCount; i++) {
+            remainingDependencies[i] = static_cast<std::uint32_t>(predecessors[i].size());
+        }
+
+        std::atomic<std::size_t> completedCount { 0 };
+
+        // systems without declared accesses conflict with all others, so at most one of them can be ready at a given time
+        std::atomic<std::int64_t> readyOnCallingThread { -1 };
+
+        std::mutex exceptionAccess;
+        std::exception_ptr firstException;
+        Async::Counter tasksInFlight;
+
+        // the calling thread sleeps on this when it has nothing to do, until another system completes
+        std::mutex progressAccess;
+        std::condition_variable progressCondition;
+        std::uint64_t completions = 0;
+
+        std::function<void(std::size_t)> markReady;
+        auto execute = [&](std::size_t index) {
+            try {
+                runSystem(index, *systems[index], action);
+            } catch(...) {
+                std::lock_guard l { exceptionAccess };
+                if(!firstException) {
+                    firstException = std::current_exception();
+                }
+            }
+
+            for(const std::size_t successor : successors[index]) {
+                if(--remainingDependencies[successor] == 0) {
+                    markReady(successor);
+                }
+            }
+            completedCount++;
+            {
+                std::lock_guard l { progressAccess };
+                completions++;
+            }
+            progressCondition.notify_one();
+        };
+        markReady = [&](std::size_t index) {
+            if(!systems[index]->getComponentAccess().declared) {
+                readyOnCallingThread = static_cast<std::int64_t>(index);
+                return;
+            }
+
+            GetTaskScheduler().schedule(TaskDescription {
+                .name = systems[index]->getName(),
+                .task = [&, index](TaskHandle&) {
+                    execute(index);
+                },
+                .joiner = &tasksInFlight,
+            }, TaskScheduler::FrameParallelWork);
+        };
+
+        for(std::size_t i = 0; i < systemCount; i++) {
+            if(predecessors[i].empty()) {
+                markReady(i);
+            }
+        }
+
+        // the calling thread runs exclusive systems, and helps with the others while waiting
+        while(true) {
+            // read before looking for work, so that a completion happening in-between wakes up the wait below
+            std::uint64_t seenCompletions;
+            {
+                std::lock_guard l { progressAccess };
+                seenCompletions = completions;
+            }
+            if(completedCount.load() == systemCount) {
+                break;
+            }
+
+            const std::int64_t index = readyOnCallingThread.exchange(-1);
+            if(index >= 0) {
+                execute(static_cast<std::size_t>(index));
+                continue;
+            }
+            if(GetTaskScheduler().stealJobAndRun(TaskScheduler::FrameParallelWork)) {
+                continue;
+            }
+
+            // nothing to help with: all ready systems are already running on workers.
+            // New work for this thread (exclusive systems) can only appear when one of them completes
+            std::unique_lock l { progressAccess };
+            progressCondition.wait(l, [&]() { return completions != seenCompletions; });
+        }
+
+        // tasks release their joiner right after their system completed
+        tasksInFlight.sleepWait();
+
+        if(firstException) {
+            std::rethrow_exception(firstException);
+        }
+    }
+
+    void SystemScheduler::buildGraph(std::span<System* const> systems) {
+        const std::size_t systemCount = systems.size();
+        predecessors.resize(systemCount);
+        successors.resize(systemCount);
+        for(std::size_t i = 0; i < systemCount; i++) {
+            predecessors[i].clear();
+            successors[i].clear();
+        }
+
+        for(std::size_t j = 0; j < systemCount; j++) {
+            const ComponentAccess& access = systems[j]->getComponentAccess();
+            for(std::size_t i = 0; i < j; i++) {
+                if(access.conflictsWith(systems[i]->getComponentAccess())) {
+                    predecessors[j].push_back(i);
+                    successors[i].push_back(j);
+                }
+            }
+        }
+    }
+
+    void SystemScheduler::computeStats(SystemPhase phase) {
+        SystemScheduleStats& stats = statsPerPhase[static_cast<std::size_t>(phase)];
+        stats.wallTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+
+        // predecessors always have a lower index, so a single pass in order is enough to find the longest chain
+        std::vector<double> earliestFinish(timings.size(), 0.0);
+        double totalDuration = 0.0;
+        stats.criticalPathMs = 0.0;
+        for(std::size_t j = 0; j < timings.size(); j++) {
+            double start = 0.0;
+            for(const std::size_t i : predecessors[j]) {
+                start = std::max(start, earliestFinish[i]);
+            }
+            earliestFinish[j] = start + timings[j].durationMs;
+            stats.criticalPathMs = std::max(stats.criticalPathMs, earliestFinish[j]);
+            totalDuration += timings[j].durationMs;
+        }
+        stats.parallelism = stats.wallTimeMs > 0.0 ? totalDuration / stats.wallTimeMs : 1.0;
+        stats.systems = timings;
+
+        TracyPlot(CriticalPathPlotNames[static_cast<std::size_t>(phase)], stats.criticalPathMs);
+        TracyPlot(ParallelismPlotNames[static_cast<std::size_t>(phase)], stats.parallelism);
+    }
+
+    void SystemScheduler::dumpAllStats() {
+        std::lock_guard l { AliveSchedulersAccess };
+        for(std::size_t schedulerIndex = 0; schedulerIndex < AliveSchedulers.size(); schedulerIndex++) {
+            const SystemScheduler& scheduler = *AliveSchedulers[schedulerIndex];
+            Carrot::Log::info("World #%llu (%s scheduling)", (unsigned long long)schedulerIndex, scheduler.scheduling == SystemScheduling::Parallel ? "parallel" : "sequential");
+            for(std::size_t phaseIndex = 0; phaseIndex < PhaseNames.size(); phaseIndex++) {
+                const SystemScheduleStats& stats = scheduler.statsPerPhase[phaseIndex];
+                Carrot::Log::info("  %s: wall time %.3f ms, critical path %.3f ms, parallelism %.2f", PhaseNames[phaseIndex], stats.wallTimeMs, stats.criticalPathMs, stats.parallelism);
+                for(const SystemTiming& timing : stats.systems) {
+                    Carrot::Log::info("    %s: started at %.3f ms, took %.3f ms", timing.name.c_str(), timing.startMs, timing.durationMs);
+                }
+            }
+        }
+    }
+}
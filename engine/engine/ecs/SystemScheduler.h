@@ -0,0 +1,102 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Carrot::ECS {
+    class System;
+
+    /// Moment of the world update when systems are run
+    enum class SystemPhase {
+        Tick,
+        PrePhysics,
+        PostPhysics,
+        Frame,
+
+        Count,
+    };
+
+    enum class SystemScheduling {
+        /// Systems run one after the other, in the order they were added. Deterministic.
+        Sequential,
+
+        /// Systems which declared non-conflicting component accesses run at the same time on TaskScheduler::FrameParallelWork.
+        /// Systems which conflict still run in the order they were added.
+        Parallel,
+    };
+
+    struct SystemTiming {
+        std::string name;
+        double startMs = 0.0; //< relative to the start of the phase
+        double durationMs = 0.0;
+    };
+
+    /// Timings of the last run of a phase
+    struct SystemScheduleStats {
+        std::vector<SystemTiming> systems;
+        double wallTimeMs = 0.0;
+
+        /// Longest chain of dependent systems, based on the measured durations. Lower bound of the wall time
+        double criticalPathMs = 0.0;
+
+        /// Sum of the durations of all systems divided by the wall time. 1 means no parallelism was achieved.
+        double parallelism = 0.0;
+    };
+
+    /**
+     * Runs the systems of a World for a given phase.
+     * Each run builds a dependency graph from the component accesses declared by each system (see System::declareReads/declareWrites):
+     * two systems depend on each other if they conflict, in which case the system added first runs first.
+     * Systems which did not declare their accesses conflict with every other system, and are run on the calling thread.
+     */
+    class SystemScheduler {
+    public:
+        SystemScheduler();
+        SystemScheduler(const SystemScheduler&) = delete;
+        ~SystemScheduler();
+
+        SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+        SystemScheduling getScheduling() const;
+        void setScheduling(SystemScheduling scheduling);
+
+        /// Calls 'action' on each system, in parallel when their declared accesses allow it.
+        /// Returns once all systems are done. If a system throws, the first exception is rethrown once all systems are done.
+        void run(SystemPhase phase, std::span<System* const> systems, const std::function<void(System&)>& action);
+
+        const SystemScheduleStats& getStats(SystemPhase phase) const;
+
+        /// Logs the stats of the last run of each phase, for all alive schedulers. Used by the 'DumpSystemSchedules' console command
+        static void dumpAllStats();
+
+    private:
+        void runSequential(std::span<System* const> systems, const std::function<void(System&)>& action);
+        void runParallel(std::span<System* const> systems, const std::function<void(System&)>& action);
+        void runSystem(std::size_t index, System& system, const std::function<void(System&)>& action);
+
+        /// Fills 'predecessors' with the edges of the dependency graph
+        void buildGraph(std::span<System* const> systems);
+        void computeStats(SystemPhase phase);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        SystemScheduling scheduling = SystemScheduling::Parallel;
+        std::array<SystemScheduleStats, static_cast<std::size_t>(SystemPhase::Count)> statsPerPhase;
+
+        // state of the current run
+        Clock::time_point runStart;
+        SystemPhase currentPhase = SystemPhase::Tick;
+        std::vector<SystemTiming> timings;
+        std::vector<std::vector<std::size_t>> predecessors;
+        std::vector<std::vector<std::size_t>> successors;
+    };
+}
@@ -0,0 +1,287 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <engine/ecs/World.h>
+#include <engine/ecs/components/TransformComponent.h>
+#include <core/tasks/TaskScheduler.h>
+#include <engine/utils/Macros.h>
+#include <engine/utils/Profiling.h>
+
+namespace Carrot::ECS {
+    /// How many nodes of a same level are updated by a single task
+    static constexpr std::size_t UpdateGranularity = 256;
+
+    static bool isSameTransform(const Carrot::Math::Transform& a, const Carrot::Math::Transform& b) {
+        return a.position == b.position && a.scale == b.scale && a.rotation == b.rotation;
+    }
+
+    TransformHierarchy::TransformHierarchy(World& world): world(world) {}
+
+    void TransformHierarchy::invalidateStructure() {
+        structureDirty.store(true, std::memory_order_release);
+    }
+
+    bool TransformHierarchy::contains(const EntityID& entity) const {
+        return nodeIndices.contains(entity);
+    }
+
+    void TransformHierarchy::markEntityUpdated(const EntityID& entity) {
+        entitiesUpdated.push_back(entity);
+    }
+
+    void TransformHierarchy::refreshComponents(std::span<const EntityID> relocated) {
+        if(structureDirty.load(std::memory_order_acquire)) {
+            // pointers will be fetched again by the rebuild
+            return;
+        }
+        for(const EntityID& entity : relocated) {
+            TransformComponent* pTransform = dynamic_cast<TransformComponent*>(world.findComponent(entity, TransformComponent::getID()));
+            auto nodeIter = nodeIndices.find(entity);
+            if(nodeIter == nodeIndices.end()) {
+                if(pTransform != nullptr) {
+                    // transform added (new entities with a transform invalidate the structure anyway)
+                    invalidateStructure();
+                    return;
+                }
+                continue;
+            }
+            if(pTransform == nullptr) {
+                // transform removed
+                invalidateStructure();
+                return;
+            }
+            nodes[nodeIter->second].pTransform = pTransform;
+            pTransform->hierarchySlot = nodeIter->second;
+        }
+    }
+
+    void TransformHierarchy::update(bool newFrame) {
+        ZoneScoped;
+
+        if(newFrame) {
+            // what was rendered by the previous frame is the last frame of this one. Updates done since (eg in World::prePhysics)
+            // only modified globalMatrices
+            lastFrameMatrices.swap(renderedMatrices);
+            hasLastFrame.swap(hasRendered);
+        }
+
+        refreshComponents(entitiesUpdated);
+        entitiesUpdated.clear();
+
+        if(structureDirty.load(std::memory_order_acquire)) {
+            rebuild();
+            structureDirty.store(false, std::memory_order_release);
+        }
+
+        // parents are always in a previous level, so they are up-to-date before their children are processed
+        for(std::size_t level = 0; level + 1 < levelStarts.size(); level++) {
+            const std::size_t levelStart = levelStarts[level];
+            const std::size_t levelSize = levelStarts[level + 1] - levelStart;
+            GetTaskScheduler().parallelFor(levelSize, [&](std::size_t i) {
+                updateNode(levelStart + i);
+            }, UpdateGranularity);
+        }
+        fullUpdate = false;
+
+        // transforms are written directly by gameplay code, this is where their changes become visible to systems filtering on changes
+        if(world.getComponentStorage() == ComponentStorage::Archetypes) {
+            const std::uint64_t version = world.nextChangeVersion();
+            for(std::size_t nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++) {
+                if(dirty[nodeIndex]) {
+                    world.markComponentChanged(nodes[nodeIndex].entity, TransformComponent::getID(), version);
+                }
+            }
+        }
+
+        if(newFrame) {
+            renderedMatrices = globalMatrices;
+            hasRendered.assign(nodes.size(), 1);
+        }
+    }
+
+    void TransformHierarchy::updateNode(std::size_t nodeIndex) {
+        Node& node = nodes[nodeIndex];
+        const Carrot::Math::Transform& localTransform = node.pTransform->localTransform;
+
+        // only changes since the previous update: the parent was processed before, its flag is the one of this update
+        bool isDirty = fullUpdate || !isSameTransform(localTransform, node.cachedLocal);
+        if(node.parent >= 0) {
+            isDirty |= dirty[node.parent] != 0;
+        }
+
+        if(isDirty) {
+            node.cachedLocal = localTransform;
+            const glm::mat4 localMatrix = localTransform.toTransformMatrix();
+            if(node.parent >= 0) {
+                globalMatrices[nodeIndex] = globalMatrices[node.parent] * localMatrix;
+                globalRotations[nodeIndex] = globalRotations[node.parent] * localTransform.rotation;
+                globalScales[nodeIndex] = globalScales[node.parent] * localTransform.scale;
+            } else {
+                globalMatrices[nodeIndex] = localMatrix;
+                globalRotations[nodeIndex] = localTransform.rotation;
+                globalScales[nodeIndex] = localTransform.scale;
+            }
+        }
+        dirty[nodeIndex] = isDirty ? 1 : 0;
+    }
+
+    void TransformHierarchy::rebuild() {
+        ZoneScoped;
+
+        // keep the matrices of entities which were already there, so that motion vectors survive structure changes
+        struct PreviousMatrices {
+            glm::mat4 current;
+            glm::mat4 rendered;
+            glm::mat4 lastFrame;
+            bool hasRendered;
+            bool hasLastFrame;
+        };
+        std::unordered_map<EntityID, PreviousMatrices> previousMatrices;
+        previousMatrices.reserve(nodes.size());
+        for(std::size_t i = 0; i < nodes.size(); i++) {
+            previousMatrices[nodes[i].entity] = PreviousMatrices {
+                .current = globalMatrices[i],
+                .rendered = renderedMatrices[i],
+                .lastFrame = lastFrameMatrices[i],
+                .hasRendered = hasRendered[i] != 0,
+                .hasLastFrame = hasLastFrame[i] != 0,
+            };
+        }
+
+        auto getTransform = [&](const EntityID& entity) -> TransformComponent* {
+            return dynamic_cast<TransformComponent*>(world.findComponent(entity, TransformComponent::getID()));
+        };
+
+        nodes.clear();
+        nodeIndices.clear();
+        levelStarts.clear();
+
+        // roots: entities with a transform whose parent does not have one (same rule as TransformComponent::toTransformMatrix)
+        levelStarts.push_back(0);
+        for(const EntityID& entity : world.entities) {
+            TransformComponent* pTransform = getTransform(entity);
+            if(pTransform == nullptr) {
+                continue;
+            }
+            auto parentIter = world.entityParents.find(entity);
+            if(parentIter != world.entityParents.end() && getTransform(parentIter->second) != nullptr) {
+                continue;
+            }
+            nodes.emplace_back(Node {
+                .pTransform = pTransform,
+                .entity = entity,
+                .parent = -1,
+            });
+        }
+
+        // then each level is made of the children of the previous one
+        std::size_t levelStart = 0;
+        while(levelStart < nodes.size()) {
+            const std::size_t levelEnd = nodes.size();
+            levelStarts.push_back(levelEnd);
+            for(std::size_t parentIndex = levelStart; parentIndex < levelEnd; parentIndex++) {
+                auto childrenIter = world.entityChildren.find(nodes[parentIndex].entity);
+                if(childrenIter == world.entityChildren.end()) {
+                    continue;
+                }
+                for(const EntityID& child : childrenIter->second) {
+                    TransformComponent* pChildTransform = getTransform(child);
+                    if(pChildTransform == nullptr) {
+                        continue;
+                    }
+                    nodes.emplace_back(Node {
+                        .pTransform = pChildTransform,
+                        .entity = child,
+                        .parent = static_cast<std::int32_t>(parentIndex),
+                    });
+                }
+            }
+            levelStart = levelEnd;
+        }
+
+        const std::size_t nodeCount = nodes.size();
+        dirty.assign(nodeCount, 0);
+        fullUpdate = true;
+        globalMatrices.resize(nodeCount);
+        renderedMatrices.resize(nodeCount);
+        hasRendered.assign(nodeCount, 0);
+        lastFrameMatrices.resize(nodeCount);
+        hasLastFrame.assign(nodeCount, 0);
+        globalRotations.resize(nodeCount);
+        globalScales.resize(nodeCount);
+        for(std::size_t i = 0; i < nodeCount; i++) {
+            nodes[i].pTransform->hierarchySlot = static_cast<std::uint32_t>(i);
+            nodeIndices[nodes[i].entity] = static_cast<std::uint32_t>(i);
+
+            auto previousIter = previousMatrices.find(nodes[i].entity);
+            if(previousIter != previousMatrices.end()) {
+                globalMatrices[i] = previousIter->second.current;
+                renderedMatrices[i] = previousIter->second.rendered;
+                hasRendered[i] = previousIter->second.hasRendered ? 1 : 0;
+                lastFrameMatrices[i] = previousIter->second.lastFrame;
+                hasLastFrame[i] = previousIter->second.hasLastFrame ? 1 : 0;
+            }
+        }
+    }
+
+    bool TransformHierarchy::isUpToDate(const TransformComponent& transform) const {
+        if(structureDirty.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const std::uint32_t slot = transform.hierarchySlot;
+        if(slot >= nodes.size() || nodes[slot].pTransform != &transform) {
+            // not part of the hierarchy yet, or slot copied from another component
+            return false;
+        }
+        // a change to an ancestor changes the world transform of the whole subtree
+        for(std::int32_t nodeIndex = static_cast<std::int32_t>(slot); nodeIndex >= 0; nodeIndex = nodes[nodeIndex].parent) {
+            const Node& node = nodes[nodeIndex];
+            if(!isSameTransform(node.pTransform->localTransform, node.cachedLocal)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool TransformHierarchy::tryGetGlobalMatrix(const TransformComponent& transform, glm::mat4& out) const {
+        if(!isUpToDate(transform)) {
+            return false;
+        }
+        out = globalMatrices[transform.hierarchySlot];
+        return true;
+    }
+
+    bool TransformHierarchy::tryGetLastFrameGlobalMatrix(const TransformComponent& transform, glm::mat4& out) const {
+        if(structureDirty.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const std::uint32_t slot = transform.hierarchySlot;
+        if(slot >= nodes.size() || nodes[slot].pTransform != &transform || !hasLastFrame[slot]) {
+            return false;
+        }
+        // the last frame cannot change anymore, no need to check local transforms
+        out = lastFrameMatrices[slot];
+        return true;
+    }
+
+    bool TransformHierarchy::tryGetGlobalRotation(const TransformComponent& transform, glm::quat& out) const {
+        if(!isUpToDate(transform)) {
+            return false;
+        }
+        out = globalRotations[transform.hierarchySlot];
+        return true;
+    }
+
+    bool TransformHierarchy::tryGetGlobalScale(const TransformComponent& transform, glm::vec3& out) const {
+        if(!isUpToDate(transform)) {
+            return false;
+        }
+        out = globalScales[transform.hierarchySlot];
+        return true;
+    }
+}
@@ -0,0 +1,104 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <engine/math/Transform.h>
+#include <engine/ecs/EntityTypes.h>
+
+namespace Carrot::ECS {
+    class World;
+    struct TransformComponent;
+
+    /**
+     * Cache of the world-space transforms of all entities with a TransformComponent, stored in a flat array ordered by depth
+     * inside the hierarchy (parents are always before their children).
+     *
+     * Local transforms are written directly by gameplay code, so changes are detected by comparing each local transform with
+     * the one used for the last update: an entity whose local transform changed marks its whole subtree as dirty, and only
+     * dirty entities get their world transform recomputed. Dirty entities also get their TransformComponent marked as changed
+     * in the World (see World::markComponentChanged).
+     *
+     * Reads are thread-safe, never update the cache, and cost O(depth): if the local transform of the entity or of one of its
+     * ancestors changed since the last update, the tryGet* methods return false and callers compute the value themselves.
+     *
+     * The flat array is only rebuilt when a TransformComponent is added, removed or reparented. Other component changes only
+     * refresh the pointers to the TransformComponents which moved in memory.
+     *
+     * The world matrices computed by the update of each frame (World::onFrame) are kept aside, and become the matrices of the
+     * last frame at the next frame, to provide the transforms used for motion vectors. Updates done between frames
+     * (World::prePhysics) do not change them.
+     */
+    class TransformHierarchy {
+    public:
+        explicit TransformHierarchy(World& world);
+
+        /// Transforms were added/removed or reparented: the flat array needs to be rebuilt.
+        /// The cache is not used until the next update
+        void invalidateStructure();
+
+        /// Is this entity part of the hierarchy, as of the last rebuild?
+        bool contains(const EntityID& entity) const;
+
+        /// Components of this entity were added or removed. The structure is invalidated only if this changed whether the entity has
+        /// a transform, the pointer to its transform is refreshed otherwise. Processed at the start of the next update. Not thread-safe
+        void markEntityUpdated(const EntityID& entity);
+
+        /// The TransformComponent of these entities may have moved in memory (see World::refreshRelocatedEntities): update the
+        /// pointers to them. Not thread-safe
+        void refreshComponents(std::span<const EntityID> relocated);
+
+        /// Rebuilds the flat array if needed, then recomputes the world transforms of dirty subtrees, one hierarchy level at a time
+        /// in parallel. If 'newFrame' is true, the matrices rendered by the previous frame become the matrices of the last frame,
+        /// and the updated matrices are the ones rendered by this frame.
+        /// Not thread-safe.
+        void update(bool newFrame);
+
+    public: // cache access, return false if the cached value cannot be used
+        bool tryGetGlobalMatrix(const TransformComponent& transform, glm::mat4& out) const;
+        bool tryGetLastFrameGlobalMatrix(const TransformComponent& transform, glm::mat4& out) const;
+        bool tryGetGlobalRotation(const TransformComponent& transform, glm::quat& out) const;
+        bool tryGetGlobalScale(const TransformComponent& transform, glm::vec3& out) const;
+
+    private:
+        /// Is the value cached for this transform up-to-date? Checks the local transforms of this entity and of its ancestors
+        bool isUpToDate(const TransformComponent& transform) const;
+
+        void rebuild();
+        void updateNode(std::size_t nodeIndex);
+
+    private:
+        struct Node {
+            TransformComponent* pTransform = nullptr;
+            EntityID entity;
+            std::int32_t parent = -1; //< index of the node of the parent, -1 for roots (or if the parent has no TransformComponent)
+            Carrot::Math::Transform cachedLocal; //< local transform used to compute the cached values
+        };
+
+        World& world;
+        std::atomic<bool> structureDirty = true;
+        std::vector<EntityID> entitiesUpdated; //< see markEntityUpdated
+
+        std::vector<Node> nodes;
+        std::unordered_map<EntityID, std::uint32_t> nodeIndices;
+        std::vector<std::size_t> levelStarts; //< index of the first node of each depth level, plus one past the last node
+        std::vector<std::uint8_t> dirty; //< recomputed by the last update, not a vector<bool> to be able to write to different elements concurrently
+        bool fullUpdate = true; //< recompute all nodes during the next update, after a rebuild
+
+        std::vector<glm::mat4> globalMatrices;
+        std::vector<glm::mat4> renderedMatrices; //< world matrices computed by the last frame update
+        std::vector<std::uint8_t> hasRendered; //< false for nodes added since the last frame update
+        std::vector<glm::mat4> lastFrameMatrices; //< world matrices of the frame before the current one
+        std::vector<std::uint8_t> hasLastFrame; //< false for nodes which were not part of the frame before the current one
+        std::vector<glm::quat> globalRotations;
+        std::vector<glm::vec3> globalScales;
+    };
+}
@@ -135,7 +135,7 @@ namespace Carrot::ECS {
     Entity& Entity::removeComponent(const ComponentID& componentID) {
         auto& componentMap = getWorld().entityComponents[internalEntity];
         componentMap.erase(componentID);
-        getWorld().entitiesUpdated.push_back(internalEntity);
+        getWorld().markEntityUpdated(internalEntity);
         return *this;
     }
 
@@ -176,8 +176,14 @@ namespace Carrot::ECS {
         return result;
     }
 
+    void World::markEntityUpdated(const EntityID& entity) {
+        entitiesUpdated.push_back(entity);
+        transformHierarchy.markEntityUpdated(entity);
+    }
+
     void World::updateEntityLists() {
         if(!entitiesUpdated.empty()) {
+            placeUpdatedEntities();
             for(const auto& logic : logicSystems) {
                 logic->onEntitiesUpdated(entitiesUpdated);
             }
@@ -185,36 +191,292 @@ namespace Carrot::ECS {
                 render->onEntitiesUpdated(entitiesUpdated);
             }
         }
+        refreshRelocatedEntities();
+    }
+
+    void World::placeUpdatedEntities() {
+        if(componentStorage != ComponentStorage::Archetypes) {
+            return;
+        }
+        // entities which are not placed yet will be placed when they are added to the world
+        for(const auto& e : entitiesUpdated) {
+            if(entityLocations.contains(e)) {
+                placeInArchetype(e);
+            }
+        }
+    }
+
+    void World::refreshRelocatedEntities() {
+        if(entitiesRelocated.empty()) {
+            return;
+        }
+
+        // entities can be moved multiple times, and removed entities have nothing left to refresh
+        std::unordered_set<EntityID> seen;
+        std::vector<EntityID> relocated;
+        relocated.reserve(entitiesRelocated.size());
+        for(const EntityID& entity : entitiesRelocated) {
+            if(entityComponents.contains(entity) && seen.insert(entity).second) {
+                relocated.push_back(entity);
+            }
+        }
+        entitiesRelocated.clear();
+
+        for(auto& [querySignature, query] : queries) {
+            for(const EntityID& entity : relocated) {
+                if(query.indices.contains(entity)) {
+                    addToQuery(query, entity);
+                }
+            }
+        }
+        for(const auto& logic : logicSystems) {
+            logic->refreshComponents(relocated);
+        }
+        for(const auto& render : renderSystems) {
+            render->refreshComponents(relocated);
+        }
+        transformHierarchy.refreshComponents(relocated);
     }
 
-    void World::invalidateQueries() {
+    void World::updateQueries() {
         ZoneScoped;
-        // maybe there's a smarter thing to do: add and remove entities from queries directly instead of recomputing query result
-        // maybe for the future
-        for(const auto& entitySet : { entitiesToAdd, entitiesToRemove }) {
-            for(const auto& e : entitySet) {
-                const Signature entitySignature = getSignature(wrap(e));
-
-                // if entity matches all components from the query signature, remove the query
-                std::erase_if(queries, [&](const QueryResult& query) {
-                    if((entitySignature & query.signature) == query.signature) {
-                        return true;
-                    }
-                    return false;
-                });
+        if(queries.empty()) {
+            return;
+        }
+
+        for(const auto& e : entitiesToAdd) {
+            const Signature entitySignature = getSignature(wrap(e));
+            for(auto& [querySignature, query] : queries) {
+                if(entitySignature.contains(querySignature)) {
+                    addToQuery(query, e);
+                }
             }
         }
 
-        // entity updates are a bit more involved: the entity signature may no longer match the current signature
+        // entity updates are a bit more involved: the entity may start or stop matching a query, or have some of its components replaced
         for(const auto& e : entitiesUpdated) {
-            std::erase_if(queries, [&](const QueryResult& query) {
-                for(const auto& queryEntity : query.matchingEntities) {
-                    if(queryEntity.entity.getID() == e) {
-                        return true;
-                    }
+            const Signature entitySignature = getSignature(wrap(e));
+            for(auto& [querySignature, query] : queries) {
+                if(entitySignature.contains(querySignature)) {
+                    addToQuery(query, e);
+                } else {
+                    removeFromQuery(query, e);
                 }
-                return false;
-            });
+            }
+        }
+
+        for(const auto& e : entitiesToRemove) {
+            for(auto& [querySignature, query] : queries) {
+                removeFromQuery(query, e);
+            }
+        }
+    }
+
+    void World::addToQuery(QueryResult& query, const EntityID& entity) {
+        auto [iter, inserted] = query.indices.try_emplace(entity, query.matchingEntities.size());
+        if(inserted) {
+            query.matchingEntities.emplace_back();
+        }
+        const Entity wrapped = wrap(entity);
+        fillComponents(query.signature, std::span { &wrapped, 1 }, std::span { &query.matchingEntities[iter->second], 1 });
+    }
+
+    void World::removeFromQuery(QueryResult& query, const EntityID& entity) {
+        auto iter = query.indices.find(entity);
+        if(iter == query.indices.end()) {
+            return;
+        }
+
+        const std::size_t index = iter->second;
+        query.indices.erase(iter);
+        if(index != query.matchingEntities.size() - 1) {
+            query.matchingEntities[index] = std::move(query.matchingEntities.back());
+            query.indices[query.matchingEntities[index].entity.getID()] = index;
+        }
+        query.matchingEntities.pop_back();
+    }
+
+    std::uint64_t World::nextChangeVersion() {
+        return lastChangeVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    void World::markComponentChanged(const EntityID& entity, ComponentID componentID) {
+        markComponentChanged(entity, componentID, nextChangeVersion());
+    }
+
+    void World::markComponentChanged(const EntityID& entity, ComponentID componentID, std::uint64_t version) {
+        auto locationIter = entityLocations.find(entity);
+        if(locationIter == entityLocations.end()) {
+            return;
+        }
+
+        const ArchetypeLocation& location = locationIter->second;
+        Archetype& archetype = *location.pArchetype;
+        if(!archetype.getSignature().hasComponent(componentID)) {
+            return;
+        }
+        archetype.getChunks()[location.chunkIndex]->markChanged(location.row, archetype.getColumnIndex(componentID), version);
+    }
+
+    ComponentStorage World::getComponentStorage() const {
+        return componentStorage;
+    }
+
+    void World::setComponentStorage(ComponentStorage storage) {
+        if(componentStorage == storage) {
+            return;
+        }
+        componentStorage = storage;
+        rebuildArchetypes();
+        refreshRelocatedEntities();
+    }
+
+    void World::updateMatchingArchetypes(const Signature& signature, ArchetypeQueryCache& cache) const {
+        if(cache.generation != archetypeGeneration) {
+            cache.archetypes.clear();
+            cache.checkedArchetypeCount = 0;
+            cache.generation = archetypeGeneration;
+        }
+
+        // archetypes are only appended, so only the new ones need to be checked
+        for(std::size_t i = cache.checkedArchetypeCount; i < archetypes.size(); i++) {
+            Archetype* pArchetype = archetypes[i].get();
+            if(pArchetype->getSignature().contains(signature)) {
+                cache.archetypes.push_back(pArchetype);
+            }
+        }
+        cache.checkedArchetypeCount = archetypes.size();
+    }
+
+    Archetype& World::getOrCreateArchetype(const Signature& signature, std::span<Component* const> components) {
+        auto iter = archetypesBySignature.find(signature);
+        if(iter != archetypesBySignature.end()) {
+            return *iter->second;
+        }
+
+        // the first entity decides how each column stores its components
+        std::vector<const ComponentLayout*> columnLayouts(components.size());
+        for(std::size_t column = 0; column < components.size(); column++) {
+            columnLayouts[column] = components[column]->getStorageLayout();
+        }
+        Archetype* pArchetype = archetypes.emplace_back(std::make_unique<Archetype>(signature, std::move(columnLayouts))).get();
+        archetypesBySignature[signature] = pArchetype;
+        return *pArchetype;
+    }
+
+    void World::placeInArchetype(const EntityID& entity) {
+        const Signature entitySignature = getSignature(wrap(entity));
+
+        std::optional<ArchetypeLocation> previousLocation;
+        if(auto locationIter = entityLocations.find(entity); locationIter != entityLocations.end()) {
+            previousLocation = locationIter->second;
+        }
+
+        // current component of each column: on the heap if it was just added, inside the previous chunk otherwise
+        std::vector<Component*> components(entitySignature.getComponentCount());
+        auto componentsIter = entityComponents.find(entity);
+        if(componentsIter != entityComponents.end()) {
+            for(const auto& [componentID, pComponent] : componentsIter->second) {
+                components[entitySignature.getComponentIndex(componentID)] = resolveComponent(entity, componentID, pComponent);
+            }
+        }
+
+        Archetype& archetype = getOrCreateArchetype(entitySignature, components);
+        const std::uint64_t version = nextChangeVersion();
+        if(previousLocation.has_value() && previousLocation->pArchetype == &archetype) {
+            // same signature, only components which were replaced need to be stored
+            if(componentsIter == entityComponents.end()) {
+                return;
+            }
+            for(auto& [componentID, pComponent] : componentsIter->second) {
+                if(!pComponent) {
+                    continue;
+                }
+                const std::size_t column = archetype.getColumnIndex(componentID);
+                if(archetype.getColumnLayout(column) == nullptr && &archetype.getComponent(*previousLocation, column) == pComponent.get()) {
+                    continue; // components which are not stored by value stay on the heap, this one is already referenced
+                }
+                archetype.replaceComponent(*previousLocation, column, *pComponent, version);
+                if(archetype.getColumnLayout(column) != nullptr) {
+                    pComponent.reset(); // moved inside the chunk
+                }
+                entitiesRelocated.push_back(entity);
+            }
+            return;
+        }
+
+        for(std::size_t column = 0; column < components.size(); column++) {
+            verify(components[column]->getStorageLayout() == archetype.getColumnLayout(column), "Components of the same type must all be stored the same way");
+        }
+        entityLocations[entity] = archetype.add(entity, components, version);
+        entitiesRelocated.push_back(entity);
+        if(componentsIter != entityComponents.end()) {
+            for(auto& [componentID, pComponent] : componentsIter->second) {
+                if(pComponent && archetype.getColumnLayout(archetype.getColumnIndex(componentID)) != nullptr) {
+                    pComponent.reset(); // moved inside the chunk
+                }
+            }
+        }
+
+        if(previousLocation.has_value()) {
+            // also destroys the moved-from components, and the ones which were removed from the entity
+            std::optional<EntityID> movedEntity = previousLocation->pArchetype->remove(*previousLocation);
+            if(movedEntity.has_value()) {
+                entityLocations[movedEntity.value()] = *previousLocation;
+                entitiesRelocated.push_back(movedEntity.value());
+            }
+        }
+    }
+
+    void World::removeFromArchetype(const EntityID& entity) {
+        auto locationIter = entityLocations.find(entity);
+        if(locationIter == entityLocations.end()) {
+            return;
+        }
+
+        const ArchetypeLocation location = locationIter->second;
+        entityLocations.erase(locationIter);
+        std::optional<EntityID> movedEntity = location.pArchetype->remove(location);
+        if(movedEntity.has_value()) {
+            entityLocations[movedEntity.value()] = location;
+            entitiesRelocated.push_back(movedEntity.value());
+        }
+    }
+
+    void World::moveComponentsToHeap() {
+        for(const auto& [entity, location] : entityLocations) {
+            auto componentsIter = entityComponents.find(entity);
+            if(componentsIter == entityComponents.end()) {
+                continue;
+            }
+            for(auto& [componentID, pComponent] : componentsIter->second) {
+                if(pComponent) {
+                    continue;
+                }
+                const std::size_t column = location.pArchetype->getColumnIndex(componentID);
+                pComponent = location.pArchetype->getColumnLayout(column)->moveToHeap(location.pArchetype->getComponent(location, column));
+            }
+            entitiesRelocated.push_back(entity);
+        }
+        // the moved-from components are destroyed with their archetype
+    }
+
+    void World::clearArchetypes() {
+        entityLocations.clear();
+        archetypesBySignature.clear();
+        archetypes.clear();
+        archetypeGeneration++;
+    }
+
+    void World::rebuildArchetypes() {
+        moveComponentsToHeap();
+        clearArchetypes();
+
+        if(componentStorage != ComponentStorage::Archetypes) {
+            return;
+        }
+        for(const auto& entity : entities) {
+            placeInArchetype(entity);
         }
     }
 
@@ -227,9 +489,9 @@ namespace Carrot::ECS {
             return iter->second;
         };
 
-        for (auto& [_, components] : entityComponents) {
-            for (auto& [_, pComponent] : components) {
-                pComponent->repairLinks(remap);
+        for (auto& [entity, components] : entityComponents) {
+            for (auto& [componentID, pComponent] : components) {
+                resolveComponent(entity, componentID, pComponent)->repairLinks(remap);
             }
         };
     }
@@ -246,7 +508,7 @@ namespace Carrot::ECS {
         std::function<void(const Carrot::ECS::Entity&)> recurse = [&](const Carrot::ECS::Entity& e) {
             auto& components = entityComponents[e.getID()];
             for (auto& [componentID, pComponent] : components) {
-                pComponent->repairLinks(remap);
+                resolveComponent(e.getID(), componentID, pComponent)->repairLinks(remap);
             }
 
             auto& children = entityChildren[e.getID()];
@@ -259,10 +521,25 @@ namespace Carrot::ECS {
     }
 
     void World::flushEntityCreationAndRemoval() {
+        // only entities with a transform are part of the transform hierarchy
+        const bool addsTransforms = std::any_of(entitiesToAdd.begin(), entitiesToAdd.end(), [&](const EntityID& entity) {
+            return findComponent(entity, TransformComponent::getID()) != nullptr;
+        });
+        const bool removesTransforms = std::any_of(entitiesToRemove.begin(), entitiesToRemove.end(), [&](const EntityID& entity) {
+            return transformHierarchy.contains(entity);
+        });
+        if(addsTransforms || removesTransforms) {
+            transformHierarchy.invalidateStructure();
+        }
         for(const auto& toAdd : entitiesToAdd) {
             entities.push_back(toAdd);
+            if(componentStorage == ComponentStorage::Archetypes) {
+                placeInArchetype(toAdd);
+            }
         }
-        invalidateQueries();
+        // queries must see the final location of components stored by value
+        placeUpdatedEntities();
+        updateQueries();
         if(!entitiesToAdd.empty()) {
             for(const auto& logic : logicSystems) {
                 logic->onEntitiesAdded(entitiesToAdd);
@@ -294,6 +571,7 @@ namespace Carrot::ECS {
                     if (entities[index] != toRemove) {
                         continue;
                     }
+                    removeFromArchetype(toRemove);
                     auto it = entityComponents.find(toRemove);
                     if (it != entityComponents.end()) {
                         entityComponents.erase(it);
@@ -304,12 +582,26 @@ namespace Carrot::ECS {
                 entityChildren.erase(toRemove);
                 entityNames.erase(toRemove);
             }
+            // removing entities from their archetype moved other entities in their place
+            refreshRelocatedEntities();
         }
         entitiesToAdd.clear();
         entitiesToRemove.clear();
         entitiesUpdated.clear();
     }
 
+    void World::gatherSystemsToRun(bool includeLogic) {
+        scheduledSystems.clear();
+        if(includeLogic) {
+            for(const auto& logic : logicSystems) {
+                scheduledSystems.push_back(logic.get());
+            }
+        }
+        for(const auto& render : renderSystems) {
+            scheduledSystems.push_back(render.get());
+        }
+    }
+
     void World::tick(double dt) {
         flushEntityCreationAndRemoval();
 
@@ -318,52 +610,48 @@ namespace Carrot::ECS {
                 pSystem->firstTick();
             }
             logicSystemsWaitingForFirstTick.clear();
-            for(const auto& logic : logicSystems) {
-                logic->tick(dt);
-            }
         }
 
         for (auto& pSystem : renderSystemsWaitingForFirstTick) {
             pSystem->firstTick();
         }
         renderSystemsWaitingForFirstTick.clear();
-        for(const auto& render : renderSystems) {
-            render->tick(dt);
-        }
+
+        gatherSystemsToRun(!frozenLogic);
+        systemScheduler.run(SystemPhase::Tick, scheduledSystems, [dt](System& system) {
+            system.tick(dt);
+        });
 
         worldData.update();
     }
 
     void World::prePhysics() {
+        // systems reading transforms during physics updates (eg rigidbodies) get up-to-date cached transforms and change versions
+        transformHierarchy.update(false);
+
         if(!frozenLogic) {
             for (auto& pSystem : logicSystemsWaitingForFirstTick) {
                 pSystem->firstTick();
             }
             logicSystemsWaitingForFirstTick.clear();
-            for(const auto& logic : logicSystems) {
-                logic->prePhysics();
-            }
         }
 
         for (auto& pSystem : renderSystemsWaitingForFirstTick) {
             pSystem->firstTick();
         }
         renderSystemsWaitingForFirstTick.clear();
-        for(const auto& render : renderSystems) {
-            render->prePhysics();
-        }
+
+        gatherSystemsToRun(!frozenLogic);
+        systemScheduler.run(SystemPhase::PrePhysics, scheduledSystems, [](System& system) {
+            system.prePhysics();
+        });
     }
 
     void World::postPhysics() {
-        if(!frozenLogic) {
-            for(const auto& logic : logicSystems) {
-                logic->postPhysics();
-            }
-        }
-
-        for(const auto& render : renderSystems) {
-            render->postPhysics();
-        }
+        gatherSystemsToRun(!frozenLogic);
+        systemScheduler.run(SystemPhase::PostPhysics, scheduledSystems, [](System& system) {
+            system.postPhysics();
+        });
     }
 
     static Carrot::RuntimeOption showWorldHierarchy("Debug/Show World hierarchy", false);
@@ -384,28 +672,20 @@ namespace Carrot::ECS {
     void World::onFrame(Carrot::Render::Context renderContext) {
         ZoneScoped;
 
-        if (lastRenderedFrame != renderContext.frameNumber) {
+        const bool newFrame = lastRenderedFrame != renderContext.frameNumber;
+        if (newFrame) {
             lighting.onFrame(renderContext);
             lastRenderedFrame = renderContext.frameNumber;
         }
 
         updateEntityLists();
+        transformHierarchy.update(newFrame);
         {
-            ZoneScopedN("Logic");
-            for(const auto& logic : logicSystems) {
-                ZoneScopedN("LogicSystem");
-                ZoneText(typeid(*logic).name(), std::strlen(typeid(*logic).name()));
-                logic->onFrame(renderContext);
-            }
-        }
-
-        {
-            ZoneScopedN("Prepare render");
-            for(const auto& render : renderSystems) {
-                ZoneScopedN("RenderSystem");
-                ZoneText(typeid(*render).name(), std::strlen(typeid(*render).name()));
-                render->onFrame(renderContext);
-            }
+            ZoneScopedN("Logic & prepare render");
+            gatherSystemsToRun(true);
+            systemScheduler.run(SystemPhase::Frame, scheduledSystems, [&](System& system) {
+                system.onFrame(renderContext);
+            });
         }
 
         {
@@ -483,6 +763,10 @@ namespace Carrot::ECS {
 
     void World::setParent(const Entity& toSet, std::optional<Entity> parent) {
         assert(toSet);
+        if(findComponent(toSet.getID(), TransformComponent::getID()) != nullptr) {
+            // roots of the hierarchy are entities whose parent has no transform: reparenting other entities changes nothing
+            transformHierarchy.invalidateStructure();
+        }
         auto previousParent = entityParents.find(toSet);
         if(previousParent != entityParents.end()) {
             auto& parentChildren = entityChildren[previousParent->second];
@@ -613,47 +897,65 @@ namespace Carrot::ECS {
     }
 
     std::span<const EntityWithComponents> World::queryEntities(const Signature& signature) {
-        for(auto& query : queries) {
-            if(query.signature == signature) {
-                return query.matchingEntities;
-            }
+        auto [iter, inserted] = queries.try_emplace(signature);
+        QueryResult& query = iter->second;
+        if(!inserted) {
+            // kept up-to-date by updateQueries
+            return query.matchingEntities;
         }
 
-        QueryResult& newQuery = queries.emplace_back();
-        newQuery.signature = signature;
+        query.signature = signature;
         std::vector<Entity> result;
-        for(const auto& entityID : entities) {
-            auto entity = wrap(entityID);
-            if((getSignature(entity) & signature) == signature) {
-                result.push_back(entity);
+        if(componentStorage == ComponentStorage::Archetypes) {
+            // only compare the signature of each archetype instead of the signature of each entity
+            for(const auto& pArchetype : archetypes) {
+                if(!pArchetype->getSignature().contains(signature)) {
+                    continue;
+                }
+                for(const auto& pChunk : pArchetype->getChunks()) {
+                    for(std::size_t row = 0; row < pChunk->size(); row++) {
+                        result.push_back(wrap(pChunk->getEntity(row)));
+                    }
+                }
+            }
+        } else {
+            for(const auto& entityID : entities) {
+                auto entity = wrap(entityID);
+                if(getSignature(entity).contains(signature)) {
+                    result.push_back(entity);
+                }
             }
         }
-        newQuery.matchingEntities.resize(result.size());
+        query.matchingEntities.resize(result.size());
+        query.indices.reserve(result.size());
+        for(std::size_t i = 0; i < result.size(); i++) {
+            query.indices[result[i].getID()] = i;
+        }
 
-        fillComponents(newQuery.signature, result, newQuery.matchingEntities);
-        return newQuery.matchingEntities;
+        fillComponents(query.signature, result, query.matchingEntities);
+        return query.matchingEntities;
     }
 
     void World::fillComponents(const Signature& signature, std::span<const Entity> _entities, std::span<EntityWithComponents> entitiesWithComponents) {
         verify(_entities.size() == entitiesWithComponents.size(), "entities.size() != entitiesWithComponents.size()");
         std::size_t componentCount = signature.getComponentCount();
 
-        for(std::size_t componentID = 0; componentID < MAX_COMPONENTS; componentID++) {
-            if(signature.hasComponent(componentID)) {
-                Signature::IndexType componentIndex = signature.getComponentIndex(componentID);
-
-                for(std::size_t i = 0; i < _entities.size(); i++) {
-                    auto& withComponents = entitiesWithComponents[i];
-                    const auto& entity = _entities[i];
-                    withComponents.entity = entity;
-                    withComponents.components.resize(componentCount);
+        for(std::size_t i = 0; i < _entities.size(); i++) {
+            entitiesWithComponents[i].entity = _entities[i];
+            entitiesWithComponents[i].components.resize(componentCount);
+        }
 
-                    Memory::OptionalRef<Component> component = entity.getComponent(componentID);
-                    verify(component.hasValue(), "Component is not in entity??");
-                    withComponents.components[componentIndex] = component.asPtr();
-                }
+        // components are ordered by their index inside the signature
+        Signature::IndexType componentIndex = 0;
+        signature.forEachComponentIndex([&](std::size_t index) {
+            const ComponentID componentID = Signature::getComponentID(index);
+            for(std::size_t i = 0; i < _entities.size(); i++) {
+                Memory::OptionalRef<Component> component = _entities[i].getComponent(componentID);
+                verify(component.hasValue(), "Component is not in entity??");
+                entitiesWithComponents[i].components[componentIndex] = component.asPtr();
             }
-        }
+            componentIndex++;
+        });
     }
 
     std::string& World::getName(const Entity& entity) {
@@ -706,7 +1008,7 @@ namespace Carrot::ECS {
             return Carrot::Vector<Component*>{};
         }
         for(auto& [id, comp] : iter->second) {
-            comps.pushBack(comp.get());
+            comps.pushBack(resolveComponent(entityID, id, comp));
         }
         return comps;
     }
@@ -716,20 +1018,36 @@ namespace Carrot::ECS {
     }
 
     Memory::OptionalRef<Component> World::getComponent(const EntityID& entityID, ComponentID component) const {
+        return findComponent(entityID, component);
+    }
+
+    Component* World::findComponent(const EntityID& entityID, ComponentID componentID) const {
         auto componentMapLocation = this->entityComponents.find(entityID);
         if(componentMapLocation == this->entityComponents.end()) {
             // no such entity
-            return {};
+            return nullptr;
         }
 
         auto& componentMap = componentMapLocation->second;
-        auto componentLocation = componentMap.find(component);
+        auto componentLocation = componentMap.find(componentID);
 
         if(componentLocation == componentMap.end()) {
             // no such component
-            return {};
+            return nullptr;
         }
-        return componentLocation->second.get();
+        return resolveComponent(entityID, componentID, componentLocation->second);
+    }
+
+    Component* World::resolveComponent(const EntityID& entity, ComponentID componentID, const std::unique_ptr<Component>& owned) const {
+        if(owned) {
+            return owned.get();
+        }
+
+        // stored by value inside the chunk of the entity
+        auto locationIter = entityLocations.find(entity);
+        verify(locationIter != entityLocations.end(), "Component is stored by value, but its entity is not inside an archetype");
+        const ArchetypeLocation& location = locationIter->second;
+        return &location.pArchetype->getComponent(location, location.pArchetype->getColumnIndex(componentID));
     }
 
     Entity World::wrap(EntityID id) const {
@@ -747,15 +1065,21 @@ namespace Carrot::ECS {
         entitiesToAdd = toCopy.entitiesToAdd;
         entitiesToRemove = toCopy.entitiesToRemove;
         frozenLogic = toCopy.frozenLogic;
+        componentStorage = toCopy.componentStorage;
+        systemScheduler.setScheduling(toCopy.systemScheduler.getScheduling());
+        clearArchetypes(); // destroys the components stored by value before their entities are forgotten
+        entitiesRelocated.clear();
         entityComponents.clear();
         lighting.getAmbientLight() = toCopy.getLighting().getAmbientLight();
 
         for(const auto& [entityID, componentMap] : toCopy.entityComponents) {
             auto& destComponents = entityComponents[entityID];
             for(const auto& [id, comp] : componentMap) {
-                destComponents[id] = comp->duplicate(wrap(entityID));
+                destComponents[id] = toCopy.resolveComponent(entityID, id, comp)->duplicate(wrap(entityID));
             }
         }
+        rebuildArchetypes();
+        transformHierarchy.invalidateStructure();
 
         auto copySystems = [&](std::vector<System*>& waitingForFirstTick, std::vector<std::unique_ptr<System>>& dest, const std::vector<std::unique_ptr<System>>& src) {
             dest.clear();
@@ -766,6 +1090,7 @@ namespace Carrot::ECS {
                 for(const auto& srcEntity : src[i]->entities) {
                     dest[i]->entities.emplace_back(srcEntity.internalEntity, *this);
                 }
+                dest[i]->recreateEntityWithComponentsList();
                 dest[i]->onEntitiesUpdated({});
                 waitingForFirstTick.emplace_back(dest[i].get());
             }
@@ -788,7 +1113,7 @@ namespace Carrot::ECS {
 
         for (auto& [entity, componentList] : entityComponents) {
             for (auto& [id, pComp] : componentList) {
-                pComp->reloadComponent();
+                resolveComponent(entity, id, pComp)->reloadComponent();
             }
         }
     }
@@ -803,7 +1128,7 @@ namespace Carrot::ECS {
 
         for (auto& [entity, componentList] : entityComponents) {
             for (auto& [id, pComp] : componentList) {
-                pComp->unloadComponent();
+                resolveComponent(entity, id, pComp)->unloadComponent();
             }
         }
     }
@@ -3,6 +3,7 @@
 //
 
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
 #include <memory>
@@ -15,6 +16,9 @@
 #include <engine/render/lighting/Lights.h>
 #include <eventpp/callbacklist.h>
 
+#include "Archetypes.h"
+#include "SystemScheduler.h"
+#include "TransformHierarchy.h"
 #include "EntityTypes.h"
 
 namespace Carrot::ECS {
@@ -86,6 +90,40 @@ namespace Carrot::ECS {
         Carrot::Vector<Component*> getAllComponents(const Entity& ent) const;
         Carrot::Vector<Component*> getAllComponents(const EntityID& ent) const;
 
+    public: // component storage
+        /// How components are stored for iteration by systems. Archetypes by default.
+        ComponentStorage getComponentStorage() const;
+
+        /// Changes how components are stored for iteration by systems. Switching to Archetypes regroups all existing entities.
+        /// Not thread-safe, should not be called while systems are iterating over entities
+        void setComponentStorage(ComponentStorage storage);
+
+        /// Adds to 'cache' the archetypes created since its last update and which contain all components of 'signature'.
+        /// Only meaningful when using ComponentStorage::Archetypes
+        void updateMatchingArchetypes(const Signature& signature, ArchetypeQueryCache& cache) const;
+
+    public: // change tracking
+        /// Returns a version number higher than all the previously returned ones. Thread-safe.
+        /// Changes of components are stamped with such versions, so that systems can only iterate over the entities which
+        /// changed since their previous run (see SignedSystem::forEachChangedEntity)
+        std::uint64_t nextChangeVersion();
+
+        /// Marks a component of the given entity as changed.
+        /// Component additions, writes done by systems which declared a write access, and moves of TransformComponent are
+        /// tracked automatically, other modifications (eg gameplay code, systems without declared accesses) must call this method.
+        /// Not thread-safe. Only meaningful when using ComponentStorage::Archetypes
+        void markComponentChanged(const EntityID& entity, ComponentID componentID);
+
+    public: // system scheduling
+        /// Decides how systems are run during tick, prePhysics, postPhysics and onFrame. Also exposes the timings of the last run of each phase
+        SystemScheduler& getSystemScheduler() { return systemScheduler; }
+        const SystemScheduler& getSystemScheduler() const { return systemScheduler; }
+
+    public: // transforms
+        /// Cache of the world transforms of entities, updated at the start of each onFrame
+        TransformHierarchy& getTransformHierarchy() { return transformHierarchy; }
+        const TransformHierarchy& getTransformHierarchy() const { return transformHierarchy; }
+
     public:
         /// Stops the processing of components (no longer calls tick), but still processes added/removed entities
         void freezeLogic() { frozenLogic = true; }
@@ -194,11 +232,53 @@ namespace Carrot::ECS {
         /// (because components can be modified during a tick)
         void updateEntityLists();
 
-        /// Based on entities added, removed and updated (components added/removed), removes cached queries which are impacted
-        ///  by these changes.
-        /// The next call to queryEntities will therefore recompute the proper list of entities matching a signature
-        /// Called *before* changes are applied, because we need to get the signature of entities which are being removed
-        void invalidateQueries();
+        /// Based on entities added, removed and updated (components added/removed), adds and removes entities from the cached queries.
+        /// Called *before* removed entities lose their components
+        void updateQueries();
+
+        /// Adds the given entity to the query, or refreshes its components if it is already inside
+        void addToQuery(QueryResult& query, const EntityID& entity);
+
+        /// Removes the entity from the query, by moving the last entity of the query in its place
+        void removeFromQuery(QueryResult& query, const EntityID& entity);
+
+        /// Marks a component as changed, with an existing version
+        void markComponentChanged(const EntityID& entity, ComponentID componentID, std::uint64_t version);
+
+        /// Moves the given entity to the archetype matching its current signature (or stores its new components if it did not change archetype)
+        void placeInArchetype(const EntityID& entity);
+
+        /// Places the entities whose components were added or removed, if they are already inside an archetype
+        void placeUpdatedEntities();
+
+        /// Removes the given entity from its archetype (destroying the components it stored by value), if it has one
+        void removeFromArchetype(const EntityID& entity);
+
+        /// Regroups all entities inside archetypes from scratch
+        void rebuildArchetypes();
+
+        /// Destroys all archetypes, and the components they store by value
+        void clearArchetypes();
+
+        /// Moves the components stored by value inside archetypes back to the heap, before the archetypes are destroyed
+        void moveComponentsToHeap();
+
+        /// Components stored by value were moved by archetypes: refreshes the component pointers held by queries, systems and the transform hierarchy
+        void refreshRelocatedEntities();
+
+        Archetype& getOrCreateArchetype(const Signature& signature, std::span<Component* const> components);
+
+        /// Component of the given type of an entity, wherever it is stored. nullptr if there is no such component
+        Component* findComponent(const EntityID& entity, ComponentID componentID) const;
+
+        /// Component referenced by an entry of 'entityComponents'
+        Component* resolveComponent(const EntityID& entity, ComponentID componentID, const std::unique_ptr<Component>& owned) const;
+
+        /// Components were added to or removed from the given entity
+        void markEntityUpdated(const EntityID& entity);
+
+        /// Fills 'scheduledSystems' with the systems to run for the current phase: logic systems (unless logic is frozen), then render systems
+        void gatherSystemsToRun(bool includeLogic);
 
     private:
         WorldData worldData;
@@ -209,11 +289,21 @@ namespace Carrot::ECS {
         std::vector<EntityID> entitiesToRemove;
         std::vector<EntityID> entitiesUpdated;
 
+        /// Components of each entity. Components stored by value inside archetype chunks have an empty pointer here:
+        /// they live in the chunk of the entity (see entityLocations), use resolveComponent to access them
         std::unordered_map<EntityID, std::unordered_map<ComponentID, std::unique_ptr<Component>>> entityComponents;
         std::unordered_map<EntityID, EntityFlags> entityFlags;
         std::unordered_map<EntityID, std::string> entityNames;
 
-        std::vector<QueryResult> queries; //< cache result of queries to avoid recomputing the list on each call of queryEntities
+        ComponentStorage componentStorage = ComponentStorage::Archetypes;
+        std::vector<std::unique_ptr<Archetype>> archetypes; //< never removed until a full rebuild, so that pointers to archetypes stay valid
+        std::unordered_map<Signature, Archetype*> archetypesBySignature;
+        std::unordered_map<EntityID, ArchetypeLocation> entityLocations;
+        std::vector<EntityID> entitiesRelocated; //< entities whose components stored by value moved since the last refreshRelocatedEntities
+        std::uint64_t archetypeGeneration = 0; //< incremented each time archetypes are rebuilt from scratch, to invalidate ArchetypeQueryCache
+
+        std::unordered_map<Signature, QueryResult> queries; //< cache result of queries to avoid recomputing the list on each call of queryEntities, updated in place when entities change
+        std::atomic<std::uint64_t> lastChangeVersion { 0 };
 
         std::vector<std::unique_ptr<System>> logicSystems;
         std::vector<std::unique_ptr<System>> renderSystems;
@@ -222,6 +312,11 @@ namespace Carrot::ECS {
 
         bool frozenLogic = false;
 
+        SystemScheduler systemScheduler;
+        std::vector<System*> scheduledSystems; //< kept between phases to avoid reallocating it each time
+
+        TransformHierarchy transformHierarchy { *this };
+
         // used to invalidate structures that hold csharp components
         eventpp::CallbackList<void()>::Handle csharpLoadCallbackHandle;
         eventpp::CallbackList<void()>::Handle csharpUnloadCallbackHandle;
@@ -233,6 +328,7 @@ namespace Carrot::ECS {
         std::unordered_map<EntityID, std::vector<EntityID>> entityChildren;
 
         friend class Entity;
+        friend class TransformHierarchy;
     };
 }
 
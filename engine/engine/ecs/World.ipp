@@ -1,8 +1,14 @@
 #include "World.h"
 #include <algorithm>
+#include <tuple>
 #include <core/async/Counter.h>
 
 namespace Carrot::ECS {
+    namespace Details {
+        template<typename T, typename... Ts>
+        constexpr bool IsOneOf = (std::is_same_v<T, Ts> || ...);
+    }
+
     template<class Comp>
     Memory::OptionalRef<Comp> World::getComponent(const Entity& entity) const {
         return getComponent<Comp>(entity.getID());
@@ -10,27 +16,14 @@ namespace Carrot::ECS {
 
     template<class Comp>
     Memory::OptionalRef<Comp> World::getComponent(const EntityID& entityID) const {
-        auto componentMapLocation = this->entityComponents.find(entityID);
-        if(componentMapLocation == this->entityComponents.end()) {
-            // no such entity
-            return {};
-        }
-
-        auto& componentMap = componentMapLocation->second;
-        auto componentLocation = componentMap.find(Comp::getID());
-
-        if(componentLocation == componentMap.end()) {
-            // no such component
-            return {};
-        }
-        return dynamic_cast<Comp*>(componentLocation->second.get());
+        return dynamic_cast<Comp*>(findComponent(entityID, Comp::getID()));
     }
 
     template<typename Comp>
     Entity& Entity::addComponent(std::unique_ptr<Comp>&& component) {
         auto& componentMap = getWorld().entityComponents[internalEntity];
         componentMap[component->getComponentTypeID()] = std::move(component);
-        getWorld().entitiesUpdated.push_back(internalEntity);
+        getWorld().markEntityUpdated(internalEntity);
         return *this;
     }
 
@@ -38,7 +31,7 @@ namespace Carrot::ECS {
     Entity& Entity::addComponent(Args&&... args) {
         auto& componentMap = getWorld().entityComponents[internalEntity];
         componentMap[Comp::getID()] = std::make_unique<Comp>(*this, args...);
-        getWorld().entitiesUpdated.push_back(internalEntity);
+        getWorld().markEntityUpdated(internalEntity);
         return *this;
     }
 
@@ -46,7 +39,7 @@ namespace Carrot::ECS {
     Entity& Entity::removeComponent() {
         auto& componentMap = getWorld().entityComponents[internalEntity];
         componentMap.erase(Comp::getID());
-        getWorld().entitiesUpdated.push_back(internalEntity);
+        getWorld().markEntityUpdated(internalEntity);
         return *this;
     }
 
@@ -121,34 +114,181 @@ namespace Carrot::ECS {
     }
 
     template<SystemType type, typename... RequiredComponents>
-    void SignedSystem<type, RequiredComponents...>::forEachEntity(const std::function<void(Entity&, RequiredComponents&...)>& action) {
-        for(auto& entity : entitiesWithComponents) {
-            if (entity.entity) {
-                // TODO: lift getComponentIndex out of loop
-                action(entity.entity, (*((RequiredComponents*)entity.components[signature.getComponentIndex(RequiredComponents::getID())]))...);
+    typename SignedSystem<type, RequiredComponents...>::ComponentColumns SignedSystem<type, RequiredComponents...>::getComponentColumns(const Signature& signature) {
+        return ComponentColumns { static_cast<std::size_t>(signature.getComponentIndex(RequiredComponents::getID()))... };
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    template<typename T>
+    typename SignedSystem<type, RequiredComponents...>::template ColumnStart<T> SignedSystem<type, RequiredComponents...>::getColumnStart(const ArchetypeChunk& chunk, std::size_t columnIndex) {
+        if constexpr (T::StoredByValue) {
+            verify(chunk.getLayout(columnIndex) == ComponentLayout::of<T>(), "Column does not store this component type by value");
+            return chunk.getValues<T>(columnIndex);
+        } else {
+            return chunk.getPointers(columnIndex);
+        }
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    template<typename T>
+    T& SignedSystem<type, RequiredComponents...>::getFromColumn(ColumnStart<T> columnStart, std::size_t row) {
+        if constexpr (T::StoredByValue) {
+            return columnStart[row];
+        } else {
+            return *static_cast<T*>(columnStart[row]);
+        }
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    template<typename... ChangedComponents>
+    typename SignedSystem<type, RequiredComponents...>::Iteration SignedSystem<type, RequiredComponents...>::makeIteration(bool filterOnChanges) {
+        static_assert((Details::IsOneOf<ChangedComponents, RequiredComponents...> && ...), "Changes can only be filtered on components required by the system");
+
+        Iteration iteration;
+        iteration.filterOnChanges = filterOnChanges;
+        iteration.changeFilter = ComponentFlags { Details::IsOneOf<RequiredComponents, ChangedComponents...>... };
+        iteration.changedSince = getChangeFilterVersion();
+        if(componentAccess.declared) {
+            iteration.writes = ComponentFlags { componentAccess.writes.hasComponent(RequiredComponents::getID())... };
+            if(std::find(iteration.writes.begin(), iteration.writes.end(), true) != iteration.writes.end()) {
+                iteration.writeVersion = getWriteVersion();
             }
         }
+        return iteration;
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    void SignedSystem<type, RequiredComponents...>::forEachEntityInChunk(ArchetypeChunk& chunk, const ComponentColumns& columns, const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        [&]<std::size_t... ComponentIndex>(std::index_sequence<ComponentIndex...>) {
+            if(iteration.filterOnChanges) {
+                const bool chunkChanged = ((iteration.changeFilter[ComponentIndex] && chunk.getColumnVersion(columns[ComponentIndex]) > iteration.changedSince) || ...);
+                if(!chunkChanged) {
+                    return;
+                }
+            }
+
+            const std::tuple<ColumnStart<RequiredComponents>...> columnStarts { getColumnStart<RequiredComponents>(chunk, columns[ComponentIndex])... };
+            const std::array<std::uint64_t*, sizeof...(RequiredComponents)> versionStarts { chunk.getRowVersions(columns[ComponentIndex])... };
+            bool visitedAny = false;
+            for(std::size_t row = 0; row < chunk.size(); row++) {
+                if(iteration.filterOnChanges) {
+                    const bool rowChanged = ((iteration.changeFilter[ComponentIndex] && versionStarts[ComponentIndex][row] > iteration.changedSince) || ...);
+                    if(!rowChanged) {
+                        continue;
+                    }
+                }
+
+                Entity entity { chunk.getEntity(row), world };
+                action(entity, getFromColumn<RequiredComponents>(std::get<ComponentIndex>(columnStarts), row)...);
+                ((iteration.writes[ComponentIndex] ? void(versionStarts[ComponentIndex][row] = iteration.writeVersion) : void()), ...);
+                visitedAny = true;
+            }
+
+            if(visitedAny) {
+                ((iteration.writes[ComponentIndex] ? chunk.raiseColumnVersion(columns[ComponentIndex], iteration.writeVersion) : void()), ...);
+            }
+        }(std::index_sequence_for<RequiredComponents...>{});
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    void SignedSystem<type, RequiredComponents...>::forEachEntityInList(std::span<EntityWithComponents> list, const ComponentColumns& columns, const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        [&]<std::size_t... ComponentIndex>(std::index_sequence<ComponentIndex...>) {
+            for(auto& entity : list) {
+                if (entity.entity) {
+                    action(entity.entity, (*static_cast<RequiredComponents*>(entity.components[columns[ComponentIndex]]))...);
+                }
+            }
+        }(std::index_sequence_for<RequiredComponents...>{});
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    void SignedSystem<type, RequiredComponents...>::forEachEntity(const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        forEachEntityWith(makeIteration<>(false), action);
     }
 
     template<SystemType type, typename... RequiredComponents>
     void SignedSystem<type, RequiredComponents...>::parallelForEachEntity(const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        parallelForEachEntityWith(makeIteration<>(false), action);
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    template<typename... ChangedComponents>
+    void SignedSystem<type, RequiredComponents...>::forEachChangedEntity(const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        forEachEntityWith(makeIteration<ChangedComponents...>(true), action);
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    template<typename... ChangedComponents>
+    void SignedSystem<type, RequiredComponents...>::parallelForEachChangedEntity(const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        parallelForEachEntityWith(makeIteration<ChangedComponents...>(true), action);
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    void SignedSystem<type, RequiredComponents...>::forEachEntityWith(const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        if(world.getComponentStorage() == ComponentStorage::Archetypes) {
+            world.updateMatchingArchetypes(signature, archetypeCache);
+            for(Archetype* pArchetype : archetypeCache.archetypes) {
+                const ComponentColumns columns = getComponentColumns(pArchetype->getSignature());
+                for(const auto& pChunk : pArchetype->getChunks()) {
+                    forEachEntityInChunk(*pChunk, columns, iteration, action);
+                }
+            }
+            return;
+        }
+
+        forEachEntityInList(entitiesWithComponents, getComponentColumns(signature), action);
+    }
+
+    template<SystemType type, typename... RequiredComponents>
+    void SignedSystem<type, RequiredComponents...>::parallelForEachEntityWith(const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action) {
+        if(world.getComponentStorage() == ComponentStorage::Archetypes) {
+            world.updateMatchingArchetypes(signature, archetypeCache);
+
+            // one work unit per chunk, each chunk remembers which columns to read
+            struct ChunkToProcess {
+                ArchetypeChunk* pChunk = nullptr;
+                std::size_t columnsIndex = 0;
+            };
+            std::vector<ComponentColumns> columnsPerArchetype;
+            std::vector<ChunkToProcess> chunks;
+            columnsPerArchetype.reserve(archetypeCache.archetypes.size());
+            for(Archetype* pArchetype : archetypeCache.archetypes) {
+                columnsPerArchetype.emplace_back(getComponentColumns(pArchetype->getSignature()));
+                for(const auto& pChunk : pArchetype->getChunks()) {
+                    chunks.emplace_back(ChunkToProcess { .pChunk = pChunk.get(), .columnsIndex = columnsPerArchetype.size() - 1 });
+                }
+            }
+
+            if(chunks.empty())
+                return;
+            Async::Counter counter;
+            const std::size_t chunkCount = chunks.size();
+            const std::size_t stepSize = static_cast<std::size_t>(ceil((double)chunkCount / concurrency()));
+            for(std::size_t index = 0; index < chunkCount; index += stepSize) {
+                parallelSubmit([&, startIndex = index, endIndex = std::min(index + stepSize, chunkCount)]() {
+                    for(std::size_t chunkIndex = startIndex; chunkIndex < endIndex; chunkIndex++) {
+                        const ChunkToProcess& toProcess = chunks[chunkIndex];
+                        forEachEntityInChunk(*toProcess.pChunk, columnsPerArchetype[toProcess.columnsIndex], iteration, action);
+                    }
+                }, counter);
+            }
+
+            waitAndHelp(counter);
+            return;
+        }
+
         if(entities.empty())
             return;
         Async::Counter counter;
-        const std::size_t entityCount = entities.size();
+        const ComponentColumns columns = getComponentColumns(signature);
+        const std::size_t entityCount = entitiesWithComponents.size();
         const std::size_t stepSize = static_cast<std::size_t>(ceil((double)entityCount / concurrency()));
         for(std::size_t index = 0; index < entityCount; index += stepSize) {
-            parallelSubmit([&, startIndex = index, endIndex = index + stepSize -1]() {
-                for(std::size_t localIndex = startIndex; localIndex <= endIndex && localIndex < entityCount; localIndex++) {
-                    auto& entity = entitiesWithComponents[localIndex];
-                    if (entity.entity) {
-                        // TODO: lift getComponentIndex out of loop
-                        action(entity.entity, (*((RequiredComponents*)entity.components[signature.getComponentIndex(RequiredComponents::getID())]))...);
-                    }
-                }
+            parallelSubmit([&, startIndex = index, endIndex = std::min(index + stepSize, entityCount)]() {
+                forEachEntityInList(std::span { entitiesWithComponents }.subspan(startIndex, endIndex - startIndex), columns, action);
             }, counter);
         }
 
-        counter.sleepWait();
+        waitAndHelp(counter);
     }
 }
\ No newline at end of file
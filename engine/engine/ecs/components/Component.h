@@ -5,7 +5,9 @@
 #pragma once
 #include "core/utils/Identifiable.h"
 #include <engine/ecs/EntityTypes.h>
+#include <engine/ecs/ComponentLayout.h>
 #include <rapidjson/document.h>
+#include <typeinfo>
 #include <utility>
 #include <core/utils/Library.hpp>
 
@@ -59,6 +61,15 @@ namespace Carrot::ECS {
         /// Should this component be serialized inside scene files?
         virtual bool isSerializable() const;
 
+        /// Layout used to store this component by value inside archetype chunks, nullptr if the component must stay at
+        /// the same address for its entire life (see StoredByValue)
+        [[nodiscard]] virtual const ComponentLayout* getStorageLayout() const { return nullptr; }
+
+        /// Can components of this type be moved around in memory by the World? Set to true in component types which do not give their
+        /// address to anything (callbacks, physics bodies...) to store them by value inside archetype chunks.
+        /// Pointers and references to such components are only valid until the world next updates its entity lists (during tick and onFrame).
+        static constexpr bool StoredByValue = false;
+
     private:
         Entity entity;
     };
@@ -74,6 +85,16 @@ namespace Carrot::ECS {
         virtual ComponentID getComponentTypeID() const override {
             return Self::getID();
         }
+
+        virtual const ComponentLayout* getStorageLayout() const override {
+            if constexpr (Self::StoredByValue) {
+                // subclasses of Self would be sliced by a layout made for Self
+                if(typeid(*this) == typeid(Self)) {
+                    return ComponentLayout::of<Self>();
+                }
+            }
+            return nullptr;
+        }
     };
 
     class ComponentLibrary {
@@ -86,11 +107,19 @@ namespace Carrot::ECS {
         template<typename T> requires std::is_base_of_v<Component, T>
         void add() {
             storage.addUniquePtrBased<T>();
+            if constexpr (IsIdentifiable<T>) {
+                // assign the signature index at registration, instead of during the first query using this component
+                Signature::getIndex(T::getID());
+            }
         }
 
         template<typename T> requires std::is_base_of_v<Component, T>
         void addV2() {
             storage.addUniquePtrBasedV2<T>();
+            if constexpr (IsIdentifiable<T>) {
+                // assign the signature index at registration, instead of during the first query using this component
+                Signature::getIndex(T::getID());
+            }
         }
 
         void add(const Storage::ID& id, const Storage::DeserialiseFunction& deserialiseFunc, const Storage::CreateNewFunction& createNewFunc);
@@ -130,6 +130,9 @@ namespace Carrot::ECS {
     struct ReflectionComponent: public IdentifiableComponent<TComponent> {
         using TSelf = TComponent;
         static inline ::Carrot::ECS::ComponentReflectionData Reflection{};
+
+        /// All the state of reflection components is inside their fields, they can be moved around freely
+        static constexpr bool StoredByValue = true;
         explicit ReflectionComponent(Carrot::ECS::Entity entity): IdentifiableComponent<TComponent>(std::move(entity)) {};
 
         explicit ReflectionComponent(const Carrot::DocumentElement& doc, Carrot::ECS::Entity entity): ReflectionComponent(std::move(entity)) { }
@@ -8,6 +8,11 @@
 
 namespace Carrot::ECS {
     glm::mat4 TransformComponent::toTransformMatrix() const {
+        glm::mat4 cachedMatrix;
+        if(getEntity().getWorld().getTransformHierarchy().tryGetGlobalMatrix(*this, cachedMatrix)) {
+            return cachedMatrix;
+        }
+
         auto parent = getEntity().getParent();
         if(parent) {
             if(auto parentTransform = getEntity().getWorld().getComponent<TransformComponent>(parent.value())) {
@@ -18,6 +23,14 @@ namespace Carrot::ECS {
         return localTransform.toTransformMatrix();
     }
 
+    glm::mat4 TransformComponent::getLastFrameGlobalTransform() const {
+        glm::mat4 lastFrameMatrix;
+        if(getEntity().getWorld().getTransformHierarchy().tryGetLastFrameGlobalMatrix(*this, lastFrameMatrix)) {
+            return lastFrameMatrix;
+        }
+        return toTransformMatrix();
+    }
+
     void TransformComponent::setGlobalTransform(const Carrot::Math::Transform& newTransform, bool applyScale) {
         auto parent = getEntity().getParent();
         if(parent) {
@@ -56,6 +69,11 @@ namespace Carrot::ECS {
     }
 
     glm::vec3 TransformComponent::computeFinalScale() const {
+        glm::vec3 cachedScale;
+        if(getEntity().getWorld().getTransformHierarchy().tryGetGlobalScale(*this, cachedScale)) {
+            return cachedScale;
+        }
+
         auto parent = getEntity().getParent();
         if(parent) {
             if (auto parentTransform = getEntity().getWorld().getComponent<TransformComponent>(parent.value())) {
@@ -66,6 +84,11 @@ namespace Carrot::ECS {
     }
 
     glm::quat TransformComponent::computeFinalOrientation() const {
+        glm::quat cachedOrientation;
+        if(getEntity().getWorld().getTransformHierarchy().tryGetGlobalRotation(*this, cachedOrientation)) {
+            return cachedOrientation;
+        }
+
         auto parent = getEntity().getParent();
         if(parent) {
             if (auto parentTransform = getEntity().getWorld().getComponent<TransformComponent>(parent.value())) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Component.h"
+#include <cstdint>
 #include <engine/math/Transform.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -21,11 +22,12 @@ namespace Carrot::ECS {
             refl.isInline = true;
         });
 
-        /// used for motion vectors
-        glm::mat4 lastFrameGlobalTransform = glm::mat4 {0.0f};
-
         [[nodiscard]] glm::mat4 toTransformMatrix() const;
 
+        /// Global transform of this entity at the start of the previous frame, used for motion vectors.
+        /// Same as toTransformMatrix() if the entity was not rendered during the previous frame
+        [[nodiscard]] glm::mat4 getLastFrameGlobalTransform() const;
+
         /**
          * Computes the final position of the entity based on the parent orientation & position and this entity's local transform.
          * @return World-space position of the entity
@@ -67,6 +69,12 @@ namespace Carrot::ECS {
 
         /// Sets up the transform of the entity to match with the given transform, even when parent transforms are taken into account
         void setGlobalTransform(const Carrot::Math::Transform& transform, bool applyScale = false /*legacy, sorry*/);
+
+    private:
+        /// index inside the TransformHierarchy of the world, only valid if the hierarchy points back to this component
+        std::uint32_t hierarchySlot = UINT32_MAX;
+
+        friend class TransformHierarchy;
     };
 }
 
@@ -28,7 +28,7 @@ namespace Carrot::ECS {
                 modelComp.asyncAnimatedModelHandle->visible = true;
 
                 Carrot::AnimatedInstanceData& instanceData = modelComp.asyncAnimatedModelHandle->getData();
-                instanceData.lastFrameTransform = transform.lastFrameGlobalTransform;
+                instanceData.lastFrameTransform = transform.getLastFrameGlobalTransform();
                 instanceData.transform = transform.toTransformMatrix();
                 instanceData.uuid = entity.getID();
                 instanceData.raytraced = modelComp.raytraced;
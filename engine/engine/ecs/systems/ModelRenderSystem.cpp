@@ -11,7 +11,7 @@
 #include <engine/render/ClusterManager.h>
 
 namespace Carrot::ECS {
-    ModelRenderSystem::ModelRenderSystem(const Carrot::DocumentElement& doc, World& world): RenderSystem<TransformComponent, ModelComponent>(world) {
+    ModelRenderSystem::ModelRenderSystem(const Carrot::DocumentElement& doc, World& world): ModelRenderSystem(world) {
 
     }
 
@@ -31,7 +31,7 @@ namespace Carrot::ECS {
 
             if (modelComp.asyncModel.isReady()) {
                 Carrot::InstanceData instanceData;
-                instanceData.lastFrameTransform = transform.lastFrameGlobalTransform;
+                instanceData.lastFrameTransform = transform.getLastFrameGlobalTransform();
                 instanceData.transform = transform.toTransformMatrix();
                 instanceData.uuid = entity.getID();
                 instanceData.color = modelComp.color;
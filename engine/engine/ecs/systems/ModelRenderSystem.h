@@ -11,7 +11,10 @@
 namespace Carrot::ECS {
     class ModelRenderSystem: public RenderSystem<TransformComponent, Carrot::ECS::ModelComponent>, public Identifiable<ModelRenderSystem> {
     public:
-        explicit ModelRenderSystem(World& world): RenderSystem<TransformComponent, ModelComponent>(world) {}
+        explicit ModelRenderSystem(World& world): RenderSystem<TransformComponent, ModelComponent>(world) {
+            declareReads<TransformComponent>();
+            declareWrites<ModelComponent>();
+        }
         explicit ModelRenderSystem(const Carrot::DocumentElement& doc, World& world);
 
         void onFrame(const Carrot::Render::Context& renderContext) override;
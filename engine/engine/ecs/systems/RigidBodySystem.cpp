@@ -13,14 +13,28 @@ namespace Carrot::ECS {
     }
 
     void RigidBodySystem::prePhysics() {
+        // static bodies follow their TransformComponent (to allow static objects to be moved around), but most of them never move:
+        // only update the ones whose transform changed since the previous physics step
+        parallelForEachChangedEntity<TransformComponent, RigidBodyComponent>([&](Entity& entity, TransformComponent& transformComponent, RigidBodyComponent& rigidBodyComp) {
+            if(rigidBodyComp.rigidbody.getBodyType() == Physics::BodyType::Static) {
+                rigidBodyComp.rigidbody.setTransform(transformComponent.computeGlobalPhysicsTransform());
+                rigidBodyComp.firstTick = false;
+            }
+        });
+
+        // other bodies are moved by the physics engine, their TransformComponent follows them
         parallelForEachEntity([&](Entity& entity, TransformComponent& transformComponent, RigidBodyComponent& rigidBodyComp) {
-            rigidBodyComp.rigidbody.setUserData((void *) &entity.getID());
+            // the entity stored in the component outlives this iteration
+            rigidBodyComp.rigidbody.setUserData((void *) &rigidBodyComp.getEntity().getID());
+            if(rigidBodyComp.rigidbody.getBodyType() == Physics::BodyType::Static) {
+                return;
+            }
 
-            auto transform = rigidBodyComp.rigidbody.getTransform();
-            if(rigidBodyComp.firstTick || rigidBodyComp.rigidbody.getBodyType() == Physics::BodyType::Static/*allow static objects to be moved around*/) {
+            if(rigidBodyComp.firstTick) {
                 rigidBodyComp.rigidbody.setTransform(transformComponent.computeGlobalPhysicsTransform());
                 rigidBodyComp.firstTick = false;
             } else {
+                auto transform = rigidBodyComp.rigidbody.getTransform();
                 transform.scale = transformComponent.computeGlobalPhysicsTransform().scale; // preserve scale
                 transformComponent.setGlobalTransform(transform);
             }
@@ -4,91 +4,80 @@
 #include "System.h"
 #include <core/async/Counter.h>
 #include <engine/Engine.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 
 namespace Carrot::ECS {
     System::System(World& world): world(world), signature() {}
 
+    bool ComponentAccess::conflictsWith(const ComponentAccess& other) const {
+        if(!declared || !other.declared) {
+            return true;
+        }
+        return writes.intersects(other.writes)
+            || writes.intersects(other.reads)
+            || reads.intersects(other.writes);
+    }
+
     const Signature& System::getSignature() const {
         return signature;
     }
 
+    const ComponentAccess& System::getComponentAccess() const {
+        return componentAccess;
+    }
+
     std::span<const Entity> System::getEntities() const {
         return entities;
     }
 
     void System::onEntitiesAdded(const std::vector<EntityID>& added) {
-        bool changed = false;
         for(const auto& e : added) {
-            auto obj = Entity(e, world);
-            auto it = std::find_if(entities.begin(), entities.end(), [&](const auto& entity) {
-                return entity.getID() == e;
-            });
-            if(it != entities.end())
+            if(entityIndices.contains(e)) {
                 continue;
-            if((world.getSignature(obj) & getSignature()) == getSignature()) {
-                changed = true;
+            }
+            auto obj = Entity(e, world);
+            if(world.getSignature(obj).contains(getSignature())) {
                 onEntityAdded(obj);
-                entities.push_back(obj);
+                addEntity(obj);
             }
         }
-
-        if(changed) {
-            recreateEntityWithComponentsList();
-        }
     }
 
     void System::onEntitiesRemoved(const std::vector<EntityID>& removed) {
-        bool changed = false;
         for(const auto& e : removed) {
-            auto obj = Entity(e, world);
-            std::size_t removedCount = std::erase_if(entities, [&](const Entity& entity) {
-                return entity.operator EntityID() == e;
-            });
-            changed |= removedCount > 0;
-        }
-
-        if(changed) {
-            recreateEntityWithComponentsList();
+            removeEntity(e);
         }
     }
 
     void System::onEntitiesUpdated(const std::vector<EntityID>& updated) {
-        bool changed = false;
         for(const auto& e : updated) {
             auto obj = Entity(e, world);
 
-            if((world.getSignature(obj) & getSignature()) != getSignature()) {
-                std::size_t removedCount = std::erase_if(entities, [&](const Entity& entity) {
-                    return entity.operator EntityID() == e;
-                });
-                changed |= removedCount > 0;
-            } else if((world.getSignature(obj) & getSignature()) == getSignature()) {
-                auto it = std::find_if(entities.begin(), entities.end(), [&](const Entity& entity) {
-                    return entity.operator EntityID() == e;
-                });
-                if(it == entities.end()) {
-                    onEntityAdded(obj);
-                    entities.push_back(obj);
-                    changed = true;
-                }
+            if(!world.getSignature(obj).contains(getSignature())) {
+                removeEntity(e);
+            } else if(entityIndices.contains(e)) {
+                // components may have been replaced
+                addEntity(obj);
+            } else {
+                onEntityAdded(obj);
+                addEntity(obj);
             }
         }
-
-        if(changed || entities.size() != entitiesWithComponents.size()) {
-            recreateEntityWithComponentsList();
-        }
     }
 
-    void System::parallelSubmit(const std::function<void()>& action, Async::Counter& counter) {
-        TaskDescription description {
+    void System::parallelSubmit(InlineFunction<void()>&& action, Async::Counter& counter) {
+        LeafTaskDescription description {
             .name = "parallelSubmit",
-            .task = [action](TaskHandle&) {
-                action();
-            },
+            .task = std::move(action),
             .joiner = &counter,
         };
-        GetTaskScheduler().schedule(std::move(description), TaskScheduler::FrameParallelWork);
+        GetTaskScheduler().scheduleLeaf(std::move(description), TaskScheduler::FrameParallelWork);
+    }
+
+    void System::waitAndHelp(Async::Counter& counter) {
+        while(!counter.isIdle()) {
+            GetTaskScheduler().stealJobAndRun(TaskScheduler::FrameParallelWork);
+        }
     }
 
     std::size_t System::concurrency() {
@@ -96,10 +85,70 @@ namespace Carrot::ECS {
     }
 
     void System::recreateEntityWithComponentsList() {
+        entityIndices.clear();
+        entityIndices.reserve(entities.size());
+        for(std::size_t i = 0; i < entities.size(); i++) {
+            entityIndices[entities[i].getID()] = i;
+        }
         entitiesWithComponents.resize(entities.size());
         world.fillComponents(signature, entities, entitiesWithComponents);
     }
 
+    void System::refreshComponents(std::span<const EntityID> relocated) {
+        for(const auto& e : relocated) {
+            if(entityIndices.contains(e)) {
+                addEntity(Entity(e, world));
+            }
+        }
+    }
+
+    void System::addEntity(const Entity& entity) {
+        auto [iter, inserted] = entityIndices.try_emplace(entity.getID(), entities.size());
+        if(inserted) {
+            entities.push_back(entity);
+            entitiesWithComponents.emplace_back();
+        }
+        const std::size_t index = iter->second;
+        world.fillComponents(signature, std::span { &entities[index], 1 }, std::span { &entitiesWithComponents[index], 1 });
+    }
+
+    bool System::removeEntity(const EntityID& entity) {
+        auto iter = entityIndices.find(entity);
+        if(iter == entityIndices.end()) {
+            return false;
+        }
+
+        const std::size_t index = iter->second;
+        entityIndices.erase(iter);
+        const std::size_t lastIndex = entities.size() - 1;
+        if(index != lastIndex) {
+            entities[index] = entities[lastIndex];
+            entitiesWithComponents[index] = std::move(entitiesWithComponents[lastIndex]);
+            entityIndices[entities[index].getID()] = index;
+        }
+        entities.pop_back();
+        entitiesWithComponents.pop_back();
+        return true;
+    }
+
+    void System::beginRun(SystemPhase phase) {
+        std::uint64_t& lastRunVersion = lastRunVersionPerPhase[static_cast<std::size_t>(phase)];
+        previousRunVersion = lastRunVersion;
+        currentRunVersion = world.nextChangeVersion();
+        lastRunVersion = currentRunVersion;
+    }
+
+    void System::endRun() {
+        currentRunVersion = 0;
+    }
+
+    std::uint64_t System::getWriteVersion() {
+        if(currentRunVersion != 0) {
+            return currentRunVersion;
+        }
+        return world.nextChangeVersion();
+    }
+
     SystemLibrary& getSystemLibrary() {
         static SystemLibrary lib;
         return lib;
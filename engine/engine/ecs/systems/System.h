@@ -3,11 +3,15 @@
 //
 
 #pragma once
+#include <array>
 #include "engine/ecs/Signature.hpp"
 #include "engine/ecs/EntityTypes.h"
+#include "engine/ecs/Archetypes.h"
+#include "engine/ecs/SystemScheduler.h"
 #include "engine/render/RenderContext.h"
 #include <engine/render/RenderPass.h>
 #include <core/utils/Library.hpp>
+#include <core/functional/InlineFunction.hpp>
 
 namespace Carrot::Async {
     class Counter;
@@ -22,12 +26,26 @@ namespace Carrot::ECS {
         Render,
     };
 
+    /// Components read and written by a system, inside its tick/prePhysics/postPhysics/onFrame methods.
+    /// Used by World to know which systems can run at the same time.
+    struct ComponentAccess {
+        Signature reads;
+        Signature writes;
+
+        /// Systems which did not declare their accesses are run alone, because they may touch anything (engine state, scripting, other worlds...)
+        bool declared = false;
+
+        /// Can the two systems NOT run at the same time?
+        bool conflictsWith(const ComponentAccess& other) const;
+    };
+
     class System {
     public:
         explicit System(World& world);
         explicit System(const Carrot::DocumentElement& doc, World& world): System(world) {};
 
         [[nodiscard]] const Signature& getSignature() const;
+        [[nodiscard]] const ComponentAccess& getComponentAccess() const;
         std::span<const Entity> getEntities() const;
 
         virtual void onFrame(const Carrot::Render::Context& renderContext) = 0;
@@ -83,22 +101,71 @@ namespace Carrot::ECS {
         const World& getWorld() const { return world; }
 
     protected:
-        void parallelSubmit(const std::function<void()>& action, Async::Counter& counter);
+        /// Declares that this system reads the given components. Once a system has declared its accesses, it can run
+        /// concurrently with other systems which do not write to these components.
+        /// Only declare accesses if all the work done by the system is limited to the declared components (and thread-safe engine APIs)
+        template<typename... Components>
+        void declareReads();
+
+        /// Declares that this system writes to the given components. See declareReads
+        template<typename... Components>
+        void declareWrites();
+
+        /// Runs 'action' on FrameParallelWork as a leaf task: it must not yield, but is much cheaper than a regular task.
+        /// Small lambdas are stored without heap allocation
+        void parallelSubmit(InlineFunction<void()>&& action, Async::Counter& counter);
+
+        /// Waits for the counter to reach 0, while executing other tasks of the same lane.
+        /// Does not put the thread to sleep, so that systems running in parallel never wait on each other's work
+        static void waitAndHelp(Async::Counter& counter);
+
         static std::size_t concurrency(); // avoids to include TaskScheduler
 
+        /// Change version used to mark the components written by this system as changed: the version of the current run,
+        /// or a new version when called outside of a run
+        std::uint64_t getWriteVersion();
+
+        /// Components with a change version strictly higher than this value changed since the previous run of this system
+        /// during the current phase
+        std::uint64_t getChangeFilterVersion() const { return previousRunVersion; }
+
     protected:
         World& world;
         Signature signature;
+        ComponentAccess componentAccess;
         std::vector<Entity> entities;
         std::vector<EntityWithComponents> entitiesWithComponents;
+        ArchetypeQueryCache archetypeCache; //< archetypes matching this system's signature, used when the world stores its components in archetypes
 
         virtual void onEntityAdded(Entity& entity) {};
 
     private:
-
+        /// Rebuilds 'entitiesWithComponents' and 'entityIndices' from 'entities'
         void recreateEntityWithComponentsList();
 
+        /// Refreshes the components of the given entities inside 'entitiesWithComponents', for the ones inside this system.
+        /// Called by the World when it moved components stored by value
+        void refreshComponents(std::span<const EntityID> relocated);
+
+        /// Adds the entity at the end of 'entities', or refreshes its components if it is already inside this system
+        void addEntity(const Entity& entity);
+
+        /// Removes the entity from this system, by moving the last entity in its place. Returns false if the entity was not inside this system
+        bool removeEntity(const EntityID& entity);
+
+        /// Called by SystemScheduler around each run of this system, to keep track of change versions
+        void beginRun(SystemPhase phase);
+        void endRun();
+
+    private:
+        std::unordered_map<EntityID, std::size_t> entityIndices; //< index of each entity inside 'entities' and 'entitiesWithComponents'
+
+        std::uint64_t currentRunVersion = 0; //< 0 when not running
+        std::uint64_t previousRunVersion = 0;
+        std::array<std::uint64_t, static_cast<std::size_t>(SystemPhase::Count)> lastRunVersionPerPhase{};
+
         friend class World;
+        friend class SystemScheduler;
     };
 
     template<SystemType systemType, typename... RequiredComponents>
@@ -114,6 +181,52 @@ namespace Carrot::ECS {
         ///  It is up to the user to ensure no data race arise from performing the action concurrently and on other threads.
         ///  Immediately called, so capturing on the stack is safe.
         void parallelForEachEntity(const std::function<void(Entity&, RequiredComponents&...)>& action);
+
+        /// Calls 'action' of each entity in this system for which at least one of 'ChangedComponents' changed since the previous
+        /// run of this system during the current phase (see World::markComponentChanged for what is tracked).
+        /// Writes made by this system earlier during the same run also count as changes, so filter before writing.
+        /// Changes are only tracked with ComponentStorage::Archetypes, otherwise all entities are visited.
+        template<typename... ChangedComponents>
+        void forEachChangedEntity(const std::function<void(Entity&, RequiredComponents&...)>& action);
+
+        /// Same as forEachChangedEntity, but entities are split between multiple tasks, like parallelForEachEntity
+        template<typename... ChangedComponents>
+        void parallelForEachChangedEntity(const std::function<void(Entity&, RequiredComponents&...)>& action);
+
+    private:
+        using ComponentColumns = std::array<std::size_t, sizeof...(RequiredComponents)>;
+        using ComponentFlags = std::array<bool, sizeof...(RequiredComponents)>;
+
+        /// How the forEach* methods visit entities stored in archetypes
+        struct Iteration {
+            bool filterOnChanges = false;
+            ComponentFlags changeFilter{}; //< only visit entities for which one of these components changed after 'changedSince'
+            std::uint64_t changedSince = 0;
+            ComponentFlags writes{}; //< components marked as changed once an entity has been visited (declared writes)
+            std::uint64_t writeVersion = 0;
+        };
+
+        template<typename... ChangedComponents>
+        Iteration makeIteration(bool filterOnChanges);
+
+        /// Column (or index inside EntityWithComponents) of each required component, for the given signature
+        static ComponentColumns getComponentColumns(const Signature& signature);
+
+        /// Start of the chunk column containing components of type T: the components themselves if T is stored by value, pointers otherwise
+        template<typename T>
+        using ColumnStart = std::conditional_t<T::StoredByValue, T*, Component**>;
+
+        template<typename T>
+        static ColumnStart<T> getColumnStart(const ArchetypeChunk& chunk, std::size_t columnIndex);
+
+        template<typename T>
+        static T& getFromColumn(ColumnStart<T> columnStart, std::size_t row);
+
+        void forEachEntityWith(const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action);
+        void parallelForEachEntityWith(const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action);
+
+        void forEachEntityInChunk(ArchetypeChunk& chunk, const ComponentColumns& columns, const Iteration& iteration, const std::function<void(Entity&, RequiredComponents&...)>& action);
+        void forEachEntityInList(std::span<EntityWithComponents> list, const ComponentColumns& columns, const std::function<void(Entity&, RequiredComponents&...)>& action);
     };
 
     template<typename... RequiredComponents>
@@ -11,4 +11,16 @@ namespace Carrot::ECS {
         signature.addComponents<RequiredComponents...>();
     }
 
+    template<typename... Components>
+    void System::declareReads() {
+        componentAccess.reads.addComponents<Components...>();
+        componentAccess.declared = true;
+    }
+
+    template<typename... Components>
+    void System::declareWrites() {
+        componentAccess.writes.addComponents<Components...>();
+        componentAccess.declared = true;
+    }
+
 }
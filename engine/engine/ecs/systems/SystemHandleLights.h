@@ -11,7 +11,10 @@
 namespace Carrot::ECS {
     class SystemHandleLights: public RenderSystem<TransformComponent, LightComponent>, public Identifiable<SystemHandleLights> {
     public:
-        explicit SystemHandleLights(World& world): RenderSystem<TransformComponent, LightComponent>(world) {}
+        explicit SystemHandleLights(World& world): RenderSystem<TransformComponent, LightComponent>(world) {
+            declareReads<TransformComponent>();
+            declareWrites<LightComponent>();
+        }
         explicit SystemHandleLights(const Carrot::DocumentElement& doc, World& world): SystemHandleLights(world) {}
 
         void onFrame(const Carrot::Render::Context&) override;
@@ -11,7 +11,10 @@
 namespace Carrot::ECS {
     class SystemKinematics: public LogicSystem<TransformComponent, KinematicsComponent>, public Identifiable<SystemKinematics> {
     public:
-        explicit SystemKinematics(World& world): LogicSystem<TransformComponent, KinematicsComponent>(world) {}
+        explicit SystemKinematics(World& world): LogicSystem<TransformComponent, KinematicsComponent>(world) {
+            declareReads<KinematicsComponent>();
+            declareWrites<TransformComponent>();
+        }
         explicit SystemKinematics(const Carrot::DocumentElement& doc, World& world): SystemKinematics(world) {}
 
         void tick(double dt) override;
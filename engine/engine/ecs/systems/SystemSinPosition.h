@@ -11,7 +11,10 @@
 namespace Carrot::ECS {
     class SystemSinPosition: public LogicSystem<TransformComponent, ForceSinPositionComponent>, public Identifiable<SystemSinPosition> {
     public:
-        explicit SystemSinPosition(World& world): LogicSystem<TransformComponent, ForceSinPositionComponent>(world) {}
+        explicit SystemSinPosition(World& world): LogicSystem<TransformComponent, ForceSinPositionComponent>(world) {
+            declareReads<ForceSinPositionComponent>();
+            declareWrites<TransformComponent>();
+        }
         explicit SystemSinPosition(const Carrot::DocumentElement& doc, World& world): SystemSinPosition(world) {}
 
         void tick(double dt) override;
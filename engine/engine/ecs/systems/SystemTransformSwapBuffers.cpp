@@ -5,9 +5,7 @@
 
 namespace Carrot::ECS {
     void SystemTransformSwapBuffers::swapBuffers() {
-        forEachEntity([&](Entity& entity, TransformComponent& transformComponent) {
-            transformComponent.lastFrameGlobalTransform = transformComponent.toTransformMatrix();
-        });
+        // last frame transforms are now kept by the TransformHierarchy of the world
     }
 
     std::unique_ptr<System> SystemTransformSwapBuffers::duplicate(World& newOwner) const {
@@ -3,97 +3,164 @@
 //
 
 #include "AStar.h"
+#include <algorithm>
+#include <limits>
 #include <core/Macros.h>
-#include <unordered_set>
+#include <core/utils/Assert.h>
 
 namespace Carrot::AI {
-    static std::vector<std::size_t> reconstructPath(const std::unordered_map<std::size_t, std::size_t>& cameFrom, std::size_t current) {
-        std::vector<std::size_t> totalPath;
-        totalPath.push_back(current);
-
-        while(true) {
-            auto it = cameFrom.find(current);
-            if(it == cameFrom.end()) {
-                break; // reached the end (which is actually the start of our path)
-            }
-
-            current = it->second;
-            totalPath.push_back(current);
+    void SearchContext::beginSearch(std::size_t nodeCount) {
+        verify(nodeCount < NotInHeap, "Too many nodes for A*");
+        if(generations.size() < nodeCount) {
+            generations.resize(nodeCount, currentGeneration);
+            gScores.resize(nodeCount);
+            cameFrom.resize(nodeCount);
+            heapIndices.resize(nodeCount);
         }
 
-        std::reverse(totalPath.begin(), totalPath.end());
-
-        return totalPath;
+        currentGeneration++;
+        if(currentGeneration == 0) {
+            // wrapped around: old stamps could be mistaken for the current generation
+            std::fill(WHOLE_CONTAINER(generations), 0);
+            currentGeneration = 1;
+        }
+        heap.clear();
+        path.clear();
     }
 
-    // TODO: separate h & d functions from costEstimation
-    std::vector<std::size_t> AStarImpl::findPath(std::size_t pointA, std::size_t pointB,
-                                                 const std::function<float(std::size_t a, std::size_t b)>& distanceFunction,
-                                                 const std::function<float(std::size_t v)>& costEstimation) {
-        std::vector<std::size_t> openSet;
-        openSet.push_back(pointA);
+    void SearchContext::open(std::uint32_t node, std::uint32_t from, float gScore, float fScore) {
+        const bool wasInHeap = isVisited(node) && heapIndices[node] != NotInHeap;
+        generations[node] = currentGeneration;
+        gScores[node] = gScore;
+        cameFrom[node] = from;
+
+        if(wasInHeap) {
+            // decrease-key: g score only ever decreases, so the node can only go up inside the heap
+            const std::uint32_t heapIndex = heapIndices[node];
+            heap[heapIndex].fScore = fScore;
+            siftUp(heapIndex);
+        } else {
+            // not visited yet, or reopened after being closed
+            heap.push_back(HeapEntry { fScore, node });
+            heapIndices[node] = static_cast<std::uint32_t>(heap.size() - 1);
+            siftUp(heapIndices[node]);
+        }
+    }
 
-        std::unordered_map<std::size_t, std::size_t> cameFrom;
+    std::uint32_t SearchContext::popBest() {
+        const std::uint32_t best = heap[0].node;
+        heapIndices[best] = NotInHeap;
 
-        std::unordered_map<std::size_t, float> gScore;
-        std::unordered_map<std::size_t, float> fScore;
+        const HeapEntry last = heap.back();
+        heap.pop_back();
+        if(!heap.empty()) {
+            placeInHeap(0, last);
+            siftDown(0);
+        }
+        return best;
+    }
 
-        gScore[pointA] = 0.0f;
-        fScore[pointA] = costEstimation(pointA);
+    void SearchContext::reconstructPath(std::uint32_t start, std::uint32_t goal) {
+        path.clear();
+        std::uint32_t current = goal;
+        path.push_back(current);
+        while(current != start) {
+            current = cameFrom[current];
+            path.push_back(current);
+        }
+        std::reverse(WHOLE_CONTAINER(path));
+    }
 
-        auto getGScore = [&](std::size_t node) {
-            auto it = gScore.find(node);
-            if(it != gScore.end()) {
-                return it->second;
+    void SearchContext::siftUp(std::uint32_t heapIndex) {
+        const HeapEntry entry = heap[heapIndex];
+        while(heapIndex > 0) {
+            const std::uint32_t parentIndex = (heapIndex - 1) / 2;
+            if(heap[parentIndex].fScore <= entry.fScore) {
+                break;
             }
-            return INFINITY;
-        };
+            placeInHeap(heapIndex, heap[parentIndex]);
+            heapIndex = parentIndex;
+        }
+        placeInHeap(heapIndex, entry);
+    }
 
-        auto getFScore = [&](std::size_t node) {
-            auto it = fScore.find(node);
-            if(it != fScore.end()) {
-                return it->second;
+    void SearchContext::siftDown(std::uint32_t heapIndex) {
+        const HeapEntry entry = heap[heapIndex];
+        const std::uint32_t size = static_cast<std::uint32_t>(heap.size());
+        while(true) {
+            std::uint32_t childIndex = heapIndex * 2 + 1;
+            if(childIndex >= size) {
+                break;
             }
-            return INFINITY;
-        };
-
-        while(!openSet.empty()) {
-            // find node in openSet with lowest fscore
-            std::size_t current = openSet[0];
-            std::size_t currentIndex = 0;
-            float lowestFScore = getFScore(current);
-
-            for (std::size_t i = 1; i < openSet.size(); ++i) {
-                float otherFScore = getFScore(openSet[i]);
-                if(otherFScore < lowestFScore) {
-                    lowestFScore = otherFScore;
-                    current = openSet[i];
-                    currentIndex = i;
-                }
+            if(childIndex + 1 < size && heap[childIndex + 1].fScore < heap[childIndex].fScore) {
+                childIndex++;
             }
-
-            if(current == pointB) {
-                return reconstructPath(cameFrom, current);
+            if(entry.fScore <= heap[childIndex].fScore) {
+                break;
             }
+            placeInHeap(heapIndex, heap[childIndex]);
+            heapIndex = childIndex;
+        }
+        placeInHeap(heapIndex, entry);
+    }
 
-            openSet.erase(openSet.begin() + currentIndex);
-            for(const auto& edge : adjacency[current]) {
-                std::size_t neighbor = edge->indexB;
+    void SearchContext::placeInHeap(std::uint32_t heapIndex, const HeapEntry& entry) {
+        heap[heapIndex] = entry;
+        heapIndices[entry.node] = heapIndex;
+    }
 
-                float tentativeGScore = getGScore(current) + distanceFunction(current, neighbor);
-                if(tentativeGScore < getGScore(neighbor)) {
-                    cameFrom[neighbor] = current;
-                    gScore[neighbor] = tentativeGScore;
-                    fScore[neighbor] = tentativeGScore + costEstimation(neighbor);
+    AStarImpl::AStarImpl(const AStarImpl& other) {
+        *this = other;
+    }
 
-                    if(std::find(WHOLE_CONTAINER(openSet), neighbor) == openSet.end()) {
-                        openSet.push_back(neighbor);
-                    }
-                }
-            }
+    AStarImpl& AStarImpl::operator=(const AStarImpl& other) {
+        if(this == &other) {
+            return *this;
+        }
+        ownedAdjacencyOffsets = other.ownedAdjacencyOffsets;
+        ownedAdjacentVertices = other.ownedAdjacentVertices;
+        if(other.adjacencyOffsets.data() == other.ownedAdjacencyOffsets.data()) {
+            // owned by 'other', point to our copy instead
+            adjacencyOffsets = ownedAdjacencyOffsets;
+            adjacentVertices = ownedAdjacentVertices;
+        } else {
+            // external memory
+            adjacencyOffsets = other.adjacencyOffsets;
+            adjacentVertices = other.adjacentVertices;
         }
+        return *this;
+    }
+
+    void AStarImpl::setEdges(std::size_t vertexCount, std::vector<Edge>&& edges) {
+        verify(vertexCount < std::numeric_limits<std::uint32_t>::max(), "Too many vertices for A*");
+
+        // counting sort of edges by starting vertex, order of edges of a given vertex is kept
+        ownedAdjacencyOffsets.clear();
+        ownedAdjacencyOffsets.resize(vertexCount + 1, 0);
+        for(const Edge& edge : edges) {
+            verify(edge.indexA < vertexCount && edge.indexB < vertexCount, "Edge references a vertex which does not exist");
+            ownedAdjacencyOffsets[edge.indexA + 1]++;
+        }
+        for(std::size_t v = 0; v < vertexCount; v++) {
+            ownedAdjacencyOffsets[v + 1] += ownedAdjacencyOffsets[v];
+        }
+
+        std::vector<std::uint32_t> insertionPoints { ownedAdjacencyOffsets.begin(), ownedAdjacencyOffsets.end() - 1 };
+        ownedAdjacentVertices.resize(edges.size());
+        for(const Edge& edge : edges) {
+            ownedAdjacentVertices[insertionPoints[edge.indexA]++] = static_cast<std::uint32_t>(edge.indexB);
+        }
+
+        adjacencyOffsets = ownedAdjacencyOffsets;
+        adjacentVertices = ownedAdjacentVertices;
+    }
 
-        return {};
+    void AStarImpl::setAdjacency(std::span<const std::uint32_t> offsets, std::span<const std::uint32_t> neighbors) {
+        verify(!offsets.empty() && offsets.front() == 0 && offsets.back() == neighbors.size(), "Invalid adjacency");
+        ownedAdjacencyOffsets.clear();
+        ownedAdjacentVertices.clear();
+        adjacencyOffsets = offsets;
+        adjacentVertices = neighbors;
     }
 
-} // Carrot::AI
\ No newline at end of file
+} // Carrot::AI
@@ -13,21 +13,127 @@ namespace Carrot::AI {
         std::size_t indexB = ~0ull;
     };
 
+    /**
+     * Working memory of an A* search: scores per node, open set, and the resulting path.
+     * Reuse the same context between searches to avoid allocations: arrays are only resized when searching a larger
+     * graph, and are never cleared (entries written by previous searches are recognized by their generation).
+     * A context must be used by a single search at a time, use one context per thread (or per agent) to search in parallel.
+     */
+    class SearchContext {
+    public:
+        /// Path found by the last successful search, from start to goal (both included)
+        std::span<const std::size_t> getPath() const {
+            return path;
+        }
+
+    private:
+        /// Marker for nodes which are not inside the open set
+        constexpr static std::uint32_t NotInHeap = ~0u;
+
+        struct HeapEntry {
+            float fScore;
+            std::uint32_t node;
+        };
+
+        /// Prepares this context for a new search over 'nodeCount' nodes
+        void beginSearch(std::size_t nodeCount);
+
+        /// Has 'node' been reached during the current search?
+        bool isVisited(std::uint32_t node) const {
+            return generations[node] == currentGeneration;
+        }
+
+        float getGScore(std::uint32_t node) const {
+            return isVisited(node) ? gScores[node] : INFINITY;
+        }
+
+        /// Updates the score of 'node', and adds it to the open set (or moves it inside the open set if already there)
+        void open(std::uint32_t node, std::uint32_t from, float gScore, float fScore);
+
+        /// Removes the node with the lowest f score from the open set
+        std::uint32_t popBest();
+
+        bool hasOpenNodes() const {
+            return !heap.empty();
+        }
+
+        /// Fills 'path' by following 'cameFrom' from 'goal'
+        void reconstructPath(std::uint32_t start, std::uint32_t goal);
+
+        void siftUp(std::uint32_t heapIndex);
+        void siftDown(std::uint32_t heapIndex);
+        void placeInHeap(std::uint32_t heapIndex, const HeapEntry& entry);
+
+        // per node, valid only if generations[node] == currentGeneration
+        std::vector<std::uint32_t> generations;
+        std::vector<float> gScores;
+        std::vector<std::uint32_t> cameFrom;
+        std::vector<std::uint32_t> heapIndices;
+
+        /// open set, binary min-heap over f scores
+        std::vector<HeapEntry> heap;
+        std::vector<std::size_t> path;
+        std::uint32_t currentGeneration = 0;
+
+        friend class AStarImpl;
+    };
+
     class AStarImpl {
     public:
-        std::span<const Edge> getEdges() const {
-            return edges;
+        AStarImpl() = default;
+        AStarImpl(const AStarImpl& other);
+        AStarImpl(AStarImpl&& other) = default;
+
+        AStarImpl& operator=(const AStarImpl& other);
+        AStarImpl& operator=(AStarImpl&& other) = default;
+
+        /// Number of (unidirectional) edges
+        std::size_t getEdgeCount() const {
+            return adjacentVertices.size();
+        }
+
+        std::size_t getVertexCount() const {
+            return adjacencyOffsets.empty() ? 0 : adjacencyOffsets.size() - 1;
         }
 
+        /// Vertices reachable from 'vertex' via a single edge
+        std::span<const std::uint32_t> getNeighbors(std::size_t vertex) const {
+            return std::span { adjacentVertices.data() + adjacencyOffsets[vertex], adjacentVertices.data() + adjacencyOffsets[vertex + 1] };
+        }
+
+        /// A* over any graph of 'vertexCount' vertices, for graphs which are not stored inside an AStar (or only partially)
+        /// \param forEachNeighbor void(std::uint32_t v, const auto& visit), must call visit(std::uint32_t neighbor, float cost) for each neighbor of v
+        /// \param costEstimation float(std::size_t v), estimated cost from v to pointB
+        /// \return true if a path was found, the path is then available via context.getPath()
+        template<typename TForEachNeighbor, typename TCostEstimation>
+        static bool findPathInGraph(SearchContext& context, std::size_t vertexCount, std::size_t pointA, std::size_t pointB,
+                                    const TForEachNeighbor& forEachNeighbor, const TCostEstimation& costEstimation);
+
     protected:
-        std::vector<Edge> edges;
+        /// Computes the adjacency of each vertex from the given edges
+        void setEdges(std::size_t vertexCount, std::vector<Edge>&& edges);
 
-        // vertex -> edges starting with this vertex
-        std::unordered_map<std::size_t, std::vector<const Edge*>> adjacency;
+        /// Uses the given adjacency (same layout as 'adjacencyOffsets' and 'adjacentVertices') without copying it.
+        /// The memory must outlive this graph, intended for graphs stored in memory-mapped files
+        void setAdjacency(std::span<const std::uint32_t> offsets, std::span<const std::uint32_t> neighbors);
 
-        std::vector<std::size_t> findPath(std::size_t pointA, std::size_t pointB,
-                                          const std::function<float(std::size_t a, std::size_t b)>& distanceFunction,
-                                          const std::function<float(std::size_t v)>& costEstimation);
+        /// Searches a path from 'pointA' to 'pointB' with the given callables.
+        /// Templated (instead of std::function) so that the cost functions can be inlined in the search loop.
+        /// \param distanceFunction float(std::size_t a, std::size_t b), cost to go from a to b (b is a neighbor of a)
+        /// \param costEstimation float(std::size_t v), estimated cost from v to pointB
+        /// \return true if a path was found, the path is then available via context.getPath()
+        template<typename TDistance, typename TCostEstimation>
+        bool findPath(SearchContext& context, std::size_t pointA, std::size_t pointB,
+                      const TDistance& distanceFunction, const TCostEstimation& costEstimation) const;
+
+        // vertex v has the neighbors adjacentVertices[adjacencyOffsets[v]] to adjacentVertices[adjacencyOffsets[v+1]] (excluded)
+        // point to 'ownedAdjacencyOffsets' and 'ownedAdjacentVertices', or to external memory (see setAdjacency)
+        std::span<const std::uint32_t> adjacencyOffsets;
+        std::span<const std::uint32_t> adjacentVertices;
+
+    private:
+        std::vector<std::uint32_t> ownedAdjacencyOffsets;
+        std::vector<std::uint32_t> ownedAdjacentVertices;
     };
 
     template<typename VertexType>
@@ -41,26 +147,36 @@ namespace Carrot::AI {
 
         void setGraph(std::vector<VertexType> _vertices, std::vector<Edge> _edges) {
             vertices = std::move(_vertices);
-            edges = std::move(_edges);
-
-            adjacency.clear();
-            for(const auto& edge : edges) {
-                adjacency[edge.indexA].push_back(&edge);
-            }
+            setEdges(vertices.size(), std::move(_edges));
         }
 
-        /// Attempts a short path from pointA to pointB
-        /// Can return an empty result, if there are no such path
-        std::vector<std::size_t> findPath(std::size_t pointA, std::size_t pointB,
-                                          const std::function<float(const VertexType& a, const VertexType& b)>& distanceFunction,
-                                          const std::function<float(const VertexType& a)>& costEstimation) {
-            return AStarImpl::findPath(pointA, pointB, [&](std::size_t a, std::size_t b) -> float {
+        /// Attempts a short path from pointA to pointB, using 'context' as working memory.
+        /// Can be called concurrently, as long as each call has its own context.
+        /// \param distanceFunction float(const VertexType& a, const VertexType& b)
+        /// \param costEstimation float(const VertexType& v)
+        /// \return true if a path was found, the path is then available via context.getPath()
+        template<typename TDistance, typename TCostEstimation>
+        bool findPath(SearchContext& context, std::size_t pointA, std::size_t pointB,
+                      const TDistance& distanceFunction, const TCostEstimation& costEstimation) const {
+            return AStarImpl::findPath(context, pointA, pointB, [&](std::size_t a, std::size_t b) -> float {
                 return distanceFunction(vertices[a], vertices[b]);
             }, [&](std::size_t v) -> float {
                 return costEstimation(vertices[v]);
             });
         }
 
+        /// Attempts a short path from pointA to pointB
+        /// Can return an empty result, if there are no such path
+        template<typename TDistance, typename TCostEstimation>
+        std::vector<std::size_t> findPath(std::size_t pointA, std::size_t pointB,
+                                          const TDistance& distanceFunction, const TCostEstimation& costEstimation) const {
+            SearchContext context;
+            if(!findPath(context, pointA, pointB, distanceFunction, costEstimation)) {
+                return {};
+            }
+            return std::vector<std::size_t> { context.getPath().begin(), context.getPath().end() };
+        }
+
         std::span<const VertexType> getVertices() const {
             return vertices;
         }
@@ -70,3 +186,5 @@ namespace Carrot::AI {
     };
 
 } // Carrot::AI
+
+#include "AStar.ipp"
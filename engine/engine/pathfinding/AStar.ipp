@@ -0,0 +1,50 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+namespace Carrot::AI {
+
+    template<typename TForEachNeighbor, typename TCostEstimation>
+    bool AStarImpl::findPathInGraph(SearchContext& context, std::size_t vertexCount, std::size_t pointA, std::size_t pointB,
+                                    const TForEachNeighbor& forEachNeighbor, const TCostEstimation& costEstimation) {
+        if(pointA >= vertexCount || pointB >= vertexCount) {
+            return false;
+        }
+
+        context.beginSearch(vertexCount);
+        const std::uint32_t start = static_cast<std::uint32_t>(pointA);
+        const std::uint32_t goal = static_cast<std::uint32_t>(pointB);
+        context.open(start, start, 0.0f, costEstimation(pointA));
+
+        while(context.hasOpenNodes()) {
+            const std::uint32_t current = context.popBest();
+            if(current == goal) {
+                context.reconstructPath(start, goal);
+                return true;
+            }
+
+            const float currentGScore = context.gScores[current];
+            forEachNeighbor(current, [&](std::uint32_t neighbor, float cost) {
+                const float tentativeGScore = currentGScore + cost;
+                if(tentativeGScore < context.getGScore(neighbor)) {
+                    context.open(neighbor, current, tentativeGScore, tentativeGScore + costEstimation(neighbor));
+                }
+            });
+        }
+
+        return false;
+    }
+
+    template<typename TDistance, typename TCostEstimation>
+    bool AStarImpl::findPath(SearchContext& context, std::size_t pointA, std::size_t pointB,
+                             const TDistance& distanceFunction, const TCostEstimation& costEstimation) const {
+        return findPathInGraph(context, getVertexCount(), pointA, pointB, [&](std::uint32_t current, const auto& visit) {
+            for(const std::uint32_t neighbor : getNeighbors(current)) {
+                visit(neighbor, distanceFunction(current, neighbor));
+            }
+        }, costEstimation);
+    }
+
+} // Carrot::AI
@@ -0,0 +1,332 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "LocalAvoidance.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <core/tasks/TaskScheduler.h>
+#include <core/utils/Assert.h>
+#include <core/utils/Profiling.h>
+
+namespace Carrot::AI {
+    static constexpr float Epsilon = 0.00001f;
+
+    namespace {
+        /// Half-plane of allowed velocities: on the left of 'direction', going through 'point'
+        struct ORCALine {
+            glm::vec2 point { 0.0f };
+            glm::vec2 direction { 0.0f };
+        };
+    }
+
+    static float det(const glm::vec2& a, const glm::vec2& b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    /// Solves the linear program on line 'lineIndex', constrained by the lines before it and by the circle of radius 'radius'.
+    /// Returns false if there is no solution
+    static bool linearProgram1(std::span<const ORCALine> lines, std::size_t lineIndex, float radius, const glm::vec2& optimalVelocity, bool directionOptimal, glm::vec2& result) {
+        const ORCALine& line = lines[lineIndex];
+        const float dotProduct = glm::dot(line.point, line.direction);
+        const float discriminant = dotProduct * dotProduct + radius * radius - glm::dot(line.point, line.point);
+        if(discriminant < 0.0f) {
+            return false; // max speed circle fully invalidates the line
+        }
+
+        const float sqrtDiscriminant = glm::sqrt(discriminant);
+        float tLeft = -dotProduct - sqrtDiscriminant;
+        float tRight = -dotProduct + sqrtDiscriminant;
+        for(std::size_t i = 0; i < lineIndex; i++) {
+            const float denominator = det(line.direction, lines[i].direction);
+            const float numerator = det(lines[i].direction, line.point - lines[i].point);
+            if(glm::abs(denominator) <= Epsilon) {
+                // lines are (almost) parallel
+                if(numerator < 0.0f) {
+                    return false;
+                }
+                continue;
+            }
+
+            const float t = numerator / denominator;
+            if(denominator >= 0.0f) {
+                tRight = glm::min(tRight, t);
+            } else {
+                tLeft = glm::max(tLeft, t);
+            }
+            if(tLeft > tRight) {
+                return false;
+            }
+        }
+
+        if(directionOptimal) {
+            result = line.point + (glm::dot(optimalVelocity, line.direction) > 0.0f ? tRight : tLeft) * line.direction;
+        } else {
+            const float t = glm::clamp(glm::dot(line.direction, optimalVelocity - line.point), tLeft, tRight);
+            result = line.point + t * line.direction;
+        }
+        return true;
+    }
+
+    /// Finds the velocity closest to 'optimalVelocity' satisfying all lines, inside the circle of radius 'radius'.
+    /// Returns the index of the line which could not be satisfied, or lines.size() on success
+    static std::size_t linearProgram2(std::span<const ORCALine> lines, float radius, const glm::vec2& optimalVelocity, bool directionOptimal, glm::vec2& result) {
+        if(directionOptimal) {
+            result = optimalVelocity * radius; // optimalVelocity is a unit vector in this case
+        } else if(glm::dot(optimalVelocity, optimalVelocity) > radius * radius) {
+            result = glm::normalize(optimalVelocity) * radius;
+        } else {
+            result = optimalVelocity;
+        }
+
+        for(std::size_t i = 0; i < lines.size(); i++) {
+            if(det(lines[i].direction, lines[i].point - result) > 0.0f) {
+                // result does not satisfy this line
+                const glm::vec2 previousResult = result;
+                if(!linearProgram1(lines, i, radius, optimalVelocity, directionOptimal, result)) {
+                    result = previousResult;
+                    return i;
+                }
+            }
+        }
+        return lines.size();
+    }
+
+    /// Called when linearProgram2 fails (agents too dense): finds the velocity which minimizes the maximum penetration in the lines
+    static void linearProgram3(std::span<const ORCALine> lines, std::size_t beginLine, float radius, glm::vec2& result, std::vector<ORCALine>& projectedLines) {
+        float distance = 0.0f;
+        for(std::size_t i = beginLine; i < lines.size(); i++) {
+            if(det(lines[i].direction, lines[i].point - result) <= distance) {
+                continue; // result already satisfies this line within the current penetration
+            }
+
+            projectedLines.clear();
+            for(std::size_t j = 0; j < i; j++) {
+                ORCALine projected;
+                const float determinant = det(lines[i].direction, lines[j].direction);
+                if(glm::abs(determinant) <= Epsilon) {
+                    if(glm::dot(lines[i].direction, lines[j].direction) > 0.0f) {
+                        continue; // same direction
+                    }
+                    projected.point = 0.5f * (lines[i].point + lines[j].point);
+                } else {
+                    projected.point = lines[i].point + (det(lines[j].direction, lines[i].point - lines[j].point) / determinant) * lines[i].direction;
+                }
+                projected.direction = glm::normalize(lines[j].direction - lines[i].direction);
+                projectedLines.push_back(projected);
+            }
+
+            const glm::vec2 previousResult = result;
+            if(linearProgram2(projectedLines, radius, glm::vec2 { -lines[i].direction.y, lines[i].direction.x }, true, result) < projectedLines.size()) {
+                // should not happen in theory, result is already in the feasible region of the projected program.
+                // Floating point errors can make it happen though, keep the previous result in that case
+                result = previousResult;
+            }
+            distance = det(lines[i].direction, lines[i].point - result);
+        }
+    }
+
+    /// Cell of the spatial hash containing 'position'
+    static glm::ivec2 getCell(const glm::vec2& position, float cellSize) {
+        return glm::ivec2 { glm::floor(position / cellSize) };
+    }
+
+    static std::uint32_t getBucket(const glm::ivec2& cell, std::uint32_t bucketMask) {
+        const std::uint32_t hash = static_cast<std::uint32_t>(cell.x) * 73856093u ^ static_cast<std::uint32_t>(cell.y) * 19349663u;
+        return hash & bucketMask;
+    }
+
+    LocalAvoidance::LocalAvoidance(TaskScheduler& scheduler): LocalAvoidance(scheduler, Params{}) {}
+
+    LocalAvoidance::LocalAvoidance(TaskScheduler& scheduler, const Params& params)
+        : scheduler(scheduler)
+        , params(params)
+    {
+        verify(params.neighborDistance > 0.0f, "Neighbor distance must be positive");
+        verify(params.timeHorizon > 0.0f, "Time horizon must be positive");
+    }
+
+    const LocalAvoidance::Params& LocalAvoidance::getParams() const {
+        return params;
+    }
+
+    void LocalAvoidance::buildSpatialHash(std::span<const AvoidanceAgent> agents) {
+        ZoneScoped;
+        // at least as many buckets as agents, to keep collisions between cells rare
+        const std::size_t bucketCount = std::bit_ceil(std::max<std::size_t>(agents.size(), 16));
+        const std::uint32_t bucketMask = static_cast<std::uint32_t>(bucketCount - 1);
+
+        // counting sort of the agents by bucket
+        bucketStarts.assign(bucketCount + 1, 0);
+        agentBuckets.resize(agents.size());
+        for(std::size_t i = 0; i < agents.size(); i++) {
+            const std::uint32_t bucket = getBucket(getCell(agents[i].position, params.neighborDistance), bucketMask);
+            agentBuckets[i] = bucket;
+            bucketStarts[bucket + 1]++;
+        }
+        for(std::size_t i = 1; i <= bucketCount; i++) {
+            bucketStarts[i] += bucketStarts[i - 1];
+        }
+
+        sortedAgents.resize(agents.size());
+        for(std::size_t i = 0; i < agents.size(); i++) {
+            // bucketStarts[bucket] is used as the insertion cursor, and ends up at the start of the next bucket
+            sortedAgents[bucketStarts[agentBuckets[i]]++] = static_cast<std::uint32_t>(i);
+        }
+        // restore the starts of the buckets
+        for(std::size_t i = bucketCount; i > 0; i--) {
+            bucketStarts[i] = bucketStarts[i - 1];
+        }
+        bucketStarts[0] = 0;
+    }
+
+    void LocalAvoidance::findNeighbors(std::span<const AvoidanceAgent> agents, std::size_t agentIndex, std::vector<std::uint32_t>& neighbors) const {
+        neighbors.clear();
+        if(params.maxNeighbors == 0) {
+            return;
+        }
+
+        static thread_local std::vector<float> neighborSqDistances;
+        neighborSqDistances.clear();
+
+        const std::uint32_t bucketMask = static_cast<std::uint32_t>(bucketStarts.size() - 2);
+        const glm::vec2 position = agents[agentIndex].position;
+        const glm::ivec2 center = getCell(position, params.neighborDistance);
+        float maxSqDistance = params.neighborDistance * params.neighborDistance;
+
+        // cells are as large as the neighbor distance: neighbors are in the 3x3 cells around the agent.
+        // Several cells can end up in the same bucket, each bucket must only be visited once
+        std::array<std::uint32_t, 9> visitedBuckets;
+        std::size_t visitedCount = 0;
+        for(int dy = -1; dy <= 1; dy++) {
+            for(int dx = -1; dx <= 1; dx++) {
+                const std::uint32_t bucket = getBucket(center + glm::ivec2 { dx, dy }, bucketMask);
+                if(std::find(visitedBuckets.begin(), visitedBuckets.begin() + visitedCount, bucket) != visitedBuckets.begin() + visitedCount) {
+                    continue;
+                }
+                visitedBuckets[visitedCount++] = bucket;
+
+                for(std::uint32_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; i++) {
+                    const std::uint32_t other = sortedAgents[i];
+                    if(other == agentIndex) {
+                        continue;
+                    }
+                    const glm::vec2 delta = agents[other].position - position;
+                    const float sqDistance = glm::dot(delta, delta);
+                    if(sqDistance >= maxSqDistance) {
+                        continue;
+                    }
+
+                    // insertion into the list of closest neighbors, sorted by distance
+                    if(neighbors.size() < params.maxNeighbors) {
+                        neighbors.push_back(other);
+                        neighborSqDistances.push_back(sqDistance);
+                    }
+                    std::size_t insertIndex = neighbors.size() - 1;
+                    while(insertIndex > 0 && sqDistance < neighborSqDistances[insertIndex - 1]) {
+                        neighbors[insertIndex] = neighbors[insertIndex - 1];
+                        neighborSqDistances[insertIndex] = neighborSqDistances[insertIndex - 1];
+                        insertIndex--;
+                    }
+                    neighbors[insertIndex] = other;
+                    neighborSqDistances[insertIndex] = sqDistance;
+
+                    if(neighbors.size() == params.maxNeighbors) {
+                        maxSqDistance = neighborSqDistances.back();
+                    }
+                }
+            }
+        }
+    }
+
+    void LocalAvoidance::computeVelocities(std::span<const AvoidanceAgent> agents, std::span<glm::vec2> newVelocities, float deltaTime) {
+        ZoneScoped;
+        verify(agents.size() == newVelocities.size(), "There must be one output velocity per agent");
+        verify(deltaTime > 0.0f, "Delta time must be positive");
+        if(agents.empty()) {
+            return;
+        }
+
+        buildSpatialHash(agents);
+
+        const float invTimeHorizon = 1.0f / params.timeHorizon;
+        const float invTimeStep = 1.0f / deltaTime;
+        scheduler.parallelFor(agents.size(), [&](std::size_t agentIndex) {
+            static thread_local std::vector<std::uint32_t> neighbors;
+            static thread_local std::vector<ORCALine> lines;
+            static thread_local std::vector<ORCALine> projectedLines;
+
+            const AvoidanceAgent& agent = agents[agentIndex];
+            findNeighbors(agents, agentIndex, neighbors);
+
+            lines.clear();
+            for(const std::uint32_t neighborIndex : neighbors) {
+                const AvoidanceAgent& other = agents[neighborIndex];
+                const glm::vec2 relativePosition = other.position - agent.position;
+                const glm::vec2 relativeVelocity = agent.velocity - other.velocity;
+                const float sqDistance = glm::dot(relativePosition, relativePosition);
+                const float combinedRadius = agent.radius + other.radius;
+                const float sqCombinedRadius = combinedRadius * combinedRadius;
+
+                ORCALine& line = lines.emplace_back();
+                glm::vec2 u; // smallest change of relative velocity to get out of the velocity obstacle
+                if(sqDistance > sqCombinedRadius) {
+                    // no collision yet. w: vector from the center of the cutoff circle to the relative velocity
+                    const glm::vec2 w = relativeVelocity - invTimeHorizon * relativePosition;
+                    const float sqWLength = glm::dot(w, w);
+                    const float dotProduct = glm::dot(w, relativePosition);
+                    if(dotProduct < 0.0f && dotProduct * dotProduct > sqCombinedRadius * sqWLength) {
+                        // project on the cutoff circle
+                        const float wLength = glm::sqrt(sqWLength);
+                        const glm::vec2 unitW = w / wLength;
+                        line.direction = glm::vec2 { unitW.y, -unitW.x };
+                        u = (combinedRadius * invTimeHorizon - wLength) * unitW;
+                    } else {
+                        // project on the legs of the cone
+                        const float leg = glm::sqrt(sqDistance - sqCombinedRadius);
+                        if(det(relativePosition, w) > 0.0f) {
+                            line.direction = glm::vec2 {
+                                relativePosition.x * leg - relativePosition.y * combinedRadius,
+                                relativePosition.x * combinedRadius + relativePosition.y * leg
+                            } / sqDistance;
+                        } else {
+                            line.direction = -glm::vec2 {
+                                relativePosition.x * leg + relativePosition.y * combinedRadius,
+                                -relativePosition.x * combinedRadius + relativePosition.y * leg
+                            } / sqDistance;
+                        }
+                        u = glm::dot(relativeVelocity, line.direction) * line.direction - relativeVelocity;
+                    }
+                } else {
+                    // already overlapping: get out of the cutoff circle of the time step
+                    const glm::vec2 w = relativeVelocity - invTimeStep * relativePosition;
+                    const float wLength = glm::length(w);
+                    const glm::vec2 unitW = wLength > Epsilon ? w / wLength : glm::vec2 { 1.0f, 0.0f }; // same position, pick any direction
+                    line.direction = glm::vec2 { unitW.y, -unitW.x };
+                    u = (combinedRadius * invTimeStep - wLength) * unitW;
+                }
+                // each agent does half of the avoidance
+                line.point = agent.velocity + 0.5f * u;
+            }
+
+            glm::vec2 newVelocity;
+            const std::size_t failedLine = linearProgram2(lines, agent.maxSpeed, agent.preferredVelocity, false, newVelocity);
+            if(failedLine < lines.size()) {
+                linearProgram3(lines, failedLine, agent.maxSpeed, newVelocity, projectedLines);
+            }
+            newVelocities[agentIndex] = newVelocity;
+        }, 64);
+    }
+
+    void LocalAvoidance::step(std::span<AvoidanceAgent> agents, float deltaTime) {
+        ZoneScoped;
+        stepVelocities.resize(agents.size());
+        computeVelocities(agents, stepVelocities, deltaTime);
+        for(std::size_t i = 0; i < agents.size(); i++) {
+            agents[i].velocity = stepVelocities[i];
+            agents[i].position += stepVelocities[i] * deltaTime;
+        }
+    }
+
+} // Carrot::AI
@@ -0,0 +1,75 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Carrot {
+    class TaskScheduler;
+}
+
+namespace Carrot::AI {
+
+    /// Agent moving on the XY plane, steered by LocalAvoidance
+    struct AvoidanceAgent {
+        glm::vec2 position { 0.0f };
+        glm::vec2 velocity { 0.0f }; //< current velocity, updated by LocalAvoidance::step
+        glm::vec2 preferredVelocity { 0.0f }; //< velocity the agent would take without other agents (towards the next waypoint of its path)
+        float radius = 0.5f;
+        float maxSpeed = 2.0f;
+    };
+
+    /**
+     * Local avoidance between agents, with optimal reciprocal collision avoidance (ORCA, "Reciprocal n-body Collision Avoidance").
+     * Each agent picks the velocity closest to its preferred velocity which does not collide with its neighbors before
+     * 'timeHorizon', assuming neighbors do half of the avoidance work. Paths on the navmesh give the preferred velocities,
+     * this layer only deals with other agents (not with the borders of the navmesh).
+     *
+     * Neighbors are found with a spatial hash rebuilt at each call, and velocities are computed in parallel on
+     * TaskScheduler::FrameParallelWork: each agent only reads the previous state of the others.
+     */
+    class LocalAvoidance {
+    public:
+        struct Params {
+            float timeHorizon = 2.0f; //< seconds ahead during which collisions with other agents are avoided
+            float neighborDistance = 5.0f; //< agents further than this are ignored
+            std::size_t maxNeighbors = 10; //< only the closest neighbors are considered
+        };
+
+        explicit LocalAvoidance(TaskScheduler& scheduler);
+        explicit LocalAvoidance(TaskScheduler& scheduler, const Params& params);
+
+        /// Computes the new velocity of each agent, without modifying the agents
+        /// \param newVelocities output, must have the same size as 'agents'
+        /// \param deltaTime duration of the next step, used to resolve agents which already overlap
+        void computeVelocities(std::span<const AvoidanceAgent> agents, std::span<glm::vec2> newVelocities, float deltaTime);
+
+        /// Computes the new velocities, then moves the agents with them
+        void step(std::span<AvoidanceAgent> agents, float deltaTime);
+
+        const Params& getParams() const;
+
+    private:
+        /// Sorts agents by cell of the spatial hash
+        void buildSpatialHash(std::span<const AvoidanceAgent> agents);
+
+        /// Indices of the closest agents to 'agentIndex', closest first
+        void findNeighbors(std::span<const AvoidanceAgent> agents, std::size_t agentIndex, std::vector<std::uint32_t>& neighbors) const;
+
+        TaskScheduler& scheduler;
+        Params params;
+
+        // spatial hash: agents of bucket i are sortedAgents[bucketStarts[i]..bucketStarts[i+1]]
+        std::vector<std::uint32_t> bucketStarts;
+        std::vector<std::uint32_t> sortedAgents;
+        std::vector<std::uint32_t> agentBuckets;
+
+        std::vector<glm::vec2> stepVelocities;
+    };
+
+} // Carrot::AI
@@ -10,116 +10,452 @@
 #include <glm/gtx/closest_point.hpp>
 #include <core/utils/Profiling.h>
 #include <engine/render/resources/model_loading/SceneLoader.h>
+#include <core/async/ParallelMap.hpp>
 #include <core/io/FileFormats.h>
+#include <core/io/MappedFile.h>
 #include <core/io/Serialisation.h>
+#include <core/math/BasicFunctions.h>
 #include <engine/render/RenderContext.h>
 #include <engine/render/VulkanRenderer.h>
 #include <engine/utils/Macros.h>
 #include <glm/gtx/vector_query.hpp>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <core/tasks/Tasks.h>
+#include <tribox3.h> // last: defines X, Y and Z macros
 
 static constexpr std::array<char, 4> CNAVMagic = { 'C', 'N', 'A', 'V' };
-static constexpr std::uint32_t CNAVVersion = 0;
+static constexpr std::uint32_t CNAVVersion = 3; // 1: added BVH, 2: added hierarchy, 3: memory-mappable layout
+
+/// Start of each section of a .cnav file, relative to the start of the file. Enough for SIMD loads of any section
+static constexpr std::size_t CNAVSectionAlignment = 16;
+
+/// Max number of triangles inside a leaf of the BVH
+static constexpr std::size_t BVHLeafSize = 4;
 
 namespace Carrot::AI {
 
+    // Since version 3, .cnav files are a header followed by arrays which are used in place, in the native layout of
+    // NavMesh::Data. Arrays are only written in little-endian, like the rest of Carrot files.
+    static_assert(std::endian::native == std::endian::little, ".cnav files are used in place, and are little-endian");
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), ".cnav files store tightly packed glm::vec3");
+
+    /// Arrays inside a .cnav file, in the order they are written
+    enum class CNAVSection: std::uint32_t {
+        TriangleVertices, // glm::vec3, 3 per triangle
+        TriangleCenters, // glm::vec3, 1 per triangle
+        AdjacencyOffsets, // std::uint32_t, 1 per triangle + 1
+        AdjacentTriangles, // std::uint32_t, 1 per edge
+        Portals, // 2 glm::vec3, 1 per edge
+        BVHNodes, // NavMesh::BVHNode
+        BVHTriangles, // std::uint32_t, 1 per triangle
+        ClusterOfTriangles, // std::uint32_t, 1 per triangle, or empty if there is no hierarchy
+        IntraClusterCosts, // float
+
+        Count
+    };
+
+    struct CNAVSectionRange {
+        std::uint64_t offset = 0; //< in bytes, from the start of the file
+        std::uint64_t size = 0; //< in bytes
+    };
+
+    struct CNAVHeader {
+        std::array<char, 4> magic = CNAVMagic; //< same position as older versions
+        std::uint32_t version = CNAVVersion; //< same position as older versions
+        std::uint32_t sectionCount = static_cast<std::uint32_t>(CNAVSection::Count);
+        std::uint32_t reserved = 0;
+        CNAVSectionRange sections[static_cast<std::size_t>(CNAVSection::Count)];
+    };
+
+    /// Gives access to an array of a .cnav file, without copying it. Throws if the section is not a valid array of T
+    template<typename T>
+    static std::span<const T> getSection(std::span<const std::uint8_t> fileContents, const CNAVHeader& header, CNAVSection section, const char* fileName) {
+        const CNAVSectionRange& range = header.sections[static_cast<std::size_t>(section)];
+        if(range.offset > fileContents.size() || range.size > fileContents.size() - range.offset || range.size % sizeof(T) != 0) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s is truncated or corrupted (section %u)", fileName, static_cast<std::uint32_t>(section)));
+        }
+        const std::uint8_t* pStart = fileContents.data() + range.offset;
+        if(reinterpret_cast<std::uintptr_t>(pStart) % alignof(T) != 0) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] Section %u of file %s is misaligned", static_cast<std::uint32_t>(section), fileName));
+        }
+        return std::span { reinterpret_cast<const T*>(pStart), range.size / sizeof(T) };
+    }
+
+    /// Appends an array to a .cnav file being written
+    template<typename T>
+    static void writeSection(std::vector<std::uint8_t>& fileContents, CNAVHeader& header, CNAVSection section, std::span<const T> elements) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const std::size_t offset = Carrot::Math::alignUp(fileContents.size(), CNAVSectionAlignment);
+        const std::size_t size = elements.size_bytes();
+        fileContents.resize(offset + size, 0);
+        if(size > 0) {
+            std::memcpy(fileContents.data() + offset, elements.data(), size);
+        }
+        header.sections[static_cast<std::size_t>(section)] = CNAVSectionRange { .offset = offset, .size = size };
+    }
+
+    struct NavMesh::OwnedArrays {
+        std::vector<glm::vec3> triangleVertices;
+        std::vector<glm::vec3> triangleCenters;
+        std::vector<std::uint32_t> adjacencyOffsets { 0 };
+        std::vector<std::uint32_t> adjacentTriangles;
+        std::vector<Portal> portals;
+        std::vector<BVHNode> bvhNodes;
+        std::vector<std::uint32_t> bvhTriangles;
+    };
+
     NavMesh::NavMesh() {
+        static const std::shared_ptr<const Data> pEmptyData = makeData(std::make_shared<OwnedArrays>());
+        pData = pEmptyData;
+    }
 
+    std::shared_ptr<NavMesh::Data> NavMesh::makeData(std::shared_ptr<const OwnedArrays> pArrays) {
+        auto pNewData = std::make_shared<Data>();
+        pNewData->triangleVertices = pArrays->triangleVertices;
+        pNewData->triangleCenters = pArrays->triangleCenters;
+        pNewData->graph.setAdjacency(pArrays->adjacencyOffsets, pArrays->adjacentTriangles);
+        pNewData->portals = pArrays->portals;
+        pNewData->bvhNodes = pArrays->bvhNodes;
+        pNewData->bvhTriangles = pArrays->bvhTriangles;
+        pNewData->pStorage = std::move(pArrays);
+        return pNewData;
+    }
+
+    std::shared_ptr<NavMesh::Data> NavMesh::copyData() const {
+        return std::make_shared<Data>(*pData);
+    }
+
+    void NavMesh::setData(std::shared_ptr<const Data> pNewData) {
+        pData = std::move(pNewData);
+        obstacles.clear();
+        freeObstacleIDs.clear();
+        obstacleCountPerTriangle.clear();
+        if(blockedTriangleCount > 0) {
+            obstacleVersion++;
+        }
+        blockedTriangleCount = 0;
     }
 
     void NavMesh::loadFromResource(const Carrot::IO::Resource& resource) {
         const char* resourceName = resource.getName().c_str();
         if(IO::getFileFormat(resourceName) == IO::FileFormat::CNAV) {
-            std::vector<std::uint8_t> data;
-            data.resize(resource.getSize());
-            resource.read(data);
-
-            IO::VectorReader reader { data };
+            if(resource.isFile()) {
+                loadFromFile(resource.getFilepath());
+                return;
+            }
 
-            // write header
-            std::array<char, 4> magic { '\0', '\0', '\0', '\0' };
-            reader >> std::span(magic);
-            if(magic != CNAVMagic) {
-                throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not have the proper magic header", resourceName));
+            // in-memory resource, only copied once
+            auto pContents = std::make_shared<std::vector<std::uint8_t>>(resource.getSize());
+            resource.read(*pContents);
+            std::uint32_t version = 0;
+            if(pContents->size() >= sizeof(CNAVHeader::magic) + sizeof(version)) {
+                std::memcpy(&version, pContents->data() + sizeof(CNAVHeader::magic), sizeof(version));
+            }
+            if(version < CNAVVersion) {
+                setData(readOlderVersion(*pContents, resourceName));
+            } else {
+                const std::span<const std::uint8_t> contents = *pContents;
+                setData(makeDataInPlace(std::move(pContents), contents, resourceName));
             }
+        } else {
+            Render::SceneLoader loader;
+            loadFromScene(loader.load(resource));
+        }
+    }
 
-            std::uint32_t version;
-            reader >> version;
-            if(version != CNAVVersion) {
-                throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not a valid version", resourceName));
+    void NavMesh::loadFromFile(const std::filesystem::path& path) {
+        ZoneScoped;
+        // navmeshes loaded from the same file share their data, as long as one of them is alive.
+        // The modification time is part of the key, to load a new version of the file once it is re-baked
+        static Async::ParallelMap<std::string, std::weak_ptr<const Data>> loadedFiles;
+        const std::filesystem::path absolutePath = std::filesystem::absolute(path);
+        const std::string key = Carrot::sprintf("%s@%lld", absolutePath.string().c_str(),
+                                                static_cast<long long>(std::filesystem::last_write_time(absolutePath).time_since_epoch().count()));
+
+        std::shared_ptr<const Data> pLoaded;
+        std::weak_ptr<const Data> pShared = loadedFiles.getOrCompute(key, [&]() {
+            const std::string fileName = absolutePath.string();
+            std::shared_ptr<const IO::MappedFile> pFile = IO::MappedFile::open(absolutePath);
+            const std::span<const std::uint8_t> contents = pFile->getData();
+
+            std::uint32_t version = 0;
+            if(contents.size() >= sizeof(CNAVHeader::magic) + sizeof(version)) {
+                std::memcpy(&version, contents.data() + sizeof(CNAVHeader::magic), sizeof(version));
             }
+            if(version < CNAVVersion) {
+                pLoaded = readOlderVersion(std::vector<std::uint8_t> { contents.begin(), contents.end() }, fileName.c_str());
+            } else {
+                pLoaded = makeDataInPlace(std::move(pFile), contents, fileName.c_str());
+            }
+            return pLoaded;
+        });
+
+        if(auto pExisting = pShared.lock()) {
+            setData(std::move(pExisting));
+        } else {
+            // all navmeshes using this file were destroyed since it was loaded
+            loadedFiles.remove(key);
+            loadFromFile(path);
+        }
+    }
+
+    std::shared_ptr<NavMesh::Data> NavMesh::makeDataInPlace(std::shared_ptr<const void> pStorage, std::span<const std::uint8_t> fileContents, const char* fileName) {
+        CNAVHeader header;
+        if(fileContents.size() < sizeof(header)) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s is too small to be a .cnav file", fileName));
+        }
+        std::memcpy(&header, fileContents.data(), sizeof(header));
+        if(header.magic != CNAVMagic) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not have the proper magic header", fileName));
+        }
+        if(header.version != CNAVVersion || header.sectionCount != static_cast<std::uint32_t>(CNAVSection::Count)) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not a valid version", fileName));
+        }
+
+        // only the sizes are checked: contents are trusted like other assets, checking them would read the entire file
+        auto pNewData = std::make_shared<Data>();
+        pNewData->triangleVertices = getSection<glm::vec3>(fileContents, header, CNAVSection::TriangleVertices, fileName);
+        pNewData->triangleCenters = getSection<glm::vec3>(fileContents, header, CNAVSection::TriangleCenters, fileName);
+        const auto adjacencyOffsets = getSection<std::uint32_t>(fileContents, header, CNAVSection::AdjacencyOffsets, fileName);
+        const auto adjacentTriangles = getSection<std::uint32_t>(fileContents, header, CNAVSection::AdjacentTriangles, fileName);
+        pNewData->portals = getSection<Portal>(fileContents, header, CNAVSection::Portals, fileName);
+        pNewData->bvhNodes = getSection<BVHNode>(fileContents, header, CNAVSection::BVHNodes, fileName);
+        pNewData->bvhTriangles = getSection<std::uint32_t>(fileContents, header, CNAVSection::BVHTriangles, fileName);
+        const auto clusterOfTriangles = getSection<std::uint32_t>(fileContents, header, CNAVSection::ClusterOfTriangles, fileName);
+        const auto intraClusterCosts = getSection<float>(fileContents, header, CNAVSection::IntraClusterCosts, fileName);
+
+        const std::size_t triangleCount = pNewData->triangleCenters.size();
+        const bool validSizes = pNewData->triangleVertices.size() == triangleCount * 3
+            && adjacencyOffsets.size() == triangleCount + 1
+            && adjacencyOffsets.front() == 0 && adjacencyOffsets.back() == adjacentTriangles.size()
+            && pNewData->portals.size() == adjacentTriangles.size()
+            && pNewData->bvhTriangles.size() == triangleCount
+            && (pNewData->bvhNodes.empty() == (triangleCount == 0))
+            && (clusterOfTriangles.empty() || clusterOfTriangles.size() == triangleCount);
+        if(!validSizes) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s is corrupted", fileName));
+        }
+
+        pNewData->graph.setAdjacency(adjacencyOffsets, adjacentTriangles);
+        pNewData->hierarchy.load(clusterOfTriangles, intraClusterCosts, pNewData->graph, pNewData->triangleCenters);
+        pNewData->pStorage = std::move(pStorage);
+        return pNewData;
+    }
+
+    namespace {
+        // layout of versions 0 to 2 of .cnav files
+        struct LegacyTriangle {
+            std::size_t index = 0;
+            glm::vec3 a { 0.0f };
+            glm::vec3 b { 0.0f };
+            glm::vec3 c { 0.0f };
+        };
+
+        struct LegacyEdge {
+            std::size_t indexA = 0;
+            std::size_t indexB = 0;
+        };
+
+        struct LegacyBVHNode {
+            glm::vec3 min { 0.0f };
+            glm::vec3 max { 0.0f };
+            std::uint32_t firstChildOrTriangle = 0;
+            std::uint32_t triangleCount = 0;
+        };
+
+        IO::VectorReader& operator>>(IO::VectorReader& i, LegacyTriangle& triangle) {
+            i >> triangle.index;
+            i >> triangle.a;
+            i >> triangle.b;
+            i >> triangle.c;
+            return i;
+        }
+
+        IO::VectorReader& operator>>(IO::VectorReader& i, LegacyEdge& edge) {
+            i >> edge.indexA;
+            i >> edge.indexB;
+            return i;
+        }
+
+        IO::VectorReader& operator>>(IO::VectorReader& i, LegacyBVHNode& node) {
+            i >> node.min;
+            i >> node.max;
+            i >> node.firstChildOrTriangle;
+            i >> node.triangleCount;
+            return i;
+        }
+    }
+
+    std::shared_ptr<NavMesh::Data> NavMesh::readOlderVersion(const std::vector<std::uint8_t>& fileContents, const char* fileName) {
+        IO::VectorReader reader { fileContents };
 
-            // write triangles
-            std::vector<NavMeshTriangle> triangles;
-            reader >> triangles;
+        std::array<char, 4> magic { '\0', '\0', '\0', '\0' };
+        reader >> std::span(magic);
+        if(magic != CNAVMagic) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not have the proper magic header", fileName));
+        }
+
+        std::uint32_t version;
+        reader >> version;
+        if(version >= CNAVVersion) {
+            throw std::invalid_argument(Carrot::sprintf("[NavMesh] File %s does not a valid version", fileName));
+        }
 
-            // write adjacency
-            std::vector<Edge> edges;
-            reader >> edges;
+        std::vector<LegacyTriangle> triangles;
+        reader >> triangles;
 
-            reader >> portalVertices;
-            pathfinder.setGraph(std::move(triangles), std::move(edges));
+        std::vector<LegacyEdge> legacyEdges;
+        reader >> legacyEdges;
+        std::vector<Edge> edges;
+        edges.reserve(legacyEdges.size());
+        for(const LegacyEdge& edge : legacyEdges) {
+            edges.push_back(Edge { edge.indexA, edge.indexB });
+        }
+
+        // triangle -> other triangle -> shared vertices
+        std::unordered_map<std::size_t, std::unordered_map<std::size_t, Portal>> portalVertices;
+        reader >> portalVertices;
+
+        auto pArrays = std::make_shared<OwnedArrays>();
+        pArrays->triangleVertices.reserve(triangles.size() * 3);
+        pArrays->triangleCenters.reserve(triangles.size());
+        for(const LegacyTriangle& triangle : triangles) {
+            pArrays->triangleVertices.push_back(triangle.a);
+            pArrays->triangleVertices.push_back(triangle.b);
+            pArrays->triangleVertices.push_back(triangle.c);
+            pArrays->triangleCenters.push_back((triangle.a + triangle.b + triangle.c) / 3.0f);
+        }
+
+        // CSR adjacency, via the same counting sort as AStar
+        TriangleGraph legacyGraph;
+        legacyGraph.setEdges(triangles.size(), std::move(edges));
+        pArrays->adjacencyOffsets.assign(WHOLE_CONTAINER(legacyGraph.adjacencyOffsets));
+        pArrays->adjacentTriangles.assign(WHOLE_CONTAINER(legacyGraph.adjacentVertices));
+        pArrays->portals.reserve(pArrays->adjacentTriangles.size());
+        for(std::size_t triangle = 0; triangle < triangles.size(); triangle++) {
+            for(const std::uint32_t neighbor : legacyGraph.getNeighbors(triangle)) {
+                pArrays->portals.push_back(portalVertices.at(triangle).at(neighbor));
+            }
+        }
+
+        if(version >= 1) {
+            std::vector<LegacyBVHNode> legacyNodes;
+            reader >> legacyNodes;
+            reader >> pArrays->bvhTriangles;
+            pArrays->bvhNodes.reserve(legacyNodes.size());
+            for(const LegacyBVHNode& node : legacyNodes) {
+                pArrays->bvhNodes.push_back(BVHNode {
+                    .min = node.min,
+                    .max = node.max,
+                    .firstChildOrTriangle = node.firstChildOrTriangle,
+                    .triangleCount = node.triangleCount,
+                });
+            }
         } else {
-            Render::SceneLoader loader;
-            loadFromScene(loader.load(resource));
+            buildBVH(*pArrays);
         }
+
+        std::shared_ptr<Data> pNewData = makeData(std::move(pArrays));
+        if(version >= 2) {
+            pNewData->hierarchy.deserialize(reader, pNewData->graph, pNewData->triangleCenters);
+        } // otherwise no hierarchy: optional, not rebuilt at load time because partitioning is slow
+        return pNewData;
     }
 
     void NavMesh::loadFromScene(const Render::LoadedScene& scene)  {
         // TODO: maybe //-ize if needed
-        std::vector<NavMeshTriangle> triangles;
+        auto pArrays = std::make_shared<OwnedArrays>();
+        std::vector<Math::Triangle> triangles;
 
-        std::vector<glm::vec3> allVertices;
         for(const auto& primitive : scene.primitives) {
             std::size_t indexCount = primitive.indices.size();
-
-            std::size_t vertexIndexOffset = triangles.size() * 3;
             triangles.reserve(triangles.size() + indexCount / 3);
 
-            allVertices.reserve(allVertices.size() + primitive.vertices.size());
-            for(const auto& v : primitive.vertices) {
-                allVertices.emplace_back(v.pos.xyz());
-            }
-
             for (std::size_t i = 0; i < indexCount; i += 3) {
-                std::size_t index0 = primitive.indices[i + 0];
-                std::size_t index1 = primitive.indices[i + 1];
-                std::size_t index2 = primitive.indices[i + 2];
-
-                NavMeshTriangle& newTriangle = triangles.emplace_back();
-                newTriangle.index = triangles.size()-1;
-                newTriangle.triangle.a = primitive.vertices[index0].pos.xyz();
-                newTriangle.triangle.b = primitive.vertices[index1].pos.xyz();
-                newTriangle.triangle.c = primitive.vertices[index2].pos.xyz();
-
-                newTriangle.globalVertexIndices[0] = index0 + vertexIndexOffset;
-                newTriangle.globalVertexIndices[1] = index1 + vertexIndexOffset;
-                newTriangle.globalVertexIndices[2] = index2 + vertexIndexOffset;
-
-                newTriangle.center = (newTriangle.triangle.a + newTriangle.triangle.b + newTriangle.triangle.c) / 3.0f;
+                Math::Triangle& newTriangle = triangles.emplace_back();
+                newTriangle.a = primitive.vertices[primitive.indices[i + 0]].pos.xyz();
+                newTriangle.b = primitive.vertices[primitive.indices[i + 1]].pos.xyz();
+                newTriangle.c = primitive.vertices[primitive.indices[i + 2]].pos.xyz();
             }
         }
 
+        pArrays->triangleVertices.reserve(triangles.size() * 3);
+        pArrays->triangleCenters.reserve(triangles.size());
+        for(const Math::Triangle& t : triangles) {
+            pArrays->triangleVertices.push_back(t.a);
+            pArrays->triangleVertices.push_back(t.b);
+            pArrays->triangleVertices.push_back(t.c);
+            pArrays->triangleCenters.push_back((t.a + t.b + t.c) / 3.0f);
+        }
+
         // Due to the way regions are generated, it is possible that the triangles of two regions have overlapping edges,
         //  but no shared vertex (or a single one). Therefore we need to find all edges which are overlapping.
 
-        // triangle index -> connected triangles
-        std::unordered_map<std::size_t, std::vector<std::size_t>> adjacency;
+        // Two edges can only overlap if the bounding boxes of their triangles overlap: sort triangles along the axis where
+        // the mesh is the most spread, and sweep over them to only test triangles with overlapping bounds
+        constexpr float BoundsMargin = 10e-5f;
+        struct TriangleBounds {
+            glm::vec3 min;
+            glm::vec3 max;
+        };
+        std::vector<TriangleBounds> bounds;
+        bounds.reserve(triangles.size());
+        glm::vec3 meshMin { +INFINITY };
+        glm::vec3 meshMax { -INFINITY };
+        for(const Math::Triangle& t : triangles) {
+            TriangleBounds& b = bounds.emplace_back();
+            b.min = glm::min(t.a, glm::min(t.b, t.c)) - BoundsMargin;
+            b.max = glm::max(t.a, glm::max(t.b, t.c)) + BoundsMargin;
+            meshMin = glm::min(meshMin, b.min);
+            meshMax = glm::max(meshMax, b.max);
+        }
 
-        for(const auto& triangle1 : triangles) {
-            for(const auto& triangle2 : triangles) { // TODO: no need to redo triangles with index < self
-                if (triangle1.index == triangle2.index) {
-                    continue;
+        const glm::vec3 meshExtents = meshMax - meshMin;
+        const int sweepAxis = meshExtents.x >= meshExtents.y && meshExtents.x >= meshExtents.z ? 0 : (meshExtents.y >= meshExtents.z ? 1 : 2);
+        std::vector<std::size_t> sweepOrder(triangles.size());
+        std::iota(WHOLE_CONTAINER(sweepOrder), 0);
+        std::ranges::sort(sweepOrder, [&](std::size_t a, std::size_t b) {
+            return bounds[a].min[sweepAxis] < bounds[b].min[sweepAxis];
+        });
+
+        // triangle index -> triangles with overlapping bounds
+        std::vector<std::vector<std::size_t>> candidates(triangles.size());
+        for(std::size_t i = 0; i < sweepOrder.size(); i++) {
+            const TriangleBounds& boundsI = bounds[sweepOrder[i]];
+            for(std::size_t j = i + 1; j < sweepOrder.size(); j++) {
+                const TriangleBounds& boundsJ = bounds[sweepOrder[j]];
+                if(boundsJ.min[sweepAxis] > boundsI.max[sweepAxis]) {
+                    break; // all next triangles start after the end of triangle i
+                }
+                if(glm::all(glm::lessThanEqual(boundsI.min, boundsJ.max)) && glm::all(glm::lessThanEqual(boundsJ.min, boundsI.max))) {
+                    candidates[sweepOrder[i]].push_back(sweepOrder[j]);
+                    candidates[sweepOrder[j]].push_back(sweepOrder[i]);
                 }
+            }
+        }
 
-                // TODO: might be able to optimize this (using the bounding boxes of triangles?)
+        // adjacency is built directly in CSR layout, triangle by triangle
+        verify(triangles.size() < std::numeric_limits<std::uint32_t>::max(), "Too many triangles for a navmesh");
+        pArrays->adjacencyOffsets.reserve(triangles.size() + 1);
+        for(std::size_t triangle1Index = 0; triangle1Index < triangles.size(); triangle1Index++) {
+            const Math::Triangle& triangle1 = triangles[triangle1Index];
+            const std::size_t firstNeighbor = pArrays->adjacentTriangles.size();
+            std::vector<std::size_t>& otherTriangles = candidates[triangle1Index];
+            std::ranges::sort(otherTriangles);
+            for(const std::size_t triangle2Index : otherTriangles) {
+                const Math::Triangle& triangle2 = triangles[triangle2Index];
 
                 // go over all edges of both triangles
                 for (i32 vertex1 = 0; vertex1 < 3; vertex1++) {
                     for (i32 vertex2 = 0; vertex2 < 3; vertex2++) {
-                        const glm::vec3& point1A = triangle1.triangle.getPoint((vertex1+0) % 3);
-                        const glm::vec3& point1B = triangle1.triangle.getPoint((vertex1+1) % 3);
-                        const glm::vec3& point2A = triangle2.triangle.getPoint((vertex2+0) % 3);
-                        const glm::vec3& point2B = triangle2.triangle.getPoint((vertex2+1) % 3);
+                        const glm::vec3& point1A = triangle1.getPoint((vertex1+0) % 3);
+                        const glm::vec3& point1B = triangle1.getPoint((vertex1+1) % 3);
+                        const glm::vec3& point2A = triangle2.getPoint((vertex2+0) % 3);
+                        const glm::vec3& point2B = triangle2.getPoint((vertex2+1) % 3);
 
                         const glm::vec3 dir1 = point1B - point1A;
                         const glm::vec3 dir2 = point2B - point2A;
@@ -146,10 +482,12 @@ namespace Carrot::AI {
                                     || (tA > 1 && tB > 1) // completely to the 'right' of edge1
                                     );
                                 if (intersect) {
-                                    adjacency[triangle1.index].push_back(triangle2.index);
-                                    // TODO: adjacency[triangle2.index].push_back(triangle1.index);
-
-                                    auto& portal = portalVertices[triangle1.index][triangle2.index];
+                                    // a single portal per pair of triangles: the last overlapping edge wins
+                                    if(pArrays->adjacentTriangles.size() == firstNeighbor || pArrays->adjacentTriangles.back() != triangle2Index) {
+                                        pArrays->adjacentTriangles.push_back(static_cast<std::uint32_t>(triangle2Index));
+                                        pArrays->portals.emplace_back();
+                                    }
+                                    Portal& portal = pArrays->portals.back();
 
                                     // sort vertices along dir1, and take the #1 and #2 of the sorted list, we need to find the opening
                                     std::array<glm::vec3, 4> sortedAlongDir1{};
@@ -170,31 +508,137 @@ namespace Carrot::AI {
                     }
                 }
             }
+            pArrays->adjacencyOffsets.push_back(static_cast<std::uint32_t>(pArrays->adjacentTriangles.size()));
         }
 
-        std::vector<Edge> flatEdges;
-        for(const auto& [triangleIndex, connectedTriangles] : adjacency) {
-            flatEdges.reserve(flatEdges.size() + connectedTriangles.size());
+        buildBVH(*pArrays);
+        setData(makeData(std::move(pArrays))); // triangles changed, no hierarchy anymore, see buildHierarchy
+    }
 
-            for(const auto& otherTriangle : connectedTriangles) {
-                assert(otherTriangle != triangleIndex);
-                Edge& newEdge = flatEdges.emplace_back();
-                newEdge.indexA = triangleIndex;
-                newEdge.indexB = otherTriangle;
-            }
+    void NavMesh::buildHierarchy(std::size_t trianglesPerCluster) {
+        std::shared_ptr<Data> pNewData = copyData();
+        pNewData->hierarchy.build(pNewData->graph, pNewData->triangleCenters, trianglesPerCluster);
+        pData = std::move(pNewData);
+    }
+
+    void NavMesh::removeHierarchy() {
+        if(pData->hierarchy.empty()) {
+            return;
+        }
+        std::shared_ptr<Data> pNewData = copyData();
+        pNewData->hierarchy.clear();
+        pData = std::move(pNewData);
+    }
+
+    bool NavMesh::hasHierarchy() const {
+        return !pData->hierarchy.empty();
+    }
+
+    void NavMesh::buildBVH(OwnedArrays& arrays) {
+        ZoneScoped;
+        const std::span<const glm::vec3> vertices = arrays.triangleVertices;
+        const std::span<const glm::vec3> centers = arrays.triangleCenters;
+        std::vector<BVHNode>& bvhNodes = arrays.bvhNodes;
+        std::vector<std::uint32_t>& bvhTriangles = arrays.bvhTriangles;
+        bvhNodes.clear();
+        bvhTriangles.resize(centers.size());
+        std::iota(WHOLE_CONTAINER(bvhTriangles), 0);
+        if(centers.empty()) {
+            return;
         }
 
-        pathfinder.setGraph(std::move(triangles), std::move(flatEdges));
+        struct PendingNode {
+            std::uint32_t nodeIndex;
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+        std::vector<PendingNode> pending;
+        bvhNodes.reserve(2 * centers.size() / BVHLeafSize + 1);
+        bvhNodes.emplace_back();
+        pending.push_back({ 0, 0, static_cast<std::uint32_t>(centers.size()) });
+        while(!pending.empty()) {
+            const PendingNode current = pending.back();
+            pending.pop_back();
+
+            glm::vec3 boundsMin { +INFINITY };
+            glm::vec3 boundsMax { -INFINITY };
+            glm::vec3 centersMin { +INFINITY };
+            glm::vec3 centersMax { -INFINITY };
+            for(std::uint32_t i = current.first; i < current.first + current.count; i++) {
+                const std::uint32_t triangle = bvhTriangles[i];
+                for(std::size_t vertex = 0; vertex < 3; vertex++) {
+                    boundsMin = glm::min(boundsMin, vertices[triangle * 3 + vertex]);
+                    boundsMax = glm::max(boundsMax, vertices[triangle * 3 + vertex]);
+                }
+                centersMin = glm::min(centersMin, centers[triangle]);
+                centersMax = glm::max(centersMax, centers[triangle]);
+            }
+            bvhNodes[current.nodeIndex].min = boundsMin;
+            bvhNodes[current.nodeIndex].max = boundsMax;
+
+            if(current.count <= BVHLeafSize) {
+                bvhNodes[current.nodeIndex].firstChildOrTriangle = current.first;
+                bvhNodes[current.nodeIndex].triangleCount = current.count;
+                continue;
+            }
+
+            // median split along the axis where triangle centers are the most spread
+            const glm::vec3 extents = centersMax - centersMin;
+            const int axis = extents.x >= extents.y && extents.x >= extents.z ? 0 : (extents.y >= extents.z ? 1 : 2);
+            const std::uint32_t half = current.count / 2;
+            auto first = bvhTriangles.begin() + current.first;
+            std::nth_element(first, first + half, first + current.count, [&](std::uint32_t a, std::uint32_t b) {
+                return centers[a][axis] < centers[b][axis];
+            });
+
+            const std::uint32_t leftChild = static_cast<std::uint32_t>(bvhNodes.size());
+            bvhNodes[current.nodeIndex].firstChildOrTriangle = leftChild;
+            bvhNodes[current.nodeIndex].triangleCount = 0;
+            bvhNodes.emplace_back();
+            bvhNodes.emplace_back();
+            pending.push_back({ leftChild, current.first, half });
+            pending.push_back({ leftChild + 1, current.first + half, current.count - half });
+        }
     }
 
-    glm::vec3 NavMesh::getClosestPointInMesh(const glm::vec3& position) {
+    glm::vec3 NavMesh::getClosestPointInMesh(const glm::vec3& position) const {
         return getClosestPosition(position).position;
     }
 
-    NavPath NavMesh::computePath(const glm::vec3& pointA, const glm::vec3& pointB) {
+    void NavMesh::getClosestPointsInMesh(std::span<const glm::vec3> positions, std::span<glm::vec3> out) const {
+        verify(out.size() >= positions.size(), "Output is too small");
+        constexpr std::size_t Granularity = 256;
+        const std::size_t chunkCount = (positions.size() + Granularity - 1) / Granularity;
+        auto snapChunk = [&](std::size_t chunkIndex) {
+            const std::size_t end = std::min(positions.size(), (chunkIndex + 1) * Granularity);
+            for(std::size_t i = chunkIndex * Granularity; i < end; i++) {
+                out[i] = getClosestPosition(positions[i]).position;
+            }
+        };
+        // through Async::parallelFor instead of GetTaskScheduler() to also work on navmeshes used outside of the engine (tools)
+        if(chunkCount > 1 && Async::parallelFor != nullptr) {
+            Async::parallelFor(chunkCount, snapChunk, 1);
+        } else {
+            for(std::size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+                snapChunk(chunkIndex);
+            }
+        }
+    }
+
+    NavPath NavMesh::computePath(const glm::vec3& pointA, const glm::vec3& pointB) const {
+        static thread_local SearchContext context;
+        return computePath(pointA, pointB, context);
+    }
+
+    NavPath NavMesh::computePath(const glm::vec3& pointA, const glm::vec3& pointB, SearchContext& context) const {
         NavMeshPosition posA = getClosestPosition(pointA);
         NavMeshPosition posB = getClosestPosition(pointB);
 
+        // empty mesh, or every triangle is blocked by obstacles: there is no path, not even a straight line
+        if(posA.triangleIndex == ~0ull || posB.triangleIndex == ~0ull) {
+            return NavPath{};
+        }
+
         if(posA.triangleIndex == posB.triangleIndex) {
             return NavPath {
                 .waypoints = {
@@ -204,103 +648,282 @@ namespace Carrot::AI {
         }
 
         // 1. find triangles to go through, via A*
+        static thread_local std::vector<std::size_t> corridor;
+        // no path found
+        if(!findCorridor(posA.triangleIndex, posB.triangleIndex, context, corridor)) {
+            return NavPath{};
+        }
+
+        // 2. find waypoints inside these triangles
+        return computePathInCorridor(pointA, posA, pointB, posB, corridor);
+    }
+
+    bool NavMesh::findCorridor(std::size_t startTriangle, std::size_t goalTriangle, SearchContext& context, std::vector<std::size_t>& corridor) const {
+        const Data& data = *pData;
+        if(!data.hierarchy.empty() && data.hierarchy.getCluster(startTriangle) != data.hierarchy.getCluster(goalTriangle)) {
+            // the hierarchy does not know about obstacles: only use its corridor if it does not go through one
+            if(!data.hierarchy.findCorridor(data.graph, startTriangle, goalTriangle, context, corridor)) {
+                return false;
+            }
+            if(!isCorridorBlocked(corridor)) {
+                return true;
+            }
+        }
+
         // cost estimate: distance between triangle centers
-        auto distance = [&](const NavMeshTriangle& a, const NavMeshTriangle& b) {
-            return glm::distance(a.center, b.center);
+        // (only depends on the triangles, so that a corridor can be reused for any pair of points inside them)
+        const std::span<const glm::vec3> centers = data.triangleCenters;
+        const glm::vec3 goalCenter = centers[goalTriangle];
+        auto distance = [&](std::size_t a, std::size_t b) {
+            // blocked triangles are never opened by A*
+            return isTriangleBlocked(b) ? INFINITY : glm::distance(centers[a], centers[b]);
         };
-        auto estimation = [&](const NavMeshTriangle& v) {
-            return glm::distance(v.center, pointB);
+        auto estimation = [&](std::size_t v) {
+            return glm::distance(centers[v], goalCenter);
         };
-        std::vector<std::size_t> triangles = pathfinder.findPath(posA.triangleIndex, posB.triangleIndex, distance, estimation);
-
-        // no path found
-        if(triangles.empty()) {
-            return NavPath{};
+        if(!data.graph.findPath(context, startTriangle, goalTriangle, distance, estimation)) {
+            return false;
         }
+        corridor.assign(context.getPath().begin(), context.getPath().end());
+        return true;
+    }
 
-        NavPath path;
-        verify(triangles[0] == posA.triangleIndex, "Path does not start at point A ?");
+    NavPath NavMesh::computePathInCorridor(const glm::vec3& pointA, const NavMeshPosition& posA,
+                                           const glm::vec3& pointB, const NavMeshPosition& posB,
+                                           std::span<const std::size_t> corridor) const {
+        verify(!corridor.empty() && corridor[0] == posA.triangleIndex, "Path does not start at point A ?");
+        verify(corridor.back() == posB.triangleIndex, "Path does not end at point B ?");
 
+        NavPath path;
         path.waypoints.push_back(pointA);
-        funnel(posA, posB, triangles, path.waypoints);
+        if(corridor.size() > 1) {
+            funnel(posA, posB, corridor, path.waypoints);
+        }
         path.waypoints.push_back(pointB);
 
         return path;
     }
 
-    IO::VectorReader& operator>>(IO::VectorReader& i, NavMesh::NavMeshTriangle& triangle) {
-        i >> triangle.index;
-        i >> triangle.triangle.a;
-        i >> triangle.triangle.b;
-        i >> triangle.triangle.c;
+    NavMesh::ObstacleID NavMesh::addObstacle(const Obstacle& obstacle) {
+        ObstacleID id;
+        if(!freeObstacleIDs.empty()) {
+            id = freeObstacleIDs.back();
+            freeObstacleIDs.pop_back();
+        } else {
+            id = static_cast<ObstacleID>(obstacles.size());
+            obstacles.emplace_back();
+        }
 
-        triangle.center = (triangle.triangle.a + triangle.triangle.b + triangle.triangle.c) / 3.0f;
+        ObstacleState& state = obstacles[id];
+        state.obstacle = obstacle;
+        state.alive = true;
+        findTrianglesTouchedBy(obstacle, state.blockedTriangles);
+        updateBlockedTriangles(state.blockedTriangles, +1);
+        return id;
+    }
 
-        return i;
+    void NavMesh::moveObstacle(ObstacleID id, const Obstacle& obstacle) {
+        verify(id < obstacles.size() && obstacles[id].alive, "Obstacle does not exist");
+        ObstacleState& state = obstacles[id];
+        state.obstacle = obstacle;
+
+        static thread_local std::vector<std::uint32_t> newTriangles;
+        static thread_local std::vector<std::uint32_t> difference;
+        findTrianglesTouchedBy(obstacle, newTriangles);
+
+        // only touch the triangles which changed, most of them stay blocked for small moves
+        difference.clear();
+        std::ranges::set_difference(state.blockedTriangles, newTriangles, std::back_inserter(difference));
+        updateBlockedTriangles(difference, -1);
+        difference.clear();
+        std::ranges::set_difference(newTriangles, state.blockedTriangles, std::back_inserter(difference));
+        updateBlockedTriangles(difference, +1);
+        state.blockedTriangles.swap(newTriangles);
     }
 
-    IO::VectorReader& operator>>(IO::VectorReader& i, Edge& edge) {
-        i >> edge.indexA;
-        i >> edge.indexB;
-        return i;
+    void NavMesh::removeObstacle(ObstacleID id) {
+        verify(id < obstacles.size() && obstacles[id].alive, "Obstacle does not exist");
+        ObstacleState& state = obstacles[id];
+        updateBlockedTriangles(state.blockedTriangles, -1);
+        state.blockedTriangles.clear();
+        state.alive = false;
+        freeObstacleIDs.push_back(id);
     }
 
-    IO::VectorWriter& operator<<(IO::VectorWriter& o, const NavMesh::NavMeshTriangle& triangle) {
-        o << triangle.index;
-        o << triangle.triangle.a;
-        o << triangle.triangle.b;
-        o << triangle.triangle.c;
-        return o;
+    bool NavMesh::isTriangleBlocked(std::size_t triangleIndex) const {
+        return blockedTriangleCount > 0 && obstacleCountPerTriangle[triangleIndex] > 0;
     }
 
-    IO::VectorWriter& operator<<(IO::VectorWriter& o, const Edge& edge) {
-        o << edge.indexA;
-        o << edge.indexB;
-        return o;
+    bool NavMesh::isCorridorBlocked(std::span<const std::size_t> corridor) const {
+        if(blockedTriangleCount == 0) {
+            return false;
+        }
+        return std::ranges::any_of(corridor, [&](std::size_t triangle) {
+            return obstacleCountPerTriangle[triangle] > 0;
+        });
     }
 
-    void NavMesh::serialize(Carrot::IO::FileHandle& output) const {
-        std::vector<std::uint8_t> data;
-        IO::VectorWriter writer { data };
+    std::uint64_t NavMesh::getObstacleVersion() const {
+        return obstacleVersion;
+    }
 
-        // write header
-        writer << std::span(CNAVMagic);
-        writer << CNAVVersion;
+    void NavMesh::updateBlockedTriangles(std::span<const std::uint32_t> triangles, int delta) {
+        if(triangles.empty()) {
+            return;
+        }
+        obstacleCountPerTriangle.resize(getTriangleCount(), 0);
+        bool changed = false;
+        for(const std::uint32_t triangle : triangles) {
+            std::uint16_t& count = obstacleCountPerTriangle[triangle];
+            verify(delta > 0 ? count < std::numeric_limits<std::uint16_t>::max() : count > 0, "Invalid obstacle count");
+            const bool wasBlocked = count > 0;
+            count = static_cast<std::uint16_t>(count + delta);
+            if(wasBlocked != (count > 0)) {
+                blockedTriangleCount += delta > 0 ? 1 : -1;
+                changed = true;
+            }
+        }
+        if(changed) {
+            obstacleVersion++;
+        }
+    }
 
-        // write triangles
-        std::vector<NavMeshTriangle> triangles;
-        triangles.reserve(pathfinder.getVertices().size());
-        for(const auto& t : pathfinder.getVertices()) {
-            triangles.emplace_back(t);
+    void NavMesh::findTrianglesTouchedBy(const Obstacle& obstacle, std::vector<std::uint32_t>& triangles) const {
+        ZoneScoped;
+        triangles.clear();
+        const Data& data = *pData;
+        if(data.bvhNodes.empty()) {
+            return;
         }
-        writer << triangles;
 
-        // write adjacency
-        std::vector<Edge> edges;
-        edges.reserve(pathfinder.getEdges().size());
-        for(const auto& e : pathfinder.getEdges()) {
-            edges.emplace_back(e);
+        // bounds of the obstacle, to only test the triangles of the BVH leaves overlapping them
+        glm::vec3 obstacleMin;
+        glm::vec3 obstacleMax;
+        const float cosYaw = glm::cos(obstacle.yaw);
+        const float sinYaw = glm::sin(obstacle.yaw);
+        switch(obstacle.shape) {
+            case Obstacle::Shape::Cylinder:
+                obstacleMin = obstacle.position - glm::vec3 { obstacle.radius, obstacle.radius, 0.0f };
+                obstacleMax = obstacle.position + glm::vec3 { obstacle.radius, obstacle.radius, obstacle.height };
+                break;
+
+            case Obstacle::Shape::Box: {
+                const glm::vec3 extents {
+                    glm::abs(cosYaw) * obstacle.halfExtents.x + glm::abs(sinYaw) * obstacle.halfExtents.y,
+                    glm::abs(sinYaw) * obstacle.halfExtents.x + glm::abs(cosYaw) * obstacle.halfExtents.y,
+                    obstacle.halfExtents.z,
+                };
+                obstacleMin = obstacle.position - extents;
+                obstacleMax = obstacle.position + extents;
+            } break;
+
+            default:
+                TODO; // missing case
         }
-        writer << edges;
 
-        writer << portalVertices;
+        auto touches = [&](std::uint32_t triangle) {
+            const glm::vec3* vertices = &data.triangleVertices[triangle * 3];
+            switch(obstacle.shape) {
+                case Obstacle::Shape::Cylinder: {
+                    const float minZ = glm::min(vertices[0].z, glm::min(vertices[1].z, vertices[2].z));
+                    const float maxZ = glm::max(vertices[0].z, glm::max(vertices[1].z, vertices[2].z));
+                    if(maxZ < obstacleMin.z || minZ > obstacleMax.z) {
+                        return false;
+                    }
+                    // vertical cylinder: distance to the triangle projected on the XY plane
+                    const Math::Triangle flatTriangle {
+                        .a = glm::vec3 { vertices[0].xy(), 0.0f },
+                        .b = glm::vec3 { vertices[1].xy(), 0.0f },
+                        .c = glm::vec3 { vertices[2].xy(), 0.0f },
+                    };
+                    const glm::vec3 center { obstacle.position.xy(), 0.0f };
+                    const glm::vec3 delta = flatTriangle.getClosestPoint(center) - center;
+                    return glm::dot(delta, delta) <= obstacle.radius * obstacle.radius;
+                }
 
-        output.write(data);
+                case Obstacle::Shape::Box: {
+                    // triangle in the space of the box, to use an axis-aligned test
+                    float localVertices[3][3];
+                    for(std::size_t i = 0; i < 3; i++) {
+                        const glm::vec3 p = vertices[i] - obstacle.position;
+                        localVertices[i][0] = cosYaw * p.x + sinYaw * p.y;
+                        localVertices[i][1] = -sinYaw * p.x + cosYaw * p.y;
+                        localVertices[i][2] = p.z;
+                    }
+                    float boxCenter[3] = { 0.0f, 0.0f, 0.0f };
+                    float boxHalfSize[3] = { obstacle.halfExtents.x, obstacle.halfExtents.y, obstacle.halfExtents.z };
+                    return triBoxOverlap(boxCenter, boxHalfSize, localVertices) != 0;
+                }
+
+                default:
+                    TODO; // missing case
+            }
+            return false;
+        };
+
+        std::array<std::uint32_t, 128> stack;
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0) {
+            const BVHNode& node = data.bvhNodes[stack[--stackSize]];
+            if(glm::any(glm::lessThan(node.max, obstacleMin)) || glm::any(glm::greaterThan(node.min, obstacleMax))) {
+                continue;
+            }
+
+            if(node.triangleCount > 0) {
+                for(std::uint32_t i = node.firstChildOrTriangle; i < node.firstChildOrTriangle + node.triangleCount; i++) {
+                    if(touches(data.bvhTriangles[i])) {
+                        triangles.push_back(data.bvhTriangles[i]);
+                    }
+                }
+                continue;
+            }
+
+            verify(stackSize + 2 <= stack.size(), "BVH is too deep");
+            stack[stackSize++] = node.firstChildOrTriangle;
+            stack[stackSize++] = node.firstChildOrTriangle + 1;
+        }
+        std::ranges::sort(triangles);
+    }
+
+    void NavMesh::serialize(Carrot::IO::FileHandle& output) const {
+        const Data& data = *pData;
+        CNAVHeader header;
+        std::vector<std::uint8_t> fileContents(sizeof(header), 0);
+        writeSection(fileContents, header, CNAVSection::TriangleVertices, data.triangleVertices);
+        writeSection(fileContents, header, CNAVSection::TriangleCenters, data.triangleCenters);
+        writeSection(fileContents, header, CNAVSection::AdjacencyOffsets, data.graph.adjacencyOffsets);
+        writeSection(fileContents, header, CNAVSection::AdjacentTriangles, data.graph.adjacentVertices);
+        writeSection(fileContents, header, CNAVSection::Portals, data.portals);
+        writeSection(fileContents, header, CNAVSection::BVHNodes, data.bvhNodes);
+        writeSection(fileContents, header, CNAVSection::BVHTriangles, data.bvhTriangles);
+        writeSection(fileContents, header, CNAVSection::ClusterOfTriangles, data.hierarchy.getClusterOfTriangles());
+        writeSection(fileContents, header, CNAVSection::IntraClusterCosts, data.hierarchy.getIntraClusterCosts());
+        std::memcpy(fileContents.data(), &header, sizeof(header));
+
+        output.write(fileContents);
     }
 
     bool NavMesh::hasTriangles() const {
-        return !pathfinder.getVertices().empty();
+        return !pData->triangleCenters.empty();
+    }
+
+    std::size_t NavMesh::getTriangleCount() const {
+        return pData->triangleCenters.size();
+    }
+
+    bool NavMesh::sharesDataWith(const NavMesh& other) const {
+        return pData->triangleCenters.data() == other.pData->triangleCenters.data();
     }
 
     void NavMesh::debugDraw() {
         const glm::vec4 color{ 0, 0, 0, 1 };
         Render::DebugRenderer& debugRenderer = GetRenderer().getDebugRenderer();
-        const auto& vertices = pathfinder.getVertices();
-        for (const auto& [indexA, indexB] : pathfinder.getEdges()) {
-            const glm::vec3& a = vertices[indexA].center;
-            const glm::vec3& b = vertices[indexB].center;
-
-            debugRenderer.drawLine(a, b, color);
+        const std::span<const glm::vec3> centers = pData->triangleCenters;
+        for(std::size_t triangle = 0; triangle < centers.size(); triangle++) {
+            for(const std::uint32_t neighbor : pData->graph.getNeighbors(triangle)) {
+                debugRenderer.drawLine(centers[triangle], centers[neighbor], color);
+            }
         }
     }
 
@@ -324,13 +947,14 @@ namespace Carrot::AI {
         return glm::dot(a-b, a-b) < 10e-12f;
     }
 
-    void NavMesh::funnel(const NavMeshPosition& startPos, const NavMeshPosition& endPos, std::span<const std::size_t> triangles, std::vector<glm::vec3>& waypoints) {
-        struct Portal {
+    void NavMesh::funnel(const NavMeshPosition& startPos, const NavMeshPosition& endPos, std::span<const std::size_t> triangles, std::vector<glm::vec3>& waypoints) const {
+        struct FunnelPortal {
             glm::vec3 left;
             glm::vec3 right;
         };
 
-        std::vector<Portal> portals;
+        const Data& data = *pData;
+        std::vector<FunnelPortal> portals;
         portals.reserve(triangles.size() + 1);
 
         auto& startPortal = portals.emplace_back();
@@ -342,14 +966,15 @@ namespace Carrot::AI {
             std::size_t triangleIndexA = triangles[i];
             std::size_t triangleIndexB = triangles[i + 1];
 
-            const NavMeshTriangle& triangleA = pathfinder.getVertices()[triangleIndexA];
-            const NavMeshTriangle& triangleB = pathfinder.getVertices()[triangleIndexB];
+            const std::span<const std::uint32_t> neighbors = data.graph.getNeighbors(triangleIndexA);
+            const auto neighborIt = std::ranges::find(neighbors, static_cast<std::uint32_t>(triangleIndexB));
+            verify(neighborIt != neighbors.end(), "Triangles of the corridor are not adjacent");
 
             // assume ZUp + entities don't move 100% vertically
-            const auto& vertices = portalVertices.at(triangleIndexA).at(triangleIndexB);
+            const Portal& vertices = data.portals[data.graph.adjacencyOffsets[triangleIndexA] + (neighborIt - neighbors.begin())];
             Math::Segment2D segment;
-            segment.first = triangleA.center.xy();
-            segment.second = triangleB.center.xy();
+            segment.first = data.triangleCenters[triangleIndexA].xy();
+            segment.second = data.triangleCenters[triangleIndexB].xy();
 
             auto& portal = portals.emplace_back();
             if(segment.getSignedDistance(vertices[0]) < 0) {
@@ -429,21 +1054,67 @@ namespace Carrot::AI {
         }
     }
 
-    NavMesh::NavMeshPosition NavMesh::getClosestPosition(const glm::vec3& position) {
+    NavMesh::NavMeshPosition NavMesh::getClosestPosition(const glm::vec3& position) const {
         float minSqDistance = std::numeric_limits<float>::infinity();
         glm::vec3 closest { NAN, NAN, NAN };
         std::size_t closestTriangleIndex = ~0ull;
-        for(const auto& navTriangle : pathfinder.getVertices()) { // ouch, I hope I can find something better than iterating over all triangles in the future
-            const Carrot::Math::Triangle& triangle = navTriangle.triangle;
-
-            const glm::vec3 p = triangle.getClosestPoint(position);
-            const glm::vec3 delta = p - position;
-            const float sqDistance = glm::dot(delta, delta);
-            if(sqDistance < minSqDistance) {
-                minSqDistance = sqDistance;
-                closest = p;
-                closestTriangleIndex = navTriangle.index;
+        const std::span<const BVHNode> bvhNodes = pData->bvhNodes;
+        const std::span<const std::uint32_t> bvhTriangles = pData->bvhTriangles;
+        const std::span<const glm::vec3> triangleVertices = pData->triangleVertices;
+        if(bvhNodes.empty()) {
+            return NavMeshPosition {
+                .triangleIndex = closestTriangleIndex,
+                .position = closest
+            };
+        }
+
+        // squared distance between 'position' and the bounds of a node, 0 if inside
+        auto getSqDistanceToNode = [&](const BVHNode& node) {
+            const glm::vec3 delta = glm::max(glm::vec3(0.0f), glm::max(node.min - position, position - node.max));
+            return glm::dot(delta, delta);
+        };
+
+        std::array<std::uint32_t, 128> stack;
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0) {
+            const BVHNode& node = bvhNodes[stack[--stackSize]];
+            if(getSqDistanceToNode(node) >= minSqDistance) {
+                continue; // cannot contain a closer triangle
+            }
+
+            if(node.triangleCount > 0) {
+                for(std::uint32_t i = node.firstChildOrTriangle; i < node.firstChildOrTriangle + node.triangleCount; i++) {
+                    const std::uint32_t triangleIndex = bvhTriangles[i];
+                    if(isTriangleBlocked(triangleIndex)) {
+                        continue;
+                    }
+                    const Math::Triangle triangle {
+                        .a = triangleVertices[triangleIndex * 3 + 0],
+                        .b = triangleVertices[triangleIndex * 3 + 1],
+                        .c = triangleVertices[triangleIndex * 3 + 2],
+                    };
+                    const glm::vec3 p = triangle.getClosestPoint(position);
+                    const glm::vec3 delta = p - position;
+                    const float sqDistance = glm::dot(delta, delta);
+                    if(sqDistance < minSqDistance) {
+                        minSqDistance = sqDistance;
+                        closest = p;
+                        closestTriangleIndex = triangleIndex;
+                    }
+                }
+                continue;
+            }
+
+            // visit the closest child first, so that it shrinks minSqDistance before looking at the other one
+            std::uint32_t nearChild = node.firstChildOrTriangle;
+            std::uint32_t farChild = node.firstChildOrTriangle + 1;
+            if(getSqDistanceToNode(bvhNodes[farChild]) < getSqDistanceToNode(bvhNodes[nearChild])) {
+                std::swap(nearChild, farChild);
             }
+            verify(stackSize + 2 <= stack.size(), "BVH is too deep");
+            stack[stackSize++] = farChild;
+            stack[stackSize++] = nearChild;
         }
 
         return NavMeshPosition {
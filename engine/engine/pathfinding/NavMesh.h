@@ -5,6 +5,7 @@
 #pragma once
 
 #include <engine/pathfinding/AStar.h>
+#include <engine/pathfinding/NavMeshHierarchy.h>
 #include <engine/pathfinding/NavPath.h>
 #include <core/math/Triangle.h>
 #include <core/scene/LoadedScene.h>
@@ -20,61 +21,206 @@ namespace Carrot::AI {
     /// Static navigation mesh. Can be used by AI agents to navigate between points inside a level
     class NavMesh {
     public:
+        /// Position inside the nav mesh
+        struct NavMeshPosition {
+            std::size_t triangleIndex = 0;
+            glm::vec3 position {0.0f};
+        };
+
+        /// Dynamic obstacle (moving door, destroyed wall...) carved out of the navmesh at runtime.
+        /// Triangles touched by an obstacle are ignored by path searches and by getClosestPosition, until it moves away or is removed
+        struct Obstacle {
+            enum class Shape {
+                Cylinder,
+                Box,
+            };
+
+            Shape shape = Shape::Cylinder;
+            glm::vec3 position { 0.0f }; //< center of the bottom of cylinders (Z up), center of boxes
+            float radius = 0.0f; //< cylinders only
+            float height = 0.0f; //< cylinders only
+            glm::vec3 halfExtents { 0.0f }; //< boxes only
+            float yaw = 0.0f; //< boxes only, rotation around Z in radians
+        };
+
+        using ObstacleID = std::uint32_t;
+
         explicit NavMesh();
 
-        /// expects glTF
+        /// expects glTF or .cnav. .cnav files on disk are loaded via loadFromFile
         void loadFromResource(const Carrot::IO::Resource& resource);
 
+        /// Loads a .cnav file. Files written by the current version are memory-mapped and used in place: loading only reads
+        /// the header, pages of the file are read by the OS when queries first touch them.
+        /// Navmeshes loaded from the same (unmodified) file share the same memory.
+        void loadFromFile(const std::filesystem::path& path);
+
         void loadFromScene(const Render::LoadedScene& scene);
 
         /// Finds the closest point to 'position' that is inside the mesh (not necessarily a vertex, can be inside polygon)
-        glm::vec3 getClosestPointInMesh(const glm::vec3& position);
+        glm::vec3 getClosestPointInMesh(const glm::vec3& position) const;
+
+        /// getClosestPointInMesh for each element of 'positions', spread over threads via Carrot::Async::parallelFor when bound. Result for positions[i] is written to out[i].
+        /// Intended to snap many agents at once.
+        void getClosestPointsInMesh(std::span<const glm::vec3> positions, std::span<glm::vec3> out) const;
+
+        /// Finds the closest point to 'position' that is inside the mesh, and the triangle it belongs to.
+        /// triangleIndex is ~0ull if the mesh is empty, or if all its triangles are blocked by obstacles
+        NavMeshPosition getClosestPosition(const glm::vec3& position) const;
 
         /// Computes path from 'pointA' to 'pointB', first transforming pointA and pointB via a similar method to getClosestPointInMesh first.
-        NavPath computePath(const glm::vec3& pointA, const glm::vec3& pointB);
+        /// The path is empty if there is none, including when the mesh is empty or fully blocked by obstacles.
+        /// Uses a search context local to the calling thread.
+        NavPath computePath(const glm::vec3& pointA, const glm::vec3& pointB) const;
+
+        /// Same as computePath(pointA, pointB), with the given search context as working memory for A*.
+        /// Can be called from multiple threads at once, as long as each call has its own context
+        NavPath computePath(const glm::vec3& pointA, const glm::vec3& pointB, SearchContext& context) const;
+
+        /// Finds the triangles to go through to reach 'goalTriangle' from 'startTriangle' (first step of computePath).
+        /// Goes through the hierarchy if there is one, and the triangles are in different clusters.
+        /// \param corridor overwritten with the triangles to go through, if there is a path
+        /// \return true if there is such a path
+        bool findCorridor(std::size_t startTriangle, std::size_t goalTriangle, SearchContext& context, std::vector<std::size_t>& corridor) const;
+
+        /// Computes the waypoints to go from 'pointA' to 'pointB' through the given triangles (second step of computePath).
+        /// \param posA closest position of pointA inside the mesh, must be inside the first triangle of 'corridor'
+        /// \param posB closest position of pointB inside the mesh, must be inside the last triangle of 'corridor'
+        /// \param corridor triangles to go through, found by findCorridor
+        NavPath computePathInCorridor(const glm::vec3& pointA, const NavMeshPosition& posA,
+                                      const glm::vec3& pointB, const NavMeshPosition& posB,
+                                      std::span<const std::size_t> corridor) const;
+
+        /// (Re)builds the hierarchy used to speed up long distance queries. Worth it for navmeshes with at least
+        /// NavMeshHierarchy::MinTriangleCount triangles. Slow: intended to be done when baking navmeshes, the hierarchy is
+        /// then saved inside .cnav files
+        void buildHierarchy(std::size_t trianglesPerCluster = NavMeshHierarchy::DefaultTrianglesPerCluster);
+
+        /// Removes the hierarchy, paths will then be searched over all triangles
+        void removeHierarchy();
+
+        bool hasHierarchy() const;
+
+        /// Blocks the triangles touched by 'obstacle'. Obstacles are specific to this instance, even if its triangles are
+        /// shared with other navmeshes. Must not be called while paths are computed on this navmesh, and obstacles are
+        /// removed when another mesh is loaded
+        ObstacleID addObstacle(const Obstacle& obstacle);
+
+        /// Changes the shape or position of an obstacle. Only the triangles which are blocked or unblocked by the change are updated
+        void moveObstacle(ObstacleID id, const Obstacle& obstacle);
+
+        void removeObstacle(ObstacleID id);
+
+        bool isTriangleBlocked(std::size_t triangleIndex) const;
+
+        /// Does the corridor go through a triangle blocked by an obstacle? Cheap check for paths computed before obstacles moved
+        bool isCorridorBlocked(std::span<const std::size_t> corridor) const;
+
+        /// Incremented each time triangles are blocked or unblocked. Paths computed with a different version may go
+        /// through obstacles (check with isCorridorBlocked), or be longer than needed
+        std::uint64_t getObstacleVersion() const;
 
         /// Writes a .cnav file with the contents of this navmesh
         void serialize(Carrot::IO::FileHandle& output) const;
 
         bool hasTriangles() const;
 
+        std::size_t getTriangleCount() const;
+
+        /// Do both navmeshes use the same triangles in memory? (copies of each other, or loaded from the same .cnav file)
+        bool sharesDataWith(const NavMesh& other) const;
+
         void debugDraw();
 
     private:
-        /// Position inside the nav mesh
-        struct NavMeshPosition {
-            std::size_t triangleIndex = 0;
-            glm::vec3 position {0.0f};
+        /// Opening between two adjacent triangles
+        using Portal = std::array<glm::vec3, 2>;
+
+        /// Node of the bounding volume hierarchy over triangles, used to find the closest triangle to a point
+        struct BVHNode {
+            glm::vec3 min{ 0.0f };
+            glm::vec3 max{ 0.0f };
+            std::uint32_t firstChildOrTriangle = 0; //< index of the left child (right child is next to it), or index of the first triangle inside 'bvhTriangles' for leaves
+            std::uint32_t triangleCount = 0; //< 0 for internal nodes
+        };
+
+        /// Graph of triangles, with the adjacency exposed to be stored in .cnav files
+        class TriangleGraph: public AStarImpl {
+        public:
+            using AStarImpl::findPath;
+            using AStarImpl::setEdges;
+            using AStarImpl::setAdjacency;
+            using AStarImpl::adjacencyOffsets;
+            using AStarImpl::adjacentVertices;
         };
 
-        struct NavMeshTriangle {
-            std::size_t index = ~0ull;
-            Math::Triangle triangle;
-            glm::vec3 center{ 0.0f };
+        /// Arrays of navmeshes which are not used in place from a file (built from a scene, or read from an older .cnav)
+        struct OwnedArrays;
+
+        /// Contents of a navmesh, never modified once loaded: can be shared by multiple NavMesh instances and threads.
+        /// Arrays have the layout of .cnav files, so that they can point directly to a mapped file
+        struct Data {
+            std::shared_ptr<const void> pStorage; //< keeps the memory of the spans alive: mapped file or OwnedArrays
+
+            std::span<const glm::vec3> triangleVertices; //< 3 per triangle
+            std::span<const glm::vec3> triangleCenters;
+
+            // nodes are triangles here
+            TriangleGraph graph;
 
-            std::size_t globalVertexIndices[3] = { ~0ull }; //< not used at runtime, not serialized
+            // parallel to the adjacency of 'graph': the portal between t and its i-th neighbor is portals[graph.adjacencyOffsets[t] + i]
+            std::span<const Portal> portals;
+
+            // BVH over triangles, root is the first node. Built at load time, and stored in .cnav files
+            std::span<const BVHNode> bvhNodes;
+            std::span<const std::uint32_t> bvhTriangles; //< triangle indices, grouped by leaf
+
+            // clusters of triangles, to plan long paths. Optional, stored in .cnav files
+            NavMeshHierarchy hierarchy;
         };
 
-        void funnel(const NavMeshPosition& startPos, const NavMeshPosition& endPos, std::span<const std::size_t> triangles, std::vector<glm::vec3>& waypoints);
+        /// Creates the data pointing to the given arrays
+        static std::shared_ptr<Data> makeData(std::shared_ptr<const OwnedArrays> pArrays);
+
+        /// Uses the contents of a .cnav file in the current version, without copying them
+        /// \param pStorage keeps 'fileContents' alive
+        static std::shared_ptr<Data> makeDataInPlace(std::shared_ptr<const void> pStorage, std::span<const std::uint8_t> fileContents, const char* fileName);
+
+        /// Reads a .cnav file written by an older version
+        static std::shared_ptr<Data> readOlderVersion(const std::vector<std::uint8_t>& fileContents, const char* fileName);
+
+        /// Builds the BVH over the triangles of 'arrays'
+        static void buildBVH(OwnedArrays& arrays);
+
+        /// Copy of the current data, to modify the hierarchy without changing the data of other navmeshes
+        std::shared_ptr<Data> copyData() const;
 
-        NavMeshPosition getClosestPosition(const glm::vec3& position);
+        /// Uses new triangles, obstacles are removed
+        void setData(std::shared_ptr<const Data> pNewData);
+
+        /// Finds the triangles touched by 'obstacle', sorted by index
+        void findTrianglesTouchedBy(const Obstacle& obstacle, std::vector<std::uint32_t>& triangles) const;
+
+        /// Adds 'delta' to the obstacle count of each of the given triangles
+        void updateBlockedTriangles(std::span<const std::uint32_t> triangles, int delta);
+
+        void funnel(const NavMeshPosition& startPos, const NavMeshPosition& endPos, std::span<const std::size_t> triangles, std::vector<glm::vec3>& waypoints) const;
 
     private:
-        // triangle -> other triangle -> shared vertices
-        std::unordered_map<std::size_t, std::unordered_map<std::size_t, std::array<glm::vec3, 2>>> portalVertices;
+        std::shared_ptr<const Data> pData;
 
-        // nodes are triangles here
-        AStar<NavMeshTriangle> pathfinder;
+        struct ObstacleState {
+            Obstacle obstacle;
+            std::vector<std::uint32_t> blockedTriangles; //< sorted
+            bool alive = false;
+        };
 
-        friend IO::VectorWriter& operator<<(IO::VectorWriter& o, const NavMesh::NavMeshTriangle& triangle);
-        friend IO::VectorReader& operator>>(IO::VectorReader& o, NavMesh::NavMeshTriangle& triangle);
-        friend IO::VectorWriter& operator<<(IO::VectorWriter& o, const Edge& edge);
-        friend IO::VectorReader& operator>>(IO::VectorReader& o, Edge& edge);
+        // obstacles of this instance, indexed by ObstacleID
+        std::vector<ObstacleState> obstacles;
+        std::vector<ObstacleID> freeObstacleIDs;
+        std::vector<std::uint16_t> obstacleCountPerTriangle; //< empty until the first obstacle is added
+        std::size_t blockedTriangleCount = 0;
+        std::uint64_t obstacleVersion = 0;
     };
 
-    IO::VectorWriter& operator<<(IO::VectorWriter& o, const NavMesh::NavMeshTriangle& triangle);
-    IO::VectorReader& operator>>(IO::VectorReader& o, NavMesh::NavMeshTriangle& triangle);
-    IO::VectorWriter& operator<<(IO::VectorWriter& o, const Edge& edge);
-    IO::VectorReader& operator>>(IO::VectorReader& o, Edge& edge);
-
 } // Carrot::AI
@@ -4,21 +4,22 @@
 
 #include "NavMeshBuilder.h"
 
+#include <chrono>
+#include <unordered_set>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include <glm/gtx/vector_query.hpp>
 #include <core/math/AABB.h>
 #include <core/math/Segment2D.h>
-#include <core/math/Sphere.h>
 #include <core/math/Triangle.h>
-#include <tribox3.h>
 #include <core/scene/LoadedScene.h>
 #include <engine/render/resources/model_loading/SceneLoader.h>
 #include <engine/render/resources/SingleMesh.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include <engine/render/RenderPacket.h>
 #include <engine/render/VulkanRenderer.h>
 #include <core/io/Logging.hpp>
+#include <core/utils/Profiling.h>
 
 namespace Carrot::AI {
 
@@ -90,12 +91,56 @@ namespace Carrot::AI {
         && edgeDirection == o.edgeDirection;
     }
 
+    /// Voxels around a tile which are needed to compute its distance field (and therefore to narrow its walkable areas)
+    /// exactly as if the world was not split into tiles
+    static std::int64_t getTilePadding(const NavMeshBuilder::BuildParams& params) {
+        return static_cast<std::int64_t>(params.characterRadius) + 1;
+    }
+
+    /// Integer division, rounded towards -infinity (tile coordinates can be negative)
+    static std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+        const std::int64_t quotient = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? quotient - 1 : quotient;
+    }
+
+    /// Voxels centered on multiples of voxelSize which can be touched by something between 'min' and 'max', with one voxel of margin
+    static void getVoxelRange(float min, float max, float voxelSize, std::int64_t& minVoxel, std::int64_t& maxVoxel) {
+        minVoxel = static_cast<std::int64_t>(glm::floor(min / voxelSize - 0.5f)) - 1;
+        maxVoxel = static_cast<std::int64_t>(glm::ceil(max / voxelSize + 0.5f)) + 1;
+    }
+
+    /// Runs 'work' and adds its duration to the timing of 'stage'
+    template<typename Work>
+    static void timeStage(std::array<double, NavMeshBuilder::BuildStageCount>& timings, NavMeshBuilder::BuildStage stage, Work&& work) {
+        const auto startTime = std::chrono::steady_clock::now();
+        work();
+        const auto endTime = std::chrono::steady_clock::now();
+        timings[static_cast<std::size_t>(stage)] += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    }
+
+    NavMeshBuilder::NavMeshBuilder(TaskScheduler& scheduler): pScheduler(&scheduler) {}
+
     void NavMeshBuilder::start(std::vector<MeshEntry>&& _entries, const BuildParams& buildParams) {
         verify(!isRunning(), "Cannot start a NavMeshBuilder which is still running");
+        verify(buildParams.tileSize > 0, "Tiles cannot be empty");
         params = buildParams;
+        fullRebuild = true;
 
         entries = std::move(_entries);
-        GetTaskScheduler().schedule(TaskDescription {
+        scheduleBuild();
+    }
+
+    void NavMeshBuilder::startIncrementalRebuild(std::vector<MeshEntry>&& _entries) {
+        verify(!isRunning(), "Cannot start a NavMeshBuilder which is still running");
+        fullRebuild = false;
+
+        entries = std::move(_entries);
+        scheduleBuild();
+    }
+
+    void NavMeshBuilder::scheduleBuild() {
+        TaskScheduler& scheduler = pScheduler != nullptr ? *pScheduler : GetTaskScheduler();
+        scheduler.schedule(TaskDescription {
             .name = "Build NavMesh",
             .task = [this](TaskHandle& task) { build(task); },
             .joiner = &taskRunning
@@ -110,89 +155,139 @@ namespace Carrot::AI {
         return navMesh;
     }
 
+    const NavMeshBuilder::BuildTimings& NavMeshBuilder::getLastTimings() const {
+        return lastTimings;
+    }
+
+    const char* NavMeshBuilder::getStageName(BuildStage stage) {
+        switch(stage) {
+            case BuildStage::LoadGeometry:
+                return "Load geometry";
+            case BuildStage::Voxelisation:
+                return "Voxelisation";
+            case BuildStage::OpenHeightField:
+                return "Open heightfield";
+            case BuildStage::DistanceField:
+                return "Distance field";
+            case BuildStage::Regions:
+                return "Regions";
+            case BuildStage::Contours:
+                return "Contours";
+            case BuildStage::Triangulation:
+                return "Triangulation";
+            case BuildStage::Stitching:
+                return "Stitching";
+            case BuildStage::NavMesh:
+                return "NavMesh";
+            default:
+                return "Unknown";
+        }
+    }
+
     void NavMeshBuilder::debugDraw(const Carrot::Render::Context& renderContext, DebugDrawType drawType) {
         const glm::vec3 halfExtents {0.5f * params.voxelSize};
         const glm::vec4 walkableColor = glm::vec4{ 0.0f, 0.0f, 1.0f, 1.0f };
-        const glm::vec4 nonWalkableColor = glm::vec4{ 1.0f, 0.0f, 0.0f, 1.0f };
         if(drawType == DebugDrawType::WalkableVoxels) {
-            for(const auto& [position, voxel] : workingData.walkableVoxels) {
-                const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, minVoxelPosition + glm::vec3 { position } * params.voxelSize + halfExtents);
-                GetRenderer().renderCuboid(renderContext, transform, halfExtents, voxel.walkable ? walkableColor : nonWalkableColor);
+            for(auto& [coords, pTile] : workingData.tiles) {
+                const Tile& tile = *pTile;
+                for(std::size_t y = tile.padding; y + tile.padding < tile.sizeY; y++) {
+                    for(std::size_t x = tile.padding; x + tile.padding < tile.sizeX; x++) {
+                        for(const SpanHeightField::Span& span : tile.heightField.getSpans(x, y)) {
+                            if(!span.walkable) {
+                                continue;
+                            }
+                            const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, voxelToWorld(tile, x, y, span.maxZ));
+                            GetRenderer().renderCuboid(renderContext, transform, halfExtents, walkableColor);
+                        }
+                    }
+                }
             }
         } else if(drawType == DebugDrawType::OpenHeightField || drawType == DebugDrawType::DistanceField || drawType == DebugDrawType::Regions) {
-            const auto& field = workingData.openHeightField;
-            for(std::int64_t y = 0; y < sizeY; y++) { // this is stupidly parallel, MAY benefit from //-ization if needed
-                for(std::int64_t x = 0; x < sizeX; x++) {
-                    const std::size_t columnIndex = x + y * sizeX;
-                    if(!field.contains(columnIndex)) { // column full of non walkable space
-                        continue;
-                    }
+            for(const auto& [coords, pTile] : workingData.tiles) {
+                const Tile& tile = *pTile;
+                const auto& field = tile.openHeightField;
+                for(std::int64_t y = 0; y < tile.sizeY; y++) {
+                    for(std::int64_t x = 0; x < tile.sizeX; x++) {
+                        const std::size_t columnIndex = x + y * tile.sizeX;
+                        if(!field.contains(columnIndex)) { // column full of non walkable space
+                            continue;
+                        }
 
-                    const auto& column = field.at(columnIndex);
-                    if(column.spans.empty()) {
-                        continue;
-                    }
+                        const auto& column = field.at(columnIndex);
+                        if(column.spans.empty()) {
+                            continue;
+                        }
 
-                    for(const auto& span : column.spans) {
-                        const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, minVoxelPosition + glm::vec3 { x, y, span.bottomZ } * params.voxelSize + halfExtents);
+                        for(const auto& span : column.spans) {
+                            const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, voxelToWorld(tile, x, y, span.bottomZ));
 
-                        glm::vec4 color = glm::vec4(0,1,0,1);
-                        if(drawType == DebugDrawType::DistanceField) {
-                            color = glm::vec4(glm::vec3{(float)span.distanceToBorder / workingData.maxDistance}, 1.0f);
-                        } else if(drawType == DebugDrawType::Regions) {
-                            if(span.regionID <= 0) {
-                                continue;
+                            glm::vec4 color = glm::vec4(0,1,0,1);
+                            if(drawType == DebugDrawType::DistanceField) {
+                                color = glm::vec4(glm::vec3{(float)span.distanceToBorder / tile.maxDistance}, 1.0f);
+                            } else if(drawType == DebugDrawType::Regions) {
+                                if(span.regionID <= 0) {
+                                    continue;
+                                }
+                                color = regionColors[(span.regionID - 1) % regionColors.size()];
                             }
-                            color = regionColors[(span.regionID - 1) % regionColors.size()];
-                        }
 
-                        GetRenderer().renderCuboid(renderContext, transform, glm::vec3 { halfExtents.x, halfExtents.y, halfExtents.z / 5.0f }, color);
+                            GetRenderer().renderCuboid(renderContext, transform, glm::vec3 { halfExtents.x, halfExtents.y, halfExtents.z / 5.0f }, color);
+                        }
                     }
                 }
-            }
 
-            for(const auto& region : workingData.regions) {
-
-                const std::size_t columnIndex = region.center.x + region.center.y * sizeX;
-                const auto& centerSpan = workingData.openHeightField.at(columnIndex).spans[region.center.z];
-                if(centerSpan.regionID <= 0) {
-                    continue;
+                for(const auto& region : tile.regions) {
+                    const std::size_t columnIndex = region.center.x + region.center.y * tile.sizeX;
+                    const auto& centerSpan = field.at(columnIndex).spans[region.center.z];
+                    if(centerSpan.regionID <= 0) {
+                        continue;
+                    }
+                    const glm::vec4 color = glm::vec4(1.0f);
+                    const glm::vec3 position = voxelToWorld(tile, region.center.x, region.center.y, centerSpan.bottomZ);
+                    const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, position);
+                    GetRenderer().render3DArrow(renderContext, transform, color);
                 }
-                const glm::vec4 color = glm::vec4(1.0f);
-                const glm::vec3 position = minVoxelPosition + glm::vec3 { region.center.x, region.center.y, centerSpan.bottomZ } * params.voxelSize + halfExtents;
-                const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, position);
-                GetRenderer().render3DArrow(renderContext, transform, color);
             }
         } else if(drawType == DebugDrawType::Contours || drawType == DebugDrawType::SimplifiedContours) {
-            for(const auto& region : workingData.regions) {
-                const auto& contour = drawType == DebugDrawType::SimplifiedContours ? region.simplifiedContour : region.contour;
-                for(const auto& contourPoint : contour) {
-                    const glm::vec4 color = regionColors[region.index % regionColors.size()];
-                    const glm::vec3 position = contourToWorld(workingData.openHeightField, contourPoint);
-                    const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, position);
-                    GetRenderer().render3DArrow(renderContext, transform, color);
+            for(const auto& [coords, pTile] : workingData.tiles) {
+                for(const auto& region : pTile->regions) {
+                    const auto& contour = drawType == DebugDrawType::SimplifiedContours ? region.simplifiedContour : region.contour;
+                    for(const auto& contourPoint : contour) {
+                        const glm::vec4 color = regionColors[region.index % regionColors.size()];
+                        const glm::vec3 position = contourToWorld(*pTile, contourPoint);
+                        const glm::mat4 transform = glm::translate(glm::mat4{1.0f}, position);
+                        GetRenderer().render3DArrow(renderContext, transform, color);
+                    }
                 }
             }
         } else if(drawType == DebugDrawType::RegionMeshes) {
-            for(const auto& region : workingData.regions) {
-                if(region.triangulatedRegionMesh) {
-                    Render::Packet& packet = GetRenderer().makeRenderPacket(Carrot::Render::PassEnum::Unlit, Render::PacketType::DrawIndexedInstanced, renderContext);
-                    Carrot::GBufferDrawData data;
-                    data.materialIndex = GetRenderer().getWhiteMaterial().getSlot();
-
-                    packet.useMesh(*region.triangulatedRegionMesh);
-                    packet.pipeline = GetRenderer().getOrCreatePipeline("gBufferWireframe");
-
-                    packet.addPerDrawData({&data, 1});
-
-                    Carrot::InstanceData instance;
-                    instance.color = regionColors[region.index % regionColors.size()];
-                    instance.transform = glm::mat4(1.0f);
-                    packet.useInstance(instance);
-                    GetRenderer().render(packet);
+            for(auto& [coords, pTile] : workingData.tiles) {
+                for(auto& region : pTile->regions) {
+                    if(!region.triangulatedRegionMesh && !region.triangulatedRegion.faces.empty()) {
+                        region.triangulatedRegionMesh = graphToMesh(region.triangulatedRegion);
+                    }
+                    if(region.triangulatedRegionMesh) {
+                        Render::Packet& packet = GetRenderer().makeRenderPacket(Carrot::Render::PassEnum::Unlit, Render::PacketType::DrawIndexedInstanced, renderContext);
+                        Carrot::GBufferDrawData data;
+                        data.materialIndex = GetRenderer().getWhiteMaterial().getSlot();
+
+                        packet.useMesh(*region.triangulatedRegionMesh);
+                        packet.pipeline = GetRenderer().getOrCreatePipeline("gBufferWireframe");
+
+                        packet.addPerDrawData({&data, 1});
+
+                        Carrot::InstanceData instance;
+                        instance.color = regionColors[region.index % regionColors.size()];
+                        instance.transform = glm::mat4(1.0f);
+                        packet.useInstance(instance);
+                        GetRenderer().render(packet);
+                    }
                 }
             }
         } else if(drawType == DebugDrawType::Mesh) {
+            if(!workingData.debugRawMesh && !workingData.rawMesh.faces.empty()) {
+                workingData.debugRawMesh = graphToMesh(workingData.rawMesh);
+            }
             if(workingData.debugRawMesh) {
                 Render::Packet& packet = GetRenderer().makeRenderPacket(Carrot::Render::PassEnum::Unlit, Render::PacketType::DrawIndexedInstanced, renderContext);
                 Carrot::GBufferDrawData data;
@@ -212,57 +307,197 @@ namespace Carrot::AI {
         }
     }
 
-    void NavMeshBuilder::build(TaskHandle&) {
-        const float voxelSize = params.voxelSize;
-        const float maxSlope = params.maxSlope;
-        debugStep = "Compute bounds";
+    void NavMeshBuilder::build(TaskHandle& task) {
+        const auto buildStart = std::chrono::steady_clock::now();
+        BuildTimings timings;
 
-        Math::AABB completeBounds;
-        completeBounds.min = glm::vec3{ +INFINITY };
-        completeBounds.max = glm::vec3{ -INFINITY };
-        for(std::size_t i = 0; i < entries.size(); i++) {
-            auto pModel = entries[i].model;
-            auto modelTransform = entries[i].transform;
-            for(const auto& [_, meshes] : pModel->getStaticMeshesPerMaterial()) {
-                for(const auto& meshInfo : meshes) {
-                    Math::Sphere worldSphere = meshInfo.boundingSphere;
-                    worldSphere.transform(modelTransform * meshInfo.transform);
-
-                    Math::AABB bounds;
-                    bounds.loadFromSphere(worldSphere);
-
-                    completeBounds.min = glm::min(completeBounds.min, bounds.min);
-                    completeBounds.max = glm::max(completeBounds.max, bounds.max);
+        debugStep = "Load geometry";
+        if(fullRebuild) {
+            workingData = {};
+        }
+        workingData.debugRawMesh = nullptr;
+
+        std::vector<Math::AABB> changedAreas;
+        timeStage(timings.stageMilliseconds, BuildStage::LoadGeometry, [&]() {
+            loadGeometry(changedAreas);
+        });
+
+        debugStep = "Prepare tiles";
+        // replace tiles which can be affected by the changes, by new empty tiles
+        std::unordered_map<glm::ivec2, Tile*> tilesToBuild;
+        const std::int64_t padding = getTilePadding(params);
+        const std::int64_t tileSize = static_cast<std::int64_t>(params.tileSize);
+        for(const Math::AABB& area : changedAreas) {
+            glm::ivec2 minTile;
+            glm::ivec2 maxTile;
+            getTileRange(area, minTile, maxTile);
+            for(std::int32_t tileY = minTile.y; tileY <= maxTile.y; tileY++) {
+                for(std::int32_t tileX = minTile.x; tileX <= maxTile.x; tileX++) {
+                    const glm::ivec2 coords { tileX, tileY };
+                    if(tilesToBuild.contains(coords)) {
+                        continue;
+                    }
+
+                    auto pTile = std::make_unique<Tile>();
+                    pTile->coords = coords;
+                    pTile->padding = padding;
+                    pTile->originX = tileX * tileSize - padding;
+                    pTile->originY = tileY * tileSize - padding;
+                    pTile->sizeX = tileSize + 2 * padding;
+                    pTile->sizeY = tileSize + 2 * padding;
+                    tilesToBuild[coords] = pTile.get();
+                    workingData.tiles[coords] = std::move(pTile);
                 }
             }
         }
 
-        debugStep = "Allocate memory for voxelisation";
-        workingData = {};
+        // give each tile the triangles which can affect it
+        for(const EntryGeometry& geometry : workingData.geometry) {
+            glm::ivec2 minEntryTile;
+            glm::ivec2 maxEntryTile;
+            getTileRange(geometry.bounds, minEntryTile, maxEntryTile);
+            bool affectsRebuiltTiles = false;
+            for(const auto& [coords, pTile] : tilesToBuild) {
+                affectsRebuiltTiles |= glm::all(glm::greaterThanEqual(coords, minEntryTile)) && glm::all(glm::lessThanEqual(coords, maxEntryTile));
+            }
+            if(!affectsRebuiltTiles) {
+                continue;
+            }
 
-        minVoxelPosition = completeBounds.min;
-        size = completeBounds.max - completeBounds.min;
+            for(const InputTriangle& triangle : geometry.triangles) {
+                Math::AABB triangleBounds;
+                triangleBounds.min = glm::min(triangle.vertices[0], glm::min(triangle.vertices[1], triangle.vertices[2]));
+                triangleBounds.max = glm::max(triangle.vertices[0], glm::max(triangle.vertices[1], triangle.vertices[2]));
+                glm::ivec2 minTile;
+                glm::ivec2 maxTile;
+                getTileRange(triangleBounds, minTile, maxTile);
+                for(std::int32_t tileY = minTile.y; tileY <= maxTile.y; tileY++) {
+                    for(std::int32_t tileX = minTile.x; tileX <= maxTile.x; tileX++) {
+                        auto it = tilesToBuild.find(glm::ivec2 { tileX, tileY });
+                        if(it != tilesToBuild.end()) {
+                            it->second->triangles.push_back(&triangle);
+                        }
+                    }
+                }
+            }
+        }
+
+        // tiles which no longer contain anything
+        std::erase_if(tilesToBuild, [&](const auto& pair) {
+            if(pair.second->triangles.empty()) {
+                workingData.tiles.erase(pair.first);
+                return true;
+            }
+            return false;
+        });
+
+        TaskScheduler& scheduler = pScheduler != nullptr ? *pScheduler : GetTaskScheduler();
+
+        // rasterise all tiles, by bands of rows
+        debugStep = Carrot::sprintf("Voxelise %llu tiles", tilesToBuild.size());
+        Async::Counter tilesVoxelised;
+        for(const auto& [coords, pTile] : tilesToBuild) {
+            prepareHeightField(*pTile);
+            const std::size_t bandCount = (pTile->sizeY + RasterisationBandRows - 1) / RasterisationBandRows;
+            pTile->bandMilliseconds.resize(bandCount);
+            for(std::size_t bandIndex = 0; bandIndex < bandCount; bandIndex++) {
+                scheduler.scheduleLeaf(LeafTaskDescription {
+                    .name = "Voxelise NavMesh tile",
+                    .task = [this, pTile, bandIndex]() {
+                        const auto startTime = std::chrono::steady_clock::now();
+                        const std::size_t firstRow = bandIndex * RasterisationBandRows;
+                        voxelise(*pTile, firstRow, std::min(firstRow + RasterisationBandRows, pTile->sizeY));
+                        pTile->bandMilliseconds[bandIndex] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                    },
+                    .joiner = &tilesVoxelised,
+                }, TaskScheduler::AssetLoading);
+            }
+        }
+        task.wait(tilesVoxelised);
+
+        debugStep = Carrot::sprintf("Build %llu tiles", tilesToBuild.size());
+        Async::Counter tilesBuilt;
+        for(const auto& [coords, pTile] : tilesToBuild) {
+            scheduler.scheduleLeaf(LeafTaskDescription {
+                .name = "Build NavMesh tile",
+                .task = [this, pTile]() {
+                    buildTile(*pTile);
+                },
+                .joiner = &tilesBuilt,
+            }, TaskScheduler::AssetLoading);
+        }
+        task.wait(tilesBuilt);
+
+        for(const auto& [coords, pTile] : tilesToBuild) {
+            pTile->triangles.clear();
+            for(double bandDuration : pTile->bandMilliseconds) {
+                pTile->stageMilliseconds[static_cast<std::size_t>(BuildStage::Voxelisation)] += bandDuration;
+            }
+            for(std::size_t stage = 0; stage < BuildStageCount; stage++) {
+                timings.stageMilliseconds[stage] += pTile->stageMilliseconds[stage];
+            }
+        }
 
-        sizeX = ceil(size.x / voxelSize);
-        sizeY = ceil(size.y / voxelSize);
-        sizeZ = ceil(size.z / voxelSize);
+        debugStep = "Stitch tiles";
+        timeStage(timings.stageMilliseconds, BuildStage::Stitching, [&]() {
+            stitchTiles(workingData.rawMesh);
+        });
 
-        auto& voxels = workingData.voxelizedScene;
-        voxels.reset(sizeX, sizeY, sizeZ);
+        // create NavMesh instance
+        timeStage(timings.stageMilliseconds, BuildStage::NavMesh, [&]() {
+            makeNavMesh(workingData.rawMesh, navMesh);
+        });
 
-        const glm::vec3 halfSize { voxelSize / 2.0f };
+        timings.rebuiltTileCount = tilesToBuild.size();
+        timings.tileCount = workingData.tiles.size();
+        timings.totalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+        lastTimings = timings;
+        debugStep = "Finished!";
+    }
+
+    void NavMeshBuilder::loadGeometry(std::vector<Math::AABB>& changedAreas) {
+        const float maxSlope = params.maxSlope;
         const glm::vec3 upVector { 0.0f, 0.0f, 1.0f };
 
-        Math::AABB triangleBounds;
-        float vertices[3][3];
-        // TODO: //-ize?
+        std::vector<EntryGeometry> previousGeometry = std::move(workingData.geometry);
+        std::vector<bool> stillPresent(previousGeometry.size(), false);
+        workingData.geometry.clear();
         for(std::size_t i = 0; i < entries.size(); i++) {
-            auto pModel = entries[i].model;
-            debugStep = Carrot::sprintf("Voxelise meshes %llu / %llu - %s", i, entries.size(), pModel->getOriginatingResource().getName().c_str());
-            // reload original model to have CPU visible meshes. We could copy from GPU but that would be painful to write
+            const MeshEntry& entry = entries[i];
+
+            // reuse the triangles of the previous build if this entry did not change
+            bool reused = false;
+            for(std::size_t previousIndex = 0; previousIndex < previousGeometry.size(); previousIndex++) {
+                const MeshEntry& previousEntry = previousGeometry[previousIndex].entry;
+                if(!stillPresent[previousIndex]
+                   && previousEntry.model == entry.model
+                   && previousEntry.scene == entry.scene
+                   && previousEntry.transform == entry.transform) {
+                    stillPresent[previousIndex] = true;
+                    workingData.geometry.emplace_back(std::move(previousGeometry[previousIndex]));
+                    reused = true;
+                    break;
+                }
+            }
+            if(reused) {
+                continue;
+            }
+
+            EntryGeometry& geometry = workingData.geometry.emplace_back();
+            geometry.entry = entry;
+            geometry.bounds.min = glm::vec3{ +INFINITY };
+            geometry.bounds.max = glm::vec3{ -INFINITY };
 
+            // reload original model to have CPU visible meshes. We could copy from GPU but that would be painful to write
             Render::SceneLoader loader;
-            Render::LoadedScene& scene = loader.load(pModel->getOriginatingResource());
+            const Render::LoadedScene* pScene = entry.scene.get();
+            if(pScene == nullptr) {
+                verify(entry.model, "A MeshEntry needs a model or a scene");
+                debugStep = Carrot::sprintf("Load geometry %llu / %llu - %s", i, entries.size(), entry.model->getOriginatingResource().getName().c_str());
+                pScene = &loader.load(entry.model->getOriginatingResource());
+            }
+            const Render::LoadedScene& scene = *pScene;
+            verify(scene.nodeHierarchy, "Scenes given to NavMeshBuilder need a node hierarchy");
 
             std::function<void(const Carrot::Render::SkeletonTreeNode&, glm::mat4)> recursivelyLoadNodes = [&](const Carrot::Render::SkeletonTreeNode& node, const glm::mat4& nodeTransform) {
                 glm::mat4 transform = nodeTransform * node.bone.originalTransform;
@@ -273,11 +508,9 @@ namespace Carrot::AI {
                         // for each primitive
                         auto& primitive = scene.primitives[meshIndex];
 
-                        // for each triangle, intersect all voxels the triangle spans over, changing their state if there is an intersection
-                        std::int64_t j = 0;
-                        for(; j < primitive.indices.size(); j += 3) {
-                            triangleBounds.min = glm::vec3{ +INFINITY };
-                            triangleBounds.max = glm::vec3{ -INFINITY };
+                        geometry.triangles.reserve(geometry.triangles.size() + primitive.indices.size() / 3);
+                        for(std::size_t j = 0; j < primitive.indices.size(); j += 3) {
+                            InputTriangle& triangle = geometry.triangles.emplace_back();
 
                             glm::vec3 normal{0.0f};
                             for (int vertexInTriangle = 0; vertexInTriangle < 3; ++vertexInTriangle) {
@@ -286,43 +519,15 @@ namespace Carrot::AI {
                                 vertexPosition.x /= vertexPosition.w;
                                 vertexPosition.y /= vertexPosition.w;
                                 vertexPosition.z /= vertexPosition.w;
-                                for (int dimension = 0; dimension < 3; ++dimension) {
-                                    vertices[vertexInTriangle][dimension] = vertexPosition[dimension];
-                                    triangleBounds.min[dimension] = glm::min(triangleBounds.min[dimension], vertexPosition[dimension]);
-                                    triangleBounds.max[dimension] = glm::max(triangleBounds.max[dimension], vertexPosition[dimension]);
-                                }
+                                triangle.vertices[vertexInTriangle] = glm::vec3 { vertexPosition.x, vertexPosition.y, vertexPosition.z };
+                                geometry.bounds.min = glm::min(geometry.bounds.min, triangle.vertices[vertexInTriangle]);
+                                geometry.bounds.max = glm::max(geometry.bounds.max, triangle.vertices[vertexInTriangle]);
                                 normal += normalTransform * primitive.vertices[index].normal;
                             }
                             normal = glm::normalize(normal);
 
-                            const bool walkable = glm::angle(normal, upVector) <= maxSlope;
-
-                            triangleBounds.min = glm::floor(triangleBounds.min / voxelSize) * voxelSize - voxelSize;
-                            triangleBounds.max = glm::ceil(triangleBounds.max / voxelSize) * voxelSize + voxelSize;
-                            for(float z = triangleBounds.min.z; z <= triangleBounds.max.z; z += voxelSize) {
-                                for(float y = triangleBounds.min.y; y <= triangleBounds.max.y; y += voxelSize) {
-                                    for (float x = triangleBounds.min.x; x <= triangleBounds.max.x; x += voxelSize) {
-                                        const glm::vec3 boxCorner {x, y, z};
-                                        const glm::vec3 boxCenter = boxCorner + halfSize;
-
-                                        float c[3] = { x, y, z };
-                                        float h[3] = { halfSize.x, halfSize.y, halfSize.z };
-                                        bool intersect = triBoxOverlap(c, h, vertices) != 0;
-
-                                        if(intersect) {
-                                            const glm::ivec3 localPosition = glm::floor((boxCorner - completeBounds.min + halfSize) / voxelSize);
-                                            if(localPosition.x >= 0 && localPosition.x < sizeX
-                                               && localPosition.y >= 0 && localPosition.y < sizeY
-                                               && localPosition.z >= 0 && localPosition.z < sizeZ) {
-                                                auto& voxel = voxels.insert(localPosition);
-                                                voxel.walkable |= walkable;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
+                            triangle.walkable = glm::angle(normal, upVector) <= maxSlope;
                         }
-                        Carrot::Log::info("index = %lld / %llu", j, primitive.indices.size());
                     }
                 }
 
@@ -331,54 +536,218 @@ namespace Carrot::AI {
                 }
             };
 
-            recursivelyLoadNodes(scene.nodeHierarchy->hierarchy, entries[i].transform);
+            recursivelyLoadNodes(scene.nodeHierarchy->hierarchy, entry.transform);
+            if(!geometry.triangles.empty()) {
+                changedAreas.push_back(geometry.bounds);
+            }
         }
-        voxels.finishBuild();
 
-        debugStep = "Remove voxels with unsufficient clearance";
-
-        workingData.walkableVoxels.reset(sizeX, sizeY, sizeZ);
-        for(const auto& [position, voxel] : voxels) {
-            if(voxel.walkable) {
-                workingData.walkableVoxels.insert(position);
+        // removed entries
+        for(std::size_t previousIndex = 0; previousIndex < previousGeometry.size(); previousIndex++) {
+            if(!stillPresent[previousIndex] && !previousGeometry[previousIndex].triangles.empty()) {
+                changedAreas.push_back(previousGeometry[previousIndex].bounds);
             }
         }
-        workingData.walkableVoxels.finishBuild();
+        entries.clear();
+    }
+
+    void NavMeshBuilder::getTileRange(const Math::AABB& bounds, glm::ivec2& minTile, glm::ivec2& maxTile) const {
+        const std::int64_t padding = getTilePadding(params);
+        const std::int64_t tileSize = static_cast<std::int64_t>(params.tileSize);
+        for(int axis = 0; axis < 2; axis++) {
+            std::int64_t minVoxel;
+            std::int64_t maxVoxel;
+            getVoxelRange(bounds.min[axis], bounds.max[axis], params.voxelSize, minVoxel, maxVoxel);
+            minTile[axis] = static_cast<std::int32_t>(floorDiv(minVoxel - padding, tileSize));
+            maxTile[axis] = static_cast<std::int32_t>(floorDiv(maxVoxel + padding, tileSize));
+        }
+    }
+
+    void NavMeshBuilder::buildTile(Tile& tile) {
+        ZoneScoped;
+        auto& timings = tile.stageMilliseconds;
 
         // 1. open heightfield, handle climbable steps & connectivity here
-        buildOpenHeightField(workingData.voxelizedScene, workingData.openHeightField);
+        timeStage(timings, BuildStage::OpenHeightField, [&]() {
+            buildOpenHeightField(tile);
+        });
+
+        timeStage(timings, BuildStage::DistanceField, [&]() {
+            // 2. from connectivity & heightfield, compute distance field
+            buildDistanceField(tile);
 
-        // 2. from connectivity & heightfield, compute distance field
-        buildDistanceField(workingData.openHeightField);
+            // 3. from distance field, remove cells where agents cannot walk (too narrow)
+            narrowDistanceField(tile);
 
-        // 3. from distance field, remove cells where agents cannot walk (too narrow)
-        narrowDistanceField(workingData.openHeightField);
+            // the padding is no longer needed, the rest of the tile is built as if its neighbors did not exist
+            removePadding(tile);
+        });
 
         // 4. from distance field, create regions (watershed ??) and determine region connectivity (walk along contour and find connected regions)
-        buildRegions(workingData.openHeightField, workingData.regions);
+        timeStage(timings, BuildStage::Regions, [&]() {
+            buildRegions(tile);
+        });
 
         // 5. create contours
-        buildContours(workingData.openHeightField, workingData.regions);
+        timeStage(timings, BuildStage::Contours, [&]() {
+            buildContours(tile);
+        });
 
         // 6. simplify contours
-        //simplifyContours(workingData.openHeightField, workingData.regions);
+        //simplifyContours(tile);
 
         // 7. from simplified contours, create mesh (reuse vertices between regions to keep connectivity)
-        buildMesh(workingData.openHeightField, workingData.regions, workingData.rawMesh);
+        timeStage(timings, BuildStage::Triangulation, [&]() {
+            buildMesh(tile);
+        });
+    }
 
-        // 8. create NavMesh instance
-        makeNavMesh(workingData.rawMesh, navMesh);
+    void NavMeshBuilder::stitchTiles(Graph& rawMesh) {
+        ZoneScoped;
+        rawMesh = {};
 
-        debugStep = "Finished!";
+        // sort tiles to always get the same mesh from the same tiles
+        std::vector<const Tile*> sortedTiles;
+        sortedTiles.reserve(workingData.tiles.size());
+        for(const auto& [coords, pTile] : workingData.tiles) {
+            sortedTiles.push_back(pTile.get());
+        }
+        std::ranges::sort(sortedTiles, [](const Tile* a, const Tile* b) {
+            return a->coords.y != b->coords.y ? a->coords.y < b->coords.y : a->coords.x < b->coords.x;
+        });
+
+        // Tiles do not see each other's regions: vertices on both sides of a tile border can have slightly different heights
+        // (see contourToWorldBorderAware). Vertices at the same X,Y coming from different tiles, and close enough along Z
+        // to be connected, are moved to their average height, so that edges of both tiles overlap.
+        struct BorderVertex {
+            std::int64_t cornerX = 0;
+            std::int64_t cornerY = 0;
+            float z = 0.0f;
+            std::size_t tileIndex = 0;
+            std::size_t pointIndex = 0;
+        };
+        std::vector<std::vector<glm::vec3>> points(sortedTiles.size());
+        std::vector<BorderVertex> borderVertices;
+        const std::int64_t tileSize = static_cast<std::int64_t>(params.tileSize);
+        for(std::size_t tileIndex = 0; tileIndex < sortedTiles.size(); tileIndex++) {
+            points[tileIndex] = sortedTiles[tileIndex]->rawMesh.points;
+            for(std::size_t pointIndex = 0; pointIndex < points[tileIndex].size(); pointIndex++) {
+                const glm::vec3& point = points[tileIndex][pointIndex];
+
+                // vertices are on corners of voxels, see contourToWorld
+                const std::int64_t cornerX = std::llround(point.x / params.voxelSize + 0.5f);
+                const std::int64_t cornerY = std::llround(point.y / params.voxelSize + 0.5f);
+                if(cornerX % tileSize == 0 || cornerY % tileSize == 0) {
+                    borderVertices.emplace_back(BorderVertex {
+                        .cornerX = cornerX,
+                        .cornerY = cornerY,
+                        .z = point.z,
+                        .tileIndex = tileIndex,
+                        .pointIndex = pointIndex,
+                    });
+                }
+            }
+        }
+
+        std::ranges::sort(borderVertices, [](const BorderVertex& a, const BorderVertex& b) {
+            if(a.cornerX != b.cornerX) {
+                return a.cornerX < b.cornerX;
+            }
+            if(a.cornerY != b.cornerY) {
+                return a.cornerY < b.cornerY;
+            }
+            return a.z < b.z;
+        });
+
+        const float maxStepHeight = params.maxClimbHeight * params.voxelSize;
+        for(std::size_t groupStart = 0; groupStart < borderVertices.size();) {
+            const BorderVertex& first = borderVertices[groupStart];
+            std::size_t groupEnd = groupStart + 1;
+            float heightSum = first.z;
+            bool fromSeveralTiles = false;
+            for(; groupEnd < borderVertices.size(); groupEnd++) {
+                const BorderVertex& vertex = borderVertices[groupEnd];
+                if(vertex.cornerX != first.cornerX || vertex.cornerY != first.cornerY || vertex.z - borderVertices[groupEnd - 1].z > maxStepHeight) {
+                    break;
+                }
+                heightSum += vertex.z;
+                fromSeveralTiles |= vertex.tileIndex != first.tileIndex;
+            }
+
+            if(fromSeveralTiles) {
+                const float height = heightSum / static_cast<float>(groupEnd - groupStart);
+                for(std::size_t i = groupStart; i < groupEnd; i++) {
+                    points[borderVertices[i].tileIndex][borderVertices[i].pointIndex].z = height;
+                }
+            }
+            groupStart = groupEnd;
+        }
+
+        // merge shared vertices
+        std::unordered_map<glm::vec3, std::size_t> vertexIndices; // index of vertex position inside rawMesh.vertices
+        for(std::size_t tileIndex = 0; tileIndex < sortedTiles.size(); tileIndex++) {
+            std::vector<std::size_t> remap(points[tileIndex].size());
+            for(std::size_t i = 0; i < points[tileIndex].size(); i++) {
+                const glm::vec3& point = points[tileIndex][i];
+                auto [iter, isNew] = vertexIndices.try_emplace(point, rawMesh.points.size());
+                if(isNew) {
+                    rawMesh.points.push_back(point);
+                }
+                remap[i] = iter->second;
+            }
+
+            for(const auto& face : sortedTiles[tileIndex]->rawMesh.faces) {
+                auto& newFace = rawMesh.faces.emplace_back();
+                newFace.indexA = remap[face.indexA];
+                newFace.indexB = remap[face.indexB];
+                newFace.indexC = remap[face.indexC];
+            }
+        }
+    }
+
+    glm::vec3 NavMeshBuilder::voxelToWorld(const Tile& tile, std::int64_t x, std::int64_t y, std::int64_t z) const {
+        return glm::vec3 { tile.originX + x, tile.originY + y, tile.originZ + z } * params.voxelSize;
+    }
+
+    bool NavMeshBuilder::isInsideTile(const Tile& tile, std::int64_t x, std::int64_t y) const {
+        const std::int64_t padding = static_cast<std::int64_t>(tile.padding);
+        return x >= padding && y >= padding
+            && x < static_cast<std::int64_t>(tile.sizeX) - padding
+            && y < static_cast<std::int64_t>(tile.sizeY) - padding;
+    }
+
+    void NavMeshBuilder::prepareHeightField(Tile& tile) {
+        // the tile only needs to go from its lowest to its highest triangle
+        float minZ = +INFINITY;
+        float maxZ = -INFINITY;
+        for(const InputTriangle* pTriangle : tile.triangles) {
+            for(const glm::vec3& vertex : pTriangle->vertices) {
+                minZ = glm::min(minZ, vertex.z);
+                maxZ = glm::max(maxZ, vertex.z);
+            }
+        }
+        std::int64_t maxVoxelZ;
+        getVoxelRange(minZ, maxZ, params.voxelSize, tile.originZ, maxVoxelZ);
+        tile.sizeZ = maxVoxelZ - tile.originZ + 1;
+
+        tile.heightField.reset(tile.sizeX, tile.sizeY, tile.sizeZ);
+    }
+
+    void NavMeshBuilder::voxelise(Tile& tile, std::size_t firstRow, std::size_t endRow) {
+        ZoneScoped;
+        const glm::vec3 origin = voxelToWorld(tile, 0, 0, 0);
+        for(const InputTriangle* pTriangle : tile.triangles) {
+            tile.heightField.rasteriseTriangle(pTriangle->vertices, pTriangle->walkable, origin, params.voxelSize, firstRow, endRow);
+        }
     }
 
     bool NavMeshBuilder::doSpansConnect(const HeightFieldSpan& spanA, const HeightFieldSpan& spanB) {
         return abs(spanA.bottomZ - spanB.bottomZ) <= params.maxClimbHeight;
     }
 
-    bool NavMeshBuilder::doContourPointsConnect(const OpenHeightField& field, const ContourPoint& pointA, const ContourPoint& pointB) {
-        const glm::vec3 worldA = contourToWorld(field, pointA);
-        const glm::vec3 worldB = contourToWorld(field, pointB);
+    bool NavMeshBuilder::doContourPointsConnect(const Tile& tile, const ContourPoint& pointA, const ContourPoint& pointB) {
+        const glm::vec3 worldA = contourToWorld(tile, pointA);
+        const glm::vec3 worldB = contourToWorld(tile, pointB);
 
         if(glm::abs(worldA.x - worldB.x) > params.voxelSize*0.5f) {
             return false;
@@ -388,43 +757,44 @@ namespace Carrot::AI {
         }
 
         // same "final" X,Y. Check if they are close along Z axis
-        const std::size_t columnIndexA = pointA.x + pointA.y * sizeX;
-        const std::size_t columnIndexB = pointB.x + pointB.y * sizeX;
+        const auto& field = tile.openHeightField;
+        const std::size_t columnIndexA = pointA.x + pointA.y * tile.sizeX;
+        const std::size_t columnIndexB = pointB.x + pointB.y * tile.sizeX;
         const auto& spanA = field.at(columnIndexA).spans.at(pointA.spanIndex);
         const auto& spanB = field.at(columnIndexB).spans.at(pointB.spanIndex);
         return doSpansConnect(spanA, spanB);
     }
 
-    glm::vec3 NavMeshBuilder::contourToWorld(const OpenHeightField& field, const ContourPoint& point) {
-        const glm::vec3 halfExtents {0.5f * params.voxelSize};
-        const std::size_t columnIndex = point.x + point.y * sizeX;
-        const auto& span = field.at(columnIndex).spans.at(point.spanIndex);
+    glm::vec3 NavMeshBuilder::contourToWorld(const Tile& tile, const ContourPoint& point) {
+        const std::size_t columnIndex = point.x + point.y * tile.sizeX;
+        const auto& span = tile.openHeightField.at(columnIndex).spans.at(point.spanIndex);
 
+        // voxels are centered on multiples of voxelSize, contour points are on their corners
         const glm::vec3 directionOffsets[DirectionCount] = {
-                glm::vec3{ 1.0f, 1.0f, 0.0f }, // Right
-                glm::vec3{ 0.0f, 1.0f, 0.0f }, // Forward
-                glm::vec3{ 0.0f, 0.0f, 0.0f }, // Left
-                glm::vec3{ 1.0f, 0.0f, 0.0f }, // Backwards
+                glm::vec3{ 0.5f, 0.5f, 0.0f }, // Right
+                glm::vec3{ -0.5f, 0.5f, 0.0f }, // Forward
+                glm::vec3{ -0.5f, -0.5f, 0.0f }, // Left
+                glm::vec3{ 0.5f, -0.5f, 0.0f }, // Backwards
         };
 
-        return minVoxelPosition + glm::vec3 { point.x, point.y, span.bottomZ } * params.voxelSize + directionOffsets[point.edgeDirection] * params.voxelSize;
+        // offset is added before scaling, so that tiles on both sides of a border compute exactly the same position
+        const glm::vec3 voxelCoords { tile.originX + point.x, tile.originY + point.y, tile.originZ + span.bottomZ };
+        return (voxelCoords + directionOffsets[point.edgeDirection]) * params.voxelSize;
     }
 
-    glm::vec3 NavMeshBuilder::contourToWorldBorderAware(const OpenHeightField& field, const ContourPoint& point, const Region& originalRegion, bool& isShared) {
+    glm::vec3 NavMeshBuilder::contourToWorldBorderAware(const Tile& tile, const ContourPoint& point, const Region& originalRegion, bool& isShared) {
         isShared = false;
-        const std::size_t columnIndex = point.x + point.y * sizeX;
-        const auto& span = field.at(columnIndex).spans.at(point.spanIndex);
 
-        glm::vec3 worldPositionSum = contourToWorld(field, point);
+        glm::vec3 worldPositionSum = contourToWorld(tile, point);
         float matchingPointsCount = 1.0f;
-        for(const auto& region : workingData.regions) {
+        for(const auto& region : tile.regions) {
             for(const auto& contourPoint : region.contour) {
                 if(contourPoint == point) {
                     continue;
                 }
 
-                if(doContourPointsConnect(field, point, contourPoint)) {
-                    worldPositionSum += contourToWorld(field, contourPoint);
+                if(doContourPointsConnect(tile, point, contourPoint)) {
+                    worldPositionSum += contourToWorld(tile, contourPoint);
                     matchingPointsCount += 1.0f;
 
                     if(region.index != originalRegion.index) {
@@ -437,49 +807,37 @@ namespace Carrot::AI {
         return worldPositionSum / matchingPointsCount;
     }
 
-    void NavMeshBuilder::buildOpenHeightField(const SparseVoxelGrid& voxels, OpenHeightField& field) {
+    void NavMeshBuilder::buildOpenHeightField(Tile& tile) {
+        const SpanHeightField& heightField = tile.heightField;
+        OpenHeightField& field = tile.openHeightField;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
+        const std::int64_t sizeZ = tile.sizeZ;
         field.resize(sizeX * sizeY);
 
-        debugStep = "Open heightfield generation";
-        // for each column, find spans of open space along Z axis
-        for(std::size_t y = 0; y < sizeY; y++) {
-            for(std::size_t x = 0; x < sizeX; x++) {
-                HeightFieldSpan* span = nullptr;
-                const std::size_t columnIndex = x + y * sizeX;
+        // for each column, the open space starts on top of each walkable solid span, and goes up to the next solid span
+        for(std::int64_t y = 0; y < sizeY; y++) {
+            for(std::int64_t x = 0; x < sizeX; x++) {
+                const std::span<const SpanHeightField::Span> solidSpans = heightField.getSpans(x, y);
+                for(std::size_t i = 0; i < solidSpans.size(); i++) {
+                    if(!solidSpans[i].walkable) {
+                        continue;
+                    }
 
-                bool emptySpace = false;
-                for(std::int64_t z = 0; z < sizeZ; z++) {
-                    if(voxels.contains(x, y, z)) {
-                        const Voxel& voxel = voxels.get(x, y, z);
-                        if(voxel.walkable) {
-                            /*if(emptySpace || span == nullptr)*/ { // new column starting here
-                                span = &field[columnIndex].spans.emplace_back();
-                                span->bottomZ = z;
-                                span->height = 1;
-                                emptySpace = false;
-                            } /*else { // continuing column below this voxel
-                                span->height++;
-                            }*/
-                        } else { // stop this column, if any
-                            span = nullptr;
-                        }
+                    const std::size_t columnIndex = x + y * sizeX;
+                    HeightFieldSpan& span = field[columnIndex].spans.emplace_back();
+                    span.bottomZ = solidSpans[i].maxZ;
+                    if(i + 1 < solidSpans.size()) {
+                        span.height = solidSpans[i + 1].minZ - span.bottomZ;
                     } else {
-                        emptySpace = true;
-                        // empty space, continue the column, if any
-                        if(span != nullptr) {
-                            span->height++;
-                        }
+                        span.height = sizeZ - span.bottomZ; // will reach the ceiling
                     }
                 }
-
-                if(span != nullptr) {
-                    span->height = sizeZ-span->bottomZ; // will reach the ceiling
-                }
             }
         }
 
-        debugStep = "Remove small gaps";
-        for(std::int64_t y = 0; y < sizeY; y++) { // this is stupidly parallel, MAY benefit from //-ization if needed
+        // remove small gaps
+        for(std::int64_t y = 0; y < sizeY; y++) {
             for (std::int64_t x = 0; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
                 if (!field.contains(columnIndex)) { // column full of non walkable space
@@ -494,9 +852,8 @@ namespace Carrot::AI {
             }
         }
 
-        debugStep = "Open heightfield adjacency";
         // connect adjacent spans (based on step height)
-        for(std::int64_t y = 0; y < sizeY; y++) { // this is stupidly parallel, MAY benefit from //-ization if needed
+        for(std::int64_t y = 0; y < sizeY; y++) {
             for(std::int64_t x = 0; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
                 if(!field.contains(columnIndex)) { // column full of non walkable space
@@ -538,10 +895,13 @@ namespace Carrot::AI {
         }
     }
 
-    void NavMeshBuilder::buildDistanceField(OpenHeightField& field) {
-        debugStep = "Build distance field init";
+    void NavMeshBuilder::buildDistanceField(Tile& tile) {
+        OpenHeightField& field = tile.openHeightField;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
+
         // initialize
-        for (std::int64_t y = 0; y < sizeY; y++) { // this is stupidly parallel, MAY benefit from //-ization if needed
+        for (std::int64_t y = 0; y < sizeY; y++) {
             for (std::int64_t x = 0; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
                 if (!field.contains(columnIndex)) { // column full of non walkable space
@@ -567,9 +927,8 @@ namespace Carrot::AI {
             }
         }
 
-        debugStep = "Build distance field pass 1";
         // pass 1
-        for (std::int64_t y = 1; y < sizeY; y++) { // this is stupidly parallel, MAY benefit from //-ization if needed
+        for (std::int64_t y = 1; y < sizeY; y++) {
             for (std::int64_t x = 1; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
                 if (!field.contains(columnIndex)) { // column full of non walkable space
@@ -607,10 +966,9 @@ namespace Carrot::AI {
             }
         }
 
-        debugStep = "Build distance field pass 2";
         // pass 2
-        for (std::int64_t y = sizeY - 1; y >= 0; y--) { // this is stupidly parallel, MAY benefit from //-ization if needed
-            for (std::int64_t x = sizeX - 1; x >= 0; x--) {
+        for (std::int64_t y = sizeY - 2; y >= 0; y--) {
+            for (std::int64_t x = sizeX - 2; x >= 0; x--) {
                 const std::size_t columnIndex = x + y * sizeX;
                 if (!field.contains(columnIndex)) { // column full of non walkable space
                     continue;
@@ -647,9 +1005,8 @@ namespace Carrot::AI {
             }
         }
 
-        debugStep = "Build distance field compute max";
         // compute max
-        workingData.maxDistance = 0;
+        tile.maxDistance = 0;
         for (std::int64_t y = 0; y < sizeY; y++) {
             for (std::int64_t x = 0; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
@@ -659,14 +1016,16 @@ namespace Carrot::AI {
 
                 auto& column = field[columnIndex];
                 for (auto& span: column.spans) {
-                    workingData.maxDistance = std::max(workingData.maxDistance, span.distanceToBorder);
+                    tile.maxDistance = std::max(tile.maxDistance, span.distanceToBorder);
                 }
             }
         }
     }
 
-    void NavMeshBuilder::narrowDistanceField(OpenHeightField& field) {
-        debugStep = "Narrow distance field";
+    void NavMeshBuilder::narrowDistanceField(Tile& tile) {
+        OpenHeightField& field = tile.openHeightField;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
         for (std::int64_t y = 0; y < sizeY; y++) {
             for (std::int64_t x = 0; x < sizeX; x++) {
                 const std::size_t columnIndex = x + y * sizeX;
@@ -687,7 +1046,25 @@ namespace Carrot::AI {
         }
     }
 
-    void NavMeshBuilder::floodFill(OpenHeightField& field, const Region& region) {
+    void NavMeshBuilder::removePadding(Tile& tile) {
+        OpenHeightField& field = tile.openHeightField;
+        for (std::int64_t y = 0; y < tile.sizeY; y++) {
+            for (std::int64_t x = 0; x < tile.sizeX; x++) {
+                const std::size_t columnIndex = x + y * tile.sizeX;
+                if (isInsideTile(tile, x, y) || !field.contains(columnIndex)) {
+                    continue;
+                }
+
+                // keep the column itself: spans next to the padding can still have a connection towards it
+                field[columnIndex].spans.clear();
+            }
+        }
+    }
+
+    void NavMeshBuilder::floodFill(Tile& tile, const Region& region) {
+        OpenHeightField& field = tile.openHeightField;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
         const std::size_t baseColumnIndex = region.center.x + region.center.y * sizeX;
         auto& baseSpan = field.at(baseColumnIndex).spans[region.center.z];
         const std::int64_t distance = baseSpan.distanceToBorder;
@@ -732,14 +1109,18 @@ namespace Carrot::AI {
         }
     }
 
-    void NavMeshBuilder::buildRegions(OpenHeightField& field, std::vector<Region>& regions) {
-        debugStep = "Build regions";
+    void NavMeshBuilder::buildRegions(Tile& tile) {
+        OpenHeightField& field = tile.openHeightField;
+        std::vector<Region>& regions = tile.regions;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
+
         // distance field is considered as an inverted heightmap, and we fill craters with water progressively
         // maybe this is like the watershed algorithm? Don't know, can't access the original paper anyway
 
         using SortedSpans = std::vector<glm::ivec3>; // span coords = { X, Y, Index of span inside column }
         std::vector<SortedSpans> sortedSpans; // sort spans by their distance to the border, one entry per distance value
-        sortedSpans.resize(workingData.maxDistance+1);
+        sortedSpans.resize(tile.maxDistance+1);
 
         for (std::int64_t y = 0; y < sizeY; y++) {
             for (std::int64_t x = 0; x < sizeX; x++) {
@@ -757,7 +1138,7 @@ namespace Carrot::AI {
             }
         }
 
-        for(std::int64_t depth = workingData.maxDistance; depth >= 0; depth--) {
+        for(std::int64_t depth = tile.maxDistance; depth >= 0; depth--) {
             auto& spanCoords = sortedSpans[depth];
 
             // do it twice to handle corners
@@ -824,20 +1205,21 @@ namespace Carrot::AI {
                 newRegion.center = coords;
                 newRegion.index = regions.size() - 1;
 
-                floodFill(field, newRegion);
+                floodFill(tile, newRegion);
             }
         }
     }
 
-    void NavMeshBuilder::buildContours(const OpenHeightField& field, std::vector<Region>& regions) {
-        debugStep = "Build contours";
-        for(auto& r : regions) {
-            buildContour(field, r);
+    void NavMeshBuilder::buildContours(Tile& tile) {
+        for(auto& r : tile.regions) {
+            buildContour(tile, r);
         }
     }
 
-    void NavMeshBuilder::buildContour(const OpenHeightField& field, Region& region) {
-        debugStep = Carrot::sprintf("Build contour %llu", region.index);
+    void NavMeshBuilder::buildContour(const Tile& tile, Region& region) {
+        const OpenHeightField& field = tile.openHeightField;
+        const std::int64_t sizeX = tile.sizeX;
+        const std::int64_t sizeY = tile.sizeY;
 
         // go in a direction until we hit the region's border
         int direction = Right;
@@ -961,13 +1343,13 @@ namespace Carrot::AI {
         }
     }
 
-    void NavMeshBuilder::simplifyContours(const OpenHeightField& field, std::vector<Region>& regions) {
-        for(auto& r : regions) {
-            simplifyContour(field, r);
+    void NavMeshBuilder::simplifyContours(Tile& tile) {
+        for(auto& r : tile.regions) {
+            simplifyContour(tile, r);
         }
     }
 
-    void NavMeshBuilder::simplifyContour(const OpenHeightField& field, Region& region) {
+    void NavMeshBuilder::simplifyContour(const Tile& tile, Region& region) {
         const float maxError = params.voxelSize; // TODO: make it configurable
         std::vector<bool> isMandatory;
         std::vector<glm::vec3> worldPositions;
@@ -976,7 +1358,7 @@ namespace Carrot::AI {
 
         for(std::size_t i = 0; i < region.contour.size(); i++) {
             bool isShared = false;
-            worldPositions[i] = contourToWorldBorderAware(field, region.contour[i], region, isShared);
+            worldPositions[i] = contourToWorldBorderAware(tile, region.contour[i], region, isShared);
             isMandatory[i] = isShared;
         }
 
@@ -1053,7 +1435,7 @@ namespace Carrot::AI {
         return bx*ay - ax*by;
     }
 
-    void NavMeshBuilder::triangulateContour(const OpenHeightField& field, const std::vector<Region>& regions, Region& region) {
+    void NavMeshBuilder::triangulateContour(const Tile& tile, Region& region) {
         const auto& contour = region.contour;
         //const auto& contour = region.simplifiedContour;
         Graph& output = region.triangulatedRegion;
@@ -1064,7 +1446,7 @@ namespace Carrot::AI {
 
         for(std::size_t i = 0; i < contour.size(); i++) {
             bool isShared; // unused
-            output.points.push_back(contourToWorldBorderAware(field, contour[i], region, isShared));
+            output.points.push_back(contourToWorldBorderAware(tile, contour[i], region, isShared));
             contourIndices.emplace_back(i);
         }
 
@@ -1179,19 +1561,16 @@ namespace Carrot::AI {
         finalFace.indexA = contourIndices[0];
         finalFace.indexB = contourIndices[1];
         finalFace.indexC = contourIndices[2];
-
-        region.triangulatedRegionMesh = graphToMesh(output);
     }
 
-    void NavMeshBuilder::buildMesh(const OpenHeightField& field, std::vector<Region>& regions, Graph& rawMesh) {
-        debugStep = "Build mesh";
+    void NavMeshBuilder::buildMesh(Tile& tile) {
+        Graph& rawMesh = tile.rawMesh;
         rawMesh = {};
 
         std::unordered_map<glm::vec3, std::size_t> vertexIndices; // index of vertex position inside rawMesh.vertices
-        for(auto& region : regions) {
-            debugStep = Carrot::sprintf("Build mesh %llu / %llu", region.index, regions.size());
+        for(auto& region : tile.regions) {
             // triangulate region contour
-            triangulateContour(field, regions, region);
+            triangulateContour(tile, region);
 
             // merge shared vertices
             std::unordered_map<std::size_t, std::size_t> remap;
@@ -1215,8 +1594,6 @@ namespace Carrot::AI {
                 newFace.indexC = remap[face.indexC];
             }
         }
-
-        workingData.debugRawMesh = graphToMesh(rawMesh);
     }
 
     void NavMeshBuilder::makeNavMesh(const Graph& rawMesh, NavMesh& navMesh) {
@@ -1251,5 +1628,8 @@ namespace Carrot::AI {
         primitive.name = "tmp navmesh mesh";
 
         navMesh.loadFromScene(tmpScene);
+        if(navMesh.getTriangleCount() >= NavMeshHierarchy::MinTriangleCount) {
+            navMesh.buildHierarchy();
+        }
     }
 } // Carrot::AI
\ No newline at end of file
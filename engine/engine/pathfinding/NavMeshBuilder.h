@@ -4,20 +4,34 @@
 
 #pragma once
 
-#include <engine/pathfinding/SparseVoxelGrid.h>
+#include <engine/pathfinding/SpanHeightField.h>
+#include <core/SparseArray.hpp>
 #include <engine/pathfinding/NavMesh.h>
 #include <engine/render/Model.h>
 #include <core/async/Counter.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/math/AABB.h>
+#include <core/tasks/TaskScheduler.h>
 #include <glm/gtx/hash.hpp>
 
 namespace Carrot::AI {
 
+    /**
+     * Builds a NavMesh from the triangles of models.
+     *
+     * The world is split into square tiles (along X and Y), each tile is voxelised and converted to a mesh on its own,
+     * with a border of padding voxels around it so that the distance field (and therefore the narrowing of walkable areas)
+     * does not depend on the tile boundaries. Tiles are built in parallel, then their meshes are stitched together.
+     * After a first build, only tiles overlapping meshes which were added, removed or moved need to be rebuilt.
+     */
     class NavMeshBuilder {
     public:
         struct MeshEntry {
             std::shared_ptr<Carrot::Model> model;
             glm::mat4 transform { 1.0f };
+
+            /// CPU copy of the geometry to use. If null, the geometry is reloaded from the resource 'model' originates from.
+            /// Allows building without a renderer (tools, benchmarks), in which case 'model' can be null
+            std::shared_ptr<const Render::LoadedScene> scene;
         };
 
         enum class DebugDrawType {
@@ -31,8 +45,38 @@ namespace Carrot::AI {
             Mesh,
         };
 
+        /// Steps of a build, see BuildTimings
+        enum class BuildStage {
+            LoadGeometry,
+            Voxelisation,
+            OpenHeightField,
+            DistanceField,
+            Regions,
+            Contours,
+            Triangulation,
+            Stitching,
+            NavMesh,
+
+            Count,
+        };
+        constexpr static std::size_t BuildStageCount = static_cast<std::size_t>(BuildStage::Count);
+
+        /// Time spent in each stage of the last build.
+        /// Stages done per tile are summed over all rebuilt tiles: as tiles are built in parallel, the sum of all stages
+        /// can be larger than the total duration of the build.
+        struct BuildTimings {
+            std::array<double, BuildStageCount> stageMilliseconds{};
+            double totalMilliseconds = 0.0;
+            std::size_t rebuiltTileCount = 0;
+            std::size_t tileCount = 0;
+        };
+
+        /// Builds on the scheduler of the engine
         NavMeshBuilder() = default;
 
+        /// Builds on the given scheduler, allows building without booting the engine
+        explicit NavMeshBuilder(TaskScheduler& scheduler);
+
     public:
         struct BuildParams {
             float voxelSize = 0.5f;
@@ -41,14 +85,29 @@ namespace Carrot::AI {
             std::size_t characterRadius = 1; //< size of character, in voxels
 
             std::size_t maxClimbHeight = 1; //< Max step size, in voxels
+
+            std::size_t tileSize = 64; //< width of a tile, in voxels (padding excluded)
         };
+
+        /// Builds a navmesh from scratch, in the background
         void start(std::vector<MeshEntry>&& entries, const BuildParams& params);
 
+        /// Builds a navmesh in the background, with the parameters of the previous build. 'entries' is the complete list of
+        /// meshes: only the tiles overlapping entries which were added, removed or moved since the previous build are rebuilt.
+        /// Entries are compared by model, scene and transform: a mesh whose content changed must be given as a new MeshEntry.
+        /// Builds everything if there was no previous build.
+        void startIncrementalRebuild(std::vector<MeshEntry>&& entries);
+
     public:
         bool isRunning() const;
 
         const NavMesh& getResult() const;
 
+        /// Timings of the last finished build
+        const BuildTimings& getLastTimings() const;
+
+        static const char* getStageName(BuildStage stage);
+
         const std::string& getDebugStep() const {
             return debugStep;
         }
@@ -61,6 +120,9 @@ namespace Carrot::AI {
         constexpr static std::uint8_t Left = 2;
         constexpr static std::uint8_t Backwards = 3;
         constexpr static std::uint8_t DirectionCount = 4;
+
+        /// Rows of a tile rasterised by a single task
+        constexpr static std::size_t RasterisationBandRows = 16;
         constexpr static std::int8_t Dx[DirectionCount] {
                 1,0,-1,0
         };
@@ -118,68 +180,130 @@ namespace Carrot::AI {
             std::vector<ContourPoint> simplifiedContour;
 
             Graph triangulatedRegion;
-            std::unique_ptr<Carrot::Mesh> triangulatedRegionMesh;
+            std::unique_ptr<Carrot::Mesh> triangulatedRegionMesh; //< created by debugDraw, when needed
         };
 
         using OpenHeightField = SparseArray<HeightFieldColumn>;
 
+        /// Triangle of a mesh entry, in world space
+        struct InputTriangle {
+            glm::vec3 vertices[3];
+            bool walkable = false;
+        };
+
+        /// Triangles of a MeshEntry, kept between builds so that unchanged entries are not reloaded
+        struct EntryGeometry {
+            MeshEntry entry;
+            std::vector<InputTriangle> triangles;
+            Math::AABB bounds;
+        };
+
+        /// Square part of the world, built independently of other tiles.
+        /// Coordinates of columns and spans inside a tile are relative to the tile origin, which includes the padding
+        struct Tile {
+            glm::ivec2 coords { 0 }; //< position in the tile grid
+
+            // coordinates of the first voxel of the tile, in the voxel grid of the world
+            std::int64_t originX = 0;
+            std::int64_t originY = 0;
+            std::int64_t originZ = 0;
+            std::size_t sizeX = 0; //< padding included
+            std::size_t sizeY = 0; //< padding included
+            std::size_t sizeZ = 0;
+            std::size_t padding = 0; //< voxels around the tile which are only used to compute the distance field
+
+            std::vector<const InputTriangle*> triangles; //< triangles overlapping the tile (padding included), only valid during the build
+
+            SpanHeightField heightField;
+            std::vector<double> bandMilliseconds; //< time spent rasterising each band of rows
+            OpenHeightField openHeightField;
+            std::int64_t maxDistance = 1;
+            std::vector<Region> regions;
+
+            Graph rawMesh; //< in world space
+
+            std::array<double, BuildStageCount> stageMilliseconds{};
+        };
+
+        void scheduleBuild();
         void build(Carrot::TaskHandle&);
 
+        /// Matches 'entries' against the geometry of the previous build, and loads the geometry of new entries.
+        /// Fills 'changedAreas' with the bounds of entries which were added or removed
+        void loadGeometry(std::vector<Math::AABB>& changedAreas);
+
+        /// Range of tiles which can be affected by something inside the given bounds
+        void getTileRange(const Math::AABB& bounds, glm::ivec2& minTile, glm::ivec2& maxTile) const;
+
+        void buildTile(Tile& tile);
+
+        /// Merges the meshes of all tiles, welding vertices on the borders between tiles
+        void stitchTiles(Graph& rawMesh);
+
         bool doSpansConnect(const HeightFieldSpan& spanA, const HeightFieldSpan& spanB);
-        bool doContourPointsConnect(const OpenHeightField& field, const ContourPoint& pointA, const ContourPoint& pointB);
+        bool doContourPointsConnect(const Tile& tile, const ContourPoint& pointA, const ContourPoint& pointB);
 
         /// Converts a contour point to world space
-        glm::vec3 contourToWorld(const OpenHeightField& field, const ContourPoint& point);
+        glm::vec3 contourToWorld(const Tile& tile, const ContourPoint& point);
 
         /// Like contourToWorld, but lerps Z with neighbor if there is one (to handle contour points with different height)
-        glm::vec3 contourToWorldBorderAware(const OpenHeightField& field, const ContourPoint& point, const Region& originalRegion, bool& isShared);
+        glm::vec3 contourToWorldBorderAware(const Tile& tile, const ContourPoint& point, const Region& originalRegion, bool& isShared);
+
+        /// Center of the given voxel of the tile, in world space
+        glm::vec3 voxelToWorld(const Tile& tile, std::int64_t x, std::int64_t y, std::int64_t z) const;
+
+        /// Is the given column part of the tile itself, and not its padding?
+        bool isInsideTile(const Tile& tile, std::int64_t x, std::int64_t y) const;
 
-        void buildOpenHeightField(const SparseVoxelGrid& voxels, OpenHeightField& field);
-        void buildDistanceField(OpenHeightField& field);
-        void narrowDistanceField(OpenHeightField& field);
+        /// Computes the vertical extent of the tile and allocates its heightfield
+        void prepareHeightField(Tile& tile);
+
+        /// Rasterises the triangles of the tile into its heightfield, only for rows in [firstRow, endRow)
+        void voxelise(Tile& tile, std::size_t firstRow, std::size_t endRow);
+        void buildOpenHeightField(Tile& tile);
+        void buildDistanceField(Tile& tile);
+        void narrowDistanceField(Tile& tile);
+
+        /// Removes spans in the padding of the tile, once they are no longer needed by the distance field
+        void removePadding(Tile& tile);
 
         /**
          * Flood-fills the field with the given region (base), filling connected spans that have the same distance to the border
-         * @param field
+         * @param tile
          * @param base
          */
-        void floodFill(OpenHeightField& field, const Region& base);
-        void buildRegions(OpenHeightField& field, std::vector<Region>& regions);
+        void floodFill(Tile& tile, const Region& base);
+        void buildRegions(Tile& tile);
 
-        void buildContours(const OpenHeightField& field, std::vector<Region>& regions);
-        void buildContour(const OpenHeightField& field, Region& region);
+        void buildContours(Tile& tile);
+        void buildContour(const Tile& tile, Region& region);
 
-        void simplifyContours(const OpenHeightField& field, std::vector<Region>& regions);
-        void simplifyContour(const OpenHeightField& field, Region& region);
+        void simplifyContours(Tile& tile);
+        void simplifyContour(const Tile& tile, Region& region);
 
         std::unique_ptr<Carrot::Mesh> graphToMesh(const Graph& graph);
-        void triangulateContour(const OpenHeightField& field, const std::vector<Region>& regions, Region& region);
-        void buildMesh(const OpenHeightField& field, std::vector<Region>& region, Graph& rawMesh);
+        void triangulateContour(const Tile& tile, Region& region);
+        void buildMesh(Tile& tile);
         void makeNavMesh(const Graph& rawMesh, NavMesh& navMesh);
 
     private:
+        TaskScheduler* pScheduler = nullptr; //< GetTaskScheduler() if null
         Carrot::Async::Counter taskRunning;
         NavMesh navMesh;
 
         std::vector<MeshEntry> entries;
-        glm::vec3 minVoxelPosition {0.0f};
+        bool fullRebuild = true; //< does the current build need to rebuild all tiles?
         BuildParams params;
-        glm::vec3 size{0.0f};
-        std::size_t sizeX = 0;
-        std::size_t sizeY = 0;
-        std::size_t sizeZ = 0;
 
         struct WorkingData {
-            SparseVoxelGrid voxelizedScene;
-            SparseVoxelGrid walkableVoxels;
-            OpenHeightField openHeightField;
-            std::int64_t maxDistance = 1;
-            std::vector<Region> regions;
+            std::vector<EntryGeometry> geometry;
+            std::unordered_map<glm::ivec2, std::unique_ptr<Tile>> tiles;
 
             Graph rawMesh;
-            std::unique_ptr<Carrot::Mesh> debugRawMesh;
+            std::unique_ptr<Carrot::Mesh> debugRawMesh; //< created by debugDraw, when needed
         };
         WorkingData workingData;
+        BuildTimings lastTimings;
 
         std::string debugStep = "Idle";
     };
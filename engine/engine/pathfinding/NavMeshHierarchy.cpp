@@ -0,0 +1,398 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "NavMeshHierarchy.h"
+#include <core/Macros.h>
+#include <core/io/Logging.hpp>
+#include <core/tasks/Tasks.h>
+#include <core/utils/Assert.h>
+#include <core/utils/Profiling.h>
+
+#define IDXTYPEWIDTH 64
+#define REALTYPEWIDTH 64
+#include <metis.h>
+
+namespace Carrot::AI {
+    void NavMeshHierarchy::build(const AStarImpl& triangleGraph, std::span<const glm::vec3> centers, std::size_t trianglesPerCluster) {
+        ZoneScoped;
+        clear();
+        const std::size_t triangleCount = triangleGraph.getVertexCount();
+        verify(centers.size() == triangleCount, "There must be a center per triangle");
+        verify(trianglesPerCluster > 0, "Clusters cannot be empty");
+        const std::size_t partCount = (triangleCount + trianglesPerCluster - 1) / trianglesPerCluster;
+        if(partCount < 2) {
+            return; // a single cluster would not help
+        }
+
+        // METIS expects an undirected graph, without self loops nor duplicated edges
+        std::vector<std::pair<idx_t, idx_t>> undirectedEdges;
+        undirectedEdges.reserve(triangleGraph.getEdgeCount() * 2);
+        for(std::size_t triangle = 0; triangle < triangleCount; triangle++) {
+            for(const std::uint32_t neighbor : triangleGraph.getNeighbors(triangle)) {
+                if(neighbor != triangle) {
+                    undirectedEdges.emplace_back(triangle, neighbor);
+                    undirectedEdges.emplace_back(neighbor, triangle);
+                }
+            }
+        }
+        std::ranges::sort(undirectedEdges);
+        undirectedEdges.erase(std::unique(WHOLE_CONTAINER(undirectedEdges)), undirectedEdges.end());
+
+        std::vector<idx_t> xadj(triangleCount + 1, 0);
+        std::vector<idx_t> adjncy;
+        adjncy.reserve(undirectedEdges.size());
+        for(const auto& [from, to] : undirectedEdges) {
+            xadj[from + 1]++;
+            adjncy.push_back(to);
+        }
+        for(std::size_t triangle = 0; triangle < triangleCount; triangle++) {
+            xadj[triangle + 1] += xadj[triangle];
+        }
+
+        std::vector<idx_t> partition(triangleCount);
+        {
+            ZoneScopedN("METIS");
+            idx_t vertexCount = static_cast<idx_t>(triangleCount);
+            idx_t constraintCount = 1;
+            idx_t parts = static_cast<idx_t>(partCount);
+            idx_t edgeCut = 0;
+            idx_t options[METIS_NOPTIONS];
+            METIS_SetDefaultOptions(options);
+            options[METIS_OPTION_NUMBERING] = 0;
+            const int result = METIS_PartGraphKway(&vertexCount, &constraintCount, xadj.data(), adjncy.data(),
+                                                   nullptr, nullptr, nullptr, &parts, nullptr, nullptr, options,
+                                                   &edgeCut, partition.data());
+            if(result != METIS_OK) {
+                Carrot::Log::warn("[NavMesh] Could not partition navmesh (METIS error %d), paths will be searched without hierarchy", result);
+                return;
+            }
+        }
+
+        // METIS does not guarantee that parts are connected: each connected component of a part becomes its own cluster,
+        // so that all triangles of a cluster can be reached without leaving it
+        constexpr std::uint32_t NoCluster = ~0u;
+        clusterOfTriangle.assign(triangleCount, NoCluster);
+        std::uint32_t clusterCount = 0;
+        std::vector<std::uint32_t> toVisit;
+        for(std::size_t seed = 0; seed < triangleCount; seed++) {
+            if(clusterOfTriangle[seed] != NoCluster) {
+                continue;
+            }
+            const std::uint32_t cluster = clusterCount++;
+            clusterOfTriangle[seed] = cluster;
+            toVisit.push_back(static_cast<std::uint32_t>(seed));
+            while(!toVisit.empty()) {
+                const std::uint32_t triangle = toVisit.back();
+                toVisit.pop_back();
+                for(idx_t i = xadj[triangle]; i < xadj[triangle + 1]; i++) {
+                    const idx_t neighbor = adjncy[i];
+                    if(clusterOfTriangle[neighbor] == NoCluster && partition[neighbor] == partition[seed]) {
+                        clusterOfTriangle[neighbor] = cluster;
+                        toVisit.push_back(static_cast<std::uint32_t>(neighbor));
+                    }
+                }
+            }
+        }
+
+        computeClusterContents(triangleGraph);
+        triangleCenters.assign(WHOLE_CONTAINER(centers));
+
+        // costs between all portals of each cluster
+        intraClusterCosts.resize(intraCostOffsets.back());
+        auto computeIntraClusterCosts = [&](std::size_t clusterIndex) {
+            static thread_local std::vector<float> costs;
+            const std::uint32_t cluster = static_cast<std::uint32_t>(clusterIndex);
+            std::span<const std::uint32_t> portals = getPortals(cluster);
+            float* matrix = intraClusterCosts.data() + intraCostOffsets[cluster];
+            for(std::size_t i = 0; i < portals.size(); i++) {
+                computeCostsInCluster(triangleGraph, cluster, portals[i], costs);
+                for(std::size_t j = 0; j < portals.size(); j++) {
+                    matrix[i * portals.size() + j] = costs[localIndices[portals[j]]];
+                }
+            }
+        };
+        {
+            ZoneScopedN("Intra-cluster costs");
+            if(clusterCount > 1 && Async::parallelFor != nullptr) {
+                Async::parallelFor(clusterCount, computeIntraClusterCosts, 1);
+            } else {
+                for(std::size_t cluster = 0; cluster < clusterCount; cluster++) {
+                    computeIntraClusterCosts(cluster);
+                }
+            }
+        }
+    }
+
+    void NavMeshHierarchy::computeClusterContents(const AStarImpl& triangleGraph) {
+        const std::size_t triangleCount = clusterOfTriangle.size();
+        const std::size_t clusterCount = triangleCount == 0 ? 0 : *std::ranges::max_element(clusterOfTriangle) + 1;
+
+        // counting sort of triangles by cluster
+        clusterTriangleOffsets.assign(clusterCount + 1, 0);
+        for(const std::uint32_t cluster : clusterOfTriangle) {
+            clusterTriangleOffsets[cluster + 1]++;
+        }
+        for(std::size_t cluster = 0; cluster < clusterCount; cluster++) {
+            clusterTriangleOffsets[cluster + 1] += clusterTriangleOffsets[cluster];
+        }
+        clusterTriangles.resize(triangleCount);
+        localIndices.resize(triangleCount);
+        std::vector<std::uint32_t> insertionPoints { clusterTriangleOffsets.begin(), clusterTriangleOffsets.end() - 1 };
+        for(std::size_t triangle = 0; triangle < triangleCount; triangle++) {
+            const std::uint32_t cluster = clusterOfTriangle[triangle];
+            localIndices[triangle] = insertionPoints[cluster] - clusterTriangleOffsets[cluster];
+            clusterTriangles[insertionPoints[cluster]++] = static_cast<std::uint32_t>(triangle);
+        }
+
+        // portals: triangles with a neighbor in another cluster
+        portalTriangles.clear();
+        portalOfTriangle.assign(triangleCount, NoPortal);
+        clusterPortalOffsets.assign(clusterCount + 1, 0);
+        intraCostOffsets.assign(clusterCount + 1, 0);
+        for(std::uint32_t cluster = 0; cluster < clusterCount; cluster++) {
+            clusterPortalOffsets[cluster] = static_cast<std::uint32_t>(portalTriangles.size());
+            for(std::uint32_t i = clusterTriangleOffsets[cluster]; i < clusterTriangleOffsets[cluster + 1]; i++) {
+                const std::uint32_t triangle = clusterTriangles[i];
+                const bool isPortal = std::ranges::any_of(triangleGraph.getNeighbors(triangle), [&](std::uint32_t neighbor) {
+                    return clusterOfTriangle[neighbor] != cluster;
+                });
+                if(isPortal) {
+                    portalOfTriangle[triangle] = static_cast<std::uint32_t>(portalTriangles.size());
+                    portalTriangles.push_back(triangle);
+                }
+            }
+            const std::uint32_t portalCount = static_cast<std::uint32_t>(portalTriangles.size()) - clusterPortalOffsets[cluster];
+            intraCostOffsets[cluster + 1] = intraCostOffsets[cluster] + portalCount * portalCount;
+        }
+        clusterPortalOffsets[clusterCount] = static_cast<std::uint32_t>(portalTriangles.size());
+
+        interEdgeOffsets.assign(portalTriangles.size() + 1, 0);
+        interEdgeTargets.clear();
+        for(std::size_t portal = 0; portal < portalTriangles.size(); portal++) {
+            const std::uint32_t triangle = portalTriangles[portal];
+            for(const std::uint32_t neighbor : triangleGraph.getNeighbors(triangle)) {
+                // neighbor is not a portal if the edge back to 'triangle' does not exist
+                if(clusterOfTriangle[neighbor] != clusterOfTriangle[triangle] && portalOfTriangle[neighbor] != NoPortal) {
+                    interEdgeTargets.push_back(portalOfTriangle[neighbor]);
+                }
+            }
+            interEdgeOffsets[portal + 1] = static_cast<std::uint32_t>(interEdgeTargets.size());
+        }
+    }
+
+    void NavMeshHierarchy::computeCostsInCluster(const AStarImpl& triangleGraph, std::uint32_t cluster, std::size_t sourceTriangle, std::vector<float>& costs) const {
+        // Dijkstra, restricted to the triangles of the cluster
+        using HeapEntry = std::pair<float, std::uint32_t>;
+        static thread_local std::vector<HeapEntry> heap;
+        heap.clear();
+        costs.assign(clusterTriangleOffsets[cluster + 1] - clusterTriangleOffsets[cluster], INFINITY);
+
+        costs[localIndices[sourceTriangle]] = 0.0f;
+        heap.emplace_back(0.0f, static_cast<std::uint32_t>(sourceTriangle));
+        while(!heap.empty()) {
+            std::ranges::pop_heap(heap, std::greater{});
+            const auto [cost, triangle] = heap.back();
+            heap.pop_back();
+            if(cost > costs[localIndices[triangle]]) {
+                continue; // already reached with a lower cost
+            }
+
+            for(const std::uint32_t neighbor : triangleGraph.getNeighbors(triangle)) {
+                if(clusterOfTriangle[neighbor] != cluster) {
+                    continue;
+                }
+                const float neighborCost = cost + getCost(triangle, neighbor);
+                float& bestCost = costs[localIndices[neighbor]];
+                if(neighborCost < bestCost) {
+                    bestCost = neighborCost;
+                    heap.emplace_back(neighborCost, neighbor);
+                    std::ranges::push_heap(heap, std::greater{});
+                }
+            }
+        }
+    }
+
+    bool NavMeshHierarchy::findCorridor(const AStarImpl& triangleGraph, std::size_t startTriangle, std::size_t goalTriangle,
+                                        SearchContext& context, std::vector<std::size_t>& corridor) const {
+        const std::uint32_t startCluster = clusterOfTriangle[startTriangle];
+        const std::uint32_t goalCluster = clusterOfTriangle[goalTriangle];
+        verify(startCluster != goalCluster, "Start and goal are in the same cluster, search the triangles directly");
+
+        // costs from start to the portals of its cluster, and from the portals of the goal cluster to the goal
+        // (the navmesh graph is symmetric: costs from the goal are the same as costs to the goal)
+        static thread_local std::vector<float> startCosts;
+        static thread_local std::vector<float> goalCosts;
+        computeCostsInCluster(triangleGraph, startCluster, startTriangle, startCosts);
+        computeCostsInCluster(triangleGraph, goalCluster, goalTriangle, goalCosts);
+
+        // 1. plan over portals, with start and goal as two extra vertices
+        const std::uint32_t startNode = static_cast<std::uint32_t>(portalTriangles.size());
+        const std::uint32_t goalNode = startNode + 1;
+        auto getNodeTriangle = [&](std::size_t node) -> std::size_t {
+            if(node == startNode) {
+                return startTriangle;
+            }
+            if(node == goalNode) {
+                return goalTriangle;
+            }
+            return portalTriangles[node];
+        };
+
+        auto forEachNeighbor = [&](std::uint32_t node, const auto& visit) {
+            if(node == goalNode) {
+                return;
+            }
+            if(node == startNode) {
+                const std::uint32_t firstPortal = clusterPortalOffsets[startCluster];
+                std::span<const std::uint32_t> portals = getPortals(startCluster);
+                for(std::uint32_t i = 0; i < portals.size(); i++) {
+                    const float cost = startCosts[localIndices[portals[i]]];
+                    if(cost < INFINITY) {
+                        visit(firstPortal + i, cost);
+                    }
+                }
+                return;
+            }
+
+            const std::uint32_t triangle = portalTriangles[node];
+            const std::uint32_t cluster = clusterOfTriangle[triangle];
+            for(std::uint32_t i = interEdgeOffsets[node]; i < interEdgeOffsets[node + 1]; i++) {
+                const std::uint32_t target = interEdgeTargets[i];
+                visit(target, getCost(triangle, portalTriangles[target]));
+            }
+
+            const std::uint32_t firstPortal = clusterPortalOffsets[cluster];
+            const std::size_t portalCount = clusterPortalOffsets[cluster + 1] - firstPortal;
+            const std::size_t localPortal = node - firstPortal;
+            const float* costs = intraClusterCosts.data() + intraCostOffsets[cluster] + localPortal * portalCount;
+            for(std::uint32_t i = 0; i < portalCount; i++) {
+                if(i != localPortal && costs[i] < INFINITY) {
+                    visit(firstPortal + i, costs[i]);
+                }
+            }
+
+            if(cluster == goalCluster) {
+                const float cost = goalCosts[localIndices[triangle]];
+                if(cost < INFINITY) {
+                    visit(goalNode, cost);
+                }
+            }
+        };
+
+        const glm::vec3 goalCenter = triangleCenters[goalTriangle];
+        auto estimation = [&](std::size_t node) {
+            return glm::distance(triangleCenters[getNodeTriangle(node)], goalCenter);
+        };
+        if(!AStarImpl::findPathInGraph(context, portalTriangles.size() + 2, startNode, goalNode, forEachNeighbor, estimation)) {
+            return false;
+        }
+
+        // 2. refine: consecutive portals are either neighbors, or inside the same cluster
+        static thread_local std::vector<std::size_t> abstractPath;
+        abstractPath.assign(context.getPath().begin(), context.getPath().end());
+
+        corridor.clear();
+        corridor.push_back(startTriangle);
+        std::size_t previousTriangle = startTriangle;
+        for(std::size_t i = 1; i < abstractPath.size(); i++) {
+            const std::size_t triangle = getNodeTriangle(abstractPath[i]);
+            if(triangle == previousTriangle) {
+                continue; // start or goal is a portal
+            }
+
+            const std::uint32_t cluster = clusterOfTriangle[triangle];
+            if(cluster != clusterOfTriangle[previousTriangle]) {
+                corridor.push_back(triangle);
+            } else {
+                const glm::vec3 target = triangleCenters[triangle];
+                const bool found = AStarImpl::findPathInGraph(context, triangleCenters.size(), previousTriangle, triangle, [&](std::uint32_t current, const auto& visit) {
+                    for(const std::uint32_t neighbor : triangleGraph.getNeighbors(current)) {
+                        if(clusterOfTriangle[neighbor] == cluster) {
+                            visit(neighbor, getCost(current, neighbor));
+                        }
+                    }
+                }, [&](std::size_t v) {
+                    return glm::distance(triangleCenters[v], target);
+                });
+                verify(found, "Portals of the same cluster should be connected if they have a finite cost");
+                corridor.insert(corridor.end(), context.getPath().begin() + 1, context.getPath().end());
+            }
+            previousTriangle = triangle;
+        }
+        return true;
+    }
+
+    float NavMeshHierarchy::getCost(std::size_t triangleA, std::size_t triangleB) const {
+        return glm::distance(triangleCenters[triangleA], triangleCenters[triangleB]);
+    }
+
+    std::span<const std::uint32_t> NavMeshHierarchy::getPortals(std::uint32_t cluster) const {
+        return std::span { portalTriangles.data() + clusterPortalOffsets[cluster], portalTriangles.data() + clusterPortalOffsets[cluster + 1] };
+    }
+
+    void NavMeshHierarchy::clear() {
+        clusterOfTriangle.clear();
+        intraClusterCosts.clear();
+        triangleCenters.clear();
+        clusterTriangleOffsets.clear();
+        clusterTriangles.clear();
+        localIndices.clear();
+        portalTriangles.clear();
+        clusterPortalOffsets.clear();
+        portalOfTriangle.clear();
+        intraCostOffsets.clear();
+        interEdgeOffsets.clear();
+        interEdgeTargets.clear();
+    }
+
+    bool NavMeshHierarchy::empty() const {
+        return clusterOfTriangle.empty();
+    }
+
+    std::size_t NavMeshHierarchy::getClusterCount() const {
+        return clusterTriangleOffsets.empty() ? 0 : clusterTriangleOffsets.size() - 1;
+    }
+
+    std::uint32_t NavMeshHierarchy::getCluster(std::size_t triangle) const {
+        return clusterOfTriangle[triangle];
+    }
+
+    void NavMeshHierarchy::serialize(IO::VectorWriter& writer) const {
+        writer << clusterOfTriangle;
+        writer << intraClusterCosts;
+    }
+
+    void NavMeshHierarchy::deserialize(IO::VectorReader& reader, const AStarImpl& triangleGraph, std::span<const glm::vec3> centers) {
+        std::vector<std::uint32_t> readClusters;
+        std::vector<float> readCosts;
+        reader >> readClusters;
+        reader >> readCosts;
+        load(readClusters, readCosts, triangleGraph, centers);
+    }
+
+    std::span<const std::uint32_t> NavMeshHierarchy::getClusterOfTriangles() const {
+        return clusterOfTriangle;
+    }
+
+    std::span<const float> NavMeshHierarchy::getIntraClusterCosts() const {
+        return intraClusterCosts;
+    }
+
+    void NavMeshHierarchy::load(std::span<const std::uint32_t> clusters, std::span<const float> costs,
+                                const AStarImpl& triangleGraph, std::span<const glm::vec3> centers) {
+        clear();
+        if(clusters.empty()) {
+            return;
+        }
+        clusterOfTriangle.assign(WHOLE_CONTAINER(clusters));
+        intraClusterCosts.assign(WHOLE_CONTAINER(costs));
+
+        verify(clusterOfTriangle.size() == triangleGraph.getVertexCount(), "Hierarchy does not match the triangles of the navmesh");
+        verify(centers.size() == triangleGraph.getVertexCount(), "There must be a center per triangle");
+        computeClusterContents(triangleGraph);
+        verify(intraClusterCosts.size() == intraCostOffsets.back(), "Hierarchy does not match the triangles of the navmesh");
+        triangleCenters.assign(WHOLE_CONTAINER(centers));
+    }
+
+} // Carrot::AI
@@ -0,0 +1,101 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <engine/pathfinding/AStar.h>
+#include <core/io/Serialisation.h>
+
+namespace Carrot::AI {
+
+    /**
+     * Abstraction layer over the triangles of a NavMesh, to speed up long distance path queries.
+     *
+     * Triangles are partitioned into clusters of connected triangles (with METIS). Triangles at the border of a cluster
+     * are portals: the abstract graph links each portal to the portals of neighboring clusters, and to all portals of its
+     * own cluster with the precomputed cost of the shortest path inside the cluster.
+     * Queries are first planned over portals, then refined cluster by cluster, with searches which never leave the cluster.
+     *
+     * Costs are distances between triangle centers, like the ones used by NavMesh for its flat searches: corridors have the
+     * same cost as flat A*, only far fewer triangles are expanded.
+     */
+    class NavMeshHierarchy {
+    public:
+        constexpr static std::size_t DefaultTrianglesPerCluster = 128;
+
+        /// Below this amount of triangles, searching over all triangles is fast enough that a hierarchy is not worth it
+        constexpr static std::size_t MinTriangleCount = 2048;
+
+        /// Partitions the triangles of 'triangleGraph' into clusters, and precomputes the costs between portals
+        void build(const AStarImpl& triangleGraph, std::span<const glm::vec3> triangleCenters, std::size_t trianglesPerCluster = DefaultTrianglesPerCluster);
+
+        /// Removes the hierarchy. Queries must then be done on the triangle graph directly
+        void clear();
+
+        bool empty() const;
+
+        std::size_t getClusterCount() const;
+
+        /// Cluster of the given triangle. Hierarchy must not be empty
+        std::uint32_t getCluster(std::size_t triangle) const;
+
+        /// Finds the triangles to go through from 'startTriangle' to 'goalTriangle', which must be in different clusters.
+        /// \param triangleGraph graph given to build (or deserialize)
+        /// \param corridor overwritten with the triangles to go through (start and goal included)
+        /// \return false if there is no path
+        bool findCorridor(const AStarImpl& triangleGraph, std::size_t startTriangle, std::size_t goalTriangle,
+                          SearchContext& context, std::vector<std::size_t>& corridor) const;
+
+        /// Writes the partition and the costs between portals. Other data is recomputed when reading
+        void serialize(IO::VectorWriter& writer) const;
+
+        /// Reads a hierarchy written by serialize, for the given graph
+        void deserialize(IO::VectorReader& reader, const AStarImpl& triangleGraph, std::span<const glm::vec3> triangleCenters);
+
+        /// Cluster of each triangle, empty if there is no hierarchy. Together with getIntraClusterCosts, enough to recreate the hierarchy via load
+        std::span<const std::uint32_t> getClusterOfTriangles() const;
+
+        /// For each cluster, matrix of costs between its portals
+        std::span<const float> getIntraClusterCosts() const;
+
+        /// Same as deserialize, with the arrays given by getClusterOfTriangles and getIntraClusterCosts
+        void load(std::span<const std::uint32_t> clusterOfTriangle, std::span<const float> intraClusterCosts,
+                  const AStarImpl& triangleGraph, std::span<const glm::vec3> triangleCenters);
+
+    private:
+        constexpr static std::uint32_t NoPortal = ~0u;
+
+        /// Computes everything but 'clusterOfTriangle' and 'intraClusterCosts', from 'clusterOfTriangle'
+        void computeClusterContents(const AStarImpl& triangleGraph);
+
+        /// Cost of the shortest path from 'sourceTriangle' to each triangle of 'cluster', without leaving the cluster.
+        /// Costs are indexed by triangle index inside the cluster (see 'localIndices')
+        void computeCostsInCluster(const AStarImpl& triangleGraph, std::uint32_t cluster, std::size_t sourceTriangle, std::vector<float>& costs) const;
+
+        /// Cost between two triangles (adjacent or not)
+        float getCost(std::size_t triangleA, std::size_t triangleB) const;
+
+        std::span<const std::uint32_t> getPortals(std::uint32_t cluster) const;
+
+        // serialized
+        std::vector<std::uint32_t> clusterOfTriangle;
+        std::vector<float> intraClusterCosts; //< for each cluster, matrix of costs between its portals (INFINITY if unreachable)
+
+        // computed after building or reading
+        std::vector<glm::vec3> triangleCenters;
+        std::vector<std::uint32_t> clusterTriangleOffsets; //< triangles of cluster c are clusterTriangles[clusterTriangleOffsets[c]] to clusterTriangles[clusterTriangleOffsets[c+1]] (excluded)
+        std::vector<std::uint32_t> clusterTriangles;
+        std::vector<std::uint32_t> localIndices; //< index of each triangle inside the triangles of its cluster
+
+        std::vector<std::uint32_t> portalTriangles; //< abstract graph vertices, grouped by cluster
+        std::vector<std::uint32_t> clusterPortalOffsets; //< portals of cluster c are portalTriangles[clusterPortalOffsets[c]] to portalTriangles[clusterPortalOffsets[c+1]] (excluded)
+        std::vector<std::uint32_t> portalOfTriangle; //< NoPortal if the triangle is not a portal
+        std::vector<std::uint32_t> intraCostOffsets; //< where the matrix of each cluster starts inside 'intraClusterCosts'
+
+        // portals of other clusters which are adjacent to each portal
+        std::vector<std::uint32_t> interEdgeOffsets;
+        std::vector<std::uint32_t> interEdgeTargets;
+    };
+
+} // Carrot::AI
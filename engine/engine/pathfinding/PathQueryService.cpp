@@ -0,0 +1,225 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "PathQueryService.h"
+#include <core/tasks/TaskScheduler.h>
+#include <core/utils/Assert.h>
+#include <core/utils/Profiling.h>
+
+namespace Carrot::AI {
+    /// Triangle index of positions which could not be snapped to the navmesh (empty navmesh)
+    static constexpr std::size_t NoTriangle = ~0ull;
+
+    bool PathQuery::isReady() const {
+        return ready.load(std::memory_order_acquire);
+    }
+
+    const NavPath& PathQuery::getPath() const {
+        verify(isReady(), "Path is not computed yet");
+        return path;
+    }
+
+    const glm::vec3& PathQuery::getStart() const {
+        return start;
+    }
+
+    const glm::vec3& PathQuery::getGoal() const {
+        return goal;
+    }
+
+    PathQueryService::PathQueryService(const NavMesh& navMesh, TaskScheduler& scheduler, std::size_t corridorCacheCapacity)
+        : navMesh(navMesh)
+        , scheduler(scheduler)
+        , cacheCapacity(corridorCacheCapacity)
+        , cachedObstacleVersion(navMesh.getObstacleVersion())
+    {}
+
+    std::shared_ptr<const PathQuery> PathQueryService::requestPath(const glm::vec3& start, const glm::vec3& goal) {
+        auto query = std::make_shared<PathQuery>();
+        query->start = start;
+        query->goal = goal;
+
+        std::lock_guard l { pendingMutex };
+        pending.push_back(query);
+        return query;
+    }
+
+    void PathQueryService::update(const std::chrono::duration<float>& timeBudget) {
+        ZoneScoped;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeBudget);
+        lastStats = {};
+
+        std::vector<std::shared_ptr<PathQuery>> queries;
+        {
+            std::lock_guard l { pendingMutex };
+            queries.swap(pending);
+        }
+
+        // if the service holds the only reference, nobody is waiting for the result anymore
+        lastStats.cancelledQueries = std::erase_if(queries, [](const std::shared_ptr<PathQuery>& query) {
+            return query.use_count() == 1;
+        });
+        if(queries.empty()) {
+            return;
+        }
+
+        // obstacles changed since the last update: deferred queries may have been snapped to triangles which are now blocked
+        if(cachedObstacleVersion != navMesh.getObstacleVersion()) {
+            evictInvalidatedCorridors();
+            for(const auto& pQuery : queries) {
+                pQuery->snapped = false;
+            }
+        }
+
+        {
+            ZoneScopedN("Snap to navmesh");
+            scheduler.parallelFor(queries.size(), [&](std::size_t i) {
+                PathQuery& query = *queries[i];
+                if(!query.snapped) {
+                    query.startPosition = navMesh.getClosestPosition(query.start);
+                    query.goalPosition = navMesh.getClosestPosition(query.goal);
+                    query.snapped = true;
+                }
+            }, 64);
+        }
+
+        // groups are created in the order of queries, so older queries are processed first
+        std::vector<QueryGroup> groups;
+        {
+            ZoneScopedN("Group queries");
+            std::unordered_map<TrianglePairKey, std::size_t> groupIndices;
+            for(const auto& pQuery : queries) {
+                const TrianglePairKey key = (static_cast<TrianglePairKey>(pQuery->startPosition.triangleIndex) << 32)
+                                            | static_cast<std::uint32_t>(pQuery->goalPosition.triangleIndex);
+                auto [it, inserted] = groupIndices.try_emplace(key, groups.size());
+                if(inserted) {
+                    QueryGroup& group = groups.emplace_back();
+                    group.key = key;
+                    group.cachedCorridor = findInCache(key);
+                }
+                groups[it->second].queries.push_back(pQuery.get());
+            }
+        }
+
+        {
+            ZoneScopedN("Compute paths");
+            scheduler.parallelFor(groups.size(), [&](std::size_t groupIndex) {
+                if(groupIndex > 0 && std::chrono::steady_clock::now() >= deadline) {
+                    return; // deferred to the next update
+                }
+                processGroup(groups[groupIndex]);
+            }, 1);
+        }
+
+        for(QueryGroup& group : groups) {
+            if(!group.processed) {
+                lastStats.deferredQueries += group.queries.size();
+                continue;
+            }
+            lastStats.completedQueries += group.queries.size();
+            if(group.cachedCorridor != nullptr) {
+                lastStats.cacheHits++;
+            } else if(group.searched) {
+                lastStats.searches++;
+                addToCache(group.key, std::move(group.corridor));
+            }
+        }
+
+        if(lastStats.deferredQueries > 0) {
+            std::vector<std::shared_ptr<PathQuery>> deferred;
+            deferred.reserve(lastStats.deferredQueries);
+            for(auto& pQuery : queries) {
+                if(!pQuery->isReady()) {
+                    deferred.push_back(std::move(pQuery));
+                }
+            }
+
+            // deferred queries go before the ones requested during this update
+            std::lock_guard l { pendingMutex };
+            pending.insert(pending.begin(), std::make_move_iterator(deferred.begin()), std::make_move_iterator(deferred.end()));
+        }
+    }
+
+    void PathQueryService::processGroup(QueryGroup& group) const {
+        const std::size_t startTriangle = group.queries[0]->startPosition.triangleIndex;
+        const std::size_t goalTriangle = group.queries[0]->goalPosition.triangleIndex;
+
+        std::span<const std::size_t> corridor;
+        if(startTriangle == NoTriangle || goalTriangle == NoTriangle) {
+            // empty navmesh (or fully blocked by obstacles), no path
+        } else if(startTriangle == goalTriangle) {
+            group.corridor.push_back(startTriangle);
+            corridor = group.corridor;
+        } else if(group.cachedCorridor != nullptr) {
+            corridor = *group.cachedCorridor;
+        } else {
+            static thread_local SearchContext context;
+            if(!navMesh.findCorridor(startTriangle, goalTriangle, context, group.corridor)) {
+                group.corridor.clear();
+            }
+            corridor = group.corridor;
+            group.searched = true;
+        }
+
+        for(PathQuery* pQuery : group.queries) {
+            if(!corridor.empty()) {
+                pQuery->path = navMesh.computePathInCorridor(pQuery->start, pQuery->startPosition, pQuery->goal, pQuery->goalPosition, corridor);
+            }
+            pQuery->ready.store(true, std::memory_order_release);
+        }
+        group.processed = true;
+    }
+
+    const std::vector<std::size_t>* PathQueryService::findInCache(TrianglePairKey key) {
+        auto it = cacheLookup.find(key);
+        if(it == cacheLookup.end()) {
+            return nullptr;
+        }
+        cache.splice(cache.begin(), cache, it->second);
+        return &it->second->corridor;
+    }
+
+    void PathQueryService::addToCache(TrianglePairKey key, std::vector<std::size_t>&& corridor) {
+        if(cacheCapacity == 0) {
+            return;
+        }
+        cache.push_front(CacheEntry { key, std::move(corridor) });
+        cacheLookup[key] = cache.begin();
+        if(cache.size() > cacheCapacity) {
+            cacheLookup.erase(cache.back().key);
+            cache.pop_back();
+        }
+    }
+
+    void PathQueryService::evictInvalidatedCorridors() {
+        ZoneScoped;
+        for(auto it = cache.begin(); it != cache.end();) {
+            // "no path" may have been caused by an obstacle which moved away since
+            if(it->corridor.empty() || navMesh.isCorridorBlocked(it->corridor)) {
+                cacheLookup.erase(it->key);
+                it = cache.erase(it);
+                lastStats.evictedCorridors++;
+            } else {
+                ++it;
+            }
+        }
+        cachedObstacleVersion = navMesh.getObstacleVersion();
+    }
+
+    void PathQueryService::clearCache() {
+        cache.clear();
+        cacheLookup.clear();
+        cachedObstacleVersion = navMesh.getObstacleVersion();
+    }
+
+    std::size_t PathQueryService::getPendingCount() const {
+        std::lock_guard l { pendingMutex };
+        return pending.size();
+    }
+
+    const PathQueryStats& PathQueryService::getLastStats() const {
+        return lastStats;
+    }
+
+} // Carrot::AI
@@ -0,0 +1,141 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <engine/pathfinding/NavMesh.h>
+
+namespace Carrot {
+    class TaskScheduler;
+}
+
+namespace Carrot::AI {
+
+    /// Path requested to a PathQueryService, filled during PathQueryService::update
+    class PathQuery {
+    public:
+        /// Has the path been computed? Once true, getPath can be called from any thread
+        bool isReady() const;
+
+        /// Computed path, without waypoints if there is no path between the requested points.
+        /// Only valid once isReady() returns true
+        const NavPath& getPath() const;
+
+        const glm::vec3& getStart() const;
+        const glm::vec3& getGoal() const;
+
+    private:
+        glm::vec3 start{ 0.0f };
+        glm::vec3 goal{ 0.0f };
+        NavMesh::NavMeshPosition startPosition;
+        NavMesh::NavMeshPosition goalPosition;
+        bool snapped = false; //< have startPosition and goalPosition been computed?
+
+        NavPath path;
+        std::atomic<bool> ready = false;
+
+        friend class PathQueryService;
+    };
+
+    /// What happened during the last call to PathQueryService::update
+    struct PathQueryStats {
+        std::size_t completedQueries = 0;
+        std::size_t cancelledQueries = 0; //< queries dropped because nobody kept their handle
+        std::size_t deferredQueries = 0; //< queries left for the next update, because the time budget was exceeded
+        std::size_t searches = 0; //< A* searches, after deduplication of queries going between the same triangles
+        std::size_t cacheHits = 0; //< triangle pairs whose corridor was already in the cache
+        std::size_t evictedCorridors = 0; //< cached corridors dropped because obstacles changed
+    };
+
+    /**
+     * Computes paths for many agents at once, instead of having each agent block on NavMesh::computePath.
+     *
+     * Requests are accumulated, then processed during update() (once per frame), spread over TaskScheduler::FrameParallelWork:
+     *  - queries going between the same triangles share a single A* search
+     *  - corridors (triangles to go through) of recent searches are kept in a LRU cache, a query between cached triangles
+     *    only needs to compute its waypoints
+     *  - update() stops starting new searches once its time budget is exceeded, remaining queries wait for the next update
+     *
+     * The navmesh must outlive this service, and not be modified during update(). Call clearCache() if it is reloaded.
+     * Obstacles can be added, moved or removed between updates: cached corridors going through blocked triangles and cached
+     * "no path" results are dropped on the next update, other cached corridors stay valid but may not be the shortest anymore.
+     */
+    class PathQueryService {
+    public:
+        /// How many corridors are kept in cache by default
+        constexpr static std::size_t DefaultCacheCapacity = 512;
+
+        explicit PathQueryService(const NavMesh& navMesh, TaskScheduler& scheduler, std::size_t corridorCacheCapacity = DefaultCacheCapacity);
+
+        /// Requests a path from 'start' to 'goal'. Can be called from any thread.
+        /// The query is cancelled if the returned handle is released before the path is computed.
+        std::shared_ptr<const PathQuery> requestPath(const glm::vec3& start, const glm::vec3& goal);
+
+        /// Computes the paths of pending queries. Expected to be called once per frame, from a single thread.
+        /// \param timeBudget no new search is started once this duration has elapsed. At least one search is done per update,
+        ///  so that queries always end up being processed
+        void update(const std::chrono::duration<float>& timeBudget);
+
+        /// Forgets all cached corridors
+        void clearCache();
+
+        /// How many queries are waiting for an update
+        std::size_t getPendingCount() const;
+
+        /// Stats of the last call to update()
+        const PathQueryStats& getLastStats() const;
+
+    private:
+        /// Key of a pair of triangles: start triangle in the high bits, goal triangle in the low bits
+        using TrianglePairKey = std::uint64_t;
+
+        /// Queries going between the same triangles, processed together
+        struct QueryGroup {
+            TrianglePairKey key = 0;
+            std::vector<PathQuery*> queries;
+            const std::vector<std::size_t>* cachedCorridor = nullptr;
+            std::vector<std::size_t> corridor; //< found during this update, if not cached
+            bool processed = false;
+            bool searched = false; //< was A* run for this group? (not cached, and start and goal triangles are different)
+        };
+
+        struct CacheEntry {
+            TrianglePairKey key = 0;
+            std::vector<std::size_t> corridor; //< empty if there is no path between the triangles
+        };
+
+        /// Finds the corridor of 'group' (from the cache or via A*), then computes the path of each of its queries
+        void processGroup(QueryGroup& group) const;
+
+        /// Returns the cached corridor for the given key and marks it as most recently used, nullptr if none
+        const std::vector<std::size_t>* findInCache(TrianglePairKey key);
+
+        void addToCache(TrianglePairKey key, std::vector<std::size_t>&& corridor);
+
+        /// Removes cached corridors which may be wrong since obstacles of the navmesh changed
+        void evictInvalidatedCorridors();
+
+        const NavMesh& navMesh;
+        TaskScheduler& scheduler;
+
+        mutable std::mutex pendingMutex;
+        std::vector<std::shared_ptr<PathQuery>> pending;
+
+        // most recently used first
+        std::size_t cacheCapacity = 0;
+        std::list<CacheEntry> cache;
+        std::unordered_map<TrianglePairKey, std::list<CacheEntry>::iterator> cacheLookup;
+        std::uint64_t cachedObstacleVersion = 0; //< obstacle version of the navmesh when the cache was last validated
+
+        PathQueryStats lastStats;
+    };
+
+} // Carrot::AI
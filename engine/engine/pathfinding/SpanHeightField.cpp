@@ -0,0 +1,205 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include "SpanHeightField.h"
+
+#include <algorithm>
+
+namespace Carrot::AI {
+
+    /// A triangle clipped by at most 4 axis-aligned planes: 3 + 4 vertices at most
+    static constexpr std::size_t MaxPolygonVertices = 8;
+
+    /// Convex polygon, stored as one array per coordinate so that distances to a plane are computed for all vertices at once
+    struct ClippedPolygon {
+        float x[MaxPolygonVertices]{};
+        float y[MaxPolygonVertices]{};
+        float z[MaxPolygonVertices]{};
+        std::size_t count = 0;
+
+        void add(float vx, float vy, float vz) {
+            x[count] = vx;
+            y[count] = vy;
+            z[count] = vz;
+            count++;
+        }
+
+        void add(const ClippedPolygon& other, std::size_t index) {
+            add(other.x[index], other.y[index], other.z[index]);
+        }
+    };
+
+    /**
+     * Splits 'polygon' with the plane coordinate == 'line' (coordinate being X or Y).
+     * 'below' receives the part where coordinate <= line, 'above' the part where coordinate >= line.
+     * Vertices on the plane are part of both.
+     */
+    static void splitPolygon(const ClippedPolygon& polygon, const float (&coordinates)[MaxPolygonVertices], float line, ClippedPolygon& below, ClippedPolygon& above) {
+        float distances[MaxPolygonVertices];
+        for(std::size_t i = 0; i < MaxPolygonVertices; i++) {
+            distances[i] = line - coordinates[i];
+        }
+
+        below.count = 0;
+        above.count = 0;
+        for(std::size_t i = 0, j = polygon.count - 1; i < polygon.count; j = i, i++) {
+            const bool previousBelow = distances[j] >= 0.0f;
+            const bool currentBelow = distances[i] >= 0.0f;
+            if(previousBelow != currentBelow) {
+                // edge crosses the plane
+                const float t = distances[j] / (distances[j] - distances[i]);
+                const float px = polygon.x[j] + (polygon.x[i] - polygon.x[j]) * t;
+                const float py = polygon.y[j] + (polygon.y[i] - polygon.y[j]) * t;
+                const float pz = polygon.z[j] + (polygon.z[i] - polygon.z[j]) * t;
+                below.add(px, py, pz);
+                above.add(px, py, pz);
+
+                // vertices on the plane were added with the intersection
+                if(distances[i] > 0.0f) {
+                    below.add(polygon, i);
+                } else if(distances[i] < 0.0f) {
+                    above.add(polygon, i);
+                }
+                continue;
+            }
+
+            if(distances[i] >= 0.0f) {
+                below.add(polygon, i);
+                if(distances[i] != 0.0f) {
+                    continue;
+                }
+            }
+            above.add(polygon, i);
+        }
+    }
+
+    void SpanHeightField::reset(std::size_t _sizeX, std::size_t _sizeY, std::size_t _sizeZ) {
+        sizeX = _sizeX;
+        sizeY = _sizeY;
+        sizeZ = _sizeZ;
+        columns.clear();
+        columns.resize(sizeX * sizeY);
+    }
+
+    void SpanHeightField::addSpan(std::size_t x, std::size_t y, std::int32_t minZ, std::int32_t maxZ, bool walkable) {
+        std::vector<Span>& spans = columns[x + y * sizeX];
+        Span newSpan { .minZ = minZ, .maxZ = maxZ, .walkable = walkable };
+
+        // find the spans touched by the new span, and merge them into it
+        auto first = std::lower_bound(spans.begin(), spans.end(), newSpan, [](const Span& a, const Span& b) {
+            return a.maxZ + 1 < b.minZ;
+        });
+        auto last = first;
+        for(; last != spans.end() && last->minZ <= newSpan.maxZ + 1; ++last) {
+            if(last->maxZ > newSpan.maxZ) {
+                newSpan.walkable = last->walkable;
+            } else if(last->maxZ == newSpan.maxZ) {
+                newSpan.walkable |= last->walkable;
+            }
+            newSpan.minZ = std::min(newSpan.minZ, last->minZ);
+            newSpan.maxZ = std::max(newSpan.maxZ, last->maxZ);
+        }
+
+        if(first == last) {
+            spans.insert(first, newSpan);
+        } else {
+            *first = newSpan;
+            spans.erase(first + 1, last);
+        }
+    }
+
+    void SpanHeightField::rasteriseTriangle(const glm::vec3 (&vertices)[3], bool walkable, const glm::vec3& origin, float voxelSize, std::size_t firstRow, std::size_t endRow) {
+        const glm::vec3 triangleMin = glm::min(vertices[0], glm::min(vertices[1], vertices[2]));
+        const glm::vec3 triangleMax = glm::max(vertices[0], glm::max(vertices[1], vertices[2]));
+
+        // work relative to the lower corner of voxel (0, 0, 0)
+        const glm::vec3 corner = origin - 0.5f * voxelSize;
+        const float inverseVoxelSize = 1.0f / voxelSize;
+        const std::int64_t minRow = std::max<std::int64_t>(static_cast<std::int64_t>(glm::floor((triangleMin.y - corner.y) * inverseVoxelSize)), firstRow);
+        const std::int64_t maxRow = std::min<std::int64_t>(static_cast<std::int64_t>(glm::floor((triangleMax.y - corner.y) * inverseVoxelSize)), static_cast<std::int64_t>(endRow) - 1);
+        if(minRow > maxRow) {
+            return;
+        }
+        const float heightfieldTop = corner.z + sizeZ * voxelSize;
+        if(triangleMax.z < corner.z || triangleMin.z > heightfieldTop) {
+            return;
+        }
+
+        ClippedPolygon remaining;
+        ClippedPolygon row;
+        ClippedPolygon rowRemaining;
+        ClippedPolygon cell;
+        ClippedPolygon discarded;
+        {
+            ClippedPolygon triangle;
+            for(const glm::vec3& v : vertices) {
+                triangle.add(v.x - corner.x, v.y - corner.y, v.z - corner.z);
+            }
+            // remove the part below the first row
+            splitPolygon(triangle, triangle.y, minRow * voxelSize, discarded, remaining);
+        }
+
+        for(std::int64_t y = minRow; y <= maxRow; y++) {
+            ClippedPolygon above;
+            splitPolygon(remaining, remaining.y, (y + 1) * voxelSize, row, above);
+            remaining = above;
+            if(row.count < 3) {
+                continue;
+            }
+
+            float rowMinX = row.x[0];
+            float rowMaxX = row.x[0];
+            for(std::size_t i = 1; i < row.count; i++) {
+                rowMinX = std::min(rowMinX, row.x[i]);
+                rowMaxX = std::max(rowMaxX, row.x[i]);
+            }
+            const std::int64_t minColumn = std::max<std::int64_t>(static_cast<std::int64_t>(glm::floor(rowMinX * inverseVoxelSize)), 0);
+            const std::int64_t maxColumn = std::min<std::int64_t>(static_cast<std::int64_t>(glm::floor(rowMaxX * inverseVoxelSize)), static_cast<std::int64_t>(sizeX) - 1);
+            if(minColumn > maxColumn) {
+                continue;
+            }
+
+            // remove the part left of the first column
+            splitPolygon(row, row.x, minColumn * voxelSize, discarded, rowRemaining);
+            for(std::int64_t x = minColumn; x <= maxColumn; x++) {
+                ClippedPolygon right;
+                splitPolygon(rowRemaining, rowRemaining.x, (x + 1) * voxelSize, cell, right);
+                rowRemaining = right;
+                if(cell.count < 3) {
+                    continue;
+                }
+
+                float cellMinZ = cell.z[0];
+                float cellMaxZ = cell.z[0];
+                for(std::size_t i = 1; i < cell.count; i++) {
+                    cellMinZ = std::min(cellMinZ, cell.z[i]);
+                    cellMaxZ = std::max(cellMaxZ, cell.z[i]);
+                }
+                const std::int64_t minZ = std::max<std::int64_t>(static_cast<std::int64_t>(glm::floor(cellMinZ * inverseVoxelSize)), 0);
+                const std::int64_t maxZ = std::min<std::int64_t>(static_cast<std::int64_t>(glm::floor(cellMaxZ * inverseVoxelSize)), static_cast<std::int64_t>(sizeZ) - 1);
+                if(minZ > maxZ) {
+                    continue;
+                }
+                addSpan(x, y, static_cast<std::int32_t>(minZ), static_cast<std::int32_t>(maxZ), walkable);
+            }
+        }
+    }
+
+    std::span<const SpanHeightField::Span> SpanHeightField::getSpans(std::size_t x, std::size_t y) const {
+        return columns[x + y * sizeX];
+    }
+
+    std::size_t SpanHeightField::getSizeX() const {
+        return sizeX;
+    }
+
+    std::size_t SpanHeightField::getSizeY() const {
+        return sizeY;
+    }
+
+    std::size_t SpanHeightField::getSizeZ() const {
+        return sizeZ;
+    }
+
+} // Carrot::AI
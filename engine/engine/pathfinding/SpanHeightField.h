@@ -0,0 +1,59 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Carrot::AI {
+
+    /**
+     * Voxelised geometry stored as solid spans along the Z axis, one list of spans per (x, y) column.
+     * Memory grows with the surface of the geometry instead of the volume of the grid.
+     *
+     * Voxel (x, y, z) is centered on origin + (x, y, z) * voxelSize.
+     * Rows (all columns with the same y) are independent: triangles can be rasterised in parallel by bands of rows,
+     * as long as two bands never share a row.
+     */
+    class SpanHeightField {
+    public:
+        struct Span {
+            std::int32_t minZ = 0; //< lowest solid voxel
+            std::int32_t maxZ = 0; //< highest solid voxel (included)
+            bool walkable = false; //< is the top of this span walkable?
+        };
+
+        void reset(std::size_t sizeX, std::size_t sizeY, std::size_t sizeZ);
+
+        /**
+         * Adds solid voxels from minZ to maxZ (included) to the given column, merging with the spans they touch.
+         * When spans are merged, the walkable flag of the highest top is kept (or'ed if both tops are the same voxel).
+         */
+        void addSpan(std::size_t x, std::size_t y, std::int32_t minZ, std::int32_t maxZ, bool walkable);
+
+        /**
+         * Adds the voxels touched by the given triangle, only for rows in [firstRow, endRow).
+         * @param origin center of voxel (0, 0, 0), in world space
+         */
+        void rasteriseTriangle(const glm::vec3 (&vertices)[3], bool walkable, const glm::vec3& origin, float voxelSize, std::size_t firstRow, std::size_t endRow);
+
+        /// Spans of the given column, sorted by Z, never overlapping nor touching
+        std::span<const Span> getSpans(std::size_t x, std::size_t y) const;
+
+        std::size_t getSizeX() const;
+        std::size_t getSizeY() const;
+        std::size_t getSizeZ() const;
+
+    private:
+        std::size_t sizeX = 0;
+        std::size_t sizeY = 0;
+        std::size_t sizeZ = 0;
+
+        std::vector<std::vector<Span>> columns;
+    };
+
+} // Carrot::AI
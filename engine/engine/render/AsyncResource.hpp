@@ -7,7 +7,7 @@
 #include <memory>
 #include <thread>
 #include <engine/utils/Macros.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include <engine/render/Model.h>
 
 namespace Carrot {
@@ -23,7 +23,7 @@
 #include <engine/render/raytracing/RaytracingScene.h>
 #include <engine/render/raytracing/AccelerationStructure.h>
 
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include "resources/LightMesh.h"
 
 /**
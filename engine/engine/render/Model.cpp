@@ -23,7 +23,7 @@
 #include <engine/render/resources/LightMesh.h>
 #include <engine/render/ModelRenderer.h>
 #include <engine/render/ClusterManager.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include <engine/Engine.h>
 
 Carrot::Model::Model(Carrot::Engine& engine, const Carrot::IO::Resource& file): engine(engine), resource(file) {}
@@ -121,7 +121,20 @@ void Carrot::Model::loadInner(TaskHandle& task, Carrot::Engine& engine, const Ca
 
     std::size_t opaqueMeshIndex = 0;
     std::size_t transparentMeshIndex = 0;
+
+    // all static primitives share the same buffers, allocated once
+    std::size_t totalStaticVertexCount = 0;
+    std::size_t totalStaticIndexCount = 0;
     for(const auto& primitive : scene.primitives) {
+        if(!primitive.isSkinned) {
+            totalStaticVertexCount += primitive.vertices.size();
+            totalStaticIndexCount += primitive.indices.size();
+        }
+    }
+    staticVertices.reserve(totalStaticVertexCount);
+    staticIndices.reserve(totalStaticIndexCount);
+
+    for(auto& primitive : scene.primitives) {
         if(primitive.isSkinned) {
             primitiveIndex++;
             continue;
@@ -129,16 +142,14 @@ void Carrot::Model::loadInner(TaskHandle& task, Carrot::Engine& engine, const Ca
 
         const std::size_t oldVertexCount = staticVertices.size();
         const std::size_t oldIndexCount = staticIndices.size();
-        staticVertices.resize(oldVertexCount + primitive.vertices.size());
-        staticIndices.resize(oldIndexCount + primitive.indices.size());
-
-        memcpy(&staticVertices[oldVertexCount], primitive.vertices.data(), primitive.vertices.size() * sizeof(Carrot::Vertex));
-        memcpy(&staticIndices[oldIndexCount], primitive.indices.data(), primitive.indices.size() * sizeof(std::uint32_t));
+        staticVertices.insert(staticVertices.end(), primitive.vertices.begin(), primitive.vertices.end());
+        staticIndices.insert(staticIndices.end(), primitive.indices.begin(), primitive.indices.end());
 
+        // the scene is not used after loading, meshlets can be stolen from it
         auto& info = staticMeshInfo[primitiveIndex];
-        info.meshletVertexIndices = primitive.meshletVertexIndices;
-        info.meshletIndices = primitive.meshletIndices;
-        info.meshlets = primitive.meshlets;
+        info.meshletVertexIndices = std::move(primitive.meshletVertexIndices);
+        info.meshletIndices = std::move(primitive.meshletIndices);
+        info.meshlets = std::move(primitive.meshlets);
         info.startVertex = oldVertexCount;
         info.startIndex = oldIndexCount;
         info.vertexCount = primitive.vertices.size();
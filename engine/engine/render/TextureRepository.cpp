@@ -8,7 +8,7 @@
 
 #include "core/utils/Assert.h"
 #include "engine/utils/Macros.h"
-#include "engine/task/TaskScheduler.h"
+#include "core/tasks/TaskScheduler.h"
 
 #include "engine/vr/Session.h"
 #include "resources/ResourceAllocator.h"
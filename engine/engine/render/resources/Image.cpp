@@ -18,7 +18,7 @@
 #include <core/io/Logging.hpp>
 #include <core/io/FileFormats.h>
 #include <engine/utils/Profiling.h>
-#include <engine/task/TaskScheduler.h>
+#include <core/tasks/TaskScheduler.h>
 #include <engine/render/resources/ResourceAllocator.h>
 
 /*static*/ Carrot::Async::SpinLock Carrot::Image::AliveImagesAccess{};
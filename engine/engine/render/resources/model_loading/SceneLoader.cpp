@@ -4,6 +4,7 @@
 
 #include "SceneLoader.h"
 #include <core/scene/AssimpLoader.h>
+#include <core/scene/CookedModel.h>
 #include <core/scene/GLTFLoader.h>
 #include <core/utils/stringmanip.h>
 #include <engine/io/AssimpCompatibilityLayer.h>
@@ -15,7 +16,10 @@ namespace Carrot::Render {
         verify(file.isFile(), "In-memory models are not supported!");
         const Carrot::IO::Path filePath { Carrot::toString(file.getFilepath().u8string()).c_str() };
 
-        if(filePath.getExtension() == ".gltf") {
+        if(filePath.getExtension() == ".cmodel") {
+            Render::CookedModelLoader loader;
+            scene = std::move(loader.load(file));
+        } else if(filePath.getExtension() == ".gltf") {
             Render::GLTFLoader loader;
             scene = std::move(loader.load(file));
         } else {
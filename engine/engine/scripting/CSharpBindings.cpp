@@ -95,6 +95,8 @@ namespace Carrot::Scripting {
         mono_add_internal_call("Carrot.Signature::GetComponentIndex", (void*)GetComponentIndex);
         mono_add_internal_call("Carrot.System::LoadEntities", (void*)LoadEntities);
         mono_add_internal_call("Carrot.System::_Query", (void*)_QueryECS);
+        // Carrot.dll built before signatures were passed as arrays of words. Mono looks for the name with the signature first
+        mono_add_internal_call("Carrot.System::_Query(ulong)", (void*)_QueryECSSingleWord);
         mono_add_internal_call("Carrot.System::FindEntityByName", (void*)FindEntityByName);
         mono_add_internal_call("Carrot.System::_GetLogicSystemByName", (void*)_GetLogicSystemByName);
         mono_add_internal_call("Carrot.Entity::GetComponent", (void*)GetComponent);
@@ -293,9 +295,11 @@ namespace Carrot::Scripting {
                         }
                 );
 
-                csharpComponentIDs.getOrCompute(fullType, []() {
+                const ComponentID componentID = csharpComponentIDs.getOrCompute(fullType, []() {
                     return Carrot::requestComponentID();
                 });
+                // assign the signature index now, instead of during the first query using this component
+                Signature::getIndex(componentID);
 
                 componentIDs.emplace_back(std::move(id));
             }
@@ -682,7 +686,7 @@ namespace Carrot::Scripting {
     //
 
     std::int32_t CSharpBindings::_GetMaxComponentCountUncached() {
-        return Carrot::MAX_COMPONENTS;
+        return static_cast<std::int32_t>(Carrot::MAX_COMPONENTS);
     }
 
     void CSharpBindings::BeginProfilingZone(MonoString* zoneName) {
@@ -734,19 +738,33 @@ namespace Carrot::Scripting {
         return systemPtr->getEntityList()->toMono();
     }
 
-    MonoArray* CSharpBindings::_QueryECS(MonoObject* systemObj, std::uint64_t componentsBitset) {
-        static_assert(MAX_COMPONENTS <= 64, "_QueryECS has to be modified if MAX_COMPONENTS > 64");
+    static MonoArray* queryECS(MonoObject* systemObj, std::span<const Signature::Word, Signature::WordCount> words) {
         Scripting::CSObject handleObj = instance().CarrotObjectHandleField->get(Scripting::CSObject(systemObj));
         std::uint64_t handle = *((std::uint64_t*)mono_object_unbox(handleObj));
         auto* systemPtr = reinterpret_cast<ECS::CSharpLogicSystem*>(handle);
 
         Signature signature;
-        signature.fromBitset(std::bitset<MAX_COMPONENTS>(componentsBitset));
+        signature.fromWords(words);
         auto queryResult = systemPtr->getWorld().queryEntities(signature);
 
         return instance().entityListToCSharp(queryResult)->toMono();
     }
 
+    MonoArray* CSharpBindings::_QueryECS(MonoObject* systemObj, MonoArray* componentsBitset) {
+        std::array<Signature::Word, Signature::WordCount> words{};
+        const std::size_t wordCount = std::min<std::size_t>(mono_array_length(componentsBitset), Signature::WordCount);
+        for(std::size_t i = 0; i < wordCount; i++) {
+            words[i] = mono_array_get(componentsBitset, std::uint64_t, i);
+        }
+        return queryECS(systemObj, words);
+    }
+
+    MonoArray* CSharpBindings::_QueryECSSingleWord(MonoObject* systemObj, std::uint64_t componentsBitset) {
+        std::array<Signature::Word, Signature::WordCount> words{};
+        words[0] = componentsBitset;
+        return queryECS(systemObj, words);
+    }
+
     ECS::Entity CSharpBindings::convertToEntity(MonoObject* entityMonoObj) {
         if(entityMonoObj == nullptr) {
             return ECS::Entity{};
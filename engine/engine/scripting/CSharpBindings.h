@@ -176,7 +176,10 @@ namespace Carrot::Scripting {
 
         static MonoArray* LoadEntities(MonoObject* systemObj);
 
-        static MonoArray* _QueryECS(MonoObject* systemObj, std::uint64_t componentsBitset);
+        static MonoArray* _QueryECS(MonoObject* systemObj, MonoArray* componentsBitset);
+
+        /// _Query of Carrot.dll versions which pass signatures as a single UInt64 (Signature.ToU64): only the first 64 component indices
+        static MonoArray* _QueryECSSingleWord(MonoObject* systemObj, std::uint64_t componentsBitset);
 
         static ECS::Entity convertToEntity(MonoObject* entityMonoObj);
 
@@ -90,8 +90,9 @@ void main() {
 
     vec3 B_ = normalize(bitangentSign * cross(N_, T_));
 
-    vec3 mappedNormal = texture(sampler2D(textures[normalMap], linearSampler), uv).xyz;
-    mappedNormal = mappedNormal * 2 -1;
+    // normal maps can be BC5 compressed (X and Y only), reconstruct Z
+    vec2 mappedNormalXY = texture(sampler2D(textures[normalMap], linearSampler), uv).xy * 2 - 1;
+    vec3 mappedNormal = vec3(mappedNormalXY, sqrt(max(0.0f, 1.0f - dot(mappedNormalXY, mappedNormalXY))));
     mappedNormal = normalize(mappedNormal.x * T_ + mappedNormal.y * B_ + mappedNormal.z * N_);
 
     N_ = mappedNormal;
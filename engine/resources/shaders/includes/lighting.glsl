@@ -611,10 +611,9 @@ LightingResult calculateGI(inout RandomSampler rng, vec3 worldPos, vec3 emissive
                 vec3 N = normalize(intersection.surfaceNormal);
                 vec3 B = cross(T, N) * intersection.bitangentSign;
 
-                vec3 mappedNormal = _sample(normalMap).rgb;
-
-                mappedNormal *= 2;
-                mappedNormal -= 1;
+                // normal maps can be BC5 compressed (X and Y only), reconstruct Z
+                vec2 mappedNormalXY = _sample(normalMap).rg * 2 - 1;
+                vec3 mappedNormal = vec3(mappedNormalXY, sqrt(max(0.0f, 1.0f - dot(mappedNormalXY, mappedNormalXY))));
                 mappedNormal = normalize(T * mappedNormal.x + B * mappedNormal.y + N * mappedNormal.z);
 
                 tangent = T;
@@ -661,7 +660,7 @@ LightingResult calculateGI(inout RandomSampler rng, vec3 worldPos, vec3 emissive
         }
 
         if(hitSkybox) {
-            vec3 skyboxColor = texture(gSkybox3D, uv).rgb;
+            vec3 skyboxColor = textureLod(gSkybox3D, uv, 0.0f).rgb; // mips of environment maps are prefiltered for rough reflections
             lightContribution += skyboxColor * beta;
         }
         r.color = lightContribution;
@@ -43,10 +43,15 @@ namespace Carrot {
             return _indices[compID];
         }
 
-        public UInt64 ToU64() {
-            UInt64 result = 0;
+        /**
+         * Packs the components of this signature into 64-bit words: bit i of word j corresponds to the component of global index j*64+i
+         */
+        public UInt64[] ToWords() {
+            UInt64[] result = new UInt64[(GetMaxComponentCount() + 63) / 64];
             for (int i = 0; i < GetMaxComponentCount(); i++) {
-                result |= (_components[i] ? 1ul : 0ul) << i;
+                if (_components[i]) {
+                    result[i / 64] |= 1ul << (i % 64);
+                }
             }
 
             return result;
@@ -307,7 +312,7 @@ namespace Carrot {
         public QueryResult Query(Signature signature) {
             QueryResult result = new QueryResult {
                 Signature = signature,
-                Entities = _Query(signature.ToU64())
+                Entities = _Query(signature.ToWords())
             };
             return result;
         }
@@ -342,7 +347,7 @@ namespace Carrot {
          * Ask engine to send list of entities with matching components
          */
         [MethodImpl(MethodImplOptions.InternalCall)]
-        private extern EntityWithComponents[] _Query(UInt64 signature);
+        private extern EntityWithComponents[] _Query(UInt64[] signature);
     }
     
     public class ECS {
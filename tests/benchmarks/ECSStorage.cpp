@@ -0,0 +1,76 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Compares the per-entity map storage of ECS::World (old) with the archetype storage (new, components stored by value
+// inside chunks), by ticking SystemKinematics over 100k entities. Boots the engine (needed by World), but never renders a frame.
+
+#include <chrono>
+#include <cstdio>
+#include <engine/Engine.h>
+#include <engine/ecs/World.h>
+#include <engine/ecs/systems/SystemKinematics.h>
+
+using namespace Carrot;
+using namespace Carrot::ECS;
+
+static constexpr std::size_t EntityCount = 100'000;
+static constexpr std::size_t TickCount = 200;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark drives the world by itself
+}
+
+struct BenchmarkResult {
+    double msPerTick = 0.0;
+    double nsPerEntity = 0.0;
+    double checksum = 0.0; //< sum of all positions at the end, both storages must do the same work
+};
+
+static BenchmarkResult runBenchmark(ComponentStorage storage) {
+    World world;
+    world.setComponentStorage(storage);
+    world.addLogicSystem<SystemKinematics>();
+
+    for(std::size_t i = 0; i < EntityCount; i++) {
+        Entity entity = world.newEntity();
+        entity.addComponent<TransformComponent>();
+        entity.addComponent<KinematicsComponent>();
+        entity.getComponent<KinematicsComponent>()->velocity = glm::vec3 { 1.0f, static_cast<float>(i % 16), 0.5f };
+    }
+    world.tick(0.0); // adds entities to the world
+
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t tick = 0; tick < TickCount; tick++) {
+        world.tick(1.0 / 60.0);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    BenchmarkResult result;
+    const double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+    result.msPerTick = totalMs / TickCount;
+    result.nsPerEntity = result.msPerTick * 1'000'000.0 / EntityCount;
+    for(const EntityWithComponents& queried : world.queryEntities<TransformComponent>()) {
+        const glm::vec3& position = static_cast<const TransformComponent*>(queried.components[0])->localTransform.position;
+        result.checksum += position.x + position.y + position.z;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    Configuration config{};
+    config.applicationName = "ECS storage benchmark";
+    config.raytracingSupport = RaytracingSupport::NotSupported;
+    config.enableFileWatching = false;
+    Engine engine{argc, argv, config};
+
+    const BenchmarkResult oldStorage = runBenchmark(ComponentStorage::PerEntityMap);
+    const BenchmarkResult newStorage = runBenchmark(ComponentStorage::Archetypes);
+
+    std::printf("%zu entities x %zu ticks of SystemKinematics\n", EntityCount, TickCount);
+    std::printf("%-28s %10s %12s %16s\n", "Storage", "ms/tick", "ns/entity", "checksum");
+    std::printf("%-28s %10.3f %12.2f %16.1f\n", "old: PerEntityMap", oldStorage.msPerTick, oldStorage.nsPerEntity, oldStorage.checksum);
+    std::printf("%-28s %10.3f %12.2f %16.1f\n", "new: Archetypes (by value)", newStorage.msPerTick, newStorage.nsPerEntity, newStorage.checksum);
+    std::printf("Speedup: x%.2f\n", oldStorage.msPerTick / newStorage.msPerTick);
+    return 0;
+}
@@ -0,0 +1,184 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Compares KDTree (one allocation per node) with FlatKDTree (implicit tree + leaf buckets) on 1M random points:
+// - build, single threaded and with Async::parallelFor bound to a scheduler of 8 threads
+// - closest neighbor of 100k random positions, one at a time and batched
+// - range search over 10k small boxes, one at a time and batched
+// - 8 nearest neighbors of 100k random positions (FlatKDTree only)
+// Also reports how often KDTree::closestNeighbor returns the actual closest point, since it does not backtrack.
+// Only depends on CarrotCore.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <core/containers/FlatKDTree.hpp>
+#include <core/containers/KDTree.hpp>
+#include <core/tasks/TaskScheduler.h>
+#include <glm/gtx/norm.hpp>
+
+using namespace Carrot;
+
+static constexpr std::size_t PointCount = 1'000'000;
+static constexpr std::size_t QueryCount = 100'000;
+static constexpr std::size_t RangeQueryCount = 10'000;
+static constexpr std::size_t AccuracySamples = 1000;
+static constexpr float WorldSize = 1000.0f;
+static constexpr float RangeHalfSize = 5.0f;
+
+struct Point {
+    glm::vec3 position;
+
+    glm::vec3 getPosition() const {
+        return position;
+    }
+};
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+static std::vector<Point> makePoints(std::size_t count, std::uint32_t seed) {
+    std::mt19937 rng { seed };
+    std::uniform_real_distribution<float> distribution { 0.0f, WorldSize };
+    std::vector<Point> points;
+    points.reserve(count);
+    for(std::size_t i = 0; i < count; i++) {
+        points.push_back(Point { glm::vec3 { distribution(rng), distribution(rng), distribution(rng) } });
+    }
+    return points;
+}
+
+static std::size_t bruteForceClosest(const std::vector<Point>& points, const glm::vec3& from) {
+    std::size_t best = 0;
+    float bestDistance = INFINITY;
+    for(std::size_t i = 0; i < points.size(); i++) {
+        const float d = glm::distance2(points[i].position, from);
+        if(d < bestDistance) {
+            bestDistance = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const std::vector<Point> points = makePoints(PointCount, 1);
+    const std::vector<Point> queries = makePoints(QueryCount, 2);
+    std::vector<glm::vec3> queryPositions;
+    std::vector<glm::vec3> rangeMins;
+    std::vector<glm::vec3> rangeMaxs;
+    for(const Point& query : queries) {
+        queryPositions.push_back(query.position);
+        if(rangeMins.size() < RangeQueryCount) {
+            rangeMins.push_back(query.position - glm::vec3(RangeHalfSize));
+            rangeMaxs.push_back(query.position + glm::vec3(RangeHalfSize));
+        }
+    }
+
+    std::uint64_t sink = 0;
+    std::printf("%-28s %12s %12s\n", "Operation", "KDTree (ms)", "Flat (ms)");
+
+    // build
+    KDTree<Point> tree { Allocator::getDefault() };
+    FlatKDTree<Point> flatTree { Allocator::getDefault() };
+    const double buildMs = measure([&]() { tree.build(points); });
+    const double flatBuildMs = measure([&]() { flatTree.build(points); });
+    std::printf("%-28s %12.3f %12.3f\n", "Build", buildMs, flatBuildMs);
+    {
+        TaskScheduler scheduler { TaskSchedulerConfig {
+            .frameParallelWorkThreads = 8,
+            .assetLoadingThreads = 1,
+        } };
+        scheduler.bindAsyncParallelFor();
+        const double parallelBuildMs = measure([&]() { flatTree.build(points); });
+        std::printf("%-28s %12s %12.3f\n", "Build (8 threads)", "-", parallelBuildMs);
+
+        const double batchedMs = measure([&]() {
+            std::vector<std::int64_t> results(queryPositions.size());
+            flatTree.closestNeighbors(results, queryPositions);
+            sink += results.back();
+        });
+        std::printf("%-28s %12s %12.3f\n", "Closest, batched (8 threads)", "-", batchedMs);
+    }
+
+    // closest neighbor
+    const double closestMs = measure([&]() {
+        for(const Point& query : queries) {
+            sink += tree.closestNeighbor(query);
+        }
+    });
+    const double flatClosestMs = measure([&]() {
+        for(const Point& query : queries) {
+            sink += flatTree.closestNeighbor(query);
+        }
+    });
+    std::printf("%-28s %12.3f %12.3f\n", "Closest neighbor", closestMs, flatClosestMs);
+    const double batchedClosestMs = measure([&]() {
+        std::vector<std::int64_t> results(queryPositions.size());
+        flatTree.closestNeighbors(results, queryPositions);
+        sink += results.back();
+    });
+    std::printf("%-28s %12s %12.3f\n", "Closest neighbor, batched", "-", batchedClosestMs);
+
+    // range search
+    const double rangeMs = measure([&]() {
+        Vector<std::size_t> results;
+        results.setGrowthFactor(2);
+        for(std::size_t i = 0; i < rangeMins.size(); i++) {
+            results.clear();
+            tree.rangeSearch(results, rangeMins[i], rangeMaxs[i]);
+            sink += results.size();
+        }
+    });
+    const double flatRangeMs = measure([&]() {
+        Vector<std::size_t> results;
+        results.setGrowthFactor(2);
+        for(std::size_t i = 0; i < rangeMins.size(); i++) {
+            results.clear();
+            flatTree.rangeSearch(results, rangeMins[i], rangeMaxs[i]);
+            sink += results.size();
+        }
+    });
+    std::printf("%-28s %12.3f %12.3f\n", "Range search", rangeMs, flatRangeMs);
+    const double batchedRangeMs = measure([&]() {
+        Vector<std::size_t> indices;
+        Vector<std::size_t> offsets;
+        indices.setGrowthFactor(2);
+        flatTree.rangeSearches(indices, offsets, rangeMins, rangeMaxs);
+        sink += indices.size();
+    });
+    std::printf("%-28s %12s %12.3f\n", "Range search, batched", "-", batchedRangeMs);
+
+    // k nearest
+    const double kNearestMs = measure([&]() {
+        Vector<std::size_t> results;
+        results.setGrowthFactor(2);
+        for(const glm::vec3& position : queryPositions) {
+            results.clear();
+            flatTree.kNearest(results, position, 8);
+            sink += results[0];
+        }
+    });
+    std::printf("%-28s %12s %12.3f\n", "8 nearest", "-", kNearestMs);
+
+    // accuracy
+    std::size_t exact = 0;
+    std::size_t flatExact = 0;
+    for(std::size_t i = 0; i < AccuracySamples; i++) {
+        const std::size_t expected = bruteForceClosest(points, queries[i].position);
+        exact += tree.closestNeighbor(queries[i]) == expected;
+        flatExact += flatTree.closestNeighbor(queries[i]) == expected;
+    }
+    std::printf("%-28s %11.1f%% %11.1f%%\n", "Exact closest neighbors", exact * 100.0 / AccuracySamples, flatExact * 100.0 / AccuracySamples);
+
+    std::printf("(ignore: %llu)\n", (unsigned long long)sink);
+    return 0;
+}
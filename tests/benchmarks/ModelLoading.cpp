@@ -0,0 +1,163 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Times the loading of the same generated model (32 primitives of 64k vertices with meshlets) from glTF, as Fertilizer
+// used to write it, and from cooked models (.cmodel): as is, compressed, and with quantized vertices.
+// Files are written in a temporary folder. Does not boot the engine.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <engine/Engine.h>
+#include <core/scene/CookedModel.h>
+#include <core/scene/GLTFLoader.h>
+#include <core/io/IO.h>
+#include <models/GLTFWriter.h>
+
+using namespace Carrot;
+using namespace Carrot::Render;
+
+static constexpr std::uint32_t PrimitiveCount = 32;
+static constexpr std::uint32_t GridSize = 256; // vertices per side of each primitive
+static constexpr std::uint32_t TrianglesPerMeshlet = 124;
+static constexpr int Iterations = 5;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark does not boot the engine
+}
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+static LoadedScene generateScene() {
+    LoadedScene scene;
+    scene.debugName = "generated";
+    scene.materials.emplace_back().name = "Material";
+    scene.nodeHierarchy = std::make_unique<Skeleton>(glm::mat4{1.0f});
+    scene.nodeHierarchy->hierarchy.bone.name = "Root";
+
+    for(std::uint32_t primitiveIndex = 0; primitiveIndex < PrimitiveCount; primitiveIndex++) {
+        LoadedPrimitive& primitive = scene.primitives.emplace_back();
+        primitive.name = Carrot::sprintf("Grid %u", primitiveIndex);
+        primitive.materialIndex = 0;
+        primitive.hadNormals = true;
+        primitive.hadTexCoords = true;
+        primitive.hadTangents = true;
+        primitive.minPos = glm::vec3 { 0.0f, 0.0f, 0.0f };
+        primitive.maxPos = glm::vec3 { 1.0f, 1.0f, 1.0f };
+
+        primitive.vertices.resize(GridSize * GridSize);
+        for(std::uint32_t y = 0; y < GridSize; y++) {
+            for(std::uint32_t x = 0; x < GridSize; x++) {
+                const glm::vec2 uv { static_cast<float>(x) / (GridSize - 1), static_cast<float>(y) / (GridSize - 1) };
+                Carrot::Vertex& vertex = primitive.vertices[y * GridSize + x];
+                vertex.pos = glm::vec4 { uv.x, uv.y, 0.1f * std::sin(uv.x * 20.0f + primitiveIndex), 1.0f };
+                vertex.color = glm::vec3 { 1.0f };
+                vertex.normal = glm::vec3 { 0.0f, 0.0f, 1.0f };
+                vertex.tangent = glm::vec4 { 1.0f, 0.0f, 0.0f, 1.0f };
+                vertex.uv = uv;
+            }
+        }
+        for(std::uint32_t y = 0; y + 1 < GridSize; y++) {
+            for(std::uint32_t x = 0; x + 1 < GridSize; x++) {
+                const std::uint32_t i = y * GridSize + x;
+                primitive.indices.insert(primitive.indices.end(), { i, i + 1, i + GridSize, i + GridSize, i + 1, i + GridSize + 1 });
+            }
+        }
+
+        // not real clusters, but meshlet arrays of the same size as real ones
+        primitive.meshletVertexIndices = primitive.indices;
+        primitive.meshletIndices.resize(primitive.indices.size());
+        const std::uint32_t triangleCount = primitive.indices.size() / 3;
+        for(std::uint32_t firstTriangle = 0; firstTriangle < triangleCount; firstTriangle += TrianglesPerMeshlet) {
+            Meshlet& meshlet = primitive.meshlets.emplace_back();
+            meshlet.indexOffset = firstTriangle * 3;
+            meshlet.indexCount = std::min(TrianglesPerMeshlet, triangleCount - firstTriangle) * 3;
+            meshlet.vertexOffset = meshlet.indexOffset;
+            meshlet.vertexCount = meshlet.indexCount;
+            for(std::uint32_t i = 0; i < meshlet.indexCount; i++) {
+                primitive.meshletIndices[meshlet.indexOffset + i] = i;
+            }
+        }
+
+        SkeletonTreeNode& node = scene.nodeHierarchy->hierarchy.newChild();
+        node.bone.name = primitive.name;
+        node.nodeKey.value = primitiveIndex + 1;
+        node.meshIndices = std::vector<std::size_t> { primitiveIndex };
+    }
+    return scene;
+}
+
+static std::uint64_t getFolderSize(const std::filesystem::path& folder) {
+    std::uint64_t size = 0;
+    for(const auto& entry : std::filesystem::directory_iterator(folder)) {
+        size += entry.file_size();
+    }
+    return size;
+}
+
+struct CookedVariant {
+    const char* name;
+    Render::CookedModelOptions options;
+    std::filesystem::path path;
+    double duration = 0.0;
+};
+
+int main() {
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "carrot-model-loading-benchmark";
+    const std::filesystem::path gltfFolder = root / "gltf";
+    std::filesystem::create_directories(gltfFolder);
+    const std::filesystem::path gltfPath = gltfFolder / "generated.gltf";
+
+    std::vector<CookedVariant> cookedVariants {
+        { .name = "cooked", .options = {}, .path = root / "generated.cmodel" },
+        { .name = "cooked, compressed", .options = { .compress = true }, .path = root / "generated-compressed.cmodel" },
+        { .name = "cooked, quantized+compressed", .options = { .quantizeVertices = true, .compress = true }, .path = root / "generated-quantized.cmodel" },
+    };
+
+    {
+        const LoadedScene scene = generateScene();
+        tinygltf::Model gltfModel = Fertilizer::writeAsGLTF("generated", scene);
+        tinygltf::TinyGLTF gltf;
+        if(!gltf.WriteGltfSceneToFile(&gltfModel, gltfPath.string(), false, false, false, false)) {
+            fprintf(stderr, "Could not write %s\n", gltfPath.string().c_str());
+            return 1;
+        }
+        for(const CookedVariant& variant : cookedVariants) {
+            const std::vector<std::uint8_t> cookedModel = writeAsCookedModel(scene, variant.options);
+            IO::writeFile(variant.path.string(), (void*)cookedModel.data(), cookedModel.size());
+        }
+    }
+
+    double gltfDuration = 0.0;
+    for(int i = 0; i < Iterations; i++) {
+        gltfDuration += measure([&]() {
+            const LoadedScene scene = GLTFLoader{}.load(IO::Resource { IO::VFS::Path { "generated.gltf" }, gltfPath });
+            verify(scene.primitives.size() == PrimitiveCount, "Wrong primitive count");
+        });
+        for(CookedVariant& variant : cookedVariants) {
+            variant.duration += measure([&]() {
+                const LoadedScene scene = CookedModelLoader{}.load(IO::Resource { IO::VFS::Path { "generated.cmodel" }, variant.path });
+                verify(scene.primitives.size() == PrimitiveCount, "Wrong primitive count");
+            });
+        }
+    }
+
+    printf("%u primitives of %u vertices\n", PrimitiveCount, GridSize * GridSize);
+    printf("%-30s %8.1f MB %8.1f ms per load\n", "glTF", getFolderSize(gltfFolder) / 1'000'000.0, gltfDuration / Iterations);
+    for(const CookedVariant& variant : cookedVariants) {
+        printf("%-30s %8.1f MB %8.1f ms per load (x%.1f)\n", variant.name, std::filesystem::file_size(variant.path) / 1'000'000.0,
+               variant.duration / Iterations, gltfDuration / variant.duration);
+    }
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,184 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Times the dynamic parts of the navigation: carving obstacles (adding, moving and removing cylinders and boxes) in a
+// generated navmesh of ~100k triangles, then local avoidance of 2000 agents crossing each other, with 1 thread and with
+// all hardware threads.
+// Does not boot the engine.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <engine/Engine.h>
+#include <engine/pathfinding/LocalAvoidance.h>
+#include <engine/pathfinding/NavMesh.h>
+#include <core/scene/LoadedScene.h>
+#include <core/tasks/TaskScheduler.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr std::size_t GridSize = 224; // 2 triangles per cell: ~100k triangles
+static constexpr std::size_t ObstacleCount = 1000;
+static constexpr std::size_t AgentRows = 40;
+static constexpr std::size_t AgentColumns = 50; // 2000 agents
+static constexpr std::size_t FrameCount = 300;
+static constexpr float DeltaTime = 1.0f / 60.0f;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark does not boot the engine
+}
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+static Render::LoadedScene makeGridScene() {
+    Render::LoadedScene scene;
+    auto& primitive = scene.primitives.emplace_back();
+    primitive.name = "benchmark navmesh";
+    for(std::size_t y = 0; y <= GridSize; y++) {
+        for(std::size_t x = 0; x <= GridSize; x++) {
+            Carrot::Vertex& v = primitive.vertices.emplace_back();
+            v.pos = glm::vec4 { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f };
+        }
+    }
+
+    auto vertexIndex = [](std::size_t x, std::size_t y) {
+        return static_cast<std::uint32_t>(y * (GridSize + 1) + x);
+    };
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+            primitive.indices.push_back(vertexIndex(x, y + 1));
+        }
+    }
+    return scene;
+}
+
+static void benchmarkObstacles() {
+    NavMesh navMesh;
+    navMesh.loadFromScene(makeGridScene());
+    printf("Obstacles in a navmesh of %llu triangles\n", static_cast<unsigned long long>(navMesh.getTriangleCount()));
+
+    std::mt19937 rng { 42 };
+    std::uniform_real_distribution<float> positions { 4.0f, GridSize - 4.0f };
+    std::uniform_real_distribution<float> sizes { 0.5f, 3.0f };
+    std::uniform_real_distribution<float> angles { 0.0f, glm::two_pi<float>() };
+    std::vector<NavMesh::Obstacle> obstacles;
+    for(std::size_t i = 0; i < ObstacleCount; i++) {
+        NavMesh::Obstacle& obstacle = obstacles.emplace_back();
+        obstacle.position = glm::vec3 { positions(rng), positions(rng), -1.0f };
+        if(i % 2 == 0) {
+            obstacle.shape = NavMesh::Obstacle::Shape::Cylinder;
+            obstacle.radius = sizes(rng);
+            obstacle.height = 2.0f;
+        } else {
+            obstacle.shape = NavMesh::Obstacle::Shape::Box;
+            obstacle.halfExtents = glm::vec3 { sizes(rng), sizes(rng), 1.0f };
+            obstacle.yaw = angles(rng);
+        }
+    }
+
+    std::vector<NavMesh::ObstacleID> ids;
+    const double addDuration = measure([&]() {
+        for(const NavMesh::Obstacle& obstacle : obstacles) {
+            ids.push_back(navMesh.addObstacle(obstacle));
+        }
+    });
+
+    // small moves, like a door opening or a crate being pushed: most blocked triangles stay the same
+    const double moveDuration = measure([&]() {
+        for(std::size_t i = 0; i < ids.size(); i++) {
+            obstacles[i].position.x += 0.25f;
+            navMesh.moveObstacle(ids[i], obstacles[i]);
+        }
+    });
+
+    // paths computed before the moves only need to be checked against the blocked triangles
+    SearchContext context;
+    std::vector<std::size_t> corridor;
+    const std::size_t start = navMesh.getClosestPosition(glm::vec3 { 1.0f, 1.0f, 0.0f }).triangleIndex;
+    const std::size_t goal = navMesh.getClosestPosition(glm::vec3 { GridSize - 1.0f, GridSize - 1.0f, 0.0f }).triangleIndex;
+    const double searchDuration = measure([&]() {
+        navMesh.findCorridor(start, goal, context, corridor);
+    });
+    bool blocked = false;
+    const double checkDuration = measure([&]() {
+        blocked = navMesh.isCorridorBlocked(corridor);
+    });
+
+    const double removeDuration = measure([&]() {
+        for(const NavMesh::ObstacleID id : ids) {
+            navMesh.removeObstacle(id);
+        }
+    });
+
+    const double perObstacle = 1000.0 / ObstacleCount; // ms to us
+    printf("  add: %.2f us/obstacle, move: %.2f us/obstacle, remove: %.2f us/obstacle\n", addDuration * perObstacle, moveDuration * perObstacle, removeDuration * perObstacle);
+    printf("  corridor of %llu triangles: search %.3f ms, obstacle check %.3f ms (blocked: %s)\n",
+           static_cast<unsigned long long>(corridor.size()), searchDuration, checkDuration, blocked ? "yes" : "no");
+}
+
+static void benchmarkAvoidance(std::size_t threads) {
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = threads,
+        .assetLoadingThreads = 1,
+    } };
+    LocalAvoidance avoidance { scheduler };
+
+    // two groups facing each other, each agent goes to the mirrored position in the other group
+    std::vector<AvoidanceAgent> agents;
+    std::vector<glm::vec2> goals;
+    for(std::size_t row = 0; row < AgentRows; row++) {
+        for(std::size_t column = 0; column < AgentColumns; column++) {
+            const float side = row < AgentRows / 2 ? -1.0f : 1.0f;
+            const glm::vec2 position {
+                static_cast<float>(column) * 1.5f,
+                side * (10.0f + static_cast<float>(row % (AgentRows / 2)) * 1.5f),
+            };
+            agents.emplace_back().position = position;
+            goals.emplace_back(position.x, -position.y);
+        }
+    }
+
+    double totalDuration = 0.0;
+    double maxDuration = 0.0;
+    for(std::size_t frame = 0; frame < FrameCount; frame++) {
+        for(std::size_t i = 0; i < agents.size(); i++) {
+            const glm::vec2 toGoal = goals[i] - agents[i].position;
+            const float distance = glm::length(toGoal);
+            agents[i].preferredVelocity = distance > agents[i].maxSpeed * DeltaTime ? toGoal / distance * agents[i].maxSpeed : toGoal / DeltaTime;
+        }
+        const double duration = measure([&]() {
+            avoidance.step(agents, DeltaTime);
+        });
+        totalDuration += duration;
+        maxDuration = std::max(maxDuration, duration);
+    }
+    printf("  %llu thread(s): %.3f ms/frame on average, %.3f ms at most\n", static_cast<unsigned long long>(threads), totalDuration / FrameCount, maxDuration);
+}
+
+int main() {
+    benchmarkObstacles();
+
+    printf("Local avoidance of %llu agents, %llu frames\n", static_cast<unsigned long long>(AgentRows * AgentColumns), static_cast<unsigned long long>(FrameCount));
+    const std::size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    benchmarkAvoidance(1);
+    if(threadCount > 1) {
+        benchmarkAvoidance(threadCount);
+    }
+    return 0;
+}
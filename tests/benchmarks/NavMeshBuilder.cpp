@@ -0,0 +1,176 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Builds a navmesh from a generated level (a large floor with pillars and raised platforms), with different tile sizes
+// and amounts of threads, and prints the time spent in each stage of the build.
+// Then moves a single pillar and compares a full rebuild with an incremental rebuild, which only rebuilds the tiles
+// around the old and new positions of the pillar.
+// Does not boot the engine.
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <glm/gtc/matrix_transform.hpp>
+#include <engine/Engine.h>
+#include <engine/pathfinding/NavMeshBuilder.h>
+#include <core/scene/LoadedScene.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr float LevelSize = 128.0f;
+static constexpr std::size_t PillarsPerSide = 8;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark does not boot the engine
+}
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+/// Adds a quad to the primitive, vertices in counter-clockwise order when seen from its front
+static void addQuad(Render::LoadedPrimitive& primitive, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    const glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+    const std::uint32_t firstIndex = static_cast<std::uint32_t>(primitive.vertices.size());
+    for(const glm::vec3& p : { a, b, c, d }) {
+        Carrot::Vertex& v = primitive.vertices.emplace_back();
+        v.pos = glm::vec4 { p, 1.0f };
+        v.normal = normal;
+    }
+    for(std::uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u }) {
+        primitive.indices.push_back(firstIndex + index);
+    }
+}
+
+/// Box from 'min' to 'max', without its bottom face
+static void addBox(Render::LoadedPrimitive& primitive, const glm::vec3& min, const glm::vec3& max) {
+    addQuad(primitive, { min.x, min.y, max.z }, { max.x, min.y, max.z }, { max.x, max.y, max.z }, { min.x, max.y, max.z });
+    addQuad(primitive, { min.x, min.y, min.z }, { max.x, min.y, min.z }, { max.x, min.y, max.z }, { min.x, min.y, max.z });
+    addQuad(primitive, { max.x, max.y, min.z }, { min.x, max.y, min.z }, { min.x, max.y, max.z }, { max.x, max.y, max.z });
+    addQuad(primitive, { min.x, max.y, min.z }, { min.x, min.y, min.z }, { min.x, min.y, max.z }, { min.x, max.y, max.z });
+    addQuad(primitive, { max.x, min.y, min.z }, { max.x, max.y, min.z }, { max.x, max.y, max.z }, { max.x, min.y, max.z });
+}
+
+static std::shared_ptr<Render::LoadedScene> makeScene(const std::function<void(Render::LoadedPrimitive&)>& fill) {
+    auto pScene = std::make_shared<Render::LoadedScene>();
+    pScene->debugName = "benchmark level";
+    pScene->nodeHierarchy = std::make_unique<Render::Skeleton>(glm::mat4(1.0f));
+    pScene->nodeHierarchy->hierarchy.meshIndices = std::vector<std::size_t>{ 0 };
+    fill(pScene->primitives.emplace_back());
+    return pScene;
+}
+
+/// Floor with raised platforms (reachable with steps) as one entry, and one entry per pillar
+static std::vector<NavMeshBuilder::MeshEntry> makeLevel() {
+    std::vector<NavMeshBuilder::MeshEntry> entries;
+    entries.emplace_back().scene = makeScene([](Render::LoadedPrimitive& primitive) {
+        addQuad(primitive, { 0, 0, 0 }, { LevelSize, 0, 0 }, { LevelSize, LevelSize, 0 }, { 0, LevelSize, 0 });
+        for(float platformX = 10.0f; platformX < LevelSize - 20.0f; platformX += 40.0f) {
+            const float platformY = LevelSize * 0.5f + 10.0f;
+            addBox(primitive, { platformX, platformY, 0.0f }, { platformX + 16.0f, platformY + 16.0f, 2.0f });
+            for(std::size_t step = 0; step < 4; step++) {
+                const float stepY = platformY - static_cast<float>(step + 1) * 1.0f;
+                addBox(primitive, { platformX, stepY, 0.0f }, { platformX + 4.0f, stepY + 1.0f, 2.0f - static_cast<float>(step + 1) * 0.5f });
+            }
+        }
+    });
+
+    auto pPillar = makeScene([](Render::LoadedPrimitive& primitive) {
+        addBox(primitive, { -1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 4.0f });
+    });
+    const float spacing = LevelSize / PillarsPerSide;
+    for(std::size_t y = 0; y < PillarsPerSide; y++) {
+        for(std::size_t x = 0; x < PillarsPerSide; x++) {
+            if(y == PillarsPerSide / 2 + 1) {
+                continue; // platforms
+            }
+            auto& entry = entries.emplace_back();
+            entry.scene = pPillar;
+            entry.transform = glm::translate(glm::mat4 { 1.0f }, glm::vec3 { (x + 0.5f) * spacing, (y + 0.5f) * spacing, 0.0f });
+        }
+    }
+    return entries;
+}
+
+static void waitForBuild(const NavMeshBuilder& builder) {
+    while(builder.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+    }
+}
+
+static void printTimings(const NavMeshBuilder& builder) {
+    const NavMeshBuilder::BuildTimings& timings = builder.getLastTimings();
+    printf("    %llu / %llu tiles rebuilt, %.2f ms, %llu triangles\n",
+           static_cast<unsigned long long>(timings.rebuiltTileCount), static_cast<unsigned long long>(timings.tileCount),
+           timings.totalMilliseconds, static_cast<unsigned long long>(builder.getResult().getTriangleCount()));
+    for(std::size_t stage = 0; stage < NavMeshBuilder::BuildStageCount; stage++) {
+        printf("      %-18s %10.2f ms\n", NavMeshBuilder::getStageName(static_cast<NavMeshBuilder::BuildStage>(stage)), timings.stageMilliseconds[stage]);
+    }
+}
+
+int main() {
+    const std::size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    printf("NavMesh build of a %.0fx%.0f level\n", LevelSize, LevelSize);
+
+    NavMeshBuilder::BuildParams params;
+    params.voxelSize = 0.5f;
+    params.characterHeight = 4;
+    params.characterRadius = 1;
+    params.maxClimbHeight = 1;
+
+    const std::vector<NavMeshBuilder::MeshEntry> level = makeLevel();
+    std::vector<std::size_t> threadCounts { 1 };
+    if(threadCount > 1) {
+        threadCounts.push_back(threadCount);
+    }
+    for(std::size_t threads : threadCounts) {
+        TaskScheduler scheduler { TaskSchedulerConfig {
+            .frameParallelWorkThreads = 1,
+            .assetLoadingThreads = threads,
+        } };
+        for(std::size_t tileSize : { 16, 32, 64 }) {
+            params.tileSize = tileSize;
+            NavMeshBuilder builder { scheduler };
+            const double duration = measure([&]() {
+                builder.start(std::vector<NavMeshBuilder::MeshEntry> { level }, params);
+                waitForBuild(builder);
+            });
+            printf("  %llu thread(s), tiles of %llu voxels: %.2f ms\n", static_cast<unsigned long long>(threads), static_cast<unsigned long long>(tileSize), duration);
+            printTimings(builder);
+        }
+    }
+
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 1,
+        .assetLoadingThreads = threadCount,
+    } };
+    params.tileSize = 32;
+    NavMeshBuilder builder { scheduler };
+    builder.start(std::vector<NavMeshBuilder::MeshEntry> { level }, params);
+    waitForBuild(builder);
+
+    // same scenes, so that only the moved entry is considered as changed
+    std::vector<NavMeshBuilder::MeshEntry> movedLevel = level;
+    movedLevel.back().transform = glm::translate(movedLevel.back().transform, glm::vec3 { -3.0f, 0.0f, 0.0f });
+
+    NavMeshBuilder fullBuilder { scheduler };
+    const double fullDuration = measure([&]() {
+        fullBuilder.start(std::vector<NavMeshBuilder::MeshEntry> { movedLevel }, params);
+        waitForBuild(fullBuilder);
+    });
+    const double incrementalDuration = measure([&]() {
+        builder.startIncrementalRebuild(std::move(movedLevel));
+        waitForBuild(builder);
+    });
+    printf("  Moved one pillar: full rebuild %.2f ms, incremental rebuild %.2f ms\n", fullDuration, incrementalDuration);
+    printTimings(builder);
+    return 0;
+}
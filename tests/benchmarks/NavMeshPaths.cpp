@@ -0,0 +1,253 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Runs thousands of NavMesh::computePath calls on a generated navmesh of ~100k triangles: a flat grid of quads, crossed
+// by walls with a few openings, so that paths have to go around them.
+// Also compares the A* search alone with the previous implementation (linear scan of the open set, scores in hash maps),
+// on the triangle graph of the same navmesh.
+// Then compares the same paths with and without the cluster hierarchy (NavMeshHierarchy), and snaps 100k random positions
+// to the navmesh, one at a time and batched.
+// Does not boot the engine.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <engine/Engine.h>
+#include <engine/pathfinding/NavMesh.h>
+#include <core/scene/LoadedScene.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr std::size_t GridSize = 230; // 2 triangles per cell, minus walls: ~100k triangles
+static constexpr std::size_t WallSpacing = 23;
+static constexpr std::size_t PathCount = 2000;
+static constexpr std::size_t PreviousAStarPathCount = 20;
+static constexpr std::size_t SnapCount = 100'000;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark does not boot the engine
+}
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+/// Is the grid cell (x, y) part of a wall?
+static bool isWall(std::size_t x, std::size_t y) {
+    const bool verticalWall = x % WallSpacing == WallSpacing / 2 && (y / 8) % 4 != 0;
+    const bool horizontalWall = y % WallSpacing == WallSpacing / 2 && (x / 8) % 5 != 0;
+    return verticalWall || horizontalWall;
+}
+
+static Render::LoadedScene makeGridScene() {
+    Render::LoadedScene scene;
+    auto& primitive = scene.primitives.emplace_back();
+    primitive.name = "benchmark navmesh";
+    for(std::size_t y = 0; y <= GridSize; y++) {
+        for(std::size_t x = 0; x <= GridSize; x++) {
+            Carrot::Vertex& v = primitive.vertices.emplace_back();
+            v.pos = glm::vec4 { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f };
+        }
+    }
+
+    auto vertexIndex = [](std::size_t x, std::size_t y) {
+        return static_cast<std::uint32_t>(y * (GridSize + 1) + x);
+    };
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            if(isWall(x, y)) {
+                continue;
+            }
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+            primitive.indices.push_back(vertexIndex(x, y + 1));
+        }
+    }
+    return scene;
+}
+
+/// Previous implementation of AStarImpl::findPath, kept for comparison
+static std::vector<std::size_t> previousFindPath(const std::unordered_map<std::size_t, std::vector<std::size_t>>& adjacency,
+                                                 std::size_t pointA, std::size_t pointB,
+                                                 const std::function<float(std::size_t a, std::size_t b)>& distanceFunction,
+                                                 const std::function<float(std::size_t v)>& costEstimation) {
+    std::vector<std::size_t> openSet;
+    openSet.push_back(pointA);
+    std::unordered_map<std::size_t, std::size_t> cameFrom;
+    std::unordered_map<std::size_t, float> gScore;
+    std::unordered_map<std::size_t, float> fScore;
+    gScore[pointA] = 0.0f;
+    fScore[pointA] = costEstimation(pointA);
+
+    auto getScore = [](const std::unordered_map<std::size_t, float>& scores, std::size_t node) {
+        auto it = scores.find(node);
+        return it != scores.end() ? it->second : INFINITY;
+    };
+
+    while(!openSet.empty()) {
+        std::size_t currentIndex = 0;
+        for(std::size_t i = 1; i < openSet.size(); ++i) {
+            if(getScore(fScore, openSet[i]) < getScore(fScore, openSet[currentIndex])) {
+                currentIndex = i;
+            }
+        }
+        std::size_t current = openSet[currentIndex];
+        if(current == pointB) {
+            std::vector<std::size_t> path { current };
+            for(auto it = cameFrom.find(current); it != cameFrom.end(); it = cameFrom.find(it->second)) {
+                path.push_back(it->second);
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+
+        openSet.erase(openSet.begin() + currentIndex);
+        auto adjacencyIt = adjacency.find(current);
+        if(adjacencyIt == adjacency.end()) {
+            continue;
+        }
+        for(std::size_t neighbor : adjacencyIt->second) {
+            float tentativeGScore = getScore(gScore, current) + distanceFunction(current, neighbor);
+            if(tentativeGScore < getScore(gScore, neighbor)) {
+                cameFrom[neighbor] = current;
+                gScore[neighbor] = tentativeGScore;
+                fScore[neighbor] = tentativeGScore + costEstimation(neighbor);
+                if(std::find(openSet.begin(), openSet.end(), neighbor) == openSet.end()) {
+                    openSet.push_back(neighbor);
+                }
+            }
+        }
+    }
+    return {};
+}
+
+int main(int argc, char** argv) {
+    NavMesh navMesh;
+    const Render::LoadedScene scene = makeGridScene();
+    const double loadMs = measure([&]() {
+        navMesh.loadFromScene(scene);
+    });
+    std::printf("Navmesh with %zu triangles loaded in %.3f ms\n", scene.primitives[0].indices.size() / 3, loadMs);
+
+    std::mt19937 rng { 42 };
+    std::uniform_real_distribution<float> coordinate { 0.5f, GridSize - 0.5f };
+    std::vector<std::pair<glm::vec3, glm::vec3>> queries;
+    for(std::size_t i = 0; i < PathCount; i++) {
+        queries.emplace_back(glm::vec3 { coordinate(rng), coordinate(rng), 0.0f }, glm::vec3 { coordinate(rng), coordinate(rng), 0.0f });
+    }
+
+    std::size_t waypointCount = 0;
+    const double pathsMs = measure([&]() {
+        SearchContext context;
+        for(const auto& [start, goal] : queries) {
+            waypointCount += navMesh.computePath(start, goal, context).waypoints.size();
+        }
+    });
+    std::printf("%zu paths computed in %.3f ms (%.3f ms per path, %zu waypoints in total)\n", PathCount, pathsMs, pathsMs / PathCount, waypointCount);
+
+    // same paths, planned over clusters first
+    const double hierarchyBuildMs = measure([&]() {
+        navMesh.buildHierarchy();
+    });
+    std::printf("Hierarchy built in %.3f ms\n", hierarchyBuildMs);
+    std::size_t hierarchicalWaypointCount = 0;
+    const double hierarchicalPathsMs = measure([&]() {
+        SearchContext context;
+        for(const auto& [start, goal] : queries) {
+            hierarchicalWaypointCount += navMesh.computePath(start, goal, context).waypoints.size();
+        }
+    });
+    std::printf("%zu paths computed with hierarchy in %.3f ms (%.3f ms per path, %zu waypoints in total)\n", PathCount, hierarchicalPathsMs, hierarchicalPathsMs / PathCount, hierarchicalWaypointCount);
+
+    // A* alone, on the triangle graph of the navmesh (triangle centers are the vertices)
+    const auto& primitive = scene.primitives[0];
+    std::vector<glm::vec3> centers;
+    for(std::size_t i = 0; i < primitive.indices.size(); i += 3) {
+        centers.push_back((primitive.vertices[primitive.indices[i]].pos.xyz()
+            + primitive.vertices[primitive.indices[i+1]].pos.xyz()
+            + primitive.vertices[primitive.indices[i+2]].pos.xyz()) / 3.0f);
+    }
+    // cells are connected to the cells around them, which are not walls
+    std::unordered_map<std::size_t, std::vector<std::size_t>> adjacency;
+    std::vector<Edge> edges;
+    {
+        std::unordered_map<std::size_t, std::size_t> cellToNode;
+        for(std::size_t node = 0; node < centers.size(); node += 2) {
+            cellToNode[static_cast<std::size_t>(centers[node].y) * GridSize + static_cast<std::size_t>(centers[node].x)] = node;
+        }
+        for(const auto& [cell, node] : cellToNode) {
+            const std::size_t x = cell % GridSize;
+            const std::size_t y = cell / GridSize;
+            for(const auto& [dx, dy] : { std::pair { 1, 0 }, std::pair { -1, 0 }, std::pair { 0, 1 }, std::pair { 0, -1 } }) {
+                auto it = cellToNode.find((y + dy) * GridSize + (x + dx));
+                if(x + dx < GridSize && y + dy < GridSize && it != cellToNode.end()) {
+                    edges.push_back(Edge { node, it->second });
+                    adjacency[node].push_back(it->second);
+                }
+            }
+        }
+    }
+    AStar<glm::vec3> graph { centers, edges };
+
+    std::vector<std::pair<std::size_t, std::size_t>> nodeQueries;
+    std::uniform_int_distribution<std::size_t> nodeDistribution { 0, centers.size() / 2 - 1 };
+    for(std::size_t i = 0; i < PathCount; i++) {
+        nodeQueries.emplace_back(nodeDistribution(rng) * 2, nodeDistribution(rng) * 2);
+    }
+
+    std::size_t pathLength = 0;
+    const double previousMs = measure([&]() {
+        for(std::size_t i = 0; i < PreviousAStarPathCount; i++) {
+            const auto [start, goal] = nodeQueries[i];
+            pathLength += previousFindPath(adjacency, start, goal, [&](std::size_t a, std::size_t b) {
+                return glm::distance(centers[a], centers[b]);
+            }, [&](std::size_t v) {
+                return glm::distance(centers[v], centers[goal]);
+            }).size();
+        }
+    });
+    const double currentMs = measure([&]() {
+        SearchContext context;
+        for(const auto& [start, goal] : nodeQueries) {
+            const glm::vec3 goalPosition = centers[goal];
+            graph.findPath(context, start, goal, [](const glm::vec3& a, const glm::vec3& b) {
+                return glm::distance(a, b);
+            }, [&](const glm::vec3& v) {
+                return glm::distance(v, goalPosition);
+            });
+            pathLength += context.getPath().size();
+        }
+    });
+    std::printf("A* only, previous implementation: %.3f ms per path (%zu paths)\n", previousMs / PreviousAStarPathCount, PreviousAStarPathCount);
+    std::printf("A* only, current implementation:  %.3f ms per path (%zu paths)\n", currentMs / PathCount, PathCount);
+
+    // snapping positions to the navmesh
+    std::uniform_real_distribution<float> height { -2.0f, 2.0f };
+    std::vector<glm::vec3> positions;
+    for(std::size_t i = 0; i < SnapCount; i++) {
+        positions.emplace_back(coordinate(rng), coordinate(rng), height(rng));
+    }
+    std::vector<glm::vec3> snapped(positions.size());
+    const double snapMs = measure([&]() {
+        for(std::size_t i = 0; i < positions.size(); i++) {
+            snapped[i] = navMesh.getClosestPointInMesh(positions[i]);
+        }
+    });
+    const double batchedSnapMs = measure([&]() {
+        navMesh.getClosestPointsInMesh(positions, snapped);
+    });
+    std::printf("%zu positions snapped in %.3f ms (%.3f ms batched)\n", SnapCount, snapMs, batchedSnapMs);
+    std::printf("(ignore: %zu, %f)\n", pathLength, snapped.back().x);
+    return 0;
+}
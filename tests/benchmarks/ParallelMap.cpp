@@ -0,0 +1,137 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Measures Async::ParallelMap under contention on 1, 8 and 32 threads, compared to a single std::unordered_map guarded
+// by a ReadWriteLock (the previous implementation of ParallelMap):
+// - hot lookups: all threads repeatedly get the same few keys, like per-thread packet storage and common textures
+// - spread lookups: all threads get keys over a large set, which already exist
+// - insertions: each thread inserts its own keys, then all threads read them
+// Only depends on CarrotCore.
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <core/async/ParallelMap.hpp>
+
+using namespace Carrot;
+
+static constexpr std::size_t OperationsPerThread = 1'000'000;
+static constexpr std::size_t HotKeyCount = 8;
+static constexpr std::size_t SpreadKeyCount = 100'000;
+static constexpr std::size_t InsertionsPerThread = 20'000;
+
+/// Previous implementation of ParallelMap, kept for comparison
+class LockedMap {
+public:
+    std::uint64_t& getOrCompute(std::uint64_t key, const std::function<std::uint64_t()>& generator) {
+        {
+            Async::LockGuard l { lock.read() };
+            auto it = storage.find(key);
+            if(it != storage.end()) {
+                return it->second;
+            }
+        }
+        Async::LockGuard l { lock.write() };
+        auto it = storage.find(key);
+        if(it != storage.end()) {
+            return it->second;
+        }
+        return storage[key] = generator();
+    }
+
+private:
+    Async::ReadWriteLock lock;
+    std::unordered_map<std::uint64_t, std::uint64_t> storage;
+};
+
+/// Runs 'work(threadIndex)' on 'threadCount' threads at once, returns the duration in milliseconds
+template<typename Work>
+static double runThreads(std::size_t threadCount, Work work) {
+    std::atomic<bool> start = false;
+    std::vector<std::thread> threads;
+    for(std::size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            while(!start.load()) {
+                std::this_thread::yield();
+            }
+            work(t);
+        });
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    start = true;
+    for(auto& t : threads) {
+        t.join();
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+template<typename Map>
+static void prefill(Map& map) {
+    for(std::uint64_t key = 0; key < SpreadKeyCount; key++) {
+        map.getOrCompute(key, [key]() { return key; });
+    }
+}
+
+template<typename Map>
+static double hotLookups(std::size_t threadCount) {
+    Map map;
+    prefill(map);
+    static std::atomic<std::uint64_t> sink { 0 };
+    return runThreads(threadCount, [&](std::size_t) {
+        std::uint64_t sum = 0;
+        for(std::size_t i = 0; i < OperationsPerThread; i++) {
+            sum += map.getOrCompute(i % HotKeyCount, []() { return 0ull; });
+        }
+        sink += sum;
+    });
+}
+
+template<typename Map>
+static double spreadLookups(std::size_t threadCount) {
+    Map map;
+    prefill(map);
+    static std::atomic<std::uint64_t> sink { 0 };
+    return runThreads(threadCount, [&](std::size_t threadIndex) {
+        std::uint64_t sum = 0;
+        std::uint64_t key = threadIndex;
+        for(std::size_t i = 0; i < OperationsPerThread; i++) {
+            key = (key * 6364136223846793005ull + 1442695040888963407ull);
+            sum += map.getOrCompute((key >> 33) % SpreadKeyCount, []() { return 0ull; });
+        }
+        sink += sum;
+    });
+}
+
+template<typename Map>
+static double insertions(std::size_t threadCount) {
+    Map map;
+    static std::atomic<std::uint64_t> sink { 0 };
+    return runThreads(threadCount, [&](std::size_t threadIndex) {
+        const std::uint64_t firstKey = threadIndex * InsertionsPerThread;
+        for(std::uint64_t key = firstKey; key < firstKey + InsertionsPerThread; key++) {
+            map.getOrCompute(key, [key]() { return key; });
+        }
+        std::uint64_t sum = 0;
+        for(std::uint64_t key = 0; key < InsertionsPerThread; key++) {
+            sum += map.getOrCompute(key, [key]() { return key; });
+        }
+        sink += sum;
+    });
+}
+
+int main(int argc, char** argv) {
+    std::printf("%-12s %8s %16s %16s %16s\n", "Map", "Threads", "Hot (ms)", "Spread (ms)", "Insertions (ms)");
+    for(std::size_t threadCount : { 1, 8, 32 }) {
+        std::printf("%-12s %8zu %16.3f %16.3f %16.3f\n", "Locked", threadCount,
+                    hotLookups<LockedMap>(threadCount), spreadLookups<LockedMap>(threadCount), insertions<LockedMap>(threadCount));
+
+        using Sharded = Async::ParallelMap<std::uint64_t, std::uint64_t>;
+        std::printf("%-12s %8zu %16.3f %16.3f %16.3f\n", "ParallelMap", threadCount,
+                    hotLookups<Sharded>(threadCount), spreadLookups<Sharded>(threadCount), insertions<Sharded>(threadCount));
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Compares the shared queue of TaskScheduler with per-thread work-stealing deques on 4, 16 and 64 threads:
+// - fan-out/fan-in: many tiny tasks scheduled from the main thread, then waited for
+// - leaf fan-out/fan-in: same, but with leaf tasks, which do not need a fiber
+// - nested parallelFor: parallelFor calls made from inside parallelFor tasks
+// - yield storm: tasks which yield their fiber over and over
+// Only depends on CarrotCore, no engine nor GPU needed.
+
+#include <chrono>
+#include <cstdio>
+#include <core/tasks/TaskScheduler.h>
+
+using namespace Carrot;
+
+static constexpr std::size_t Repetitions = 5;
+static constexpr std::size_t FanOutTaskCount = 20'000;
+static constexpr std::size_t OuterLoopCount = 64;
+static constexpr std::size_t InnerLoopCount = 4096;
+static constexpr std::size_t YieldingTaskCount = 256;
+static constexpr std::size_t YieldsPerTask = 200;
+
+/// Some work that the compiler cannot remove
+static void work(std::size_t seed) {
+    static std::atomic<std::uint64_t> sink { 0 };
+    std::uint64_t value = seed;
+    for(int i = 0; i < 64; i++) {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    sink.fetch_add(value & 1, std::memory_order_relaxed);
+}
+
+static void waitFor(TaskScheduler& scheduler, Async::Counter& counter) {
+    while(!counter.isIdle()) {
+        scheduler.stealJobAndRun(TaskScheduler::FrameParallelWork);
+    }
+}
+
+static void fanOutFanIn(TaskScheduler& scheduler) {
+    Async::Counter sync;
+    for(std::size_t i = 0; i < FanOutTaskCount; i++) {
+        scheduler.schedule(TaskDescription {
+            .name = "Fan out",
+            .task = [i](TaskHandle&) {
+                work(i);
+            },
+            .joiner = &sync,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    waitFor(scheduler, sync);
+}
+
+static void leafFanOutFanIn(TaskScheduler& scheduler) {
+    Async::Counter sync;
+    for(std::size_t i = 0; i < FanOutTaskCount; i++) {
+        scheduler.scheduleLeaf(LeafTaskDescription {
+            .name = "Leaf fan out",
+            .task = [i]() {
+                work(i);
+            },
+            .joiner = &sync,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    waitFor(scheduler, sync);
+}
+
+static void nestedParallelFor(TaskScheduler& scheduler) {
+    scheduler.parallelFor(OuterLoopCount, [&](std::size_t outer) {
+        scheduler.parallelFor(InnerLoopCount, [&](std::size_t inner) {
+            work(outer * InnerLoopCount + inner);
+        }, 64);
+    }, 1);
+}
+
+static void yieldStorm(TaskScheduler& scheduler) {
+    Async::Counter sync;
+    for(std::size_t i = 0; i < YieldingTaskCount; i++) {
+        scheduler.schedule(TaskDescription {
+            .name = "Yield storm",
+            .task = [i](TaskHandle& task) {
+                for(std::size_t y = 0; y < YieldsPerTask; y++) {
+                    work(i + y);
+                    task.yield();
+                }
+            },
+            .joiner = &sync,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    waitFor(scheduler, sync);
+}
+
+template<typename Scenario>
+static double measure(TaskScheduler& scheduler, Scenario scenario) {
+    scenario(scheduler); // warm up, allocates TaskData and fibers
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < Repetitions; i++) {
+        scenario(scheduler);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / Repetitions;
+}
+
+int main(int argc, char** argv) {
+    std::printf("%-14s %8s %16s %16s %16s %16s %12s\n", "Queueing", "Threads", "Fan-out (ms)", "Leaf fan-out (ms)", "Nested for (ms)", "Yield storm (ms)", "Steals");
+    for(std::size_t threadCount : { 4, 16, 64 }) {
+        for(TaskQueueing queueing : { TaskQueueing::SharedQueue, TaskQueueing::WorkStealing }) {
+            TaskScheduler scheduler { TaskSchedulerConfig {
+                .frameParallelWorkThreads = threadCount,
+                .assetLoadingThreads = 0,
+                .queueing = queueing,
+            } };
+
+            const double fanOutMs = measure(scheduler, fanOutFanIn);
+            const double leafFanOutMs = measure(scheduler, leafFanOutFanIn);
+            const double nestedMs = measure(scheduler, nestedParallelFor);
+            const double yieldMs = measure(scheduler, yieldStorm);
+            std::printf("%-14s %8zu %16.3f %16.3f %16.3f %16.3f %12llu\n",
+                        queueing == TaskQueueing::SharedQueue ? "SharedQueue" : "WorkStealing",
+                        threadCount, fanOutMs, leafFanOutMs, nestedMs, yieldMs,
+                        (unsigned long long)scheduler.getStolenTaskCount());
+        }
+    }
+    return 0;
+}
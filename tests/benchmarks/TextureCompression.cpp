@@ -0,0 +1,187 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+// Times block compression of 4096x4096 textures (opaque albedo, albedo with transparency, normal map, mask) for each
+// format and quality fertilizer can pick, with 1 thread and with all hardware threads, and reports the PSNR of each.
+// Images given on the command line are used instead of the generated ones, with the format fertilizer would choose.
+// Does not boot the engine.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <thread>
+#include <engine/Engine.h>
+#include <BlockCompression.h>
+#include <core/render/ImageFormats.h>
+#include <core/tasks/TaskScheduler.h>
+#include <stb_image.h>
+
+using namespace Carrot;
+using namespace Fertilizer;
+
+static constexpr std::uint32_t GeneratedSize = 4096;
+
+void Carrot::Engine::initGame() {
+    // no game, the benchmark does not boot the engine
+}
+
+/// Runs 'work' once and returns its duration in milliseconds
+template<typename Work>
+static double measure(Work work) {
+    const auto startTime = std::chrono::steady_clock::now();
+    work();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+struct BenchmarkImage {
+    std::string name;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::vector<std::uint8_t> texels; // RGBA8
+    TextureUsage usage = TextureUsage::Color;
+    bool hasAlpha = false;
+};
+
+static BenchmarkImage generateImage(const char* name, TextureUsage usage, bool hasAlpha) {
+    BenchmarkImage image { .name = name, .width = GeneratedSize, .height = GeneratedSize, .usage = usage, .hasAlpha = hasAlpha };
+    image.texels.resize(static_cast<std::size_t>(GeneratedSize) * GeneratedSize * 4);
+
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<int> noise { -6, 6 };
+    for(std::uint32_t y = 0; y < GeneratedSize; y++) {
+        for(std::uint32_t x = 0; x < GeneratedSize; x++) {
+            const float u = static_cast<float>(x) / GeneratedSize;
+            const float v = static_cast<float>(y) / GeneratedSize;
+            float values[4];
+            if(usage == TextureUsage::NormalMap) {
+                const float dx = 0.6f * std::cos(x * 0.05f) * std::sin(y * 0.02f);
+                const float dy = 0.6f * std::sin(x * 0.03f) * std::cos(y * 0.04f);
+                const float length = std::sqrt(dx * dx + dy * dy + 1.0f);
+                values[0] = (dx / length * 0.5f + 0.5f) * 255.0f;
+                values[1] = (dy / length * 0.5f + 0.5f) * 255.0f;
+                values[2] = (1.0f / length * 0.5f + 0.5f) * 255.0f;
+                values[3] = 255.0f;
+            } else {
+                values[0] = 128.0f + 100.0f * std::sin(u * 40.0f + std::sin(v * 13.0f));
+                values[1] = 128.0f + 100.0f * std::cos(v * 35.0f);
+                values[2] = 64.0f + 128.0f * u * v;
+                values[3] = hasAlpha ? 255.0f * (0.5f + 0.5f * std::sin((u + v) * 60.0f)) : 255.0f;
+            }
+            for(std::size_t c = 0; c < 4; c++) {
+                const int n = (c < 3 && usage != TextureUsage::NormalMap) ? noise(rng) : 0;
+                image.texels[(static_cast<std::size_t>(y) * GeneratedSize + x) * 4 + c] = static_cast<std::uint8_t>(std::clamp(static_cast<int>(values[c]) + n, 0, 255));
+            }
+        }
+    }
+    return image;
+}
+
+static std::optional<BenchmarkImage> loadImage(const char* path) {
+    int width = 0;
+    int height = 0;
+    int componentCount = 0;
+    stbi_uc* pixels = stbi_load(path, &width, &height, &componentCount, 4);
+    if(pixels == nullptr) {
+        printf("Could not load %s\n", path);
+        return {};
+    }
+
+    BenchmarkImage image { .name = path, .width = static_cast<std::uint32_t>(width), .height = static_cast<std::uint32_t>(height) };
+    image.texels.assign(pixels, pixels + static_cast<std::size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    image.usage = guessTextureUsage(path, componentCount);
+    for(std::size_t i = 3; i < image.texels.size() && componentCount == 4; i += 4) {
+        image.hasAlpha |= image.texels[i] != 255;
+    }
+    return image;
+}
+
+static std::size_t getChannelCount(VkFormat format) {
+    switch(format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            return 3;
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return 1;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+static double computePSNR(std::span<const std::uint8_t> reference, std::span<const std::uint8_t> other, std::size_t channelCount) {
+    double squaredError = 0.0;
+    for(std::size_t texel = 0; texel < reference.size() / 4; texel++) {
+        for(std::size_t c = 0; c < channelCount; c++) {
+            const double difference = static_cast<double>(reference[texel * 4 + c]) - static_cast<double>(other[texel * 4 + c]);
+            squaredError += difference * difference;
+        }
+    }
+    const double meanSquaredError = squaredError / (reference.size() / 4 * channelCount);
+    return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+}
+
+static void benchmarkImage(const BenchmarkImage& image) {
+    printf("%s (%ux%u)\n", image.name.c_str(), image.width, image.height);
+    const double megaTexels = static_cast<double>(image.width) * image.height / 1'000'000.0;
+    for(const TextureCompressionQuality quality : { TextureCompressionQuality::Fast, TextureCompressionQuality::Normal, TextureCompressionQuality::High }) {
+        const VkFormat format = chooseCompressedFormat(image.usage, image.hasAlpha, quality);
+        std::vector<std::uint8_t> blocks(ImageFormats::computeMipSize(image.width, image.height, 1, format));
+
+        // BC7 at high quality is slow: keep single-threaded runs on a slice of the image
+        const std::uint32_t serialHeight = format == VK_FORMAT_BC7_UNORM_BLOCK ? std::min(image.height, 512u) : image.height;
+        const double serialDuration = measure([&]() {
+            compressBlocks(format, quality, image.texels, image.width, serialHeight, 1, blocks);
+        }) * image.height / serialHeight;
+
+        double parallelDuration = 0.0;
+        std::size_t threadCount = 0;
+        {
+            TaskScheduler scheduler { TaskSchedulerConfig {
+                .assetLoadingThreads = 0,
+            } };
+            scheduler.bindAsyncParallelFor();
+            threadCount = scheduler.getParallelThreadIDs().size() + 1 /* calling thread */;
+            parallelDuration = measure([&]() {
+                compressBlocks(format, quality, image.texels, image.width, image.height, 1, blocks);
+            });
+        }
+
+        std::vector<std::uint8_t> decompressed(image.texels.size());
+        decompressBlocks(format, blocks, image.width, image.height, 1, decompressed);
+        const char* qualityName = quality == TextureCompressionQuality::Fast ? "fast" : quality == TextureCompressionQuality::Normal ? "normal" : "high";
+        const char* formatName = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK ? "BC1"
+                               : format == VK_FORMAT_BC3_UNORM_BLOCK ? "BC3"
+                               : format == VK_FORMAT_BC4_UNORM_BLOCK ? "BC4"
+                               : format == VK_FORMAT_BC5_UNORM_BLOCK ? "BC5" : "BC7";
+        printf("  %-6s %s: 1 thread %9.1f ms (%6.2f MTexel/s), %llu threads %8.1f ms (%6.2f MTexel/s), PSNR %.2f dB\n",
+               qualityName, formatName,
+               serialDuration, megaTexels / (serialDuration / 1000.0),
+               static_cast<unsigned long long>(threadCount), parallelDuration, megaTexels / (parallelDuration / 1000.0),
+               computePSNR(image.texels, decompressed, getChannelCount(format)));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<BenchmarkImage> images;
+    for(int i = 1; i < argc; i++) {
+        if(std::optional<BenchmarkImage> image = loadImage(argv[i])) {
+            images.emplace_back(std::move(image.value()));
+        }
+    }
+    if(images.empty()) {
+        images.emplace_back(generateImage("generated albedo", TextureUsage::Color, false));
+        images.emplace_back(generateImage("generated albedo with transparency", TextureUsage::Color, true));
+        images.emplace_back(generateImage("generated normal map", TextureUsage::NormalMap, false));
+        images.emplace_back(generateImage("generated mask", TextureUsage::Mask, false));
+    }
+
+    for(const BenchmarkImage& image : images) {
+        benchmarkImage(image);
+    }
+    return 0;
+}
@@ -0,0 +1,347 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <core/scene/CookedModel.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Carrot;
+using namespace Carrot::Render;
+
+static Carrot::Vertex makeVertex(float i) {
+    Carrot::Vertex vertex;
+    std::memset(&vertex, 0xCD, sizeof(vertex)); // garbage in padding, must not end up in the file
+    vertex.pos = glm::vec4 { i, i + 1.0f, i + 2.0f, 1.0f };
+    vertex.color = glm::vec3 { 1.0f, 0.5f, 0.25f };
+    vertex.normal = glm::vec3 { 0.0f, 1.0f, 0.0f };
+    vertex.tangent = glm::vec4 { 1.0f, 0.0f, 0.0f, -1.0f };
+    vertex.uv = glm::vec2 { i * 0.1f, 1.0f - i * 0.1f };
+    return vertex;
+}
+
+/// Small scene using every part of the format: materials, static and skinned primitives, meshlets, nodes, animations, BLASes
+static LoadedScene makeScene() {
+    LoadedScene scene;
+    scene.debugName = "test scene";
+
+    LoadedMaterial& material = scene.materials.emplace_back();
+    material.name = "Material";
+    material.blendMode = LoadedMaterial::BlendMode::Blend;
+    material.albedo = IO::VFS::Path { "textures/albedo.png" };
+    material.normalMap = IO::VFS::Path { "textures/normal.png" };
+    material.baseColorFactor = glm::vec4 { 0.5f, 0.25f, 1.0f, 0.75f };
+    material.metallicFactor = 0.25f;
+    material.roughnessFactor = 0.75f;
+    material.emissiveFactor = glm::vec3 { 2.0f, 3.0f, 4.0f };
+    scene.materials.emplace_back().name = "Untextured";
+
+    LoadedPrimitive& staticPrimitive = scene.primitives.emplace_back();
+    staticPrimitive.name = "Static";
+    staticPrimitive.hadNormals = true;
+    staticPrimitive.hadTexCoords = true;
+    staticPrimitive.materialIndex = 0;
+    staticPrimitive.transform = glm::mat4 { 2.0f };
+    staticPrimitive.minPos = glm::vec3 { -1.0f };
+    staticPrimitive.maxPos = glm::vec3 { 5.0f };
+    for(int i = 0; i < 4; i++) {
+        staticPrimitive.vertices.emplace_back(makeVertex(static_cast<float>(i)));
+    }
+    staticPrimitive.indices = { 0, 1, 2, 2, 1, 3 };
+    staticPrimitive.meshletVertexIndices = { 0, 1, 2, 3 };
+    staticPrimitive.meshletIndices = { 0, 1, 2, 2, 1, 3 };
+    Meshlet& meshlet = staticPrimitive.meshlets.emplace_back();
+    meshlet.vertexCount = 4;
+    meshlet.indexCount = 6;
+    meshlet.groupIndex = 1;
+    meshlet.lod = 2;
+    meshlet.refinedError = 0.5f;
+
+    LoadedPrimitive& skinnedPrimitive = scene.primitives.emplace_back();
+    skinnedPrimitive.name = "Skinned";
+    skinnedPrimitive.isSkinned = true;
+    skinnedPrimitive.hadTangents = true;
+    for(int i = 0; i < 3; i++) {
+        Carrot::SkinnedVertex vertex;
+        std::memset(&vertex, 0xAB, sizeof(vertex));
+        static_cast<Carrot::Vertex&>(vertex) = makeVertex(static_cast<float>(i));
+        vertex.boneWeights = glm::vec4 { 0.75f, 0.25f, 0.0f, 0.0f };
+        vertex.boneIDs = glm::u8vec4 { 0, 1, 0, 0 };
+        skinnedPrimitive.skinnedVertices.emplace_back(vertex);
+    }
+    skinnedPrimitive.indices = { 0, 1, 2 };
+
+    scene.nodeHierarchy = std::make_unique<Skeleton>(glm::mat4 { 0.5f });
+    SkeletonTreeNode& root = scene.nodeHierarchy->hierarchy;
+    root.bone.name = "Root";
+    root.nodeKey.value = 10;
+    SkeletonTreeNode& child = root.newChild();
+    child.bone.name = "Child";
+    child.bone.transform = glm::mat4 { 3.0f };
+    child.nodeKey.value = 11;
+    child.meshIndices = std::vector<std::size_t> { 0, 1 };
+    SkeletonTreeNode& grandChild = child.newChild();
+    grandChild.bone.name = "GrandChild";
+    grandChild.nodeKey.value = 12;
+    grandChild.meshIndices = std::vector<std::size_t> {};
+    root.newChild().bone.name = "Sibling";
+
+    scene.boneMapping[1]["Root"] = 0;
+    scene.boneMapping[1]["Child"] = 1;
+    scene.offsetMatrices[1]["Child"] = glm::mat4 { 4.0f };
+
+    Animation& animation = scene.animationData.emplace_back();
+    animation.keyframeCount = 2;
+    animation.duration = 1.5f;
+    animation.keyframes.emplace_back(0.0f).boneTransforms = { glm::mat4 { 1.0f }, glm::mat4 { 2.0f } };
+    animation.keyframes.emplace_back(1.5f).boneTransforms = { glm::mat4 { 3.0f }, glm::mat4 { 4.0f } };
+    scene.animationMapping["Walk"] = 0;
+
+    PrecomputedBLAS& blas = scene.precomputedBLASes[NodeKey { 11 }][Carrot::Pair<std::uint32_t, std::uint32_t> { 0, 1 }];
+    blas.blasBytes.resize(5);
+    for(std::uint8_t i = 0; i < 5; i++) {
+        blas.blasBytes[i] = i;
+    }
+    return scene;
+}
+
+static void expectSameVertex(const Carrot::Vertex& a, const Carrot::Vertex& b) {
+    EXPECT_EQ(a.pos, b.pos);
+    EXPECT_EQ(a.color, b.color);
+    EXPECT_EQ(a.normal, b.normal);
+    EXPECT_EQ(a.tangent, b.tangent);
+    EXPECT_EQ(a.uv, b.uv);
+}
+
+static void expectSameNodes(const SkeletonTreeNode& a, const SkeletonTreeNode& b) {
+    EXPECT_EQ(a.bone.name, b.bone.name);
+    EXPECT_EQ(a.bone.transform, b.bone.transform);
+    EXPECT_EQ(a.bone.originalTransform, b.bone.originalTransform);
+    EXPECT_EQ(a.nodeKey, b.nodeKey);
+    EXPECT_EQ(a.meshIndices, b.meshIndices);
+    ASSERT_EQ(a.getChildren().size(), b.getChildren().size());
+    auto itB = b.getChildren().begin();
+    for(const SkeletonTreeNode& childA : a.getChildren()) {
+        EXPECT_EQ(childA.pParent, &a);
+        expectSameNodes(childA, *itB);
+        ++itB;
+    }
+}
+
+TEST(CookedModels, RoundTrip) {
+    const LoadedScene scene = makeScene();
+    const IO::VFS::Path modelPath { "game://models/test.cmodel" };
+    const std::vector<std::uint8_t> bytes = writeAsCookedModel(scene);
+    const LoadedScene loaded = CookedModelLoader{}.load(bytes, modelPath, "test.cmodel");
+
+    EXPECT_EQ(loaded.debugName, scene.debugName);
+
+    ASSERT_EQ(loaded.materials.size(), scene.materials.size());
+    const LoadedMaterial& material = loaded.materials[0];
+    EXPECT_EQ(material.name, "Material");
+    EXPECT_EQ(material.blendMode, LoadedMaterial::BlendMode::Blend);
+    EXPECT_EQ(material.albedo, modelPath.relative(IO::Path { "textures/albedo.png" }));
+    EXPECT_EQ(material.normalMap, modelPath.relative(IO::Path { "textures/normal.png" }));
+    EXPECT_TRUE(material.metallicRoughness.isEmpty());
+    EXPECT_TRUE(material.occlusion.isEmpty());
+    EXPECT_TRUE(material.emissive.isEmpty());
+    EXPECT_EQ(material.baseColorFactor, scene.materials[0].baseColorFactor);
+    EXPECT_EQ(material.metallicFactor, 0.25f);
+    EXPECT_EQ(material.roughnessFactor, 0.75f);
+    EXPECT_EQ(material.emissiveFactor, scene.materials[0].emissiveFactor);
+    EXPECT_EQ(loaded.materials[1].name, "Untextured");
+    EXPECT_TRUE(loaded.materials[1].albedo.isEmpty());
+
+    ASSERT_EQ(loaded.primitives.size(), scene.primitives.size());
+    for(std::size_t i = 0; i < scene.primitives.size(); i++) {
+        const LoadedPrimitive& expected = scene.primitives[i];
+        const LoadedPrimitive& primitive = loaded.primitives[i];
+        EXPECT_EQ(primitive.name, expected.name);
+        EXPECT_EQ(primitive.isSkinned, expected.isSkinned);
+        EXPECT_EQ(primitive.hadTangents, expected.hadTangents);
+        EXPECT_EQ(primitive.hadNormals, expected.hadNormals);
+        EXPECT_EQ(primitive.hadTexCoords, expected.hadTexCoords);
+        EXPECT_EQ(primitive.transform, expected.transform);
+        EXPECT_EQ(primitive.minPos, expected.minPos);
+        EXPECT_EQ(primitive.maxPos, expected.maxPos);
+        EXPECT_EQ(primitive.materialIndex, expected.materialIndex);
+        EXPECT_EQ(primitive.indices, expected.indices);
+        EXPECT_EQ(primitive.meshletVertexIndices, expected.meshletVertexIndices);
+        EXPECT_EQ(primitive.meshletIndices, expected.meshletIndices);
+
+        ASSERT_EQ(primitive.vertices.size(), expected.vertices.size());
+        for(std::size_t v = 0; v < expected.vertices.size(); v++) {
+            expectSameVertex(primitive.vertices[v], expected.vertices[v]);
+        }
+        ASSERT_EQ(primitive.skinnedVertices.size(), expected.skinnedVertices.size());
+        for(std::size_t v = 0; v < expected.skinnedVertices.size(); v++) {
+            expectSameVertex(primitive.skinnedVertices[v], expected.skinnedVertices[v]);
+            EXPECT_EQ(primitive.skinnedVertices[v].boneWeights, expected.skinnedVertices[v].boneWeights);
+            EXPECT_EQ(primitive.skinnedVertices[v].boneIDs, expected.skinnedVertices[v].boneIDs);
+        }
+        ASSERT_EQ(primitive.meshlets.size(), expected.meshlets.size());
+        for(std::size_t m = 0; m < expected.meshlets.size(); m++) {
+            EXPECT_EQ(primitive.meshlets[m].vertexCount, expected.meshlets[m].vertexCount);
+            EXPECT_EQ(primitive.meshlets[m].indexCount, expected.meshlets[m].indexCount);
+            EXPECT_EQ(primitive.meshlets[m].groupIndex, expected.meshlets[m].groupIndex);
+            EXPECT_EQ(primitive.meshlets[m].lod, expected.meshlets[m].lod);
+            EXPECT_EQ(primitive.meshlets[m].refinedError, expected.meshlets[m].refinedError);
+            EXPECT_EQ(primitive.meshlets[m].clusterError, expected.meshlets[m].clusterError);
+        }
+    }
+
+    ASSERT_NE(loaded.nodeHierarchy, nullptr);
+    EXPECT_EQ(loaded.nodeHierarchy->getGlobalInverseTransform(), scene.nodeHierarchy->getGlobalInverseTransform());
+    expectSameNodes(loaded.nodeHierarchy->hierarchy, scene.nodeHierarchy->hierarchy);
+
+    EXPECT_EQ(loaded.boneMapping, scene.boneMapping);
+    EXPECT_EQ(loaded.offsetMatrices, scene.offsetMatrices);
+    EXPECT_EQ(loaded.animationMapping, scene.animationMapping);
+    ASSERT_EQ(loaded.animationData.size(), 1u);
+    EXPECT_EQ(loaded.animationData[0].keyframeCount, 2);
+    EXPECT_EQ(loaded.animationData[0].duration, 1.5f);
+    ASSERT_EQ(loaded.animationData[0].keyframes.size(), 2u);
+    for(std::size_t k = 0; k < 2; k++) {
+        EXPECT_EQ(loaded.animationData[0].keyframes[k].timestamp, scene.animationData[0].keyframes[k].timestamp);
+        EXPECT_EQ(loaded.animationData[0].keyframes[k].boneTransforms, scene.animationData[0].keyframes[k].boneTransforms);
+    }
+
+    ASSERT_EQ(loaded.precomputedBLASes.size(), 1u);
+    const auto& blasesOfNode = loaded.precomputedBLASes.at(NodeKey { 11 });
+    ASSERT_EQ(blasesOfNode.size(), 1u);
+    const PrecomputedBLAS& blas = blasesOfNode.at(Carrot::Pair<std::uint32_t, std::uint32_t> { 0, 1 });
+    ASSERT_EQ(blas.blasBytes.size(), 5);
+    for(std::uint8_t i = 0; i < 5; i++) {
+        EXPECT_EQ(blas.blasBytes[i], i);
+    }
+}
+
+TEST(CookedModels, EmptyScene) {
+    const LoadedScene loaded = CookedModelLoader{}.load(writeAsCookedModel(LoadedScene{}), {}, "empty.cmodel");
+    EXPECT_TRUE(loaded.materials.empty());
+    EXPECT_TRUE(loaded.primitives.empty());
+    EXPECT_EQ(loaded.nodeHierarchy, nullptr);
+    EXPECT_TRUE(loaded.animationData.empty());
+    EXPECT_TRUE(loaded.precomputedBLASes.empty());
+}
+
+TEST(CookedModels, Deterministic) {
+    // same scene, same bytes: the asset cache and diffs of converted assets rely on it
+    const std::vector<std::uint8_t> bytes = writeAsCookedModel(makeScene());
+    EXPECT_EQ(writeAsCookedModel(makeScene()), bytes);
+
+    const LoadedScene loaded = CookedModelLoader{}.load(bytes, {}, "test.cmodel");
+    EXPECT_EQ(writeAsCookedModel(loaded), bytes);
+}
+
+TEST(CookedModels, InvalidFiles) {
+    const std::vector<std::uint8_t> bytes = writeAsCookedModel(makeScene());
+
+    EXPECT_THROW(CookedModelLoader{}.load(std::span<const std::uint8_t>{}, {}, "empty.cmodel"), std::invalid_argument);
+
+    std::vector<std::uint8_t> wrongMagic = bytes;
+    wrongMagic[0] ^= 0xFF;
+    EXPECT_THROW(CookedModelLoader{}.load(wrongMagic, {}, "magic.cmodel"), std::invalid_argument);
+
+    std::vector<std::uint8_t> wrongVersion = bytes;
+    wrongVersion[4] ^= 0xFF;
+    EXPECT_THROW(CookedModelLoader{}.load(wrongVersion, {}, "version.cmodel"), std::invalid_argument);
+
+    // sections outside of the file
+    for(std::size_t size : { bytes.size() / 4, bytes.size() / 2, bytes.size() - 1 }) {
+        const std::span<const std::uint8_t> truncated { bytes.data(), size };
+        EXPECT_THROW(CookedModelLoader{}.load(truncated, {}, "truncated.cmodel"), std::invalid_argument) << size;
+    }
+}
+
+TEST(CookedModels, Compressed) {
+    // compression is lossless: same scene as the uncompressed file once loaded
+    const LoadedScene scene = makeScene();
+    const std::vector<std::uint8_t> uncompressedBytes = writeAsCookedModel(scene);
+    const std::vector<std::uint8_t> compressedBytes = writeAsCookedModel(scene, { .compress = true });
+    EXPECT_EQ(writeAsCookedModel(scene, { .compress = true }), compressedBytes);
+
+    const LoadedScene loaded = CookedModelLoader{}.load(compressedBytes, {}, "compressed.cmodel");
+    EXPECT_EQ(writeAsCookedModel(loaded), uncompressedBytes);
+    EXPECT_EQ(writeAsCookedModel(loaded, { .compress = true }), compressedBytes);
+
+    // large, regular meshes are where compression matters
+    LoadedScene grid;
+    LoadedPrimitive& primitive = grid.primitives.emplace_back();
+    constexpr std::uint32_t GridSize = 64;
+    for(std::uint32_t y = 0; y < GridSize; y++) {
+        for(std::uint32_t x = 0; x < GridSize; x++) {
+            Carrot::Vertex vertex = makeVertex(0.0f);
+            vertex.pos = glm::vec4 { x, y, 0.0f, 1.0f };
+            vertex.uv = glm::vec2 { x, y } / static_cast<float>(GridSize);
+            primitive.vertices.emplace_back(vertex);
+            if(x + 1 < GridSize && y + 1 < GridSize) {
+                const std::uint32_t i = y * GridSize + x;
+                primitive.indices.insert(primitive.indices.end(), { i, i + 1, i + GridSize, i + GridSize, i + 1, i + GridSize + 1 });
+            }
+        }
+    }
+    primitive.meshletVertexIndices = primitive.indices;
+    primitive.meshletIndices = primitive.indices;
+    const std::vector<std::uint8_t> uncompressedGrid = writeAsCookedModel(grid);
+    const std::vector<std::uint8_t> compressedGrid = writeAsCookedModel(grid, { .compress = true });
+    EXPECT_LT(compressedGrid.size(), uncompressedGrid.size());
+    EXPECT_EQ(writeAsCookedModel(CookedModelLoader{}.load(compressedGrid, {}, "grid.cmodel")), uncompressedGrid);
+
+    // corrupted compressed sections must not be decoded past their end
+    for(std::size_t size : { compressedGrid.size() / 2, compressedGrid.size() - 1 }) {
+        const std::span<const std::uint8_t> truncated { compressedGrid.data(), size };
+        EXPECT_THROW(CookedModelLoader{}.load(truncated, {}, "truncated.cmodel"), std::invalid_argument) << size;
+    }
+}
+
+TEST(CookedModels, QuantizedVertices) {
+    const LoadedScene scene = makeScene();
+    for(const bool compress : { false, true }) {
+        const CookedModelOptions options { .quantizeVertices = true, .compress = compress };
+        const std::vector<std::uint8_t> bytes = writeAsCookedModel(scene, options);
+        EXPECT_LT(bytes.size(), writeAsCookedModel(scene, { .compress = compress }).size());
+
+        const LoadedScene loaded = CookedModelLoader{}.load(bytes, {}, "quantized.cmodel");
+        ASSERT_EQ(loaded.primitives.size(), scene.primitives.size());
+        for(std::size_t i = 0; i < scene.primitives.size(); i++) {
+            const LoadedPrimitive& expected = scene.primitives[i];
+            const LoadedPrimitive& primitive = loaded.primitives[i];
+            // only vertices are quantized
+            EXPECT_EQ(primitive.indices, expected.indices);
+            EXPECT_EQ(primitive.meshletIndices, expected.meshletIndices);
+            EXPECT_EQ(primitive.minPos, expected.minPos);
+            EXPECT_EQ(primitive.maxPos, expected.maxPos);
+
+            auto expectClose = [](const Carrot::Vertex& a, const Carrot::Vertex& b) {
+                for(int c = 0; c < 4; c++) {
+                    EXPECT_NEAR(a.pos[c], b.pos[c], 1e-3f);
+                    EXPECT_NEAR(a.tangent[c], b.tangent[c], 1e-3f);
+                }
+                for(int c = 0; c < 3; c++) {
+                    EXPECT_NEAR(a.color[c], b.color[c], 1.0f / 255.0f);
+                    EXPECT_NEAR(a.normal[c], b.normal[c], 1e-3f);
+                }
+                for(int c = 0; c < 2; c++) {
+                    EXPECT_NEAR(a.uv[c], b.uv[c], 1e-4f);
+                }
+            };
+            ASSERT_EQ(primitive.vertices.size(), expected.vertices.size());
+            for(std::size_t v = 0; v < expected.vertices.size(); v++) {
+                expectClose(primitive.vertices[v], expected.vertices[v]);
+            }
+            ASSERT_EQ(primitive.skinnedVertices.size(), expected.skinnedVertices.size());
+            for(std::size_t v = 0; v < expected.skinnedVertices.size(); v++) {
+                expectClose(primitive.skinnedVertices[v], expected.skinnedVertices[v]);
+                EXPECT_EQ(primitive.skinnedVertices[v].boneIDs, expected.skinnedVertices[v].boneIDs);
+                for(int b = 0; b < 4; b++) {
+                    EXPECT_NEAR(primitive.skinnedVertices[v].boneWeights[b], expected.skinnedVertices[v].boneWeights[b], 2.0f / 255.0f);
+                }
+            }
+        }
+
+        // quantizing again what was already quantized gives the same file
+        EXPECT_EQ(writeAsCookedModel(loaded, options), bytes);
+    }
+}
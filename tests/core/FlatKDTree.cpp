@@ -0,0 +1,186 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <core/containers/FlatKDTree.hpp>
+#include <core/tasks/TaskScheduler.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <glm/gtx/norm.hpp>
+
+using namespace Carrot;
+
+struct Point {
+    glm::vec3 position;
+
+    glm::vec3 getPosition() const {
+        return position;
+    }
+};
+
+static std::vector<Point> makePoints(std::size_t count, std::uint32_t seed) {
+    std::mt19937 rng { seed };
+    std::uniform_real_distribution<float> distribution { -100.0f, 100.0f };
+    std::vector<Point> points;
+    points.reserve(count);
+    for(std::size_t i = 0; i < count; i++) {
+        points.push_back(Point { glm::vec3 { distribution(rng), distribution(rng), distribution(rng) } });
+    }
+    return points;
+}
+
+static std::int64_t bruteForceClosest(std::span<const Point> points, const glm::vec3& from) {
+    std::int64_t best = -1;
+    float bestDistance = INFINITY;
+    for(std::size_t i = 0; i < points.size(); i++) {
+        const float d = glm::distance2(points[i].position, from);
+        if(d < bestDistance) {
+            bestDistance = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+static std::vector<std::size_t> sorted(const Vector<std::size_t>& v) {
+    std::vector<std::size_t> result { v.cdata(), v.cdata() + v.size() };
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST(FlatKDTree, Empty) {
+    FlatKDTree<Point> tree;
+    tree.build({});
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.closestNeighbor(glm::vec3{0.0f}), FlatKDTree<Point>::NoNeighbor);
+
+    Vector<std::size_t> out;
+    tree.kNearest(out, glm::vec3{0.0f}, 4);
+    tree.rangeSearch(out, glm::vec3{-INFINITY}, glm::vec3{+INFINITY});
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(FlatKDTree, ClosestNeighbor) {
+    for(std::size_t count : { 1, 7, 16, 17, 1000 }) {
+        auto points = makePoints(count, count);
+        FlatKDTree<Point> tree { Allocator::getDefault(), points };
+        EXPECT_EQ(tree.size(), count);
+
+        auto queries = makePoints(200, 42);
+        for(const Point& query : queries) {
+            EXPECT_EQ(tree.closestNeighbor(query), bruteForceClosest(points, query.position));
+        }
+        EXPECT_EQ(tree.closestNeighbor(points[0]), 0);
+    }
+}
+
+TEST(FlatKDTree, MaxDistance) {
+    std::vector<Point> points { Point { glm::vec3 { 10.0f, 0.0f, 0.0f } } };
+    FlatKDTree<Point> tree { Allocator::getDefault(), points };
+    EXPECT_EQ(tree.closestNeighbor(glm::vec3{0.0f}, 5.0f), FlatKDTree<Point>::NoNeighbor);
+    EXPECT_EQ(tree.closestNeighbor(glm::vec3{0.0f}, 11.0f), 0);
+
+    Vector<std::size_t> out;
+    tree.kNearest(out, glm::vec3{0.0f}, 3, 5.0f);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(FlatKDTree, KNearest) {
+    auto points = makePoints(2000, 1);
+    FlatKDTree<Point> tree { Allocator::getDefault(), points };
+
+    auto queries = makePoints(50, 2);
+    for(const Point& query : queries) {
+        std::vector<std::size_t> expected(points.size());
+        std::iota(expected.begin(), expected.end(), 0);
+        std::sort(expected.begin(), expected.end(), [&](std::size_t a, std::size_t b) {
+            return glm::distance2(points[a].position, query.position) < glm::distance2(points[b].position, query.position);
+        });
+
+        Vector<std::size_t> out;
+        tree.kNearest(out, query.position, 10);
+        ASSERT_EQ(out.size(), 10);
+        for(std::size_t i = 0; i < 10; i++) {
+            EXPECT_EQ(out[i], expected[i]);
+        }
+    }
+
+    Vector<std::size_t> all;
+    tree.kNearest(all, glm::vec3{0.0f}, points.size() * 2);
+    EXPECT_EQ(all.size(), points.size());
+}
+
+TEST(FlatKDTree, RangeSearchAndNeighbors) {
+    auto points = makePoints(3000, 3);
+    FlatKDTree<Point> tree { Allocator::getDefault(), points };
+
+    const glm::vec3 min { -20.0f, -50.0f, 0.0f };
+    const glm::vec3 max { 30.0f, 10.0f, 40.0f };
+    const glm::vec3 center { 5.0f, -5.0f, 10.0f };
+    const float radius = 25.0f;
+    std::vector<std::size_t> expectedInRange;
+    std::vector<std::size_t> expectedNeighbors;
+    for(std::size_t i = 0; i < points.size(); i++) {
+        const glm::vec3& p = points[i].position;
+        if(glm::all(glm::greaterThanEqual(p, min)) && glm::all(glm::lessThan(p, max))) {
+            expectedInRange.push_back(i);
+        }
+        if(glm::distance2(p, center) <= radius * radius) {
+            expectedNeighbors.push_back(i);
+        }
+    }
+
+    Vector<std::size_t> inRange;
+    tree.rangeSearch(inRange, min, max);
+    EXPECT_EQ(sorted(inRange), expectedInRange);
+
+    Vector<std::size_t> neighbors;
+    tree.getNeighbors(neighbors, center, radius);
+    EXPECT_EQ(sorted(neighbors), expectedNeighbors);
+
+    Vector<std::size_t> everything;
+    tree.getNeighbors(everything, center, INFINITY);
+    EXPECT_EQ(everything.size(), points.size());
+}
+
+TEST(FlatKDTree, BatchedQueries) {
+    auto points = makePoints(5000, 4);
+    auto queries = makePoints(5000, 5);
+    std::vector<glm::vec3> positions;
+    for(const Point& query : queries) {
+        positions.push_back(query.position);
+    }
+
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 1,
+    } };
+    scheduler.bindAsyncParallelFor();
+
+    FlatKDTree<Point> tree { Allocator::getDefault(), points };
+    std::vector<std::int64_t> closest(positions.size());
+    tree.closestNeighbors(closest, positions);
+    for(std::size_t i = 0; i < positions.size(); i++) {
+        EXPECT_EQ(closest[i], tree.closestNeighbor(positions[i]));
+    }
+
+    std::vector<glm::vec3> mins;
+    std::vector<glm::vec3> maxs;
+    for(std::size_t i = 0; i < 100; i++) {
+        mins.push_back(positions[i] - glm::vec3(10.0f));
+        maxs.push_back(positions[i] + glm::vec3(10.0f));
+    }
+    Vector<std::size_t> indices;
+    Vector<std::size_t> offsets;
+    tree.rangeSearches(indices, offsets, mins, maxs);
+    ASSERT_EQ(offsets.size(), mins.size() + 1);
+    for(std::size_t i = 0; i < mins.size(); i++) {
+        Vector<std::size_t> expected;
+        tree.rangeSearch(expected, mins[i], maxs[i]);
+        ASSERT_EQ(offsets[i + 1] - offsets[i], expected.size());
+        for(std::size_t j = 0; j < expected.size(); j++) {
+            EXPECT_EQ(indices[offsets[i] + j], expected[j]);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <core/functional/InlineFunction.hpp>
+
+using namespace Carrot;
+
+TEST(InlineFunction, Empty) {
+    InlineFunction<void()> f;
+    EXPECT_FALSE(f);
+
+    std::function<void()> emptyStd;
+    InlineFunction<void()> fromEmptyStd = emptyStd;
+    EXPECT_FALSE(fromEmptyStd);
+
+    InlineFunction<void()> g = []() {};
+    EXPECT_TRUE(g);
+    g = nullptr;
+    EXPECT_FALSE(g);
+}
+
+TEST(InlineFunction, ArgumentsAndReturn) {
+    InlineFunction<int(int, int&)> f = [](int a, int& out) {
+        out = a * 2;
+        return a + 1;
+    };
+    int out = 0;
+    EXPECT_EQ(f(20, out), 21);
+    EXPECT_EQ(out, 40);
+}
+
+TEST(InlineFunction, SmallCallablesAreInline) {
+    struct Small { void* a; void* b; std::size_t c; void operator()() const {} };
+    struct Large { std::array<char, 256> data; void operator()() const {} };
+    EXPECT_TRUE(InlineFunction<void()>::StoresInline<Small>);
+    EXPECT_FALSE(InlineFunction<void()>::StoresInline<Large>);
+}
+
+TEST(InlineFunction, CopyMoveAndDestroy) {
+    auto shared = std::make_shared<int>(42);
+    std::array<char, 128> padding{}; // forces heap storage
+
+    for(bool large : { false, true }) {
+        {
+            InlineFunction<int()> f;
+            if(large) {
+                f = [shared, padding]() { return *shared + padding[0]; };
+            } else {
+                f = [shared]() { return *shared; };
+            }
+            EXPECT_EQ(shared.use_count(), 2);
+
+            InlineFunction<int()> copy = f;
+            EXPECT_EQ(shared.use_count(), 3);
+            EXPECT_EQ(copy(), 42);
+
+            InlineFunction<int()> moved = std::move(f);
+            EXPECT_FALSE(f);
+            EXPECT_EQ(shared.use_count(), 3);
+            EXPECT_EQ(moved(), 42);
+
+            copy = moved;
+            EXPECT_EQ(shared.use_count(), 3);
+        }
+        EXPECT_EQ(shared.use_count(), 1);
+    }
+}
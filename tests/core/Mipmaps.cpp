@@ -0,0 +1,211 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <core/render/Mipmaps.h>
+#include <core/tasks/TaskScheduler.h>
+#include <cmath>
+#include <random>
+#include <glm/gtc/constants.hpp>
+
+using namespace Carrot;
+using namespace Carrot::Mipmaps;
+
+static PlanarImage makeRandomImage(std::uint32_t width, std::uint32_t height, std::uint32_t channelCount, std::uint32_t seed) {
+    std::mt19937 rng { seed };
+    std::uniform_real_distribution<float> distribution { 0.0f, 1.0f };
+    PlanarImage image;
+    image.resize(width, height, channelCount);
+    for(std::size_t i = 0; i < image.texels.size(); i++) {
+        image.texels[i] = distribution(rng);
+    }
+    return image;
+}
+
+TEST(Mipmaps, SRGBRoundTrip) {
+    std::vector<std::uint8_t> texels(256);
+    for(std::size_t i = 0; i < texels.size(); i++) {
+        texels[i] = static_cast<std::uint8_t>(i);
+    }
+
+    PlanarImage image;
+    decode(texels, 256, 1, 1, 0b1, image);
+    EXPECT_NEAR(image.texels[128], std::pow((128.0 / 255.0 + 0.055) / 1.055, 2.4), 1e-6);
+
+    std::vector<std::uint8_t> encoded(256);
+    encode(image, 0b1, encoded);
+    EXPECT_EQ(encoded, texels);
+
+    // compare with the exact conversion over the whole range
+    for(std::size_t i = 0; i <= 10000; i++) {
+        image.texels[i % 256] = i / 10000.0f;
+        encode(image, 0b1, encoded);
+        const double linear = i / 10000.0;
+        const double exact = (linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055) * 255.0;
+        EXPECT_LE(std::abs(encoded[i % 256] - exact), 0.5 + 1e-3) << "linear value " << linear;
+    }
+}
+
+TEST(Mipmaps, GammaCorrectAverage) {
+    // black and white checkerboard: half the light, which is not 128 in sRGB
+    const std::vector<std::uint8_t> texels = { 0, 255, 255, 0 };
+    PlanarImage image;
+    decode(texels, 2, 2, 1, 0b1, image);
+
+    PlanarImage mip;
+    mip.resize(1, 1, 1);
+    resample(image, mip, Filter::Box);
+    EXPECT_NEAR(mip.texels[0], 0.5f, 1e-6f);
+
+    std::uint8_t encoded = 0;
+    encode(mip, 0b1, std::span { &encoded, 1 });
+    EXPECT_EQ(encoded, 188);
+
+    // linear channels are averaged as is
+    encode(mip, 0b0, std::span { &encoded, 1 });
+    EXPECT_EQ(encoded, 128);
+}
+
+TEST(Mipmaps, BoxIsAverageOf2x2) {
+    const PlanarImage image = makeRandomImage(8, 6, 2, 1);
+    PlanarImage mip;
+    mip.resize(4, 3, 2);
+    resample(image, mip, Filter::Box);
+
+    for(std::uint32_t channel = 0; channel < 2; channel++) {
+        std::span<const float> source = image.getPlane(channel);
+        std::span<const float> result = mip.getPlane(channel);
+        for(std::uint32_t y = 0; y < 3; y++) {
+            for(std::uint32_t x = 0; x < 4; x++) {
+                const float average = (source[(2 * y) * 8 + 2 * x] + source[(2 * y) * 8 + 2 * x + 1]
+                                     + source[(2 * y + 1) * 8 + 2 * x] + source[(2 * y + 1) * 8 + 2 * x + 1]) / 4.0f;
+                EXPECT_NEAR(result[y * 4 + x], average, 1e-5f);
+            }
+        }
+    }
+}
+
+TEST(Mipmaps, ConstantImagesStayConstant) {
+    // weights are normalized, edges are clamped: whatever the filter and the size, a constant image stays constant
+    for(const Filter filter : { Filter::Box, Filter::Kaiser, Filter::Lanczos }) {
+        PlanarImage image;
+        image.resize(37, 23, 1);
+        image.texels.fill(0.25f);
+
+        std::uint32_t lastLevel = 0;
+        generateMipChain(image, 6, MipChainSettings { .filter = filter }, [&](std::uint32_t mipLevel, const PlanarImage& mip) {
+            EXPECT_EQ(mip.width, std::max(1u, 37u >> mipLevel));
+            EXPECT_EQ(mip.height, std::max(1u, 23u >> mipLevel));
+            for(std::size_t i = 0; i < mip.texels.size(); i++) {
+                EXPECT_NEAR(mip.texels[i], 0.25f, 1e-5f);
+            }
+            lastLevel = mipLevel;
+        });
+        EXPECT_EQ(lastLevel, 5);
+    }
+}
+
+TEST(Mipmaps, SharperFiltersKeepMoreContrast) {
+    // a sine wave of period 8 texels: lowpass filters all keep it at mip 1, Box attenuates it the most
+    PlanarImage image;
+    image.resize(64, 64, 1);
+    for(std::uint32_t y = 0; y < 64; y++) {
+        for(std::uint32_t x = 0; x < 64; x++) {
+            image.texels[y * 64 + x] = 0.5f + 0.4f * std::sin(x * glm::two_pi<float>() / 8.0f);
+        }
+    }
+
+    auto computeAmplitude = [&](Filter filter) {
+        PlanarImage mip;
+        mip.resize(32, 32, 1);
+        resample(image, mip, filter);
+        float minValue = 1.0f;
+        float maxValue = 0.0f;
+        for(std::uint32_t x = 4; x < 28; x++) { // away from the borders
+            minValue = std::min(minValue, mip.texels[16 * 32 + x]);
+            maxValue = std::max(maxValue, mip.texels[16 * 32 + x]);
+        }
+        return (maxValue - minValue) / 2.0f;
+    };
+
+    const float box = computeAmplitude(Filter::Box);
+    EXPECT_GT(computeAmplitude(Filter::Kaiser), box);
+    EXPECT_GT(computeAmplitude(Filter::Lanczos), box);
+    EXPECT_LT(computeAmplitude(Filter::Lanczos), 0.41f);
+}
+
+TEST(Mipmaps, AlphaCoverage) {
+    // thin alpha-tested strands: about 30% of the texels pass the test
+    PlanarImage image;
+    image.resize(128, 128, 4);
+    image.texels.fill(0.0f);
+    std::span<float> alpha = image.getPlane(3);
+    std::mt19937 rng { 7 };
+    std::uniform_real_distribution<float> distribution { 0.0f, 1.0f };
+    for(float& value : alpha) {
+        value = distribution(rng) < 0.3f ? 1.0f : 0.1f;
+    }
+    const float coverage = computeAlphaCoverage(alpha, 0.5f);
+    ASSERT_NEAR(coverage, 0.3f, 0.02f);
+
+    for(const bool preserve : { false, true }) {
+        const MipChainSettings settings {
+            .filter = Filter::Box,
+            .preserveAlphaCoverage = preserve,
+        };
+        float mip3Coverage = 0.0f;
+        generateMipChain(image, 4, settings, [&](std::uint32_t mipLevel, const PlanarImage& mip) {
+            if(mipLevel == 3) {
+                mip3Coverage = computeAlphaCoverage(mip.getPlane(3), settings.alphaCutoff);
+            }
+        });
+
+        if(preserve) {
+            EXPECT_NEAR(mip3Coverage, coverage, 0.05f);
+        } else {
+            // averages of 64 texels are all close to 0.37: nothing passes the test anymore
+            EXPECT_LT(mip3Coverage, 0.05f);
+        }
+    }
+}
+
+TEST(Mipmaps, Halves) {
+    const std::vector<float> values = { 0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, 0.333251953125f, 1024.0f, -0.25f, 3.0f, 7.5f, 0.125f };
+    std::vector<std::uint16_t> halves(values.size());
+    floatsToHalves(values, halves);
+    EXPECT_EQ(halves[0], 0x0000);
+    EXPECT_EQ(halves[1], 0x3C00);
+    EXPECT_EQ(halves[2], 0xC000);
+    EXPECT_EQ(halves[4], 0x7BFF);
+
+    std::vector<float> roundTrip(values.size());
+    halvesToFloats(halves, roundTrip);
+    EXPECT_EQ(roundTrip, values);
+
+    PlanarImage image;
+    image.resize(3, 1, 2);
+    image.texels = { 1.0f, 2.0f, 3.0f, -1.0f, -2.0f, -3.0f };
+    std::vector<std::uint16_t> interleaved(6);
+    encodeHalf(image, interleaved);
+    std::vector<float> decoded(6);
+    halvesToFloats(interleaved, decoded);
+    EXPECT_EQ(decoded, (std::vector<float> { 1.0f, -1.0f, 2.0f, -2.0f, 3.0f, -3.0f }));
+}
+
+TEST(Mipmaps, ParallelMatchesSerial) {
+    const PlanarImage image = makeRandomImage(301, 157, 3, 2);
+    PlanarImage serial;
+    serial.resize(150, 78, 3);
+    resample(image, serial, Filter::Lanczos);
+
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 0,
+    } };
+    scheduler.bindAsyncParallelFor();
+    PlanarImage parallel;
+    parallel.resize(150, 78, 3);
+    resample(image, parallel, Filter::Lanczos);
+    EXPECT_EQ(serial.texels, parallel.texels);
+}
@@ -0,0 +1,203 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <core/async/ParallelMap.hpp>
+
+using namespace Carrot;
+
+TEST(ParallelMap, GetOrComputeOnlyComputesOnce) {
+    Async::ParallelMap<std::string, int> map;
+    int calls = 0;
+    int& value = map.getOrCompute("a", [&]() { calls++; return 1; });
+    int& sameValue = map.getOrCompute("a", [&]() { calls++; return 2; });
+    EXPECT_EQ(&value, &sameValue);
+    EXPECT_EQ(value, 1);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ParallelMap, FindReplaceRemove) {
+    Async::ParallelMap<int, std::string> map;
+    EXPECT_EQ(map.find(1), nullptr);
+
+    map.replace(1, "one");
+    ASSERT_NE(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(1), "one");
+
+    EXPECT_TRUE(map.remove(1));
+    EXPECT_EQ(map.find(1), nullptr);
+    EXPECT_FALSE(map.remove(1));
+    EXPECT_FALSE(map.remove(2));
+
+    EXPECT_EQ(map.getOrCompute(1, []() { return std::string("uno"); }), "uno");
+}
+
+TEST(ParallelMap, ManyKeys) {
+    Async::ParallelMap<std::uint64_t, std::uint64_t> map;
+    constexpr std::uint64_t KeyCount = 100'000;
+    for(std::uint64_t i = 0; i < KeyCount; i++) {
+        map.getOrCompute(i * 256 /* aligned addresses, like buffer addresses */, [i]() { return i; });
+    }
+    for(std::uint64_t i = 0; i < KeyCount; i++) {
+        const std::uint64_t* pValue = map.find(i * 256);
+        ASSERT_NE(pValue, nullptr);
+        ASSERT_EQ(*pValue, i);
+    }
+    EXPECT_EQ(map.snapshot().size(), KeyCount);
+}
+
+TEST(ParallelMap, SnapshotSeesKeysPresentAtCreation) {
+    Async::ParallelMap<int, int> map;
+    for(int i = 0; i < 10; i++) {
+        map.replace(i, i * 10);
+    }
+    auto snapshot = map.snapshot();
+    map.replace(100, 1000); // added after the snapshot
+    map.remove(3); // removed after the snapshot
+
+    std::set<int> keys;
+    for(auto& [key, pValue] : snapshot) {
+        EXPECT_EQ(*pValue, key * 10);
+        keys.insert(key);
+    }
+    EXPECT_EQ(keys.size(), 9u);
+    EXPECT_FALSE(keys.contains(3));
+    EXPECT_FALSE(keys.contains(100));
+    EXPECT_EQ(map.snapshot().size(), 10u);
+
+    map.clear();
+    EXPECT_EQ(map.snapshot().size(), 0u);
+    EXPECT_EQ(map.find(1), nullptr);
+}
+
+TEST(ParallelMap, ConcurrentGetOrCompute) {
+    constexpr int ThreadCount = 8;
+    constexpr int KeyCount = 10'000;
+    Async::ParallelMap<int, int> map;
+    std::vector<std::atomic<int>> computations(KeyCount);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < ThreadCount; t++) {
+        threads.emplace_back([&, t]() {
+            for(int i = 0; i < KeyCount; i++) {
+                const int key = (i + t * 997) % KeyCount; // threads start at different keys, but all collide eventually
+                const int& value = map.getOrCompute(key, [&]() {
+                    computations[key]++;
+                    return key * 2;
+                });
+                ASSERT_EQ(value, key * 2);
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    for(int i = 0; i < KeyCount; i++) {
+        ASSERT_EQ(computations[i].load(), 1) << "Key " << i;
+    }
+}
+
+TEST(ParallelMap, ReplaceWhileReading) {
+    constexpr int ReaderCount = 6;
+    constexpr int WriterCount = 2;
+    constexpr int KeyCount = 16;
+    constexpr int Replacements = 20'000;
+    Async::ParallelMap<int, std::string> map;
+    // values are long enough to be heap-allocated, and made of a single repeated character
+    auto makeValue = [](int version) {
+        return std::string(64, static_cast<char>('a' + version % 26));
+    };
+    for(int key = 0; key < KeyCount; key++) {
+        map.replace(key, makeValue(0));
+    }
+
+    std::atomic<bool> done = false;
+    std::atomic<int> corruptedReads = 0;
+    auto isValid = [](const std::string& value) {
+        return value.size() == 64 && std::all_of(value.begin(), value.end(), [&](char c) { return c == value[0]; });
+    };
+
+    std::vector<std::thread> threads;
+    for(int r = 0; r < ReaderCount; r++) {
+        threads.emplace_back([&, r]() {
+            for(int i = r; !done.load(); i++) {
+                const int key = i % KeyCount;
+                map.read(key, [&](const std::string& value) {
+                    if(!isValid(value)) {
+                        corruptedReads++;
+                    }
+                });
+                for(const auto& [snapshotKey, pValue] : map.snapshot()) {
+                    if(!isValid(*pValue)) {
+                        corruptedReads++;
+                    }
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for(int w = 0; w < WriterCount; w++) {
+        writers.emplace_back([&, w]() {
+            for(int i = 0; i < Replacements; i++) {
+                const int key = (i + w) % KeyCount;
+                if(i % 7 == 0) {
+                    map.remove(key);
+                }
+                map.replace(key, makeValue(i));
+            }
+        });
+    }
+    for(auto& t : writers) {
+        t.join();
+    }
+    done = true;
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(corruptedReads.load(), 0);
+    for(int key = 0; key < KeyCount; key++) {
+        const std::string* pValue = map.find(key);
+        ASSERT_NE(pValue, nullptr);
+        EXPECT_TRUE(isValid(*pValue));
+    }
+}
+
+TEST(ParallelMap, RemovedKeysAreReclaimed) {
+    constexpr int ThreadCount = 4;
+    constexpr int Rounds = 200;
+    constexpr int KeysPerRound = 1000;
+    Async::ParallelMap<int, std::string> map;
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < ThreadCount; t++) {
+        threads.emplace_back([&, t]() {
+            // every round uses new keys, which are removed right after: nodes without value must not accumulate
+            for(int round = 0; round < Rounds; round++) {
+                const int firstKey = (round * ThreadCount + t) * KeysPerRound;
+                for(int i = 0; i < KeysPerRound; i++) {
+                    map.getOrCompute(firstKey + i, [i]() { return std::to_string(i); });
+                }
+                for(int i = 0; i < KeysPerRound; i++) {
+                    ASSERT_TRUE(map.remove(firstKey + i));
+                    ASSERT_EQ(map.find(firstKey + i), nullptr);
+                }
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(map.snapshot().size(), 0u);
+    map.replace(1, "one");
+    ASSERT_NE(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(1), "one");
+}
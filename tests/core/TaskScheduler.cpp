@@ -0,0 +1,190 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+#include <core/tasks/TaskScheduler.h>
+
+using namespace Carrot;
+
+static TaskSchedulerConfig smallConfig(TaskQueueing queueing) {
+    return TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 1,
+        .queueing = queueing,
+    };
+}
+
+class TaskSchedulerTest: public testing::TestWithParam<TaskQueueing> {};
+
+TEST_P(TaskSchedulerTest, ParallelForVisitsEachIndexOnce) {
+    TaskScheduler scheduler { smallConfig(GetParam()) };
+    constexpr std::size_t Count = 10'000;
+    std::vector<std::atomic<int>> visits(Count);
+    scheduler.parallelFor(Count, [&](std::size_t i) {
+        visits[i]++;
+    }, 16);
+
+    for(std::size_t i = 0; i < Count; i++) {
+        ASSERT_EQ(visits[i].load(), 1) << "Index " << i;
+    }
+}
+
+TEST_P(TaskSchedulerTest, NestedParallelFor) {
+    TaskScheduler scheduler { smallConfig(GetParam()) };
+    std::atomic<std::size_t> sum { 0 };
+    scheduler.parallelFor(32, [&](std::size_t outer) {
+        scheduler.parallelFor(100, [&](std::size_t inner) {
+            sum += inner;
+        }, 8);
+    }, 1);
+    EXPECT_EQ(sum.load(), 32u * (99u * 100u / 2u));
+}
+
+TEST_P(TaskSchedulerTest, ScheduleYieldAndJoin) {
+    TaskScheduler scheduler { smallConfig(GetParam()) };
+    constexpr int TaskCount = 64;
+    std::atomic<int> yields { 0 };
+    Async::Counter sync;
+    for(int i = 0; i < TaskCount; i++) {
+        scheduler.schedule(TaskDescription {
+            .name = "Yielding task",
+            .task = [&](TaskHandle& task) {
+                for(int y = 0; y < 10; y++) {
+                    task.yield();
+                    yields++;
+                }
+            },
+            .joiner = &sync,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    while(!sync.isIdle()) {
+        scheduler.stealJobAndRun(TaskScheduler::FrameParallelWork);
+    }
+    EXPECT_EQ(yields.load(), TaskCount * 10);
+}
+
+TEST_P(TaskSchedulerTest, TaskWaitsForDependency) {
+    TaskScheduler scheduler { smallConfig(GetParam()) };
+    Async::Counter dependency;
+    Async::Counter sync;
+    std::atomic<bool> dependencyDone = false;
+    std::atomic<bool> orderRespected = false;
+
+    dependency.increment();
+    scheduler.schedule(TaskDescription {
+        .name = "Dependent task",
+        .task = [&](TaskHandle&) {
+            orderRespected = dependencyDone.load();
+        },
+        .dependency = &dependency,
+        .joiner = &sync,
+    }, TaskScheduler::AssetLoading);
+
+    dependencyDone = true;
+    dependency.decrement();
+    sync.sleepWait();
+    EXPECT_TRUE(orderRespected.load());
+}
+
+TEST_P(TaskSchedulerTest, LeafTasks) {
+    TaskScheduler scheduler { smallConfig(GetParam()) };
+    constexpr int TaskCount = 1000;
+    std::atomic<int> executed { 0 };
+    Async::Counter sync;
+    const std::int64_t fibersBefore = TaskScheduler::collectFrameStats().fibersCreated;
+    for(int i = 0; i < TaskCount; i++) {
+        scheduler.scheduleLeaf(LeafTaskDescription {
+            .name = "Leaf",
+            .task = [&]() {
+                executed++;
+            },
+            .joiner = &sync,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    while(!sync.isIdle()) {
+        scheduler.stealJobAndRun(TaskScheduler::FrameParallelWork);
+    }
+    EXPECT_EQ(executed.load(), TaskCount);
+    EXPECT_EQ(TaskScheduler::collectFrameStats().fibersCreated, fibersBefore);
+}
+
+TEST(TaskScheduler, StackMemoryBudget) {
+    const std::size_t mediumStack = TaskScheduler::getStackBytes(TaskStackSize::Medium);
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 2,
+        .assetLoadingThreads = 0,
+        .fiberStackMemoryBudget = 2 * mediumStack,
+    } };
+
+    // only two fibers fit in the budget, they must be reused
+    constexpr int TaskCount = 64;
+    std::atomic<int> executed { 0 };
+    Async::Counter sync;
+    const std::int64_t fibersBefore = TaskScheduler::collectFrameStats().fibersCreated;
+    for(int i = 0; i < TaskCount; i++) {
+        scheduler.schedule(TaskDescription {
+            .name = "Budgeted task",
+            .task = [&](TaskHandle& task) {
+                task.yield();
+                executed++;
+            },
+            .joiner = &sync,
+            .stackSize = TaskStackSize::Medium,
+        }, TaskScheduler::FrameParallelWork);
+    }
+    sync.sleepWait();
+    EXPECT_EQ(executed.load(), TaskCount);
+    EXPECT_LE(TaskScheduler::collectFrameStats().fibersCreated - fibersBefore, 2);
+
+    // idle fibers of another size are released to make room
+    Async::Counter smallSync;
+    scheduler.schedule(TaskDescription {
+        .name = "Small task",
+        .task = [&](TaskHandle&) {
+            executed++;
+        },
+        .joiner = &smallSync,
+        .stackSize = TaskStackSize::Small,
+    }, TaskScheduler::FrameParallelWork);
+    smallSync.sleepWait();
+    EXPECT_EQ(executed.load(), TaskCount + 1);
+}
+
+TEST(TaskScheduler, ThreadInitCallback) {
+    std::atomic<int> frameThreads { 0 };
+    std::atomic<int> asyncThreads { 0 };
+    {
+        TaskScheduler scheduler { TaskSchedulerConfig {
+            .frameParallelWorkThreads = 3,
+            .assetLoadingThreads = 2,
+            .threadInit = [&](const Async::TaskLane& lane, std::size_t threadIndex) {
+                if(lane == TaskScheduler::FrameParallelWork) {
+                    frameThreads++;
+                } else if(lane == TaskScheduler::AssetLoading) {
+                    asyncThreads++;
+                }
+            },
+        } };
+    } // destructor joins threads
+    EXPECT_EQ(frameThreads.load(), 3);
+    EXPECT_EQ(asyncThreads.load(), 2);
+}
+
+TEST(TaskScheduler, BindAsyncParallelFor) {
+    {
+        TaskScheduler scheduler { smallConfig(TaskQueueing::WorkStealing) };
+        scheduler.bindAsyncParallelFor();
+        ASSERT_NE(Async::parallelFor, nullptr);
+
+        std::atomic<int> count { 0 };
+        Async::parallelFor(100, [&](std::size_t) {
+            count++;
+        }, 4);
+        EXPECT_EQ(count.load(), 100);
+    }
+    EXPECT_EQ(Async::parallelFor, nullptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(Queueing, TaskSchedulerTest, testing::Values(TaskQueueing::SharedQueue, TaskQueueing::WorkStealing));
@@ -0,0 +1,219 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <core/render/VertexQuantization.h>
+#include <cmath>
+#include <random>
+#include <glm/gtc/constants.hpp>
+
+using namespace Carrot;
+using namespace Carrot::VertexQuantization;
+
+static std::vector<Carrot::Vertex> makeRandomVertices(std::size_t count, std::uint32_t seed) {
+    std::mt19937 rng { seed };
+    std::uniform_real_distribution<float> position { -50.0f, 150.0f };
+    std::uniform_real_distribution<float> unit { 0.0f, 1.0f };
+    std::uniform_real_distribution<float> signedUnit { -1.0f, 1.0f };
+    std::uniform_real_distribution<float> uv { -2.0f, 3.0f }; // tiling UVs are outside [0; 1]
+    auto randomDirection = [&]() {
+        glm::vec3 direction;
+        do {
+            direction = glm::vec3 { signedUnit(rng), signedUnit(rng), signedUnit(rng) };
+        } while(glm::length(direction) < 0.01f || glm::length(direction) > 1.0f);
+        return glm::normalize(direction);
+    };
+
+    std::vector<Carrot::Vertex> vertices(count);
+    for(Carrot::Vertex& vertex : vertices) {
+        vertex.pos = glm::vec4 { position(rng), position(rng) * 0.01f, position(rng), 1.0f };
+        vertex.color = glm::vec3 { unit(rng), unit(rng), unit(rng) };
+        vertex.normal = randomDirection();
+        vertex.tangent = glm::vec4 { randomDirection(), unit(rng) < 0.5f ? -1.0f : 1.0f };
+        vertex.uv = glm::vec2 { uv(rng), uv(rng) };
+    }
+    return vertices;
+}
+
+/// More precise than acos(dot) for small angles
+static float angleBetween(const glm::vec3& a, const glm::vec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+/// Largest error of a value quantized to 16 bits over 'extent': half a step, plus some float rounding
+static float quantizationTolerance(float extent) {
+    return extent / 65535.0f * 0.5f * 1.01f + 1e-6f;
+}
+
+TEST(VertexQuantization, Sizes) {
+    EXPECT_EQ(sizeof(QuantizedVertex), 24);
+    EXPECT_EQ(sizeof(QuantizedSkinnedVertex), 32);
+    EXPECT_LT(sizeof(QuantizedVertex) * 3, sizeof(Carrot::Vertex));
+}
+
+TEST(VertexQuantization, Bounds) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(1000, 1);
+    const Bounds bounds = computeBounds(vertices);
+    for(const Carrot::Vertex& vertex : vertices) {
+        for(int i = 0; i < 3; i++) {
+            EXPECT_GE(vertex.pos[i], bounds.positionMin[i]);
+            EXPECT_LE(vertex.pos[i], bounds.positionMin[i] + bounds.positionExtent[i] + 1e-4f);
+        }
+        for(int i = 0; i < 2; i++) {
+            EXPECT_GE(vertex.uv[i], bounds.uvMin[i]);
+            EXPECT_LE(vertex.uv[i], bounds.uvMin[i] + bounds.uvExtent[i] + 1e-6f);
+        }
+    }
+
+    const Bounds empty = computeBounds(std::span<const Carrot::Vertex>{});
+    EXPECT_EQ(empty.positionExtent, glm::vec3 { 0.0f });
+}
+
+TEST(VertexQuantization, Positions) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 2);
+    const Bounds bounds = computeBounds(vertices);
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, bounds), bounds);
+        for(int i = 0; i < 3; i++) {
+            EXPECT_NEAR(decoded.pos[i], vertex.pos[i], quantizationTolerance(bounds.positionExtent[i]));
+        }
+        EXPECT_EQ(decoded.pos.w, 1.0f);
+    }
+
+    // flat meshes have an extent of 0 on one axis
+    std::vector<Carrot::Vertex> flat = makeRandomVertices(100, 3);
+    for(Carrot::Vertex& vertex : flat) {
+        vertex.pos.y = 4.0f;
+    }
+    const Bounds flatBounds = computeBounds(flat);
+    for(const Carrot::Vertex& vertex : flat) {
+        EXPECT_EQ(decode(encode(vertex, flatBounds), flatBounds).pos.y, 4.0f);
+    }
+}
+
+TEST(VertexQuantization, Normals) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 4);
+    const Bounds bounds = computeBounds(vertices);
+    float maxError = 0.0f;
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, bounds), bounds);
+        EXPECT_NEAR(glm::length(decoded.normal), 1.0f, 1e-5f);
+        maxError = std::max(maxError, angleBetween(decoded.normal, vertex.normal));
+    }
+    EXPECT_LT(maxError, glm::radians(0.01f));
+
+    // axes and the folded edges of the octahedron
+    for(const glm::vec3& direction : { glm::vec3 { 1, 0, 0 }, glm::vec3 { -1, 0, 0 }, glm::vec3 { 0, 1, 0 }, glm::vec3 { 0, -1, 0 },
+                                       glm::vec3 { 0, 0, 1 }, glm::vec3 { 0, 0, -1 }, glm::normalize(glm::vec3 { 1, 1, -1 }), glm::normalize(glm::vec3 { -1, 1, -0.001f }) }) {
+        std::int16_t encoded[2];
+        encodeOctahedral(direction, encoded);
+        EXPECT_LT(angleBetween(decodeOctahedral(encoded), direction), glm::radians(0.01f)) << direction.x << " " << direction.y << " " << direction.z;
+    }
+
+    std::int16_t encoded[2];
+    encodeOctahedral(glm::vec3 { 0.0f }, encoded);
+    EXPECT_EQ(decodeOctahedral(encoded), glm::vec3(0, 0, 1));
+}
+
+TEST(VertexQuantization, Tangents) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 5);
+    const Bounds bounds = computeBounds(vertices);
+    float maxError = 0.0f;
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, bounds), bounds);
+        maxError = std::max(maxError, angleBetween(glm::vec3 { decoded.tangent }, glm::vec3 { vertex.tangent }));
+        EXPECT_EQ(decoded.tangent.w, vertex.tangent.w); // bitangent sign is exact
+    }
+    EXPECT_LT(maxError, glm::radians(0.01f));
+}
+
+TEST(VertexQuantization, UVs) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 6);
+    const Bounds bounds = computeBounds(vertices);
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, bounds), bounds);
+        for(int i = 0; i < 2; i++) {
+            EXPECT_NEAR(decoded.uv[i], vertex.uv[i], quantizationTolerance(bounds.uvExtent[i]));
+        }
+    }
+
+    // UVs in [0; 1] are exact at the borders, and texel-accurate for 8k textures
+    Carrot::Vertex vertex = vertices[0];
+    const Bounds unitBounds { .uvMin = glm::vec2 { 0.0f }, .uvExtent = glm::vec2 { 1.0f } };
+    for(const float u : { 0.0f, 1.0f, 0.5f, 1.0f / 8192.0f }) {
+        vertex.uv = glm::vec2 { u, 1.0f - u };
+        const glm::vec2 decodedUV = decode(encode(vertex, unitBounds), unitBounds).uv;
+        EXPECT_NEAR(decodedUV.x, u, 1.0f / 8192.0f / 4.0f);
+        EXPECT_NEAR(decodedUV.y, 1.0f - u, 1.0f / 8192.0f / 4.0f);
+    }
+    vertex.uv = glm::vec2 { 0.0f, 1.0f };
+    EXPECT_EQ(decode(encode(vertex, unitBounds), unitBounds).uv, glm::vec2(0.0f, 1.0f));
+}
+
+TEST(VertexQuantization, Colors) {
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 7);
+    const Bounds bounds = computeBounds(vertices);
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, bounds), bounds);
+        for(int i = 0; i < 3; i++) {
+            EXPECT_NEAR(decoded.color[i], vertex.color[i], 0.5f / 255.0f + 1e-6f);
+        }
+    }
+
+    Carrot::Vertex white = vertices[0];
+    white.color = glm::vec3 { 1.0f };
+    EXPECT_EQ(decode(encode(white, bounds), bounds).color, glm::vec3(1.0f));
+}
+
+TEST(VertexQuantization, BoneWeights) {
+    std::mt19937 rng { 8 };
+    std::uniform_real_distribution<float> unit { 0.0f, 1.0f };
+    std::uniform_int_distribution<int> boneID { 0, 255 };
+    const std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 9);
+    std::vector<Carrot::SkinnedVertex> skinnedVertices(vertices.size());
+    for(std::size_t i = 0; i < vertices.size(); i++) {
+        static_cast<Carrot::Vertex&>(skinnedVertices[i]) = vertices[i];
+        // between 1 and 4 influences, normalized like loaders do
+        const int influences = 1 + static_cast<int>(i % 4);
+        for(int b = 0; b < 4; b++) {
+            skinnedVertices[i].boneWeights[b] = b < influences ? unit(rng) + 0.01f : 0.0f;
+            skinnedVertices[i].boneIDs[b] = static_cast<std::uint8_t>(boneID(rng));
+        }
+        skinnedVertices[i].normalizeWeights();
+    }
+
+    const Bounds bounds = computeBounds(skinnedVertices);
+    for(const Carrot::SkinnedVertex& vertex : skinnedVertices) {
+        const QuantizedSkinnedVertex encoded = encode(vertex, bounds);
+        EXPECT_EQ(encoded.boneWeights[0] + encoded.boneWeights[1] + encoded.boneWeights[2] + encoded.boneWeights[3], 255);
+
+        const Carrot::SkinnedVertex decoded = decode(encoded, bounds);
+        EXPECT_EQ(decoded.boneIDs, vertex.boneIDs);
+        for(int b = 0; b < 4; b++) {
+            // rounding of the other three weights can end up on the largest one
+            EXPECT_NEAR(decoded.boneWeights[b], vertex.boneWeights[b], 2.0f / 255.0f);
+            if(vertex.boneWeights[b] == 0.0f) {
+                EXPECT_EQ(decoded.boneWeights[b], 0.0f);
+            }
+        }
+        EXPECT_NEAR(decoded.boneWeights.x + decoded.boneWeights.y + decoded.boneWeights.z + decoded.boneWeights.w, 1.0f, 1e-5f);
+        EXPECT_NEAR(decoded.pos.x, vertex.pos.x, quantizationTolerance(bounds.positionExtent.x));
+    }
+}
+
+TEST(VertexQuantization, DecodedVerticesAreStable) {
+    // Fertilizer builds clusters and BLASes from decoded vertices: quantizing them again must give the same vertices
+    std::vector<Carrot::Vertex> vertices = makeRandomVertices(10000, 10);
+    const Bounds bounds = computeBounds(vertices);
+    for(Carrot::Vertex& vertex : vertices) {
+        vertex = decode(encode(vertex, bounds), bounds);
+    }
+
+    const Bounds decodedBounds = computeBounds(vertices);
+    for(const Carrot::Vertex& vertex : vertices) {
+        const Carrot::Vertex decoded = decode(encode(vertex, decodedBounds), decodedBounds);
+        EXPECT_EQ(decoded.pos, vertex.pos);
+        EXPECT_EQ(decoded.uv, vertex.uv);
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <core/async/WorkStealingDeque.hpp>
+
+using namespace Carrot::Async;
+
+TEST(WorkStealingDeque, OwnerIsLIFO) {
+    WorkStealingDeque<int> deque;
+    deque.push(1);
+    deque.push(2);
+    deque.push(3);
+    EXPECT_EQ(deque.pop(), 3);
+    EXPECT_EQ(deque.pop(), 2);
+    EXPECT_EQ(deque.pop(), 1);
+    EXPECT_FALSE(deque.pop().has_value());
+}
+
+TEST(WorkStealingDeque, ThievesAreFIFO) {
+    WorkStealingDeque<int> deque;
+    deque.push(1);
+    deque.push(2);
+    deque.push(3);
+    EXPECT_EQ(deque.steal(), 1);
+    EXPECT_EQ(deque.pop(), 3);
+    EXPECT_EQ(deque.steal(), 2);
+    EXPECT_FALSE(deque.steal().has_value());
+    EXPECT_FALSE(deque.pop().has_value());
+}
+
+TEST(WorkStealingDeque, Grows) {
+    WorkStealingDeque<int> deque { 4 };
+    for(int i = 0; i < 1000; i++) {
+        deque.push(i);
+    }
+    EXPECT_EQ(deque.getSizeApprox(), 1000u);
+    for(int i = 0; i < 500; i++) {
+        EXPECT_EQ(deque.steal(), i);
+    }
+    for(int i = 999; i >= 500; i--) {
+        EXPECT_EQ(deque.pop(), i);
+    }
+    EXPECT_EQ(deque.getSizeApprox(), 0u);
+}
+
+TEST(WorkStealingDeque, ConcurrentSteals) {
+    constexpr int ItemCount = 200'000;
+    constexpr int ThiefCount = 4;
+
+    WorkStealingDeque<int> deque { 16 };
+    std::vector<std::atomic<int>> seen(ItemCount);
+    std::atomic<bool> ownerDone = false;
+
+    std::vector<std::thread> thieves;
+    for(int thief = 0; thief < ThiefCount; thief++) {
+        thieves.emplace_back([&]() {
+            while(!ownerDone.load() || deque.getSizeApprox() > 0) {
+                if(std::optional<int> item = deque.steal()) {
+                    seen[*item]++;
+                }
+            }
+        });
+    }
+
+    // the owner pushes everything, popping from time to time to race with thieves on the last elements
+    for(int i = 0; i < ItemCount; i++) {
+        deque.push(i);
+        if(i % 3 == 0) {
+            if(std::optional<int> item = deque.pop()) {
+                seen[*item]++;
+            }
+        }
+    }
+    while(std::optional<int> item = deque.pop()) {
+        seen[*item]++;
+    }
+    ownerDone = true;
+
+    for(auto& t : thieves) {
+        t.join();
+    }
+
+    // each element must have been taken exactly once
+    for(int i = 0; i < ItemCount; i++) {
+        ASSERT_EQ(seen[i].load(), 1) << "Item " << i;
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <engine/pathfinding/AStar.h>
+
+using namespace Carrot::AI;
+
+/// Line of 'count' vertices, each connected to the next one, and a shortcut from the first vertex to the last one which
+/// is more expensive than going through the line
+static AStar<float> makeLine(std::size_t count) {
+    std::vector<float> vertices;
+    std::vector<Edge> edges;
+    for(std::size_t i = 0; i < count; i++) {
+        vertices.push_back(static_cast<float>(i));
+        if(i + 1 < count) {
+            edges.push_back(Edge { i, i + 1 });
+            edges.push_back(Edge { i + 1, i });
+        }
+    }
+    edges.push_back(Edge { 0, count - 1 });
+    return AStar<float> { vertices, edges };
+}
+
+static float distance(float a, float b) {
+    if(std::abs(a - b) > 1.0f) {
+        return 1000.0f; // shortcut
+    }
+    return std::abs(a - b);
+}
+
+TEST(AStar, ShortestPath) {
+    AStar<float> graph = makeLine(10);
+    SearchContext context;
+    ASSERT_TRUE(graph.findPath(context, 0, 9, distance, [](float v) { return 9.0f - v; }));
+    ASSERT_EQ(context.getPath().size(), 10);
+    for(std::size_t i = 0; i < 10; i++) {
+        EXPECT_EQ(context.getPath()[i], i);
+    }
+
+    // context is reused, previous search must not interfere
+    ASSERT_TRUE(graph.findPath(context, 9, 2, distance, [](float v) { return v - 2.0f; }));
+    EXPECT_EQ(context.getPath().size(), 8);
+    EXPECT_EQ(context.getPath().front(), 9);
+    EXPECT_EQ(context.getPath().back(), 2);
+
+    ASSERT_TRUE(graph.findPath(context, 4, 4, distance, [](float v) { return 0.0f; }));
+    EXPECT_EQ(context.getPath().size(), 1);
+
+    EXPECT_EQ(graph.findPath(0, 3, distance, [](float v) { return 3.0f - v; }).size(), 4);
+}
+
+TEST(AStar, NoPath) {
+    std::vector<float> vertices { 0.0f, 1.0f, 2.0f };
+    std::vector<Edge> edges { Edge { 0, 1 }, Edge { 2, 1 } };
+    AStar<float> graph { vertices, edges };
+
+    SearchContext context;
+    EXPECT_FALSE(graph.findPath(context, 0, 2, distance, [](float v) { return 0.0f; }));
+    EXPECT_FALSE(graph.findPath(context, 0, 42, distance, [](float v) { return 0.0f; }));
+    EXPECT_TRUE(graph.findPath(0, 2, distance, [](float v) { return 0.0f; }).empty());
+    EXPECT_TRUE(graph.findPath(context, 2, 1, distance, [](float v) { return 0.0f; }));
+}
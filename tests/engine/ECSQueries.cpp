@@ -0,0 +1,275 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <gtest/gtest.h>
+#include <engine/Engine.h>
+#include <engine/ecs/World.h>
+#include <engine/ecs/systems/System.h>
+#include <engine/ecs/components/TransformComponent.h>
+#include <engine/ecs/components/Kinematics.h>
+
+using namespace Carrot;
+using namespace Carrot::ECS;
+
+#define START_ENGINE()                                      \
+Carrot::Configuration config;                               \
+config.applicationName = __FUNCTION__;                      \
+Carrot::Engine e{ 0, nullptr, config };
+
+/// Records the entities whose transform changed since its previous tick
+struct ChangeRecordingSystem: public LogicSystem<TransformComponent> {
+    std::vector<EntityID> changed;
+
+    explicit ChangeRecordingSystem(World& world): LogicSystem<TransformComponent>(world) {}
+
+    void tick(double dt) override {
+        changed.clear();
+        forEachChangedEntity<TransformComponent>([&](Entity& entity, TransformComponent&) {
+            changed.push_back(entity.getID());
+        });
+    }
+
+    bool hasChanged(const Entity& entity) const {
+        return std::find(changed.begin(), changed.end(), entity.getID()) != changed.end();
+    }
+
+    std::unique_ptr<System> duplicate(World& newOwner) const override {
+        return std::make_unique<ChangeRecordingSystem>(newOwner);
+    }
+
+    const char* getName() const override {
+        return "ChangeRecording";
+    }
+};
+
+/// Records the values of the components it iterates over, to check what systems see after components moved around
+struct ValueRecordingSystem: public LogicSystem<TransformComponent, KinematicsComponent> {
+    std::unordered_map<EntityID, std::pair<float, float>> values; //< position.x and velocity.x of each entity
+
+    explicit ValueRecordingSystem(World& world): LogicSystem<TransformComponent, KinematicsComponent>(world) {}
+
+    void tick(double dt) override {
+        values.clear();
+        forEachEntity([&](Entity& entity, TransformComponent& transform, KinematicsComponent& kinematics) {
+            values[entity.getID()] = { transform.localTransform.position.x, kinematics.velocity.x };
+        });
+    }
+
+    std::unique_ptr<System> duplicate(World& newOwner) const override {
+        return std::make_unique<ValueRecordingSystem>(newOwner);
+    }
+
+    const char* getName() const override {
+        return "ValueRecording";
+    }
+};
+
+static bool containsEntity(std::span<const EntityWithComponents> query, const Entity& entity) {
+    return std::find_if(query.begin(), query.end(), [&](const EntityWithComponents& e) {
+        return e.entity.getID() == entity.getID();
+    }) != query.end();
+}
+
+TEST(ECSQueries, QueriesAreUpdatedInPlace) {
+    START_ENGINE();
+    World world;
+    Entity a = world.newEntity("A");
+    a.addComponent<TransformComponent>();
+    world.tick(0.0);
+
+    EXPECT_EQ(world.queryEntities<TransformComponent>().size(), 1);
+
+    Entity b = world.newEntity("B");
+    b.addComponent<TransformComponent>();
+    Entity c = world.newEntity("C");
+    world.tick(0.0);
+
+    auto query = world.queryEntities<TransformComponent>();
+    EXPECT_EQ(query.size(), 2);
+    EXPECT_TRUE(containsEntity(query, a));
+    EXPECT_TRUE(containsEntity(query, b));
+
+    a.remove();
+    c.addComponent<TransformComponent>();
+    world.tick(0.0);
+
+    query = world.queryEntities<TransformComponent>();
+    EXPECT_EQ(query.size(), 2);
+    EXPECT_TRUE(containsEntity(query, b));
+    EXPECT_TRUE(containsEntity(query, c));
+
+    b.removeComponent<TransformComponent>();
+    world.tick(0.0);
+
+    query = world.queryEntities<TransformComponent>();
+    ASSERT_EQ(query.size(), 1);
+    EXPECT_EQ(query[0].entity.getID(), c.getID());
+    EXPECT_EQ(query[0].components[0], c.getComponent<TransformComponent>().asPtr());
+}
+
+TEST(ECSQueries, ChangeFilters) {
+    START_ENGINE();
+    World world;
+    auto& system = world.addLogicSystem<ChangeRecordingSystem>();
+    Entity a = world.newEntity("A");
+    a.addComponent<TransformComponent>();
+    Entity b = world.newEntity("B");
+    b.addComponent<TransformComponent>();
+
+    // new components are changes
+    world.tick(0.0);
+    EXPECT_TRUE(system.hasChanged(a));
+    EXPECT_TRUE(system.hasChanged(b));
+
+    world.prePhysics(); // first update of the transform hierarchy
+    world.tick(0.0);
+    world.tick(0.0);
+    EXPECT_TRUE(system.changed.empty());
+
+    // transform changes are detected when the transform hierarchy is updated
+    a.getComponent<TransformComponent>()->localTransform.position.x += 1.0f;
+    world.prePhysics();
+    world.tick(0.0);
+    EXPECT_TRUE(system.hasChanged(a));
+    EXPECT_FALSE(system.hasChanged(b));
+
+    world.markComponentChanged(b.getID(), TransformComponent::getID());
+    world.tick(0.0);
+    EXPECT_FALSE(system.hasChanged(a));
+    EXPECT_TRUE(system.hasChanged(b));
+}
+
+TEST(ECSQueries, ComponentsSurviveArchetypeChanges) {
+    START_ENGINE();
+    World world;
+    ASSERT_EQ(world.getComponentStorage(), ComponentStorage::Archetypes);
+    auto& system = world.addLogicSystem<ValueRecordingSystem>();
+
+    std::vector<Entity> entities;
+    for(int i = 0; i < 5; i++) {
+        Entity entity = world.newEntity("Entity " + std::to_string(i));
+        entity.addComponent<TransformComponent>();
+        entity.addComponent<KinematicsComponent>();
+        entity.getComponent<TransformComponent>()->localTransform.position.x = static_cast<float>(i);
+        entity.getComponent<KinematicsComponent>()->velocity.x = static_cast<float>(i * 10);
+        entities.push_back(entity);
+    }
+    world.tick(0.0);
+    ASSERT_EQ(system.values.size(), 5);
+
+    auto checkValues = [&](std::span<const int> withKinematics) {
+        for(int i = 0; i < 5; i++) {
+            EXPECT_EQ(entities[i].getComponent<TransformComponent>()->localTransform.position.x, static_cast<float>(i)) << i;
+            const bool hasKinematics = std::find(withKinematics.begin(), withKinematics.end(), i) != withKinematics.end();
+            EXPECT_EQ(entities[i].getComponent<KinematicsComponent>().hasValue(), hasKinematics) << i;
+            EXPECT_EQ(system.values.contains(entities[i].getID()), hasKinematics) << i;
+            if(hasKinematics) {
+                EXPECT_EQ(entities[i].getComponent<KinematicsComponent>()->velocity.x, static_cast<float>(i * 10)) << i;
+                EXPECT_EQ(system.values[entities[i].getID()].first, static_cast<float>(i)) << i;
+                EXPECT_EQ(system.values[entities[i].getID()].second, static_cast<float>(i * 10)) << i;
+            }
+        }
+    };
+
+    // removing a component moves the entity to another archetype, and the last entity of its chunk into its place
+    entities[1].removeComponent<KinematicsComponent>();
+    entities[2].removeComponent<KinematicsComponent>();
+    world.tick(0.0);
+    checkValues(std::array { 0, 3, 4 });
+
+    // adding a component moves the entity back
+    entities[1].addComponent<KinematicsComponent>();
+    entities[1].getComponent<KinematicsComponent>()->velocity.x = 10.0f;
+    world.tick(0.0);
+    checkValues(std::array { 0, 1, 3, 4 });
+
+    // removed entities leave a hole which is filled by another entity
+    entities[0].remove();
+    world.tick(0.0);
+    EXPECT_EQ(system.values.size(), 3);
+    for(int i : { 1, 3, 4 }) {
+        EXPECT_EQ(system.values[entities[i].getID()].first, static_cast<float>(i)) << i;
+        EXPECT_EQ(system.values[entities[i].getID()].second, static_cast<float>(i * 10)) << i;
+    }
+
+    // pointers given by queries follow the components
+    for(const EntityWithComponents& queried : world.queryEntities<KinematicsComponent>()) {
+        EXPECT_EQ(queried.components[0], world.getComponent<KinematicsComponent>(queried.entity).asPtr());
+    }
+
+    // going back to the per-entity storage keeps the values
+    world.setComponentStorage(ComponentStorage::PerEntityMap);
+    world.tick(0.0);
+    EXPECT_EQ(system.values.size(), 3);
+    EXPECT_EQ(entities[4].getComponent<KinematicsComponent>()->velocity.x, 40.0f);
+    EXPECT_EQ(entities[2].getComponent<TransformComponent>()->localTransform.position.x, 2.0f);
+}
+
+TEST(ECSQueries, LastFrameTransformsIgnoreUpdatesBetweenFrames) {
+    START_ENGINE();
+    World world;
+    Entity parent = world.newEntity("Parent");
+    parent.addComponent<TransformComponent>();
+    Entity child = world.newEntity("Child");
+    child.addComponent<TransformComponent>();
+    child.setParent(parent);
+    world.tick(0.0);
+
+    // World::onFrame needs a renderer, frames are simulated by updating the hierarchy like it does
+    TransformHierarchy& hierarchy = world.getTransformHierarchy();
+    hierarchy.update(true);
+    hierarchy.update(true);
+
+    auto getPositionX = [](const glm::mat4& m) {
+        return m[3][0];
+    };
+
+    // moved during a tick, then the hierarchy is updated by World::prePhysics before the next frame
+    parent.getComponent<TransformComponent>()->localTransform.position.x = 1.0f;
+    child.getComponent<TransformComponent>()->localTransform.position.x = 2.0f;
+    world.tick(0.0);
+    world.prePhysics();
+    EXPECT_EQ(getPositionX(child.getComponent<TransformComponent>()->toTransformMatrix()), 3.0f);
+
+    hierarchy.update(true);
+    EXPECT_EQ(getPositionX(parent.getComponent<TransformComponent>()->toTransformMatrix()), 1.0f);
+    EXPECT_EQ(getPositionX(parent.getComponent<TransformComponent>()->getLastFrameGlobalTransform()), 0.0f);
+    EXPECT_EQ(getPositionX(child.getComponent<TransformComponent>()->toTransformMatrix()), 3.0f);
+    EXPECT_EQ(getPositionX(child.getComponent<TransformComponent>()->getLastFrameGlobalTransform()), 0.0f);
+
+    // not moving anymore: no motion at the next frame
+    world.prePhysics();
+    hierarchy.update(true);
+    EXPECT_EQ(getPositionX(child.getComponent<TransformComponent>()->getLastFrameGlobalTransform()), 3.0f);
+}
+
+TEST(ECSQueries, AncestorChangesAreVisibleBeforeUpdate) {
+    START_ENGINE();
+    World world;
+    Entity grandParent = world.newEntity("GrandParent");
+    grandParent.addComponent<TransformComponent>();
+    Entity parent = world.newEntity("Parent");
+    parent.addComponent<TransformComponent>();
+    parent.setParent(grandParent);
+    Entity child = world.newEntity("Child");
+    child.addComponent<TransformComponent>();
+    child.setParent(parent);
+    world.tick(0.0);
+    world.prePhysics();
+
+    // moved after the last update of the hierarchy: the cached transforms of descendants cannot be used
+    grandParent.getComponent<TransformComponent>()->localTransform.position.x = 1.0f;
+    EXPECT_EQ(child.getComponent<TransformComponent>()->computeFinalPosition().x, 1.0f);
+
+    // the local transform is computed from the current transform of the parent
+    Carrot::Math::Transform globalTransform;
+    globalTransform.position.x = 5.0f;
+    child.getComponent<TransformComponent>()->setGlobalTransform(globalTransform);
+    EXPECT_EQ(child.getComponent<TransformComponent>()->localTransform.position.x, 4.0f);
+
+    world.prePhysics();
+    EXPECT_EQ(child.getComponent<TransformComponent>()->computeFinalPosition().x, 5.0f);
+}
@@ -0,0 +1,160 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <EnvironmentMapProcessing.h>
+#include <core/tasks/TaskScheduler.h>
+#include <glm/gtc/constants.hpp>
+
+using namespace Fertilizer;
+
+static constexpr std::uint32_t FaceSize = 16;
+
+/// Cubemap where each texel has the radiance returned by 'radiance' for its direction
+template<typename Func>
+static Carrot::Mipmaps::PlanarImage makeCubemap(std::uint32_t faceSize, Func&& radiance) {
+    Carrot::Mipmaps::PlanarImage cubemap;
+    cubemap.resize(faceSize, faceSize * 6, 3);
+    for(std::uint32_t face = 0; face < 6; face++) {
+        for(std::uint32_t y = 0; y < faceSize; y++) {
+            for(std::uint32_t x = 0; x < faceSize; x++) {
+                const glm::vec3 direction = getCubemapDirection(face, (x + 0.5f) / faceSize * 2.0f - 1.0f, (y + 0.5f) / faceSize * 2.0f - 1.0f);
+                const glm::vec3 color = radiance(direction);
+                const std::size_t index = (face * faceSize + y) * faceSize + x;
+                for(std::uint32_t c = 0; c < 3; c++) {
+                    cubemap.getPlane(c)[index] = color[c];
+                }
+            }
+        }
+    }
+    return cubemap;
+}
+
+static std::vector<Carrot::Mipmaps::PlanarImage> prefilter(const Carrot::Mipmaps::PlanarImage& cubemap, std::uint32_t mipCount) {
+    const std::vector<Carrot::Mipmaps::PlanarImage> radianceMips = computeCubemapMips(cubemap);
+    std::vector<Carrot::Mipmaps::PlanarImage> specularMips(mipCount);
+    prefilterSpecular(radianceMips, 64, specularMips);
+    return specularMips;
+}
+
+TEST(EnvironmentMaps, CubemapDirections) {
+    // centers of faces point along their axis, in KTX2 order
+    const glm::vec3 expected[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    for(std::uint32_t face = 0; face < 6; face++) {
+        const glm::vec3 direction = getCubemapDirection(face, 0.0f, 0.0f);
+        EXPECT_NEAR(glm::distance(direction, expected[face]), 0.0f, 1e-6f) << "face " << face;
+    }
+    // Vulkan orientation: top of +X is +Y, right of +Z is +X
+    EXPECT_GT(getCubemapDirection(0, 0.0f, -1.0f).y, 0.5f);
+    EXPECT_GT(getCubemapDirection(4, 1.0f, 0.0f).x, 0.5f);
+}
+
+TEST(EnvironmentMaps, ConstantIrradiance) {
+    const glm::vec3 radiance { 1.0f, 0.5f, 0.25f };
+    const IrradianceSH sh = computeIrradianceSH(makeCubemap(FaceSize, [&](const glm::vec3&) { return radiance; }));
+    // irradiance of a uniform environment is pi * L, whatever the normal
+    for(const glm::vec3& normal : { glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::normalize(glm::vec3(-1, 2, -3)) }) {
+        const glm::vec3 irradiance = evaluateIrradianceSH(sh, normal);
+        for(std::uint32_t c = 0; c < 3; c++) {
+            EXPECT_NEAR(irradiance[c], glm::pi<float>() * radiance[c], 1e-3f);
+        }
+    }
+}
+
+TEST(EnvironmentMaps, DirectionalIrradiance) {
+    // radiance = max(0, y): irradiance is 2pi/3 facing up, 0 facing down
+    const IrradianceSH sh = computeIrradianceSH(makeCubemap(32, [](const glm::vec3& direction) {
+        return glm::vec3 { glm::max(0.0f, direction.y) };
+    }));
+    EXPECT_NEAR(evaluateIrradianceSH(sh, glm::vec3(0, 1, 0)).x, 2.0f * glm::pi<float>() / 3.0f, 0.05f * 2.0f * glm::pi<float>() / 3.0f);
+    EXPECT_LT(evaluateIrradianceSH(sh, glm::vec3(0, -1, 0)).x, 0.1f);
+    EXPECT_GT(evaluateIrradianceSH(sh, glm::vec3(0, 1, 0)).x, evaluateIrradianceSH(sh, glm::vec3(1, 0, 0)).x);
+}
+
+TEST(EnvironmentMaps, CubemapMips) {
+    const std::vector<Carrot::Mipmaps::PlanarImage> mips = computeCubemapMips(makeCubemap(FaceSize, [](const glm::vec3& direction) {
+        return glm::vec3 { direction.x > 0 ? 1.0f : 0.0f };
+    }));
+    ASSERT_EQ(mips.size(), 5);
+    EXPECT_EQ(mips.back().width, 1);
+    EXPECT_EQ(mips.back().height, 6);
+    // faces are never mixed together: +X stays bright, -X stays dark
+    EXPECT_FLOAT_EQ(mips.back().getPlane(0)[0], 1.0f);
+    EXPECT_FLOAT_EQ(mips.back().getPlane(0)[1], 0.0f);
+}
+
+TEST(EnvironmentMaps, PrefilteredConstantStaysConstant) {
+    const std::vector<Carrot::Mipmaps::PlanarImage> specularMips = prefilter(makeCubemap(FaceSize, [](const glm::vec3&) { return glm::vec3 { 2.0f }; }), 4);
+    for(std::size_t mip = 0; mip < specularMips.size(); mip++) {
+        EXPECT_EQ(specularMips[mip].width, FaceSize >> mip);
+        for(float value : specularMips[mip].getPlane(1)) {
+            EXPECT_NEAR(value, 2.0f, 1e-4f) << "mip " << mip;
+        }
+    }
+}
+
+TEST(EnvironmentMaps, PrefilteringBlursWithRoughness) {
+    // bright "sun" around +Z
+    const std::vector<Carrot::Mipmaps::PlanarImage> specularMips = prefilter(makeCubemap(FaceSize, [](const glm::vec3& direction) {
+        return glm::vec3 { direction.z > 0.95f ? 100.0f : 0.0f };
+    }), 5);
+
+    // value at the center of +Z, and at the center of +X (90 degrees away)
+    auto sample = [&](std::size_t mip, std::uint32_t face) {
+        const std::uint32_t size = specularMips[mip].width;
+        return specularMips[mip].getPlane(0)[(face * size + size / 2) * size + size / 2];
+    };
+    float previousPeak = sample(0, 4);
+    for(std::size_t mip = 1; mip < specularMips.size(); mip++) {
+        const float peak = sample(mip, 4);
+        EXPECT_LE(peak, previousPeak) << "mip " << mip;
+        previousPeak = peak;
+    }
+    EXPECT_EQ(sample(1, 0), 0.0f); // low roughness: energy stays around the sun
+    EXPECT_GT(sample(4, 0), 0.0f); // roughness 1: energy spreads over the hemisphere
+}
+
+TEST(EnvironmentMaps, BRDFLUT) {
+    constexpr std::uint32_t Size = 16;
+    std::vector<glm::vec2> lut(Size * Size);
+    computeBRDFLUT(Size, 256, lut);
+    for(const glm::vec2& value : lut) {
+        EXPECT_GE(value.x, 0.0f);
+        EXPECT_GE(value.y, 0.0f);
+        EXPECT_LE(value.x + value.y, 1.02f);
+    }
+
+    // smooth surface seen from the front: no energy lost
+    const glm::vec2 smooth = lut[Size - 1];
+    EXPECT_NEAR(smooth.x + smooth.y, 1.0f, 0.02f);
+
+    // rougher surfaces reflect less at grazing angles
+    EXPECT_GT(lut[0].x + lut[0].y, lut[(Size - 1) * Size].x + lut[(Size - 1) * Size].y);
+}
+
+TEST(EnvironmentMaps, ParallelMatchesSerial) {
+    const Carrot::Mipmaps::PlanarImage cubemap = makeCubemap(FaceSize, [](const glm::vec3& direction) {
+        return glm::vec3 { glm::max(0.0f, direction.x), direction.y * direction.y, glm::max(0.0f, -direction.z) * 3.0f };
+    });
+    const std::vector<Carrot::Mipmaps::PlanarImage> serialMips = prefilter(cubemap, 4);
+    std::vector<glm::vec2> serialLUT(8 * 8);
+    computeBRDFLUT(8, 64, serialLUT);
+
+    Carrot::TaskScheduler scheduler { Carrot::TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 0,
+    } };
+    scheduler.bindAsyncParallelFor();
+    const std::vector<Carrot::Mipmaps::PlanarImage> parallelMips = prefilter(cubemap, 4);
+    std::vector<glm::vec2> parallelLUT(8 * 8);
+    computeBRDFLUT(8, 64, parallelLUT);
+
+    for(std::size_t mip = 0; mip < serialMips.size(); mip++) {
+        ASSERT_EQ(serialMips[mip].texels.size(), parallelMips[mip].texels.size());
+        for(std::int64_t i = 0; i < serialMips[mip].texels.size(); i++) {
+            ASSERT_EQ(serialMips[mip].texels[i], parallelMips[mip].texels[i]);
+        }
+    }
+    EXPECT_EQ(serialLUT, parallelLUT);
+}
@@ -0,0 +1,219 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <Fertilizer.h>
+#include <stb_image_write.h>
+
+namespace fs = std::filesystem;
+
+/// Counts of each ConversionStatus during a conversion of a folder
+struct FolderConversionStats {
+    std::size_t converted = 0;
+    std::size_t upToDate = 0;
+    std::size_t restoredFromCache = 0;
+};
+
+class FertilizerCacheTest: public testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / "carrot-test-fertilizer-cache";
+        fs::remove_all(root);
+        fs::create_directories(root / "input" / "nested");
+        writeImage(root / "input" / "a.png", 0);
+        writeImage(root / "input" / "b.png", 1);
+        writeImage(root / "input" / "nested" / "c.png", 2);
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    /// Writes a 16x16 RGBA image, with a pattern depending on 'seed'
+    static void writeImage(const fs::path& path, int seed) {
+        constexpr int Size = 16;
+        std::vector<std::uint8_t> pixels(Size * Size * 4);
+        for(std::size_t i = 0; i < pixels.size(); i++) {
+            pixels[i] = static_cast<std::uint8_t>(i * (seed + 3) + seed * 17);
+        }
+        ASSERT_NE(stbi_write_png(path.string().c_str(), Size, Size, 4, pixels.data(), Size * 4), 0);
+    }
+
+    /// Converts all supported files of 'input' to 'output', like "fertilizer -r"
+    FolderConversionStats convertFolder(const fs::path& input, const fs::path& output, const Fertilizer::AssetCache* pCache) {
+        FolderConversionStats stats;
+        for(const auto& entry : fs::recursive_directory_iterator(input)) {
+            if(!Fertilizer::isSupportedFormat(entry.path())) {
+                continue;
+            }
+            const fs::path outputPath = output / Fertilizer::makeOutputPath(fs::relative(entry.path(), input));
+            const Fertilizer::ConversionResult result = Fertilizer::convert(entry.path(), outputPath, false, pCache);
+            EXPECT_EQ(result.errorCode, Fertilizer::ConversionResultError::Success) << result.errorMessage;
+            switch(result.status) {
+                case Fertilizer::ConversionStatus::Converted:
+                    stats.converted++;
+                    break;
+                case Fertilizer::ConversionStatus::UpToDate:
+                    stats.upToDate++;
+                    break;
+                case Fertilizer::ConversionStatus::RestoredFromCache:
+                    stats.restoredFromCache++;
+                    break;
+            }
+        }
+        return stats;
+    }
+
+    static std::string readAll(const fs::path& path) {
+        std::ifstream file { path, std::ios::binary };
+        return std::string { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    }
+
+    fs::path root;
+};
+
+TEST_F(FertilizerCacheTest, SecondRunDoesNothing) {
+    const fs::path input = root / "input";
+    const fs::path output = root / "output";
+
+    FolderConversionStats stats = convertFolder(input, output, nullptr);
+    EXPECT_EQ(stats.converted, 3u);
+    ASSERT_TRUE(fs::exists(output / "nested" / "c.ktx2"));
+
+    stats = convertFolder(input, output, nullptr);
+    EXPECT_EQ(stats.converted, 0u);
+    EXPECT_EQ(stats.upToDate, 3u);
+
+    // same contents with a different timestamp (checkout, branch switch): nothing to do
+    fs::last_write_time(input / "a.png", fs::last_write_time(input / "a.png") + std::chrono::hours { 1 });
+    stats = convertFolder(input, output, nullptr);
+    EXPECT_EQ(stats.converted, 0u);
+    EXPECT_EQ(stats.upToDate, 3u);
+
+    // different contents
+    writeImage(input / "b.png", 5);
+    stats = convertFolder(input, output, nullptr);
+    EXPECT_EQ(stats.converted, 1u);
+    EXPECT_EQ(stats.upToDate, 2u);
+
+    // outputs deleted behind Fertilizer's back
+    fs::remove(output / "a.ktx2");
+    stats = convertFolder(input, output, nullptr);
+    EXPECT_EQ(stats.converted, 1u);
+}
+
+TEST_F(FertilizerCacheTest, RestoresFromCache) {
+    const fs::path input = root / "input";
+    const Fertilizer::AssetCache cache { root / "cache" };
+
+    FolderConversionStats stats = convertFolder(input, root / "output", &cache);
+    EXPECT_EQ(stats.converted, 3u);
+
+    // fresh checkout: no outputs, but the cache is shared
+    stats = convertFolder(input, root / "other_output", &cache);
+    EXPECT_EQ(stats.converted, 0u);
+    EXPECT_EQ(stats.restoredFromCache, 3u);
+    EXPECT_EQ(readAll(root / "other_output" / "nested" / "c.ktx2"), readAll(root / "output" / "nested" / "c.ktx2"));
+
+    stats = convertFolder(input, root / "other_output", &cache);
+    EXPECT_EQ(stats.upToDate, 3u);
+}
+
+TEST_F(FertilizerCacheTest, GLTFDependencies) {
+    const fs::path model = root / "input" / "model.gltf";
+    {
+        std::ofstream file { model };
+        file << R"({
+            "asset": { "version": "2.0" },
+            "buffers": [ { "uri": "model%20data.bin", "byteLength": 4 }, { "uri": "data:application/octet-stream;base64,AAAA", "byteLength": 3 } ],
+            "images": [ { "uri": "textures/albedo.png" }, { "uri": "a.png" } ]
+        })";
+    }
+    std::ofstream { root / "input" / "model data.bin" } << "1234";
+
+    const std::vector<fs::path> dependencies = Fertilizer::findDependencies(model);
+    ASSERT_EQ(dependencies.size(), 3u);
+    EXPECT_EQ(dependencies[0], (root / "input" / "model data.bin").lexically_normal());
+    EXPECT_EQ(dependencies[1], (root / "input" / "textures" / "albedo.png").lexically_normal()); // missing, but still a dependency
+    EXPECT_EQ(dependencies[2], (root / "input" / "a.png").lexically_normal());
+
+    // the key changes with the contents of dependencies, and when missing dependencies are created
+    std::vector<Fertilizer::InputFileRecord> inputs;
+    const fs::path output = root / "output" / "model.cmodel";
+    const std::uint64_t key = Fertilizer::computeAssetKey(model, output, {}, nullptr, inputs);
+    EXPECT_EQ(inputs.size(), 4u);
+    EXPECT_EQ(Fertilizer::computeAssetKey(model, output, {}, nullptr, inputs), key);
+
+    // outputs converted with other options must not be reused
+    const Fertilizer::ConversionOptions highQuality { .textureQuality = Fertilizer::TextureCompressionQuality::High };
+    EXPECT_NE(Fertilizer::computeAssetKey(model, output, highQuality, nullptr, inputs), key);
+
+    std::ofstream { root / "input" / "model data.bin" } << "5678";
+    const std::uint64_t keyWithNewBuffer = Fertilizer::computeAssetKey(model, output, {}, nullptr, inputs);
+    EXPECT_NE(keyWithNewBuffer, key);
+
+    fs::create_directories(root / "input" / "textures");
+    writeImage(root / "input" / "textures" / "albedo.png", 3);
+    EXPECT_NE(Fertilizer::computeAssetKey(model, output, {}, nullptr, inputs), keyWithNewBuffer);
+}
+
+TEST_F(FertilizerCacheTest, OBJDependenciesChangeWithMaterials) {
+    const fs::path input = root / "input";
+    const fs::path model = input / "model.obj";
+    std::ofstream { model } << "mtllib model.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    std::ofstream { input / "model.mtl" } << "newmtl Material\nmap_Kd a.png\n";
+
+    const fs::path output = root / "output" / "model.cmodel";
+    Fertilizer::AssetManifest previous;
+    previous.key = Fertilizer::computeAssetKey(model, output, {}, nullptr, previous.inputs);
+    ASSERT_EQ(previous.inputs.size(), 3u);
+    EXPECT_EQ(previous.inputs[2].path, (input / "a.png").lexically_normal());
+
+    std::vector<Fertilizer::InputFileRecord> inputs;
+    EXPECT_EQ(Fertilizer::computeAssetKey(model, output, {}, &previous, inputs), previous.key);
+    EXPECT_EQ(inputs.size(), 3u);
+
+    // only the material changes, and references a new texture: the texture must become a dependency
+    std::ofstream { input / "model.mtl" } << "newmtl Material\nmap_Kd a.png\nmap_Bump nested/c.png\n";
+    Fertilizer::AssetManifest withNormalMap;
+    withNormalMap.key = Fertilizer::computeAssetKey(model, output, {}, &previous, withNormalMap.inputs);
+    EXPECT_NE(withNormalMap.key, previous.key);
+    ASSERT_EQ(withNormalMap.inputs.size(), 4u);
+    EXPECT_EQ(withNormalMap.inputs[3].path, (input / "nested" / "c.png").lexically_normal());
+
+    // ...and changes to the new texture change the key
+    writeImage(input / "nested" / "c.png", 7);
+    EXPECT_NE(Fertilizer::computeAssetKey(model, output, {}, &withNormalMap, inputs), withNormalMap.key);
+    EXPECT_EQ(inputs.size(), 4u);
+}
+
+TEST_F(FertilizerCacheTest, NormalMapsOfModels) {
+    const fs::path input = root / "input";
+    std::ofstream { input / "model.gltf" } << R"({
+        "asset": { "version": "2.0" },
+        "images": [ { "uri": "a.png" }, { "uri": "nested/rock%20surface.png" } ],
+        "textures": [ { "source": 0 }, { "source": 1 } ],
+        "materials": [ { "normalTexture": { "index": 1 }, "pbrMetallicRoughness": { "baseColorTexture": { "index": 0 } } }, { "normalTexture": { "index": 5 } } ]
+    })";
+    const std::vector<fs::path> gltfNormalMaps = Fertilizer::findNormalMaps(input / "model.gltf");
+    ASSERT_EQ(gltfNormalMaps.size(), 1u);
+    EXPECT_EQ(gltfNormalMaps[0], (input / "nested" / "rock surface.png").lexically_normal());
+
+    std::ofstream { input / "model.obj" } << "mtllib model.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    std::ofstream { input / "model.mtl" } << "newmtl Material\nmap_Kd a.png\nmap_Bump -bm 1.0 nested/c.png\n";
+    const std::vector<fs::path> objNormalMaps = Fertilizer::findNormalMaps(input / "model.obj");
+    ASSERT_EQ(objNormalMaps.size(), 1u);
+    EXPECT_EQ(objNormalMaps[0], (input / "nested" / "c.png").lexically_normal());
+
+    EXPECT_TRUE(Fertilizer::findNormalMaps(input / "a.png").empty());
+
+    // textures are converted as normal maps when a model uses them as such, whatever their name
+    std::vector<Fertilizer::InputFileRecord> inputs;
+    const fs::path output = root / "output" / "c.ktx2";
+    Fertilizer::ConversionOptions options;
+    const std::uint64_t key = Fertilizer::computeAssetKey(input / "nested" / "c.png", output, options, nullptr, inputs);
+    options.normalMaps.insert(objNormalMaps.begin(), objNormalMaps.end());
+    EXPECT_NE(Fertilizer::computeAssetKey(input / "nested" / "c.png", output, options, nullptr, inputs), key);
+}
@@ -0,0 +1,75 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <random>
+#include <engine/pathfinding/LocalAvoidance.h>
+#include <core/tasks/TaskScheduler.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+class LocalAvoidanceTest: public testing::Test {
+protected:
+    /// Moves the agents towards their goals, and returns the smallest distance between two agents, relative to the sum of their radii
+    float simulate(std::span<AvoidanceAgent> agents, std::span<const glm::vec2> goals, float deltaTime, std::size_t steps) {
+        LocalAvoidance avoidance { scheduler };
+        float minRelativeDistance = INFINITY;
+        for(std::size_t step = 0; step < steps; step++) {
+            for(std::size_t i = 0; i < agents.size(); i++) {
+                const glm::vec2 toGoal = goals[i] - agents[i].position;
+                const float distance = glm::length(toGoal);
+                agents[i].preferredVelocity = distance > agents[i].maxSpeed * deltaTime ? toGoal / distance * agents[i].maxSpeed : toGoal / deltaTime;
+            }
+            avoidance.step(agents, deltaTime);
+
+            for(std::size_t i = 0; i < agents.size(); i++) {
+                for(std::size_t j = i + 1; j < agents.size(); j++) {
+                    const float distance = glm::distance(agents[i].position, agents[j].position);
+                    minRelativeDistance = glm::min(minRelativeDistance, distance / (agents[i].radius + agents[j].radius));
+                }
+            }
+        }
+        return minRelativeDistance;
+    }
+
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 1,
+    } };
+};
+
+TEST_F(LocalAvoidanceTest, HeadOn) {
+    std::array<AvoidanceAgent, 2> agents;
+    agents[0].position = glm::vec2 { -5.0f, 0.0f };
+    agents[1].position = glm::vec2 { 5.0f, 0.0f };
+    const std::array<glm::vec2, 2> goals { agents[1].position, agents[0].position };
+
+    EXPECT_GE(simulate(agents, goals, 0.05f, 400), 0.99f);
+    for(std::size_t i = 0; i < agents.size(); i++) {
+        EXPECT_LT(glm::distance(agents[i].position, goals[i]), 0.05f);
+    }
+}
+
+TEST_F(LocalAvoidanceTest, Crowd) {
+    // agents on a circle, going to the opposite side
+    constexpr std::size_t AgentCount = 100;
+    constexpr float CircleRadius = 20.0f;
+    std::vector<AvoidanceAgent> agents { AgentCount };
+    std::vector<glm::vec2> goals;
+    std::mt19937 rng { 42 };
+    std::uniform_real_distribution<float> radii { 0.3f, 0.5f };
+    for(std::size_t i = 0; i < AgentCount; i++) {
+        const float angle = glm::two_pi<float>() * i / AgentCount;
+        agents[i].position = CircleRadius * glm::vec2 { glm::cos(angle), glm::sin(angle) };
+        agents[i].radius = radii(rng);
+        goals.push_back(-agents[i].position);
+    }
+
+    // the center gets very crowded: velocities are only corrected once per step, so agents can overlap a bit there
+    EXPECT_GE(simulate(agents, goals, 0.02f, 3000), 0.95f);
+    for(std::size_t i = 0; i < agents.size(); i++) {
+        EXPECT_LT(glm::distance(agents[i].position, goals[i]), 0.5f);
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <engine/pathfinding/NavMesh.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+namespace fs = std::filesystem;
+
+static constexpr std::size_t GridSize = 16;
+
+/// Flat grid of GridSize x GridSize cells (2 triangles per cell), with a wall in the middle which has an opening at the top
+static Render::LoadedScene makeGridScene() {
+    Render::LoadedScene scene;
+    auto& primitive = scene.primitives.emplace_back();
+    for(std::size_t y = 0; y <= GridSize; y++) {
+        for(std::size_t x = 0; x <= GridSize; x++) {
+            Carrot::Vertex& v = primitive.vertices.emplace_back();
+            v.pos = glm::vec4 { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f };
+        }
+    }
+
+    auto vertexIndex = [](std::size_t x, std::size_t y) {
+        return static_cast<std::uint32_t>(y * (GridSize + 1) + x);
+    };
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            if(x == GridSize / 2 && y < GridSize - 2) {
+                continue;
+            }
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+            primitive.indices.push_back(vertexIndex(x, y + 1));
+        }
+    }
+    return scene;
+}
+
+static fs::path writeNavMesh(const NavMesh& navMesh, const char* filename) {
+    const fs::path path = fs::temp_directory_path() / filename;
+    fs::remove(path);
+    IO::FileHandle file { path, IO::OpenMode::NewReadWrite };
+    navMesh.serialize(file);
+    return path;
+}
+
+static void expectSamePaths(const NavMesh& expectedMesh, const NavMesh& actualMesh) {
+    for(std::size_t i = 0; i < 16; i++) {
+        const float y = static_cast<float>(i % 8) + 0.25f;
+        const glm::vec3 start { 1.5f, y, 0.0f };
+        const glm::vec3 goal { GridSize - 1.5f, y + 0.5f, 0.0f };
+        const NavPath expected = expectedMesh.computePath(start, goal);
+        const NavPath actual = actualMesh.computePath(start, goal);
+        ASSERT_EQ(actual.waypoints.size(), expected.waypoints.size());
+        for(std::size_t w = 0; w < expected.waypoints.size(); w++) {
+            EXPECT_EQ(actual.waypoints[w], expected.waypoints[w]);
+        }
+    }
+}
+
+TEST(NavMeshFiles, RoundTrip) {
+    NavMesh built;
+    built.loadFromScene(makeGridScene());
+    const fs::path path = writeNavMesh(built, "carrot-test-roundtrip.cnav");
+
+    NavMesh loaded;
+    loaded.loadFromFile(path);
+    EXPECT_EQ(loaded.getTriangleCount(), built.getTriangleCount());
+    EXPECT_FALSE(loaded.hasHierarchy());
+    EXPECT_EQ(loaded.getClosestPointInMesh(glm::vec3 { 3.2f, 4.7f, 2.0f }), built.getClosestPointInMesh(glm::vec3 { 3.2f, 4.7f, 2.0f }));
+    expectSamePaths(built, loaded);
+}
+
+TEST(NavMeshFiles, SameFileIsShared) {
+    NavMesh built;
+    built.loadFromScene(makeGridScene());
+    const fs::path path = writeNavMesh(built, "carrot-test-shared.cnav");
+
+    NavMesh worldA;
+    NavMesh worldB;
+    worldA.loadFromFile(path);
+    worldB.loadFromFile(path);
+    EXPECT_TRUE(worldA.sharesDataWith(worldB));
+    EXPECT_FALSE(worldA.sharesDataWith(built));
+
+    // modifying one navmesh must not modify the other
+    worldA.removeHierarchy();
+    NavMesh copy = worldB;
+    EXPECT_TRUE(copy.sharesDataWith(worldB));
+    expectSamePaths(built, copy);
+}
+
+TEST(NavMeshFiles, RejectsTruncatedFiles) {
+    NavMesh built;
+    built.loadFromScene(makeGridScene());
+    const fs::path path = writeNavMesh(built, "carrot-test-truncated.cnav");
+    fs::resize_file(path, fs::file_size(path) / 2);
+
+    NavMesh loaded;
+    EXPECT_THROW(loaded.loadFromFile(path), std::invalid_argument);
+    EXPECT_FALSE(loaded.hasTriangles());
+}
@@ -0,0 +1,132 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <random>
+#include <engine/pathfinding/NavMeshHierarchy.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr int GridSize = 60;
+
+/// Grid of cells crossed by walls with openings, each cell is a vertex connected to its 4 neighbors
+struct Grid {
+    std::vector<glm::vec3> centers;
+    AStar<glm::vec3> graph;
+};
+
+static Grid makeGrid() {
+    auto isWall = [](int x, int y) {
+        return (x % 15 == 7 && (y / 6) % 3 != 0) || (y % 17 == 8 && (x / 5) % 4 != 0);
+    };
+
+    Grid grid;
+    std::vector<std::int64_t> vertexOfCell(GridSize * GridSize, -1);
+    for(int y = 0; y < GridSize; y++) {
+        for(int x = 0; x < GridSize; x++) {
+            if(!isWall(x, y)) {
+                vertexOfCell[y * GridSize + x] = static_cast<std::int64_t>(grid.centers.size());
+                grid.centers.emplace_back(x + 0.5f, y + 0.5f, 0.0f);
+            }
+        }
+    }
+
+    std::vector<Edge> edges;
+    auto link = [&](std::int64_t a, std::int64_t b) {
+        if(a >= 0 && b >= 0) {
+            edges.push_back(Edge { static_cast<std::size_t>(a), static_cast<std::size_t>(b) });
+            edges.push_back(Edge { static_cast<std::size_t>(b), static_cast<std::size_t>(a) });
+        }
+    };
+    for(int y = 0; y < GridSize; y++) {
+        for(int x = 0; x < GridSize; x++) {
+            if(x + 1 < GridSize) {
+                link(vertexOfCell[y * GridSize + x], vertexOfCell[y * GridSize + x + 1]);
+            }
+            if(y + 1 < GridSize) {
+                link(vertexOfCell[y * GridSize + x], vertexOfCell[(y + 1) * GridSize + x]);
+            }
+        }
+    }
+    grid.graph.setGraph(grid.centers, std::move(edges));
+    return grid;
+}
+
+static float getCost(const Grid& grid, std::span<const std::size_t> path) {
+    float cost = 0.0f;
+    for(std::size_t i = 1; i < path.size(); i++) {
+        cost += glm::distance(grid.centers[path[i - 1]], grid.centers[path[i]]);
+    }
+    return cost;
+}
+
+/// Checks that 'hierarchy' finds corridors as short as the ones found by A* over all vertices
+static void checkCorridors(const Grid& grid, const NavMeshHierarchy& hierarchy) {
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<std::size_t> vertexDistribution { 0, grid.centers.size() - 1 };
+    SearchContext context;
+    std::vector<std::size_t> corridor;
+    std::size_t checkedCount = 0;
+    while(checkedCount < 200) {
+        const std::size_t start = vertexDistribution(rng);
+        const std::size_t goal = vertexDistribution(rng);
+        if(hierarchy.getCluster(start) == hierarchy.getCluster(goal)) {
+            continue;
+        }
+        checkedCount++;
+
+        ASSERT_TRUE(grid.graph.findPath(context, start, goal, [](const glm::vec3& a, const glm::vec3& b) {
+            return glm::distance(a, b);
+        }, [&](const glm::vec3& v) {
+            return glm::distance(v, grid.centers[goal]);
+        }));
+        const float expectedCost = getCost(grid, context.getPath());
+
+        ASSERT_TRUE(hierarchy.findCorridor(grid.graph, start, goal, context, corridor));
+        ASSERT_EQ(corridor.front(), start);
+        ASSERT_EQ(corridor.back(), goal);
+        for(std::size_t i = 1; i < corridor.size(); i++) {
+            std::span<const std::uint32_t> neighbors = grid.graph.getNeighbors(corridor[i - 1]);
+            EXPECT_NE(std::find(neighbors.begin(), neighbors.end(), corridor[i]), neighbors.end());
+        }
+        EXPECT_NEAR(getCost(grid, corridor), expectedCost, expectedCost * 1e-4f);
+    }
+}
+
+TEST(NavMeshHierarchy, SameCostAsFlatSearch) {
+    const Grid grid = makeGrid();
+    NavMeshHierarchy hierarchy;
+    hierarchy.build(grid.graph, grid.centers, 64);
+    ASSERT_FALSE(hierarchy.empty());
+    EXPECT_GE(hierarchy.getClusterCount(), grid.centers.size() / 64);
+
+    checkCorridors(grid, hierarchy);
+}
+
+TEST(NavMeshHierarchy, Serialization) {
+    const Grid grid = makeGrid();
+    NavMeshHierarchy hierarchy;
+    hierarchy.build(grid.graph, grid.centers, 64);
+
+    std::vector<std::uint8_t> data;
+    IO::VectorWriter writer { data };
+    hierarchy.serialize(writer);
+
+    NavMeshHierarchy readHierarchy;
+    IO::VectorReader reader { data };
+    readHierarchy.deserialize(reader, grid.graph, grid.centers);
+    ASSERT_EQ(readHierarchy.getClusterCount(), hierarchy.getClusterCount());
+    for(std::size_t i = 0; i < grid.centers.size(); i++) {
+        ASSERT_EQ(readHierarchy.getCluster(i), hierarchy.getCluster(i));
+    }
+    checkCorridors(grid, readHierarchy);
+}
+
+TEST(NavMeshHierarchy, TooSmall) {
+    const Grid grid = makeGrid();
+    NavMeshHierarchy hierarchy;
+    hierarchy.build(grid.graph, grid.centers, grid.centers.size());
+    EXPECT_TRUE(hierarchy.empty());
+}
@@ -0,0 +1,159 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <engine/pathfinding/NavMesh.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr std::size_t GridSize = 16;
+
+/// Flat grid of GridSize x GridSize cells (2 triangles per cell), with a wall in the middle which has an opening at the top
+static Render::LoadedScene makeGridScene() {
+    Render::LoadedScene scene;
+    auto& primitive = scene.primitives.emplace_back();
+    for(std::size_t y = 0; y <= GridSize; y++) {
+        for(std::size_t x = 0; x <= GridSize; x++) {
+            Carrot::Vertex& v = primitive.vertices.emplace_back();
+            v.pos = glm::vec4 { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f };
+        }
+    }
+
+    auto vertexIndex = [](std::size_t x, std::size_t y) {
+        return static_cast<std::uint32_t>(y * (GridSize + 1) + x);
+    };
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            if(x == GridSize / 2 && y < GridSize - 2) {
+                continue;
+            }
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+            primitive.indices.push_back(vertexIndex(x, y + 1));
+        }
+    }
+    return scene;
+}
+
+static const glm::vec3 Start { 1.5f, 1.5f, 0.0f };
+static const glm::vec3 Goal { GridSize - 1.5f, 1.5f, 0.0f };
+
+/// Box filling the opening of the wall
+static NavMesh::Obstacle makeDoor() {
+    return NavMesh::Obstacle {
+        .shape = NavMesh::Obstacle::Shape::Box,
+        .position = glm::vec3 { GridSize / 2 + 0.5f, GridSize - 1.0f, 0.0f },
+        .halfExtents = glm::vec3 { 0.4f, 0.9f, 0.5f },
+    };
+}
+
+TEST(NavMeshObstacles, BoxClosesOpening) {
+    NavMesh navMesh;
+    navMesh.loadFromScene(makeGridScene());
+    ASSERT_GT(navMesh.computePath(Start, Goal).waypoints.size(), 2u);
+
+    const NavMesh::ObstacleID door = navMesh.addObstacle(makeDoor());
+    EXPECT_TRUE(navMesh.computePath(Start, Goal).waypoints.empty());
+
+    // closest position is never inside the obstacle
+    const glm::vec3 insideDoor { GridSize / 2 + 0.5f, GridSize - 1.0f, 0.0f };
+    const glm::vec3 snapped = navMesh.getClosestPointInMesh(insideDoor);
+    EXPECT_TRUE(snapped.x <= GridSize / 2 || snapped.x >= GridSize / 2 + 1);
+
+    navMesh.removeObstacle(door);
+    EXPECT_GT(navMesh.computePath(Start, Goal).waypoints.size(), 2u);
+
+    // opened by moving the door away
+    const NavMesh::ObstacleID door2 = navMesh.addObstacle(makeDoor());
+    EXPECT_EQ(door2, door); // ID is reused
+    EXPECT_TRUE(navMesh.computePath(Start, Goal).waypoints.empty());
+    NavMesh::Obstacle openDoor = makeDoor();
+    openDoor.position.x += 3.0f;
+    navMesh.moveObstacle(door2, openDoor);
+    EXPECT_GT(navMesh.computePath(Start, Goal).waypoints.size(), 2u);
+}
+
+TEST(NavMeshObstacles, NoPathWhenEverythingIsBlocked) {
+    NavMesh navMesh;
+    EXPECT_TRUE(navMesh.computePath(Start, Goal).waypoints.empty()); // nothing loaded
+
+    navMesh.loadFromScene(makeGridScene());
+    const NavMesh::ObstacleID everything = navMesh.addObstacle(NavMesh::Obstacle {
+        .shape = NavMesh::Obstacle::Shape::Box,
+        .position = glm::vec3 { GridSize / 2.0f, GridSize / 2.0f, 0.0f },
+        .halfExtents = glm::vec3 { GridSize, GridSize, 1.0f },
+    });
+    EXPECT_EQ(navMesh.getClosestPosition(Start).triangleIndex, ~0ull);
+    EXPECT_TRUE(navMesh.computePath(Start, Goal).waypoints.empty());
+    EXPECT_TRUE(navMesh.computePath(Start, Start + glm::vec3 { 0.1f, 0.0f, 0.0f }).waypoints.empty());
+
+    navMesh.removeObstacle(everything);
+    EXPECT_EQ(navMesh.computePath(Start, Start + glm::vec3 { 0.1f, 0.0f, 0.0f }).waypoints.size(), 2u);
+}
+
+TEST(NavMeshObstacles, PathGoesAroundCylinder) {
+    NavMesh navMesh;
+    navMesh.loadFromScene(makeGridScene());
+
+    const NavMesh::Obstacle pillar {
+        .shape = NavMesh::Obstacle::Shape::Cylinder,
+        .position = glm::vec3 { GridSize / 2 + 0.5f, GridSize - 1.5f, -0.5f },
+        .radius = 0.3f,
+        .height = 1.0f,
+    };
+    navMesh.addObstacle(pillar);
+
+    const NavPath path = navMesh.computePath(Start, Goal);
+    ASSERT_GT(path.waypoints.size(), 2u);
+    for(std::size_t i = 1; i < path.waypoints.size(); i++) {
+        const glm::vec2 a = path.waypoints[i - 1].xy();
+        const glm::vec2 b = path.waypoints[i].xy();
+        const glm::vec2 center = pillar.position.xy();
+        if(a == b) {
+            continue;
+        }
+        const float t = glm::clamp(glm::dot(center - a, b - a) / glm::dot(b - a, b - a), 0.0f, 1.0f);
+        EXPECT_GE(glm::distance(a + t * (b - a), center), pillar.radius);
+    }
+}
+
+TEST(NavMeshObstacles, Version) {
+    NavMesh navMesh;
+    navMesh.loadFromScene(makeGridScene());
+    std::uint64_t version = navMesh.getObstacleVersion();
+
+    // does not touch the navmesh
+    NavMesh::Obstacle floating = makeDoor();
+    floating.position.z = 10.0f;
+    const NavMesh::ObstacleID id = navMesh.addObstacle(floating);
+    EXPECT_EQ(navMesh.getObstacleVersion(), version);
+
+    navMesh.moveObstacle(id, makeDoor());
+    EXPECT_NE(navMesh.getObstacleVersion(), version);
+    version = navMesh.getObstacleVersion();
+
+    // same triangles
+    NavMesh::Obstacle slightlyMoved = makeDoor();
+    slightlyMoved.position.y += 0.05f;
+    navMesh.moveObstacle(id, slightlyMoved);
+    EXPECT_EQ(navMesh.getObstacleVersion(), version);
+
+    // triangles blocked twice stay blocked until both obstacles are removed
+    const NavMesh::ObstacleID other = navMesh.addObstacle(makeDoor());
+    navMesh.removeObstacle(id);
+    EXPECT_EQ(navMesh.getObstacleVersion(), version);
+    EXPECT_TRUE(navMesh.computePath(Start, Goal).waypoints.empty());
+    navMesh.removeObstacle(other);
+    EXPECT_NE(navMesh.getObstacleVersion(), version);
+
+    // loading another mesh removes obstacles
+    navMesh.addObstacle(makeDoor());
+    navMesh.loadFromScene(makeGridScene());
+    EXPECT_GT(navMesh.computePath(Start, Goal).waypoints.size(), 2u);
+}
@@ -0,0 +1,171 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <engine/pathfinding/PathQueryService.h>
+#include <core/tasks/TaskScheduler.h>
+
+using namespace Carrot;
+using namespace Carrot::AI;
+
+static constexpr std::size_t GridSize = 16;
+
+/// Flat grid of GridSize x GridSize cells (2 triangles per cell), with a wall in the middle which has an opening at the top
+static Render::LoadedScene makeGridScene() {
+    Render::LoadedScene scene;
+    auto& primitive = scene.primitives.emplace_back();
+    for(std::size_t y = 0; y <= GridSize; y++) {
+        for(std::size_t x = 0; x <= GridSize; x++) {
+            Carrot::Vertex& v = primitive.vertices.emplace_back();
+            v.pos = glm::vec4 { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f };
+        }
+    }
+
+    auto vertexIndex = [](std::size_t x, std::size_t y) {
+        return static_cast<std::uint32_t>(y * (GridSize + 1) + x);
+    };
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            if(x == GridSize / 2 && y < GridSize - 2) {
+                continue;
+            }
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+
+            primitive.indices.push_back(vertexIndex(x, y));
+            primitive.indices.push_back(vertexIndex(x + 1, y + 1));
+            primitive.indices.push_back(vertexIndex(x, y + 1));
+        }
+    }
+    return scene;
+}
+
+class PathQueryServiceTest: public testing::Test {
+protected:
+    void SetUp() override {
+        navMesh.loadFromScene(makeGridScene());
+    }
+
+    NavMesh navMesh;
+    TaskScheduler scheduler { TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 1,
+    } };
+};
+
+static constexpr std::chrono::duration<float> LargeBudget { 10.0f };
+
+TEST_F(PathQueryServiceTest, SameResultsAsComputePath) {
+    PathQueryService service { navMesh, scheduler };
+    std::vector<std::shared_ptr<const PathQuery>> queries;
+    for(std::size_t i = 0; i < 40; i++) {
+        const float y = static_cast<float>(i % 8) + 0.25f;
+        queries.push_back(service.requestPath(glm::vec3 { 1.5f, y, 0.0f }, glm::vec3 { GridSize - 1.5f, y + 0.5f, 0.0f }));
+    }
+    // same triangle
+    queries.push_back(service.requestPath(glm::vec3 { 0.8f, 0.2f, 0.0f }, glm::vec3 { 0.9f, 0.1f, 0.0f }));
+
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().completedQueries, queries.size());
+    EXPECT_EQ(service.getLastStats().deferredQueries, 0u);
+    EXPECT_EQ(service.getPendingCount(), 0u);
+
+    for(const auto& pQuery : queries) {
+        ASSERT_TRUE(pQuery->isReady());
+        const NavPath expected = navMesh.computePath(pQuery->getStart(), pQuery->getGoal());
+        const NavPath& actual = pQuery->getPath();
+        ASSERT_EQ(actual.waypoints.size(), expected.waypoints.size());
+        for(std::size_t i = 0; i < expected.waypoints.size(); i++) {
+            EXPECT_EQ(actual.waypoints[i], expected.waypoints[i]);
+        }
+        EXPECT_GT(actual.waypoints.size(), 1u);
+    }
+}
+
+TEST_F(PathQueryServiceTest, DeduplicationAndCache) {
+    PathQueryService service { navMesh, scheduler };
+    const glm::vec3 start { 1.2f, 1.3f, 0.0f };
+    const glm::vec3 goal { GridSize - 1.2f, 1.3f, 0.0f };
+
+    auto a = service.requestPath(start, goal);
+    auto b = service.requestPath(start + glm::vec3 { 0.05f, 0.05f, 0.0f }, goal); // same triangles
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().searches, 1u);
+    EXPECT_EQ(service.getLastStats().cacheHits, 0u);
+    EXPECT_TRUE(a->isReady());
+    EXPECT_TRUE(b->isReady());
+
+    auto c = service.requestPath(start, goal);
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().searches, 0u);
+    EXPECT_EQ(service.getLastStats().cacheHits, 1u);
+    ASSERT_TRUE(c->isReady());
+    EXPECT_EQ(c->getPath().waypoints.size(), a->getPath().waypoints.size());
+
+    service.clearCache();
+    auto d = service.requestPath(start, goal);
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().searches, 1u);
+    EXPECT_EQ(service.getLastStats().cacheHits, 0u);
+}
+
+TEST_F(PathQueryServiceTest, TimeBudget) {
+    PathQueryService service { navMesh, scheduler, 0 };
+    std::vector<std::shared_ptr<const PathQuery>> queries;
+    for(std::size_t i = 0; i < 5; i++) {
+        const float y = static_cast<float>(i) + 0.5f;
+        queries.push_back(service.requestPath(glm::vec3 { 0.5f, y, 0.0f }, glm::vec3 { GridSize - 0.5f, y, 0.0f }));
+    }
+
+    // no time at all: a single search per update
+    for(std::size_t i = 0; i < queries.size(); i++) {
+        service.update(std::chrono::duration<float> { 0.0f });
+        EXPECT_EQ(service.getLastStats().completedQueries, 1u);
+        EXPECT_EQ(service.getPendingCount(), queries.size() - i - 1);
+        EXPECT_TRUE(queries[i]->isReady()); // oldest queries first
+    }
+    for(const auto& pQuery : queries) {
+        EXPECT_TRUE(pQuery->isReady());
+    }
+}
+
+TEST_F(PathQueryServiceTest, Cancellation) {
+    PathQueryService service { navMesh, scheduler };
+    auto kept = service.requestPath(glm::vec3 { 0.5f, 0.5f, 0.0f }, glm::vec3 { GridSize - 0.5f, 0.5f, 0.0f });
+    service.requestPath(glm::vec3 { 0.5f, 2.5f, 0.0f }, glm::vec3 { GridSize - 0.5f, 2.5f, 0.0f }); // handle dropped immediately
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().cancelledQueries, 1u);
+    EXPECT_EQ(service.getLastStats().completedQueries, 1u);
+    EXPECT_TRUE(kept->isReady());
+}
+
+TEST_F(PathQueryServiceTest, ObstaclesInvalidateCache) {
+    PathQueryService service { navMesh, scheduler };
+    const glm::vec3 start { 1.5f, 1.5f, 0.0f };
+    const glm::vec3 goal { GridSize - 1.5f, 1.5f, 0.0f };
+    auto a = service.requestPath(start, goal);
+    service.update(LargeBudget);
+    ASSERT_GT(a->getPath().waypoints.size(), 2u);
+
+    // closes the opening of the wall
+    const NavMesh::ObstacleID door = navMesh.addObstacle(NavMesh::Obstacle {
+        .shape = NavMesh::Obstacle::Shape::Box,
+        .position = glm::vec3 { GridSize / 2 + 0.5f, GridSize - 1.0f, 0.0f },
+        .halfExtents = glm::vec3 { 0.4f, 0.9f, 0.5f },
+    });
+    auto b = service.requestPath(start, goal);
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().evictedCorridors, 1u);
+    EXPECT_EQ(service.getLastStats().searches, 1u);
+    ASSERT_TRUE(b->isReady());
+    EXPECT_TRUE(b->getPath().waypoints.empty());
+
+    navMesh.removeObstacle(door);
+    auto c = service.requestPath(start, goal);
+    service.update(LargeBudget);
+    EXPECT_EQ(service.getLastStats().evictedCorridors, 1u); // "no path" result
+    ASSERT_TRUE(c->isReady());
+    EXPECT_EQ(c->getPath().waypoints.size(), a->getPath().waypoints.size());
+}
@@ -0,0 +1,74 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <engine/ecs/Signature.hpp>
+
+using namespace Carrot;
+
+/// Component IDs which are not used by any registered component, to avoid interfering with the rest of the engine
+static ComponentID testComponentID(std::size_t i) {
+    return static_cast<ComponentID>(1'000'000'000 + i);
+}
+
+TEST(Signatures, MoreThan64Components) {
+    constexpr std::size_t Count = 150;
+    std::vector<std::size_t> indices;
+    for(std::size_t i = 0; i < Count; i++) {
+        indices.push_back(Signature::getIndex(testComponentID(i)));
+    }
+
+    Signature signature;
+    for(std::size_t i = 0; i < Count; i += 2) {
+        signature.addComponent(testComponentID(i));
+    }
+
+    EXPECT_EQ(signature.getComponentCount(), Count / 2);
+    for(std::size_t i = 0; i < Count; i++) {
+        EXPECT_EQ(Signature::getIndex(testComponentID(i)), indices[i]) << "Index must not change once assigned";
+        EXPECT_EQ(Signature::getComponentID(indices[i]), testComponentID(i));
+        EXPECT_EQ(signature.hasComponent(testComponentID(i)), i % 2 == 0);
+    }
+
+    // signature index is the rank of the component inside the signature
+    std::vector<std::size_t> visitedIndices;
+    signature.forEachComponentIndex([&](std::size_t index) {
+        const ComponentID componentID = Signature::getComponentID(index);
+        EXPECT_EQ(signature.getComponentIndex(componentID), visitedIndices.size());
+        visitedIndices.push_back(index);
+    });
+    EXPECT_EQ(visitedIndices.size(), Count / 2);
+    EXPECT_TRUE(std::is_sorted(visitedIndices.begin(), visitedIndices.end()));
+}
+
+TEST(Signatures, Matching) {
+    Signature all;
+    Signature evens;
+    Signature odds;
+    for(std::size_t i = 0; i < 100; i++) {
+        all.addComponent(testComponentID(i));
+        (i % 2 == 0 ? evens : odds).addComponent(testComponentID(i));
+    }
+
+    EXPECT_TRUE(all.contains(evens));
+    EXPECT_TRUE(all.contains(odds));
+    EXPECT_FALSE(evens.contains(all));
+    EXPECT_FALSE(evens.intersects(odds));
+    EXPECT_TRUE(evens.intersects(all));
+    EXPECT_TRUE((evens & odds).isEmpty());
+    EXPECT_EQ(all & evens, evens);
+    EXPECT_TRUE(all.contains(Signature{}));
+
+    Signature copy = all;
+    EXPECT_EQ(copy, all);
+    EXPECT_EQ(copy.hash(), all.hash());
+    copy.clear();
+    EXPECT_TRUE(copy.isEmpty());
+    EXPECT_NE(copy, all);
+
+    Signature fromWords;
+    fromWords.fromWords(odds.getWords());
+    EXPECT_EQ(fromWords, odds);
+}
@@ -0,0 +1,173 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <engine/pathfinding/SpanHeightField.h>
+
+using namespace Carrot::AI;
+
+using Span = SpanHeightField::Span;
+
+static constexpr std::size_t GridSize = 8;
+static constexpr float VoxelSize = 1.0f;
+
+/// Voxel (x, y, z) covers [x; x+1] x [y; y+1] x [z; z+1] in world space
+static const glm::vec3 Origin { 0.5f, 0.5f, 0.5f };
+
+static void expectSpans(const SpanHeightField& heightField, std::size_t x, std::size_t y, std::initializer_list<Span> expected) {
+    const std::span<const Span> spans = heightField.getSpans(x, y);
+    ASSERT_EQ(spans.size(), expected.size()) << "Column " << x << ", " << y;
+    std::size_t i = 0;
+    for(const Span& expectedSpan : expected) {
+        EXPECT_EQ(spans[i].minZ, expectedSpan.minZ) << "Column " << x << ", " << y << ", span " << i;
+        EXPECT_EQ(spans[i].maxZ, expectedSpan.maxZ) << "Column " << x << ", " << y << ", span " << i;
+        EXPECT_EQ(spans[i].walkable, expectedSpan.walkable) << "Column " << x << ", " << y << ", span " << i;
+        i++;
+    }
+}
+
+/// Rasterises the quad [minX; maxX] x [minY; maxY] as two triangles, with the given heights at minX and maxX
+static void rasteriseQuad(SpanHeightField& heightField, float minX, float minY, float maxX, float maxY, float zAtMinX, float zAtMaxX, bool walkable,
+                          std::size_t firstRow = 0, std::size_t endRow = GridSize) {
+    const glm::vec3 triangleA[3] {
+        { minX, minY, zAtMinX },
+        { maxX, minY, zAtMaxX },
+        { maxX, maxY, zAtMaxX },
+    };
+    const glm::vec3 triangleB[3] {
+        { minX, minY, zAtMinX },
+        { maxX, maxY, zAtMaxX },
+        { minX, maxY, zAtMinX },
+    };
+    heightField.rasteriseTriangle(triangleA, walkable, Origin, VoxelSize, firstRow, endRow);
+    heightField.rasteriseTriangle(triangleB, walkable, Origin, VoxelSize, firstRow, endRow);
+}
+
+TEST(SpanHeightField, MergeSpans) {
+    SpanHeightField heightField;
+    heightField.reset(1, 1, 32);
+
+    heightField.addSpan(0, 0, 5, 6, false);
+    heightField.addSpan(0, 0, 1, 2, true);
+    expectSpans(heightField, 0, 0, { { 1, 2, true }, { 5, 6, false } });
+
+    // touches both spans: everything is merged, the highest top decides if the span is walkable
+    heightField.addSpan(0, 0, 3, 4, true);
+    expectSpans(heightField, 0, 0, { { 1, 6, false } });
+
+    // same top: walkable if any of them is
+    heightField.addSpan(0, 0, 0, 6, true);
+    expectSpans(heightField, 0, 0, { { 0, 6, true } });
+
+    // higher top wins
+    heightField.addSpan(0, 0, 10, 10, false);
+    heightField.addSpan(0, 0, 8, 12, true);
+    expectSpans(heightField, 0, 0, { { 0, 6, true }, { 8, 12, true } });
+
+    // fully inside an existing span: the top does not change
+    heightField.addSpan(0, 0, 9, 9, false);
+    expectSpans(heightField, 0, 0, { { 0, 6, true }, { 8, 12, true } });
+
+    // a gap of one voxel is kept
+    heightField.addSpan(0, 0, 14, 20, false);
+    expectSpans(heightField, 0, 0, { { 0, 6, true }, { 8, 12, true }, { 14, 20, false } });
+
+    heightField.reset(1, 1, 32);
+    expectSpans(heightField, 0, 0, {});
+}
+
+TEST(SpanHeightField, FlatTriangleIsClippedToColumns) {
+    SpanHeightField heightField;
+    heightField.reset(GridSize, GridSize, GridSize);
+
+    // half of a 5x5 square, at the middle of voxel 1 in Z
+    const glm::vec3 triangle[3] {
+        { 0.5f, 0.5f, 1.5f },
+        { 5.5f, 0.5f, 1.5f },
+        { 0.5f, 5.5f, 1.5f },
+    };
+    heightField.rasteriseTriangle(triangle, true, Origin, VoxelSize, 0, GridSize);
+
+    // columns inside the triangle, and columns only partially covered by it
+    for(const auto& [x, y] : { std::pair { 0, 0 }, { 2, 2 }, { 4, 0 }, { 5, 0 }, { 0, 5 }, { 1, 3 } }) {
+        expectSpans(heightField, x, y, { { 1, 1, true } });
+    }
+    // columns beyond the diagonal or outside of the triangle bounds
+    for(const auto& [x, y] : { std::pair { 4, 4 }, { 3, 5 }, { 5, 5 }, { 6, 0 }, { 0, 6 }, { 7, 7 } }) {
+        expectSpans(heightField, x, y, {});
+    }
+}
+
+TEST(SpanHeightField, SlopedQuad) {
+    SpanHeightField heightField;
+    heightField.reset(GridSize, GridSize, GridSize);
+
+    // 45° slope going up along X: each column covers 1 unit in Z, so touches 2 voxels
+    rasteriseQuad(heightField, 0.0f, 0.0f, 4.0f, 4.0f, 0.5f, 4.5f, true);
+    for(std::int32_t y = 0; y < 4; y++) {
+        for(std::int32_t x = 0; x < 4; x++) {
+            expectSpans(heightField, x, y, { { x, x + 1, true } });
+        }
+        expectSpans(heightField, 5, y, {});
+    }
+    for(std::size_t x = 0; x < GridSize; x++) {
+        expectSpans(heightField, x, 5, {});
+    }
+}
+
+TEST(SpanHeightField, OverlappingTriangles) {
+    SpanHeightField heightField;
+    heightField.reset(GridSize, GridSize, GridSize);
+
+    // walkable floor with a non-walkable ceiling above the middle
+    rasteriseQuad(heightField, 0.0f, 0.0f, 4.0f, 4.0f, 0.5f, 0.5f, true);
+    rasteriseQuad(heightField, 1.0f, 1.0f, 3.0f, 3.0f, 5.5f, 5.5f, false);
+    expectSpans(heightField, 0, 0, { { 0, 0, true } });
+    expectSpans(heightField, 2, 2, { { 0, 0, true }, { 5, 5, false } });
+
+    // non-walkable geometry touching the floor from below does not change its top
+    rasteriseQuad(heightField, 0.0f, 0.0f, 2.0f, 2.0f, -0.5f, 0.5f, false);
+    expectSpans(heightField, 0, 0, { { 0, 0, true } });
+
+    // non-walkable geometry at the same height as the floor: still walkable
+    rasteriseQuad(heightField, 0.0f, 0.0f, 4.0f, 4.0f, 0.25f, 0.25f, false);
+    expectSpans(heightField, 3, 3, { { 0, 0, true } });
+
+    // a box on the floor: touches it, and its non-walkable top becomes the top of the merged span
+    rasteriseQuad(heightField, 2.0f, 2.0f, 3.0f, 3.0f, 1.5f, 2.5f, false);
+    expectSpans(heightField, 2, 2, { { 0, 2, false }, { 5, 5, false } });
+
+    // walkable top of the box
+    rasteriseQuad(heightField, 2.0f, 2.0f, 3.0f, 3.0f, 2.5f, 2.5f, true);
+    expectSpans(heightField, 2, 2, { { 0, 2, true }, { 5, 5, false } });
+}
+
+TEST(SpanHeightField, OnlyRasterisesRequestedRowsAndBounds) {
+    SpanHeightField heightField;
+    heightField.reset(GridSize, GridSize, GridSize);
+
+    // larger than the heightfield, and partially below it
+    rasteriseQuad(heightField, -4.0f, -4.0f, 12.0f, 12.0f, -3.5f, 12.5f, true, 2, 4);
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            const std::span<const Span> spans = heightField.getSpans(x, y);
+            if(y < 2 || y >= 4) {
+                EXPECT_TRUE(spans.empty()) << x << ", " << y;
+                continue;
+            }
+            ASSERT_EQ(spans.size(), 1) << x << ", " << y;
+            EXPECT_GE(spans[0].minZ, 0);
+            EXPECT_LT(spans[0].maxZ, static_cast<std::int32_t>(GridSize));
+        }
+    }
+
+    // entirely below the heightfield
+    heightField.reset(GridSize, GridSize, GridSize);
+    rasteriseQuad(heightField, 0.0f, 0.0f, 4.0f, 4.0f, -2.0f, -1.0f, true);
+    for(std::size_t y = 0; y < GridSize; y++) {
+        for(std::size_t x = 0; x < GridSize; x++) {
+            EXPECT_TRUE(heightField.getSpans(x, y).empty());
+        }
+    }
+}
@@ -0,0 +1,191 @@
+//
+// Created by jglrxavpok on 17/10/2026.
+//
+
+#include <gtest/gtest.h>
+#include <BlockCompression.h>
+#include <core/render/ImageFormats.h>
+#include <core/tasks/TaskScheduler.h>
+#include <rgbcx.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <glm/glm.hpp>
+
+using namespace Fertilizer;
+
+static constexpr std::uint32_t ImageSize = 64;
+
+/// Smooth gradients with some noise, close to a photographed albedo. RGBA8
+static std::vector<std::uint8_t> makeColorImage(std::uint32_t width, std::uint32_t height, bool withAlpha) {
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<int> noise { -8, 8 };
+    std::vector<std::uint8_t> texels(width * height * 4);
+    for(std::uint32_t y = 0; y < height; y++) {
+        for(std::uint32_t x = 0; x < width; x++) {
+            const float u = static_cast<float>(x) / width;
+            const float v = static_cast<float>(y) / height;
+            const float values[4] = {
+                128.0f + 100.0f * std::sin(u * 6.0f),
+                128.0f + 100.0f * std::cos(v * 5.0f),
+                64.0f + 128.0f * u * v,
+                withAlpha ? 255.0f * (0.5f + 0.5f * std::sin((u + v) * 9.0f)) : 255.0f,
+            };
+            for(std::size_t c = 0; c < 4; c++) {
+                const int n = c < 3 || withAlpha ? noise(rng) : 0;
+                texels[(y * width + x) * 4 + c] = static_cast<std::uint8_t>(std::clamp(static_cast<int>(values[c]) + n, 0, 255));
+            }
+        }
+    }
+    return texels;
+}
+
+/// Tangent-space normal map of a bumpy surface. RGBA8, Z in blue
+static std::vector<std::uint8_t> makeNormalMap(std::uint32_t width, std::uint32_t height) {
+    std::vector<std::uint8_t> texels(width * height * 4);
+    for(std::uint32_t y = 0; y < height; y++) {
+        for(std::uint32_t x = 0; x < width; x++) {
+            const float dx = 0.6f * std::cos(x * 0.4f) * std::sin(y * 0.15f);
+            const float dy = 0.6f * std::sin(x * 0.2f) * std::cos(y * 0.35f);
+            const glm::vec3 normal = glm::normalize(glm::vec3 { dx, dy, 1.0f });
+            texels[(y * width + x) * 4 + 0] = static_cast<std::uint8_t>(std::round((normal.x * 0.5f + 0.5f) * 255.0f));
+            texels[(y * width + x) * 4 + 1] = static_cast<std::uint8_t>(std::round((normal.y * 0.5f + 0.5f) * 255.0f));
+            texels[(y * width + x) * 4 + 2] = static_cast<std::uint8_t>(std::round((normal.z * 0.5f + 0.5f) * 255.0f));
+            texels[(y * width + x) * 4 + 3] = 255;
+        }
+    }
+    return texels;
+}
+
+/// PSNR in dB over the first 'channelCount' channels of RGBA8 images
+static double computePSNR(std::span<const std::uint8_t> reference, std::span<const std::uint8_t> other, std::size_t channelCount) {
+    double squaredError = 0.0;
+    std::size_t sampleCount = 0;
+    for(std::size_t texel = 0; texel < reference.size() / 4; texel++) {
+        for(std::size_t c = 0; c < channelCount; c++) {
+            const double difference = static_cast<double>(reference[texel * 4 + c]) - static_cast<double>(other[texel * 4 + c]);
+            squaredError += difference * difference;
+            sampleCount++;
+        }
+    }
+    if(squaredError == 0.0) {
+        return INFINITY;
+    }
+    const double meanSquaredError = squaredError / sampleCount;
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+static std::vector<std::uint8_t> compress(VkFormat format, TextureCompressionQuality quality, std::span<const std::uint8_t> image, std::uint32_t width, std::uint32_t height) {
+    std::vector<std::uint8_t> blocks(Carrot::ImageFormats::computeMipSize(width, height, 1, format));
+    compressBlocks(format, quality, image, width, height, 1, blocks);
+    return blocks;
+}
+
+/// PSNR of 'image' once compressed to 'format'
+static double compressionPSNR(VkFormat format, TextureCompressionQuality quality, std::span<const std::uint8_t> image, std::size_t channelCount) {
+    const std::vector<std::uint8_t> blocks = compress(format, quality, image, ImageSize, ImageSize);
+    std::vector<std::uint8_t> decompressed(image.size());
+    decompressBlocks(format, blocks, ImageSize, ImageSize, 1, decompressed);
+    return computePSNR(image, decompressed, channelCount);
+}
+
+/// PSNR of the output of fertilizer before formats were chosen per usage: BC3 for everything, rgbcx::MAX_LEVEL
+static double legacyPSNR(std::span<const std::uint8_t> image, std::size_t channelCount) {
+    rgbcx::init();
+    std::vector<std::uint8_t> blocks(Carrot::ImageFormats::computeMipSize(ImageSize, ImageSize, 1, VK_FORMAT_BC3_UNORM_BLOCK));
+    const std::uint32_t widthInBlocks = ImageSize / 4;
+    for(std::uint32_t blockY = 0; blockY < ImageSize / 4; blockY++) {
+        for(std::uint32_t blockX = 0; blockX < widthInBlocks; blockX++) {
+            std::array<std::uint8_t, 4 * 4 * 4> texels;
+            for(std::uint32_t dy = 0; dy < 4; dy++) {
+                for(std::uint32_t dx = 0; dx < 4; dx++) {
+                    const std::size_t texelIndex = (blockY * 4 + dy) * ImageSize + blockX * 4 + dx;
+                    std::copy_n(&image[texelIndex * 4], 4, &texels[(dx + dy * 4) * 4]);
+                }
+            }
+            rgbcx::encode_bc3(rgbcx::MAX_LEVEL, &blocks[(blockY * widthInBlocks + blockX) * 16], texels.data());
+        }
+    }
+
+    std::vector<std::uint8_t> decompressed(image.size());
+    decompressBlocks(VK_FORMAT_BC3_UNORM_BLOCK, blocks, ImageSize, ImageSize, 1, decompressed);
+    return computePSNR(image, decompressed, channelCount);
+}
+
+TEST(TextureCompression, FormatChoice) {
+    EXPECT_EQ(guessTextureUsage("textures/rock_albedo.png", 3), TextureUsage::Color);
+    EXPECT_EQ(guessTextureUsage("textures/rock_normal.png", 3), TextureUsage::NormalMap);
+    EXPECT_EQ(guessTextureUsage("textures/Rock_N.png", 4), TextureUsage::NormalMap);
+    EXPECT_EQ(guessTextureUsage("textures/rock_nrm.tga", 3), TextureUsage::NormalMap);
+    EXPECT_EQ(guessTextureUsage("textures/rock_roughness.png", 1), TextureUsage::Mask);
+    EXPECT_EQ(guessTextureUsage("textures/rock_normal.png", 2), TextureUsage::TwoChannels);
+    EXPECT_EQ(guessTextureUsage("textures/rock_nor_gl.png", 3), TextureUsage::NormalMap);
+    EXPECT_EQ(guessTextureUsage("textures/NormalMap.png", 3), TextureUsage::NormalMap);
+    // only suffixes are normal maps
+    EXPECT_EQ(guessTextureUsage("textures/abnormal_stone.png", 3), TextureUsage::Color);
+    EXPECT_EQ(guessTextureUsage("textures/normalized_height.png", 3), TextureUsage::Color);
+    EXPECT_EQ(guessTextureUsage("textures/sign.png", 3), TextureUsage::Color);
+
+    EXPECT_EQ(chooseCompressedFormat(TextureUsage::Color, false, TextureCompressionQuality::Normal), VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+    EXPECT_EQ(chooseCompressedFormat(TextureUsage::Color, true, TextureCompressionQuality::Normal), VK_FORMAT_BC3_UNORM_BLOCK);
+    EXPECT_EQ(chooseCompressedFormat(TextureUsage::Color, true, TextureCompressionQuality::High), VK_FORMAT_BC7_UNORM_BLOCK);
+    EXPECT_EQ(chooseCompressedFormat(TextureUsage::NormalMap, false, TextureCompressionQuality::Fast), VK_FORMAT_BC5_UNORM_BLOCK);
+    EXPECT_EQ(chooseCompressedFormat(TextureUsage::Mask, false, TextureCompressionQuality::High), VK_FORMAT_BC4_UNORM_BLOCK);
+}
+
+TEST(TextureCompression, OpaqueColorPSNR) {
+    const std::vector<std::uint8_t> image = makeColorImage(ImageSize, ImageSize, false);
+    const double legacy = legacyPSNR(image, 3);
+    EXPECT_GT(legacy, 30.0);
+
+    // BC1 is the color part of BC3, but can also use its 3 color mode: never worse
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC1_RGB_UNORM_BLOCK, TextureCompressionQuality::Normal, image, 3), legacy - 0.1);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC1_RGB_UNORM_BLOCK, TextureCompressionQuality::Fast, image, 3), legacy - 2.0);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC7_UNORM_BLOCK, TextureCompressionQuality::High, image, 3), legacy);
+}
+
+TEST(TextureCompression, TransparentColorPSNR) {
+    const std::vector<std::uint8_t> image = makeColorImage(ImageSize, ImageSize, true);
+    const double legacy = legacyPSNR(image, 4);
+
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC3_UNORM_BLOCK, TextureCompressionQuality::Normal, image, 4), legacy - 0.1);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC3_UNORM_BLOCK, TextureCompressionQuality::Fast, image, 4), legacy - 2.0);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC7_UNORM_BLOCK, TextureCompressionQuality::High, image, 4), legacy - 0.5);
+}
+
+TEST(TextureCompression, NormalMapAndMaskPSNR) {
+    // X and Y of normals are compressed independently, with more precision than the colors of BC3
+    const std::vector<std::uint8_t> normalMap = makeNormalMap(ImageSize, ImageSize);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC5_UNORM_BLOCK, TextureCompressionQuality::Normal, normalMap, 2), legacyPSNR(normalMap, 2) + 1.0);
+
+    // masks are in the red channel
+    const std::vector<std::uint8_t> mask = makeColorImage(ImageSize, ImageSize, false);
+    EXPECT_GE(compressionPSNR(VK_FORMAT_BC4_UNORM_BLOCK, TextureCompressionQuality::Normal, mask, 1), legacyPSNR(mask, 1) + 1.0);
+}
+
+TEST(TextureCompression, PartialBlocks) {
+    constexpr std::uint32_t Width = 13;
+    constexpr std::uint32_t Height = 7;
+    const std::vector<std::uint8_t> image = makeColorImage(Width, Height, false);
+    const std::vector<std::uint8_t> blocks = compress(VK_FORMAT_BC1_RGB_UNORM_BLOCK, TextureCompressionQuality::Normal, image, Width, Height);
+    EXPECT_EQ(blocks.size(), 4u * 2u * 8u);
+
+    std::vector<std::uint8_t> decompressed(image.size());
+    decompressBlocks(VK_FORMAT_BC1_RGB_UNORM_BLOCK, blocks, Width, Height, 1, decompressed);
+    EXPECT_GT(computePSNR(image, decompressed, 3), 25.0);
+}
+
+TEST(TextureCompression, ParallelMatchesSerial) {
+    const std::vector<std::uint8_t> image = makeColorImage(ImageSize, ImageSize, true);
+    const std::vector<std::uint8_t> serialBC3 = compress(VK_FORMAT_BC3_UNORM_BLOCK, TextureCompressionQuality::Normal, image, ImageSize, ImageSize);
+    const std::vector<std::uint8_t> serialBC7 = compress(VK_FORMAT_BC7_UNORM_BLOCK, TextureCompressionQuality::Fast, image, ImageSize, ImageSize);
+
+    Carrot::TaskScheduler scheduler { Carrot::TaskSchedulerConfig {
+        .frameParallelWorkThreads = 4,
+        .assetLoadingThreads = 0,
+    } };
+    scheduler.bindAsyncParallelFor();
+    EXPECT_EQ(compress(VK_FORMAT_BC3_UNORM_BLOCK, TextureCompressionQuality::Normal, image, ImageSize, ImageSize), serialBC3);
+    EXPECT_EQ(compress(VK_FORMAT_BC7_UNORM_BLOCK, TextureCompressionQuality::Fast, image, ImageSize, ImageSize), serialBC7);
+}